@@ -0,0 +1,203 @@
+#pragma once
+
+#include <asset_pack.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// In memory asset pack construction, shared by the asset_packer tool and the benchmarks
+
+namespace Game
+{
+    struct InputAsset
+    {
+        std::string       Name;
+        std::vector<char> Data;
+    };
+
+    struct AssetPackStats
+    {
+        uint64      SizeTotal   = 0;
+        uint64      StoredTotal = 0;
+        std::string Error; // why the pack is empty
+    };
+
+    namespace Detail
+    {
+        inline uint64 AlignUp(uint64 Value, uint64 Alignment) { return (Value + Alignment - 1) & ~(Alignment - 1); }
+
+        // Hash and displace: big buckets first, each bucket gets the first seed sending all its names to free slots
+        inline bool BuildPerfectHash(const std::vector<InputAsset>& Assets,
+                                     uint32                         BucketCount,
+                                     std::vector<uint32>&           Displacements,
+                                     std::vector<uint32>&           SlotToAsset)
+        {
+            auto EntryCount = static_cast<uint32>(Assets.size());
+
+            std::vector<std::vector<uint32>> Buckets(BucketCount);
+            for (uint32 Index = 0; Index < EntryCount; ++Index)
+            {
+                auto& Name = Assets[Index].Name;
+                Buckets[AssetPackBucket(HashBytes(Name.data(), Name.size()), BucketCount)].push_back(Index);
+            }
+            std::vector<uint32> Order(BucketCount);
+            for (uint32 Index = 0; Index < BucketCount; ++Index)
+            {
+                Order[Index] = Index;
+            }
+            std::stable_sort(Order.begin(), Order.end(), [&Buckets](uint32 A, uint32 B) {
+                return Buckets[A].size() > Buckets[B].size();
+            });
+
+            constexpr uint32 NoAsset = 0xFFFFFFFF;
+            Displacements.assign(BucketCount, 0);
+            SlotToAsset.assign(EntryCount, NoAsset);
+            std::vector<uint32> Slots;
+            for (auto BucketIndex : Order)
+            {
+                auto& Bucket = Buckets[BucketIndex];
+                if (Bucket.empty())
+                {
+                    break;
+                }
+                bool IsPlaced = false;
+                for (uint32 Displacement = 1; !IsPlaced && Displacement < (1u << 24); ++Displacement)
+                {
+                    Slots.clear();
+                    IsPlaced = true;
+                    for (auto AssetIndex : Bucket)
+                    {
+                        auto& Name = Assets[AssetIndex].Name;
+                        auto  Slot = AssetPackSlot(Name.data(), Name.size(), Displacement, EntryCount);
+                        if (SlotToAsset[Slot] != NoAsset || std::find(Slots.begin(), Slots.end(), Slot) != Slots.end())
+                        {
+                            IsPlaced = false;
+                            break;
+                        }
+                        Slots.push_back(Slot);
+                    }
+                    if (IsPlaced)
+                    {
+                        Displacements[BucketIndex] = Displacement;
+                        for (size_t Index = 0; Index < Bucket.size(); ++Index)
+                        {
+                            SlotToAsset[Slots[Index]] = Bucket[Index];
+                        }
+                    }
+                }
+                if (!IsPlaced)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    } // namespace Detail
+
+    // Returns an empty vector if names are duplicated or no perfect hash is found, Stats->Error tells which. Assets are
+    // compressed if it saves at least 1/8.
+    inline std::vector<char> BuildAssetPack(std::vector<InputAsset> Assets, bool Compress, AssetPackStats* Stats)
+    {
+        // deterministic output
+        std::sort(Assets.begin(), Assets.end(), [](const InputAsset& A, const InputAsset& B) {
+            return A.Name < B.Name;
+        });
+        auto IsSameName = [](const InputAsset& A, const InputAsset& B) { return A.Name == B.Name; };
+        if (auto Same = std::adjacent_find(Assets.begin(), Assets.end(), IsSameName); Same != Assets.end())
+        {
+            if (Stats)
+            {
+                Stats->Error = "duplicated name " + Same->Name;
+            }
+            return {};
+        }
+
+        auto EntryCount  = static_cast<uint32>(Assets.size());
+        auto BucketCount = std::max(1u, EntryCount / 2);
+
+        std::vector<uint32> Displacements;
+        std::vector<uint32> SlotToAsset;
+        if (!Detail::BuildPerfectHash(Assets, BucketCount, Displacements, SlotToAsset))
+        {
+            if (Stats)
+            {
+                Stats->Error = "no perfect hash found for the names";
+            }
+            return {};
+        }
+
+        AssetPackHeader Header     = {};
+        Header.Magic               = AssetPackMagic;
+        Header.Version             = AssetPackVersion;
+        Header.EntryCount          = EntryCount;
+        Header.BucketCount         = BucketCount;
+        Header.DisplacementsOffset = sizeof(AssetPackHeader);
+        Header.EntriesOffset =
+            Detail::AlignUp(Header.DisplacementsOffset + BucketCount * sizeof(uint32), alignof(AssetPackEntry));
+        Header.NamesOffset = Header.EntriesOffset + EntryCount * sizeof(AssetPackEntry);
+
+        std::vector<std::vector<char>> Stored(EntryCount);
+        std::vector<AssetPackEntry>    Entries(EntryCount);
+        std::string                    Names;
+        auto                           Offset = Header.NamesOffset;
+        for (auto& Asset : Assets)
+        {
+            Offset += Asset.Name.size();
+        }
+        for (uint32 Slot = 0; Slot < EntryCount; ++Slot)
+        {
+            auto& Asset       = Assets[SlotToAsset[Slot]];
+            auto& Blob        = Stored[Slot];
+            auto& Entry       = Entries[Slot];
+            Entry.Compression = AssetCompression::None;
+            if (Compress && !Asset.Data.empty())
+            {
+                Blob.resize(Lz::CompressBound(Asset.Data.size()));
+                auto StoredSize = Lz::Compress(Asset.Data.data(), Asset.Data.size(), Blob.data(), Blob.size());
+                if (StoredSize && StoredSize < Asset.Data.size() - Asset.Data.size() / 8)
+                {
+                    Blob.resize(StoredSize);
+                    Entry.Compression = AssetCompression::Lz;
+                }
+            }
+            if (Entry.Compression == AssetCompression::None)
+            {
+                Blob = Asset.Data;
+            }
+
+            Entry.NameHash   = HashBytes(Asset.Name.data(), Asset.Name.size());
+            Entry.NameOffset = static_cast<uint32>(Names.size());
+            Entry.NameLength = static_cast<uint32>(Asset.Name.size());
+            Entry.Size       = Asset.Data.size();
+            Entry.StoredSize = Blob.size();
+            Names += Asset.Name;
+
+            Offset       = Detail::AlignUp(Offset, AssetPackAlignment);
+            Entry.Offset = Offset;
+            Offset += Entry.StoredSize;
+        }
+        Header.FileSize = Offset;
+
+        std::vector<char> Pack(Header.FileSize, 0);
+        memcpy(Pack.data(), &Header, sizeof(Header));
+        memcpy(Pack.data() + Header.DisplacementsOffset, Displacements.data(), BucketCount * sizeof(uint32));
+        memcpy(Pack.data() + Header.EntriesOffset, Entries.data(), EntryCount * sizeof(AssetPackEntry));
+        memcpy(Pack.data() + Header.NamesOffset, Names.data(), Names.size());
+        for (uint32 Slot = 0; Slot < EntryCount; ++Slot)
+        {
+            if (!Stored[Slot].empty()) // an empty vector may have no data
+            {
+                memcpy(Pack.data() + Entries[Slot].Offset, Stored[Slot].data(), Stored[Slot].size());
+            }
+            if (Stats)
+            {
+                Stats->SizeTotal += Entries[Slot].Size;
+                Stats->StoredTotal += Entries[Slot].StoredSize;
+            }
+        }
+        return Pack;
+    }
+
+} // namespace Game
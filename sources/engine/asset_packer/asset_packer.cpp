@@ -0,0 +1,64 @@
+#include "asset_pack_builder.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// usage: asset_packer <input directory> <output pack> [-compress]
+// every file below the input directory is stored under its relative path, with '/' separators
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <input directory> <output pack> [-compress]\n", argv[0]);
+        return 1;
+    }
+    fs::path InputDirectory = argv[1];
+    fs::path OutputPath     = argv[2];
+    bool     Compress       = argc > 3 && strcmp(argv[3], "-compress") == 0;
+
+    std::vector<Game::InputAsset> Assets;
+    std::error_code               Error;
+    for (auto& Item : fs::recursive_directory_iterator(InputDirectory, Error))
+    {
+        if (Item.is_regular_file())
+        {
+            std::ifstream File{ Item.path(), std::ios::binary };
+            Assets.push_back({ fs::relative(Item.path(), InputDirectory).generic_string(),
+                               { std::istreambuf_iterator<char>{ File }, std::istreambuf_iterator<char>{} } });
+        }
+    }
+    if (Error)
+    {
+        fprintf(stderr, "cannot read %s: %s\n", InputDirectory.string().c_str(), Error.message().c_str());
+        return 1;
+    }
+
+    auto AssetCount = Assets.size();
+
+    Game::AssetPackStats Stats;
+    auto                 Pack = Game::BuildAssetPack(std::move(Assets), Compress, &Stats);
+    if (Pack.empty())
+    {
+        fprintf(stderr, "cannot build the pack: %s\n", Stats.Error.c_str());
+        return 1;
+    }
+
+    std::ofstream Output{ OutputPath, std::ios::binary };
+    Output.write(Pack.data(), Pack.size());
+    if (!Output)
+    {
+        fprintf(stderr, "cannot write %s\n", OutputPath.string().c_str());
+        return 1;
+    }
+    printf("%zu assets, %llu bytes stored for %llu bytes, pack is %zu bytes\n",
+           AssetCount,
+           static_cast<unsigned long long>(Stats.StoredTotal),
+           static_cast<unsigned long long>(Stats.SizeTotal),
+           Pack.size());
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include "bench.hpp"
+
+#include "../asset_packer/asset_pack_builder.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+#if _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Cold start: load every asset once, from loose files (open + read into a heap buffer) or from the pack (map + find).
+// On Linux the page cache is dropped for the files before each run (posix_fadvise), on Windows the cache stays warm.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr int    AssetCount = 2000;
+    constexpr size_t PageSize   = 4096;
+
+    // touches one byte per page, the game would read the data anyway
+    uint64 Touch(const uint8* Data, uint64 Size)
+    {
+        uint64 Sum = 0;
+        for (uint64 Offset = 0; Offset < Size; Offset += PageSize)
+        {
+            Sum += Data[Offset];
+        }
+        return Sum;
+    }
+
+    struct MappedPack
+    {
+        explicit MappedPack(const fs::path& Path)
+        {
+#if _WIN32
+            File = CreateFileW(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+            LARGE_INTEGER FileSize;
+            GetFileSizeEx(File, &FileSize);
+            Size    = FileSize.QuadPart;
+            Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            Data    = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+            auto File = open(Path.c_str(), O_RDONLY);
+            Size      = static_cast<uint64>(lseek(File, 0, SEEK_END));
+            Data      = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, File, 0);
+            close(File);
+#endif
+        }
+        ~MappedPack()
+        {
+#if _WIN32
+            UnmapViewOfFile(Data);
+            CloseHandle(Mapping);
+            CloseHandle(File);
+#else
+            munmap(Data, Size);
+#endif
+        }
+
+#if _WIN32
+        HANDLE File;
+        HANDLE Mapping;
+#endif
+        void*  Data;
+        uint64 Size;
+    };
+} // namespace
+
+void AssetPackBench()
+{
+    auto Directory = fs::temp_directory_path() / "engine_bench_assets";
+    auto PackPath  = fs::temp_directory_path() / "engine_bench_assets.pack";
+    fs::remove_all(Directory);
+    fs::create_directories(Directory);
+
+    // sprite like sizes: 1KB to 64KB
+    std::vector<Game::InputAsset> Assets;
+    std::vector<std::string>      Names;
+    uint32                        Seed       = 1;
+    uint64                        TotalBytes = 0;
+    for (int Index = 0; Index < AssetCount; ++Index)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        Game::InputAsset Asset;
+        Asset.Name = "sprites/sprite_" + std::to_string(Index) + ".bin";
+        Asset.Data.resize(1024 + (Seed >> 8) % (63 * 1024));
+        for (auto& Byte : Asset.Data)
+        {
+            Seed = Seed * 1664525u + 1013904223u;
+            Byte = static_cast<char>(Seed >> 24);
+        }
+        fs::create_directories((Directory / Asset.Name).parent_path());
+        std::ofstream{ Directory / Asset.Name, std::ios::binary }.write(Asset.Data.data(), Asset.Data.size());
+        TotalBytes += Asset.Data.size();
+        Names.push_back(Asset.Name);
+        Assets.push_back(std::move(Asset));
+    }
+    auto Pack = Game::BuildAssetPack(std::move(Assets), false, nullptr);
+    std::ofstream{ PackPath, std::ios::binary }.write(Pack.data(), Pack.size());
+
+    uint64 Checksum = 0;
+
+    auto EvictLooseFiles = [&] {
+        for (auto& Name : Names)
+        {
+            Bench::EvictFromCache(Directory / Name);
+        }
+    };
+    auto LooseSeconds = Bench::Measure(5, EvictLooseFiles, [&] {
+        for (auto& Name : Names)
+        {
+            auto File = fopen((Directory / Name).string().c_str(), "rb");
+            fseek(File, 0, SEEK_END);
+            auto Size = static_cast<size_t>(ftell(File));
+            fseek(File, 0, SEEK_SET);
+            auto Data = static_cast<uint8*>(malloc(Size));
+            Checksum += fread(Data, 1, Size, File);
+            fclose(File);
+            Checksum += Touch(Data, Size);
+            free(Data);
+        }
+    });
+
+    auto PackSeconds = Bench::Measure(5, [&] { Bench::EvictFromCache(PackPath); }, [&] {
+        MappedPack      Mapped{ PackPath };
+        Game::AssetPack AssetPack;
+        AssetPack.Open(Mapped.Data, Mapped.Size);
+        for (auto& Name : Names)
+        {
+            auto View = AssetPack.Get(Name.c_str());
+            Checksum += View.Size + Touch(View.Data, View.Size);
+        }
+    });
+
+    Game::AssetPack AssetPack;
+    AssetPack.Open(Pack.data(), Pack.size());
+    auto FindSeconds = Bench::Measure(5, [&] {
+        for (auto& Name : Names)
+        {
+            Checksum += AssetPack.Find(Name.c_str())->Size;
+        }
+    });
+
+    Bench::Report("loose files: open + read + touch", LooseSeconds, TotalBytes, "B");
+    Bench::Report("asset pack: map + find + touch", PackSeconds, TotalBytes, "B");
+    Bench::Report("asset pack: find only", FindSeconds, AssetCount, "lookups");
+    Bench::DoNotOptimize(Checksum);
+
+    fs::remove_all(Directory);
+    fs::remove(PackPath);
+}
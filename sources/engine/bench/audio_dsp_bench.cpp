@@ -0,0 +1,68 @@
+#include "bench.hpp"
+
+#include <audio_dsp.hpp>
+
+#include <memory>
+#include <vector>
+
+// One second of 48kHz stereo noise: each effect alone on blocks of 256 frames, then the mixer chain (peak filter,
+// compressor, reverb) with the int16 conversions. Real time is 0.048 Mframe/s.
+
+namespace
+{
+    constexpr uint32 FrameCount = 48000;
+    constexpr real32 SampleRate = 48000.0f;
+
+    template <typename E>
+    void RunBlocks(const char* Name, E& Effect)
+    {
+        Game::AudioBlock Block;
+        Block.FrameCount = Game::AudioBlock::MaxFrameCount;
+        uint32 Seed      = 1;
+        for (auto& Sample : Block.Samples)
+        {
+            Seed   = Seed * 1664525u + 1013904223u;
+            Sample = static_cast<real32>(static_cast<int32>(Seed)) / 2147483648.0f * 0.5f;
+        }
+        auto Seconds = Bench::Measure(10, [&] {
+            for (uint32 Frame = 0; Frame < FrameCount; Frame += Block.FrameCount)
+            {
+                Effect.Process(Block);
+            }
+        });
+        Bench::DoNotOptimize(Block.Samples[0]);
+        Bench::Report(Name, Seconds, FrameCount, "frame");
+    }
+} // namespace
+
+void AudioDspBench()
+{
+    Game::Biquad Filter{ SampleRate };
+    Filter.Set(Game::Biquad::Type::Peak, 2000.0f, 1.0f, 4.0f);
+    RunBlocks("biquad, peak", Filter);
+
+    auto Reverb = std::make_unique<Game::FeedbackDelayReverb>();
+    Reverb->SetMix(0.3f);
+    RunBlocks("feedback delay reverb", *Reverb);
+
+    Game::Compressor Compress{ SampleRate };
+    Compress.SetThreshold(-12.0f);
+    Compress.SetRatio(4.0f);
+    RunBlocks("compressor", Compress);
+
+    Game::EffectChain Chain;
+    Chain.Insert(Filter);
+    Chain.Insert(Compress);
+    Chain.Insert(*Reverb);
+    std::vector<int16> Input(2 * FrameCount);
+    std::vector<int16> Samples(2 * FrameCount);
+    uint32             Seed = 3;
+    for (auto& Sample : Input)
+    {
+        Seed   = Seed * 1664525u + 1013904223u;
+        Sample = static_cast<int16>(Seed >> 20) - 2048;
+    }
+    auto Seconds = Bench::Measure(10, [&] { Samples = Input; }, [&] { Chain.Process(Samples.data(), FrameCount); });
+    Bench::DoNotOptimize(Samples[0]);
+    Bench::Report("chain of 3, int16 stereo", Seconds, FrameCount, "frame");
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+#if !_WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Best of RepeatCount runs, in seconds. Setup runs before each run, out of the measure.
+    template <typename S, typename F>
+    double Measure(int RepeatCount, S&& Setup, F&& Function)
+    {
+        double Best = 1e30;
+        for (int Repeat = 0; Repeat < RepeatCount; ++Repeat)
+        {
+            Setup();
+            auto Start   = Clock::now();
+            Function();
+            auto Elapsed = std::chrono::duration<double>(Clock::now() - Start).count();
+            Best         = Elapsed < Best ? Elapsed : Best;
+        }
+        return Best;
+    }
+
+    template <typename F>
+    double Measure(int RepeatCount, F&& Function)
+    {
+        return Measure(RepeatCount, [] {}, Function);
+    }
+
+    // Prints the time and the throughput: ItemCount Unit per second
+    inline void Report(const char* Name, double Seconds, double ItemCount, const char* Unit)
+    {
+        printf("%-48s %10.3f ms %12.2f M%s/s\n", Name, Seconds * 1e3, ItemCount / Seconds * 1e-6, Unit);
+    }
+
+    // Cold reads: drops the file from the page cache on Linux, on Windows the cache stays warm
+    inline void EvictFromCache([[maybe_unused]] const std::filesystem::path& Path)
+    {
+#if !_WIN32
+        auto File = open(Path.c_str(), O_RDONLY);
+        if (File >= 0)
+        {
+            fdatasync(File);
+            posix_fadvise(File, 0, 0, POSIX_FADV_DONTNEED);
+            close(File);
+        }
+#endif
+    }
+
+    inline const void* volatile Sink = nullptr;
+
+    // Keeps the optimizer from removing a computation
+    template <typename T>
+    void DoNotOptimize(const T& Value)
+    {
+        Sink = &Value;
+    }
+
+} // namespace Bench
+
+// one entry point per benchmarked module, called by main
+void AssetPackBench();
+void FileServiceBench();
+void BlitBench();
+void RenderCommandsBench();
+void RasterizerBench();
+void TileMapBench();
+void MathBench();
+void EntitiesBench();
+void ParticlesBench();
+void BroadphaseBench();
+void PathfindingBench();
+void PackedInputsBench();
+void SnapshotBench();
+void LoggerBench();
+void FormatBench();
+void InternedStringBench();
+void FlatHashMapBench();
+void SerializationBench();
+void MetricsBench();
+void DebugOverlayBench();
+void BitmapFontBench();
+void PixelFormatBench();
+void AudioDspBench();
@@ -0,0 +1,48 @@
+#include "bench.hpp"
+
+#include <cstring>
+
+// usage: engine_bench [name filter]
+int main(int argc, char** argv)
+{
+    struct Entry
+    {
+        const char* Name;
+        void (*Run)();
+    };
+    const Entry Entries[] = {
+        { "asset_pack", AssetPackBench },
+        { "file_service", FileServiceBench },
+        { "blit", BlitBench },
+        { "render_commands", RenderCommandsBench },
+        { "rasterizer", RasterizerBench },
+        { "tilemap", TileMapBench },
+        { "math", MathBench },
+        { "entities", EntitiesBench },
+        { "particles", ParticlesBench },
+        { "broadphase", BroadphaseBench },
+        { "pathfinding", PathfindingBench },
+        { "packed_inputs", PackedInputsBench },
+        { "snapshot", SnapshotBench },
+        { "logger", LoggerBench },
+        { "format", FormatBench },
+        { "interned_string", InternedStringBench },
+        { "flat_hash_map", FlatHashMapBench },
+        { "serialization", SerializationBench },
+        { "metrics", MetricsBench },
+        { "debug_overlay", DebugOverlayBench },
+        { "bitmap_font", BitmapFontBench },
+        { "pixel_format", PixelFormatBench },
+        { "audio_dsp", AudioDspBench },
+    };
+
+    for (auto& Entry : Entries)
+    {
+        if (argc < 2 || strstr(Entry.Name, argv[1]))
+        {
+            printf("== %s\n", Entry.Name);
+            Entry.Run();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "bench.hpp"
+
+#include <bitmap_font.hpp>
+
+#include <vector>
+
+// Text in a 1280x720 frame: measuring and laying out a line of 48 characters with the cached metrics, then drawing
+// 40 such lines (2000 glyphs) at each SIMD level, with the built-in font at scale 1 and 2.
+
+namespace
+{
+    constexpr uint32 LineCount = 40;
+    constexpr char   Line[]    = "frame 16.67 ms, update 4.20 ms, render 9.81 ms!";
+} // namespace
+
+void BitmapFontBench()
+{
+    constexpr int32     Width  = 1280;
+    constexpr int32     Height = 720;
+    std::vector<uint32> Pixels(size_t(Width) * Height, 0x00336699);
+    PIBackBuffer        Buffer = { Pixels.data(), Width, Height, 4, Width * 4 };
+    std::vector<uint8>  Memory(1 << 16);
+    Game::MemoryArena   Arena{ Memory.data(), Memory.size() };
+    Game::BitmapFont    Font{ Arena };
+    Game::BitmapFont    Large{ Arena, 2 };
+
+    constexpr uint32 CallCount = 100000;
+    int64            Total     = 0;
+    auto             Seconds   = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Total += Font.Measure(Line).Width;
+        }
+    });
+    Bench::Report("measure, 48 characters", Seconds, CallCount, "line");
+    Bench::DoNotOptimize(Total);
+
+    Game::GlyphQuad Quads[64];
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Total += Font.Layout(Line, int32(Call & 63), 8, Quads, 64);
+        }
+    });
+    Bench::Report("layout, 48 characters", Seconds, CallCount, "line");
+    Bench::DoNotOptimize(Quads);
+
+    for (auto* Used : { &Font, &Large })
+    {
+        std::vector<Game::GlyphQuad> Text(LineCount * 64);
+        uint32                       Count = 0;
+        for (uint32 Index = 0; Index < LineCount; ++Index)
+        {
+            Count += Used->Layout(Line, 8, 8 + int32(Index) * Used->GetLineHeight(), Text.data() + Count, 64);
+        }
+        for (auto Level : { Game::SimdLevel::Scalar, Game::SimdLevel::Sse2, Game::GetBestSimdLevel() })
+        {
+            Seconds = Bench::Measure(10, [&] {
+                Game::DrawGlyphs(Buffer, *Used, Text.data(), Count, 0xC0C0C0C0, Game::GetBufferRect(Buffer), Level);
+            });
+            char Name[64];
+            snprintf(Name, sizeof(Name), "draw, scale %d, %s", Used == &Font ? 1 : 2, Game::GetSimdLevelName(Level));
+            Bench::Report(Name, Seconds, Count, "glyph");
+        }
+    }
+    Bench::DoNotOptimize(Pixels);
+}
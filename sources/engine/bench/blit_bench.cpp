@@ -0,0 +1,92 @@
+#include "bench.hpp"
+
+#include <blit.hpp>
+
+#include <string>
+#include <vector>
+
+// 64x64 sprites at random positions of a 1280x720 back buffer, some of them clipped by the borders.
+// Throughput in pixels written (after clipping), per alpha kind and per kernel.
+
+namespace
+{
+    constexpr int32 BufferWidth  = 1280;
+    constexpr int32 BufferHeight = 720;
+    constexpr int32 SpriteSize   = 64;
+    constexpr int32 DrawCount    = 4000;
+
+    std::vector<uint32> MakeSprite(Game::BitmapAlpha Alpha)
+    {
+        std::vector<uint32> Pixels(SpriteSize * SpriteSize);
+        for (int32 Y = 0; Y < SpriteSize; ++Y)
+        {
+            for (int32 X = 0; X < SpriteSize; ++X)
+            {
+                // a disc with a soft border
+                auto   DX       = X - SpriteSize / 2;
+                auto   DY       = Y - SpriteSize / 2;
+                auto   Distance = DX * DX + DY * DY;
+                uint32 A        = Distance < 24 * 24 ? 255 : 0;
+                if (Distance >= 24 * 24 && Distance < 32 * 32)
+                {
+                    A = 255 - (Distance - 24 * 24) * 255 / (32 * 32 - 24 * 24);
+                }
+                A = Alpha == Game::BitmapAlpha::Opaque ? 255 : Alpha == Game::BitmapAlpha::Mask && A ? 255 : A;
+                auto Color = (uint32(X * 4) * A / 255 << 16) | (uint32(Y * 4) * A / 255 << 8) | (A / 2);
+                Pixels[Y * SpriteSize + X] = A ? (A << 24) | Color : 0;
+            }
+        }
+        return Pixels;
+    }
+} // namespace
+
+void BlitBench()
+{
+    std::vector<uint32> Memory(BufferWidth * BufferHeight, 0xFF203040);
+    PIBackBuffer        Buffer = { Memory.data(), BufferWidth, BufferHeight, 4, BufferWidth * 4 };
+
+    struct Position
+    {
+        int32 X, Y;
+    };
+    std::vector<Position> Positions(DrawCount);
+    uint32                Seed = 5;
+    for (auto& Position : Positions)
+    {
+        Seed       = Seed * 1664525u + 1013904223u;
+        Position.X = int32((Seed >> 8) % (BufferWidth + SpriteSize)) - SpriteSize;
+        Seed       = Seed * 1664525u + 1013904223u;
+        Position.Y = int32((Seed >> 8) % (BufferHeight + SpriteSize)) - SpriteSize;
+    }
+    uint64 PixelCount = 0;
+    for (auto& Position : Positions)
+    {
+        auto Area = Game::Intersect(Game::GetBufferRect(Buffer),
+                                    { Position.X, Position.Y, Position.X + SpriteSize, Position.Y + SpriteSize });
+        PixelCount += Area.IsEmpty() ? 0 : uint64(Area.MaxX - Area.MinX) * (Area.MaxY - Area.MinY);
+    }
+
+    const Game::BitmapAlpha Alphas[] = { Game::BitmapAlpha::Opaque, Game::BitmapAlpha::Mask, Game::BitmapAlpha::Blend };
+    const char*             Names[]  = { "opaque", "mask", "blend" };
+    for (int Kind = 0; Kind < 3; ++Kind)
+    {
+        auto         Pixels = MakeSprite(Alphas[Kind]);
+        Game::Bitmap Sprite = { Pixels.data(), SpriteSize, SpriteSize, SpriteSize * 4, Alphas[Kind] };
+        for (auto Level : { Game::SimdLevel::Scalar, Game::SimdLevel::Sse2, Game::SimdLevel::Avx2 })
+        {
+            if (Level == Game::SimdLevel::Avx2 && !Game::GetCpuFeatures().Avx2)
+            {
+                continue;
+            }
+            auto Seconds = Bench::Measure(5, [&] {
+                for (auto& Position : Positions)
+                {
+                    Game::DrawBitmap(Buffer, Sprite, Position.X, Position.Y, Game::GetBufferRect(Buffer), Level);
+                }
+            });
+            auto Name = std::string("draw bitmap: ") + Names[Kind] + ", " + Game::GetSimdLevelName(Level);
+            Bench::Report(Name.c_str(), Seconds, double(PixelCount), "Pix");
+        }
+    }
+    Bench::DoNotOptimize(Memory[BufferWidth * BufferHeight / 2]);
+}
@@ -0,0 +1,102 @@
+#include "bench.hpp"
+
+#include <broadphase.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// 10k to 1M boxes of 0.5 to 3 units, 4 units apart on average (about 1.5 overlaps per box), cells of 4 units. The
+// grid is rebuilt each frame; the sweep and prune is updated after a small move of every box (the incremental sort)
+// and after a teleport of every box (the radix sort). One thread, then all of them.
+
+namespace
+{
+    struct Scene
+    {
+        explicit Scene(uint32 Count)
+            : Boxes(Count)
+            , Moves(Count)
+        {
+            auto   Side = std::sqrt(real32(Count)) * 4.0f;
+            uint32 Seed = 11;
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                auto X         = Next(Seed) * Side;
+                auto Y         = Next(Seed) * Side;
+                Boxes[Index] = { { X, Y }, { X + 0.5f + Next(Seed) * 2.5f, Y + 0.5f + Next(Seed) * 2.5f } };
+                Moves[Index] = { Next(Seed) * 0.02f - 0.01f, Next(Seed) * 0.02f - 0.01f };
+            }
+        }
+
+        static real32 Next(uint32& Seed)
+        {
+            Seed = Seed * 1664525u + 1013904223u;
+            return real32(Seed >> 8) / 16777216.0f;
+        }
+
+        void Move(real32 Scale)
+        {
+            for (uint32 Index = 0; Index < Boxes.size(); ++Index)
+            {
+                Boxes[Index].Min = Boxes[Index].Min + Moves[Index] * Scale;
+                Boxes[Index].Max = Boxes[Index].Max + Moves[Index] * Scale;
+            }
+        }
+
+        std::vector<Game::Aabb> Boxes;
+        std::vector<Game::v2>   Moves;
+    };
+} // namespace
+
+void BroadphaseBench()
+{
+    std::vector<uint8>          Memory(512 << 20);
+    std::vector<Game::BodyPair> Storage(4 << 20);
+    Game::ThreadPoolJobSystem   ThreadPool;
+    Game::JobSystem*            Parallel = &ThreadPool;
+    char                        Name[96];
+
+    for (uint32 Count : { 10000u, 100000u, 1000000u })
+    {
+        Scene               World{ Count };
+        Game::MemoryArena   Arena{ Memory.data(), Memory.size() };
+        Game::HashGrid      Grid{ Arena, Count, 8 * Count, 4.0f, 21 };
+        Game::SweepAndPrune Sweep{ Arena, Count, 4 * Count, 16.0f };
+        Game::PairBuffer    Pairs{ Storage.data(), uint32(Storage.size()) };
+        auto                Clear = [&] { Pairs.Count = 0; };
+
+        for (auto Jobs : { static_cast<Game::JobSystem*>(nullptr), Parallel })
+        {
+            auto Threads = Jobs ? Jobs->GetThreadCount() : 1;
+
+            auto Seconds = Bench::Measure(5, Clear, [&] {
+                Grid.Build(World.Boxes.data(), Count, Jobs);
+                Grid.FindPairs(Pairs, Jobs);
+            });
+            snprintf(Name, sizeof(Name), "grid, %u boxes, %u threads", Count, Threads);
+            Bench::Report(Name, Seconds, Pairs.Count, "pair");
+
+            Sweep.Update(World.Boxes.data(), Count, Jobs);
+            Seconds = Bench::Measure(5, [&] {
+                World.Move(1.0f);
+                Clear();
+            }, [&] {
+                Sweep.Update(World.Boxes.data(), Count, Jobs);
+                Sweep.FindPairs(Pairs, Jobs);
+            });
+            snprintf(Name, sizeof(Name), "sweep, small moves, %u boxes, %u threads", Count, Threads);
+            Bench::Report(Name, Seconds, Pairs.Count, "pair");
+
+            Seconds = Bench::Measure(5, [&] {
+                std::reverse(World.Boxes.begin(), World.Boxes.end());
+                Clear();
+            }, [&] {
+                Sweep.Update(World.Boxes.data(), Count, Jobs);
+                Sweep.FindPairs(Pairs, Jobs);
+            });
+            snprintf(Name, sizeof(Name), "sweep, teleports, %u boxes, %u threads", Count, Threads);
+            Bench::Report(Name, Seconds, Pairs.Count, "pair");
+        }
+    }
+}
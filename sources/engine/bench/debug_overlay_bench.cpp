@@ -0,0 +1,60 @@
+#include "bench.hpp"
+
+#include <debug_overlay.hpp>
+
+#include <vector>
+
+// Cost of the overlay in a 1280x720 frame: a graph of 256 frames, 6 profiler bars, 4 usage bars and 3 lines of text
+// in a 320 pixel wide panel, from the widgets to the pixels. The budget is 0.2 ms per frame.
+
+namespace
+{
+    constexpr uint32 FrameCount = 200;
+} // namespace
+
+void DebugOverlayBench()
+{
+    constexpr int32     Width  = 1280;
+    constexpr int32     Height = 720;
+    std::vector<uint32> Pixels(size_t(Width) * Height, 0x00336699);
+    PIBackBuffer        Buffer = { Pixels.data(), Width, Height, 4, Width * 4 };
+    std::vector<uint8>  Memory(1 << 20);
+    Game::MemoryArena   Arena{ Memory.data(), Memory.size() };
+    Game::DebugOverlay  Overlay{ Arena };
+
+    const char*         Names[] = { "input", "update", "render", "sound", "blit", "overlay" };
+    Game::ProfileRecord Records[6];
+    for (uint32 Index = 0; Index < 6; ++Index)
+    {
+        Records[Index].Name           = Names[Index];
+        Records[Index].LastCycleCount = 150000 * (Index + 1);
+    }
+    for (uint32 Frame = 0; Frame < Game::DebugOverlay::HistorySize; ++Frame)
+    {
+        Overlay.AddFrameTime(real32(20 + (Frame * 7) % 30));
+    }
+
+    for (auto Level : { Game::SimdLevel::Scalar, Game::SimdLevel::Sse2, Game::GetBestSimdLevel() })
+    {
+        auto Seconds = Bench::Measure(5, [&] {
+            for (uint32 Frame = 0; Frame < FrameCount; ++Frame)
+            {
+                Overlay.Begin(8, 8, 320);
+                Overlay.AddText("debug overlay, F1 to hide");
+                Overlay.AddFrameGraph(33.3f);
+                Overlay.AddProfileBars(Records, 6, 100000000 / 30);
+                Overlay.AddUsageBar("permanent", Megabytes(40), Megabytes(64));
+                Overlay.AddUsageBar("transient", Megabytes(300), Megabytes(512));
+                Overlay.AddUsageBar("strings", Kilobytes(300), Megabytes(1));
+                Overlay.AddUsageBar("log", Kilobytes(60), Kilobytes(64));
+                Overlay.AddText("latency 1600 samples (jitter 12.5)");
+                Overlay.AddText("0 underruns, 3 reloads");
+                Overlay.End(Buffer, Level);
+            }
+        });
+        char Name[64];
+        snprintf(Name, sizeof(Name), "overlay, %s", Game::GetSimdLevelName(Level));
+        printf("%-48s %10.3f ms per frame\n", Name, Seconds * 1e3 / FrameCount);
+    }
+    Bench::DoNotOptimize(Pixels);
+}
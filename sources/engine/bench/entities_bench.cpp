@@ -0,0 +1,138 @@
+#include "bench.hpp"
+
+#include <entities.hpp>
+
+#include <vector>
+
+// 1M entities, 3 in 4 of them moving: Position += Velocity * Dt. The baseline is the usual array of game objects,
+// every object holding every field and a flag tested per object, against the entity store walked per entity, per
+// chunk and per chunk on the job system.
+
+namespace
+{
+    constexpr uint32 EntityCount = 1 << 20;
+    constexpr real32 Dt          = 1.0f / 60.0f;
+
+    struct Position
+    {
+        real32 X, Y, Z;
+    };
+
+    struct Velocity
+    {
+        real32 X, Y, Z;
+    };
+
+    struct Health
+    {
+        int32 Value;
+    };
+
+    struct Prop
+    {
+    };
+
+    // what the systems not run here keep in a game object
+    struct Sprite
+    {
+        uint32 Id;
+        uint32 Frame;
+        real32 Scale;
+        uint32 Color;
+    };
+
+    struct GameObject
+    {
+        Position Where;
+        Velocity Speed;
+        Health   Life;
+        Sprite   Look;
+        uint32   Flags;
+        bool     IsMoving;
+    };
+
+    using Store = Game::EntityStore<Position, Velocity, Health, Sprite, Prop>;
+
+    Velocity MakeVelocity(uint32 Index) { return { real32(Index % 7), 1.0f, -real32(Index % 3) }; }
+
+    template <typename F>
+    void Run(const char* Name, F&& Function)
+    {
+        constexpr int Repeat  = 10;
+        auto          Seconds = Bench::Measure(5, [&] {
+            for (int Index = 0; Index < Repeat; ++Index)
+            {
+                Function();
+            }
+        });
+        Bench::Report(Name, Seconds / Repeat, EntityCount, "ent");
+    }
+} // namespace
+
+void EntitiesBench()
+{
+    std::vector<GameObject> Objects(EntityCount);
+    for (uint32 Index = 0; Index < EntityCount; ++Index)
+    {
+        Objects[Index]          = {};
+        Objects[Index].IsMoving = Index % 4 != 0;
+        Objects[Index].Speed    = MakeVelocity(Index);
+    }
+
+    std::vector<uint8> Memory(256 << 20);
+    Game::MemoryArena  Arena{ Memory.data(), Memory.size() };
+    Store              Entities{ Arena, EntityCount };
+    for (uint32 Index = 0; Index < EntityCount; ++Index)
+    {
+        switch (Index % 4)
+        {
+        case 0:
+            Entities.Create(Position{}, Health{}, Sprite{}, Prop{});
+            break;
+        case 1:
+            Entities.Create(Position{}, MakeVelocity(Index), Health{}, Sprite{});
+            break;
+        default:
+            Entities.Create(Position{}, MakeVelocity(Index), Sprite{});
+            break;
+        }
+    }
+
+    Run("array of game objects", [&] {
+        for (auto& Object : Objects)
+        {
+            if (Object.IsMoving)
+            {
+                Object.Where.X += Object.Speed.X * Dt;
+                Object.Where.Y += Object.Speed.Y * Dt;
+                Object.Where.Z += Object.Speed.Z * Dt;
+            }
+        }
+    });
+
+    auto Move = [](Position& P, const Velocity& V) {
+        P.X += V.X * Dt;
+        P.Y += V.Y * Dt;
+        P.Z += V.Z * Dt;
+    };
+    Run("entity store: ForEach", [&] { Entities.ForEach<Position, const Velocity>(Move); });
+    Run("entity store: ForEachChunk", [&] {
+        Entities.ForEachChunk<Position, const Velocity>(
+            [](uint32 Count, const Game::Entity*, Position* P, const Velocity* V) {
+                for (uint32 Index = 0; Index < Count; ++Index)
+                {
+                    P[Index].X += V[Index].X * Dt;
+                    P[Index].Y += V[Index].Y * Dt;
+                    P[Index].Z += V[Index].Z * Dt;
+                }
+            });
+    });
+
+    Game::ThreadPoolJobSystem Jobs;
+    char                      Name[64];
+    snprintf(Name, sizeof(Name), "entity store: ParallelForEach, %u threads", Jobs.GetThreadCount());
+    Run(Name, [&] { Entities.ParallelForEach<Position, const Velocity>(&Jobs, Move); });
+
+    Bench::DoNotOptimize(Objects[EntityCount - 1]);
+    Bench::DoNotOptimize(Arena);
+}
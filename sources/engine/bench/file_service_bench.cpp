@@ -0,0 +1,162 @@
+#include "bench.hpp"
+
+#include <file_service.hpp>
+
+#if !_WIN32
+#include "../linux/io_uring_file_service.hpp"
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+// Streaming: 64KB reads at random offsets of a cold 64MB file, synchronous (one fread after the other) or through the
+// file service (batches of up to 64 submitted, completions polled like a frame loop would). The latency of a request
+// is the time from its submission to the moment its completion is visible.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr uint64 FileSize     = 64 * 1024 * 1024;
+    constexpr uint32 RequestSize  = 64 * 1024;
+    constexpr uint32 RequestCount = FileSize / RequestSize;
+    constexpr uint32 BatchSize    = 64;
+
+    struct Latencies
+    {
+        std::vector<double> Samples;
+
+        void Report(const char* Name, double Seconds) const
+        {
+            auto Sorted = Samples;
+            std::sort(Sorted.begin(), Sorted.end());
+            Bench::Report(Name, Seconds, FileSize, "B");
+            printf("%-48s %10.1f us median %8.1f us p99\n",
+                   "",
+                   Sorted[Sorted.size() / 2] * 1e6,
+                   Sorted[Sorted.size() * 99 / 100] * 1e6);
+        }
+    };
+
+    std::unique_ptr<Game::FileService> CreateService()
+    {
+#if _WIN32
+        return std::make_unique<Game::ThreadPoolFileService>();
+#else
+        return Linux::CreateFileService();
+#endif
+    }
+
+    double Seconds(Bench::Clock::time_point Start, Bench::Clock::time_point End)
+    {
+        return std::chrono::duration<double>(End - Start).count();
+    }
+} // namespace
+
+void FileServiceBench()
+{
+    auto Path = fs::temp_directory_path() / "engine_bench_stream.bin";
+    {
+        std::vector<char> Data(FileSize);
+        uint32            Seed = 1;
+        for (auto& Byte : Data)
+        {
+            Seed = Seed * 1664525u + 1013904223u;
+            Byte = static_cast<char>(Seed >> 24);
+        }
+        std::ofstream{ Path, std::ios::binary }.write(Data.data(), Data.size());
+    }
+
+    // every block once, shuffled
+    std::vector<uint64> Offsets(RequestCount);
+    uint32              Seed = 7;
+    for (uint32 Index = 0; Index < RequestCount; ++Index)
+    {
+        Offsets[Index] = uint64(Index) * RequestSize;
+    }
+    for (uint32 Index = RequestCount - 1; Index > 0; --Index)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        std::swap(Offsets[Index], Offsets[(Seed >> 8) % (Index + 1)]);
+    }
+
+    std::vector<uint8> Memory(RequestCount * RequestSize + 64);
+    uint64             Checksum = 0;
+
+    Latencies Sync;
+    auto      EvictSync = [&] {
+        Bench::EvictFromCache(Path);
+        Sync.Samples.clear();
+    };
+    auto SyncSeconds = Bench::Measure(3, EvictSync, [&] {
+        auto File = fopen(Path.string().c_str(), "rb");
+        for (uint32 Index = 0; Index < RequestCount; ++Index)
+        {
+            auto Start = Bench::Clock::now();
+            fseek(File, static_cast<long>(Offsets[Index]), SEEK_SET);
+            Checksum += fread(Memory.data() + uint64(Index) * RequestSize, 1, RequestSize, File);
+            Sync.Samples.push_back(Seconds(Start, Bench::Clock::now()));
+        }
+        fclose(File);
+    });
+    Sync.Report("synchronous fread", SyncSeconds);
+
+    auto                Service = CreateService();
+    Game::MemoryArena   Arena{ Memory.data(), Memory.size() };
+    uint64              FileSizeRead;
+    auto                File = Service->OpenForRead(Path.string().c_str(), &FileSizeRead);
+    std::vector<double> SubmitTimes(RequestCount);
+    Latencies           Async;
+    auto                EvictAsync = [&] {
+        Bench::EvictFromCache(Path);
+        Async.Samples.clear();
+    };
+    auto AsyncSeconds = Bench::Measure(3, EvictAsync, [&] {
+        Arena.Reset();
+        auto   Origin    = Bench::Clock::now();
+        uint32 Submitted = 0;
+        uint32 Completed = 0;
+        while (Completed < RequestCount)
+        {
+            // never more than the service accepts: the buffers pushed on the arena are all used
+            Game::FileReadRequest Batch[BatchSize];
+            uint32                Count    = 0;
+            auto                  Capacity = Game::FileService::MaxInFlightCount - Service->GetInFlightCount();
+            while (Count < BatchSize && Count < Capacity && Submitted + Count < RequestCount)
+            {
+                auto Index     = Submitted + Count;
+                Batch[Count++] = Game::PushRead(Arena, File, Offsets[Index], RequestSize, Index);
+            }
+            auto Accepted = Service->SubmitReads(Batch, Count);
+            auto Now      = Seconds(Origin, Bench::Clock::now());
+            for (uint32 Index = 0; Index < Accepted; ++Index)
+            {
+                SubmitTimes[Submitted + Index] = Now;
+            }
+            Submitted += Accepted;
+
+            Service->BeginFrame();
+            Now = Seconds(Origin, Bench::Clock::now());
+            for (uint32 Index = 0; Index < Service->GetCompletionCount(); ++Index)
+            {
+                auto& Completion = Service->GetCompletion(Index);
+                Checksum += Completion.BytesRead;
+                Async.Samples.push_back(Now - SubmitTimes[Completion.UserData]);
+            }
+            Completed += Service->GetCompletionCount();
+        }
+    });
+    Service->Close(File);
+#if _WIN32
+    Async.Report("file service: thread pool", AsyncSeconds);
+#else
+    Async.Report(dynamic_cast<Linux::IoUringFileService*>(Service.get()) ? "file service: io_uring"
+                                                                          : "file service: thread pool",
+                 AsyncSeconds);
+#endif
+    Bench::DoNotOptimize(Checksum);
+
+    fs::remove(Path);
+}
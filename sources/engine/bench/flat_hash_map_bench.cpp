@@ -0,0 +1,91 @@
+#include "bench.hpp"
+
+#include <flat_hash_map.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+// Random 64-bit keys (entity and asset ids are hashes) at 1k to 10M keys: insertion of every key in a map sized for
+// them, then lookups of present keys and of absent ones in random order, against std::unordered_map with a reserve.
+
+namespace
+{
+    constexpr uint32 LookupCount = 1000000;
+
+    uint64 GetKey(uint64 Index) { return Game::MixHash(Index + 1); }
+} // namespace
+
+void FlatHashMapBench()
+{
+    std::vector<uint8> Memory;
+    for (uint32 KeyCount : { 1000u, 100000u, 1000000u, 10000000u })
+    {
+        std::vector<uint64> Keys(KeyCount);
+        for (uint32 Index = 0; Index < KeyCount; ++Index)
+        {
+            Keys[Index] = GetKey(Index);
+        }
+        std::vector<uint64> Hits(LookupCount);
+        std::vector<uint64> Misses(LookupCount);
+        uint32              Seed = 9;
+        for (uint32 Index = 0; Index < LookupCount; ++Index)
+        {
+            Seed          = Seed * 1664525u + 1013904223u;
+            Hits[Index]   = Keys[Seed % KeyCount];
+            Misses[Index] = GetKey(uint64(KeyCount) + Seed);
+        }
+        auto   Repeat = KeyCount >= 1000000 ? 2 : 10;
+        uint64 Sum    = 0;
+        char   Name[64];
+
+        // room for the largest table: slots of 16 bytes and a control byte, at 7/8
+        auto GroupCount = Game::FlatHashMapping::GetGroupCount(KeyCount);
+        Memory.resize(uint64(GroupCount) * Game::FlatHashMapping::GroupSize * 17 + 256);
+        Game::MemoryArena                  Arena{ Memory.data(), Memory.size() };
+        Game::FlatHashMap<uint64, uint64>  Flat{ Arena, KeyCount };
+        std::unordered_map<uint64, uint64> Standard;
+
+        auto Seconds = Bench::Measure(Repeat, [&] { Flat.Clear(); }, [&] {
+            for (uint32 Index = 0; Index < KeyCount; ++Index)
+            {
+                Flat.Insert(Keys[Index], Index);
+            }
+        });
+        snprintf(Name, sizeof(Name), "insert, FlatHashMap, %u keys", KeyCount);
+        Bench::Report(Name, Seconds, KeyCount, "insert");
+
+        Seconds = Bench::Measure(Repeat, [&] { Standard = {}; Standard.reserve(KeyCount); }, [&] {
+            for (uint32 Index = 0; Index < KeyCount; ++Index)
+            {
+                Standard[Keys[Index]] = Index;
+            }
+        });
+        snprintf(Name, sizeof(Name), "insert, unordered_map, %u keys", KeyCount);
+        Bench::Report(Name, Seconds, KeyCount, "insert");
+
+        for (auto* Lookups : { &Hits, &Misses })
+        {
+            auto Kind = Lookups == &Hits ? "hit" : "miss";
+            Seconds   = Bench::Measure(Repeat, [&] {
+                for (auto Key : *Lookups)
+                {
+                    auto Value = Flat.Find(Key);
+                    Sum += Value ? *Value : 1;
+                }
+            });
+            snprintf(Name, sizeof(Name), "%s, FlatHashMap, %u keys", Kind, KeyCount);
+            Bench::Report(Name, Seconds, LookupCount, "lookup");
+
+            Seconds = Bench::Measure(Repeat, [&] {
+                for (auto Key : *Lookups)
+                {
+                    auto Found = Standard.find(Key);
+                    Sum += Found != Standard.end() ? Found->second : 1;
+                }
+            });
+            snprintf(Name, sizeof(Name), "%s, unordered_map, %u keys", Kind, KeyCount);
+            Bench::Report(Name, Seconds, LookupCount, "lookup");
+        }
+        Bench::DoNotOptimize(Sum);
+    }
+}
@@ -0,0 +1,109 @@
+#include "bench.hpp"
+
+#include <format.hpp>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// One line of text with the same arguments through Game::Format (into a stack buffer, then into an arena),
+// std::ostringstream and snprintf: integers only, then floats, then a mixed line with a string and padding.
+
+namespace
+{
+    constexpr uint32 CallCount = 100000;
+} // namespace
+
+void FormatBench()
+{
+    char   Buffer[256];
+    real64 Value = 0.0;
+    uint64 Size  = 0;
+
+    auto Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            auto Text = Game::Format(Buffer, GAME_FORMAT_STRING("frame {} took {} us, {} entities"), Call, 33333, -42);
+            Size += Text.size();
+        }
+    });
+    Bench::Report("Game::Format, 3 integers", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Size += uint64(snprintf(Buffer, sizeof(Buffer), "frame %u took %d us, %d entities", Call, 33333, -42));
+        }
+    });
+    Bench::Report("snprintf, 3 integers", Seconds, CallCount, "call");
+
+    std::ostringstream Stream;
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Stream.str({});
+            Stream << "frame " << Call << " took " << 33333 << " us, " << -42 << " entities";
+            Size += Stream.str().size();
+        }
+    });
+    Bench::Report("ostringstream, 3 integers", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Value += 0.001;
+            auto Rate = 1000 / Value;
+            auto Text = Game::Format(Buffer, GAME_FORMAT_STRING("{:.2f}ms/f, {:.2f}fps, {:.3e}"), Value, Rate, Value);
+            Size += Text.size();
+        }
+    });
+    Bench::Report("Game::Format, 3 floats", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Value += 0.001;
+            Size += uint64(snprintf(Buffer, sizeof(Buffer), "%.2fms/f, %.2ffps, %.3e", Value, 1000 / Value, Value));
+        }
+    });
+    Bench::Report("snprintf, 3 floats", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Value += 0.001;
+            Stream.str({});
+            Stream.setf(std::ios::fixed);
+            Stream.precision(2);
+            Stream << Value << "ms/f, " << 1000 / Value << "fps, ";
+            Stream.setf(std::ios::scientific, std::ios::floatfield);
+            Stream.precision(3);
+            Stream << Value;
+            Stream.unsetf(std::ios::floatfield);
+            Size += Stream.str().size();
+        }
+    });
+    Bench::Report("ostringstream, 3 floats", Seconds, CallCount, "call");
+
+    std::vector<uint8> Memory(CallCount * 64);
+    Game::MemoryArena  Arena{ Memory.data(), Memory.size() };
+    Seconds = Bench::Measure(10, [&] { Arena.Reset(); }, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            auto Hash = Call * 2654435761u;
+            auto Text = Game::Format(Arena, GAME_FORMAT_STRING("{:<12}|{:>6}|{:08x}"), "level_01", Call, Hash);
+            Size += Text.size();
+        }
+    });
+    Bench::Report("Game::Format to arena, string, padded integers", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Size += uint64(snprintf(Buffer, sizeof(Buffer), "%-12s|%6u|%08x", "level_01", Call, Call * 2654435761u));
+        }
+    });
+    Bench::Report("snprintf, string, padded integers", Seconds, CallCount, "call");
+    Bench::DoNotOptimize(Size);
+}
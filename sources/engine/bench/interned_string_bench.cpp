@@ -0,0 +1,90 @@
+#include "bench.hpp"
+
+#include <interned_string.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Asset-like names: interning a run time text (hash, probe, compare), the lookup of a literal through GAME_INTERN,
+// then the equality and the hash map lookup of interned names against std::string.
+
+namespace
+{
+    constexpr uint32 NameCount = 4096;
+    constexpr uint32 CallCount = 1000000;
+} // namespace
+
+void InternedStringBench()
+{
+    std::vector<uint8> Memory(4 << 20);
+    Game::MemoryArena  Arena{ Memory.data(), Memory.size() };
+    Game::StringTable  Table{ Arena, 8192, 1 << 20 };
+    Game::SetStringTable(&Table);
+
+    std::vector<std::string>          Names;
+    std::vector<Game::InternedString> Interned;
+    for (uint32 Index = 0; Index < NameCount; ++Index)
+    {
+        Names.push_back("textures/level_" + std::to_string(Index / 64) + "/tile_" + std::to_string(Index));
+        Interned.push_back(Game::InternedString{ Names.back() });
+    }
+
+    uint64 Sum     = 0;
+    auto   Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Sum += Game::InternedString{ Names[Call % NameCount] }.size();
+        }
+    });
+    Bench::Report("intern a std::string (found)", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Sum += GAME_INTERN("textures/level_3/tile_200").size();
+        }
+    });
+    Bench::Report("GAME_INTERN", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Sum += Interned[Call % NameCount] == Interned[(Call * 7) % NameCount];
+        }
+    });
+    Bench::Report("equality, InternedString", Seconds, CallCount, "compare");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Sum += Names[Call % NameCount] == Names[(Call * 7) % NameCount];
+        }
+    });
+    Bench::Report("equality, std::string", Seconds, CallCount, "compare");
+
+    std::unordered_map<Game::InternedString, uint32> ByInterned;
+    std::unordered_map<std::string, uint32>          ByString;
+    for (uint32 Index = 0; Index < NameCount; ++Index)
+    {
+        ByInterned[Interned[Index]] = Index;
+        ByString[Names[Index]]      = Index;
+    }
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Sum += ByInterned.find(Interned[(Call * 7) % NameCount])->second;
+        }
+    });
+    Bench::Report("unordered_map lookup, InternedString", Seconds, CallCount, "lookup");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Sum += ByString.find(Names[(Call * 7) % NameCount])->second;
+        }
+    });
+    Bench::Report("unordered_map lookup, std::string", Seconds, CallCount, "lookup");
+    Bench::DoNotOptimize(Sum);
+    Game::SetStringTable(nullptr);
+}
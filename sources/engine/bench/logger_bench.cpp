@@ -0,0 +1,89 @@
+#include "bench.hpp"
+
+// Trace is compiled out of this file
+#define MIN_LOG_LEVEL 1
+#include <logger.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Cost of a log call on the calling thread: the binary logger (the budget is 50 ns), a level compiled out, and the
+// text built at the call with an ostringstream per argument or with snprintf. Then the
+// deferred formatting of the entries by Drain.
+
+namespace
+{
+    constexpr uint32 CallCount = 100000;
+
+    void Discard(void* Context, const char*, uint32 Size) { *static_cast<uint64*>(Context) += Size; }
+} // namespace
+
+void LoggerBench()
+{
+    std::vector<uint8> Memory(16 << 20);
+    Game::MemoryArena  Arena{ Memory.data(), Memory.size() };
+    Game::Logger       Log{ Arena, 1, 8 << 20 };
+    uint64             TextSize = 0;
+    auto               Drain    = [&] { Log.Drain({ &TextSize, &Discard }); };
+    real32             Value    = 0.25f;
+
+    auto Seconds = Bench::Measure(10, Drain, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            GAME_LOG(Log, Info, "frame {} took {} us", Call, 33333);
+        }
+    });
+    Bench::Report("binary, 2 integers", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, Drain, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            GAME_LOG(Log, Info, "entity {} at {} in {}", Call, Value, "level_01");
+        }
+    });
+    Bench::Report("binary, integer, float, string", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, Drain, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            GAME_LOG(Log, Trace, "frame {} took {} us", Call, 33333);
+        }
+    });
+    Bench::Report("binary, level compiled out", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            GAME_LOG(Log, Info, "entity {} at {} in {}", Call, Value, "level_01");
+        }
+    }, [&] { Drain(); });
+    Bench::Report("drain (format), integer, float, string", Seconds, CallCount, "entry");
+    Bench::DoNotOptimize(TextSize);
+
+    std::string Text;
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            for (auto Part : { std::string{ "entity " }, std::to_string(Call), std::string{ " at " },
+                               std::to_string(Value), std::string{ " in level_01\n" } })
+            {
+                std::ostringstream Stream{};
+                Stream << Part;
+                Text = Stream.str();
+            }
+        }
+    });
+    Bench::Report("ostringstream per argument", Seconds, CallCount, "call");
+
+    char Buffer[256];
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            snprintf(Buffer, sizeof(Buffer), "entity %u at %f in %s\n", Call, Value, "level_01");
+            Bench::DoNotOptimize(Buffer);
+        }
+    });
+    Bench::Report("snprintf", Seconds, CallCount, "call");
+    printf("%-48s %10llu dropped\n", "", static_cast<unsigned long long>(Log.GetDroppedCount()));
+}
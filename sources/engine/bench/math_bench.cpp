@@ -0,0 +1,126 @@
+#include "bench.hpp"
+
+#include <math.hpp>
+
+#include <vector>
+
+// Batches of 4096 values (in L1) and 1M values (out of the caches): an array of v3 structures walked with the value
+// functions, then the SoA batch functions for each SimdLevel.
+
+namespace
+{
+    struct Batch
+    {
+        explicit Batch(uint32 Count)
+            : Values(Count)
+            , X(Count)
+            , Y(Count)
+            , Z(Count)
+            , Results(Count)
+        {
+            uint32 Seed = 5;
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                real32 Coordinates[3];
+                for (auto& Coordinate : Coordinates)
+                {
+                    Seed       = Seed * 1664525u + 1013904223u;
+                    Coordinate = real32(Seed >> 8) / 16777216.0f - 0.5f;
+                }
+                Values[Index] = { Coordinates[0], Coordinates[1], Coordinates[2] };
+                X[Index]      = Coordinates[0];
+                Y[Index]      = Coordinates[1];
+                Z[Index]      = Coordinates[2];
+            }
+        }
+
+        Game::V3Soa Soa() { return { X.data(), Y.data(), Z.data() }; }
+
+        std::vector<Game::v3> Values;
+        std::vector<real32>   X, Y, Z;
+        std::vector<real32>   Results;
+    };
+
+    template <typename F>
+    void Run(const char* Name, uint32 Count, F&& Function)
+    {
+        auto Repeat  = Count < 100000 ? 1000 : 10;
+        auto Seconds = Bench::Measure(5, [&] {
+            for (int Index = 0; Index < Repeat; ++Index)
+            {
+                Function();
+            }
+        });
+        Bench::Report(Name, Seconds / Repeat, Count, "val");
+    }
+} // namespace
+
+void MathBench()
+{
+    auto Scaling   = Game::Scaling(Game::v3{ 2, 2, 2 });
+    auto Transform = Game::Translation(Game::v3{ 1, 2, 3 }) * Game::RotationY(0.4f) * Scaling;
+
+    Game::SimdLevel Levels[] = { Game::SimdLevel::Scalar, Game::SimdLevel::Sse2, Game::SimdLevel::Avx2,
+                                 Game::SimdLevel::Avx512 };
+
+    for (uint32 Count : { 4096u, 1u << 20 })
+    {
+        Batch Input{ Count };
+        Batch Output{ Count };
+        char  Name[64];
+
+        snprintf(Name, sizeof(Name), "%u transforms: aos values", Count);
+        Run(Name, Count, [&] {
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                Output.Values[Index] = Game::TransformPoint(Transform, Input.Values[Index]);
+            }
+            Bench::DoNotOptimize(Output.Values[Count / 2]);
+        });
+        for (auto Level : Levels)
+        {
+            if (Level > Game::GetBestSimdLevel())
+            {
+                continue;
+            }
+            snprintf(Name, sizeof(Name), "%u transforms: soa %s", Count, Game::GetSimdLevelName(Level));
+            Run(Name, Count, [&] { Game::TransformPoints(Transform, Input.Soa(), Output.Soa(), Count, Level); });
+        }
+
+        snprintf(Name, sizeof(Name), "%u normalizes: aos values", Count);
+        Run(Name, Count, [&] {
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                Output.Values[Index] = Game::Normalize(Input.Values[Index]);
+            }
+            Bench::DoNotOptimize(Output.Values[Count / 2]);
+        });
+        for (auto Level : Levels)
+        {
+            if (Level > Game::GetBestSimdLevel())
+            {
+                continue;
+            }
+            snprintf(Name, sizeof(Name), "%u normalizes: soa %s", Count, Game::GetSimdLevelName(Level));
+            Run(Name, Count, [&] { Game::Normalize(Input.Soa(), Output.Soa(), Count, Level); });
+        }
+
+        snprintf(Name, sizeof(Name), "%u dots: aos values", Count);
+        Run(Name, Count, [&] {
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                Output.Results[Index] = Game::Dot(Input.Values[Index], Output.Values[Index]);
+            }
+            Bench::DoNotOptimize(Output.Results[Count / 2]);
+        });
+        for (auto Level : Levels)
+        {
+            if (Level > Game::GetBestSimdLevel())
+            {
+                continue;
+            }
+            snprintf(Name, sizeof(Name), "%u dots: soa %s", Count, Game::GetSimdLevelName(Level));
+            Run(Name, Count, [&] { Game::Dot(Input.Soa(), Output.Soa(), Output.Results.data(), Count, Level); });
+        }
+    }
+}
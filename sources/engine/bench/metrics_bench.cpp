@@ -0,0 +1,105 @@
+#include "bench.hpp"
+
+#include <metrics.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Cost on the hot path: a counter, a gauge and a histogram (one relaxed atomic operation each), against a counter
+// behind a mutex. Then the same counter shared by 4 threads, and the cost of a record of 64 metrics in a series.
+
+namespace
+{
+    constexpr uint32 CallCount = 1000000;
+} // namespace
+
+void MetricsBench()
+{
+    std::vector<uint8>   Memory(1 << 20);
+    Game::MemoryArena    Arena{ Memory.data(), Memory.size() };
+    Game::MetricRegistry Registry{ Arena, 64, 16 * Game::Metering::BucketCount + 48 };
+    auto                 Counter   = Registry.AddCounter("calls");
+    auto                 Gauge     = Registry.AddGauge("level");
+    auto                 Histogram = Registry.AddHistogram("latency");
+
+    auto Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Counter->Add();
+        }
+    });
+    Bench::Report("counter", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Gauge->Set(Call);
+        }
+    });
+    Bench::Report("gauge", Seconds, CallCount, "call");
+
+    Seconds = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            Histogram->Record(Call & 0xFFFF);
+        }
+    });
+    Bench::Report("histogram", Seconds, CallCount, "call");
+
+    std::mutex Mutex;
+    uint64     Locked = 0;
+    Seconds           = Bench::Measure(10, [&] {
+        for (uint32 Call = 0; Call < CallCount; ++Call)
+        {
+            std::lock_guard<std::mutex> Lock{ Mutex };
+            ++Locked;
+        }
+    });
+    Bench::Report("counter behind a mutex", Seconds, CallCount, "call");
+    Bench::DoNotOptimize(Locked);
+
+    Seconds = Bench::Measure(5, [&] {
+        std::vector<std::thread> Threads;
+        for (uint32 Thread = 0; Thread < 4; ++Thread)
+        {
+            Threads.emplace_back([Counter] {
+                for (uint32 Call = 0; Call < CallCount; ++Call)
+                {
+                    Counter->Add();
+                }
+            });
+        }
+        for (auto& Thread : Threads)
+        {
+            Thread.join();
+        }
+    });
+    Bench::Report("counter, 4 threads", Seconds, 4.0 * CallCount, "call");
+
+    // 16 histograms and 48 counters, 560 values per record
+    char Name[16];
+    for (uint32 Index = 1; Index < 16; ++Index)
+    {
+        snprintf(Name, sizeof(Name), "histogram_%u", Index);
+        Registry.AddHistogram(Name);
+    }
+    for (uint32 Index = 1; Index < 48; ++Index)
+    {
+        snprintf(Name, sizeof(Name), "counter_%u", Index);
+        Registry.AddCounter(Name);
+    }
+    constexpr uint32    RecordCount = 1000;
+    std::vector<uint64> File((1 + Registry.GetMaxValueCount()) * (RecordCount + 2) + 1024);
+    auto                Clear = [&] { std::fill(File.begin(), File.end(), 0); };
+    Seconds = Bench::Measure(5, Clear, [&] {
+        Game::MetricSeries Series{ Registry, File.data(), File.size() * sizeof(uint64) };
+        for (uint32 Record = 0; Record < RecordCount; ++Record)
+        {
+            Series.Append();
+        }
+    });
+    printf("%-48s %10u metrics\n", "", Registry.GetCount());
+    Bench::Report("series, records", Seconds, RecordCount, "record");
+}
@@ -0,0 +1,93 @@
+#include "bench.hpp"
+
+#include <packed_inputs.hpp>
+
+#include <cmath>
+#include <vector>
+
+// A minute of play at 60 Hz: two pads and the keyboard, a button changes every second or so, the sticks of the first
+// pad move half of the time. Pack, Unpack, EncodeDelta and DecodeDelta per frame (the budget is 100 ns each), then
+// the size of the recorded stream.
+
+namespace
+{
+    constexpr uint32 FrameCount = 60 * 60;
+
+    std::vector<Game::Inputs> Record()
+    {
+        std::vector<Game::Inputs> Frames(FrameCount);
+        Game::Inputs              Value = {};
+        uint32                    Seed  = 1;
+        for (auto& Frame : Frames)
+        {
+            for (auto* Pad : { &Value.GamePads[0], &Value.GamePads[1], &Value.Keyboard })
+            {
+                Pad->IsConnected = true;
+                for (auto& Button : Pad->Buttons)
+                {
+                    Seed                       = Seed * 1664525u + 1013904223u;
+                    Button.HalfTransitionCount = (Seed >> 8) % 1000 < 2;
+                    Button.EndedDown ^= Button.HalfTransitionCount;
+                }
+            }
+            auto& Pad = Value.GamePads[0];
+            if ((Seed >> 4) % 2)
+            {
+                Pad.LeftStickX = std::sin(real32(&Frame - Frames.data()) * 0.05f);
+                Pad.LeftStickY = std::cos(real32(&Frame - Frames.data()) * 0.03f);
+            }
+            Frame = Value;
+        }
+        return Frames;
+    }
+} // namespace
+
+void PackedInputsBench()
+{
+    auto                            Frames = Record();
+    std::vector<Game::PackedInputs> Packed(FrameCount);
+    std::vector<uint8>              Stream(FrameCount * Game::InputPacking::MaxDeltaSize);
+    uint32                          StreamSize = 0;
+
+    auto Seconds = Bench::Measure(20, [&] {
+        for (uint32 Frame = 0; Frame < FrameCount; ++Frame)
+        {
+            Packed[Frame] = Game::InputPacking::Pack(Frames[Frame]);
+        }
+    });
+    Bench::Report("pack", Seconds, FrameCount, "frame");
+
+    std::vector<Game::Inputs> Unpacked(FrameCount);
+    Seconds = Bench::Measure(20, [&] {
+        for (uint32 Frame = 0; Frame < FrameCount; ++Frame)
+        {
+            Game::InputPacking::Unpack(Packed[Frame], Unpacked[Frame]);
+        }
+    });
+    Bench::Report("unpack", Seconds, FrameCount, "frame");
+
+    Seconds = Bench::Measure(20, [&] {
+        Game::PackedInputs Previous;
+        StreamSize = 0;
+        for (uint32 Frame = 0; Frame < FrameCount; ++Frame)
+        {
+            StreamSize += Game::InputPacking::EncodeDelta(Previous, Packed[Frame], Stream.data() + StreamSize);
+            Previous = Packed[Frame];
+        }
+    });
+    Bench::Report("encode delta", Seconds, FrameCount, "frame");
+
+    Seconds = Bench::Measure(20, [&] {
+        Game::PackedInputs Previous;
+        uint32             Offset = 0;
+        for (uint32 Frame = 0; Frame < FrameCount; ++Frame)
+        {
+            Offset += Game::InputPacking::DecodeDelta(Previous, Stream.data() + Offset, StreamSize - Offset, Previous);
+        }
+        Bench::DoNotOptimize(Previous);
+    });
+    Bench::Report("decode delta", Seconds, FrameCount, "frame");
+
+    printf("%-48s %10u bytes, %.2f bytes/frame (Inputs: %u, PackedInputs: %u)\n", "stream of a minute", StreamSize,
+           double(StreamSize) / FrameCount, uint32(sizeof(Game::Inputs)), uint32(sizeof(Game::PackedInputs)));
+}
@@ -0,0 +1,79 @@
+#include "bench.hpp"
+
+#include <particles.hpp>
+
+#include <vector>
+
+// 1M particles over a 1920x1080 buffer, a frame of 1/60 second: Update with about 1% of deaths, refilled before each
+// run, then Draw. Every kernel on one thread, the best one on all of them; the budget is 2 ms for the whole frame.
+
+namespace
+{
+    constexpr uint32 ParticleCount = 1 << 20;
+    constexpr int32  Width         = 1920;
+    constexpr int32  Height        = 1080;
+    constexpr real32 Dt            = 1.0f / 60;
+
+    void Refill(Game::ParticleSystem& System, uint32& Seed)
+    {
+        while (System.GetCount() < ParticleCount)
+        {
+            Game::Particle Value;
+            Seed           = Seed * 1664525u + 1013904223u;
+            Value.Position = { real32(Seed % Width), real32((Seed >> 11) % Height) };
+            Value.Velocity = { real32(Seed % 100) - 50.0f, real32((Seed >> 7) % 100) - 80.0f };
+            Value.Life     = real32((Seed >> 3) % 100000) / 100000.0f * 1.6f + Dt; // about 1% die each frame
+            Value.Color    = 0x040302 << (Seed % 3);
+            System.Spawn(Value);
+        }
+    }
+} // namespace
+
+void ParticlesBench()
+{
+    std::vector<uint8>   Memory(128 << 20);
+    Game::MemoryArena    Arena{ Memory.data(), 64 << 20 };
+    Game::MemoryArena    Scratch{ Memory.data() + (64 << 20), 64 << 20 };
+    Game::ParticleSystem System{ Arena, ParticleCount };
+    std::vector<uint32>  Pixels(Width * Height);
+    PIBackBuffer         Buffer = { Pixels.data(), Width, Height, 4, Width * 4 };
+    uint32               Seed   = 3;
+
+    Game::ThreadPoolJobSystem Jobs;
+    Game::SimdLevel           Levels[] = { Game::SimdLevel::Scalar, Game::SimdLevel::Sse2, Game::SimdLevel::Avx2,
+                                           Game::SimdLevel::Avx512 };
+    char                      Name[96];
+
+    for (auto Level : Levels)
+    {
+        if (Level > Game::GetBestSimdLevel())
+        {
+            continue;
+        }
+        auto Seconds = Bench::Measure(10, [&] { Refill(System, Seed); }, [&] {
+            System.Update(Dt, { 0, 100 }, Scratch, nullptr, Level);
+        });
+        snprintf(Name, sizeof(Name), "update, %s, 1 thread", Game::GetSimdLevelName(Level));
+        Bench::Report(Name, Seconds, ParticleCount, "part");
+    }
+    for (auto Level : Levels)
+    {
+        if (Level > Game::GetBestSimdLevel())
+        {
+            continue;
+        }
+        Refill(System, Seed);
+        auto Seconds = Bench::Measure(10, [&] { System.Draw(Buffer, Scratch, nullptr, Level); });
+        snprintf(Name, sizeof(Name), "draw, %s, 1 thread", Game::GetSimdLevelName(Level));
+        Bench::Report(Name, Seconds, ParticleCount, "part");
+    }
+
+    auto Best    = Game::GetBestSimdLevel();
+    auto Seconds = Bench::Measure(10, [&] { Refill(System, Seed); }, [&] {
+        System.Update(Dt, { 0, 100 }, Scratch, &Jobs, Best);
+        System.Draw(Buffer, Scratch, &Jobs, Best);
+    });
+    snprintf(Name, sizeof(Name), "update + draw, %s, %u threads", Game::GetSimdLevelName(Best), Jobs.GetThreadCount());
+    Bench::Report(Name, Seconds, ParticleCount, "part");
+    Bench::DoNotOptimize(Pixels[Width * Height / 2]);
+}
@@ -0,0 +1,106 @@
+#include "bench.hpp"
+
+#include <pathfinding.hpp>
+
+#include <vector>
+
+// 1024x1024 grids with walls of 2 to 32 cells over about 15% of the cells, 256 queries between random walkable
+// cells: JPS and A* on the uniform grid, A* on the same grid with costs from 1 to 4. One thread, then a batch on all
+// of them.
+
+namespace
+{
+    constexpr int32  Size       = 1024;
+    constexpr uint32 QueryCount = 256;
+    constexpr uint32 MaxLength  = 1024;
+
+    uint32 Random(uint32& Seed)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        return Seed >> 8;
+    }
+
+    void Fill(Game::NavGrid& Grid, uint32 MaxCost)
+    {
+        uint32 Seed = 5;
+        for (int32 Y = 0; Y < Size; ++Y)
+        {
+            for (int32 X = 0; X < Size; ++X)
+            {
+                Grid.SetCost(X, Y, uint8(1 + Random(Seed) % MaxCost));
+            }
+        }
+        for (int32 Wall = 0; Wall < Size * Size / 110; ++Wall)
+        {
+            auto X      = int32(Random(Seed) % Size);
+            auto Y      = int32(Random(Seed) % Size);
+            auto Length = int32(2 + Random(Seed) % 31);
+            auto IsWide = Random(Seed) % 2 == 0;
+            for (int32 Index = 0; Index < Length; ++Index)
+            {
+                Grid.SetCost(IsWide ? X + Index : X, IsWide ? Y : Y + Index, 0);
+            }
+        }
+    }
+
+    std::vector<Game::PathQuery> MakeQueries(const Game::NavGrid& Grid)
+    {
+        std::vector<Game::PathQuery> Queries;
+        uint32                       Seed = 7;
+        while (Queries.size() < QueryCount)
+        {
+            Game::GridPoint Start = { int32(Random(Seed) % Size), int32(Random(Seed) % Size) };
+            Game::GridPoint Goal  = { int32(Random(Seed) % Size), int32(Random(Seed) % Size) };
+            if (Grid.IsWalkable(Start.X, Start.Y) && Grid.IsWalkable(Goal.X, Goal.Y))
+            {
+                Queries.push_back({ Start, Goal });
+            }
+        }
+        return Queries;
+    }
+} // namespace
+
+void PathfindingBench()
+{
+    Game::ThreadPoolJobSystem     Jobs;
+    auto                          FinderSize = uint64(Size + 2) * (Size + 2) * 32 + (1 << 20);
+    std::vector<uint8>            Memory((Jobs.GetThreadCount() + 2) * FinderSize + (8 << 20));
+    Game::MemoryArena             Arena{ Memory.data(), Memory.size() };
+    std::vector<Game::PathResult> Results(QueryCount);
+    std::vector<Game::GridPoint>  Paths(QueryCount * MaxLength);
+    char                          Name[96];
+
+    struct Case
+    {
+        const char*      Name;
+        uint32           MaxCost;
+        Game::PathMethod Method;
+    };
+    Case Cases[] = { { "JPS, uniform", 1, Game::PathMethod::JumpPoint },
+                     { "A*, uniform", 1, Game::PathMethod::AStar },
+                     { "A*, weighted", 4, Game::PathMethod::AStar } };
+    for (auto& Test : Cases)
+    {
+        Game::TemporaryMemory Temporary{ Arena };
+        Game::NavGrid         Grid{ Arena, Size, Size };
+        Fill(Grid, Test.MaxCost);
+        auto Queries = MakeQueries(Grid);
+
+        for (auto Parallel : { static_cast<Game::JobSystem*>(nullptr), static_cast<Game::JobSystem*>(&Jobs) })
+        {
+            auto Seconds = Bench::Measure(3, [&] {
+                Game::FindPaths(Grid, Queries.data(), Results.data(), QueryCount, Paths.data(), MaxLength, Arena,
+                                Parallel, Test.Method);
+            });
+            uint64 Expanded = 0;
+            for (auto& Result : Results)
+            {
+                Expanded += Result.ExpandedCount;
+            }
+            // about a thousand queries per second: reported per expanded node, the queries in the name
+            auto Threads = Parallel ? Parallel->GetThreadCount() : 1;
+            snprintf(Name, sizeof(Name), "%s, %.0f queries/s, %u threads", Test.Name, QueryCount / Seconds, Threads);
+            Bench::Report(Name, Seconds, real32(Expanded), "node");
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#include "bench.hpp"
+
+#include <pixel_format.hpp>
+
+#include <cstring>
+#include <vector>
+
+// Throughput of the conversions of a 1280x720 image, per format pair and SIMD level, against a plain copy of the
+// frame: the shuffles between 32-bit formats, the alpha changes, 565, gray and the sRGB tables.
+
+namespace
+{
+    struct FormatPair
+    {
+        Game::PixelFormat From;
+        Game::PixelFormat To;
+    };
+} // namespace
+
+void PixelFormatBench()
+{
+    using Game::PixelFormat;
+    constexpr int32     Width  = 1280;
+    constexpr int32     Height = 720;
+    constexpr double    Count  = double(Width) * Height;
+    std::vector<uint32> Source(size_t(Width) * Height * 2);
+    std::vector<uint32> Destination(size_t(Width) * Height * 2);
+    uint32              Seed = 1;
+    for (auto& Pixel : Source)
+    {
+        Seed  = Seed * 1664525u + 1013904223u;
+        Pixel = Seed;
+    }
+
+    auto Seconds = Bench::Measure(20, [&] { memcpy(Destination.data(), Source.data(), size_t(Width) * Height * 4); });
+    Bench::Report("memcpy, 32-bit", Seconds, Count, "pixel");
+
+    FormatPair Pairs[] = {
+        { PixelFormat::Bgrx8, PixelFormat::Rgba8 },
+        { PixelFormat::Rgba8, PixelFormat::Bgrx8 },
+        { PixelFormat::Argb8, PixelFormat::Rgba8 },
+        { PixelFormat::Bgra8, PixelFormat::Bgra8Premultiplied },
+        { PixelFormat::Bgra8Premultiplied, PixelFormat::Bgra8 },
+        { PixelFormat::Rgba8, PixelFormat::Bgra8Premultiplied },
+        { PixelFormat::Bgrx8, PixelFormat::Rgb565 },
+        { PixelFormat::Rgb565, PixelFormat::Bgrx8 },
+        { PixelFormat::Bgrx8, PixelFormat::Gray8 },
+        { PixelFormat::Gray8, PixelFormat::Bgrx8 },
+        { PixelFormat::Bgra8, PixelFormat::Bgra16Linear },
+        { PixelFormat::Bgra16Linear, PixelFormat::Bgrx8 },
+    };
+    for (auto& Pair : Pairs)
+    {
+        Game::PixelView From = { Source.data(), Width, Height, Width * Game::GetBytesPerPixel(Pair.From), Pair.From };
+        Game::PixelView To   = { Destination.data(), Width, Height, Width * Game::GetBytesPerPixel(Pair.To), Pair.To };
+        for (auto Level : { Game::SimdLevel::Scalar, Game::SimdLevel::Sse2, Game::GetBestSimdLevel() })
+        {
+            Seconds = Bench::Measure(10, [&] { Game::ConvertPixels(From, To, Level); });
+            char Name[64];
+            snprintf(Name, sizeof(Name), "%s to %s, %s", Game::GetPixelFormatName(Pair.From),
+                     Game::GetPixelFormatName(Pair.To), Game::GetSimdLevelName(Level));
+            Bench::Report(Name, Seconds, Count, "pixel");
+        }
+    }
+    Bench::DoNotOptimize(Destination);
+}
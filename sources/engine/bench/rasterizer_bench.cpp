@@ -0,0 +1,113 @@
+#include "bench.hpp"
+
+#include <rasterizer.hpp>
+
+#include <vector>
+
+// A 1280x720 target with a depth buffer: 100000 small triangles (about 50 pixels each) for the setup and binning
+// cost, then 200 large ones (about 40000 pixels each) for the fill rate. Every kernel on one thread, the best one on
+// all of them.
+
+namespace
+{
+    constexpr int32  Width       = 1280;
+    constexpr int32  Height      = 720;
+    constexpr uint32 SmallCount  = 100000;
+    constexpr uint32 LargeCount  = 200;
+    constexpr real32 SmallExtent = 10.0f;
+    constexpr real32 LargeExtent = 280.0f;
+
+    using VertexArray = std::vector<Game::RasterVertex>;
+
+    VertexArray MakeTriangles(uint32 Count, real32 Extent)
+    {
+        VertexArray Vertices(Count * 3);
+        uint32      Seed = 29;
+        auto        Next = [&Seed](real32 Range) {
+            Seed = Seed * 1664525u + 1013904223u;
+            return real32((Seed >> 8) & 0xFFFF) / 65535.0f * Range;
+        };
+        for (uint32 Index = 0; Index < Count; ++Index)
+        {
+            auto X = Next(Width - Extent);
+            auto Y = Next(Height - Extent);
+            auto Z = Next(1.0f);
+            // right triangles of half the extent squared, alternating diagonals
+            real32 Corners[3][2] = { { 0, 0 }, { Extent, 0 }, { Index % 2 ? Extent : 0, Extent } };
+            for (int Corner = 0; Corner < 3; ++Corner)
+            {
+                auto W                       = 1.0f + Next(1.0f);
+                auto R                       = Next(1.0f);
+                auto G                       = Next(1.0f);
+                auto B                       = Next(1.0f);
+                Vertices[Index * 3 + Corner] = { X + Corners[Corner][0], Y + Corners[Corner][1], Z, W, R, G, B, 1.0f,
+                                                 Next(4.0f), Next(4.0f) };
+            }
+        }
+        return Vertices;
+    }
+} // namespace
+
+void RasterizerBench()
+{
+    std::vector<uint32> Texels(64 * 64);
+    for (uint32 Index = 0; Index < Texels.size(); ++Index)
+    {
+        Texels[Index] = 0xFF000000 | (Index * 2654435761u >> 8);
+    }
+    Game::Bitmap Texture = { Texels.data(), 64, 64, 64 * 4, Game::BitmapAlpha::Opaque };
+
+    std::vector<uint32>       Pixels(Width * Height);
+    std::vector<real32>       Depth(Width * Height);
+    Game::RasterTarget        Target = { { Pixels.data(), Width, Height, 4, Width * 4 }, Depth.data() };
+    std::vector<uint8>        Memory(64 << 20);
+    Game::MemoryArena         Arena{ Memory.data(), Memory.size() };
+    Game::ThreadPoolJobSystem Jobs;
+
+    auto Small = MakeTriangles(SmallCount, SmallExtent);
+    auto Large = MakeTriangles(LargeCount, LargeExtent);
+
+    auto ClearDepth = [&] {
+        for (auto& Value : Depth)
+        {
+            Value = 1.0f;
+        }
+    };
+    uint64 Written = 0;
+    auto   Run     = [&](const VertexArray& Vertices, Game::JobSystem* Jobs, Game::SimdLevel Level) {
+        return Bench::Measure(5, ClearDepth, [&] {
+            Game::TemporaryMemory Frame{ Arena };
+            auto                  Count = static_cast<uint32>(Vertices.size() / 3);
+            Game::Rasterizer      Rasterizer{ Arena, Count, Width, Height };
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                auto V = &Vertices[Index * 3];
+                Rasterizer.PushTriangle(V[0], V[1], V[2], Index % 2 ? &Texture : nullptr);
+            }
+            Rasterizer.Execute(Target, Arena, Jobs, Level);
+            Written = Rasterizer.GetWrittenPixelCount();
+        });
+    };
+
+    auto Features = Game::GetCpuFeatures();
+    for (auto Level : { Game::SimdLevel::Scalar, Game::SimdLevel::Sse2, Game::SimdLevel::Avx2 })
+    {
+        if (Level == Game::SimdLevel::Avx2 && !Features.Avx2)
+        {
+            continue;
+        }
+        char Name[64];
+        snprintf(Name, sizeof(Name), "small triangles: %s, 1 thread", Game::GetSimdLevelName(Level));
+        Bench::Report(Name, Run(Small, nullptr, Level), SmallCount, "tri");
+        auto Seconds = Run(Large, nullptr, Level);
+        snprintf(Name, sizeof(Name), "large triangles: %s, 1 thread", Game::GetSimdLevelName(Level));
+        Bench::Report(Name, Seconds, double(Written), "pix");
+    }
+    char Name[64];
+    snprintf(Name, sizeof(Name), "small triangles: best, %u threads", Jobs.GetThreadCount());
+    Bench::Report(Name, Run(Small, &Jobs, Game::GetBestSimdLevel()), SmallCount, "tri");
+    auto Seconds = Run(Large, &Jobs, Game::GetBestSimdLevel());
+    snprintf(Name, sizeof(Name), "large triangles: best, %u threads", Jobs.GetThreadCount());
+    Bench::Report(Name, Seconds, double(Written), "pix");
+    Bench::DoNotOptimize(Pixels[Width * Height / 2]);
+}
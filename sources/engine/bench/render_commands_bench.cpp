@@ -0,0 +1,113 @@
+#include "bench.hpp"
+
+#include <render_commands.hpp>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// A 1280x720 frame of 20000 commands (32x32 blended sprites and translucent rectangles, 16 sort keys, 10% out of the
+// screen): drawn immediately after a std::stable_sort, or through the command buffer on one thread and on all of them.
+
+namespace
+{
+    constexpr int32  Width        = 1280;
+    constexpr int32  Height       = 720;
+    constexpr uint32 CommandCount = 20000;
+
+    struct Draw
+    {
+        uint32 Key;
+        int32  X;
+        int32  Y;
+        bool   IsBitmap;
+    };
+} // namespace
+
+void RenderCommandsBench()
+{
+    std::vector<uint32> Sprite(32 * 32);
+    for (uint32 Index = 0; Index < Sprite.size(); ++Index)
+    {
+        auto A        = (Index * 13) % 256;
+        Sprite[Index] = (A << 24) | ((A / 2) << 16) | ((A / 4) << 8);
+    }
+    Game::Bitmap Bitmap = { Sprite.data(), 32, 32, 32 * 4, Game::BitmapAlpha::Blend };
+
+    std::vector<Draw> Draws(CommandCount);
+    uint32            Seed = 13;
+    for (auto& Draw : Draws)
+    {
+        Seed          = Seed * 1664525u + 1013904223u;
+        Draw.X        = int32((Seed >> 8) % (Width + 140)) - 70;
+        Seed          = Seed * 1664525u + 1013904223u;
+        Draw.Y        = int32((Seed >> 8) % (Height + 80)) - 40;
+        Draw.Key      = (Seed >> 4) % 16;
+        Draw.IsBitmap = (Seed >> 28) & 1;
+    }
+
+    std::vector<uint32> Pixels(Width * Height);
+    PIBackBuffer        Buffer = { Pixels.data(), Width, Height, 4, Width * 4 };
+    std::vector<uint8>  Memory(64 << 20);
+    Game::MemoryArena   Arena{ Memory.data(), Memory.size() };
+
+    auto Immediate = Bench::Measure(10, [&] {
+        auto Sorted = Draws;
+        std::stable_sort(Sorted.begin(), Sorted.end(), [](const Draw& A, const Draw& B) { return A.Key < B.Key; });
+        for (auto& Draw : Sorted)
+        {
+            if (Draw.IsBitmap)
+            {
+                Game::DrawBitmap(Buffer, Bitmap, Draw.X, Draw.Y);
+            }
+            else
+            {
+                Game::BlitRect Rectangle = { Draw.X, Draw.Y, Draw.X + 40, Draw.Y + 24 };
+                Game::DrawRectangle(Buffer, Rectangle, 0x80204060, Game::GetBufferRect(Buffer));
+            }
+        }
+    });
+
+    auto RunCommands = [&](Game::JobSystem* Jobs) {
+        Game::TemporaryMemory     Frame{ Arena };
+        Game::RenderCommandBuffer Commands{ Arena, CommandCount, Width, Height };
+        for (auto& Draw : Draws)
+        {
+            if (Draw.IsBitmap)
+            {
+                Commands.PushBitmap(Draw.Key, Bitmap, Draw.X, Draw.Y);
+            }
+            else
+            {
+                Commands.PushRectangle(Draw.Key, { Draw.X, Draw.Y, Draw.X + 40, Draw.Y + 24 }, 0x80204060);
+            }
+        }
+        Commands.Execute(Buffer, Arena, Jobs);
+    };
+    auto OneThread = Bench::Measure(10, [&] { RunCommands(nullptr); });
+
+    Game::ThreadPoolJobSystem Jobs;
+    auto                      AllThreads = Bench::Measure(10, [&] { RunCommands(&Jobs); });
+
+    std::vector<Game::RenderSortEntry> Entries(CommandCount);
+    std::vector<Game::RenderSortEntry> Temporary(CommandCount);
+    auto                               Fill = [&] {
+        for (uint32 Index = 0; Index < CommandCount; ++Index)
+        {
+            Entries[Index] = { Draws[Index].Key, Index };
+        }
+    };
+    auto Radix  = Bench::Measure(20, Fill, [&] { Game::RadixSort(Entries.data(), Temporary.data(), CommandCount); });
+    auto Stable = Bench::Measure(20, Fill, [&] {
+        std::stable_sort(Entries.begin(), Entries.end(), [](auto& A, auto& B) { return A.Key < B.Key; });
+    });
+
+    Bench::Report("immediate: stable_sort + draw", Immediate, CommandCount, "cmd");
+    Bench::Report("command buffer: 1 thread", OneThread, CommandCount, "cmd");
+    char Name[64];
+    snprintf(Name, sizeof(Name), "command buffer: %u threads", Jobs.GetThreadCount());
+    Bench::Report(Name, AllThreads, CommandCount, "cmd");
+    Bench::Report("sort keys: radix", Radix, CommandCount, "cmd");
+    Bench::Report("sort keys: std::stable_sort", Stable, CommandCount, "cmd");
+    Bench::DoNotOptimize(Pixels[Width * Height / 2]);
+}
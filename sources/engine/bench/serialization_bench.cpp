@@ -0,0 +1,125 @@
+#include "bench.hpp"
+
+#include <format.hpp>
+#include <serialization.hpp>
+
+#include "../../wit/quantity.hpp"
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Load time of 100k units (position, life, team, name): the flat block read in place (header and bounds checks, then
+// a pass over the units), against the same data as text lines parsed with strtol/strtof, and with an istringstream.
+// The text loads build the units in memory; the flat one uses them where they lie.
+
+namespace
+{
+    constexpr uint32 UnitCount = 100000;
+
+    struct Unit
+    {
+        wit::Meter         X;
+        wit::Meter         Y;
+        int32              Life;
+        uint32             Team;
+        Game::SerialString Name;
+
+        static constexpr auto GetSerialFields()
+        {
+            return std::make_tuple(GAME_SERIAL_FIELD(Unit, X), GAME_SERIAL_FIELD(Unit, Y),
+                                   GAME_SERIAL_FIELD(Unit, Life), GAME_SERIAL_FIELD(Unit, Team),
+                                   GAME_SERIAL_FIELD(Unit, Name));
+        }
+    };
+
+    struct Save
+    {
+        uint32                  Seed;
+        Game::SerialArray<Unit> Units;
+
+        static constexpr auto GetSerialFields()
+        {
+            return std::make_tuple(GAME_SERIAL_FIELD(Save, Seed), GAME_SERIAL_FIELD(Save, Units));
+        }
+    };
+
+    // what the text loads build
+    struct LoadedUnit
+    {
+        real32      X;
+        real32      Y;
+        int32       Life;
+        uint32      Team;
+        std::string Name;
+    };
+} // namespace
+
+void SerializationBench()
+{
+    std::vector<uint8> Memory(32 << 20);
+    Game::MemoryArena  Arena{ Memory.data(), Memory.size() };
+    Game::SerialWriter Writer{ Arena, 16 << 20 };
+    std::string        Text;
+    char               Line[128];
+    char               NameText[32];
+
+    auto Root  = Writer.PushRoot<Save>();
+    Root->Seed = 42;
+    auto Units = Writer.PushArray(Root->Units, UnitCount);
+    for (uint32 Index = 0; Index < UnitCount; ++Index)
+    {
+        auto& Unit = Units[Index];
+        Unit.X     = wit::Meter{ real32(Index % 1000) * 0.25f };
+        Unit.Y     = wit::Meter{ real32(Index / 1000) * -0.5f };
+        Unit.Life  = int32(Index % 97);
+        Unit.Team  = Index % 4;
+        auto Name  = Game::Format(NameText, GAME_FORMAT_STRING("unit_{}"), Index);
+        Writer.PushString(Unit.Name, Name);
+        Text += Game::Format(Line, GAME_FORMAT_STRING("{} {} {} {} {}\n"), Unit.X.value_, Unit.Y.value_, Unit.Life,
+                             Unit.Team, Name);
+    }
+    auto Size = Writer.Finish<Save>();
+    printf("%-48s %10.2f MB flat, %.2f MB text\n", "", double(Size) / (1 << 20), double(Text.size()) / (1 << 20));
+
+    real64 Sum     = 0;
+    auto   Seconds = Bench::Measure(10, [&] {
+        auto Loaded = Game::ReadSerial<Save>(Writer.GetData(), Size);
+        for (auto& Unit : Loaded->Units)
+        {
+            Sum += Unit.X.value_ + Unit.Life + Unit.Name.GetView().size();
+        }
+    });
+    Bench::Report("flat, read in place (verified)", Seconds, UnitCount, "unit");
+
+    std::vector<LoadedUnit> Loaded(UnitCount);
+    Seconds = Bench::Measure(10, [&] {
+        auto Cursor = Text.c_str();
+        for (auto& Unit : Loaded)
+        {
+            char* End;
+            Unit.X    = strtof(Cursor, &End);
+            Unit.Y    = strtof(End, &End);
+            Unit.Life = int32(strtol(End, &End, 10));
+            Unit.Team = uint32(strtoul(End, &End, 10));
+            auto Name = End + 1;
+            auto Next = strchr(Name, '\n');
+            Unit.Name.assign(Name, Next);
+            Cursor = Next + 1;
+            Sum += Unit.X + Unit.Life + Unit.Name.size();
+        }
+    });
+    Bench::Report("text, strtof/strtol", Seconds, UnitCount, "unit");
+
+    Seconds = Bench::Measure(3, [&] {
+        std::istringstream Stream{ Text };
+        for (auto& Unit : Loaded)
+        {
+            Stream >> Unit.X >> Unit.Y >> Unit.Life >> Unit.Team >> Unit.Name;
+            Sum += Unit.X + Unit.Life + Unit.Name.size();
+        }
+    });
+    Bench::Report("text, istringstream", Seconds, UnitCount, "unit");
+    Bench::DoNotOptimize(Sum);
+}
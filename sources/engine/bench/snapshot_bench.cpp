@@ -0,0 +1,166 @@
+#include "bench.hpp"
+
+#include <snapshot.hpp>
+
+#if !_WIN32
+#include "../linux/write_fault_page_tracker.hpp"
+#include <sys/mman.h>
+#endif
+
+#include <vector>
+
+// Snapshots of a 64MB permanent storage: a quarter of it holds game state (entities of floats and small integers),
+// the rest is still zero. Each frame writes 1% or 10% of the pages, then captures. Against a full copy of the block:
+// the time spent on the game thread (the writes, which fault once per page with the write fault tracker, tracking and
+// staging), the background compression and the size of a delta.
+
+namespace
+{
+    constexpr uint64 StorageSize = 64 * 1024 * 1024;
+    constexpr uint64 PageCount   = StorageSize / Game::PageTracker::PageSize;
+    constexpr uint32 FrameCount  = 10;
+
+    struct Entity
+    {
+        real32 Position[3];
+        real32 Velocity[3];
+        uint32 Flags;
+        uint16 Health;
+        uint16 Type;
+    };
+
+    uint32 Random(uint32& Seed)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        return Seed >> 8;
+    }
+
+    void Fill(uint8* Storage)
+    {
+        auto   Entities = reinterpret_cast<Entity*>(Storage);
+        uint32 Seed     = 1;
+        for (uint64 Index = 0; Index < StorageSize / 4 / sizeof(Entity); ++Index)
+        {
+            Entities[Index] = { { real32(Random(Seed) % 4096), 0.0f, real32(Random(Seed) % 4096) },
+                                { 0.0f, 0.0f, 0.0f },
+                                Random(Seed) % 4,
+                                100,
+                                uint16(Random(Seed) % 16) };
+        }
+    }
+
+    // moves the entities of the written pages, in runs of 8 pages
+    void Step(uint8* Storage, uint64 DirtyPageCount, uint32& Seed)
+    {
+        for (uint64 Run = 0; Run < DirtyPageCount / 8; ++Run)
+        {
+            auto First    = Random(Seed) % (PageCount / 4 - 8);
+            auto Entities = reinterpret_cast<Entity*>(Storage + First * Game::PageTracker::PageSize);
+            for (uint64 Index = 0; Index < 8 * Game::PageTracker::PageSize / sizeof(Entity); ++Index)
+            {
+                Entities[Index].Position[0] += 0.25f;
+                Entities[Index].Velocity[0] = 0.25f;
+            }
+        }
+    }
+
+    struct Stream
+    {
+        std::vector<uint8> Data;
+        uint64             Size = 0;
+
+        static bool Write(void* Context, const void* Data, uint64 Size)
+        {
+            auto Self = static_cast<Stream*>(Context);
+            if (Self->Size + Size > Self->Data.size())
+            {
+                return false;
+            }
+            memcpy(Self->Data.data() + Self->Size, Data, Size);
+            Self->Size += Size;
+            return true;
+        }
+    };
+
+    // the tracker is made while the block is zero, like at startup
+    template <typename T>
+    void Run(const char* Name, uint8* Storage, Game::MemoryArena& Arena)
+    {
+        for (uint64 Percent : { 1, 10 })
+        {
+            memset(Storage, 0, StorageSize);
+            Game::TemporaryMemory Scratch{ Arena };
+            T                     Tracker{ Arena, Storage, StorageSize };
+            Fill(Storage);
+
+            Stream Output;
+            Output.Data.resize(StorageSize + StorageSize / 8);
+            Game::SnapshotWriter  Writer{ Arena, Storage, StorageSize, Tracker, { &Output, &Stream::Write } };
+            Writer.Capture();
+            Writer.Wait();
+            auto BaseSize = Output.Size;
+
+            uint32 Seed      = 7;
+            double Stepping  = 0;
+            double Capturing = 0;
+            double Writing   = 0;
+            for (uint32 Frame = 0; Frame < FrameCount; ++Frame)
+            {
+                auto Stepped = Bench::Clock::now();
+                Step(Storage, PageCount * Percent / 100, Seed);
+                auto Start = Bench::Clock::now();
+                Stepping += std::chrono::duration<double>(Start - Stepped).count();
+                Writer.Capture();
+                auto Captured = Bench::Clock::now();
+                Writer.Wait();
+                Capturing += std::chrono::duration<double>(Captured - Start).count();
+                Writing += std::chrono::duration<double>(Bench::Clock::now() - Captured).count();
+            }
+
+            char Label[64];
+            snprintf(Label, sizeof(Label), "%s, %u%% dirty: frame writes", Name, uint32(Percent));
+            Bench::Report(Label, Stepping / FrameCount, double(StorageSize) * Percent / 100, "B");
+            snprintf(Label, sizeof(Label), "%s, %u%% dirty: capture", Name, uint32(Percent));
+            Bench::Report(Label, Capturing / FrameCount, double(StorageSize), "B");
+            snprintf(Label, sizeof(Label), "%s, %u%% dirty: compress (background)", Name, uint32(Percent));
+            Bench::Report(Label, Writing / FrameCount, double(StorageSize) * Percent / 100, "B");
+            printf("%-48s %10.2f MB base %9.2f MB per delta\n", "", double(BaseSize) / (1 << 20),
+                   double(Output.Size - BaseSize) / FrameCount / (1 << 20));
+
+            std::vector<uint8> Restored(StorageSize);
+            auto               Seconds = Bench::Measure(3, [&] {
+                Game::Snapshot::Restore(Output.Data.data(), Output.Size, Restored.data(), StorageSize);
+            });
+            snprintf(Label, sizeof(Label), "%s, %u%% dirty: restore base + %u", Name, uint32(Percent), FrameCount);
+            Bench::Report(Label, Seconds, double(StorageSize), "B");
+            if (memcmp(Restored.data(), Storage, StorageSize) != 0)
+            {
+                printf("%-48s restored state differs\n", "");
+            }
+        }
+    }
+} // namespace
+
+void SnapshotBench()
+{
+#if _WIN32
+    std::vector<uint8> Block(StorageSize);
+    auto               Storage = Block.data();
+#else
+    auto Storage = static_cast<uint8*>(
+        mmap(nullptr, StorageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0));
+#endif
+    std::vector<uint8> Memory(StorageSize + (8 << 20));
+    Game::MemoryArena  Arena{ Memory.data(), Memory.size() };
+
+    std::vector<uint8> Copy(StorageSize);
+    Fill(Storage);
+    auto Seconds = Bench::Measure(5, [&] { memcpy(Copy.data(), Storage, StorageSize); });
+    Bench::Report("full copy", Seconds, double(StorageSize), "B");
+
+    Run<Game::HashPageTracker>("hash", Storage, Arena);
+#if !_WIN32
+    Run<Linux::WriteFaultPageTracker>("write faults", Storage, Arena);
+    munmap(Storage, StorageSize);
+#endif
+}
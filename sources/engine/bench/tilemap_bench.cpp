@@ -0,0 +1,101 @@
+#include "bench.hpp"
+
+#include <tilemap.hpp>
+
+#include <vector>
+
+// A 1280x720 view over maps of 10^6 and 10^8 tiles of 8x8 and 16x16 pixels, generated by the streamer when a chunk is
+// loaded. 100 frames with a still camera (cached chunk bitmaps), then 100 frames panning 8 pixels per frame (chunks
+// streamed in and their bitmaps built). The baseline keeps no map: it generates and draws every visible tile.
+
+namespace
+{
+    constexpr int32 Width      = 1280;
+    constexpr int32 Height     = 720;
+    constexpr int   FrameCount = 100;
+
+    Game::TileId Generate(int32 X, int32 Y)
+    {
+        auto Hash = uint32(X) * 73856093u ^ uint32(Y) * 19349663u;
+        return Game::TileId(1 + (Hash >> 8) % 16);
+    }
+
+    void LoadChunk(void*, int32 ChunkX, int32 ChunkY, Game::TileId* Tiles)
+    {
+        for (int32 Index = 0; Index < Game::TileMap::ChunkTileCount; ++Index)
+        {
+            Tiles[Index] = Generate(ChunkX * Game::TileMap::ChunkSize + Index % Game::TileMap::ChunkSize,
+                                    ChunkY * Game::TileMap::ChunkSize + Index / Game::TileMap::ChunkSize);
+        }
+    }
+} // namespace
+
+void TileMapBench()
+{
+    std::vector<uint32> Pixels(Width * Height);
+    PIBackBuffer        Buffer = { Pixels.data(), Width, Height, 4, Width * 4 };
+    std::vector<uint8>  Memory(64 << 20);
+    Game::MemoryArena   Arena{ Memory.data(), Memory.size() };
+    double              FramePixels = double(Width) * Height * FrameCount;
+    char                Name[64];
+
+    for (int32 TileSize : { 8, 16 })
+    {
+        std::vector<uint32> Atlas(4 * TileSize * 4 * TileSize);
+        for (uint32 Index = 0; Index < Atlas.size(); ++Index)
+        {
+            Atlas[Index] = 0xFF000000 | (Index * 2654435761u >> 8);
+        }
+        Game::Bitmap  Cells = { Atlas.data(), 4 * TileSize, 4 * TileSize, 4 * TileSize * 4, Game::BitmapAlpha::Opaque };
+        Game::Tileset Tiles = { Cells, TileSize, TileSize, Game::TileShape::Rectangle };
+
+        for (int32 Side : { 1000, 10000 })
+        {
+            Game::TemporaryMemory Scope{ Arena };
+            auto                  Used = Arena.GetUsed();
+            Game::TileMap         Map{ Arena, Side, Side, Tiles, 256, 64 };
+            Map.SetStreamer({ nullptr, LoadChunk, nullptr });
+
+            auto Start = Side * TileSize / 4;
+            auto Still = Bench::Measure(3, [&] {
+                for (int Frame = 0; Frame < FrameCount; ++Frame)
+                {
+                    Map.Draw(Buffer, Start, Start);
+                }
+            });
+            int32 Pan     = 0;
+            auto  Panning = Bench::Measure(3, [&] {
+                for (int Frame = 0; Frame < FrameCount; ++Frame, Pan += 8)
+                {
+                    Map.Draw(Buffer, Start + Pan, Start + Pan / 2);
+                }
+            });
+
+            snprintf(Name, sizeof(Name), "%dpx, %d^2 tiles: still, %d frames", TileSize, Side, FrameCount);
+            Bench::Report(Name, Still, FramePixels, "pix");
+            snprintf(Name, sizeof(Name), "%dpx, %d^2 tiles: panning, %d frames", TileSize, Side, FrameCount);
+            Bench::Report(Name, Panning, FramePixels, "pix");
+            printf("%-48s %10.2f MB\n", "  arena", double(Arena.GetUsed() - Used) / (1 << 20));
+        }
+
+        int32 Pan     = 0;
+        auto  PerTile = Bench::Measure(3, [&] {
+            for (int Frame = 0; Frame < FrameCount; ++Frame, Pan += 8)
+            {
+                auto CameraX = 20000 + Pan;
+                auto CameraY = 20000 + Pan / 2;
+                for (auto Y = CameraY / TileSize; Y <= (CameraY + Height - 1) / TileSize; ++Y)
+                {
+                    for (auto X = CameraX / TileSize; X <= (CameraX + Width - 1) / TileSize; ++X)
+                    {
+                        auto Tile = Tiles.GetTile(Generate(X, Y));
+                        Game::DrawBitmap(Buffer, Tile, X * TileSize - CameraX, Y * TileSize - CameraY);
+                    }
+                }
+            }
+        });
+        snprintf(Name, sizeof(Name), "%dpx, tile by tile: panning, %d frames", TileSize, FrameCount);
+        Bench::Report(Name, PerTile, FramePixels, "pix");
+    }
+    Bench::DoNotOptimize(Pixels[Width * Height / 2]);
+}
@@ -1,5 +1,7 @@
 #include "game.hpp"
 #include "game_inputs.hpp"
+#include "interned_string.hpp"
+#include "render_commands.hpp"
 
 #include "types.hpp"
 
@@ -87,6 +89,8 @@ extern "C" __declspec(dllexport) void GameUpdateAndRender(thread_context& Thread
                          SoundOutputBuffer&     SoundBuffer*/)
 {
     (void)Thread;
+    // the dll has its own globals, set again after each reload
+    SetStringTable(Memory.Strings);
     auto& GameState = *static_cast<State*>(Memory.PermanentStorage);
     // if (!Memory.IsInitialized)
     // {
@@ -110,6 +114,16 @@ extern "C" __declspec(dllexport) void GameUpdateAndRender(thread_context& Thread
     }
 
     RenderWeirdGradient(Buffer, GameState.BlueOffset, GameState.GreenOffset);
+
+    // the transient storage is only used during the frame for now
+    MemoryArena         Transient{ Memory.TransientStorage, Memory.TransientStorageSize };
+    RenderCommandBuffer Commands{ Transient, 4096, Buffer.Width, Buffer.Height };
+
+    auto MarkerX = Buffer.Width / 2 + GameState.BlueOffset % (Buffer.Width / 2);
+    auto MarkerY = Buffer.Height / 2 + GameState.GreenOffset % (Buffer.Height / 2);
+    Commands.PushRectangle(1, { MarkerX - 20, MarkerY - 20, MarkerX + 20, MarkerY + 20 }, 0x80000000);
+    Commands.PushRectangle(0, { MarkerX - 24, MarkerY - 24, MarkerX + 24, MarkerY + 24 }, 0xFFFFFFFF);
+    Commands.Execute(Buffer, Transient, Memory.Jobs);
 }
 
 extern "C" __declspec(dllexport) void GameGetSoundSamples(thread_context&    Thread,
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <logger.hpp>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+// Linux crash handler of the logger: on a fatal signal, the entries still in the rings are formatted and appended to
+// a file, then the previous handler runs. Install it before the other SIGSEGV handlers (the write fault page tracker
+// chains to it).
+
+namespace Linux
+{
+
+    class CrashLog final
+    {
+    public:
+        CrashLog(Game::Logger& Log, const char* Path)
+            : Log{ Log }
+            , Path{ Path }
+        {
+            struct sigaction Action = {};
+            Action.sa_sigaction     = &OnSignal;
+            Action.sa_flags         = SA_SIGINFO;
+            sigemptyset(&Action.sa_mask);
+            Instance = this;
+            for (uint32 Index = 0; Index < SignalCount; ++Index)
+            {
+                sigaction(Signals[Index], &Action, &Previous[Index]);
+            }
+        }
+        CrashLog(const CrashLog&) = delete; // non copyable
+
+        ~CrashLog()
+        {
+            for (uint32 Index = 0; Index < SignalCount; ++Index)
+            {
+                sigaction(Signals[Index], &Previous[Index], nullptr);
+            }
+            Instance = nullptr;
+        }
+
+    private:
+        static constexpr int    Signals[]   = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+        static constexpr uint32 SignalCount = sizeof(Signals) / sizeof(*Signals);
+
+        static void Write(void* Context, const char* Text, uint32 Size)
+        {
+            auto File = *static_cast<int*>(Context);
+            while (Size)
+            {
+                auto Written = write(File, Text, Size);
+                if (Written <= 0)
+                {
+                    return;
+                }
+                Text += Written;
+                Size -= uint32(Written);
+            }
+        }
+
+        // open, write, close, the formatting of the logger and the forced Drain are async signal safe: it claims the
+        // rings with a lock free atomic, and only writes a "log not drained" line when a drain was in progress
+        static void OnSignal(int Signal, siginfo_t* Info, void* Context)
+        {
+            auto Self  = Instance;
+            auto Index = 0u;
+            while (Index < SignalCount && Signals[Index] != Signal)
+            {
+                ++Index;
+            }
+            if (!Self || Index == SignalCount)
+            {
+                return;
+            }
+
+            auto File = open(Self->Path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (File >= 0)
+            {
+                char Line[64];
+                auto Text = Game::Format(Line, GAME_FORMAT_STRING("crash: signal {}\n"), Signal);
+                Write(&File, Text.data(), uint32(Text.size()));
+                Self->Log.Drain({ &File, &Write }, true);
+                close(File);
+            }
+
+            // the previous handler, or the default action once this one returns
+            auto& Chained = Self->Previous[Index];
+            sigaction(Signal, &Chained, nullptr);
+            if (Chained.sa_flags & SA_SIGINFO)
+            {
+                Chained.sa_sigaction(Signal, Info, Context);
+            }
+            else if (Chained.sa_handler != SIG_DFL && Chained.sa_handler != SIG_IGN)
+            {
+                Chained.sa_handler(Signal);
+            }
+            else if (Signal == SIGABRT)
+            {
+                raise(Signal);
+            }
+        }
+
+        static inline CrashLog* Instance = nullptr;
+
+        Game::Logger&    Log;
+        const char*      Path;
+        struct sigaction Previous[SignalCount] = {};
+    };
+
+} // namespace Linux
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <file_service.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <memory>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Linux backend of the file service: one io_uring, no thread. Reads are queued in the submission ring and handed to
+// the kernel with one io_uring_enter per batch, BeginFrame only reads the completion ring.
+// Raw system calls, liburing is not required.
+
+namespace Linux
+{
+
+    class IoUringFileService final : public Game::FileService
+    {
+    public:
+        IoUringFileService()
+        {
+            for (auto& File : Files)
+            {
+                File = -1;
+            }
+            for (uint32 Slot = 0; Slot < MaxInFlightCount; ++Slot)
+            {
+                FreeSlots[Slot] = Slot;
+            }
+
+            io_uring_params Params = {};
+            Ring                   = static_cast<int>(syscall(__NR_io_uring_setup, MaxInFlightCount, &Params));
+            if (Ring < 0)
+            {
+                return;
+            }
+            if (!IsReadSupported())
+            {
+                Release();
+                return;
+            }
+            SqMapSize = Params.sq_off.array + Params.sq_entries * sizeof(uint32);
+            CqMapSize = Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe);
+            if (Params.features & IORING_FEAT_SINGLE_MMAP)
+            {
+                SqMapSize = CqMapSize = SqMapSize > CqMapSize ? SqMapSize : CqMapSize;
+            }
+            SqMap = Map(SqMapSize, IORING_OFF_SQ_RING);
+            CqMap = (Params.features & IORING_FEAT_SINGLE_MMAP) ? SqMap : Map(CqMapSize, IORING_OFF_CQ_RING);
+            SqeMapSize = Params.sq_entries * sizeof(io_uring_sqe);
+            Sqes       = static_cast<io_uring_sqe*>(Map(SqeMapSize, IORING_OFF_SQES));
+            if (!SqMap || !CqMap || !Sqes)
+            {
+                Release();
+                return;
+            }
+
+            auto Sq   = static_cast<uint8*>(SqMap);
+            SqHead    = reinterpret_cast<std::atomic<uint32>*>(Sq + Params.sq_off.head);
+            SqTail    = reinterpret_cast<std::atomic<uint32>*>(Sq + Params.sq_off.tail);
+            SqMask    = *reinterpret_cast<uint32*>(Sq + Params.sq_off.ring_mask);
+            SqArray   = reinterpret_cast<uint32*>(Sq + Params.sq_off.array);
+            auto Cq   = static_cast<uint8*>(CqMap);
+            CqHead    = reinterpret_cast<std::atomic<uint32>*>(Cq + Params.cq_off.head);
+            CqTail    = reinterpret_cast<std::atomic<uint32>*>(Cq + Params.cq_off.tail);
+            CqMask    = *reinterpret_cast<uint32*>(Cq + Params.cq_off.ring_mask);
+            Cqes      = reinterpret_cast<io_uring_cqe*>(Cq + Params.cq_off.cqes);
+        }
+
+        IoUringFileService(const IoUringFileService&) = delete; // non copyable
+
+        ~IoUringFileService() override
+        {
+            // the kernel still writes into the destinations of the reads in flight, the rejected ones never reach it
+            while (IsValid() && InFlightCount > RejectedCount)
+            {
+                syscall(__NR_io_uring_enter, Ring, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                BeginFrame();
+            }
+            for (Game::FileHandle File = 0; File < MaxFileCount; ++File)
+            {
+                Close(File);
+            }
+            Release();
+        }
+
+        bool IsValid() const { return Sqes != nullptr; }
+
+        Game::FileHandle OpenForRead(const char* Path, uint64* FileSize) override
+        {
+            for (Game::FileHandle File = 0; File < MaxFileCount; ++File)
+            {
+                if (Files[File] < 0)
+                {
+                    auto        Descriptor = open(Path, O_RDONLY | O_CLOEXEC);
+                    struct stat Status;
+                    if (Descriptor < 0 || fstat(Descriptor, &Status) != 0)
+                    {
+                        if (Descriptor >= 0)
+                        {
+                            close(Descriptor);
+                        }
+                        return Game::InvalidFileHandle;
+                    }
+                    *FileSize   = static_cast<uint64>(Status.st_size);
+                    Files[File] = Descriptor;
+                    return File;
+                }
+            }
+            return Game::InvalidFileHandle;
+        }
+
+        void Close(Game::FileHandle File) override
+        {
+            if (File < MaxFileCount && Files[File] >= 0)
+            {
+                close(Files[File]);
+                Files[File] = -1;
+            }
+        }
+
+        uint32 SubmitReads(const Game::FileReadRequest* Requests, uint32 Count) override
+        {
+            uint32 Accepted = 0;
+            uint32 Queued   = 0;
+            auto   Tail     = SqTail->load(std::memory_order_relaxed);
+            while (Accepted < Count && InFlightCount < MaxInFlightCount)
+            {
+                auto& Request = Requests[Accepted++];
+                ++InFlightCount;
+                if (Request.File >= MaxFileCount || Files[Request.File] < 0 || !Request.Destination)
+                {
+                    // never reaches the kernel, completes at the next frame
+                    Rejected[RejectedCount++] = { Request.UserData, 0, false };
+                    continue;
+                }
+                auto  Index = Tail & SqMask;
+                auto& Sqe   = Sqes[Index];
+                Sqe         = {};
+                Sqe.opcode  = IORING_OP_READ;
+                Sqe.fd      = Files[Request.File];
+                Sqe.off     = Request.Offset;
+                Sqe.addr    = reinterpret_cast<uint64>(Request.Destination);
+                Sqe.len     = Request.Size;
+                // the kernel gives back a slot index, the slot keeps what is needed to tell short reads
+                auto Slot      = FreeSlots[--FreeSlotCount];
+                Slots[Slot]    = { Request.UserData, Request.Size };
+                Sqe.user_data  = Slot;
+                SqArray[Index] = Index;
+                ++Tail;
+                ++Queued;
+            }
+            if (Queued)
+            {
+                SqTail->store(Tail, std::memory_order_release);
+                Submit(Queued);
+            }
+            return Accepted;
+        }
+
+        void BeginFrame() override
+        {
+            FrameCompletionCount = 0;
+            for (uint32 Index = 0; Index < RejectedCount; ++Index)
+            {
+                FrameCompletions[FrameCompletionCount++] = Rejected[Index];
+            }
+            RejectedCount = 0;
+
+            if (IsValid())
+            {
+                auto Head = CqHead->load(std::memory_order_relaxed);
+                auto Tail = CqTail->load(std::memory_order_acquire);
+                for (; Head != Tail && FrameCompletionCount < MaxInFlightCount; ++Head)
+                {
+                    auto& Cqe  = Cqes[Head & CqMask];
+                    auto  Slot = static_cast<uint32>(Cqe.user_data);
+                    auto  Read = Cqe.res > 0 ? static_cast<uint32>(Cqe.res) : 0u;
+                    FrameCompletions[FrameCompletionCount++] = { Slots[Slot].UserData, Read, Read == Slots[Slot].Size };
+                    FreeSlots[FreeSlotCount++]               = Slot;
+                }
+                CqHead->store(Head, std::memory_order_release);
+            }
+            InFlightCount -= FrameCompletionCount;
+        }
+
+    private:
+        struct PendingRead
+        {
+            uint64 UserData;
+            uint32 Size;
+        };
+
+        void* Map(size_t Size, off_t Offset)
+        {
+            auto Memory = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Ring, Offset);
+            return Memory == MAP_FAILED ? nullptr : Memory;
+        }
+
+        // IORING_OP_READ came with kernel 5.6, as the probe: an older kernel fails the probe
+        bool IsReadSupported() const
+        {
+            alignas(io_uring_probe) uint8 Buffer[sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op)] = {};
+            auto Probe = reinterpret_cast<io_uring_probe*>(Buffer);
+            if (syscall(__NR_io_uring_register, Ring, IORING_REGISTER_PROBE, Probe, 256) < 0)
+            {
+                return false;
+            }
+            return Probe->last_op >= IORING_OP_READ && (Probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+        }
+
+        // Hands the queued entries to the kernel. The ones it refuses (EAGAIN, EBUSY: out of resources) are taken back
+        // from the submission ring and fail at the next frame, as the invalid requests
+        void Submit(uint32 Count)
+        {
+            while (Count)
+            {
+                auto Submitted = syscall(__NR_io_uring_enter, Ring, Count, 0, 0, nullptr, 0);
+                if (Submitted < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (Submitted <= 0)
+                {
+                    break;
+                }
+                Count -= static_cast<uint32>(Submitted);
+            }
+            if (Count)
+            {
+                // without SQPOLL, the kernel reads the ring only in io_uring_enter: the entries past its head are ours
+                auto Head = SqHead->load(std::memory_order_acquire);
+                auto Tail = SqTail->load(std::memory_order_relaxed);
+                for (auto Entry = Head; Entry != Tail; ++Entry)
+                {
+                    auto Slot                  = static_cast<uint32>(Sqes[SqArray[Entry & SqMask]].user_data);
+                    Rejected[RejectedCount++]  = { Slots[Slot].UserData, 0, false };
+                    FreeSlots[FreeSlotCount++] = Slot;
+                }
+                SqTail->store(Head, std::memory_order_release);
+            }
+        }
+
+        void Release()
+        {
+            if (Sqes)
+            {
+                munmap(Sqes, SqeMapSize);
+            }
+            if (CqMap && CqMap != SqMap)
+            {
+                munmap(CqMap, CqMapSize);
+            }
+            if (SqMap)
+            {
+                munmap(SqMap, SqMapSize);
+            }
+            if (Ring >= 0)
+            {
+                close(Ring);
+            }
+            Sqes  = nullptr;
+            SqMap = CqMap = nullptr;
+            Ring          = -1;
+        }
+
+        int Ring = -1;
+        int Files[MaxFileCount];
+
+        void*                SqMap      = nullptr;
+        void*                CqMap      = nullptr;
+        size_t               SqMapSize  = 0;
+        size_t               CqMapSize  = 0;
+        size_t               SqeMapSize = 0;
+        io_uring_sqe*        Sqes       = nullptr;
+        std::atomic<uint32>* SqHead     = nullptr;
+        std::atomic<uint32>* SqTail     = nullptr;
+        uint32*              SqArray    = nullptr;
+        uint32               SqMask     = 0;
+        std::atomic<uint32>* CqHead     = nullptr;
+        std::atomic<uint32>* CqTail     = nullptr;
+        io_uring_cqe*        Cqes       = nullptr;
+        uint32               CqMask     = 0;
+
+        PendingRead Slots[MaxInFlightCount];
+        uint32      FreeSlots[MaxInFlightCount];
+        uint32      FreeSlotCount = MaxInFlightCount;
+
+        Game::FileReadCompletion Rejected[MaxInFlightCount];
+        uint32                   RejectedCount = 0;
+    };
+
+    // io_uring when the kernel allows it (5.6+, not disabled by seccomp or sysctl), else blocking reads on threads
+    inline std::unique_ptr<Game::FileService> CreateFileService()
+    {
+        auto Ring = std::make_unique<IoUringFileService>();
+        if (Ring->IsValid())
+        {
+            return Ring;
+        }
+        return std::make_unique<Game::ThreadPoolFileService>();
+    }
+
+} // namespace Linux
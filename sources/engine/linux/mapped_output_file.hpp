@@ -0,0 +1,55 @@
+#pragma once
+
+#include <types.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Linux
+{
+
+    // Shared writable mapping of a new file of Size bytes, zero filled (a metric series, see metrics.hpp); other
+    // processes see the writes through their own mapping. Empty if the file can't be created.
+    class MappedOutputFile final
+    {
+    public:
+        MappedOutputFile(const char* Path, uint64 Size)
+        {
+            File = open(Path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (File < 0 || Size == 0 || ftruncate(File, off_t(Size)) != 0)
+            {
+                return;
+            }
+            auto Mapping = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, File, 0);
+            if (Mapping != MAP_FAILED)
+            {
+                View       = Mapping;
+                this->Size = Size;
+            }
+        }
+        MappedOutputFile(const MappedOutputFile&) = delete; // non copyable
+
+        ~MappedOutputFile()
+        {
+            if (View)
+            {
+                munmap(View, Size);
+            }
+            if (File >= 0)
+            {
+                close(File);
+            }
+        }
+
+        bool   IsValid() const { return View != nullptr; }
+        void*  GetData() const { return View; }
+        uint64 GetSize() const { return Size; }
+
+    private:
+        int    File = -1;
+        void*  View = nullptr;
+        uint64 Size = 0;
+    };
+
+} // namespace Linux
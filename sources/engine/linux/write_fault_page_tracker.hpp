@@ -0,0 +1,122 @@
+#pragma once
+
+#include <snapshot.hpp>
+
+#include <atomic>
+
+#include <signal.h>
+#include <sys/mman.h>
+
+// Linux page tracker of the snapshots: the block is made read only, the first write to a page faults, the SIGSEGV
+// handler marks the page and gives the write access back. A page costs one fault per capture (~6 us), the pages which
+// are not written cost nothing. Soft-dirty bits (/proc/self/clear_refs) would avoid the handler, but they are not
+// available on every kernel and reading /proc/self/pagemap is slower for a mostly clean block.
+//
+// One tracker at a time: the handler is process wide. Faults outside the block go to the previous handler.
+// The block must not be written while CollectDirtyPages runs.
+//
+// The kernel does not fault on the block, it fails: read(), recv() or an io_uring completion into a protected page
+// returns EFAULT instead of writing. Keep the buffers of such calls out of the block (transient storage), or write
+// to each of their pages from user space first so they are unprotected until the next capture.
+
+namespace Linux
+{
+
+    class WriteFaultPageTracker final : public Game::PageTracker
+    {
+    public:
+        // Base is page aligned (mmap, VirtualAlloc). IsValid is false when another tracker is alive
+        WriteFaultPageTracker(Game::MemoryArena& Arena, void* Base, uint64 Size)
+            : Base{ static_cast<uint8*>(Base) }
+            , Size{ Size }
+            , Bits{ Arena.PushArray<uint64>((Game::Snapshot::GetPageCount(Size) + 63) / 64, 64) }
+        {
+            if (!Bits || Instance.load() || reinterpret_cast<uintptr_t>(Base) % PageSize)
+            {
+                Bits = nullptr;
+                return;
+            }
+            for (uint64 Word = 0; Word < (GetPageCount() + 63) / 64; ++Word)
+            {
+                Bits[Word] = 0;
+            }
+
+            struct sigaction Action = {};
+            Action.sa_sigaction     = &OnFault;
+            Action.sa_flags         = SA_SIGINFO | SA_NODEFER;
+            sigemptyset(&Action.sa_mask);
+            Instance = this;
+            if (sigaction(SIGSEGV, &Action, &Previous) != 0 || mprotect(Base, Size, PROT_READ) != 0)
+            {
+                Instance = nullptr;
+                Bits     = nullptr;
+            }
+        }
+
+        ~WriteFaultPageTracker() override
+        {
+            if (IsValid())
+            {
+                mprotect(Base, Size, PROT_READ | PROT_WRITE);
+                sigaction(SIGSEGV, &Previous, nullptr);
+                Instance = nullptr;
+            }
+        }
+
+        bool IsValid() const { return Bits != nullptr; }
+
+        void CollectDirtyPages(uint64* Dirty) override
+        {
+            if (!IsValid())
+            {
+                return;
+            }
+            // protected first: a write from now on belongs to the next call
+            mprotect(Base, Size, PROT_READ);
+            for (uint64 Word = 0; Word < (GetPageCount() + 63) / 64; ++Word)
+            {
+                Dirty[Word] = __atomic_exchange_n(&Bits[Word], 0, __ATOMIC_ACQ_REL);
+            }
+        }
+
+        uint64 GetPageCount() const override { return Game::Snapshot::GetPageCount(Size); }
+
+    private:
+        static void OnFault(int Signal, siginfo_t* Info, void* Context)
+        {
+            auto Tracker = Instance.load();
+            auto Address = static_cast<uint8*>(Info->si_addr);
+            if (Tracker && Address >= Tracker->Base && Address < Tracker->Base + Tracker->Size)
+            {
+                auto Page = uint64(Address - Tracker->Base) / PageSize;
+                __atomic_fetch_or(&Tracker->Bits[Page / 64], uint64(1) << (Page % 64), __ATOMIC_ACQ_REL);
+                mprotect(Tracker->Base + Page * PageSize, PageSize, PROT_READ | PROT_WRITE);
+                return;
+            }
+
+            // not ours: the previous handler, or the default action when the faulting instruction runs again
+            auto& Chained = Tracker ? Tracker->Previous : Default;
+            if (Chained.sa_flags & SA_SIGINFO)
+            {
+                Chained.sa_sigaction(Signal, Info, Context);
+            }
+            else if (Chained.sa_handler != SIG_DFL && Chained.sa_handler != SIG_IGN)
+            {
+                Chained.sa_handler(Signal);
+            }
+            else
+            {
+                signal(SIGSEGV, SIG_DFL);
+            }
+        }
+
+        static inline std::atomic<WriteFaultPageTracker*> Instance = nullptr;
+        static inline struct sigaction                     Default  = {};
+
+        uint8*           Base;
+        uint64           Size;
+        uint64*          Bits; // written by the handler
+        struct sigaction Previous = {};
+    };
+
+} // namespace Linux
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "hash.hpp"
+#include "interned_string.hpp"
+#include "lz.hpp"
+#include "types.hpp"
+
+#include <cstring>
+
+// Asset pack: one read-only file meant to be memory-mapped and used in place.
+//
+//   AssetPackHeader
+//   uint32 Displacements[BucketCount]    perfect hash: bucket -> seed of the second hash
+//   AssetPackEntry Entries[EntryCount]   slot = HashBytes(Name, Displacements[Bucket]) % EntryCount
+//   char Names[]                         not null terminated
+//   blobs, each one aligned on AssetPackAlignment
+//
+// Built by the asset_packer tool.
+
+namespace Game
+{
+    constexpr uint32 AssetPackMagic     = 'A' | ('P' << 8) | ('A' << 16) | ('K' << 24);
+    constexpr uint32 AssetPackVersion   = 1;
+    constexpr uint64 AssetPackAlignment = 64;
+
+    enum class AssetCompression : uint32
+    {
+        None = 0,
+        Lz   = 1,
+    };
+
+    struct AssetPackHeader
+    {
+        uint32 Magic;
+        uint32 Version;
+        uint32 EntryCount;
+        uint32 BucketCount;
+        uint64 DisplacementsOffset;
+        uint64 EntriesOffset;
+        uint64 NamesOffset;
+        uint64 FileSize;
+    };
+
+    struct AssetPackEntry
+    {
+        uint64           NameHash; // HashBytes(Name), seed 0
+        uint32           NameOffset; // from NamesOffset
+        uint32           NameLength;
+        uint64           Offset; // from the beginning of the pack
+        uint64           Size; // uncompressed
+        uint64           StoredSize; // == Size when not compressed
+        AssetCompression Compression;
+        uint32           Reserved;
+    };
+
+    struct AssetView
+    {
+        const uint8*     Data        = nullptr; // points into the mapped pack
+        uint64           Size        = 0;
+        uint64           StoredSize  = 0;
+        AssetCompression Compression = AssetCompression::None;
+
+        explicit operator bool() const { return Data != nullptr; }
+        bool IsCompressed() const { return Compression != AssetCompression::None; }
+    };
+
+    inline uint32 AssetPackBucket(uint64 NameHash, uint32 BucketCount)
+    {
+        return static_cast<uint32>(NameHash % BucketCount);
+    }
+
+    inline uint32 AssetPackSlot(const char* Name, size_t Length, uint32 Displacement, uint32 EntryCount)
+    {
+        return static_cast<uint32>(HashBytes(Name, Length, Displacement) % EntryCount);
+    }
+
+    // Read only view of a pack, does not own the memory
+    class AssetPack final
+    {
+    public:
+        // validates the header and the tables, the memory must outlive the pack
+        bool Open(const void* Memory, uint64 Size)
+        {
+            Base   = nullptr;
+            auto B = static_cast<const uint8*>(Memory);
+            if (!B || Size < sizeof(AssetPackHeader))
+            {
+                return false;
+            }
+            // written so that a corrupt offset cannot overflow
+            auto  IsInside = [Size](uint64 Offset, uint64 Length) { return Offset <= Size && Length <= Size - Offset; };
+            auto& H        = *reinterpret_cast<const AssetPackHeader*>(B);
+            if (H.Magic != AssetPackMagic || H.Version != AssetPackVersion || H.FileSize != Size || !H.BucketCount ||
+                !IsInside(H.DisplacementsOffset, uint64(H.BucketCount) * sizeof(uint32)) ||
+                !IsInside(H.EntriesOffset, uint64(H.EntryCount) * sizeof(AssetPackEntry)) || H.NamesOffset > Size)
+            {
+                return false;
+            }
+            // every name and blob within the file, Find and GetView trust them
+            auto Table = reinterpret_cast<const AssetPackEntry*>(B + H.EntriesOffset);
+            for (uint32 Index = 0; Index < H.EntryCount; ++Index)
+            {
+                auto& Entry = Table[Index];
+                if (!IsInside(H.NamesOffset + Entry.NameOffset, Entry.NameLength) ||
+                    !IsInside(Entry.Offset, Entry.StoredSize) ||
+                    (Entry.Compression == AssetCompression::None && Entry.StoredSize != Entry.Size))
+                {
+                    return false;
+                }
+            }
+            Base          = B;
+            Header        = &H;
+            Displacements = reinterpret_cast<const uint32*>(B + H.DisplacementsOffset);
+            Entries       = reinterpret_cast<const AssetPackEntry*>(B + H.EntriesOffset);
+            Names         = reinterpret_cast<const char*>(B + H.NamesOffset);
+            return true;
+        }
+
+        bool   IsOpen() const { return Base != nullptr; }
+        uint32 GetEntryCount() const { return Base ? Header->EntryCount : 0; }
+
+        // NameHash is HashBytes(Name, Length)
+        const AssetPackEntry* Find(const char* Name, size_t Length, uint64 NameHash) const
+        {
+            if (!Base || !Header->EntryCount)
+            {
+                return nullptr;
+            }
+            auto  Displacement = Displacements[AssetPackBucket(NameHash, Header->BucketCount)];
+            auto& Entry        = Entries[AssetPackSlot(Name, Length, Displacement, Header->EntryCount)];
+            // a perfect hash maps unknown names somewhere too
+            if (Entry.NameHash != NameHash || Entry.NameLength != Length ||
+                memcmp(Names + Entry.NameOffset, Name, Length) != 0)
+            {
+                return nullptr;
+            }
+            return &Entry;
+        }
+
+        const AssetPackEntry* Find(const char* Name, size_t Length) const
+        {
+            return Find(Name, Length, HashBytes(Name, Length));
+        }
+        const AssetPackEntry* Find(const char* Name) const { return Find(Name, strlen(Name)); }
+        // the hash of an interned name is already known
+        const AssetPackEntry* Find(InternedString Name) const { return Find(Name.data(), Name.size(), Name.GetHash()); }
+
+        AssetView Get(const char* Name) const { return GetView(Find(Name)); }
+        AssetView Get(InternedString Name) const { return GetView(Find(Name)); }
+
+        // Only copy: for compressed assets, Destination must hold View.Size bytes
+        static bool Unpack(const AssetView& View, void* Destination)
+        {
+            switch (View.Compression)
+            {
+            case AssetCompression::None:
+                if (View.Size) // the destination of an empty asset may be null
+                {
+                    memcpy(Destination, View.Data, View.Size);
+                }
+                return true;
+            case AssetCompression::Lz:
+                return Lz::Decompress(View.Data, View.StoredSize, Destination, View.Size);
+            }
+            return false;
+        }
+
+        const AssetPackEntry& GetEntry(uint32 Index) const { return Entries[Index]; }
+        const char*           GetName(const AssetPackEntry& Entry) const { return Names + Entry.NameOffset; }
+
+    private:
+        AssetView GetView(const AssetPackEntry* Entry) const
+        {
+            if (Entry)
+            {
+                return { Base + Entry->Offset, Entry->Size, Entry->StoredSize, Entry->Compression };
+            }
+            return {};
+        }
+
+        const uint8*           Base          = nullptr;
+        const AssetPackHeader* Header        = nullptr;
+        const uint32*          Displacements = nullptr;
+        const AssetPackEntry*  Entries       = nullptr;
+        const char*            Names         = nullptr;
+    };
+
+} // namespace Game
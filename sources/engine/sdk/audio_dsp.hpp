@@ -0,0 +1,488 @@
+#pragma once
+
+#include "profiler.hpp"
+#include "types.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+// Effects are processed on blocks of frames where the 4 SIMD lanes of a frame are 4 channels (or voices).
+// A stereo bus uses lanes 0 (left) and 1 (right), lanes 2 and 3 stay silent but cost nothing more.
+// Parameters are smoothed linearly over one block: targets can be changed at any time from the update thread.
+
+namespace Game
+{
+    struct AudioBlock
+    {
+        static constexpr uint32 LaneCount     = 4;
+        static constexpr uint32 MaxFrameCount = 256;
+
+        alignas(16) real32 Samples[MaxFrameCount * LaneCount];
+        uint32 FrameCount = 0;
+
+        __m128 Load(uint32 FrameIndex) const { return _mm_load_ps(Samples + FrameIndex * LaneCount); }
+        void   Store(uint32 FrameIndex, __m128 Frame) { _mm_store_ps(Samples + FrameIndex * LaneCount, Frame); }
+    };
+
+    // Parameter ramp: moves linearly from the current value to the target during the next block
+    struct SmoothedParameter
+    {
+        SmoothedParameter(real32 Value = 0.0f)
+            : Current{ Value }
+            , Target{ Value }
+        {}
+
+        void SetTarget(real32 Value) { Target = Value; }
+
+        // returns the increment to apply per frame, Current is already the end value of the block
+        real32 BeginBlock(uint32 FrameCount)
+        {
+            auto Start = Current;
+            Current    = Target;
+            return (Target - Start) / static_cast<real32>(FrameCount ? FrameCount : 1);
+        }
+
+        real32 Current;
+        real32 Target;
+    };
+
+    namespace Dsp
+    {
+        constexpr real32 Pi32 = 3.14159265359f;
+
+        // Approximations within 0.5% relative error, good enough for gain computing
+        inline __m128 FastLog2(__m128 X)
+        {
+            auto Bits     = _mm_castps_si128(_mm_max_ps(X, _mm_set1_ps(1e-30f)));
+            auto Exponent = _mm_sub_epi32(_mm_srli_epi32(Bits, 23), _mm_set1_epi32(127));
+            auto Mantissa = _mm_castsi128_ps(
+                _mm_or_si128(_mm_and_si128(Bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+            // polynomial for log2(m) on [1,2)
+            auto P = _mm_set1_ps(-0.34484843f);
+            P      = _mm_add_ps(_mm_mul_ps(P, Mantissa), _mm_set1_ps(2.02466578f));
+            P      = _mm_add_ps(_mm_mul_ps(P, Mantissa), _mm_set1_ps(-1.67487759f));
+            return _mm_add_ps(P, _mm_cvtepi32_ps(Exponent));
+        }
+
+        inline __m128 FastExp2(__m128 X)
+        {
+            X              = _mm_max_ps(_mm_min_ps(X, _mm_set1_ps(126.0f)), _mm_set1_ps(-126.0f));
+            auto Truncated = _mm_cvttps_epi32(X);
+            // floor for negative values
+            auto IsBelow  = _mm_castps_si128(_mm_cmplt_ps(X, _mm_cvtepi32_ps(Truncated)));
+            auto Floor    = _mm_sub_epi32(Truncated, _mm_srli_epi32(IsBelow, 31));
+            auto Fraction = _mm_sub_ps(X, _mm_cvtepi32_ps(Floor));
+            // polynomial for 2^f on [0,1)
+            auto P = _mm_set1_ps(0.07944154f);
+            P      = _mm_add_ps(_mm_mul_ps(P, Fraction), _mm_set1_ps(0.22741129f));
+            P      = _mm_add_ps(_mm_mul_ps(P, Fraction), _mm_set1_ps(0.69314718f));
+            P      = _mm_add_ps(_mm_mul_ps(P, Fraction), _mm_set1_ps(1.0f));
+            auto Scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(Floor, _mm_set1_epi32(127)), 23));
+            return _mm_mul_ps(P, Scale);
+        }
+
+        // Mask ? A : B (SSE2 only)
+        inline __m128 Select(__m128 Mask, __m128 A, __m128 B)
+        {
+            return _mm_or_ps(_mm_and_ps(Mask, A), _mm_andnot_ps(Mask, B));
+        }
+
+        inline __m128 Abs(__m128 X) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), X); }
+
+        // One pole smoothing coefficient for a given time constant
+        inline real32 TimeCoefficient(real32 Seconds, real32 SampleRate)
+        {
+            return Seconds > 0.0f ? std::exp(-1.0f / (Seconds * SampleRate)) : 0.0f;
+        }
+    } // namespace Dsp
+
+    class AudioEffect
+    {
+    public:
+        AudioEffect(const char* Name) { Profile.Name = Name; }
+        AudioEffect(const AudioEffect&) = delete; // non copyable
+        virtual ~AudioEffect() {}
+
+        void Process(AudioBlock& Block)
+        {
+            TimedBlock Timer{ Profile };
+            ProcessBlock(Block);
+        }
+
+        const ProfileRecord& GetProfile() const { return Profile; }
+        ProfileRecord&       GetProfile() { return Profile; }
+
+        bool32 IsBypassed = false;
+
+    protected:
+        virtual void ProcessBlock(AudioBlock& Block) = 0;
+
+    private:
+        ProfileRecord Profile;
+    };
+
+    // RBJ cookbook biquad, transposed direct form II, the 4 lanes are filtered in parallel
+    class Biquad final : public AudioEffect
+    {
+    public:
+        enum class Type
+        {
+            LowPass,
+            HighPass,
+            BandPass,
+            Peak,
+        };
+
+        Biquad(real32 SampleRate)
+            : AudioEffect{ "Biquad" }
+            , SampleRate{ SampleRate }
+        {
+            Set(Type::LowPass, SampleRate * 0.45f, 0.7071f, 0.0f);
+            for (uint32 Index = 0; Index < CoefficientCount; ++Index)
+            {
+                Current[Index] = Target[Index];
+            }
+        }
+
+        // new coefficients are reached at the end of the next block
+        void Set(Type FilterType, real32 FrequencyHz, real32 Q, real32 GainDb)
+        {
+            auto W0    = 2.0f * Dsp::Pi32 * FrequencyHz / SampleRate;
+            auto CosW0 = std::cos(W0);
+            auto Alpha = std::sin(W0) / (2.0f * Q);
+            auto A     = std::pow(10.0f, GainDb / 40.0f);
+
+            real32 B0 = 1.0f, B1 = 0.0f, B2 = 0.0f, A0 = 1.0f, A1 = 0.0f, A2 = 0.0f;
+            switch (FilterType)
+            {
+            case Type::LowPass:
+                B0 = B2 = (1.0f - CosW0) * 0.5f;
+                B1      = 1.0f - CosW0;
+                A0      = 1.0f + Alpha;
+                A1      = -2.0f * CosW0;
+                A2      = 1.0f - Alpha;
+                break;
+            case Type::HighPass:
+                B0 = B2 = (1.0f + CosW0) * 0.5f;
+                B1      = -(1.0f + CosW0);
+                A0      = 1.0f + Alpha;
+                A1      = -2.0f * CosW0;
+                A2      = 1.0f - Alpha;
+                break;
+            case Type::BandPass:
+                B0 = Alpha;
+                B1 = 0.0f;
+                B2 = -Alpha;
+                A0 = 1.0f + Alpha;
+                A1 = -2.0f * CosW0;
+                A2 = 1.0f - Alpha;
+                break;
+            case Type::Peak:
+                B0 = 1.0f + Alpha * A;
+                B1 = -2.0f * CosW0;
+                B2 = 1.0f - Alpha * A;
+                A0 = 1.0f + Alpha / A;
+                A1 = -2.0f * CosW0;
+                A2 = 1.0f - Alpha / A;
+                break;
+            }
+            Target[0] = B0 / A0;
+            Target[1] = B1 / A0;
+            Target[2] = B2 / A0;
+            Target[3] = A1 / A0;
+            Target[4] = A2 / A0;
+        }
+
+    private:
+        void ProcessBlock(AudioBlock& Block) override
+        {
+            __m128 Coefficients[CoefficientCount];
+            __m128 Steps[CoefficientCount];
+            auto   InvFrameCount = 1.0f / static_cast<real32>(Block.FrameCount ? Block.FrameCount : 1);
+            for (uint32 Index = 0; Index < CoefficientCount; ++Index)
+            {
+                Coefficients[Index] = _mm_set1_ps(Current[Index]);
+                Steps[Index]        = _mm_set1_ps((Target[Index] - Current[Index]) * InvFrameCount);
+                Current[Index]      = Target[Index];
+            }
+
+            auto Z1 = _mm_load_ps(State1);
+            auto Z2 = _mm_load_ps(State2);
+            for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                for (uint32 Index = 0; Index < CoefficientCount; ++Index)
+                {
+                    Coefficients[Index] = _mm_add_ps(Coefficients[Index], Steps[Index]);
+                }
+                auto X = Block.Load(FrameIndex);
+                auto Y = _mm_add_ps(_mm_mul_ps(Coefficients[0], X), Z1);
+                Z1     = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(Coefficients[1], X), _mm_mul_ps(Coefficients[3], Y)), Z2);
+                Z2     = _mm_sub_ps(_mm_mul_ps(Coefficients[2], X), _mm_mul_ps(Coefficients[4], Y));
+                Block.Store(FrameIndex, Y);
+            }
+            _mm_store_ps(State1, Z1);
+            _mm_store_ps(State2, Z2);
+        }
+
+        static constexpr uint32 CoefficientCount = 5; // b0 b1 b2 a1 a2 (normalized by a0)
+
+        real32 SampleRate;
+        real32 Current[CoefficientCount];
+        real32 Target[CoefficientCount];
+        alignas(16) real32 State1[AudioBlock::LaneCount] = {};
+        alignas(16) real32 State2[AudioBlock::LaneCount] = {};
+    };
+
+    // Feedback delay network: 4 damped delay lines (one per SIMD lane) mixed by a Hadamard matrix.
+    // Input is the mono sum of lanes 0 and 1, the wet signal is spread back on lanes 0 and 1.
+    class FeedbackDelayReverb final : public AudioEffect
+    {
+    public:
+        static constexpr uint32 LineLength = 4096; // power of two, ~85ms at 48kHz
+
+        FeedbackDelayReverb()
+            : AudioEffect{ "FeedbackDelayReverb" }
+        {}
+
+        void SetFeedback(real32 Value) { Feedback.SetTarget(Value); } // [0, 1[ decay time
+        void SetDamping(real32 Value) { Damping.SetTarget(Value); } // [0, 1[ high frequency absorption
+        void SetMix(real32 Value) { Mix.SetTarget(Value); } // 0 dry, 1 wet
+
+    private:
+        void ProcessBlock(AudioBlock& Block) override
+        {
+            auto FeedbackValue = _mm_set1_ps(Feedback.Current);
+            auto FeedbackStep  = _mm_set1_ps(Feedback.BeginBlock(Block.FrameCount));
+            auto DampingValue  = _mm_set1_ps(Damping.Current);
+            auto DampingStep   = _mm_set1_ps(Damping.BeginBlock(Block.FrameCount));
+            auto MixValue      = _mm_set1_ps(Mix.Current);
+            auto MixStep       = _mm_set1_ps(Mix.BeginBlock(Block.FrameCount));
+
+            auto       LowPass   = _mm_load_ps(LowPassState);
+            const auto Half      = _mm_set1_ps(0.5f);
+            const auto One       = _mm_set1_ps(1.0f);
+            const auto StereoPan = _mm_set_ps(0.0f, 0.0f, 1.0f, 1.0f);
+
+            for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                FeedbackValue = _mm_add_ps(FeedbackValue, FeedbackStep);
+                DampingValue  = _mm_add_ps(DampingValue, DampingStep);
+                MixValue      = _mm_add_ps(MixValue, MixStep);
+
+                auto Dry = Block.Load(FrameIndex);
+
+                // lane k reads line k
+                auto Taps = _mm_set_ps(Lines[3][(Position - Lengths[3]) & Mask],
+                                       Lines[2][(Position - Lengths[2]) & Mask],
+                                       Lines[1][(Position - Lengths[1]) & Mask],
+                                       Lines[0][(Position - Lengths[0]) & Mask]);
+                LowPass = _mm_add_ps(Taps, _mm_mul_ps(DampingValue, _mm_sub_ps(LowPass, Taps)));
+
+                // 4x4 Hadamard: (a+b+c+d, a-b+c-d, a+b-c-d, a-b-c+d) / 2
+                auto Swapped1 = _mm_shuffle_ps(LowPass, LowPass, _MM_SHUFFLE(2, 3, 0, 1));
+                auto Sum1     = _mm_add_ps(LowPass, Swapped1);
+                auto Diff1    = _mm_sub_ps(LowPass, Swapped1);
+                auto Pairs    = _mm_shuffle_ps(Sum1, Diff1, _MM_SHUFFLE(2, 0, 2, 0)); // s01 s23 d01 d23
+                Pairs         = _mm_shuffle_ps(Pairs, Pairs, _MM_SHUFFLE(3, 1, 2, 0)); // s01 d01 s23 d23
+                auto Swapped2 = _mm_shuffle_ps(Pairs, Pairs, _MM_SHUFFLE(1, 0, 3, 2));
+                auto Sign     = _mm_set_ps(-1.0f, -1.0f, 1.0f, 1.0f);
+                auto Mixed    = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(Pairs, Sign), Swapped2), Half);
+
+                auto MonoInput = _mm_mul_ps(_mm_add_ps(_mm_shuffle_ps(Dry, Dry, _MM_SHUFFLE(0, 0, 0, 0)),
+                                                       _mm_shuffle_ps(Dry, Dry, _MM_SHUFFLE(1, 1, 1, 1))),
+                                            Half);
+                alignas(16) real32 Written[AudioBlock::LaneCount];
+                _mm_store_ps(Written, _mm_add_ps(MonoInput, _mm_mul_ps(FeedbackValue, Mixed)));
+                for (uint32 LineIndex = 0; LineIndex < AudioBlock::LaneCount; ++LineIndex)
+                {
+                    Lines[LineIndex][Position] = Written[LineIndex];
+                }
+                Position = (Position + 1) & Mask;
+
+                // left = line 0 + line 2, right = line 1 + line 3
+                auto Wet = _mm_mul_ps(_mm_add_ps(Taps, _mm_movehl_ps(Taps, Taps)), _mm_mul_ps(Half, StereoPan));
+                auto Out = _mm_add_ps(_mm_mul_ps(Dry, _mm_sub_ps(One, MixValue)), _mm_mul_ps(Wet, MixValue));
+                Block.Store(FrameIndex, Out);
+            }
+            _mm_store_ps(LowPassState, LowPass);
+        }
+
+        static constexpr uint32 Mask                            = LineLength - 1;
+        static constexpr uint32 Lengths[AudioBlock::LaneCount] = { 1447, 1789, 2083, 2503 }; // mutually prime
+
+        SmoothedParameter Feedback{ 0.7f };
+        SmoothedParameter Damping{ 0.3f };
+        SmoothedParameter Mix{ 0.0f };
+        uint32            Position = 0;
+        alignas(16) real32 LowPassState[AudioBlock::LaneCount] = {};
+        real32 Lines[AudioBlock::LaneCount][LineLength]         = {};
+    };
+
+    // Feed forward compressor with linked stereo detection. A ratio of 0 means infinity: a brick wall limiter.
+    class Compressor final : public AudioEffect
+    {
+    public:
+        Compressor(real32 SampleRate)
+            : AudioEffect{ "Compressor" }
+            , SampleRate{ SampleRate }
+        {
+            SetTimes(0.001f, 0.1f);
+        }
+
+        void SetThreshold(real32 Decibels) { ThresholdLog2.SetTarget(Decibels / DecibelsPerLog2); }
+        void SetRatio(real32 Ratio) { Slope.SetTarget(Ratio > 0.0f ? 1.0f - 1.0f / Ratio : 1.0f); }
+        void SetMakeUpGain(real32 Decibels) { MakeUpLog2.SetTarget(Decibels / DecibelsPerLog2); }
+        void SetTimes(real32 AttackSeconds, real32 ReleaseSeconds)
+        {
+            AttackCoefficient  = Dsp::TimeCoefficient(AttackSeconds, SampleRate);
+            ReleaseCoefficient = Dsp::TimeCoefficient(ReleaseSeconds, SampleRate);
+        }
+
+        real32 GetLastGainReduction() const { return LastGain; }
+
+    private:
+        void ProcessBlock(AudioBlock& Block) override
+        {
+            auto Threshold     = _mm_set1_ps(ThresholdLog2.Current);
+            auto ThresholdStep = _mm_set1_ps(ThresholdLog2.BeginBlock(Block.FrameCount));
+            auto SlopeValue    = _mm_set1_ps(Slope.Current);
+            auto SlopeStep     = _mm_set1_ps(Slope.BeginBlock(Block.FrameCount));
+            auto MakeUp        = _mm_set1_ps(MakeUpLog2.Current);
+            auto MakeUpStep    = _mm_set1_ps(MakeUpLog2.BeginBlock(Block.FrameCount));
+
+            const auto Attack  = _mm_set1_ps(AttackCoefficient);
+            const auto Release = _mm_set1_ps(ReleaseCoefficient);
+            const auto Zero    = _mm_setzero_ps();
+            auto       Env     = _mm_set1_ps(Envelope);
+            auto       Gain    = _mm_set1_ps(1.0f);
+
+            for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                Threshold  = _mm_add_ps(Threshold, ThresholdStep);
+                SlopeValue = _mm_add_ps(SlopeValue, SlopeStep);
+                MakeUp     = _mm_add_ps(MakeUp, MakeUpStep);
+
+                auto Frame = Block.Load(FrameIndex);
+
+                // linked detection: peak of all lanes broadcast to all lanes
+                auto Level = Dsp::Abs(Frame);
+                Level      = _mm_max_ps(Level, _mm_shuffle_ps(Level, Level, _MM_SHUFFLE(2, 3, 0, 1)));
+                Level      = _mm_max_ps(Level, _mm_shuffle_ps(Level, Level, _MM_SHUFFLE(1, 0, 3, 2)));
+
+                auto Coefficient = Dsp::Select(_mm_cmpgt_ps(Level, Env), Attack, Release);
+                Env              = _mm_add_ps(Level, _mm_mul_ps(Coefficient, _mm_sub_ps(Env, Level)));
+
+                // gain in log2 domain: min(0, slope * (threshold - level)) + make up
+                auto Over = _mm_sub_ps(Threshold, Dsp::FastLog2(Env));
+                Gain      = Dsp::FastExp2(_mm_add_ps(_mm_min_ps(Zero, _mm_mul_ps(SlopeValue, Over)), MakeUp));
+                Block.Store(FrameIndex, _mm_mul_ps(Frame, Gain));
+            }
+            Envelope = _mm_cvtss_f32(Env);
+            LastGain = _mm_cvtss_f32(Gain);
+        }
+
+        static constexpr real32 DecibelsPerLog2 = 6.0206f;
+
+        real32            SampleRate;
+        real32            AttackCoefficient;
+        real32            ReleaseCoefficient;
+        SmoothedParameter ThresholdLog2{ 0.0f };
+        SmoothedParameter Slope{ 1.0f };
+        SmoothedParameter MakeUpLog2{ 0.0f };
+        real32            Envelope = 0.0f;
+        real32            LastGain = 1.0f;
+    };
+
+    // Ordered list of insertable effects applied to an interleaved int16 stereo stream
+    class EffectChain final
+    {
+    public:
+        static constexpr uint32 MaxEffectCount = 8;
+
+        bool Insert(AudioEffect& Effect, uint32 SlotIndex = MaxEffectCount)
+        {
+            if (EffectCount == MaxEffectCount)
+            {
+                return false;
+            }
+            if (SlotIndex > EffectCount)
+            {
+                SlotIndex = EffectCount;
+            }
+            for (auto Index = EffectCount; Index > SlotIndex; --Index)
+            {
+                Effects[Index] = Effects[Index - 1];
+            }
+            Effects[SlotIndex] = &Effect;
+            ++EffectCount;
+            return true;
+        }
+
+        void Remove(const AudioEffect& Effect)
+        {
+            uint32 Kept = 0;
+            for (uint32 Index = 0; Index < EffectCount; ++Index)
+            {
+                if (Effects[Index] != &Effect)
+                {
+                    Effects[Kept++] = Effects[Index];
+                }
+            }
+            EffectCount = Kept;
+        }
+
+        uint32       GetEffectCount() const { return EffectCount; }
+        AudioEffect& GetEffect(uint32 Index) const { return *Effects[Index]; }
+
+        // In place processing, the conversion back to int16 saturates
+        void Process(int16* Samples, uint32 FrameCount)
+        {
+            if (!EffectCount)
+            {
+                return;
+            }
+            const auto ToFloat = _mm_set1_ps(1.0f / 32768.0f);
+            const auto ToInt16 = _mm_set1_ps(32767.0f);
+            while (FrameCount)
+            {
+                Block.FrameCount = FrameCount < AudioBlock::MaxFrameCount ? FrameCount : AudioBlock::MaxFrameCount;
+
+                for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+                {
+                    // one frame, left and right, read as a whole through memcpy: int16 storage is not an int32
+                    int32 Frame;
+                    memcpy(&Frame, Samples + 2 * FrameIndex, sizeof(Frame));
+                    auto Stereo = _mm_cvtsi32_si128(Frame);
+                    auto Lanes  = _mm_srai_epi32(_mm_unpacklo_epi16(Stereo, Stereo), 16);
+                    Block.Store(FrameIndex, _mm_mul_ps(_mm_cvtepi32_ps(Lanes), ToFloat));
+                }
+
+                for (uint32 Index = 0; Index < EffectCount; ++Index)
+                {
+                    if (!Effects[Index]->IsBypassed)
+                    {
+                        Effects[Index]->Process(Block);
+                    }
+                }
+
+                for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+                {
+                    auto Lanes  = _mm_cvtps_epi32(_mm_mul_ps(Block.Load(FrameIndex), ToInt16));
+                    auto Stereo = _mm_packs_epi32(Lanes, Lanes);
+                    auto Frame  = _mm_cvtsi128_si32(Stereo);
+                    memcpy(Samples + 2 * FrameIndex, &Frame, sizeof(Frame));
+                }
+
+                Samples += 2 * Block.FrameCount;
+                FrameCount -= Block.FrameCount;
+            }
+        }
+
+    private:
+        AudioEffect* Effects[MaxEffectCount] = {};
+        uint32       EffectCount             = 0;
+        AudioBlock   Block;
+    };
+
+} // namespace Game
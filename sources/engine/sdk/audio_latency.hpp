@@ -0,0 +1,191 @@
+#pragma once
+
+#include "types.hpp"
+
+// Platform independent write-ahead controller for a looping sound buffer (DirectSound style play/write cursors).
+// Each frame, the platform layer feeds the cursors and the position it is about to write to. The controller measures
+// how far the play cursor advances between two frames and how much it jitters, detects underruns and keeps
+// LatencySampleCount as small as possible while staying ahead of the play cursor.
+
+namespace Game
+{
+    struct SoundCursors
+    {
+        uint32 PlayCursor; // in bytes
+        uint32 WriteCursor; // in bytes
+    };
+
+    // Counters, all in samples (a sample being one frame of all channels) unless stated otherwise
+    struct LatencyTelemetry
+    {
+        uint64 UpdateCount        = 0;
+        uint64 UnderrunCount      = 0;
+        uint32 LastAdvance        = 0; // play cursor advance since the previous update
+        uint32 PeakAdvance        = 0; // decaying peak of LastAdvance
+        real32 MeanAdvance        = 0.0f;
+        real32 Jitter             = 0.0f; // mean absolute deviation of the advance
+        uint32 GuardSampleCount   = 0; // write cursor - play cursor: the region we can't write to anymore
+        uint32 LatencySampleCount = 0;
+        uint32 MinLatencyReached  = 0xFFFFFFFF;
+        uint32 MaxLatencyReached  = 0;
+    };
+
+    class LatencyController final
+    {
+    public:
+        LatencyController(uint32 BufferSize, uint32 BytesPerSample, uint32 SamplesPerSecond, uint32 InitialLatency)
+            : BufferSize{ BufferSize }
+            , BytesPerSample{ BytesPerSample }
+            , MinLatency{ SamplesPerSecond / 1000 } // 1ms
+            , MaxLatency{ BufferSize / BytesPerSample / 2 }
+            , HoldUpdateCount{ 60 }
+            , MarginStep{ SamplesPerSecond / 500 } // 2ms
+        {
+            Telemetry.LatencySampleCount = Clamp(InitialLatency);
+        }
+
+        // Returns true if WritePosition (in bytes) was already reached by the play cursor: the caller must resync its
+        // write position on the write cursor.
+        bool Update(SoundCursors Cursors, uint32 WritePosition)
+        {
+            auto& T = Telemetry;
+            ++T.UpdateCount;
+
+            T.GuardSampleCount = Distance(Cursors.PlayCursor, Cursors.WriteCursor) / BytesPerSample;
+            auto Ahead         = Distance(Cursors.PlayCursor, WritePosition);
+            bool IsUnderrun    = HasPrevious && (Ahead < T.GuardSampleCount * BytesPerSample || Ahead > BufferSize / 2);
+
+            if (HasPrevious)
+            {
+                T.LastAdvance = Distance(PreviousPlayCursor, Cursors.PlayCursor) / BytesPerSample;
+                if (T.UpdateCount == 2)
+                {
+                    T.MeanAdvance = static_cast<real32>(T.LastAdvance);
+                }
+                auto Deviation = static_cast<real32>(T.LastAdvance) - T.MeanAdvance;
+                T.MeanAdvance += Deviation * Smoothing;
+                T.Jitter += ((Deviation < 0.0f ? -Deviation : Deviation) - T.Jitter) * Smoothing;
+                // peak decays by 1/64 per update
+                T.PeakAdvance -= T.PeakAdvance / 64;
+                if (T.LastAdvance > T.PeakAdvance)
+                {
+                    T.PeakAdvance = T.LastAdvance;
+                }
+            }
+            HasPrevious        = true;
+            PreviousPlayCursor = Cursors.PlayCursor;
+
+            if (IsUnderrun)
+            {
+                ++T.UnderrunCount;
+                Margin += MarginStep;
+                UpdatesSinceUnderrun = 0;
+            }
+            else
+            {
+                ++UpdatesSinceUnderrun;
+            }
+
+            auto Desired = T.GuardSampleCount + T.PeakAdvance + static_cast<uint32>(2.0f * T.Jitter) + Margin;
+            if (IsUnderrun || Desired > T.LatencySampleCount)
+            {
+                // grow immediately
+                T.LatencySampleCount = Clamp(Desired > T.LatencySampleCount ? Desired : T.LatencySampleCount + Margin);
+            }
+            else if (UpdatesSinceUnderrun > HoldUpdateCount)
+            {
+                // shrink slowly, and forgive old underruns
+                T.LatencySampleCount = Clamp(T.LatencySampleCount - (T.LatencySampleCount - Desired + 7) / 8);
+                if (Margin && (UpdatesSinceUnderrun % HoldUpdateCount) == 0)
+                {
+                    Margin -= Margin < MarginStep ? Margin : MarginStep / 2;
+                }
+            }
+
+            if (HasConverged())
+            {
+                if (T.LatencySampleCount < T.MinLatencyReached)
+                {
+                    T.MinLatencyReached = T.LatencySampleCount;
+                }
+                if (T.LatencySampleCount > T.MaxLatencyReached)
+                {
+                    T.MaxLatencyReached = T.LatencySampleCount;
+                }
+            }
+            return IsUnderrun;
+        }
+
+        uint32                  GetLatencySampleCount() const { return Telemetry.LatencySampleCount; }
+        const LatencyTelemetry& GetTelemetry() const { return Telemetry; }
+
+    private:
+        // forward distance from A to B in the looping buffer, in bytes
+        uint32 Distance(uint32 A, uint32 B) const { return (B + BufferSize - A) % BufferSize; }
+
+        uint32 Clamp(uint32 Latency) const
+        {
+            return Latency < MinLatency ? MinLatency : (Latency > MaxLatency ? MaxLatency : Latency);
+        }
+
+        bool HasConverged() const { return Telemetry.UpdateCount > HoldUpdateCount; }
+
+        static constexpr real32 Smoothing = 1.0f / 16.0f;
+
+        const uint32     BufferSize;
+        const uint32     BytesPerSample;
+        const uint32     MinLatency;
+        const uint32     MaxLatency;
+        const uint32     HoldUpdateCount; // updates without underrun before shrinking
+        const uint32     MarginStep;
+        uint32           Margin               = 0; // extra samples earned by underruns
+        uint32           UpdatesSinceUnderrun = 0;
+        uint32           PreviousPlayCursor   = 0;
+        bool             HasPrevious          = false;
+        LatencyTelemetry Telemetry;
+    };
+
+    // Headless fake sound device: a play cursor moving at the sample rate, reported with a granularity, and a write
+    // cursor a constant guard ahead. Time is driven by the caller so simulations are deterministic.
+    class SimulatedSoundDevice final
+    {
+    public:
+        SimulatedSoundDevice(uint32 BufferSize,
+                             uint32 BytesPerSample,
+                             uint32 SamplesPerSecond,
+                             uint32 GranularitySampleCount,
+                             uint32 GuardSampleCount)
+            : BufferSize{ BufferSize }
+            , BytesPerSample{ BytesPerSample }
+            , SamplesPerSecond{ SamplesPerSecond }
+            , Granularity{ GranularitySampleCount }
+            , Guard{ GuardSampleCount }
+        {}
+
+        void Advance(uint64 Microseconds)
+        {
+            ElapsedMicroseconds += Microseconds;
+            PlayedSampleCount = ElapsedMicroseconds * SamplesPerSecond / 1'000'000;
+        }
+
+        SoundCursors GetCursors() const
+        {
+            auto Reported = PlayedSampleCount - PlayedSampleCount % Granularity;
+            auto Play     = static_cast<uint32>((Reported * BytesPerSample) % BufferSize);
+            return { Play, static_cast<uint32>((Play + Guard * BytesPerSample) % BufferSize) };
+        }
+
+        // absolute count of samples actually played (not quantized), to detect real underruns
+        uint64 GetPlayedSampleCount() const { return PlayedSampleCount; }
+
+    private:
+        const uint32 BufferSize;
+        const uint32 BytesPerSample;
+        const uint32 SamplesPerSecond;
+        const uint32 Granularity;
+        const uint32 Guard;
+        uint64       ElapsedMicroseconds = 0;
+        uint64       PlayedSampleCount   = 0;
+    };
+
+} // namespace Game
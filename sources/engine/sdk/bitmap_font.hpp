@@ -0,0 +1,407 @@
+#pragma once
+
+#include "blit.hpp"
+#include "game.hpp"
+#include "memory_arena.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+#include <cstring>
+#include <string_view>
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// Text drawing without a system font: the glyphs are rasterized once in an atlas of 8-bit coverage, the metrics of the
+// 256 characters are cached in the font, so that measuring a text is a sum of advances and laying it out writes a
+// quad per glyph in a buffer of the caller, without allocation.
+//
+//     BitmapFont Font{ Arena, 2 };
+//     auto       Count = Font.Layout("12.5 ms", X, Y, Quads, MaxCount);
+//     DrawGlyphs(Buffer, Font, Quads, Count, 0xFFFFFFFF, Clip);
+//
+// The built-in font is a 5x7 ASCII font, scaled by an integer factor; any other font is an atlas and its metrics
+// (from the assets). A glyph blends the premultiplied color scaled by its coverage, with the rounding of blit.hpp: the
+// SIMD kernels give the same pixels as the scalar one. A character without a glyph is drawn as '?'.
+
+namespace Game
+{
+    // A glyph in the atlas, and its box relative to the pen (at the top left of the line)
+    struct GlyphMetrics
+    {
+        uint16 AtlasX;
+        uint16 AtlasY;
+        uint8  Width;
+        uint8  Height;
+        int8   OffsetX;
+        int8   OffsetY;
+        uint8  Advance;
+        uint8  Padding;
+    };
+
+    // A glyph to draw: its box in the buffer and in the atlas
+    struct GlyphQuad
+    {
+        int32  X;
+        int32  Y;
+        uint16 AtlasX;
+        uint16 AtlasY;
+        uint16 Width;
+        uint16 Height;
+    };
+
+    struct TextExtent
+    {
+        int32 Width;
+        int32 Height;
+    };
+
+    namespace FontRendering
+    {
+        constexpr uint32 FirstCharacter = 32;
+        constexpr uint32 GlyphCount     = 95;
+        constexpr int32  GlyphWidth     = 5;
+        constexpr int32  GlyphHeight    = 7;
+        constexpr int32  AtlasColumns   = 16;
+
+        // ' ' to '~', a byte per column, the top row in bit 0
+        constexpr uint8 Font5x7[GlyphCount][GlyphWidth] = {
+            { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 },
+            { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 },
+            { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 }, { 0x00, 0x1C, 0x22, 0x41, 0x00 },
+            { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x14, 0x08, 0x3E, 0x08, 0x14 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+            { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 },
+            { 0x20, 0x10, 0x08, 0x04, 0x02 }, { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 },
+            { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 }, { 0x18, 0x14, 0x12, 0x7F, 0x10 },
+            { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+            { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 },
+            { 0x00, 0x56, 0x36, 0x00, 0x00 }, { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 },
+            { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 }, { 0x32, 0x49, 0x79, 0x41, 0x3E },
+            { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+            { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 },
+            { 0x3E, 0x41, 0x49, 0x49, 0x7A }, { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 },
+            { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 }, { 0x7F, 0x40, 0x40, 0x40, 0x40 },
+            { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+            { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 },
+            { 0x46, 0x49, 0x49, 0x49, 0x31 }, { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F },
+            { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F }, { 0x63, 0x14, 0x08, 0x14, 0x63 },
+            { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },
+            { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 },
+            { 0x40, 0x40, 0x40, 0x40, 0x40 }, { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 },
+            { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 }, { 0x38, 0x44, 0x44, 0x48, 0x7F },
+            { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E },
+            { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3D, 0x00 },
+            { 0x7F, 0x10, 0x28, 0x44, 0x00 }, { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 },
+            { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, { 0x7C, 0x14, 0x14, 0x14, 0x08 },
+            { 0x08, 0x14, 0x14, 0x18, 0x7C }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+            { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C },
+            { 0x3C, 0x40, 0x30, 0x40, 0x3C }, { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C },
+            { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, { 0x00, 0x00, 0x7F, 0x00, 0x00 },
+            { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 },
+        };
+
+        // Row kernels: Count pixels of Color scaled by Coverage, blended over Destination
+
+        inline uint32 ScaleColor(uint32 Color, uint32 Coverage)
+        {
+            uint32 Result = 0;
+            for (uint32 Shift = 0; Shift < 32; Shift += 8)
+            {
+                Result |= (((((Color >> Shift) & 0xFF) * Coverage + 128) * 257) >> 16) << Shift;
+            }
+            return Result;
+        }
+
+        inline void CoverageRowScalar(uint32 Color, const uint8* Coverage, uint32* Destination, int32 Count)
+        {
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                if (Coverage[Index])
+                {
+                    Destination[Index] = Blit::BlendPixel(ScaleColor(Color, Coverage[Index]), Destination[Index]);
+                }
+            }
+        }
+
+        // Color16 is the color widened to 16 bits, twice; Coverage4 a coverage per pixel in each byte of the pixel
+        inline __m128i ScaleColor4(__m128i Color16, __m128i Coverage4)
+        {
+            auto Zero  = _mm_setzero_si128();
+            auto Round = _mm_set1_epi16(128);
+            auto By255 = _mm_set1_epi16(257);
+            auto Low   = _mm_mullo_epi16(Color16, _mm_unpacklo_epi8(Coverage4, Zero));
+            auto High  = _mm_mullo_epi16(Color16, _mm_unpackhi_epi8(Coverage4, Zero));
+            Low        = _mm_mulhi_epu16(_mm_add_epi16(Low, Round), By255);
+            High       = _mm_mulhi_epu16(_mm_add_epi16(High, Round), By255);
+            return _mm_packus_epi16(Low, High);
+        }
+
+        inline void CoverageRowSse2(uint32 Color, const uint8* Coverage, uint32* Destination, int32 Count)
+        {
+            auto  Color16  = _mm_unpacklo_epi8(_mm_set1_epi32(int32(Color)), _mm_setzero_si128());
+            auto  IsOpaque = (Color >> 24) == 0xFF;
+            int32 Index    = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                int32 Bytes;
+                memcpy(&Bytes, Coverage + Index, sizeof(Bytes));
+                if (Bytes == 0)
+                {
+                    continue;
+                }
+                auto D = reinterpret_cast<__m128i*>(Destination + Index);
+                if (Bytes == -1 && IsOpaque)
+                {
+                    _mm_storeu_si128(D, _mm_set1_epi32(int32(Color)));
+                    continue;
+                }
+                auto Spread    = _mm_cvtsi32_si128(Bytes);
+                Spread         = _mm_unpacklo_epi8(Spread, Spread);
+                auto Coverage4 = _mm_unpacklo_epi16(Spread, Spread);
+                _mm_storeu_si128(D, Blit::Blend4(ScaleColor4(Color16, Coverage4), _mm_loadu_si128(D)));
+            }
+            CoverageRowScalar(Color, Coverage + Index, Destination + Index, Count - Index);
+        }
+
+        GAME_TARGET_AVX2 inline void CoverageRowAvx2(uint32 Color, const uint8* Coverage, uint32* Destination,
+                                                     int32 Count)
+        {
+            auto  Color16  = _mm256_unpacklo_epi8(_mm256_set1_epi32(int32(Color)), _mm256_setzero_si256());
+            auto  Zero     = _mm256_setzero_si256();
+            auto  Round    = _mm256_set1_epi16(128);
+            auto  By255    = _mm256_set1_epi16(257);
+            auto  IsOpaque = (Color >> 24) == 0xFF;
+            int32 Index    = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                int64 Bytes;
+                memcpy(&Bytes, Coverage + Index, sizeof(Bytes));
+                if (Bytes == 0)
+                {
+                    continue;
+                }
+                auto D = reinterpret_cast<__m256i*>(Destination + Index);
+                if (Bytes == -1 && IsOpaque)
+                {
+                    _mm256_storeu_si256(D, _mm256_set1_epi32(int32(Color)));
+                    continue;
+                }
+                // a coverage in each byte of its pixel, pixels 0-3 in the low lane, 4-7 in the high one
+                auto Spread    = _mm_cvtsi64_si128(Bytes);
+                Spread         = _mm_unpacklo_epi8(Spread, Spread);
+                auto Coverage8 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(Spread, Spread)),
+                                                         _mm_unpackhi_epi16(Spread, Spread), 1);
+                auto Low       = _mm256_mullo_epi16(Color16, _mm256_unpacklo_epi8(Coverage8, Zero));
+                auto High      = _mm256_mullo_epi16(Color16, _mm256_unpackhi_epi8(Coverage8, Zero));
+                Low            = _mm256_mulhi_epu16(_mm256_add_epi16(Low, Round), By255);
+                High           = _mm256_mulhi_epu16(_mm256_add_epi16(High, Round), By255);
+                auto Scaled    = _mm256_packus_epi16(Low, High);
+                _mm256_storeu_si256(D, Blit::Blend8(Scaled, _mm256_loadu_si256(D)));
+            }
+            CoverageRowSse2(Color, Coverage + Index, Destination + Index, Count - Index);
+        }
+
+        using CoverageKernel = void (*)(uint32 Color, const uint8* Coverage, uint32* Destination, int32 Count);
+
+        inline CoverageKernel GetCoverageKernel(SimdLevel Level)
+        {
+            return Level >= SimdLevel::Avx2   ? CoverageRowAvx2
+                   : Level == SimdLevel::Sse2 ? CoverageRowSse2
+                                              : CoverageRowScalar;
+        }
+    } // namespace FontRendering
+
+    class BitmapFont final
+    {
+    public:
+        // The built-in 5x7 font, each of its pixels a Scale x Scale block, rasterized in an atlas pushed on Arena
+        BitmapFont(MemoryArena& Arena, int32 Scale = 1)
+        {
+            using namespace FontRendering;
+            auto CellWidth  = GlyphWidth * Scale;
+            auto CellHeight = GlyphHeight * Scale;
+            auto Width      = AtlasColumns * CellWidth;
+            auto Height     = int32((GlyphCount + AtlasColumns - 1) / AtlasColumns) * CellHeight;
+            auto IsScaled   = Scale > 0 && Scale <= 8; // the metrics are bytes
+            auto Pixels     = IsScaled ? Arena.PushArray<uint8>(uint64(Width) * Height) : nullptr;
+            if (!Pixels)
+            {
+                return;
+            }
+            memset(Pixels, 0, size_t(Width) * Height);
+            GlyphMetrics Metrics[256] = {};
+            for (uint32 Glyph = 0; Glyph < GlyphCount; ++Glyph)
+            {
+                auto Left = int32(Glyph % AtlasColumns) * CellWidth;
+                auto Top  = int32(Glyph / AtlasColumns) * CellHeight;
+                for (int32 Y = 0; Y < CellHeight; ++Y)
+                {
+                    for (int32 X = 0; X < CellWidth; ++X)
+                    {
+                        auto IsSet = (Font5x7[Glyph][X / Scale] >> (Y / Scale)) & 1;
+                        Pixels[(Top + Y) * Width + Left + X] = IsSet ? 0xFF : 0;
+                    }
+                }
+                // the space has no box, only an advance
+                auto IsEmpty = Glyph == 0;
+                Metrics[FirstCharacter + Glyph] = { uint16(Left), uint16(Top),   uint8(IsEmpty ? 0 : CellWidth),
+                                                    uint8(IsEmpty ? 0 : CellHeight), 0, 0,
+                                                    uint8((GlyphWidth + 1) * Scale), 0 };
+            }
+            Atlas       = Pixels;
+            AtlasWidth  = Width;
+            AtlasHeight = Height;
+            SetMetrics(Metrics, (GlyphHeight + 2) * Scale);
+        }
+
+        // A font of the caller: an atlas of Width x Height coverage bytes, the metrics of the 256 characters (those
+        // without advance have no glyph), both kept by the caller
+        BitmapFont(const uint8* Atlas, int32 Width, int32 Height, const GlyphMetrics* Metrics, int32 LineHeight)
+            : Atlas{ Atlas }
+            , AtlasWidth{ Width }
+            , AtlasHeight{ Height }
+        {
+            if (Atlas && Metrics)
+            {
+                SetMetrics(Metrics, LineHeight);
+            }
+        }
+        BitmapFont(const BitmapFont&) = delete; // non copyable
+
+        bool         IsValid() const { return Atlas != nullptr; }
+        int32        GetLineHeight() const { return LineHeight; }
+        const uint8* GetAtlas() const { return Atlas; }
+        int32        GetAtlasWidth() const { return AtlasWidth; }
+        int32        GetAtlasHeight() const { return AtlasHeight; }
+
+        const GlyphMetrics& GetGlyph(char Character) const { return Glyphs[uint8(Character)]; }
+
+        // The box of Text, a line per '\n'
+        TextExtent Measure(std::string_view Text) const
+        {
+            int32 Width     = 0;
+            int32 LineWidth = 0;
+            int32 LineCount = 1;
+            for (auto Character : Text)
+            {
+                if (Character == '\n')
+                {
+                    Width     = LineWidth > Width ? LineWidth : Width;
+                    LineWidth = 0;
+                    ++LineCount;
+                    continue;
+                }
+                LineWidth += Glyphs[uint8(Character)].Advance;
+            }
+            Width = LineWidth > Width ? LineWidth : Width;
+            return { Width, LineCount * LineHeight };
+        }
+
+        // Writes the quads of Text, its top left corner at (X, Y), returns their number: at most MaxCount, the rest of
+        // the text is dropped. The blanks have no quad.
+        uint32 Layout(std::string_view Text, int32 X, int32 Y, GlyphQuad* Quads, uint32 MaxCount) const
+        {
+            uint32 Count = 0;
+            auto   PenX  = X;
+            for (auto Character : Text)
+            {
+                if (Character == '\n')
+                {
+                    PenX = X;
+                    Y += LineHeight;
+                    continue;
+                }
+                auto& Glyph = Glyphs[uint8(Character)];
+                if (Glyph.Width && Glyph.Height)
+                {
+                    if (Count == MaxCount)
+                    {
+                        break;
+                    }
+                    Quads[Count++] = { PenX + Glyph.OffsetX, Y + Glyph.OffsetY, Glyph.AtlasX,
+                                       Glyph.AtlasY,         Glyph.Width,       Glyph.Height };
+                }
+                PenX += Glyph.Advance;
+            }
+            return Count;
+        }
+
+    private:
+        // the characters without a glyph take the one of '?'
+        void SetMetrics(const GlyphMetrics* Metrics, int32 Height)
+        {
+            auto& Fallback = Metrics[uint8('?')];
+            for (uint32 Character = 0; Character < 256; ++Character)
+            {
+                Glyphs[Character] = Metrics[Character].Advance ? Metrics[Character] : Fallback;
+            }
+            LineHeight = Height;
+        }
+
+        const uint8* Atlas       = nullptr;
+        int32        AtlasWidth  = 0;
+        int32        AtlasHeight = 0;
+        int32        LineHeight  = 0;
+        GlyphMetrics Glyphs[256] = {};
+    };
+
+    // Draws the glyphs of Quads in Color (premultiplied), only the pixels inside Clip (itself clipped to the buffer)
+    inline void DrawGlyphs(const PIBackBuffer& Buffer,
+                           const BitmapFont&   Font,
+                           const GlyphQuad*    Quads,
+                           uint32              Count,
+                           uint32              Color,
+                           const BlitRect&     Clip,
+                           SimdLevel           Level = GetBestSimdLevel())
+    {
+        auto Bounds = Intersect(Clip, GetBufferRect(Buffer));
+        auto Kernel = FontRendering::GetCoverageKernel(Level);
+        for (uint32 Index = 0; Index < Count; ++Index)
+        {
+            auto& Quad = Quads[Index];
+            auto  Area = Intersect(Bounds, { Quad.X, Quad.Y, Quad.X + Quad.Width, Quad.Y + Quad.Height });
+            if (Area.IsEmpty())
+            {
+                continue;
+            }
+            auto Width       = Area.MaxX - Area.MinX;
+            auto Source      = Font.GetAtlas() + int64(Quad.AtlasY + Area.MinY - Quad.Y) * Font.GetAtlasWidth()
+                          + Quad.AtlasX + (Area.MinX - Quad.X);
+            auto Destination = static_cast<uint8*>(Buffer.Memory) + int64(Area.MinY) * Buffer.Pitch + Area.MinX * 4;
+            for (auto Row = Area.MinY; Row < Area.MaxY; ++Row)
+            {
+                Kernel(Color, Source, reinterpret_cast<uint32*>(Destination), Width);
+                Source += Font.GetAtlasWidth();
+                Destination += Buffer.Pitch;
+            }
+        }
+    }
+
+    // Lays out and draws Text, its top left corner at (X, Y)
+    inline void DrawText(const PIBackBuffer& Buffer,
+                         const BitmapFont&   Font,
+                         std::string_view    Text,
+                         int32               X,
+                         int32               Y,
+                         uint32              Color,
+                         SimdLevel           Level = GetBestSimdLevel())
+    {
+        GlyphQuad Quads[64];
+        while (!Text.empty())
+        {
+            // a line at a time, by chunks of as many characters as quads
+            auto Line = Text.substr(0, Text.find('\n'));
+            auto PenX = X;
+            for (size_t Start = 0; Start < Line.size(); Start += 64)
+            {
+                auto Chunk = Line.substr(Start, 64);
+                auto Count = Font.Layout(Chunk, PenX, Y, Quads, 64);
+                DrawGlyphs(Buffer, Font, Quads, Count, Color, GetBufferRect(Buffer), Level);
+                PenX += Font.Measure(Chunk).Width;
+            }
+            Text.remove_prefix(Line.size() < Text.size() ? Line.size() + 1 : Line.size());
+            Y += Font.GetLineHeight();
+        }
+    }
+
+} // namespace Game
@@ -0,0 +1,351 @@
+#pragma once
+
+#include "game.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+#include <cstring>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// Sprite drawing into the PIBackBuffer (32-bit BGRX, 0xXXRRGGBB).
+// Sprites are 32-bit premultiplied BGRA (0xAARRGGBB), blended with D = S + D * (255 - Sa) / 255 on the 4 channels.
+// Every kernel gives the same result to the bit: the division by 255 is rounded the same way everywhere.
+
+namespace Game
+{
+    // Alpha content of a sprite, selects the kernel: measure it once at load time with ClassifyAlpha
+    enum class BitmapAlpha : uint32
+    {
+        Opaque = 0, // every alpha is 255: row copies
+        Mask   = 1, // pixels are opaque or fully transparent (0): select
+        Blend  = 2,
+    };
+
+    struct Bitmap
+    {
+        const uint32* Pixels = nullptr;
+        int32         Width  = 0;
+        int32         Height = 0;
+        int32         Pitch  = 0; // in bytes, like PIBackBuffer
+        BitmapAlpha   Alpha  = BitmapAlpha::Blend;
+
+        const uint32* GetRow(int32 Y) const
+        {
+            return reinterpret_cast<const uint32*>(reinterpret_cast<const uint8*>(Pixels) + int64(Y) * Pitch);
+        }
+    };
+
+    // Pixel rectangle, Max excluded
+    struct BlitRect
+    {
+        int32 MinX;
+        int32 MinY;
+        int32 MaxX;
+        int32 MaxY;
+
+        bool IsEmpty() const { return MinX >= MaxX || MinY >= MaxY; }
+    };
+
+    inline BlitRect GetBufferRect(const PIBackBuffer& Buffer)
+    {
+        return { 0, 0, Buffer.Width, Buffer.Height };
+    }
+
+    inline BlitRect Intersect(const BlitRect& A, const BlitRect& B)
+    {
+        return { A.MinX > B.MinX ? A.MinX : B.MinX,
+                 A.MinY > B.MinY ? A.MinY : B.MinY,
+                 A.MaxX < B.MaxX ? A.MaxX : B.MaxX,
+                 A.MaxY < B.MaxY ? A.MaxY : B.MaxY };
+    }
+
+    inline BitmapAlpha ClassifyAlpha(const uint32* Pixels, int32 Width, int32 Height, int32 Pitch)
+    {
+        auto Result = BitmapAlpha::Opaque;
+        for (int32 Y = 0; Y < Height; ++Y)
+        {
+            auto Row = reinterpret_cast<const uint32*>(reinterpret_cast<const uint8*>(Pixels) + int64(Y) * Pitch);
+            for (int32 X = 0; X < Width; ++X)
+            {
+                // premultiplied: a null alpha with a color is additive, it must be blended
+                if (Row[X] >> 24 != 0xFF)
+                {
+                    if (Row[X] != 0)
+                    {
+                        return BitmapAlpha::Blend;
+                    }
+                    Result = BitmapAlpha::Mask;
+                }
+            }
+        }
+        return Result;
+    }
+
+    namespace Blit
+    {
+        // Row kernels: Count pixels from Source blended over Destination
+
+        inline uint32 BlendPixel(uint32 Source, uint32 Destination)
+        {
+            auto   InverseAlpha = 255 - (Source >> 24);
+            uint32 Result       = 0;
+            for (uint32 Shift = 0; Shift < 32; Shift += 8)
+            {
+                auto Scaled  = ((((Destination >> Shift) & 0xFF) * InverseAlpha + 128) * 257) >> 16;
+                auto Channel = ((Source >> Shift) & 0xFF) + Scaled;
+                Result |= (Channel < 255 ? Channel : 255) << Shift;
+            }
+            return Result;
+        }
+
+        inline void BlendRowScalar(const uint32* Source, uint32* Destination, int32 Count)
+        {
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                Destination[Index] = BlendPixel(Source[Index], Destination[Index]);
+            }
+        }
+
+        inline void MaskRowScalar(const uint32* Source, uint32* Destination, int32 Count)
+        {
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                Destination[Index] = (Source[Index] >> 24) ? Source[Index] : Destination[Index];
+            }
+        }
+
+        // 4 pixels: the channels are widened to 16 bits, the alpha of each pixel spread on its 4 channels
+        inline __m128i Blend4(__m128i Source, __m128i Destination)
+        {
+            auto Zero     = _mm_setzero_si128();
+            auto Alpha    = _mm_srli_epi32(Source, 24);
+            auto Alpha16  = _mm_or_si128(Alpha, _mm_slli_epi32(Alpha, 16));
+            auto Inverse  = _mm_set1_epi16(255);
+            auto InvLow   = _mm_sub_epi16(Inverse, _mm_unpacklo_epi32(Alpha16, Alpha16));
+            auto InvHigh  = _mm_sub_epi16(Inverse, _mm_unpackhi_epi32(Alpha16, Alpha16));
+            auto Round    = _mm_set1_epi16(128);
+            auto By255    = _mm_set1_epi16(257);
+            auto Low      = _mm_mullo_epi16(_mm_unpacklo_epi8(Destination, Zero), InvLow);
+            auto High     = _mm_mullo_epi16(_mm_unpackhi_epi8(Destination, Zero), InvHigh);
+            Low           = _mm_mulhi_epu16(_mm_add_epi16(Low, Round), By255);
+            High          = _mm_mulhi_epu16(_mm_add_epi16(High, Round), By255);
+            return _mm_adds_epu8(Source, _mm_packus_epi16(Low, High));
+        }
+
+        inline void BlendRowSse2(const uint32* Source, uint32* Destination, int32 Count)
+        {
+            int32 Index = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto S = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source + Index));
+                // transparent and opaque runs are common in sprites
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(S, _mm_setzero_si128())) == 0xFFFF)
+                {
+                    continue;
+                }
+                auto D = reinterpret_cast<__m128i*>(Destination + Index);
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srai_epi32(S, 24), _mm_set1_epi32(-1))) == 0xFFFF)
+                {
+                    _mm_storeu_si128(D, S);
+                    continue;
+                }
+                _mm_storeu_si128(D, Blend4(S, _mm_loadu_si128(D)));
+            }
+            BlendRowScalar(Source + Index, Destination + Index, Count - Index);
+        }
+
+        inline void MaskRowSse2(const uint32* Source, uint32* Destination, int32 Count)
+        {
+            int32 Index = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto S    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source + Index));
+                auto D    = reinterpret_cast<__m128i*>(Destination + Index);
+                auto Mask = _mm_srai_epi32(S, 31);
+                _mm_storeu_si128(D, _mm_or_si128(_mm_and_si128(Mask, S), _mm_andnot_si128(Mask, _mm_loadu_si128(D))));
+            }
+            MaskRowScalar(Source + Index, Destination + Index, Count - Index);
+        }
+
+        // Same as Blend4 on 8 pixels: unpack and pack work inside each 128-bit lane, so the order is kept
+        GAME_TARGET_AVX2 inline __m256i Blend8(__m256i Source, __m256i Destination)
+        {
+            auto Zero    = _mm256_setzero_si256();
+            auto Alpha   = _mm256_srli_epi32(Source, 24);
+            auto Alpha16 = _mm256_or_si256(Alpha, _mm256_slli_epi32(Alpha, 16));
+            auto Inverse = _mm256_set1_epi16(255);
+            auto InvLow  = _mm256_sub_epi16(Inverse, _mm256_unpacklo_epi32(Alpha16, Alpha16));
+            auto InvHigh = _mm256_sub_epi16(Inverse, _mm256_unpackhi_epi32(Alpha16, Alpha16));
+            auto Round   = _mm256_set1_epi16(128);
+            auto By255   = _mm256_set1_epi16(257);
+            auto Low     = _mm256_mullo_epi16(_mm256_unpacklo_epi8(Destination, Zero), InvLow);
+            auto High    = _mm256_mullo_epi16(_mm256_unpackhi_epi8(Destination, Zero), InvHigh);
+            Low          = _mm256_mulhi_epu16(_mm256_add_epi16(Low, Round), By255);
+            High         = _mm256_mulhi_epu16(_mm256_add_epi16(High, Round), By255);
+            return _mm256_adds_epu8(Source, _mm256_packus_epi16(Low, High));
+        }
+
+        GAME_TARGET_AVX2 inline void BlendRowAvx2(const uint32* Source, uint32* Destination, int32 Count)
+        {
+            int32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto S = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Source + Index));
+                if (_mm256_testz_si256(S, S))
+                {
+                    continue;
+                }
+                auto D        = reinterpret_cast<__m256i*>(Destination + Index);
+                auto IsOpaque = _mm256_testc_si256(_mm256_srai_epi32(S, 24), _mm256_set1_epi32(-1));
+                _mm256_storeu_si256(D, IsOpaque ? S : Blend8(S, _mm256_loadu_si256(D)));
+            }
+            BlendRowSse2(Source + Index, Destination + Index, Count - Index);
+        }
+
+        GAME_TARGET_AVX2 inline void MaskRowAvx2(const uint32* Source, uint32* Destination, int32 Count)
+        {
+            int32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto S    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Source + Index));
+                auto D    = reinterpret_cast<__m256i*>(Destination + Index);
+                auto Mask = _mm256_srai_epi32(S, 31);
+                _mm256_storeu_si256(D, _mm256_blendv_epi8(_mm256_loadu_si256(D), S, Mask));
+            }
+            MaskRowSse2(Source + Index, Destination + Index, Count - Index);
+        }
+
+        inline void CopyRowScalar(const uint32* Source, uint32* Destination, int32 Count)
+        {
+            memcpy(Destination, Source, size_t(Count) * sizeof(uint32));
+        }
+
+        // sprite rows are short, an inlined loop beats the memcpy call
+        inline void CopyRowSse2(const uint32* Source, uint32* Destination, int32 Count)
+        {
+            int32 Index = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto S = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source + Index));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Destination + Index), S);
+            }
+            CopyRowScalar(Source + Index, Destination + Index, Count - Index);
+        }
+
+        GAME_TARGET_AVX2 inline void CopyRowAvx2(const uint32* Source, uint32* Destination, int32 Count)
+        {
+            int32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto S = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Source + Index));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(Destination + Index), S);
+            }
+            CopyRowSse2(Source + Index, Destination + Index, Count - Index);
+        }
+
+        using RowKernel = void (*)(const uint32* Source, uint32* Destination, int32 Count);
+
+        inline RowKernel GetRowKernel(BitmapAlpha Alpha, SimdLevel Level)
+        {
+            switch (Alpha)
+            {
+            case BitmapAlpha::Opaque:
+                return Level >= SimdLevel::Avx2 ? CopyRowAvx2 : Level == SimdLevel::Sse2 ? CopyRowSse2 : CopyRowScalar;
+            case BitmapAlpha::Mask:
+                return Level >= SimdLevel::Avx2 ? MaskRowAvx2 : Level == SimdLevel::Sse2 ? MaskRowSse2 : MaskRowScalar;
+            case BitmapAlpha::Blend:
+                break;
+            }
+            return Level >= SimdLevel::Avx2 ? BlendRowAvx2 : Level == SimdLevel::Sse2 ? BlendRowSse2 : BlendRowScalar;
+        }
+
+        // Solid color rows: the color is premultiplied too
+        inline void FillRowScalar(uint32 Color, uint32* Destination, int32 Count)
+        {
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                Destination[Index] = (Color >> 24) == 0xFF ? Color : BlendPixel(Color, Destination[Index]);
+            }
+        }
+
+        inline void FillRowSse2(uint32 Color, uint32* Destination, int32 Count)
+        {
+            auto  S      = _mm_set1_epi32(static_cast<int32>(Color));
+            auto  Opaque = (Color >> 24) == 0xFF;
+            int32 Index  = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto D = reinterpret_cast<__m128i*>(Destination + Index);
+                _mm_storeu_si128(D, Opaque ? S : Blend4(S, _mm_loadu_si128(D)));
+            }
+            FillRowScalar(Color, Destination + Index, Count - Index);
+        }
+
+        GAME_TARGET_AVX2 inline void FillRowAvx2(uint32 Color, uint32* Destination, int32 Count)
+        {
+            auto  S      = _mm256_set1_epi32(static_cast<int32>(Color));
+            auto  Opaque = (Color >> 24) == 0xFF;
+            int32 Index  = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto D = reinterpret_cast<__m256i*>(Destination + Index);
+                _mm256_storeu_si256(D, Opaque ? S : Blend8(S, _mm256_loadu_si256(D)));
+            }
+            FillRowSse2(Color, Destination + Index, Count - Index);
+        }
+    } // namespace Blit
+
+    // Draws Sprite with its top left corner at (X, Y), only the pixels inside Clip (itself clipped to the buffer)
+    inline void DrawBitmap(const PIBackBuffer& Buffer,
+                           const Bitmap&       Sprite,
+                           int32               X,
+                           int32               Y,
+                           const BlitRect&     Clip,
+                           SimdLevel           Level = GetBestSimdLevel())
+    {
+        auto Area = Intersect(Intersect(Clip, GetBufferRect(Buffer)), { X, Y, X + Sprite.Width, Y + Sprite.Height });
+        if (Area.IsEmpty())
+        {
+            return;
+        }
+        auto Kernel      = Blit::GetRowKernel(Sprite.Alpha, Level);
+        auto Count       = Area.MaxX - Area.MinX;
+        auto Destination = static_cast<uint8*>(Buffer.Memory) + int64(Area.MinY) * Buffer.Pitch + Area.MinX * 4;
+        for (auto Row = Area.MinY; Row < Area.MaxY; ++Row)
+        {
+            Kernel(Sprite.GetRow(Row - Y) + (Area.MinX - X), reinterpret_cast<uint32*>(Destination), Count);
+            Destination += Buffer.Pitch;
+        }
+    }
+
+    inline void DrawBitmap(const PIBackBuffer& Buffer, const Bitmap& Sprite, int32 X, int32 Y)
+    {
+        DrawBitmap(Buffer, Sprite, X, Y, GetBufferRect(Buffer));
+    }
+
+    // Fills Rectangle with a premultiplied color, blended unless it is opaque
+    inline void DrawRectangle(const PIBackBuffer& Buffer,
+                              const BlitRect&     Rectangle,
+                              uint32              Color,
+                              const BlitRect&     Clip,
+                              SimdLevel           Level = GetBestSimdLevel())
+    {
+        auto Area = Intersect(Intersect(Clip, GetBufferRect(Buffer)), Rectangle);
+        if (Area.IsEmpty())
+        {
+            return;
+        }
+        auto Kernel      = Level >= SimdLevel::Avx2   ? Blit::FillRowAvx2
+                           : Level == SimdLevel::Sse2 ? Blit::FillRowSse2
+                                                      : Blit::FillRowScalar;
+        auto Count       = Area.MaxX - Area.MinX;
+        auto Destination = static_cast<uint8*>(Buffer.Memory) + int64(Area.MinY) * Buffer.Pitch + Area.MinX * 4;
+        for (auto Row = Area.MinY; Row < Area.MaxY; ++Row)
+        {
+            Kernel(Color, reinterpret_cast<uint32*>(Destination), Count);
+            Destination += Buffer.Pitch;
+        }
+    }
+
+} // namespace Game
@@ -0,0 +1,550 @@
+#pragma once
+
+#include "job_system.hpp"
+#include "math.hpp"
+#include "memory_arena.hpp"
+#include "types.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+// Broadphase: the pairs of overlapping boxes (touching counts), each pair once, the smallest index first.
+//
+// HashGrid is rebuilt every frame: each box is entered in the cells it covers, the entries are sorted by cell hash
+// with a radix sort (counting sorts of 11 bits) and the boxes sharing a bucket are tested. A pair is reported by the
+// cell holding the lower corner of the overlap only, so boxes covering several common cells give one pair.
+//
+// SweepAndPrune cuts the world in horizontal strips and keeps the boxes of each strip sorted on X from one frame to
+// the next: an insertion sort updates the order when the boxes moved a little (mostly static scenes), a radix sort
+// rebuilds it when they moved a lot. Then each box is tested against the next ones of its strip until their X ranges
+// stop overlapping. One sorted axis for the whole world would test every box against a whole column of boxes.
+//
+// Both push everything on the arena at construction, build and test in parallel on the job system, and write the
+// pairs into a PairBuffer provided by the caller. With several threads, the pairs come in no particular order.
+
+namespace Game
+{
+    struct Aabb
+    {
+        v2 Min;
+        v2 Max;
+    };
+
+    inline bool Overlap(const Aabb& A, const Aabb& B)
+    {
+        return A.Min.X <= B.Max.X && B.Min.X <= A.Max.X && A.Min.Y <= B.Max.Y && B.Min.Y <= A.Max.Y;
+    }
+
+    struct BodyPair
+    {
+        uint32 A; // A < B
+        uint32 B;
+    };
+
+    // Preallocated output: Count goes on when the buffer is full, so the caller knows the size it needs
+    struct PairBuffer
+    {
+        BodyPair*           Pairs    = nullptr;
+        uint32              Capacity = 0;
+        std::atomic<uint32> Count    = 0;
+
+        uint32 GetStoredCount() const { return Count < Capacity ? Count.load() : Capacity; }
+        bool   IsOverflowing() const { return Count > Capacity; }
+    };
+
+    namespace Broadphase
+    {
+        constexpr uint32 BatchSize  = 16384; // boxes or entries per job
+        constexpr uint32 DigitBits  = 11;    // per counting sort pass
+        constexpr uint32 DigitCount = 1 << DigitBits;
+
+        // Collects the pairs of one job, to reserve room in the shared buffer once per block
+        class PairWriter final
+        {
+        public:
+            explicit PairWriter(PairBuffer& Output)
+                : Output{ Output }
+            {}
+            PairWriter(const PairWriter&) = delete; // non copyable
+            ~PairWriter() { Flush(); }
+
+            void Push(uint32 A, uint32 B)
+            {
+                Pairs[Count++] = A < B ? BodyPair{ A, B } : BodyPair{ B, A };
+                if (Count == BlockSize)
+                {
+                    Flush();
+                }
+            }
+
+        private:
+            static constexpr uint32 BlockSize = 128;
+
+            void Flush()
+            {
+                auto Start = Output.Count.fetch_add(Count, std::memory_order_relaxed);
+                if (Start < Output.Capacity)
+                {
+                    auto Stored = Output.Capacity - Start < Count ? Output.Capacity - Start : Count;
+                    memcpy(Output.Pairs + Start, Pairs, Stored * sizeof(BodyPair));
+                }
+                Count = 0;
+            }
+
+            PairBuffer& Output;
+            BodyPair    Pairs[BlockSize];
+            uint32      Count = 0;
+        };
+
+        // Histograms of a parallel radix sort of Count items, by batch
+        inline uint32* PushHistograms(MemoryArena& Arena, uint32 MaxCount)
+        {
+            return Arena.PushArray<uint32>(uint64((MaxCount + BatchSize - 1) / BatchSize) * DigitCount, 64);
+        }
+
+        // Stable LSD radix sort on the low KeyBits of Key(Item), ping-ponging between Items and Temporary. Returns
+        // the one holding the result. Histograms comes from PushHistograms.
+        template <typename T, typename F>
+        T* RadixSort(T*         Items,
+                     T*         Temporary,
+                     uint32     Count,
+                     uint32     KeyBits,
+                     F&&        Key,
+                     uint32*    Histograms,
+                     JobSystem* Jobs)
+        {
+            auto BatchCount = (Count + BatchSize - 1) / BatchSize;
+            for (uint32 Shift = 0; Shift < KeyBits; Shift += DigitBits)
+            {
+                ParallelFor(Jobs, BatchCount, [&](uint32 Batch) {
+                    auto Counts = Histograms + uint64(Batch) * DigitCount;
+                    memset(Counts, 0, DigitCount * sizeof(uint32));
+                    auto Last = Batch * BatchSize + BatchSize < Count ? Batch * BatchSize + BatchSize : Count;
+                    for (auto Index = Batch * BatchSize; Index < Last; ++Index)
+                    {
+                        ++Counts[(Key(Items[Index]) >> Shift) & (DigitCount - 1)];
+                    }
+                });
+                // digit after digit, batch after batch: stable
+                uint32 Total = 0;
+                for (uint32 Digit = 0; Digit < DigitCount; ++Digit)
+                {
+                    for (uint32 Batch = 0; Batch < BatchCount; ++Batch)
+                    {
+                        auto& Start = Histograms[uint64(Batch) * DigitCount + Digit];
+                        auto  Size  = Start;
+                        Start       = Total;
+                        Total += Size;
+                    }
+                }
+                ParallelFor(Jobs, BatchCount, [&](uint32 Batch) {
+                    auto Cursors = Histograms + uint64(Batch) * DigitCount;
+                    auto Last    = Batch * BatchSize + BatchSize < Count ? Batch * BatchSize + BatchSize : Count;
+                    for (auto Index = Batch * BatchSize; Index < Last; ++Index)
+                    {
+                        Temporary[Cursors[(Key(Items[Index]) >> Shift) & (DigitCount - 1)]++] = Items[Index];
+                    }
+                });
+                auto Swapped = Items;
+                Items        = Temporary;
+                Temporary    = Swapped;
+            }
+            return Items;
+        }
+
+        // Orders the floats like the integers, negative ones included
+        inline uint32 GetSortKey(real32 Value)
+        {
+            uint32 Bits;
+            memcpy(&Bits, &Value, sizeof(Bits));
+            return Bits & 0x80000000 ? ~Bits : Bits | 0x80000000;
+        }
+    } // namespace Broadphase
+
+    class HashGrid final
+    {
+    public:
+        // TableBits: log2 of the bucket count, about the log2 of the entry count is right, at most 31. MaxEntryCount
+        // bounds the cells covered by all the boxes. Both capacities are 0 when the arena is too small.
+        HashGrid(MemoryArena& Arena, uint32 MaxBoxCount, uint32 MaxEntryCount, real32 CellSize, uint32 TableBits = 20)
+            : Entries{ Arena.PushArray<Entry>(MaxEntryCount, 64) }
+            , Sorted{ Arena.PushArray<Entry>(MaxEntryCount, 64) }
+            , Offsets{ Arena.PushArray<uint32>((MaxBoxCount + Broadphase::BatchSize - 1) / Broadphase::BatchSize + 1) }
+            , Histograms{ Broadphase::PushHistograms(Arena, MaxEntryCount) }
+            , MaxBoxCount{ Entries && Sorted && Offsets && Histograms ? MaxBoxCount : 0 }
+            , MaxEntryCount{ Entries && Sorted && Offsets && Histograms ? MaxEntryCount : 0 }
+            , InverseCellSize{ 1.0f / CellSize }
+            , TableBits{ TableBits < 32 ? TableBits : 31 } // the bucket mask is 1 << TableBits minus 1
+        {}
+        HashGrid(const HashGrid&) = delete; // non copyable
+
+        // Enters the boxes, which must stay valid until FindPairs. Cells over MaxEntryCount are dropped.
+        void Build(const Aabb* Bodies, uint32 Count, JobSystem* Jobs = nullptr)
+        {
+            Boxes    = Bodies;
+            BoxCount = Count < MaxBoxCount ? Count : MaxBoxCount;
+            if (!IsValid())
+            {
+                EntryCount   = 0;
+                DroppedCount = 0;
+                return;
+            }
+            auto Mask  = (1u << TableBits) - 1;
+            auto Cells = [this](const Aabb& Box, int32& MinX, int32& MinY, int32& MaxX, int32& MaxY) {
+                MinX = GetCell(Box.Min.X);
+                MinY = GetCell(Box.Min.Y);
+                MaxX = GetCell(Box.Max.X);
+                MaxY = GetCell(Box.Max.Y);
+                return uint32(MaxX - MinX + 1) * uint32(MaxY - MinY + 1);
+            };
+
+            // entries per batch of boxes, then written at their offset
+            auto BatchCount = (BoxCount + Broadphase::BatchSize - 1) / Broadphase::BatchSize;
+            ParallelFor(Jobs, BatchCount, [&](uint32 Batch) {
+                uint32 Total = 0;
+                int32  MinX, MinY, MaxX, MaxY;
+                for (auto Index = Batch * Broadphase::BatchSize; Index < GetBatchEnd(Batch, BoxCount); ++Index)
+                {
+                    Total += Cells(Boxes[Index], MinX, MinY, MaxX, MaxY);
+                }
+                Offsets[Batch + 1] = Total;
+            });
+            Offsets[0] = 0;
+            for (uint32 Batch = 0; Batch < BatchCount; ++Batch)
+            {
+                Offsets[Batch + 1] += Offsets[Batch];
+            }
+            ParallelFor(Jobs, BatchCount, [&](uint32 Batch) {
+                auto  Written = Offsets[Batch];
+                int32 MinX, MinY, MaxX, MaxY;
+                for (auto Index = Batch * Broadphase::BatchSize; Index < GetBatchEnd(Batch, BoxCount); ++Index)
+                {
+                    Cells(Boxes[Index], MinX, MinY, MaxX, MaxY);
+                    for (auto Y = MinY; Y <= MaxY; ++Y)
+                    {
+                        for (auto X = MinX; X <= MaxX && Written < MaxEntryCount; ++X)
+                        {
+                            Entries[Written++] = { Hash(X, Y) & Mask, Index, X, Y };
+                        }
+                    }
+                }
+            });
+            auto Total   = Offsets[BatchCount];
+            EntryCount   = Total < MaxEntryCount ? Total : MaxEntryCount;
+            DroppedCount = Total - EntryCount;
+            auto Key     = [](const Entry& Value) { return Value.Bucket; };
+            Result = Broadphase::RadixSort(Entries, Sorted, EntryCount, TableBits, Key, Histograms, Jobs);
+        }
+
+        // Tests the boxes of each bucket, in parallel with Jobs
+        void FindPairs(PairBuffer& Output, JobSystem* Jobs = nullptr) const
+        {
+            auto BatchCount = (EntryCount + Broadphase::BatchSize - 1) / Broadphase::BatchSize;
+            ParallelFor(Jobs, BatchCount, [&](uint32 Batch) {
+                Broadphase::PairWriter Writer{ Output };
+                // the buckets starting in the batch, to their end
+                auto First = Batch * Broadphase::BatchSize;
+                while (First > 0 && First < EntryCount && Result[First].Bucket == Result[First - 1].Bucket)
+                {
+                    ++First;
+                }
+                auto End = GetBatchEnd(Batch, EntryCount);
+                for (auto Start = First; Start < End;)
+                {
+                    auto Last = Start + 1;
+                    while (Last < EntryCount && Result[Last].Bucket == Result[Start].Bucket)
+                    {
+                        ++Last;
+                    }
+                    for (auto A = Start; A < Last; ++A)
+                    {
+                        for (auto B = A + 1; B < Last; ++B)
+                        {
+                            if (IsFirstSharedCell(Result[A], Result[B]))
+                            {
+                                Writer.Push(Result[A].Box, Result[B].Box);
+                            }
+                        }
+                    }
+                    Start = Last;
+                }
+            });
+        }
+
+        bool   IsValid() const { return MaxEntryCount != 0; }
+        uint32 GetEntryCount() const { return EntryCount; }
+        uint32 GetDroppedCount() const { return DroppedCount; } // entries, by the last Build
+
+    private:
+        struct Entry
+        {
+            uint32 Bucket;
+            uint32 Box;
+            int32  CellX;
+            int32  CellY;
+        };
+
+        static uint32 Hash(int32 X, int32 Y) { return (uint32(X) * 73856093u) ^ (uint32(Y) * 19349663u); }
+
+        static uint32 GetBatchEnd(uint32 Batch, uint32 Count)
+        {
+            auto End = (Batch + 1) * Broadphase::BatchSize;
+            return End < Count ? End : Count;
+        }
+
+        int32 GetCell(real32 Coordinate) const { return static_cast<int32>(std::floor(Coordinate * InverseCellSize)); }
+
+        // overlapping, in the same cell, which holds the lower corner of their overlap
+        bool IsFirstSharedCell(const Entry& A, const Entry& B) const
+        {
+            auto& BoxA = Boxes[A.Box];
+            auto& BoxB = Boxes[B.Box];
+            if (A.CellX != B.CellX || A.CellY != B.CellY || !Overlap(BoxA, BoxB))
+            {
+                return false;
+            }
+            auto CornerX = BoxA.Min.X > BoxB.Min.X ? BoxA.Min.X : BoxB.Min.X;
+            auto CornerY = BoxA.Min.Y > BoxB.Min.Y ? BoxA.Min.Y : BoxB.Min.Y;
+            return GetCell(CornerX) == A.CellX && GetCell(CornerY) == A.CellY;
+        }
+
+        Entry*      Entries;
+        Entry*      Sorted;
+        Entry*      Result = nullptr; // Entries or Sorted, after the radix sort
+        uint32*     Offsets;
+        uint32*     Histograms;
+        const Aabb* Boxes = nullptr;
+        uint32      MaxBoxCount;
+        uint32      MaxEntryCount;
+        uint32      BoxCount     = 0;
+        uint32      EntryCount   = 0;
+        uint32      DroppedCount = 0;
+        real32      InverseCellSize;
+        uint32      TableBits;
+    };
+
+    class SweepAndPrune final
+    {
+    public:
+        // MaxEntryCount bounds the strips covered by all the boxes. Strips a few times higher than the boxes are
+        // right: the boxes of a strip are sorted together. Both capacities are 0 when the arena is too small.
+        SweepAndPrune(MemoryArena& Arena, uint32 MaxBoxCount, uint32 MaxEntryCount, real32 StripHeight)
+            : Order{ Arena.PushArray<Item>(MaxEntryCount, 64) }
+            , Temporary{ Arena.PushArray<Item>(MaxEntryCount, 64) }
+            , Sorted{ Arena.PushArray<Aabb>(MaxEntryCount, 64) }
+            , Strips{ Arena.PushArray<StripRange>(MaxBoxCount, 64) }
+            , NewStrips{ Arena.PushArray<StripRange>(MaxBoxCount, 64) }
+            , Histograms{ Broadphase::PushHistograms(Arena, MaxEntryCount) }
+            , MaxBoxCount{ Order && Temporary && Sorted && Strips && NewStrips && Histograms ? MaxBoxCount : 0 }
+            , MaxEntryCount{ Order && Temporary && Sorted && Strips && NewStrips && Histograms ? MaxEntryCount : 0 }
+            , InverseStripHeight{ 1.0f / StripHeight }
+        {}
+        SweepAndPrune(const SweepAndPrune&) = delete; // non copyable
+
+        // Sorts the boxes from the order of the previous update, boxes may be added or removed at the end. Bodies is
+        // copied and can change after the call. Strips over MaxEntryCount are dropped.
+        void Update(const Aabb* Bodies, uint32 Count, JobSystem* Jobs = nullptr)
+        {
+            if (!IsValid())
+            {
+                return;
+            }
+            Count = Count < MaxBoxCount ? Count : MaxBoxCount;
+            if (DroppedCount)
+            {
+                // the ranges do not match the entries: all of them are made again
+                BoxCount   = 0;
+                EntryCount = 0;
+            }
+            ParallelFor(Jobs, GetBatchCount(Count), [&](uint32 Batch) {
+                for (auto Box = Batch * Broadphase::BatchSize; Box < GetBatchEnd(Batch, Count); ++Box)
+                {
+                    NewStrips[Box] = { GetStrip(Bodies[Box].Min.Y), GetStrip(Bodies[Box].Max.Y) };
+                }
+            });
+
+            // the entries of the previous order still covered, in Order, then the strips newly covered, in Temporary
+            uint32 Kept = 0;
+            for (uint32 Index = 0; Index < EntryCount; ++Index)
+            {
+                auto& Entry = Order[Index];
+                auto  Range = NewStrips[Entry.Box]; // stale for the removed boxes
+                if (Entry.Box < Count && Range.First <= Entry.Strip && Entry.Strip <= Range.Last)
+                {
+                    Order[Kept++] = Entry;
+                }
+            }
+            uint32 Added  = 0;
+            DroppedCount  = 0;
+            auto MinStrip = Count ? NewStrips[0].First : 0;
+            auto MaxStrip = MinStrip;
+            for (uint32 Box = 0; Box < Count; ++Box)
+            {
+                auto Old = Box < BoxCount ? Strips[Box] : StripRange{ 1, 0 };
+                auto New = NewStrips[Box];
+                for (auto Strip = New.First; Strip <= New.Last; ++Strip)
+                {
+                    if (Strip >= Old.First && Strip <= Old.Last)
+                    {
+                        continue;
+                    }
+                    if (Kept + Added == MaxEntryCount)
+                    {
+                        ++DroppedCount;
+                        continue;
+                    }
+                    Temporary[Added++] = { 0, Box, Strip };
+                }
+                MinStrip = New.First < MinStrip ? New.First : MinStrip;
+                MaxStrip = New.Last > MaxStrip ? New.Last : MaxStrip;
+            }
+            auto Swapped = Strips;
+            Strips       = NewStrips;
+            NewStrips    = Swapped;
+            BoxCount     = Count;
+
+            // strip, then Min.X
+            auto SetKeys = [&](Item* Items, uint32 ItemCount) {
+                ParallelFor(Jobs, GetBatchCount(ItemCount), [&](uint32 Batch) {
+                    for (auto Index = Batch * Broadphase::BatchSize; Index < GetBatchEnd(Batch, ItemCount); ++Index)
+                    {
+                        auto& Entry = Items[Index];
+                        auto  X     = Broadphase::GetSortKey(Bodies[Entry.Box].Min.X);
+                        Entry.Key   = uint64(uint32(Entry.Strip - MinStrip)) << 32 | X;
+                    }
+                });
+            };
+            SetKeys(Order, Kept);
+            SetKeys(Temporary, Added);
+            EntryCount = Kept + Added;
+
+            // the kept entries moved a little: insertion sort, then the few added ones are sorted and merged
+            if (Added <= Kept / 8 + 64 && InsertionSort(Order, Kept, uint64(Kept) * 4 + 1024))
+            {
+                std::sort(Temporary, Temporary + Added, [](const Item& A, const Item& B) { return A.Key < B.Key; });
+                auto Write = EntryCount;
+                auto From  = Kept;
+                while (Added)
+                {
+                    auto IsAdded   = !From || Order[From - 1].Key <= Temporary[Added - 1].Key;
+                    Order[--Write] = IsAdded ? Temporary[--Added] : Order[--From];
+                }
+            }
+            else
+            {
+                std::memcpy(Order + Kept, Temporary, Added * sizeof(Item));
+                uint32 KeyBits = 32;
+                while (KeyBits < 64 && (uint64(uint32(MaxStrip - MinStrip)) >> (KeyBits - 32)))
+                {
+                    ++KeyBits;
+                }
+                auto Key   = [](const Item& Value) { return Value.Key; };
+                auto Found = Broadphase::RadixSort(Order, Temporary, EntryCount, KeyBits, Key, Histograms, Jobs);
+                Temporary  = Found == Order ? Temporary : Order;
+                Order      = Found;
+                ++RebuildCount;
+            }
+
+            ParallelFor(Jobs, GetBatchCount(EntryCount), [&](uint32 Batch) {
+                for (auto Index = Batch * Broadphase::BatchSize; Index < GetBatchEnd(Batch, EntryCount); ++Index)
+                {
+                    Sorted[Index] = Bodies[Order[Index].Box];
+                }
+            });
+        }
+
+        // Sweeps the strips, in parallel with Jobs
+        void FindPairs(PairBuffer& Output, JobSystem* Jobs = nullptr) const
+        {
+            ParallelFor(Jobs, GetBatchCount(EntryCount), [&](uint32 Batch) {
+                Broadphase::PairWriter Writer{ Output };
+                for (auto A = Batch * Broadphase::BatchSize; A < GetBatchEnd(Batch, EntryCount); ++A)
+                {
+                    auto& Box   = Sorted[A];
+                    auto  Strip = Order[A].Strip;
+                    for (auto B = A + 1; B < EntryCount && Sorted[B].Min.X <= Box.Max.X && Order[B].Strip == Strip; ++B)
+                    {
+                        // reported by the strip of the lower overlap edge only
+                        auto Bottom = Sorted[B].Min.Y > Box.Min.Y ? Sorted[B].Min.Y : Box.Min.Y;
+                        if (Sorted[B].Min.Y <= Box.Max.Y && Box.Min.Y <= Sorted[B].Max.Y && GetStrip(Bottom) == Strip)
+                        {
+                            Writer.Push(Order[A].Box, Order[B].Box);
+                        }
+                    }
+                }
+            });
+        }
+
+        bool   IsValid() const { return MaxEntryCount != 0; }
+        uint32 GetEntryCount() const { return EntryCount; }
+        uint32 GetDroppedCount() const { return DroppedCount; } // entries, by the last Update
+        uint32 GetRebuildCount() const { return RebuildCount; } // radix sorts, since construction
+
+    private:
+        struct Item
+        {
+            uint64 Key; // strip, then Min.X
+            uint32 Box;
+            int32  Strip;
+        };
+
+        struct StripRange
+        {
+            int32 First;
+            int32 Last;
+        };
+
+        static uint32 GetBatchCount(uint32 Count)
+        {
+            return (Count + Broadphase::BatchSize - 1) / Broadphase::BatchSize;
+        }
+
+        static uint32 GetBatchEnd(uint32 Batch, uint32 Count)
+        {
+            auto End = (Batch + 1) * Broadphase::BatchSize;
+            return End < Count ? End : Count;
+        }
+
+        int32 GetStrip(real32 Y) const { return static_cast<int32>(std::floor(Y * InverseStripHeight)); }
+
+        // Returns false, the items still a permutation, when more than MaxMoveCount moves are needed
+        static bool InsertionSort(Item* Items, uint32 ItemCount, uint64 MaxMoveCount)
+        {
+            uint64 MoveCount = 0;
+            for (uint32 Index = 1; Index < ItemCount; ++Index)
+            {
+                auto Value    = Items[Index];
+                auto Position = Index;
+                while (Position > 0 && Items[Position - 1].Key > Value.Key)
+                {
+                    Items[Position] = Items[Position - 1];
+                    --Position;
+                }
+                Items[Position] = Value;
+                MoveCount += Index - Position;
+                if (MoveCount > MaxMoveCount)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        Item*       Order;     // of the entries, a box per strip it covers
+        Item*       Temporary; // of the radix sort
+        Aabb*       Sorted;    // copies of the boxes, in order
+        StripRange* Strips;    // of each box, at the last update
+        StripRange* NewStrips;
+        uint32*     Histograms;
+        uint32      MaxBoxCount;
+        uint32      MaxEntryCount;
+        uint32      BoxCount     = 0;
+        uint32      EntryCount   = 0;
+        uint32      DroppedCount = 0;
+        uint32      RebuildCount = 0;
+        real32      InverseStripHeight;
+    };
+
+} // namespace Game
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "bitmap_font.hpp"
+#include "blit.hpp"
+#include "format.hpp"
+#include "memory_arena.hpp"
+#include "profiler.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+// Debug overlay drawn into the PIBackBuffer at the end of a frame: the last frame times, the profiler bars and the
+// arena usage, in a panel laid out from top to bottom.
+//
+//     Overlay.Begin(8, 8, 320);
+//     Overlay.AddFrameGraph(33.3f);
+//     Overlay.AddProfileBars(Records, RecordCount, FrameCycles);
+//     Overlay.AddUsageBar("strings", Arena.GetUsed(), Arena.GetSize());
+//     Overlay.End(Buffer);
+//
+// The widgets only push rectangles (the lines are one pixel wide rectangles) and text in a batch: End draws the panel
+// by bands of BandHeight rows, each rectangle and glyph of a band one after the other while its rows are in the L1
+// cache, with the SIMD fills of blit.hpp and the glyph blits of bitmap_font.hpp. The text is laid out with the built-in
+// 5x7 font when it is pushed. The colors are premultiplied 0xAARRGGBB, like the sprites. A full batch drops what does
+// not fit.
+
+namespace Game
+{
+    namespace DebugDrawing
+    {
+        constexpr int32  LineHeight = 10;
+        constexpr int32  BandHeight = 16;
+        constexpr int32  Margin     = 4;
+        constexpr uint32 White      = 0xFFFFFFFF;
+        constexpr uint32 Gray       = 0xFF909090;
+        constexpr uint32 Green      = 0xFF40D040;
+        constexpr uint32 Yellow     = 0xFFE0D040;
+        constexpr uint32 Red        = 0xFFE04040;
+        constexpr uint32 Background = 0xC0000000;
+
+        struct Rectangle
+        {
+            BlitRect Area;
+            uint32   Color;
+        };
+
+        struct Text
+        {
+            BlitRect Area;
+            uint32   Color;
+            uint32   FirstQuad;
+            uint32   QuadCount;
+        };
+    } // namespace DebugDrawing
+
+    class DebugOverlay final
+    {
+    public:
+        static constexpr uint32 HistorySize = 256;
+
+        // Batches of MaxRectangleCount rectangles and MaxQuadCount glyphs, pushed on Arena with the font atlas
+        DebugOverlay(MemoryArena& Arena, uint32 MaxRectangleCount = 2048, uint32 MaxQuadCount = 4096)
+            : Font{ Arena }
+            , Rectangles{ Arena.PushArray<DebugDrawing::Rectangle>(MaxRectangleCount) }
+            , Texts{ Arena.PushArray<DebugDrawing::Text>(MaxQuadCount / 8) }
+            , Quads{ Arena.PushArray<GlyphQuad>(MaxQuadCount) }
+            , MaxRectangleCount{ MaxRectangleCount }
+            , MaxTextCount{ MaxQuadCount / 8 }
+            , MaxQuadCount{ MaxQuadCount }
+        {
+            if (!IsValid())
+            {
+                this->MaxRectangleCount = MaxTextCount = this->MaxQuadCount = 0;
+            }
+        }
+        DebugOverlay(const DebugOverlay&) = delete; // non copyable
+
+        bool IsValid() const { return Font.IsValid() && Rectangles && Texts && Quads; }
+
+        // The history of the frame graph, HistorySize frames
+        void AddFrameTime(real32 Milliseconds)
+        {
+            FrameTimes[NextFrame] = Milliseconds;
+            NextFrame             = (NextFrame + 1) % HistorySize;
+            FrameCount += FrameCount < HistorySize;
+        }
+
+        // A new panel, Width pixels wide, its top left corner at (X, Y)
+        void Begin(int32 X, int32 Y, int32 Width)
+        {
+            Panel          = { X, Y, X + Width, Y + DebugDrawing::Margin };
+            RectangleCount = 0;
+            TextCount      = 0;
+            QuadCount      = 0;
+            HasPanel       = RectangleCount < MaxRectangleCount;
+            PushRectangle(Panel, DebugDrawing::Background); // resized by End
+        }
+
+        void AddText(std::string_view Text, uint32 Color = DebugDrawing::White)
+        {
+            PushText(Panel.MinX + DebugDrawing::Margin, Panel.MaxY, Text, Color);
+            Panel.MaxY += DebugDrawing::LineHeight;
+        }
+
+        // The frame times of the history, oldest first, a bar per frame: green within TargetMilliseconds, yellow up to
+        // twice as long, red beyond. The lines are the target and twice the target.
+        void AddFrameGraph(real32 TargetMilliseconds, int32 Height = 64)
+        {
+            auto Last = FrameCount ? FrameTimes[(NextFrame + HistorySize - 1) % HistorySize] : 0.0f;
+            char Line[64];
+            AddText(Format(Line, GAME_FORMAT_STRING("frame {:.2f} ms, target {:.1f} ms"), Last, TargetMilliseconds));
+
+            auto Left     = Panel.MinX + DebugDrawing::Margin;
+            auto Width    = Panel.MaxX - Panel.MinX - 2 * DebugDrawing::Margin;
+            auto Bottom   = Panel.MaxY + Height;
+            auto Scale    = real32(Height) / (3.0f * TargetMilliseconds);
+            auto BarWidth = Width / int32(HistorySize) > 0 ? Width / int32(HistorySize) : 1;
+            auto Shown    = uint32(Width / BarWidth) < FrameCount ? uint32(Width / BarWidth) : FrameCount;
+            for (uint32 Index = 0; Index < Shown; ++Index)
+            {
+                auto Time   = FrameTimes[(NextFrame + HistorySize - Shown + Index) % HistorySize];
+                auto Length = int32(Time * Scale + 0.5f);
+                auto Color  = Time <= TargetMilliseconds       ? DebugDrawing::Green
+                              : Time <= 2 * TargetMilliseconds ? DebugDrawing::Yellow
+                                                               : DebugDrawing::Red;
+                auto X      = Left + int32(Index) * BarWidth;
+                PushRectangle({ X, Bottom - (Length < Height ? Length : Height), X + BarWidth, Bottom }, Color);
+            }
+            for (auto Multiple : { 1, 2 })
+            {
+                auto Y = Bottom - int32(Multiple * TargetMilliseconds * Scale + 0.5f);
+                PushRectangle({ Left, Y, Left + Width, Y + 1 }, DebugDrawing::Gray);
+            }
+            Panel.MaxY = Bottom + DebugDrawing::Margin;
+        }
+
+        // A bar per record, the cycles of its last hit against FrameCycles
+        void AddProfileBars(const ProfileRecord* Records, uint32 Count, uint64 FrameCycles)
+        {
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                auto& Record = Records[Index];
+                auto  Share  = FrameCycles ? real64(Record.LastCycleCount) / real64(FrameCycles) : 0.0;
+                char  Line[96];
+                AddBar(Format(Line, GAME_FORMAT_STRING("{} {:.3f} Mc {:.1f}%"), Record.Name ? Record.Name : "?",
+                              real64(Record.LastCycleCount) * 1e-6, Share * 100),
+                       Share, DebugDrawing::Yellow);
+            }
+        }
+
+        // Used bytes of Size, an arena or a pool
+        void AddUsageBar(std::string_view Name, uint64 Used, uint64 Size)
+        {
+            auto Share = Size ? real64(Used) / real64(Size) : 0.0;
+            char Line[96];
+            AddBar(Format(Line, GAME_FORMAT_STRING("{} {} / {} KB"), Name, (Used + 1023) / 1024, Size / 1024), Share,
+                   Share < 0.75 ? DebugDrawing::Green : Share < 0.9 ? DebugDrawing::Yellow : DebugDrawing::Red);
+        }
+
+        void PushRectangle(const BlitRect& Area, uint32 Color)
+        {
+            if (RectangleCount < MaxRectangleCount)
+            {
+                Rectangles[RectangleCount++] = { Area, Color };
+            }
+        }
+
+        void PushText(int32 X, int32 Y, std::string_view Text, uint32 Color)
+        {
+            if (TextCount == MaxTextCount)
+            {
+                return;
+            }
+            auto Count         = Font.Layout(Text, X, Y, Quads + QuadCount, MaxQuadCount - QuadCount);
+            auto Extent        = Font.Measure(Text);
+            Texts[TextCount++] = { { X, Y, X + Extent.Width, Y + Extent.Height }, Color, QuadCount, Count };
+            QuadCount += Count;
+        }
+
+        // Draws the batch into Buffer, band by band
+        void End(const PIBackBuffer& Buffer, SimdLevel Level = GetBestSimdLevel())
+        {
+            if (HasPanel)
+            {
+                Panel.MaxY += DebugDrawing::Margin;
+                Rectangles[0].Area = Panel;
+            }
+            auto Area = GetBounds(Buffer);
+            for (auto Band = Area.MinY; Band < Area.MaxY; Band += DebugDrawing::BandHeight)
+            {
+                BlitRect Clip = { Area.MinX, Band, Area.MaxX, Band + DebugDrawing::BandHeight };
+                for (uint32 Index = 0; Index < RectangleCount; ++Index)
+                {
+                    auto& Item = Rectangles[Index];
+                    if (Item.Area.MinY < Clip.MaxY && Item.Area.MaxY > Clip.MinY)
+                    {
+                        DrawRectangle(Buffer, Item.Area, Item.Color, Clip, Level);
+                    }
+                }
+                for (uint32 Index = 0; Index < TextCount; ++Index)
+                {
+                    auto& Item = Texts[Index];
+                    if (Item.Area.MinY < Clip.MaxY && Item.Area.MaxY > Clip.MinY)
+                    {
+                        DrawGlyphs(Buffer, Font, Quads + Item.FirstQuad, Item.QuadCount, Item.Color, Clip, Level);
+                    }
+                }
+            }
+            RectangleCount = 0;
+            TextCount      = 0;
+            QuadCount      = 0;
+            HasPanel       = false;
+        }
+
+    private:
+        // a line of text, then a bar of Share of the width
+        void AddBar(std::string_view Text, real64 Share, uint32 Color)
+        {
+            AddText(Text);
+            auto Left  = Panel.MinX + DebugDrawing::Margin;
+            auto Width = Panel.MaxX - Panel.MinX - 2 * DebugDrawing::Margin;
+            auto Fill  = int32(real64(Width) * (Share < 1 ? Share : 1) + 0.5);
+            PushRectangle({ Left, Panel.MaxY, Left + Width, Panel.MaxY + 4 }, 0x80404040);
+            PushRectangle({ Left, Panel.MaxY, Left + Fill, Panel.MaxY + 4 }, Color);
+            Panel.MaxY += 8;
+        }
+
+        // the rows and columns touched by the batch, within the buffer
+        BlitRect GetBounds(const PIBackBuffer& Buffer) const
+        {
+            BlitRect Bounds = { INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN };
+            auto     Add    = [&Bounds](const BlitRect& Area) {
+                Bounds.MinX = Area.MinX < Bounds.MinX ? Area.MinX : Bounds.MinX;
+                Bounds.MinY = Area.MinY < Bounds.MinY ? Area.MinY : Bounds.MinY;
+                Bounds.MaxX = Area.MaxX > Bounds.MaxX ? Area.MaxX : Bounds.MaxX;
+                Bounds.MaxY = Area.MaxY > Bounds.MaxY ? Area.MaxY : Bounds.MaxY;
+            };
+            for (uint32 Index = 0; Index < RectangleCount; ++Index)
+            {
+                Add(Rectangles[Index].Area);
+            }
+            for (uint32 Index = 0; Index < TextCount; ++Index)
+            {
+                Add(Texts[Index].Area);
+            }
+            return Intersect(Bounds, GetBufferRect(Buffer));
+        }
+
+        BitmapFont               Font;
+        DebugDrawing::Rectangle* Rectangles;
+        DebugDrawing::Text*      Texts;
+        GlyphQuad*               Quads;
+        uint32                   MaxRectangleCount;
+        uint32                   MaxTextCount;
+        uint32                   MaxQuadCount;
+        uint32                   RectangleCount          = 0;
+        uint32                   TextCount               = 0;
+        uint32                   QuadCount               = 0;
+        BlitRect                 Panel                   = {};
+        bool                     HasPanel                = false;
+        real32                   FrameTimes[HistorySize] = {};
+        uint32                   NextFrame               = 0;
+        uint32                   FrameCount              = 0;
+    };
+
+} // namespace Game
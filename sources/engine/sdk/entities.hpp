@@ -0,0 +1,460 @@
+#pragma once
+
+#include "job_system.hpp"
+#include "memory_arena.hpp"
+#include "types.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+// Entities made of components, stored by archetype: all the entities having exactly the same components share an
+// archetype, whose components are stored in columns (one array per component) cut in chunks of ChunkCapacity
+// entities. A query names its components at compile time: it visits the archetypes having all of them and walks
+// their columns, without any virtual call nor any test per entity.
+//
+//   EntityStore<Position, Velocity, Prop> Entities{ Arena, 10000 };
+//   Entities.ForEach<Position, const Velocity>([](Position& P, const Velocity& V) { P.X += V.X; });
+//   Entities.Count<Prop>();
+//
+// Components are trivially copyable, empty ones are tags which take no memory. Everything is pushed on the arena given
+// at construction (the permanent storage of Game::Memory): the store holds no pointer to code and keeps working
+// after the game DLL is reloaded. Creating, destroying or changing the components of an entity is not allowed
+// during a query.
+
+namespace Game
+{
+    struct Entity
+    {
+        uint32 Index;
+        uint32 Generation; // of the index: a handle to a destroyed entity is not alive anymore
+
+        bool operator==(const Entity& Other) const { return Index == Other.Index && Generation == Other.Generation; }
+        bool operator!=(const Entity& Other) const { return !(*this == Other); }
+    };
+
+    constexpr Entity InvalidEntity = { 0xFFFFFFFF, 0 };
+
+    namespace Detail
+    {
+        template <typename T, typename... Ts>
+        struct TypeIndex;
+
+        template <typename T, typename... Ts>
+        struct TypeIndex<T, T, Ts...>
+        {
+            static constexpr uint32 Value = 0;
+        };
+
+        template <typename T, typename U, typename... Ts>
+        struct TypeIndex<T, U, Ts...>
+        {
+            static constexpr uint32 Value = 1 + TypeIndex<T, Ts...>::Value;
+        };
+    } // namespace Detail
+
+    template <typename... Components>
+    class EntityStore final
+    {
+    public:
+        static constexpr uint32 ComponentCount    = sizeof...(Components);
+        static constexpr uint32 ChunkCapacity     = 4096;
+        static constexpr uint32 MaxArchetypeCount = 64;
+
+        static_assert(ComponentCount <= 64, "the signature of an archetype is a 64-bit mask");
+        static_assert((std::is_trivially_copyable_v<Components> && ...), "components are moved with memcpy");
+
+        // the compile time id of a component, const ignored
+        template <typename T>
+        static constexpr uint32 ComponentId = Detail::TypeIndex<std::remove_const_t<T>, Components...>::Value;
+
+        template <typename... Ts>
+        static constexpr uint64 Signature = ((uint64(1) << ComponentId<Ts>) | ... | uint64(0));
+
+        // At most MaxEntityCount entities alive at the same time, IsValid is false if Arena is too small
+        EntityStore(MemoryArena& Arena, uint32 MaxEntityCount)
+            : Arena{ Arena }
+            , MaxEntityCount{ MaxEntityCount }
+            , Records{ Arena.PushArray<Record>(MaxEntityCount) }
+            , FreeIndices{ Arena.PushArray<uint32>(MaxEntityCount) }
+            , Batches{ Arena.PushArray<Batch>(MaxEntityCount / ChunkCapacity + MaxArchetypeCount) }
+        {}
+        EntityStore(const EntityStore&) = delete; // non copyable
+
+        bool   IsValid() const { return Records && FreeIndices && Batches; }
+        uint32 GetEntityCount() const { return EntityCount; }
+        uint32 GetArchetypeCount() const { return ArchetypeCount; }
+
+        // Returns InvalidEntity when the store or the arena is full
+        template <typename... Ts>
+        Entity Create(const Ts&... Values)
+        {
+            // a full store pushes no archetype
+            if (!IsValid() || (!FreeCount && IndexCount == MaxEntityCount))
+            {
+                return InvalidEntity;
+            }
+            auto Archetype = FindOrAddArchetype(Signature<Ts...>);
+            if (!Archetype || !Reserve(*Archetype))
+            {
+                return InvalidEntity;
+            }
+            auto Index = FreeCount ? FreeIndices[--FreeCount] : IndexCount;
+            if (Index == IndexCount)
+            {
+                Records[IndexCount++] = {};
+            }
+            auto& Target = Records[Index];
+            auto  Row    = Archetype->Count++;
+            Target.Archetype             = uint32(Archetype - Archetypes);
+            Target.Row                   = Row;
+            GetEntities(*Archetype, Row) = { Index, Target.Generation };
+            (Write(*Archetype, Row, Values), ...);
+            ++EntityCount;
+            return { Index, Target.Generation };
+        }
+
+        void Destroy(Entity Handle)
+        {
+            if (!IsAlive(Handle))
+            {
+                return;
+            }
+            auto& Target = Records[Handle.Index];
+            RemoveRow(Archetypes[Target.Archetype], Target.Row);
+            Target.Archetype = NoArchetype;
+            ++Target.Generation;
+            FreeIndices[FreeCount++] = Handle.Index;
+            --EntityCount;
+        }
+
+        bool IsAlive(Entity Handle) const
+        {
+            return Handle.Index < IndexCount && Records[Handle.Index].Generation == Handle.Generation &&
+                   Records[Handle.Index].Archetype != NoArchetype;
+        }
+
+        template <typename T>
+        bool Has(Entity Handle) const
+        {
+            return IsAlive(Handle) && (Archetypes[Records[Handle.Index].Archetype].Signature & Signature<T>);
+        }
+
+        // Null if the entity is not alive or has no T
+        template <typename T>
+        T* Get(Entity Handle)
+        {
+            if (!Has<T>(Handle))
+            {
+                return nullptr;
+            }
+            auto& Target = Records[Handle.Index];
+            if constexpr (std::is_empty_v<T>)
+            {
+                return GetColumn<T>(Archetypes[Target.Archetype], 0); // the single value of the tag
+            }
+            else
+            {
+                auto Column = GetColumn<T>(Archetypes[Target.Archetype], Target.Row / ChunkCapacity);
+                return Column + Target.Row % ChunkCapacity;
+            }
+        }
+
+        // Adds T or replaces its value: the entity moves to another archetype. Returns false when it cannot move.
+        template <typename T>
+        bool Add(Entity Handle, const T& Value)
+        {
+            if (!IsAlive(Handle))
+            {
+                return false;
+            }
+            if (auto Existing = Get<T>(Handle))
+            {
+                *Existing = Value;
+                return true;
+            }
+            if (!Move(Handle, Archetypes[Records[Handle.Index].Archetype].Signature | Signature<T>))
+            {
+                return false;
+            }
+            auto& Target = Records[Handle.Index];
+            Write(Archetypes[Target.Archetype], Target.Row, Value);
+            return true;
+        }
+
+        template <typename T>
+        bool Remove(Entity Handle)
+        {
+            if (!Has<T>(Handle))
+            {
+                return false;
+            }
+            return Move(Handle, Archetypes[Records[Handle.Index].Archetype].Signature & ~Signature<T>);
+        }
+
+        // Function(Ts&...) for every entity having all the Ts
+        template <typename... Ts, typename F>
+        void ForEach(F&& Function)
+        {
+            ForEachChunk<Ts...>([&Function](uint32 Count, const Entity*, Ts*... Columns) {
+                for (uint32 Index = 0; Index < Count; ++Index)
+                {
+                    Function(At(Columns, Index)...);
+                }
+            });
+        }
+
+        // Function(Count, Entities, Ts*...) for every chunk of entities having all the Ts: the columns for batch
+        // kernels. Tag columns point to a single value.
+        template <typename... Ts, typename F>
+        void ForEachChunk(F&& Function)
+        {
+            constexpr auto Query = Signature<Ts...>;
+            for (uint32 ArchetypeIndex = 0; ArchetypeIndex < ArchetypeCount; ++ArchetypeIndex)
+            {
+                auto& Archetype = Archetypes[ArchetypeIndex];
+                if ((Archetype.Signature & Query) != Query)
+                {
+                    continue;
+                }
+                for (uint32 Chunk = 0; Chunk * ChunkCapacity < Archetype.Count; ++Chunk)
+                {
+                    Function(GetChunkCount(Archetype, Chunk),
+                             &GetEntities(Archetype, Chunk * ChunkCapacity),
+                             GetColumn<Ts>(Archetype, Chunk)...);
+                }
+            }
+        }
+
+        // ForEach with the chunks spread on the job system: Function runs on several threads at the same time
+        template <typename... Ts, typename F>
+        void ParallelForEach(JobSystem* Jobs, F&& Function)
+        {
+            constexpr auto Query      = Signature<Ts...>;
+            uint32         BatchCount = 0;
+            for (uint32 ArchetypeIndex = 0; ArchetypeIndex < ArchetypeCount; ++ArchetypeIndex)
+            {
+                auto& Archetype = Archetypes[ArchetypeIndex];
+                if ((Archetype.Signature & Query) != Query)
+                {
+                    continue;
+                }
+                for (uint32 Chunk = 0; Chunk * ChunkCapacity < Archetype.Count; ++Chunk)
+                {
+                    Batches[BatchCount++] = { ArchetypeIndex, Chunk };
+                }
+            }
+            ParallelFor(Jobs, BatchCount, [this, &Function](uint32 BatchIndex) {
+                auto& Archetype = Archetypes[Batches[BatchIndex].Archetype];
+                auto  Chunk     = Batches[BatchIndex].Chunk;
+                RunChunk(Function, GetChunkCount(Archetype, Chunk), GetColumn<Ts>(Archetype, Chunk)...);
+            });
+        }
+
+        // Entities having all the Ts, without visiting them
+        template <typename... Ts>
+        uint32 Count() const
+        {
+            constexpr auto Query  = Signature<Ts...>;
+            uint32         Result = 0;
+            for (uint32 ArchetypeIndex = 0; ArchetypeIndex < ArchetypeCount; ++ArchetypeIndex)
+            {
+                auto& Archetype = Archetypes[ArchetypeIndex];
+                Result += (Archetype.Signature & Query) == Query ? Archetype.Count : 0;
+            }
+            return Result;
+        }
+
+    private:
+        static constexpr uint32 NoArchetype = 0xFFFFFFFF;
+        static constexpr uint32 Sizes[]     = { (std::is_empty_v<Components> ? 0 : uint32(sizeof(Components)))..., 0 };
+        static constexpr uint32 Alignment   = 64; // of every column
+
+        struct Record
+        {
+            uint32 Generation = 0;
+            uint32 Archetype  = NoArchetype;
+            uint32 Row        = 0; // in the archetype, chunk after chunk
+        };
+
+        struct ArchetypeData
+        {
+            uint64  Signature;
+            uint32  Count;                      // of entities
+            uint32  ChunkCount;                 // allocated, never released
+            uint8** Chunks;                     // each one: the entities, then a column per component of the signature
+            uint32  Offsets[ComponentCount + 1]; // of the columns in a chunk by component id, then the chunk size
+        };
+
+        struct Batch
+        {
+            uint32 Archetype;
+            uint32 Chunk;
+        };
+
+        template <typename T>
+        static T& At(T* Column, uint32 Index)
+        {
+            if constexpr (std::is_empty_v<T>)
+            {
+                return *Column;
+            }
+            else
+            {
+                return Column[Index];
+            }
+        }
+
+        template <typename F, typename... Ts>
+        static void RunChunk(F& Function, uint32 Count, Ts*... Columns)
+        {
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                Function(At(Columns, Index)...);
+            }
+        }
+
+        static uint32 GetChunkCount(const ArchetypeData& Archetype, uint32 Chunk)
+        {
+            auto Remaining = Archetype.Count - Chunk * ChunkCapacity;
+            return Remaining < ChunkCapacity ? Remaining : ChunkCapacity;
+        }
+
+        static Entity& GetEntities(ArchetypeData& Archetype, uint32 Row)
+        {
+            return reinterpret_cast<Entity*>(Archetype.Chunks[Row / ChunkCapacity])[Row % ChunkCapacity];
+        }
+
+        template <typename T>
+        static T* GetColumn(ArchetypeData& Archetype, uint32 Chunk)
+        {
+            if constexpr (std::is_empty_v<T>)
+            {
+                static std::remove_const_t<T> Tag;
+                return &Tag;
+            }
+            else
+            {
+                return reinterpret_cast<T*>(Archetype.Chunks[Chunk] + Archetype.Offsets[ComponentId<T>]);
+            }
+        }
+
+        template <typename T>
+        static void Write(ArchetypeData& Archetype, uint32 Row, const T& Value)
+        {
+            if constexpr (!std::is_empty_v<T>)
+            {
+                GetColumn<T>(Archetype, Row / ChunkCapacity)[Row % ChunkCapacity] = Value;
+            }
+        }
+
+        ArchetypeData* FindOrAddArchetype(uint64 ArchetypeSignature)
+        {
+            for (uint32 Index = 0; Index < ArchetypeCount; ++Index)
+            {
+                if (Archetypes[Index].Signature == ArchetypeSignature)
+                {
+                    return &Archetypes[Index];
+                }
+            }
+            if (ArchetypeCount == MaxArchetypeCount)
+            {
+                return nullptr;
+            }
+            auto Chunks = Arena.PushArray<uint8*>((MaxEntityCount + ChunkCapacity - 1) / ChunkCapacity);
+            if (!Chunks)
+            {
+                return nullptr;
+            }
+            auto& Archetype      = Archetypes[ArchetypeCount++];
+            Archetype.Signature  = ArchetypeSignature;
+            Archetype.Count      = 0;
+            Archetype.ChunkCount = 0;
+            Archetype.Chunks     = Chunks;
+            uint32 Offset        = ChunkCapacity * sizeof(Entity);
+            for (uint32 Component = 0; Component < ComponentCount; ++Component)
+            {
+                Archetype.Offsets[Component] = Offset;
+                if ((ArchetypeSignature >> Component) & 1)
+                {
+                    Offset += (ChunkCapacity * Sizes[Component] + Alignment - 1) & ~(Alignment - 1);
+                }
+            }
+            Archetype.Offsets[ComponentCount] = Offset;
+            return &Archetype;
+        }
+
+        // room for one more entity
+        bool Reserve(ArchetypeData& Archetype)
+        {
+            if (Archetype.Count < Archetype.ChunkCount * ChunkCapacity)
+            {
+                return true;
+            }
+            auto Chunk = static_cast<uint8*>(Arena.Push(Archetype.Offsets[ComponentCount], Alignment));
+            if (!Chunk)
+            {
+                return false;
+            }
+            Archetype.Chunks[Archetype.ChunkCount++] = Chunk;
+            return true;
+        }
+
+        // moves the last row of the archetype into Row
+        void RemoveRow(ArchetypeData& Archetype, uint32 Row)
+        {
+            auto Last = --Archetype.Count;
+            if (Row != Last)
+            {
+                CopyRow(Archetype, Last, Archetype, Row, Archetype.Signature);
+                auto Moved = GetEntities(Archetype, Row) = GetEntities(Archetype, Last);
+                Records[Moved.Index].Row = Row;
+            }
+        }
+
+        static void CopyRow(ArchetypeData& From, uint32 FromRow, ArchetypeData& To, uint32 ToRow, uint64 Copied)
+        {
+            auto Source      = From.Chunks[FromRow / ChunkCapacity];
+            auto Destination = To.Chunks[ToRow / ChunkCapacity];
+            for (uint32 Component = 0; Component < ComponentCount; ++Component)
+            {
+                if ((Copied >> Component) & 1)
+                {
+                    auto Size = Sizes[Component];
+                    memcpy(Destination + To.Offsets[Component] + ToRow % ChunkCapacity * Size,
+                           Source + From.Offsets[Component] + FromRow % ChunkCapacity * Size,
+                           Size);
+                }
+            }
+        }
+
+        bool Move(Entity Handle, uint64 NewSignature)
+        {
+            auto& Target = Records[Handle.Index];
+            auto  From   = &Archetypes[Target.Archetype];
+            auto  To     = FindOrAddArchetype(NewSignature);
+            if (!To || !Reserve(*To))
+            {
+                return false;
+            }
+            auto Row = To->Count++;
+            CopyRow(*From, Target.Row, *To, Row, From->Signature & NewSignature);
+            GetEntities(*To, Row) = Handle;
+            RemoveRow(*From, Target.Row);
+            Target.Archetype = uint32(To - Archetypes);
+            Target.Row       = Row;
+            return true;
+        }
+
+        MemoryArena&  Arena;
+        uint32        MaxEntityCount;
+        Record*       Records;
+        uint32*       FreeIndices;
+        Batch*        Batches; // chunks of a parallel query
+        uint32        IndexCount     = 0; // indices used at least once
+        uint32        FreeCount      = 0;
+        uint32        EntityCount    = 0;
+        uint32        ArchetypeCount = 0;
+        ArchetypeData Archetypes[MaxArchetypeCount];
+    };
+
+} // namespace Game
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "memory_arena.hpp"
+#include "types.hpp"
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Asynchronous reads for the game: requests are submitted in batches during a frame, the platform collects the
+// finished ones at the beginning of the next frame (BeginFrame) and the game reads them from the frame completion
+// queue. Nothing here blocks the frame except OpenForRead/Close, meant for load time.
+
+namespace Game
+{
+    using FileHandle                       = uint32;
+    constexpr FileHandle InvalidFileHandle = 0xFFFFFFFF;
+
+    struct FileReadRequest
+    {
+        FileHandle File;
+        uint32     Size;
+        uint64     Offset;
+        void*      Destination; // must stay valid until completion, see PushRead
+        uint64     UserData;
+    };
+
+    struct FileReadCompletion
+    {
+        uint64 UserData;
+        uint32 BytesRead;
+        bool32 Succeeded;
+    };
+
+    class FileService
+    {
+    public:
+        static constexpr uint32 MaxInFlightCount = 256;
+        static constexpr uint32 MaxFileCount     = 64;
+
+        FileService()                   = default;
+        FileService(const FileService&) = delete; // non copyable
+        virtual ~FileService() {}
+
+        virtual FileHandle OpenForRead(const char* Path, uint64* FileSize) = 0;
+        virtual void       Close(FileHandle File)                          = 0;
+
+        // Never blocks: returns how many requests were accepted, the others must be submitted again later
+        virtual uint32 SubmitReads(const FileReadRequest* Requests, uint32 Count) = 0;
+
+        // Platform only, at frame start: moves the reads finished since the previous call to the frame queue
+        virtual void BeginFrame() = 0;
+
+        // Frame completion queue: stable during the whole frame
+        uint32                    GetCompletionCount() const { return FrameCompletionCount; }
+        const FileReadCompletion& GetCompletion(uint32 Index) const { return FrameCompletions[Index]; }
+
+        uint32 GetInFlightCount() const { return InFlightCount; }
+
+    protected:
+        FileReadCompletion FrameCompletions[MaxInFlightCount];
+        uint32             FrameCompletionCount = 0;
+        uint32             InFlightCount        = 0; // submitted and not yet in a frame queue
+    };
+
+    // Builds a request reading into a buffer pushed on Arena, Destination is null if the arena is full
+    inline FileReadRequest PushRead(MemoryArena& Arena, FileHandle File, uint64 Offset, uint32 Size, uint64 UserData)
+    {
+        return { File, Size, Offset, Arena.Push(Size, 64), UserData };
+    }
+
+    // Portable fallback: blocking reads on worker threads
+    class ThreadPoolFileService final : public FileService
+    {
+    public:
+        explicit ThreadPoolFileService(uint32 ThreadCount = 2)
+        {
+            for (uint32 Index = 0; Index < ThreadCount; ++Index)
+            {
+                Workers.emplace_back([this] { Work(); });
+            }
+        }
+
+        ~ThreadPoolFileService() override
+        {
+            {
+                std::lock_guard<std::mutex> Lock{ Mutex };
+                IsStopping = true;
+            }
+            HasWork.notify_all();
+            for (auto& Worker : Workers)
+            {
+                Worker.join();
+            }
+        }
+
+        FileHandle OpenForRead(const char* Path, uint64* FileSize) override
+        {
+            std::lock_guard<std::mutex> Lock{ Mutex };
+            for (FileHandle File = 0; File < MaxFileCount; ++File)
+            {
+                if (!Files[File].IsOpen)
+                {
+                    auto Stream = OpenStream(Path);
+                    if (!Stream)
+                    {
+                        return InvalidFileHandle;
+                    }
+                    Seek(Stream, 0, SEEK_END);
+                    *FileSize = Tell(Stream);
+                    fclose(Stream);
+
+                    snprintf(Files[File].Path, sizeof(Files[File].Path), "%s", Path);
+                    Files[File].IsOpen = true;
+                    ++Files[File].Generation;
+                    return File;
+                }
+            }
+            return InvalidFileHandle;
+        }
+
+        void Close(FileHandle File) override
+        {
+            std::lock_guard<std::mutex> Lock{ Mutex };
+            if (File < MaxFileCount)
+            {
+                Files[File].IsOpen = false;
+            }
+        }
+
+        uint32 SubmitReads(const FileReadRequest* Requests, uint32 Count) override
+        {
+            uint32 Accepted = 0;
+            {
+                std::lock_guard<std::mutex> Lock{ Mutex };
+                while (Accepted < Count && InFlightCount < MaxInFlightCount)
+                {
+                    Queue[(QueueHead + QueueCount++) % MaxInFlightCount] = Requests[Accepted++];
+                    ++InFlightCount;
+                }
+            }
+            HasWork.notify_all();
+            return Accepted;
+        }
+
+        void BeginFrame() override
+        {
+            std::lock_guard<std::mutex> Lock{ Mutex };
+            for (uint32 Index = 0; Index < FinishedCount; ++Index)
+            {
+                FrameCompletions[Index] = Finished[Index];
+            }
+            FrameCompletionCount = FinishedCount;
+            InFlightCount -= FinishedCount;
+            FinishedCount = 0;
+        }
+
+    private:
+        struct OpenedFile
+        {
+            char   Path[260];
+            uint32 Generation = 0;
+            bool   IsOpen     = false;
+        };
+
+        static FILE* OpenStream(const char* Path)
+        {
+#if _MSC_VER
+            FILE* Stream = nullptr;
+            return fopen_s(&Stream, Path, "rb") == 0 ? Stream : nullptr;
+#else
+            return fopen(Path, "rb");
+#endif
+        }
+
+        static int Seek(FILE* Stream, uint64 Offset, int Origin)
+        {
+#if _MSC_VER
+            return _fseeki64(Stream, static_cast<int64>(Offset), Origin);
+#else
+            return fseeko(Stream, static_cast<off_t>(Offset), Origin);
+#endif
+        }
+
+        static uint64 Tell(FILE* Stream)
+        {
+#if _MSC_VER
+            return static_cast<uint64>(_ftelli64(Stream));
+#else
+            return static_cast<uint64>(ftello(Stream));
+#endif
+        }
+
+        void Work()
+        {
+            // each worker has its own streams, reopened if the handle was reused
+            FILE*  Streams[MaxFileCount]     = {};
+            uint32 Generations[MaxFileCount] = {};
+
+            std::unique_lock<std::mutex> Lock{ Mutex };
+            for (;;)
+            {
+                HasWork.wait(Lock, [this] { return IsStopping || QueueCount; });
+                if (IsStopping)
+                {
+                    break;
+                }
+                auto Request = Queue[QueueHead];
+                QueueHead    = (QueueHead + 1) % MaxInFlightCount;
+                --QueueCount;
+
+                FILE* Stream = nullptr;
+                if (Request.File < MaxFileCount)
+                {
+                    auto& File = Files[Request.File];
+                    Stream     = Streams[Request.File];
+                    if (Stream && Generations[Request.File] != File.Generation)
+                    {
+                        fclose(Stream);
+                        Stream = nullptr;
+                    }
+                    if (!Stream && File.IsOpen)
+                    {
+                        Stream                    = OpenStream(File.Path);
+                        Generations[Request.File] = File.Generation;
+                    }
+                    Streams[Request.File] = Stream;
+                }
+                Lock.unlock();
+
+                FileReadCompletion Completion = { Request.UserData, 0, false };
+                if (Stream && Request.Destination && Seek(Stream, Request.Offset, SEEK_SET) == 0)
+                {
+                    Completion.BytesRead = static_cast<uint32>(fread(Request.Destination, 1, Request.Size, Stream));
+                    Completion.Succeeded = Completion.BytesRead == Request.Size;
+                }
+
+                Lock.lock();
+                Finished[FinishedCount++] = Completion;
+            }
+            for (auto Stream : Streams)
+            {
+                if (Stream)
+                {
+                    fclose(Stream);
+                }
+            }
+        }
+
+        std::mutex               Mutex;
+        std::condition_variable  HasWork;
+        std::vector<std::thread> Workers;
+        bool                     IsStopping = false;
+
+        OpenedFile         Files[MaxFileCount];
+        FileReadRequest    Queue[MaxInFlightCount];
+        uint32             QueueHead  = 0;
+        uint32             QueueCount = 0;
+        FileReadCompletion Finished[MaxInFlightCount];
+        uint32             FinishedCount = 0;
+    };
+
+} // namespace Game
@@ -0,0 +1,304 @@
+#pragma once
+
+#include "hash.hpp"
+#include "memory_arena.hpp"
+
+#include <emmintrin.h>
+
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+// Open addressing hash map in the style of the Swiss tables: one control byte per slot, the slots in groups of 16.
+//
+//   Control[SlotCount]   Empty (0x80), Deleted (0xFE), or the 7 low bits of the hash (H2) of a full slot
+//   Slots[SlotCount]     { Key, Value }, flat
+//
+// A lookup starts at the group given by the high bits of the hash (H1) and compares the 16 control bytes of a group
+// with H2 in one SSE2 instruction: only the slots of the matching bytes read their key, one in 128 by chance. The
+// probe goes on with the next groups in triangular order and stops at a group holding an Empty slot. A removed slot
+// becomes Deleted when its group is full, so that the probes of the other keys go on through it; the tombstones
+// are dropped in place when they fill the table.
+//
+// The map has a fixed capacity, pushed on an arena: no allocation after the construction, nothing to free. Insertion
+// fails when MaxCount keys are stored; the table keeps 1/8 of its slots empty for the probes to end quickly. Keys and
+// values are copied with their assignment and never destroyed, like everything in an arena.
+
+namespace Game
+{
+    // The default hash: std::hash (the identity for the integers) and the avalanche of MixHash
+    template <typename K>
+    struct FlatHash
+    {
+        uint64 operator()(const K& Key) const { return MixHash(uint64(std::hash<K>{}(Key))); }
+    };
+
+    namespace FlatHashMapping
+    {
+        constexpr uint32 GroupSize = 16;
+        constexpr int8   Empty     = -128;
+        constexpr int8   Deleted   = -2;
+
+        inline uint32 FindFirstBit(uint32 Bits) // Bits != 0
+        {
+#if _MSC_VER
+            unsigned long Index;
+            _BitScanForward(&Index, Bits);
+            return Index;
+#else
+            return static_cast<uint32>(__builtin_ctz(Bits));
+#endif
+        }
+
+        // The 16 control bytes of a group, a bit per slot in the masks
+        struct Group
+        {
+            explicit Group(const int8* Control)
+                : Control{ _mm_load_si128(reinterpret_cast<const __m128i*>(Control)) }
+            {}
+
+            uint32 Match(int8 Hash) const
+            {
+                return uint32(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(Hash), Control)));
+            }
+            uint32 MatchEmpty() const { return Match(Empty); }
+            // Empty and Deleted are the only negative bytes
+            uint32 MatchNonFull() const { return uint32(_mm_movemask_epi8(Control)); }
+
+            __m128i Control;
+        };
+
+        // The smallest power of two number of groups holding MaxCount keys at 7/8 of its slots
+        inline uint32 GetGroupCount(uint32 MaxCount)
+        {
+            uint32 GroupCount = 1;
+            while (uint64(GroupCount) * GroupSize * 7 / 8 < MaxCount)
+            {
+                GroupCount *= 2;
+            }
+            return GroupCount;
+        }
+    } // namespace FlatHashMapping
+
+    template <typename K, typename V, typename H = FlatHash<K>>
+    class FlatHashMap final
+    {
+    public:
+        static_assert(std::is_trivially_destructible_v<K> && std::is_trivially_destructible_v<V>,
+                      "the slots live in an arena, they are never destroyed");
+
+        struct Slot
+        {
+            K Key;
+            V Value;
+        };
+
+        // Room for MaxCount keys, IsValid is false if Arena is too small
+        FlatHashMap(MemoryArena& Arena, uint32 MaxCount, const H& Hasher = H{})
+            : Hasher{ Hasher }
+        {
+            auto GroupCount = FlatHashMapping::GetGroupCount(MaxCount);
+            auto SlotCount  = GroupCount * FlatHashMapping::GroupSize;
+            Control         = Arena.PushArray<int8>(SlotCount, 16);
+            Slots           = Arena.PushArray<Slot>(SlotCount, alignof(Slot) > 64 ? alignof(Slot) : 64);
+            if (Control && Slots)
+            {
+                GroupMask = GroupCount - 1;
+                MaxLoad   = SlotCount / 8 * 7;
+                Clear();
+            }
+        }
+        FlatHashMap(const FlatHashMap&) = delete; // non copyable
+
+        bool   IsValid() const { return Slots != nullptr && Control != nullptr && MaxLoad != 0; }
+        uint32 GetCount() const { return Count; }
+        uint32 GetCapacity() const { return MaxLoad; }
+
+        void Clear()
+        {
+            if (Control)
+            {
+                memset(Control, FlatHashMapping::Empty, GetSlotCount());
+            }
+            Count          = 0;
+            TombstoneCount = 0;
+        }
+
+        V* Find(const K& Key) { return const_cast<V*>(static_cast<const FlatHashMap&>(*this).Find(Key)); }
+
+        const V* Find(const K& Key) const
+        {
+            auto Index = FindIndex(Key, Hasher(Key));
+            return Index != NotFound ? &Slots[Index].Value : nullptr;
+        }
+
+        bool Contains(const K& Key) const { return Find(Key) != nullptr; }
+
+        // The value of Key, a value-initialized one when it is new; nullptr when the map is full
+        V* FindOrInsert(const K& Key)
+        {
+            auto Hash  = Hasher(Key);
+            auto Index = FindIndex(Key, Hash);
+            if (Index != NotFound)
+            {
+                return &Slots[Index].Value;
+            }
+            if (Count >= MaxLoad)
+            {
+                return nullptr;
+            }
+            if (Count + TombstoneCount >= MaxLoad)
+            {
+                DropTombstones();
+            }
+            Index = FindFirstNonFull(Hash);
+            TombstoneCount -= Control[Index] == FlatHashMapping::Deleted;
+            ++Count;
+            Control[Index]     = GetH2(Hash);
+            Slots[Index].Key   = Key;
+            Slots[Index].Value = V{};
+            return &Slots[Index].Value;
+        }
+
+        // Inserts or replaces, false when the map is full
+        bool Insert(const K& Key, const V& Value)
+        {
+            auto Stored = FindOrInsert(Key);
+            if (!Stored)
+            {
+                return false;
+            }
+            *Stored = Value;
+            return true;
+        }
+
+        bool Remove(const K& Key)
+        {
+            auto Index = FindIndex(Key, Hasher(Key));
+            if (Index == NotFound)
+            {
+                return false;
+            }
+            // the probes stop at a group holding an Empty slot: a group without one may be on the way to other keys
+            auto Group     = FlatHashMapping::Group{ Control + (Index & ~(FlatHashMapping::GroupSize - 1)) };
+            auto IsEmptied = Group.MatchEmpty() != 0;
+            Control[Index] = IsEmptied ? FlatHashMapping::Empty : FlatHashMapping::Deleted;
+            TombstoneCount += !IsEmptied;
+            --Count;
+            return true;
+        }
+
+        // Function(const K&, V&) for each key, in the order of the slots
+        template <typename F>
+        void ForEach(F&& Function)
+        {
+            for (uint32 Index = 0; IsValid() && Index < GetSlotCount(); ++Index)
+            {
+                if (Control[Index] >= 0)
+                {
+                    Function(static_cast<const K&>(Slots[Index].Key), Slots[Index].Value);
+                }
+            }
+        }
+
+    private:
+        static constexpr uint32 NotFound = ~0u;
+
+        static int8   GetH2(uint64 Hash) { return int8(Hash & 0x7F); }
+        static uint32 GetH1(uint64 Hash) { return uint32(Hash >> 7); }
+
+        uint32 GetSlotCount() const { return (GroupMask + 1) * FlatHashMapping::GroupSize; }
+
+        uint32 FindIndex(const K& Key, uint64 Hash) const
+        {
+            if (!IsValid())
+            {
+                return NotFound;
+            }
+            auto GroupIndex = GetH1(Hash) & GroupMask;
+            for (uint32 Step = 1; Step <= GroupMask + 1; ++Step)
+            {
+                auto Base  = GroupIndex * FlatHashMapping::GroupSize;
+                auto Group = FlatHashMapping::Group{ Control + Base };
+                for (auto Bits = Group.Match(GetH2(Hash)); Bits; Bits &= Bits - 1)
+                {
+                    auto Index = Base + FlatHashMapping::FindFirstBit(Bits);
+                    if (Slots[Index].Key == Key)
+                    {
+                        return Index;
+                    }
+                }
+                if (Group.MatchEmpty())
+                {
+                    return NotFound;
+                }
+                // triangular numbers: every group once for a power of two count
+                GroupIndex = (GroupIndex + Step) & GroupMask;
+            }
+            return NotFound;
+        }
+
+        // an Empty or Deleted slot, there is always one below MaxLoad
+        uint32 FindFirstNonFull(uint64 Hash) const
+        {
+            auto GroupIndex = GetH1(Hash) & GroupMask;
+            for (uint32 Step = 1;; ++Step)
+            {
+                auto Base = GroupIndex * FlatHashMapping::GroupSize;
+                if (auto Bits = FlatHashMapping::Group{ Control + Base }.MatchNonFull())
+                {
+                    return Base + FlatHashMapping::FindFirstBit(Bits);
+                }
+                GroupIndex = (GroupIndex + Step) & GroupMask;
+            }
+        }
+
+        // In place: the full slots are marked Deleted and placed again one by one, the tombstones become Empty
+        void DropTombstones()
+        {
+            for (uint32 Index = 0; Index < GetSlotCount(); ++Index)
+            {
+                Control[Index] = Control[Index] >= 0 ? FlatHashMapping::Deleted : FlatHashMapping::Empty;
+            }
+            for (uint32 Index = 0; Index < GetSlotCount(); ++Index)
+            {
+                if (Control[Index] != FlatHashMapping::Deleted)
+                {
+                    continue;
+                }
+                auto Hash   = Hasher(Slots[Index].Key);
+                auto Target = FindFirstNonFull(Hash);
+                // the groups before Target in the probe are full for good: staying in its group is as good
+                if (Target / FlatHashMapping::GroupSize == Index / FlatHashMapping::GroupSize)
+                {
+                    Control[Index] = GetH2(Hash);
+                    continue;
+                }
+                if (Control[Target] == FlatHashMapping::Empty)
+                {
+                    Slots[Target]  = Slots[Index];
+                    Control[Index] = FlatHashMapping::Empty;
+                }
+                else
+                {
+                    // another slot to place: exchanged, and placed on the next turn
+                    auto Moved    = Slots[Target];
+                    Slots[Target] = Slots[Index];
+                    Slots[Index]  = Moved;
+                    --Index;
+                }
+                Control[Target] = GetH2(Hash);
+            }
+            TombstoneCount = 0;
+        }
+
+        H      Hasher;
+        int8*  Control        = nullptr;
+        Slot*  Slots          = nullptr;
+        uint32 GroupMask      = 0;
+        uint32 MaxLoad        = 0;
+        uint32 Count          = 0;
+        uint32 TombstoneCount = 0;
+    };
+
+} // namespace Game
@@ -0,0 +1,766 @@
+#pragma once
+
+#include "memory_arena.hpp"
+#include "types.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Text formatting without allocation: the format string is parsed at compile time, the arguments are written in a
+// buffer of the caller (a FormatBuffer, a char array or a MemoryArena), truncated when it is full.
+//
+//     char Text[64];
+//     auto Line = Game::Format(Text, GAME_FORMAT_STRING("{:.2f} ms/f, {} fps"), MillisecondsPerFrame, Fps);
+//
+// The placeholders are sequential, "{}" or "{:spec}" with spec [[fill]align][+][0][width][.precision][type]:
+//     align   < > ^ (numbers to the right, the rest to the left)
+//     type    integers d x X b, floats f e g, strings s (precision truncates), char c, pointers p
+// "{{" and "}}" are braces. A malformed string, a wrong number of arguments or a type which does not fit its argument
+// fail to compile. Other types are written by a FormatValue(FormatBuffer&, const T&, const FormatSpec&) found by ADL.
+//
+// Integers are written two digits at a time. Floats: f is exact, as printf, up to 9 decimals (zeros after), e rounds
+// the mantissa to at most 16 digits, the default is f with up to 6 decimals, trailing zeros removed, or e out of
+// [1e-5, 1e15). Fast rather than round trip exact. No locale: usable from a signal handler.
+
+#define GAME_FORMAT_STRING(_TEXT_)                                                                                     \
+    ([] {                                                                                                              \
+        struct FormatString_ : Game::Formatting::FormatString                                                          \
+        {                                                                                                              \
+            static constexpr std::string_view Get() { return _TEXT_; }                                                 \
+        };                                                                                                             \
+        return FormatString_{};                                                                                        \
+    }())
+
+namespace Game
+{
+    // Bytes written in a fixed buffer, the overflow is dropped
+    struct FormatBuffer
+    {
+        char*  Data;
+        uint32 Capacity;
+        uint32 Size        = 0;
+        bool   IsTruncated = false;
+
+        void Append(char Character)
+        {
+            if (Size < Capacity)
+            {
+                Data[Size++] = Character;
+                return;
+            }
+            IsTruncated = true;
+        }
+
+        void Append(const char* Text, uint64 Count)
+        {
+            auto Copied = Count <= Capacity - Size ? uint32(Count) : Capacity - Size;
+            memcpy(Data + Size, Text, Copied);
+            Size += Copied;
+            IsTruncated |= Copied < Count;
+        }
+
+        void Append(char Character, uint32 Count)
+        {
+            auto Copied = Count <= Capacity - Size ? Count : Capacity - Size;
+            memset(Data + Size, Character, Copied);
+            Size += Copied;
+            IsTruncated |= Copied < Count;
+        }
+
+        std::string_view GetText() const { return { Data, Size }; }
+    };
+
+    namespace Formatting
+    {
+        constexpr uint32 MaxItemCount     = 32; // literal texts and placeholders
+        constexpr uint32 MaxArgumentCount = 16;
+
+        // base of the types made by GAME_FORMAT_STRING
+        struct FormatString
+        {
+        };
+
+        struct FormatSpec
+        {
+            char   Fill        = ' ';
+            char   Align       = 0; // default: numbers to the right
+            bool   IsSigned    = false;
+            bool   IsZeroPadded = false;
+            uint16 Width       = 0;
+            int16  Precision   = -1;
+            char   Type        = 0;
+        };
+
+        struct FormatItem
+        {
+            uint32     Offset   = 0;
+            uint32     Length   = 0;
+            int32      Argument = -1; // literal text
+            FormatSpec Spec     = {};
+        };
+
+        struct ParsedFormat
+        {
+            FormatItem Items[MaxItemCount] = {};
+            FormatSpec Specs[MaxArgumentCount] = {};
+            uint32     ItemCount     = 0;
+            uint32     ArgumentCount = 0;
+            bool       IsValid       = true;
+        };
+
+        constexpr bool IsDigit(char Character)
+        {
+            return Character >= '0' && Character <= '9';
+        }
+
+        constexpr bool IsAlign(char Character)
+        {
+            return Character == '<' || Character == '>' || Character == '^';
+        }
+
+        // the text between ':' and '}'
+        constexpr bool ParseSpec(std::string_view Text, FormatSpec& Spec)
+        {
+            size_t Index = 0;
+            if (Text.size() >= 2 && IsAlign(Text[1]))
+            {
+                Spec.Fill  = Text[0];
+                Spec.Align = Text[1];
+                Index      = 2;
+            }
+            else if (!Text.empty() && IsAlign(Text[0]))
+            {
+                Spec.Align = Text[0];
+                Index      = 1;
+            }
+            if (Index < Text.size() && Text[Index] == '+')
+            {
+                Spec.IsSigned = true;
+                ++Index;
+            }
+            if (Index < Text.size() && Text[Index] == '0')
+            {
+                Spec.IsZeroPadded = true;
+                ++Index;
+            }
+            uint32 Width = 0;
+            for (; Index < Text.size() && IsDigit(Text[Index]) && Width < 1000; ++Index)
+            {
+                Width = Width * 10 + uint32(Text[Index] - '0');
+            }
+            Spec.Width = uint16(Width);
+            if (Index < Text.size() && Text[Index] == '.')
+            {
+                uint32 Precision = 0;
+                auto   Start     = ++Index;
+                for (; Index < Text.size() && IsDigit(Text[Index]) && Precision < 1000; ++Index)
+                {
+                    Precision = Precision * 10 + uint32(Text[Index] - '0');
+                }
+                if (Index == Start)
+                {
+                    return false;
+                }
+                Spec.Precision = int16(Precision);
+            }
+            if (Index < Text.size())
+            {
+                Spec.Type = Text[Index++];
+                if (std::string_view{ "dxXbfegscp" }.find(Spec.Type) == std::string_view::npos)
+                {
+                    return false;
+                }
+            }
+            return Index == Text.size() && Width < 1000;
+        }
+
+        constexpr ParsedFormat Parse(std::string_view Format)
+        {
+            ParsedFormat Result;
+            auto         AddItem = [&Result](uint32 Offset, uint32 Length, int32 Argument) {
+                if (Result.ItemCount == MaxItemCount)
+                {
+                    Result.IsValid = false;
+                    return false;
+                }
+                auto& Item    = Result.Items[Result.ItemCount++];
+                Item.Offset   = Offset;
+                Item.Length   = Length;
+                Item.Argument = Argument;
+                return true;
+            };
+
+            uint32 Start = 0;
+            for (uint32 Index = 0; Index < Format.size() && Result.IsValid; ++Index)
+            {
+                auto Character = Format[Index];
+                if (Character != '{' && Character != '}')
+                {
+                    continue;
+                }
+                if (Index + 1 < Format.size() && Format[Index + 1] == Character)
+                {
+                    // an escaped brace: the text up to the first one, the second one skipped
+                    AddItem(Start, Index + 1 - Start, -1);
+                    Start = ++Index + 1;
+                    continue;
+                }
+                auto End = Format.find('}', Index);
+                if (Character == '}' || End == std::string_view::npos || Result.ArgumentCount == MaxArgumentCount)
+                {
+                    Result.IsValid = false;
+                    break;
+                }
+                if (Index > Start)
+                {
+                    AddItem(Start, Index - Start, -1);
+                }
+
+                auto       Inside = Format.substr(Index + 1, End - Index - 1);
+                FormatSpec Spec;
+                if (!Inside.empty() && (Inside[0] != ':' || !ParseSpec(Inside.substr(1), Spec)))
+                {
+                    Result.IsValid = false;
+                    break;
+                }
+                if (AddItem(Index, End + 1 - Index, int32(Result.ArgumentCount)))
+                {
+                    Result.Items[Result.ItemCount - 1].Spec = Spec;
+                    Result.Specs[Result.ArgumentCount++]    = Spec;
+                }
+                Index = uint32(End);
+                Start = Index + 1;
+            }
+            if (Start < Format.size() && Result.IsValid)
+            {
+                AddItem(Start, uint32(Format.size()) - Start, -1);
+            }
+            return Result;
+        }
+
+        enum class Category
+        {
+            Integer,
+            Float,
+            Boolean,
+            Character,
+            String,
+            Pointer,
+            Custom
+        };
+
+        template <typename T>
+        constexpr Category GetCategory()
+        {
+            using U = std::decay_t<T>;
+            if constexpr (std::is_same_v<U, bool>)
+                return Category::Boolean;
+            else if constexpr (std::is_same_v<U, char>)
+                return Category::Character;
+            else if constexpr (std::is_integral_v<U> || std::is_enum_v<U>)
+                return Category::Integer;
+            else if constexpr (std::is_floating_point_v<U>)
+                return Category::Float;
+            else if constexpr (std::is_null_pointer_v<U>)
+                return Category::Pointer;
+            else if constexpr (std::is_convertible_v<const U&, std::string_view> || std::is_same_v<U, char*>)
+                return Category::String;
+            else if constexpr (std::is_pointer_v<U>)
+                return Category::Pointer;
+            else
+                return Category::Custom;
+        }
+
+        constexpr bool IsCompatible(Category Kind, const FormatSpec& Spec)
+        {
+            auto HasType = [&Spec](const char* Types) {
+                return !Spec.Type || std::string_view{ Types }.find(Spec.Type) != std::string_view::npos;
+            };
+            switch (Kind)
+            {
+            case Category::Integer:
+                return HasType("dxXbc") && Spec.Precision < 0;
+            case Category::Float:
+                return HasType("feg");
+            case Category::Boolean:
+                return HasType("sd") && Spec.Precision < 0;
+            case Category::Character:
+                return HasType("cdxX") && Spec.Precision < 0;
+            case Category::String:
+                return HasType("s");
+            case Category::Pointer:
+                return HasType("p") && Spec.Precision < 0;
+            default:
+                return true;
+            }
+        }
+
+        template <typename S>
+        struct Parsed
+        {
+            static constexpr ParsedFormat Value = Parse(S::Get());
+        };
+
+        template <typename S, typename... A, size_t... I>
+        constexpr bool AreCompatible(std::index_sequence<I...>)
+        {
+            return (IsCompatible(GetCategory<A>(), Parsed<S>::Value.Specs[I]) && ...);
+        }
+
+        // Fails to compile when the arguments do not fit the format string
+        template <typename S, typename... A>
+        constexpr bool Check()
+        {
+            static_assert(std::is_base_of_v<FormatString, S>, "use GAME_FORMAT_STRING");
+            static_assert(Parsed<S>::Value.IsValid, "malformed format string");
+            static_assert(Parsed<S>::Value.ArgumentCount == sizeof...(A), "the format string takes another count");
+            static_assert(AreCompatible<S, A...>(std::index_sequence_for<A...>{}), "a spec does not fit its argument");
+            return true;
+        }
+
+        // The characters of Value, backwards from End
+        inline char* WriteDecimal(char* End, uint64 Value)
+        {
+            static constexpr char Pairs[] = "0001020304050607080910111213141516171819"
+                                            "2021222324252627282930313233343536373839"
+                                            "4041424344454647484950515253545556575859"
+                                            "6061626364656667686970717273747576777879"
+                                            "8081828384858687888990919293949596979899";
+            while (Value >= 100)
+            {
+                auto Pair = uint32(Value % 100) * 2;
+                Value /= 100;
+                End -= 2;
+                memcpy(End, Pairs + Pair, 2);
+            }
+            if (Value >= 10)
+            {
+                End -= 2;
+                memcpy(End, Pairs + Value * 2, 2);
+            }
+            else
+            {
+                *--End = char('0' + Value);
+            }
+            return End;
+        }
+
+        inline char* WriteBase(char* End, uint64 Value, uint32 Shift, bool IsUpper)
+        {
+            auto Digits = IsUpper ? "0123456789ABCDEF" : "0123456789abcdef";
+            auto Mask   = (uint64(1) << Shift) - 1;
+            do
+            {
+                *--End = Digits[Value & Mask];
+                Value >>= Shift;
+            } while (Value);
+            return End;
+        }
+
+        // Width and alignment of the text written from Start: moved and filled in place, the zeros of "0" go after
+        // the sign and the prefix (Skip characters)
+        inline void Pad(FormatBuffer& Out, uint32 Start, const FormatSpec& Spec, char DefaultAlign, uint32 Skip = 0)
+        {
+            auto Written = Out.Size - Start;
+            if (Spec.Width <= Written)
+            {
+                return;
+            }
+            auto Count = Spec.Width - Written;
+            auto Align = Spec.Align ? Spec.Align : DefaultAlign;
+            auto Fill  = Spec.Fill;
+            if (Spec.IsZeroPadded && !Spec.Align)
+            {
+                Align = '=';
+                Fill  = '0';
+            }
+            auto Before = Align == '>' ? Count : Align == '^' ? Count / 2 : Align == '=' ? Count : 0;
+            auto After  = Count - Before;
+            Out.Append(Fill, Count);
+            if (Out.IsTruncated)
+            {
+                return;
+            }
+            auto Moved = Align == '=' ? Start + Skip : Start;
+            memmove(Out.Data + Moved + Before, Out.Data + Moved, Written - (Moved - Start));
+            memset(Out.Data + Moved, Fill, Before);
+            memset(Out.Data + Out.Size - After, Fill, After);
+        }
+
+        inline void WriteInteger(FormatBuffer& Out, uint64 Magnitude, bool IsNegative, const FormatSpec& Spec)
+        {
+            char   Text[72];
+            auto   End   = Text + sizeof(Text);
+            char*  Begin = nullptr;
+            uint32 Skip  = 0;
+            switch (Spec.Type)
+            {
+            case 'x':
+            case 'X':
+                Begin = WriteBase(End, Magnitude, 4, Spec.Type == 'X');
+                break;
+            case 'b':
+                Begin = WriteBase(End, Magnitude, 1, false);
+                break;
+            default:
+                Begin = WriteDecimal(End, Magnitude);
+            }
+            if (IsNegative || Spec.IsSigned)
+            {
+                *--Begin = IsNegative ? '-' : '+';
+                Skip     = 1;
+            }
+            auto Start = Out.Size;
+            Out.Append(Begin, uint64(End - Begin));
+            Pad(Out, Start, Spec, '>', Skip);
+        }
+
+        template <typename T>
+        void WriteInteger(FormatBuffer& Out, T Value, const FormatSpec& Spec)
+        {
+            if constexpr (std::is_enum_v<T>)
+            {
+                WriteInteger(Out, std::underlying_type_t<T>(Value), Spec);
+            }
+            else if constexpr (std::is_signed_v<T>)
+            {
+                auto IsNegative = Value < 0;
+                WriteInteger(Out, IsNegative ? 0 - uint64(Value) : uint64(Value), IsNegative, Spec);
+            }
+            else
+            {
+                WriteInteger(Out, uint64(Value), false, Spec);
+            }
+        }
+
+        // the digits of Value < 10^Count, zeros in front
+        inline void WriteDigits(char* Text, uint64 Value, uint32 Count)
+        {
+            auto Begin = WriteDecimal(Text + Count, Value);
+            memset(Text, '0', size_t(Begin - Text));
+        }
+
+        constexpr uint64 PowersOf10[] = { 1ULL,
+                                          10ULL,
+                                          100ULL,
+                                          1000ULL,
+                                          10000ULL,
+                                          100000ULL,
+                                          1000000ULL,
+                                          10000000ULL,
+                                          100000000ULL,
+                                          1000000000ULL,
+                                          10000000000ULL,
+                                          100000000000ULL,
+                                          1000000000000ULL,
+                                          10000000000000ULL,
+                                          100000000000000ULL,
+                                          1000000000000000ULL,
+                                          10000000000000000ULL,
+                                          100000000000000000ULL };
+
+        // ties to even, like printf: the exact halves of the binary values stay halves
+        inline uint64 Round(double Value)
+        {
+            auto Floor = std::floor(Value);
+            auto Rest  = Value - Floor;
+            auto Lower = uint64(Floor);
+            return Lower + (Rest > 0.5 || (Rest == 0.5 && (Lower & 1)));
+        }
+
+        // Value * 10^Exponent, one rounding while 10^Exponent is exact (up to 1e22)
+        inline double Scale(double Value, int32 Exponent)
+        {
+            constexpr double Exact[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+            for (; Exponent > 22; Exponent -= 22)
+            {
+                Value *= 1e22;
+            }
+            for (; Exponent < -22; Exponent += 22)
+            {
+                Value /= 1e22;
+            }
+            return Exponent >= 0 ? Value * Exact[Exponent] : Value / Exact[-Exponent];
+        }
+
+        // Magnitude >= 0 and finite, Text holds 96 characters; IsTrimmed removes the zeros at the end of the
+        // decimals. 0 when Magnitude is too large for the integer path. The integer part and the fraction split
+        // exactly; the scaled fraction is rounded once, its remainder against the half checked exactly with fma.
+        inline uint32 WriteFixed(char* Text, double Magnitude, uint32 Precision, bool IsTrimmed)
+        {
+            if (Magnitude >= 1.8e19)
+            {
+                return 0; // as e
+            }
+            Precision     = Precision < 64 ? Precision : 64;
+            auto Decimals = Precision < 9 ? Precision : 9;
+            auto Integer  = uint64(Magnitude);
+            auto Rest     = Magnitude - double(Integer);
+            auto Scale    = double(PowersOf10[Decimals]);
+            auto Fraction = uint64(Rest * Scale); // the product rounded: one over at most
+            if (std::fma(Rest, Scale, -double(Fraction)) < 0)
+            {
+                --Fraction;
+            }
+            auto Half = std::fma(Rest, Scale, -(double(Fraction) + 0.5));
+            Fraction += Half > 0 || (Half == 0 && ((Decimals ? Fraction : Integer) & 1));
+            if (Fraction == PowersOf10[Decimals])
+            {
+                Fraction = 0;
+                ++Integer;
+            }
+            char   Digits[24];
+            auto   Begin = WriteDecimal(Digits + sizeof(Digits), Integer);
+            uint32 Size  = uint32(Digits + sizeof(Digits) - Begin);
+            memcpy(Text, Begin, Size);
+            if (IsTrimmed)
+            {
+                for (; Decimals && Fraction % 10 == 0; --Decimals)
+                {
+                    Fraction /= 10;
+                }
+                Precision = Decimals;
+            }
+            if (Precision)
+            {
+                Text[Size++] = '.';
+                WriteDigits(Text + Size, Fraction, Decimals);
+                memset(Text + Size + Decimals, '0', Precision - Decimals);
+                Size += Precision;
+            }
+            return Size;
+        }
+
+        inline uint32 WriteExponent(char* Text, double Magnitude, uint32 Precision, bool IsTrimmed)
+        {
+            Precision       = Precision < 16 ? Precision : 16;
+            int32  Exponent = Magnitude == 0 ? 0 : int32(std::floor(std::log10(Magnitude)));
+            uint64 Digits   = 0;
+            for (uint32 Try = 0; Magnitude != 0 && Try < 3; ++Try)
+            {
+                // Precision + 1 digits, the estimate of the exponent may be one off
+                Digits = Round(Scale(Magnitude, int32(Precision) - Exponent));
+                if (Digits >= PowersOf10[Precision + 1])
+                {
+                    ++Exponent;
+                }
+                else if (Digits < PowersOf10[Precision])
+                {
+                    --Exponent;
+                }
+                else
+                {
+                    break;
+                }
+            }
+            auto Leading  = Digits / PowersOf10[Precision];
+            auto Fraction = Digits % PowersOf10[Precision];
+            if (IsTrimmed)
+            {
+                for (; Precision && Fraction % 10 == 0; --Precision)
+                {
+                    Fraction /= 10;
+                }
+            }
+            uint32 Size = 0;
+            Text[Size++] = char('0' + Leading);
+            if (Precision)
+            {
+                Text[Size++] = '.';
+                WriteDigits(Text + Size, Fraction, Precision);
+                Size += Precision;
+            }
+            Text[Size++] = 'e';
+            Text[Size++] = Exponent < 0 ? '-' : '+';
+            auto Absolute = uint32(Exponent < 0 ? -Exponent : Exponent);
+            WriteDigits(Text + Size, Absolute, Absolute >= 100 ? 3 : 2);
+            return Size + (Absolute >= 100 ? 3 : 2);
+        }
+
+        inline void WriteFloat(FormatBuffer& Out, double Value, const FormatSpec& Spec)
+        {
+            char   Text[96];
+            uint32 Size       = 0;
+            auto   IsNegative = std::signbit(Value);
+            auto   Magnitude  = std::fabs(Value);
+            if (Value != Value)
+            {
+                memcpy(Text + 1, "nan", 3);
+                Size = 3;
+            }
+            else if (Magnitude > 1.7976931348623157e308)
+            {
+                memcpy(Text + 1, "inf", 3);
+                Size = 3;
+            }
+            else if (Spec.Type == 'e')
+            {
+                Size = WriteExponent(Text + 1, Magnitude, Spec.Precision < 0 ? 6 : uint32(Spec.Precision), false);
+            }
+            else if (Spec.Type == 'f')
+            {
+                Size = WriteFixed(Text + 1, Magnitude, Spec.Precision < 0 ? 6 : uint32(Spec.Precision), false);
+            }
+            else if (Magnitude == 0 || (Magnitude >= 1e-5 && Magnitude < 1e15))
+            {
+                Size = WriteFixed(Text + 1, Magnitude, Spec.Precision < 0 ? 6 : uint32(Spec.Precision), true);
+            }
+            if (!Size)
+            {
+                auto IsTrimmed = Spec.Type != 'e' && Spec.Type != 'f';
+                Size = WriteExponent(Text + 1, Magnitude, Spec.Precision < 0 ? 6 : uint32(Spec.Precision), IsTrimmed);
+            }
+
+            auto Begin = Text + 1;
+            if (IsNegative || Spec.IsSigned)
+            {
+                *--Begin = IsNegative ? '-' : '+';
+                ++Size;
+            }
+            auto Start = Out.Size;
+            Out.Append(Begin, Size);
+            Pad(Out, Start, Spec, '>', Begin == Text ? 1 : 0);
+        }
+
+        inline void WriteString(FormatBuffer& Out, std::string_view Value, const FormatSpec& Spec)
+        {
+            if (Spec.Precision >= 0 && Value.size() > uint32(Spec.Precision))
+            {
+                Value = Value.substr(0, uint32(Spec.Precision));
+            }
+            auto Start = Out.Size;
+            Out.Append(Value.data(), Value.size());
+            Pad(Out, Start, Spec, '<');
+        }
+
+        inline void WritePointer(FormatBuffer& Out, uintptr_t Value, const FormatSpec& Spec)
+        {
+            char Text[24];
+            auto End   = Text + sizeof(Text);
+            auto Begin = WriteBase(End, Value, 4, false);
+            *--Begin   = 'x';
+            *--Begin   = '0';
+            auto Start = Out.Size;
+            Out.Append(Begin, uint64(End - Begin));
+            Pad(Out, Start, Spec, '>', 2);
+        }
+
+        template <typename T>
+        void WriteArgument(FormatBuffer& Out, const T& Value, const FormatSpec& Spec)
+        {
+            constexpr auto Kind = GetCategory<T>();
+            if constexpr (Kind == Category::Integer)
+            {
+                if (Spec.Type == 'c')
+                {
+                    auto Character = static_cast<char>(Value);
+                    return WriteString(Out, { &Character, 1 }, Spec);
+                }
+                WriteInteger(Out, Value, Spec);
+            }
+            else if constexpr (Kind == Category::Float)
+            {
+                WriteFloat(Out, double(Value), Spec);
+            }
+            else if constexpr (Kind == Category::Boolean)
+            {
+                Spec.Type == 'd' ? WriteInteger(Out, uint32(Value), Spec)
+                                 : WriteString(Out, Value ? "true" : "false", Spec);
+            }
+            else if constexpr (Kind == Category::Character)
+            {
+                Spec.Type && Spec.Type != 'c' ? WriteInteger(Out, uint32(uint8(Value)), Spec)
+                                              : WriteString(Out, { &Value, 1 }, Spec);
+            }
+            else if constexpr (Kind == Category::String)
+            {
+                if constexpr (std::is_array_v<T>)
+                {
+                    WriteString(Out, { Value, strnlen(Value, std::extent_v<T>) }, Spec);
+                }
+                else if constexpr (std::is_pointer_v<T>)
+                {
+                    WriteString(Out, Value ? std::string_view{ Value } : std::string_view{ "(null)" }, Spec);
+                }
+                else
+                {
+                    WriteString(Out, std::string_view{ Value }, Spec);
+                }
+            }
+            else if constexpr (Kind == Category::Pointer)
+            {
+                WritePointer(Out, reinterpret_cast<uintptr_t>(static_cast<const void*>(Value)), Spec);
+            }
+            else
+            {
+                FormatValue(Out, Value, Spec);
+            }
+        }
+
+        template <typename S, size_t I, typename Tuple>
+        void WriteItem(FormatBuffer& Out, const Tuple& Arguments)
+        {
+            constexpr auto& Item = Parsed<S>::Value.Items[I];
+            if constexpr (Item.Argument < 0)
+            {
+                Out.Append(S::Get().data() + Item.Offset, Item.Length);
+            }
+            else
+            {
+                WriteArgument(Out, std::get<Item.Argument>(Arguments), Item.Spec);
+            }
+        }
+
+        template <typename S, typename Tuple, size_t... I>
+        void WriteItems(FormatBuffer& Out, const Tuple& Arguments, std::index_sequence<I...>)
+        {
+            (WriteItem<S, I>(Out, Arguments), ...);
+        }
+    } // namespace Formatting
+
+    using Formatting::FormatSpec;
+
+    // Appends to Out
+    template <typename S, typename... A>
+    void Format(FormatBuffer& Out, S, const A&... Arguments)
+    {
+        static_assert(Formatting::Check<S, A...>());
+        Formatting::WriteItems<S>(Out, std::forward_as_tuple(Arguments...),
+                                  std::make_index_sequence<Formatting::Parsed<S>::Value.ItemCount>{});
+    }
+
+    // Writes in Buffer, null terminated, truncated if need be
+    template <uint32 N, typename S, typename... A>
+    std::string_view Format(char (&Buffer)[N], S FormatString, const A&... Arguments)
+    {
+        static_assert(N > 0);
+        FormatBuffer Out = { Buffer, N - 1 };
+        Format(Out, FormatString, Arguments...);
+        Buffer[Out.Size] = 0;
+        return Out.GetText();
+    }
+
+    // Pushes the text, null terminated, on Arena: empty if it does not fit
+    template <typename S, typename... A>
+    std::string_view Format(MemoryArena& Arena, S FormatString, const A&... Arguments)
+    {
+        auto         Remaining = Arena.GetRemaining();
+        FormatBuffer Out       = { reinterpret_cast<char*>(Arena.Base + Arena.Used),
+                             uint32(Remaining > 0xFFFFFFFF ? 0xFFFFFFFF : Remaining) };
+        Format(Out, FormatString, Arguments...);
+        if (Out.IsTruncated || Out.Size == Out.Capacity)
+        {
+            return {};
+        }
+        Out.Data[Out.Size] = 0;
+        Arena.Push(Out.Size + 1, 1);
+        return Out.GetText();
+    }
+
+} // namespace Game
@@ -34,21 +34,25 @@ inline auto __builtin_trap()
 {
     return __debugbreak();
 }
+#else // gcc: only used to build the SDK tests and benchmarks
+#define IS_CLANG 0
+#define IS_MSVC 0
+#endif
+
+#ifndef ENABLE_ASSERT
+#define ENABLE_ASSERT 0
 #endif
 
 inline void PIDebugBreak()
 {
-    if constexpr (IS_CLANG)
-    {
-        __builtin_trap();
-    }
-    else if constexpr (IS_MSVC)
-    {
-        __debugbreak();
-    }
+#if IS_MSVC
+    __debugbreak();
+#else
+    __builtin_trap();
+#endif
 }
 
-inline void Check(bool _condition)
+inline void Check([[maybe_unused]] bool _condition)
 {
 #if ENABLE_ASSERT
     if (!_condition)
@@ -87,6 +91,12 @@ struct PIBackBuffer
 
 namespace Game
 {
+    class AssetPack;
+    class FileService;
+    class JobSystem;
+    class MetricRegistry;
+    class StringTable;
+
     struct Memory
     {
         Memory(const Memory&) = delete; // non copyable
@@ -101,6 +111,21 @@ namespace Game
         // REQUIRED to be cleared to zero at startup
         void* TransientStorage = nullptr;
 
+        // memory-mapped asset pack, null if there is none (see asset_pack.hpp)
+        const AssetPack* Assets = nullptr;
+
+        // asynchronous reads, completions are collected before each update (see file_service.hpp)
+        FileService* Files = nullptr;
+
+        // worker threads for parallel loops in the frame (see job_system.hpp)
+        JobSystem* Jobs = nullptr;
+
+        // interned strings of the engine, set as the table of the game dll (see interned_string.hpp)
+        StringTable* Strings = nullptr;
+
+        // counters, gauges and histograms of the process, written to a time series file (see metrics.hpp)
+        MetricRegistry* Metrics = nullptr;
+
     protected:
         Memory(uint64 PermanentStorageSize, uint64 TransientStorageSize)
             : PermanentStorageSize{ PermanentStorageSize }
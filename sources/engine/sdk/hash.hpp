@@ -0,0 +1,32 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+
+namespace Game
+{
+    // Final avalanche of MurmurHash3: spreads the entropy of all bits on the low bits
+    constexpr uint64 MixHash(uint64 Value)
+    {
+        Value ^= Value >> 33;
+        Value *= 0xFF51AFD7ED558CCDULL;
+        Value ^= Value >> 33;
+        Value *= 0xC4CEB9FE1A85EC53ULL;
+        Value ^= Value >> 33;
+        return Value;
+    }
+
+    // FNV-1a 64 bits, usable at compile time, Seed gives independent hash functions
+    constexpr uint64 HashBytes(const char* Bytes, size_t Length, uint64 Seed = 0)
+    {
+        uint64 Hash = 0xCBF29CE484222325ULL ^ MixHash(Seed);
+        for (size_t Index = 0; Index < Length; ++Index)
+        {
+            Hash ^= static_cast<uint8>(Bytes[Index]);
+            Hash *= 0x100000001B3ULL;
+        }
+        return MixHash(Hash);
+    }
+
+} // namespace Game
@@ -0,0 +1,254 @@
+#pragma once
+
+#include "game.hpp"
+#include "hash.hpp"
+#include "memory_arena.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+
+// Interned strings: every distinct text is stored once in a StringTable, an InternedString is the pointer to it.
+// Equality is a pointer compare, the hash (HashBytes, seed 0, the one of the asset pack) is stored with the text and
+// the text stays null terminated, so c_str() and the std::string_view are free.
+//
+//   InternedString Name{ "player" };                // hashed and looked up in the global table
+//   InternedString Copy{ std::string{ "player" } }; // Copy == Name is one compare
+//   auto           Fast = GAME_INTERN("player");    // hashed at compile time, looked up once per call site
+//
+// The table is lock free: open addressing over atomic slots, a new text is copied in the pool first and published
+// by a compare-exchange of an empty slot. Two threads interning the same new text race on the slot, the loser uses
+// the winner and its copy is lost in the pool. Nothing is ever removed: size the table for the names of the game.
+//
+// The global table (SetStringTable) is a pointer per module: the engine owns the table and gives it to the game dll
+// in Game::Memory, the strings stay valid across the reloads of the dll.
+
+namespace Game
+{
+    namespace Interning
+    {
+        // followed by Length characters and a null
+        struct Entry
+        {
+            uint64 Hash;
+            uint32 Length;
+            uint32 Padding;
+
+            const char* GetText() const { return reinterpret_cast<const char*>(this + 1); }
+        };
+    } // namespace Interning
+
+    // A text with its hash, constexpr from a literal: constexpr StringKey Key{ "name" } costs nothing at run time
+    struct StringKey
+    {
+        constexpr StringKey(std::string_view Text)
+            : Text{ Text }
+            , Hash{ HashBytes(Text.data(), Text.size()) }
+        {}
+        constexpr StringKey(const char* Text)
+            : StringKey{ std::string_view{ Text } }
+        {}
+        StringKey(const std::string& Text)
+            : StringKey{ std::string_view{ Text } }
+        {}
+
+        std::string_view Text;
+        uint64           Hash;
+    };
+
+    class StringTable final
+    {
+    public:
+        // SlotCount is a power of two, up to 3/4 of it is used; TextSize bytes hold the entries and their texts
+        StringTable(MemoryArena& Arena, uint32 SlotCount, uint64 TextSize)
+            : Slots{ static_cast<std::atomic<const Interning::Entry*>*>(
+                  Arena.Push(sizeof(std::atomic<const Interning::Entry*>) * SlotCount, 64)) }
+            , Pool{ Arena.PushArray<uint8>(TextSize, 64) }
+            , Mask{ Slots && Pool && (SlotCount & (SlotCount - 1)) == 0 ? SlotCount - 1 : 0 }
+            , PoolSize{ Pool ? TextSize : 0 }
+        {
+            for (uint32 Slot = 0; Mask && Slot <= Mask; ++Slot)
+            {
+                new (Slots + Slot) std::atomic<const Interning::Entry*>{ nullptr };
+            }
+        }
+        StringTable(const StringTable&) = delete; // non copyable
+
+        bool IsValid() const { return Mask != 0; }
+
+        // The entry of Key.Text, added when missing; nullptr when the table or its pool is full
+        const Interning::Entry* Intern(const StringKey& Key)
+        {
+            if (!IsValid())
+            {
+                return nullptr;
+            }
+            const Interning::Entry* Fresh = nullptr;
+            for (uint32 Probe = 0, Slot = uint32(Key.Hash) & Mask; Probe <= Mask; ++Probe, Slot = (Slot + 1) & Mask)
+            {
+                auto Current = Slots[Slot].load(std::memory_order_acquire);
+                if (!Current)
+                {
+                    if (!Fresh && !(Fresh = Allocate(Key)))
+                    {
+                        return nullptr;
+                    }
+                    if (Slots[Slot].compare_exchange_strong(Current, Fresh, std::memory_order_acq_rel))
+                    {
+                        Count.fetch_add(1, std::memory_order_relaxed);
+                        return Fresh;
+                    }
+                    // Current is the text of another thread, maybe ours
+                }
+                if (IsEqual(Current, Key))
+                {
+                    return Current;
+                }
+            }
+            return nullptr;
+        }
+
+        // No insertion: nullptr when Key.Text was never interned
+        const Interning::Entry* Find(const StringKey& Key) const
+        {
+            for (uint32 Probe = 0, Slot = uint32(Key.Hash) & Mask; IsValid() && Probe <= Mask;
+                 ++Probe, Slot = (Slot + 1) & Mask)
+            {
+                auto Current = Slots[Slot].load(std::memory_order_acquire);
+                if (!Current)
+                {
+                    return nullptr;
+                }
+                if (IsEqual(Current, Key))
+                {
+                    return Current;
+                }
+            }
+            return nullptr;
+        }
+
+        uint32 GetCount() const { return Count.load(std::memory_order_relaxed); }
+        uint64 GetPoolUsed() const { return PoolUsed.load(std::memory_order_relaxed); }
+
+    private:
+        static bool IsEqual(const Interning::Entry* Entry, const StringKey& Key)
+        {
+            return Entry->Hash == Key.Hash && Entry->Length == Key.Text.size() &&
+                   memcmp(Entry->GetText(), Key.Text.data(), Key.Text.size()) == 0;
+        }
+
+        const Interning::Entry* Allocate(const StringKey& Key)
+        {
+            // the probes stay short below 3/4 of the slots
+            if (GetCount() >= (Mask + 1) / 4 * 3)
+            {
+                return nullptr;
+            }
+            // reserved only when it fits: a text too long leaves the pool to the next ones
+            auto Size   = (sizeof(Interning::Entry) + Key.Text.size() + 1 + 7) & ~uint64(7);
+            auto Offset = PoolUsed.load(std::memory_order_relaxed);
+            do
+            {
+                if (Size > PoolSize - Offset)
+                {
+                    return nullptr;
+                }
+            } while (!PoolUsed.compare_exchange_weak(Offset, Offset + Size, std::memory_order_relaxed));
+            auto Entry = new (Pool + Offset) Interning::Entry{ Key.Hash, uint32(Key.Text.size()), 0 };
+            auto Text  = const_cast<char*>(Entry->GetText());
+            memcpy(Text, Key.Text.data(), Key.Text.size());
+            Text[Key.Text.size()] = 0;
+            return Entry;
+        }
+
+        std::atomic<const Interning::Entry*>* Slots;
+        uint8*                                Pool;
+        uint32                                Mask;
+        uint64                                PoolSize;
+        std::atomic<uint32>                   Count{ 0 };
+        std::atomic<uint64>                   PoolUsed{ 0 };
+    };
+
+    namespace Interning
+    {
+        inline StringTable* GlobalTable = nullptr;
+    } // namespace Interning
+
+    // The table of the InternedString constructors without one; set before the threads use it
+    inline void         SetStringTable(StringTable* Table) { Interning::GlobalTable = Table; }
+    inline StringTable* GetStringTable() { return Interning::GlobalTable; }
+
+    // 8 bytes, trivially copyable; the empty string is a null entry. A text which does not fit in the table becomes
+    // the empty string: size the table with some margin and watch StringTable::GetCount. So does any text before
+    // SetStringTable, for the constructors without a table. GAME_INTERN asserts instead.
+    class InternedString
+    {
+    public:
+        InternedString() = default;
+        InternedString(StringTable& Table, const StringKey& Key)
+            : Entry{ Key.Text.empty() ? nullptr : Table.Intern(Key) }
+        {}
+        InternedString(const StringKey& Key)
+            : Entry{ Key.Text.empty() || !GetStringTable() ? nullptr : GetStringTable()->Intern(Key) }
+        {}
+        InternedString(const char* Text)
+            : InternedString{ StringKey{ Text } }
+        {}
+        InternedString(const std::string& Text)
+            : InternedString{ StringKey{ Text } }
+        {}
+        explicit InternedString(std::string_view Text)
+            : InternedString{ StringKey{ Text } }
+        {}
+
+        const char*      c_str() const { return Entry ? Entry->GetText() : ""; }
+        const char*      data() const { return c_str(); }
+        size_t           size() const { return Entry ? Entry->Length : 0; }
+        bool             empty() const { return Entry == nullptr; }
+        uint64           GetHash() const { return Entry ? Entry->Hash : HashBytes("", 0); }
+        std::string_view GetView() const { return { c_str(), size() }; }
+        std::string      ToString() const { return std::string{ GetView() }; }
+
+        operator std::string_view() const { return GetView(); }
+
+        friend bool operator==(InternedString Left, InternedString Right) { return Left.Entry == Right.Entry; }
+        friend bool operator!=(InternedString Left, InternedString Right) { return Left.Entry != Right.Entry; }
+        // an arbitrary but stable order, for sorted containers
+        friend bool operator<(InternedString Left, InternedString Right) { return Left.Entry < Right.Entry; }
+
+    private:
+        const Interning::Entry* Entry = nullptr;
+    };
+
+    namespace Interning
+    {
+        // GAME_INTERN keeps its string forever: a literal interned without a table, or in a full one, asserts
+        inline InternedString InternLiteral(const StringKey& Key)
+        {
+            InternedString Value{ Key };
+            Assert(Key.Text.empty() || !Value.empty());
+            return Value;
+        }
+    } // namespace Interning
+
+} // namespace Game
+
+namespace std
+{
+    template <>
+    struct hash<Game::InternedString>
+    {
+        size_t operator()(Game::InternedString Value) const { return size_t(Value.GetHash()); }
+    };
+} // namespace std
+
+// The interned string of a literal, hashed at compile time and looked up once per call site. Asserts when it does not
+// fit in the table, or before SetStringTable: the empty string would stay for good.
+#define GAME_INTERN(_LITERAL_)                                                                                         \
+    [] {                                                                                                               \
+        static constexpr Game::StringKey  Key{ _LITERAL_ };                                                            \
+        static const Game::InternedString Value = Game::Interning::InternLiteral(Key);                                 \
+        return Value;                                                                                                  \
+    }()
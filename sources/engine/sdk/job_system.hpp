@@ -0,0 +1,175 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fork-join parallelism for the frame: ParallelFor runs Function(Data, Index) for every index on the workers and on
+// the calling thread, and returns when all of them are done. Only plain function pointers cross the call, nothing is
+// kept afterwards, so the game DLL can be reloaded between two calls.
+
+namespace Game
+{
+    using JobFunction = void (*)(void* Data, uint32 Index);
+
+    class JobSystem
+    {
+    public:
+        JobSystem()                 = default;
+        JobSystem(const JobSystem&) = delete; // non copyable
+        virtual ~JobSystem() {}
+
+        // Blocks until the Count jobs are done, jobs must not call ParallelFor
+        virtual void ParallelFor(uint32 Count, JobFunction Function, void* Data) = 0;
+
+        // Threads running the jobs, including the caller: the useful number of parallel slices
+        virtual uint32 GetThreadCount() const = 0;
+    };
+
+    // Runs the jobs on the calling thread, when there is no job system
+    inline void ParallelFor(JobSystem* Jobs, uint32 Count, JobFunction Function, void* Data)
+    {
+        if (Jobs && Count > 1)
+        {
+            Jobs->ParallelFor(Count, Function, Data);
+            return;
+        }
+        for (uint32 Index = 0; Index < Count; ++Index)
+        {
+            Function(Data, Index);
+        }
+    }
+
+    // Lambda convenience for the callers: the lambda lives on the caller stack during the call
+    template <typename F>
+    void ParallelFor(JobSystem* Jobs, uint32 Count, F&& Function)
+    {
+        ParallelFor(
+            Jobs, Count, [](void* Data, uint32 Index) { (*static_cast<F*>(Data))(Index); }, &Function);
+    }
+
+    class ThreadPoolJobSystem final : public JobSystem
+    {
+    public:
+        // WorkerCount 0: one worker per hardware thread, minus the caller
+        explicit ThreadPoolJobSystem(uint32 WorkerCount = 0)
+        {
+            if (!WorkerCount)
+            {
+                auto HardwareCount = std::thread::hardware_concurrency();
+                WorkerCount        = HardwareCount > 1 ? HardwareCount - 1 : 0;
+            }
+            for (uint32 Index = 0; Index < WorkerCount; ++Index)
+            {
+                Workers.emplace_back([this] { Work(); });
+            }
+        }
+
+        ~ThreadPoolJobSystem() override
+        {
+            {
+                std::lock_guard<std::mutex> Lock{ Mutex };
+                IsStopping = true;
+            }
+            HasWork.notify_all();
+            for (auto& Worker : Workers)
+            {
+                Worker.join();
+            }
+        }
+
+        void ParallelFor(uint32 Count, JobFunction Function, void* Data) override
+        {
+            if (Workers.empty())
+            {
+                Game::ParallelFor(nullptr, Count, Function, Data);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> Lock{ Mutex };
+                CurrentFunction = Function;
+                CurrentData     = Data;
+                CurrentCount    = Count;
+                NextIndex.store(0, std::memory_order_relaxed);
+                DoneCount.store(0, std::memory_order_relaxed);
+                ++Generation;
+            }
+            HasWork.notify_all();
+
+            RunJobs(Function, Data, Count);
+
+            // the last jobs may still run on the workers, and a late worker must not start on the next call
+            std::unique_lock<std::mutex> Lock{ Mutex };
+            IsDone.wait(Lock, [this, Count] {
+                return DoneCount.load(std::memory_order_acquire) == Count && !ActiveWorkerCount;
+            });
+            CurrentFunction = nullptr;
+        }
+
+        uint32 GetThreadCount() const override { return static_cast<uint32>(Workers.size()) + 1; }
+
+    private:
+        void RunJobs(JobFunction Function, void* Data, uint32 Count)
+        {
+            for (;;)
+            {
+                auto Index = NextIndex.fetch_add(1, std::memory_order_relaxed);
+                if (Index >= Count)
+                {
+                    break;
+                }
+                Function(Data, Index);
+                if (DoneCount.fetch_add(1, std::memory_order_acq_rel) + 1 == Count)
+                {
+                    std::lock_guard<std::mutex> Lock{ Mutex };
+                    IsDone.notify_all();
+                }
+            }
+        }
+
+        void Work()
+        {
+            uint64                       SeenGeneration = 0;
+            std::unique_lock<std::mutex> Lock{ Mutex };
+            for (;;)
+            {
+                HasWork.wait(Lock, [&] { return IsStopping || (CurrentFunction && Generation != SeenGeneration); });
+                if (IsStopping)
+                {
+                    break;
+                }
+                SeenGeneration = Generation;
+                auto Function  = CurrentFunction;
+                auto Data      = CurrentData;
+                auto Count     = CurrentCount;
+                ++ActiveWorkerCount;
+                Lock.unlock();
+                RunJobs(Function, Data, Count);
+                Lock.lock();
+                if (!--ActiveWorkerCount)
+                {
+                    IsDone.notify_all();
+                }
+            }
+        }
+
+        std::mutex               Mutex;
+        std::condition_variable  HasWork;
+        std::condition_variable  IsDone;
+        std::vector<std::thread> Workers;
+        bool                     IsStopping = false;
+
+        JobFunction         CurrentFunction   = nullptr;
+        void*               CurrentData       = nullptr;
+        uint32              CurrentCount      = 0;
+        uint64              Generation        = 0;
+        uint32              ActiveWorkerCount = 0; // workers inside RunJobs
+        std::atomic<uint32> NextIndex{ 0 };
+        std::atomic<uint32> DoneCount{ 0 };
+    };
+
+} // namespace Game
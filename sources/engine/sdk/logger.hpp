@@ -0,0 +1,572 @@
+#pragma once
+
+#include "format.hpp"
+#include "memory_arena.hpp"
+#include "profiler.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+// Binary logger: a call copies the address of its site (level, format, file, line), a cycle count and its raw
+// arguments in the ring of its thread, nothing is formatted. The rings are single producer single consumer: the
+// thread which logs, and Drain, which merges the rings by time, formats the entries and hands the text to a sink. A
+// LogThread drains periodically; after a crash, the handler of the platform drains what is left to a file.
+//
+//     GAME_LOG(Log, Warning, "missed frame: {} us for {} us", Elapsed, Target);
+//
+// The levels under MIN_LOG_LEVEL are compiled out. The format string is checked at compile time against the arguments
+// (see format.hpp): integers, floats, bool, char, pointers, enums and strings (copied, up to MaxStringSize bytes). A
+// full ring drops the new entries and counts them, the caller never waits.
+// The sites live in the module which logs: drain before a module is unloaded.
+
+#ifndef MIN_LOG_LEVEL
+#define MIN_LOG_LEVEL 0
+#endif
+
+#define GAME_LOG(_LOGGER_, _LEVEL_, _FORMAT_, ...)                                                                     \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if constexpr (uint32(Game::LogLevel::_LEVEL_) >= MIN_LOG_LEVEL)                                                \
+        {                                                                                                              \
+            static constexpr Game::LogSite LogSite_{ Game::LogLevel::_LEVEL_, _FORMAT_, __FILE__, __LINE__ };          \
+            if (false)                                                                                                 \
+            {                                                                                                          \
+                Game::Logging::CheckArguments(GAME_FORMAT_STRING(_FORMAT_), ##__VA_ARGS__);                            \
+            }                                                                                                          \
+            (_LOGGER_).Write(LogSite_, ##__VA_ARGS__);                                                                 \
+        }                                                                                                              \
+    } while (false)
+
+namespace Game
+{
+    enum class LogLevel : uint8
+    {
+        Trace,
+        Debug,
+        Info,
+        Warning,
+        Error,
+        Fatal
+    };
+
+    // A call site of GAME_LOG, static: the entries only keep its address
+    struct LogSite
+    {
+        LogLevel    Level;
+        const char* Format;
+        const char* File;
+        uint32      Line;
+    };
+
+    // Receives the formatted text, a line per entry
+    struct LogSink
+    {
+        using WriteFunction = void (*)(void* Context, const char* Text, uint32 Size);
+
+        void*         Context = nullptr;
+        WriteFunction Write   = nullptr;
+    };
+
+    namespace Logging
+    {
+        constexpr uint32 MaxArgumentCount = 8;
+        constexpr uint32 MaxStringSize    = 256;
+        constexpr uint32 Padding          = 0xFFFFFFFF; // Types of the filler at the end of a ring
+
+        // 4 bits per argument in EntryHeader::Types, End after the last one
+        enum ArgumentType : uint32
+        {
+            End,
+            Signed,
+            Unsigned,
+            Float,
+            Boolean,
+            Character,
+            Pointer,
+            String
+        };
+
+        struct EntryHeader
+        {
+            uint32         Size; // of the entry, arguments included, multiple of 8
+            uint32         Types;
+            uint64         Cycles;
+            const LogSite* Site;
+        };
+
+        template <typename T>
+        constexpr ArgumentType GetArgumentType()
+        {
+            using U = std::decay_t<T>;
+            if constexpr (std::is_same_v<U, bool>)
+                return Boolean;
+            else if constexpr (std::is_same_v<U, char>)
+                return Character;
+            else if constexpr (std::is_enum_v<U>)
+                return GetArgumentType<std::underlying_type_t<U>>();
+            else if constexpr (std::is_integral_v<U>)
+                return std::is_signed_v<U> ? Signed : Unsigned;
+            else if constexpr (std::is_floating_point_v<U>)
+                return Float;
+            else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*> ||
+                               std::is_same_v<U, std::string_view>)
+                return String;
+            else
+            {
+                static_assert(std::is_pointer_v<U>, "unsupported log argument");
+                return Pointer;
+            }
+        }
+
+        template <typename... A>
+        constexpr uint32 GetTypes()
+        {
+            uint32 Types = 0;
+            uint32 Shift = 0;
+            ((Types |= uint32(GetArgumentType<A>()) << Shift, Shift += 4), ...);
+            return Types;
+        }
+
+        inline std::string_view GetString(std::string_view Value)
+        {
+            return Value.size() <= MaxStringSize ? Value : Value.substr(0, MaxStringSize);
+        }
+
+        inline std::string_view GetString(const char* Value)
+        {
+            return Value ? GetString(std::string_view{ Value, strnlen(Value, MaxStringSize) }) : "(null)";
+        }
+
+        // a slot of 8 bytes, strings are a length then their bytes
+        template <typename T>
+        uint32 GetArgumentSize(const T& Value)
+        {
+            if constexpr (GetArgumentType<T>() == String)
+            {
+                return 8 + ((uint32(GetString(Value).size()) + 7) & ~7u);
+            }
+            else
+            {
+                return 8;
+            }
+        }
+
+        template <typename T>
+        void WriteArgument(uint8*& Out, const T& Value)
+        {
+            constexpr auto Type = GetArgumentType<T>();
+            uint64         Slot = 0;
+            if constexpr (Type == String)
+            {
+                auto Text = GetString(Value);
+                Slot      = Text.size();
+                memcpy(Out, &Slot, sizeof(Slot));
+                memcpy(Out + 8, Text.data(), Text.size());
+                Out += 8 + ((Text.size() + 7) & ~size_t(7));
+                return;
+            }
+            else if constexpr (Type == Float)
+            {
+                auto Converted = double(Value);
+                memcpy(&Slot, &Converted, sizeof(Slot));
+            }
+            else if constexpr (Type == Pointer)
+            {
+                Slot = reinterpret_cast<uintptr_t>(Value);
+            }
+            else if constexpr (Type == Signed)
+            {
+                Slot = uint64(int64(Value));
+            }
+            else
+            {
+                Slot = uint64(Value);
+            }
+            memcpy(Out, &Slot, sizeof(Slot));
+            Out += 8;
+        }
+
+        inline const char* GetLevelName(LogLevel Level)
+        {
+            static const char* const Names[] = { "trace", "debug", "info", "warning", "error", "fatal" };
+            return uint32(Level) < 6 ? Names[uint32(Level)] : "?";
+        }
+
+        // "[level] cycles file(line): message\n", the format is parsed again (see format.hpp), a placeholder without
+        // argument is left as it is
+        inline void FormatEntry(const EntryHeader& Header, const uint8* Arguments, uint64 BaseCycles, FormatBuffer& Out)
+        {
+            auto& Site = *Header.Site;
+            Format(Out, GAME_FORMAT_STRING("[{}] {} {}({}): "), GetLevelName(Site.Level), Header.Cycles - BaseCycles,
+                   Site.File, Site.Line);
+
+            std::string_view Text   = Site.Format;
+            auto             Parsed = Formatting::Parse(Text);
+            if (!Parsed.IsValid)
+            {
+                Out.Append(Text.data(), Text.size());
+                Out.Append('\n');
+                return;
+            }
+            auto Types = Header.Types;
+            for (uint32 Index = 0; Index < Parsed.ItemCount; ++Index)
+            {
+                auto& Item = Parsed.Items[Index];
+                if (Item.Argument < 0 || (Types & 15) == End)
+                {
+                    Out.Append(Text.data() + Item.Offset, Item.Length);
+                    continue;
+                }
+                uint64 Slot;
+                memcpy(&Slot, Arguments, sizeof(Slot));
+                Arguments += 8;
+                switch (Types & 15)
+                {
+                case Signed:
+                    Formatting::WriteArgument(Out, int64(Slot), Item.Spec);
+                    break;
+                case Unsigned:
+                    Formatting::WriteArgument(Out, Slot, Item.Spec);
+                    break;
+                case Float:
+                {
+                    double Value;
+                    memcpy(&Value, &Slot, sizeof(Value));
+                    Formatting::WriteFloat(Out, Value, Item.Spec);
+                    break;
+                }
+                case Boolean:
+                    Formatting::WriteArgument(Out, Slot != 0, Item.Spec);
+                    break;
+                case Character:
+                    Formatting::WriteArgument(Out, char(Slot), Item.Spec);
+                    break;
+                case Pointer:
+                    Formatting::WritePointer(Out, uintptr_t(Slot), Item.Spec);
+                    break;
+                case String:
+                    Formatting::WriteString(Out, { reinterpret_cast<const char*>(Arguments), size_t(Slot) }, Item.Spec);
+                    Arguments += (Slot + 7) & ~uint64(7);
+                    break;
+                }
+                Types >>= 4;
+            }
+            Out.Append('\n');
+        }
+
+        // Fails to compile when the arguments do not fit the format, never called
+        template <typename S, typename... A>
+        void CheckArguments(S, const A&...)
+        {
+            static_assert(Formatting::Check<S, A...>());
+        }
+    } // namespace Logging
+
+    // Single producer single consumer ring of entries, an entry never wraps: a filler takes the end of the ring
+    class LogRing final
+    {
+    public:
+        void Initialize(uint8* Memory, uint32 Size)
+        {
+            Data     = Memory;
+            Capacity = Size;
+        }
+
+        // producer: nullptr when the ring is full
+        uint8* Reserve(uint32 Size)
+        {
+            auto Position = Head.load(std::memory_order_relaxed);
+            auto Offset   = uint32(Position & (Capacity - 1));
+            auto Filler   = Offset + Size > Capacity ? Capacity - Offset : 0;
+            if (Position + Filler + Size - CachedTail > Capacity)
+            {
+                CachedTail = Tail.load(std::memory_order_acquire);
+                if (Position + Filler + Size - CachedTail > Capacity)
+                {
+                    ++DroppedCount;
+                    return nullptr;
+                }
+            }
+            if (Filler)
+            {
+                uint32 Header[2] = { Filler, Logging::Padding };
+                memcpy(Data + Offset, Header, sizeof(Header));
+                Head.store(Position + Filler, std::memory_order_release);
+                Offset = 0;
+            }
+            return Data + Offset;
+        }
+
+        void Commit(uint32 Size) { Head.store(Head.load(std::memory_order_relaxed) + Size, std::memory_order_release); }
+
+        // consumer: the next entry, fillers skipped, nullptr when the ring is empty
+        const Logging::EntryHeader* Peek()
+        {
+            for (;;)
+            {
+                auto Position = Tail.load(std::memory_order_relaxed);
+                if (Position == Head.load(std::memory_order_acquire))
+                {
+                    return nullptr;
+                }
+                auto Entry = reinterpret_cast<const Logging::EntryHeader*>(Data + (Position & (Capacity - 1)));
+                if (Entry->Types != Logging::Padding)
+                {
+                    return Entry;
+                }
+                Tail.store(Position + Entry->Size, std::memory_order_release);
+            }
+        }
+
+        void Pop(uint32 Size) { Tail.store(Tail.load(std::memory_order_relaxed) + Size, std::memory_order_release); }
+
+        uint64 GetDroppedCount() const { return DroppedCount; }
+
+        std::atomic<const void*> Owner{ nullptr }; // the thread, see Logger::ClaimRing
+
+    private:
+        uint8* Data     = nullptr;
+        uint32 Capacity = 0; // power of two
+
+        alignas(64) std::atomic<uint64> Head{ 0 };
+        uint64 CachedTail   = 0;
+        uint64 DroppedCount = 0;
+        alignas(64) std::atomic<uint64> Tail{ 0 };
+    };
+
+    class Logger final
+    {
+    public:
+        static constexpr char NotDrainedLine[] = "log not drained: a drain was in progress\n";
+
+        // Up to MaxThreadCount threads log, each in a ring of RingSize bytes (a power of two), pushed on Arena
+        Logger(MemoryArena& Arena, uint32 MaxThreadCount, uint32 RingSize)
+            : Rings{ static_cast<LogRing*>(Arena.Push(sizeof(LogRing) * MaxThreadCount, 64)) }
+            , RingCount{ Rings ? MaxThreadCount : 0 }
+            , BaseCycles{ ReadCycleCounter() }
+        {
+            for (uint32 Ring = 0; Ring < RingCount; ++Ring)
+            {
+                auto Memory = Arena.PushArray<uint8>(RingSize, 64);
+                new (Rings + Ring) LogRing{};
+                Rings[Ring].Initialize(Memory, Memory && (RingSize & (RingSize - 1)) == 0 ? RingSize : 0);
+            }
+        }
+        Logger(const Logger&) = delete; // non copyable
+
+        ~Logger()
+        {
+            for (uint32 Ring = 0; Ring < RingCount; ++Ring)
+            {
+                Rings[Ring].~LogRing();
+            }
+        }
+
+        template <typename... A>
+        void Write(const LogSite& Site, const A&... Arguments)
+        {
+            static_assert(sizeof...(A) <= Logging::MaxArgumentCount, "too many log arguments");
+            auto Ring = GetRing();
+            if (!Ring)
+            {
+                DroppedCount.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            uint32 Size  = sizeof(Logging::EntryHeader) + (Logging::GetArgumentSize(Arguments) + ... + 0);
+            auto   Entry = Ring->Reserve(Size);
+            if (!Entry)
+            {
+                return;
+            }
+            Logging::EntryHeader Header = { Size, Logging::GetTypes<A...>(), ReadCycleCounter(), &Site };
+            memcpy(Entry, &Header, sizeof(Header));
+            [[maybe_unused]] auto Out = Entry + sizeof(Header);
+            (Logging::WriteArgument(Out, Arguments), ...);
+            Ring->Commit(Size);
+        }
+
+        // Formats the pending entries of every ring in time order, returns their number. One drain at a time: the
+        // rings have a single consumer. A forced drain (from a crash handler) never waits nor takes the mutex, which
+        // the crashing thread may hold: when another drain is in progress, it writes NotDrainedLine and returns 0.
+        uint32 Drain(const LogSink& Sink, bool IsForced = false)
+        {
+            std::unique_lock<std::mutex> Lock{ DrainMutex, std::defer_lock };
+            if (IsForced)
+            {
+                if (IsDraining.exchange(true, std::memory_order_acquire))
+                {
+                    if (Sink.Write)
+                    {
+                        Sink.Write(Sink.Context, NotDrainedLine, sizeof(NotDrainedLine) - 1);
+                    }
+                    return 0;
+                }
+            }
+            else
+            {
+                Lock.lock();
+                while (IsDraining.exchange(true, std::memory_order_acquire))
+                {
+                    std::this_thread::yield(); // a forced drain, the process is going down
+                }
+            }
+
+            char                Text[4096];
+            FormatBuffer        Out   = { Text, sizeof(Text) };
+            uint32              Count = 0;
+            auto                Used  = ClaimedCount.load(std::memory_order_acquire);
+            for (;;)
+            {
+                LogRing*                    Oldest = nullptr;
+                const Logging::EntryHeader* Entry  = nullptr;
+                for (uint32 Ring = 0; Ring < Used; ++Ring)
+                {
+                    auto Next = Rings[Ring].Peek();
+                    if (Next && (!Entry || int64(Next->Cycles - Entry->Cycles) < 0))
+                    {
+                        Oldest = &Rings[Ring];
+                        Entry  = Next;
+                    }
+                }
+                if (!Entry)
+                {
+                    break;
+                }
+                if (Out.Size + 1024 > Out.Capacity)
+                {
+                    Flush(Sink, Out);
+                }
+                Logging::FormatEntry(*Entry, reinterpret_cast<const uint8*>(Entry + 1), BaseCycles, Out);
+                Oldest->Pop(Entry->Size);
+                ++Count;
+            }
+            Flush(Sink, Out);
+            IsDraining.store(false, std::memory_order_release);
+            return Count;
+        }
+
+        // the entries which did not fit, in their ring or because every ring was taken
+        uint64 GetDroppedCount() const
+        {
+            auto Count = DroppedCount.load(std::memory_order_relaxed);
+            for (uint32 Ring = 0; Ring < ClaimedCount.load(std::memory_order_acquire); ++Ring)
+            {
+                Count += Rings[Ring].GetDroppedCount();
+            }
+            return Count;
+        }
+
+    private:
+        static void Flush(const LogSink& Sink, FormatBuffer& Out)
+        {
+            if (Out.Size && Sink.Write)
+            {
+                Sink.Write(Sink.Context, Out.Data, Out.Size);
+            }
+            Out.Size = 0;
+        }
+
+        // zero: thread local storage is zero initialized
+        struct ThreadRing
+        {
+            uint32   LoggerId;
+            LogRing* Ring;
+        };
+
+        LogRing* GetRing()
+        {
+            auto& Cached = CachedRing;
+            if (Cached.LoggerId != Id)
+            {
+                Cached = { Id, ClaimRing() };
+            }
+            return Cached.Ring;
+        }
+
+        // The ring of the thread (the address of its CachedRing), taken for good: a new thread at the same address
+        // takes the ring back, the previous one is gone
+        LogRing* ClaimRing()
+        {
+            const void* Thread = &CachedRing;
+            for (uint32 Ring = 0; Ring < RingCount; ++Ring)
+            {
+                const void* Owner = nullptr;
+                if (Rings[Ring].Owner.load(std::memory_order_relaxed) == Thread ||
+                    Rings[Ring].Owner.compare_exchange_strong(Owner, Thread, std::memory_order_acq_rel))
+                {
+                    // claimed in order: Drain reads the rings before ClaimedCount
+                    auto Used = ClaimedCount.load(std::memory_order_relaxed);
+                    while (Used < Ring + 1 && !ClaimedCount.compare_exchange_weak(Used, Ring + 1))
+                    {
+                    }
+                    return &Rings[Ring];
+                }
+            }
+            return nullptr;
+        }
+
+        static inline std::atomic<uint32>     NextId{ 1 };
+        static inline thread_local ThreadRing CachedRing;
+
+        const uint32        Id = NextId.fetch_add(1, std::memory_order_relaxed);
+        LogRing*            Rings;
+        uint32              RingCount;
+        uint64              BaseCycles;
+        std::atomic<uint32> ClaimedCount{ 0 };
+        std::atomic<uint64> DroppedCount{ 0 };
+        std::mutex          DrainMutex;
+        std::atomic<bool>   IsDraining{ false }; // the consumer of the rings, claimed by every drain
+    };
+
+    // Drains a logger every PeriodMilliseconds on its own thread, and once more when it stops
+    class LogThread final
+    {
+    public:
+        LogThread(Logger& Log, const LogSink& Sink, uint32 PeriodMilliseconds = 10)
+            : Log{ Log }
+            , Sink{ Sink }
+            , Period{ PeriodMilliseconds }
+            , Worker{ [this] { Work(); } }
+        {}
+        LogThread(const LogThread&) = delete; // non copyable
+
+        ~LogThread()
+        {
+            {
+                std::lock_guard<std::mutex> Lock{ Mutex };
+                IsStopping = true;
+            }
+            HasStopped.notify_all();
+            Worker.join();
+        }
+
+    private:
+        void Work()
+        {
+            std::unique_lock<std::mutex> Lock{ Mutex };
+            while (!HasStopped.wait_for(Lock, std::chrono::milliseconds(Period), [this] { return IsStopping; }))
+            {
+                Lock.unlock();
+                Log.Drain(Sink);
+                Lock.lock();
+            }
+            Log.Drain(Sink);
+        }
+
+        Logger&                 Log;
+        LogSink                 Sink;
+        uint32                  Period;
+        std::mutex              Mutex;
+        std::condition_variable HasStopped;
+        bool                    IsStopping = false;
+        std::thread             Worker; // last: starts once the rest is ready
+    };
+
+} // namespace Game
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstring>
+
+// Small LZ77 block codec (LZ4 like sequences): favours decompression speed over ratio.
+// A sequence is: token (literal count:4 | match length - 4:4), extra literal count bytes, literals,
+// match offset (16 bits little endian), extra match length bytes. The last sequence only has literals.
+
+namespace Game
+{
+    namespace Lz
+    {
+        constexpr uint32 MinMatch     = 4;
+        constexpr uint32 LastLiterals = 5; // the tail of a block is always stored as literals
+        constexpr uint32 MaxOffset    = 65535;
+        constexpr uint32 HashBits     = 12;
+
+        inline uint64 CompressBound(uint64 SourceSize) { return SourceSize + SourceSize / 255 + 16; }
+
+        inline uint32 Read32(const uint8* Pointer)
+        {
+            uint32 Value;
+            memcpy(&Value, Pointer, sizeof(Value));
+            return Value;
+        }
+
+        inline uint32 HashSequence(uint32 Sequence) { return (Sequence * 2654435761u) >> (32 - HashBits); }
+
+        inline uint8* WriteLength(uint8* Out, uint64 Length)
+        {
+            while (Length >= 255)
+            {
+                *Out++ = 255;
+                Length -= 255;
+            }
+            *Out++ = static_cast<uint8>(Length);
+            return Out;
+        }
+
+        // Returns the compressed size, 0 if it does not fit in DestinationCapacity
+        inline uint64 Compress(const void* Source, uint64 SourceSize, void* Destination, uint64 DestinationCapacity)
+        {
+            if (DestinationCapacity < CompressBound(SourceSize))
+            {
+                return 0;
+            }
+            auto In     = static_cast<const uint8*>(Source);
+            auto Out    = static_cast<uint8*>(Destination);
+            auto Anchor = In;
+            auto End    = In + SourceSize;
+
+            auto EmitSequence = [&Out](const uint8* Literals, uint64 LiteralCount, uint64 Offset, uint64 MatchLength) {
+                auto Token = Out++;
+                *Token     = static_cast<uint8>((LiteralCount < 15 ? LiteralCount : 15) << 4);
+                if (LiteralCount >= 15)
+                {
+                    Out = WriteLength(Out, LiteralCount - 15);
+                }
+                memcpy(Out, Literals, LiteralCount);
+                Out += LiteralCount;
+                if (MatchLength)
+                {
+                    *Out++     = static_cast<uint8>(Offset);
+                    *Out++     = static_cast<uint8>(Offset >> 8);
+                    auto Extra = MatchLength - MinMatch;
+                    *Token |= static_cast<uint8>(Extra < 15 ? Extra : 15);
+                    if (Extra >= 15)
+                    {
+                        Out = WriteLength(Out, Extra - 15);
+                    }
+                }
+            };
+
+            if (SourceSize > MinMatch + LastLiterals + 8)
+            {
+                uint32 Table[1 << HashBits] = {}; // position + 1, 0 is empty
+                auto   MatchLimit           = End - LastLiterals;
+                auto   SearchLimit          = End - (MinMatch + LastLiterals + 8);
+                auto   Cursor               = In;
+                while (Cursor < SearchLimit)
+                {
+                    auto Sequence  = Read32(Cursor);
+                    auto& Slot     = Table[HashSequence(Sequence)];
+                    auto Reference = Slot ? In + Slot - 1 : nullptr;
+                    Slot           = static_cast<uint32>(Cursor - In + 1);
+
+                    if (Reference && static_cast<uint64>(Cursor - Reference) <= MaxOffset &&
+                        Read32(Reference) == Sequence)
+                    {
+                        auto Length = MinMatch;
+                        while (Cursor + Length < MatchLimit && Reference[Length] == Cursor[Length])
+                        {
+                            ++Length;
+                        }
+                        EmitSequence(Anchor, Cursor - Anchor, Cursor - Reference, Length);
+                        Cursor += Length;
+                        Anchor = Cursor;
+                    }
+                    else
+                    {
+                        ++Cursor;
+                    }
+                }
+            }
+            EmitSequence(Anchor, End - Anchor, 0, 0);
+            return Out - static_cast<uint8*>(Destination);
+        }
+
+        // DestinationSize must be the exact uncompressed size. Returns false on corrupted data.
+        inline bool Decompress(const void* Source, uint64 SourceSize, void* Destination, uint64 DestinationSize)
+        {
+            auto In     = static_cast<const uint8*>(Source);
+            auto InEnd  = In + SourceSize;
+            auto Out    = static_cast<uint8*>(Destination);
+            auto OutEnd = Out + DestinationSize;
+
+            auto ReadLength = [&In, InEnd](uint64& Length) {
+                uint8 Byte;
+                do
+                {
+                    if (In == InEnd)
+                    {
+                        return false;
+                    }
+                    Byte = *In++;
+                    Length += Byte;
+                } while (Byte == 255);
+                return true;
+            };
+
+            while (In < InEnd)
+            {
+                auto   Token        = *In++;
+                uint64 LiteralCount = Token >> 4;
+                if (LiteralCount == 15 && !ReadLength(LiteralCount))
+                {
+                    return false;
+                }
+                if (LiteralCount > static_cast<uint64>(InEnd - In) || LiteralCount > static_cast<uint64>(OutEnd - Out))
+                {
+                    return false;
+                }
+                memcpy(Out, In, LiteralCount);
+                In += LiteralCount;
+                Out += LiteralCount;
+                if (In == InEnd)
+                {
+                    break; // last sequence
+                }
+
+                if (InEnd - In < 2)
+                {
+                    return false;
+                }
+                uint64 Offset = In[0] | (In[1] << 8);
+                In += 2;
+                uint64 MatchLength = Token & 15;
+                if (MatchLength == 15 && !ReadLength(MatchLength))
+                {
+                    return false;
+                }
+                MatchLength += MinMatch;
+                if (!Offset || Offset > static_cast<uint64>(Out - static_cast<uint8*>(Destination)) ||
+                    MatchLength > static_cast<uint64>(OutEnd - Out))
+                {
+                    return false;
+                }
+                auto Reference = Out - Offset;
+                if (Offset >= MatchLength)
+                {
+                    memcpy(Out, Reference, MatchLength);
+                    Out += MatchLength;
+                }
+                else
+                {
+                    // overlapping: repeats the last Offset bytes
+                    for (auto Index = 0ULL; Index < MatchLength; ++Index)
+                    {
+                        *Out++ = Reference[Index];
+                    }
+                }
+            }
+            return Out == OutEnd;
+        }
+    } // namespace Lz
+
+} // namespace Game
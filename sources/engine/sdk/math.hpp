@@ -0,0 +1,654 @@
+#pragma once
+
+#include "simd.hpp"
+#include "types.hpp"
+
+#include <cmath>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// Vectors and matrices for the game: v2, v3, v4 values with the usual operators, m3x3 (2D affine transforms) and
+// m4x4 (3D transforms), row-major and applied to column vectors (M * v).
+// The batch functions work on structures of arrays (one array per coordinate, see V2Soa and V3Soa) with a kernel per
+// SimdLevel, the default being the best one of the CPU. Everything is inline: the game DLL carries its own copy and
+// keeps no state, it can be reloaded at any time.
+
+namespace Game
+{
+    struct v2
+    {
+        real32 X, Y;
+    };
+
+    struct v3
+    {
+        real32 X, Y, Z;
+    };
+
+    struct v4
+    {
+        real32 X, Y, Z, W;
+    };
+
+    struct m3x3
+    {
+        real32 E[3][3]; // [Row][Column]
+    };
+
+    struct m4x4
+    {
+        real32 E[4][4]; // [Row][Column]
+    };
+
+    // clang-format off
+    constexpr v2 operator+(v2 A, v2 B) { return { A.X + B.X, A.Y + B.Y }; }
+    constexpr v2 operator-(v2 A, v2 B) { return { A.X - B.X, A.Y - B.Y }; }
+    constexpr v2 operator-(v2 A) { return { -A.X, -A.Y }; }
+    constexpr v2 operator*(v2 A, real32 S) { return { A.X * S, A.Y * S }; }
+    constexpr v2 operator*(real32 S, v2 A) { return A * S; }
+    constexpr v2 Hadamard(v2 A, v2 B) { return { A.X * B.X, A.Y * B.Y }; }
+    constexpr real32 Dot(v2 A, v2 B) { return A.X * B.X + A.Y * B.Y; }
+    constexpr v2 Perpendicular(v2 A) { return { -A.Y, A.X }; }
+
+    constexpr v3 operator+(v3 A, v3 B) { return { A.X + B.X, A.Y + B.Y, A.Z + B.Z }; }
+    constexpr v3 operator-(v3 A, v3 B) { return { A.X - B.X, A.Y - B.Y, A.Z - B.Z }; }
+    constexpr v3 operator-(v3 A) { return { -A.X, -A.Y, -A.Z }; }
+    constexpr v3 operator*(v3 A, real32 S) { return { A.X * S, A.Y * S, A.Z * S }; }
+    constexpr v3 operator*(real32 S, v3 A) { return A * S; }
+    constexpr v3 Hadamard(v3 A, v3 B) { return { A.X * B.X, A.Y * B.Y, A.Z * B.Z }; }
+    constexpr real32 Dot(v3 A, v3 B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+    constexpr v3 Cross(v3 A, v3 B) { return { A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X }; }
+
+    constexpr v4 operator+(v4 A, v4 B) { return { A.X + B.X, A.Y + B.Y, A.Z + B.Z, A.W + B.W }; }
+    constexpr v4 operator-(v4 A, v4 B) { return { A.X - B.X, A.Y - B.Y, A.Z - B.Z, A.W - B.W }; }
+    constexpr v4 operator-(v4 A) { return { -A.X, -A.Y, -A.Z, -A.W }; }
+    constexpr v4 operator*(v4 A, real32 S) { return { A.X * S, A.Y * S, A.Z * S, A.W * S }; }
+    constexpr v4 operator*(real32 S, v4 A) { return A * S; }
+    constexpr v4 Hadamard(v4 A, v4 B) { return { A.X * B.X, A.Y * B.Y, A.Z * B.Z, A.W * B.W }; }
+    constexpr real32 Dot(v4 A, v4 B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z + A.W * B.W; }
+    // clang-format on
+
+    // clang-format off
+    constexpr v2& operator+=(v2& A, v2 B) { return A = A + B; }
+    constexpr v2& operator-=(v2& A, v2 B) { return A = A - B; }
+    constexpr v2& operator*=(v2& A, real32 S) { return A = A * S; }
+    constexpr v3& operator+=(v3& A, v3 B) { return A = A + B; }
+    constexpr v3& operator-=(v3& A, v3 B) { return A = A - B; }
+    constexpr v3& operator*=(v3& A, real32 S) { return A = A * S; }
+    constexpr v4& operator+=(v4& A, v4 B) { return A = A + B; }
+    constexpr v4& operator-=(v4& A, v4 B) { return A = A - B; }
+    constexpr v4& operator*=(v4& A, real32 S) { return A = A * S; }
+    // clang-format on
+
+    template <typename V>
+    constexpr real32 LengthSquared(V A)
+    {
+        return Dot(A, A);
+    }
+
+    template <typename V>
+    real32 Length(V A)
+    {
+        return std::sqrt(Dot(A, A));
+    }
+
+    // A with a length of 1, or zero for a zero vector
+    template <typename V>
+    V Normalize(V A)
+    {
+        auto Squared = Dot(A, A);
+        return Squared > 0.0f ? A * (1.0f / std::sqrt(Squared)) : V{};
+    }
+
+    template <typename V>
+    constexpr V Lerp(V A, V B, real32 T)
+    {
+        return A + (B - A) * T;
+    }
+
+    constexpr m3x3 Identity3x3() { return { { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } } }; }
+    constexpr m4x4 Identity4x4() { return { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } }; }
+
+    template <typename M, int Size>
+    constexpr M Multiply(const M& A, const M& B)
+    {
+        M Result = {};
+        for (int Row = 0; Row < Size; ++Row)
+        {
+            for (int Column = 0; Column < Size; ++Column)
+            {
+                for (int Index = 0; Index < Size; ++Index)
+                {
+                    Result.E[Row][Column] += A.E[Row][Index] * B.E[Index][Column];
+                }
+            }
+        }
+        return Result;
+    }
+
+    // A * B applies B first
+    constexpr m3x3 operator*(const m3x3& A, const m3x3& B) { return Multiply<m3x3, 3>(A, B); }
+    constexpr m4x4 operator*(const m4x4& A, const m4x4& B) { return Multiply<m4x4, 4>(A, B); }
+
+    constexpr v3 operator*(const m3x3& M, v3 V)
+    {
+        return { M.E[0][0] * V.X + M.E[0][1] * V.Y + M.E[0][2] * V.Z,
+                 M.E[1][0] * V.X + M.E[1][1] * V.Y + M.E[1][2] * V.Z,
+                 M.E[2][0] * V.X + M.E[2][1] * V.Y + M.E[2][2] * V.Z };
+    }
+
+    constexpr v4 operator*(const m4x4& M, v4 V)
+    {
+        return { M.E[0][0] * V.X + M.E[0][1] * V.Y + M.E[0][2] * V.Z + M.E[0][3] * V.W,
+                 M.E[1][0] * V.X + M.E[1][1] * V.Y + M.E[1][2] * V.Z + M.E[1][3] * V.W,
+                 M.E[2][0] * V.X + M.E[2][1] * V.Y + M.E[2][2] * V.Z + M.E[2][3] * V.W,
+                 M.E[3][0] * V.X + M.E[3][1] * V.Y + M.E[3][2] * V.Z + M.E[3][3] * V.W };
+    }
+
+    template <typename M, int Size>
+    constexpr M Transpose(const M& A)
+    {
+        M Result = {};
+        for (int Row = 0; Row < Size; ++Row)
+        {
+            for (int Column = 0; Column < Size; ++Column)
+            {
+                Result.E[Column][Row] = A.E[Row][Column];
+            }
+        }
+        return Result;
+    }
+
+    constexpr m3x3 Transpose(const m3x3& A) { return Transpose<m3x3, 3>(A); }
+    constexpr m4x4 Transpose(const m4x4& A) { return Transpose<m4x4, 4>(A); }
+
+    // 2D affine transforms, the last row stays (0, 0, 1)
+    constexpr m3x3 Translation(v2 T) { return { { { 1, 0, T.X }, { 0, 1, T.Y }, { 0, 0, 1 } } }; }
+    constexpr m3x3 Scaling(v2 S) { return { { { S.X, 0, 0 }, { 0, S.Y, 0 }, { 0, 0, 1 } } }; }
+
+    inline m3x3 Rotation(real32 Angle)
+    {
+        auto C = std::cos(Angle);
+        auto S = std::sin(Angle);
+        return { { { C, -S, 0 }, { S, C, 0 }, { 0, 0, 1 } } };
+    }
+
+    // point: translated, W = 1
+    constexpr v2 TransformPoint(const m3x3& M, v2 P)
+    {
+        return { M.E[0][0] * P.X + M.E[0][1] * P.Y + M.E[0][2], M.E[1][0] * P.X + M.E[1][1] * P.Y + M.E[1][2] };
+    }
+
+    // 3D transforms
+    constexpr m4x4 Translation(v3 T)
+    {
+        return { { { 1, 0, 0, T.X }, { 0, 1, 0, T.Y }, { 0, 0, 1, T.Z }, { 0, 0, 0, 1 } } };
+    }
+
+    constexpr m4x4 Scaling(v3 S)
+    {
+        return { { { S.X, 0, 0, 0 }, { 0, S.Y, 0, 0 }, { 0, 0, S.Z, 0 }, { 0, 0, 0, 1 } } };
+    }
+
+    inline m4x4 RotationX(real32 Angle)
+    {
+        auto C = std::cos(Angle);
+        auto S = std::sin(Angle);
+        return { { { 1, 0, 0, 0 }, { 0, C, -S, 0 }, { 0, S, C, 0 }, { 0, 0, 0, 1 } } };
+    }
+
+    inline m4x4 RotationY(real32 Angle)
+    {
+        auto C = std::cos(Angle);
+        auto S = std::sin(Angle);
+        return { { { C, 0, S, 0 }, { 0, 1, 0, 0 }, { -S, 0, C, 0 }, { 0, 0, 0, 1 } } };
+    }
+
+    inline m4x4 RotationZ(real32 Angle)
+    {
+        auto C = std::cos(Angle);
+        auto S = std::sin(Angle);
+        return { { { C, -S, 0, 0 }, { S, C, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+    }
+
+    // affine: the last row is ignored
+    constexpr v3 TransformPoint(const m4x4& M, v3 P)
+    {
+        return { M.E[0][0] * P.X + M.E[0][1] * P.Y + M.E[0][2] * P.Z + M.E[0][3],
+                 M.E[1][0] * P.X + M.E[1][1] * P.Y + M.E[1][2] * P.Z + M.E[1][3],
+                 M.E[2][0] * P.X + M.E[2][1] * P.Y + M.E[2][2] * P.Z + M.E[2][3] };
+    }
+
+    // Structures of arrays: Count values in each array. The batch functions accept an output equal to an input.
+    struct V2Soa
+    {
+        real32* X;
+        real32* Y;
+
+        v2 Get(uint32 Index) const { return { X[Index], Y[Index] }; }
+
+        void Set(uint32 Index, v2 V) const
+        {
+            X[Index] = V.X;
+            Y[Index] = V.Y;
+        }
+    };
+
+    struct V3Soa
+    {
+        real32* X;
+        real32* Y;
+        real32* Z;
+
+        v3 Get(uint32 Index) const { return { X[Index], Y[Index], Z[Index] }; }
+
+        void Set(uint32 Index, v3 V) const
+        {
+            X[Index] = V.X;
+            Y[Index] = V.Y;
+            Z[Index] = V.Z;
+        }
+    };
+
+    namespace MathBatch
+    {
+        // scalar kernels, also used for the ends of the SIMD loops
+
+        inline void TransformPoints2Scalar(const m3x3& M, V2Soa In, V2Soa Out, uint32 Begin, uint32 End)
+        {
+            for (auto Index = Begin; Index < End; ++Index)
+            {
+                Out.Set(Index, TransformPoint(M, In.Get(Index)));
+            }
+        }
+
+        inline void TransformPoints3Scalar(const m4x4& M, V3Soa In, V3Soa Out, uint32 Begin, uint32 End)
+        {
+            for (auto Index = Begin; Index < End; ++Index)
+            {
+                Out.Set(Index, TransformPoint(M, In.Get(Index)));
+            }
+        }
+
+        inline void NormalizeScalar(V3Soa In, V3Soa Out, uint32 Begin, uint32 End)
+        {
+            for (auto Index = Begin; Index < End; ++Index)
+            {
+                Out.Set(Index, Normalize(In.Get(Index)));
+            }
+        }
+
+        inline void DotScalar(V3Soa A, V3Soa B, real32* Out, uint32 Begin, uint32 End)
+        {
+            for (auto Index = Begin; Index < End; ++Index)
+            {
+                Out[Index] = Dot(A.Get(Index), B.Get(Index));
+            }
+        }
+
+        inline void CrossScalar(V3Soa A, V3Soa B, V3Soa Out, uint32 Begin, uint32 End)
+        {
+            for (auto Index = Begin; Index < End; ++Index)
+            {
+                Out.Set(Index, Cross(A.Get(Index), B.Get(Index)));
+            }
+        }
+
+        // SSE2: 4 values per iteration, same operations in the same order as the scalar kernels. Each kernel returns
+        // how many values it processed, the scalar kernel does the rest.
+
+        // Row[0] * X + Row[1] * Y + Row[2]
+        inline __m128 AffineRowSse2(const real32* Row, __m128 X, __m128 Y)
+        {
+            auto XY = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(Row[0]), X), _mm_mul_ps(_mm_set1_ps(Row[1]), Y));
+            return _mm_add_ps(XY, _mm_set1_ps(Row[2]));
+        }
+
+        // Row[0] * X + Row[1] * Y + Row[2] * Z + Row[3]
+        inline __m128 AffineRowSse2(const real32* Row, __m128 X, __m128 Y, __m128 Z)
+        {
+            auto XY = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(Row[0]), X), _mm_mul_ps(_mm_set1_ps(Row[1]), Y));
+            return _mm_add_ps(_mm_add_ps(XY, _mm_mul_ps(_mm_set1_ps(Row[2]), Z)), _mm_set1_ps(Row[3]));
+        }
+
+        inline uint32 TransformPoints2Sse2(const m3x3& M, V2Soa In, V2Soa Out, uint32 Count)
+        {
+            uint32 Index = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto X = _mm_loadu_ps(In.X + Index);
+                auto Y = _mm_loadu_ps(In.Y + Index);
+                _mm_storeu_ps(Out.X + Index, AffineRowSse2(M.E[0], X, Y));
+                _mm_storeu_ps(Out.Y + Index, AffineRowSse2(M.E[1], X, Y));
+            }
+            return Index;
+        }
+
+        inline uint32 TransformPoints3Sse2(const m4x4& M, V3Soa In, V3Soa Out, uint32 Count)
+        {
+            uint32 Index = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto X = _mm_loadu_ps(In.X + Index);
+                auto Y = _mm_loadu_ps(In.Y + Index);
+                auto Z = _mm_loadu_ps(In.Z + Index);
+                _mm_storeu_ps(Out.X + Index, AffineRowSse2(M.E[0], X, Y, Z));
+                _mm_storeu_ps(Out.Y + Index, AffineRowSse2(M.E[1], X, Y, Z));
+                _mm_storeu_ps(Out.Z + Index, AffineRowSse2(M.E[2], X, Y, Z));
+            }
+            return Index;
+        }
+
+        inline __m128 DotSse2(__m128 AX, __m128 AY, __m128 AZ, __m128 BX, __m128 BY, __m128 BZ)
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(AX, BX), _mm_mul_ps(AY, BY)), _mm_mul_ps(AZ, BZ));
+        }
+
+        inline uint32 NormalizeSse2(V3Soa In, V3Soa Out, uint32 Count)
+        {
+            uint32 Index = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto X       = _mm_loadu_ps(In.X + Index);
+                auto Y       = _mm_loadu_ps(In.Y + Index);
+                auto Z       = _mm_loadu_ps(In.Z + Index);
+                auto Squared = DotSse2(X, Y, Z, X, Y, Z);
+                auto Scale   = _mm_and_ps(_mm_cmpgt_ps(Squared, _mm_setzero_ps()),
+                                        _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(Squared)));
+                _mm_storeu_ps(Out.X + Index, _mm_mul_ps(X, Scale));
+                _mm_storeu_ps(Out.Y + Index, _mm_mul_ps(Y, Scale));
+                _mm_storeu_ps(Out.Z + Index, _mm_mul_ps(Z, Scale));
+            }
+            return Index;
+        }
+
+        inline uint32 DotSse2(V3Soa A, V3Soa B, real32* Out, uint32 Count)
+        {
+            uint32 Index = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto AX = _mm_loadu_ps(A.X + Index);
+                auto AY = _mm_loadu_ps(A.Y + Index);
+                auto AZ = _mm_loadu_ps(A.Z + Index);
+                auto BX = _mm_loadu_ps(B.X + Index);
+                auto BY = _mm_loadu_ps(B.Y + Index);
+                auto BZ = _mm_loadu_ps(B.Z + Index);
+                _mm_storeu_ps(Out + Index, DotSse2(AX, AY, AZ, BX, BY, BZ));
+            }
+            return Index;
+        }
+
+        inline uint32 CrossSse2(V3Soa A, V3Soa B, V3Soa Out, uint32 Count)
+        {
+            uint32 Index = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto AX = _mm_loadu_ps(A.X + Index);
+                auto AY = _mm_loadu_ps(A.Y + Index);
+                auto AZ = _mm_loadu_ps(A.Z + Index);
+                auto BX = _mm_loadu_ps(B.X + Index);
+                auto BY = _mm_loadu_ps(B.Y + Index);
+                auto BZ = _mm_loadu_ps(B.Z + Index);
+                _mm_storeu_ps(Out.X + Index, _mm_sub_ps(_mm_mul_ps(AY, BZ), _mm_mul_ps(AZ, BY)));
+                _mm_storeu_ps(Out.Y + Index, _mm_sub_ps(_mm_mul_ps(AZ, BX), _mm_mul_ps(AX, BZ)));
+                _mm_storeu_ps(Out.Z + Index, _mm_sub_ps(_mm_mul_ps(AX, BY), _mm_mul_ps(AY, BX)));
+            }
+            return Index;
+        }
+
+        // AVX2: 8 values per iteration, with FMA (results can differ from the scalar ones in the last bit)
+
+        GAME_TARGET_AVX2 inline __m256 AffineRowAvx2(const real32* Row, __m256 X, __m256 Y)
+        {
+            auto R = _mm256_fmadd_ps(_mm256_set1_ps(Row[1]), Y, _mm256_set1_ps(Row[2]));
+            return _mm256_fmadd_ps(_mm256_set1_ps(Row[0]), X, R);
+        }
+
+        GAME_TARGET_AVX2 inline __m256 AffineRowAvx2(const real32* Row, __m256 X, __m256 Y, __m256 Z)
+        {
+            auto R = _mm256_fmadd_ps(_mm256_set1_ps(Row[2]), Z, _mm256_set1_ps(Row[3]));
+            R      = _mm256_fmadd_ps(_mm256_set1_ps(Row[1]), Y, R);
+            return _mm256_fmadd_ps(_mm256_set1_ps(Row[0]), X, R);
+        }
+
+        GAME_TARGET_AVX2 inline uint32 TransformPoints2Avx2(const m3x3& M, V2Soa In, V2Soa Out, uint32 Count)
+        {
+            uint32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto X = _mm256_loadu_ps(In.X + Index);
+                auto Y = _mm256_loadu_ps(In.Y + Index);
+                _mm256_storeu_ps(Out.X + Index, AffineRowAvx2(M.E[0], X, Y));
+                _mm256_storeu_ps(Out.Y + Index, AffineRowAvx2(M.E[1], X, Y));
+            }
+            return Index;
+        }
+
+        GAME_TARGET_AVX2 inline uint32 TransformPoints3Avx2(const m4x4& M, V3Soa In, V3Soa Out, uint32 Count)
+        {
+            uint32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto X = _mm256_loadu_ps(In.X + Index);
+                auto Y = _mm256_loadu_ps(In.Y + Index);
+                auto Z = _mm256_loadu_ps(In.Z + Index);
+                _mm256_storeu_ps(Out.X + Index, AffineRowAvx2(M.E[0], X, Y, Z));
+                _mm256_storeu_ps(Out.Y + Index, AffineRowAvx2(M.E[1], X, Y, Z));
+                _mm256_storeu_ps(Out.Z + Index, AffineRowAvx2(M.E[2], X, Y, Z));
+            }
+            return Index;
+        }
+
+        GAME_TARGET_AVX2 inline __m256 DotAvx2(__m256 AX, __m256 AY, __m256 AZ, __m256 BX, __m256 BY, __m256 BZ)
+        {
+            return _mm256_fmadd_ps(AZ, BZ, _mm256_fmadd_ps(AY, BY, _mm256_mul_ps(AX, BX)));
+        }
+
+        GAME_TARGET_AVX2 inline uint32 NormalizeAvx2(V3Soa In, V3Soa Out, uint32 Count)
+        {
+            uint32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto X       = _mm256_loadu_ps(In.X + Index);
+                auto Y       = _mm256_loadu_ps(In.Y + Index);
+                auto Z       = _mm256_loadu_ps(In.Z + Index);
+                auto Squared = DotAvx2(X, Y, Z, X, Y, Z);
+                auto Scale   = _mm256_and_ps(_mm256_cmp_ps(Squared, _mm256_setzero_ps(), _CMP_GT_OQ),
+                                           _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(Squared)));
+                _mm256_storeu_ps(Out.X + Index, _mm256_mul_ps(X, Scale));
+                _mm256_storeu_ps(Out.Y + Index, _mm256_mul_ps(Y, Scale));
+                _mm256_storeu_ps(Out.Z + Index, _mm256_mul_ps(Z, Scale));
+            }
+            return Index;
+        }
+
+        GAME_TARGET_AVX2 inline uint32 DotAvx2(V3Soa A, V3Soa B, real32* Out, uint32 Count)
+        {
+            uint32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto AX = _mm256_loadu_ps(A.X + Index);
+                auto AY = _mm256_loadu_ps(A.Y + Index);
+                auto AZ = _mm256_loadu_ps(A.Z + Index);
+                auto BX = _mm256_loadu_ps(B.X + Index);
+                auto BY = _mm256_loadu_ps(B.Y + Index);
+                auto BZ = _mm256_loadu_ps(B.Z + Index);
+                _mm256_storeu_ps(Out + Index, DotAvx2(AX, AY, AZ, BX, BY, BZ));
+            }
+            return Index;
+        }
+
+        GAME_TARGET_AVX2 inline uint32 CrossAvx2(V3Soa A, V3Soa B, V3Soa Out, uint32 Count)
+        {
+            uint32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto AX = _mm256_loadu_ps(A.X + Index);
+                auto AY = _mm256_loadu_ps(A.Y + Index);
+                auto AZ = _mm256_loadu_ps(A.Z + Index);
+                auto BX = _mm256_loadu_ps(B.X + Index);
+                auto BY = _mm256_loadu_ps(B.Y + Index);
+                auto BZ = _mm256_loadu_ps(B.Z + Index);
+                _mm256_storeu_ps(Out.X + Index, _mm256_fmsub_ps(AY, BZ, _mm256_mul_ps(AZ, BY)));
+                _mm256_storeu_ps(Out.Y + Index, _mm256_fmsub_ps(AZ, BX, _mm256_mul_ps(AX, BZ)));
+                _mm256_storeu_ps(Out.Z + Index, _mm256_fmsub_ps(AX, BY, _mm256_mul_ps(AY, BX)));
+            }
+            return Index;
+        }
+
+        // AVX-512: 16 values per iteration, the last one masked: nothing is left for the scalar kernel
+
+        GAME_TARGET_AVX512 inline __mmask16 GetMaskAvx512(uint32 Index, uint32 Count)
+        {
+            return Count - Index >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << (Count - Index)) - 1);
+        }
+
+        GAME_TARGET_AVX512 inline __m512 AffineRowAvx512(const real32* Row, __m512 X, __m512 Y)
+        {
+            auto R = _mm512_fmadd_ps(_mm512_set1_ps(Row[1]), Y, _mm512_set1_ps(Row[2]));
+            return _mm512_fmadd_ps(_mm512_set1_ps(Row[0]), X, R);
+        }
+
+        GAME_TARGET_AVX512 inline __m512 AffineRowAvx512(const real32* Row, __m512 X, __m512 Y, __m512 Z)
+        {
+            auto R = _mm512_fmadd_ps(_mm512_set1_ps(Row[2]), Z, _mm512_set1_ps(Row[3]));
+            R      = _mm512_fmadd_ps(_mm512_set1_ps(Row[1]), Y, R);
+            return _mm512_fmadd_ps(_mm512_set1_ps(Row[0]), X, R);
+        }
+
+        GAME_TARGET_AVX512 inline uint32 TransformPoints2Avx512(const m3x3& M, V2Soa In, V2Soa Out, uint32 Count)
+        {
+            for (uint32 Index = 0; Index < Count; Index += 16)
+            {
+                auto Mask = GetMaskAvx512(Index, Count);
+                auto X    = _mm512_maskz_loadu_ps(Mask, In.X + Index);
+                auto Y    = _mm512_maskz_loadu_ps(Mask, In.Y + Index);
+                _mm512_mask_storeu_ps(Out.X + Index, Mask, AffineRowAvx512(M.E[0], X, Y));
+                _mm512_mask_storeu_ps(Out.Y + Index, Mask, AffineRowAvx512(M.E[1], X, Y));
+            }
+            return Count;
+        }
+
+        GAME_TARGET_AVX512 inline uint32 TransformPoints3Avx512(const m4x4& M, V3Soa In, V3Soa Out, uint32 Count)
+        {
+            for (uint32 Index = 0; Index < Count; Index += 16)
+            {
+                auto Mask = GetMaskAvx512(Index, Count);
+                auto X    = _mm512_maskz_loadu_ps(Mask, In.X + Index);
+                auto Y    = _mm512_maskz_loadu_ps(Mask, In.Y + Index);
+                auto Z    = _mm512_maskz_loadu_ps(Mask, In.Z + Index);
+                _mm512_mask_storeu_ps(Out.X + Index, Mask, AffineRowAvx512(M.E[0], X, Y, Z));
+                _mm512_mask_storeu_ps(Out.Y + Index, Mask, AffineRowAvx512(M.E[1], X, Y, Z));
+                _mm512_mask_storeu_ps(Out.Z + Index, Mask, AffineRowAvx512(M.E[2], X, Y, Z));
+            }
+            return Count;
+        }
+
+        GAME_TARGET_AVX512 inline __m512 DotAvx512(__m512 AX, __m512 AY, __m512 AZ, __m512 BX, __m512 BY, __m512 BZ)
+        {
+            return _mm512_fmadd_ps(AZ, BZ, _mm512_fmadd_ps(AY, BY, _mm512_mul_ps(AX, BX)));
+        }
+
+        GAME_TARGET_AVX512 inline uint32 NormalizeAvx512(V3Soa In, V3Soa Out, uint32 Count)
+        {
+            for (uint32 Index = 0; Index < Count; Index += 16)
+            {
+                auto Mask     = GetMaskAvx512(Index, Count);
+                auto X        = _mm512_maskz_loadu_ps(Mask, In.X + Index);
+                auto Y        = _mm512_maskz_loadu_ps(Mask, In.Y + Index);
+                auto Z        = _mm512_maskz_loadu_ps(Mask, In.Z + Index);
+                auto Squared  = DotAvx512(X, Y, Z, X, Y, Z);
+                auto IsLonger = _mm512_cmp_ps_mask(Squared, _mm512_setzero_ps(), _CMP_GT_OQ);
+                auto Root     = _mm512_maskz_sqrt_ps(IsLonger, Squared);
+                auto Scale    = _mm512_maskz_div_ps(IsLonger, _mm512_set1_ps(1.0f), Root);
+                _mm512_mask_storeu_ps(Out.X + Index, Mask, _mm512_mul_ps(X, Scale));
+                _mm512_mask_storeu_ps(Out.Y + Index, Mask, _mm512_mul_ps(Y, Scale));
+                _mm512_mask_storeu_ps(Out.Z + Index, Mask, _mm512_mul_ps(Z, Scale));
+            }
+            return Count;
+        }
+
+        GAME_TARGET_AVX512 inline uint32 DotAvx512(V3Soa A, V3Soa B, real32* Out, uint32 Count)
+        {
+            for (uint32 Index = 0; Index < Count; Index += 16)
+            {
+                auto Mask = GetMaskAvx512(Index, Count);
+                auto AX   = _mm512_maskz_loadu_ps(Mask, A.X + Index);
+                auto AY   = _mm512_maskz_loadu_ps(Mask, A.Y + Index);
+                auto AZ   = _mm512_maskz_loadu_ps(Mask, A.Z + Index);
+                auto BX   = _mm512_maskz_loadu_ps(Mask, B.X + Index);
+                auto BY   = _mm512_maskz_loadu_ps(Mask, B.Y + Index);
+                auto BZ   = _mm512_maskz_loadu_ps(Mask, B.Z + Index);
+                _mm512_mask_storeu_ps(Out + Index, Mask, DotAvx512(AX, AY, AZ, BX, BY, BZ));
+            }
+            return Count;
+        }
+
+        GAME_TARGET_AVX512 inline uint32 CrossAvx512(V3Soa A, V3Soa B, V3Soa Out, uint32 Count)
+        {
+            for (uint32 Index = 0; Index < Count; Index += 16)
+            {
+                auto Mask = GetMaskAvx512(Index, Count);
+                auto AX   = _mm512_maskz_loadu_ps(Mask, A.X + Index);
+                auto AY   = _mm512_maskz_loadu_ps(Mask, A.Y + Index);
+                auto AZ   = _mm512_maskz_loadu_ps(Mask, A.Z + Index);
+                auto BX   = _mm512_maskz_loadu_ps(Mask, B.X + Index);
+                auto BY   = _mm512_maskz_loadu_ps(Mask, B.Y + Index);
+                auto BZ   = _mm512_maskz_loadu_ps(Mask, B.Z + Index);
+                _mm512_mask_storeu_ps(Out.X + Index, Mask, _mm512_fmsub_ps(AY, BZ, _mm512_mul_ps(AZ, BY)));
+                _mm512_mask_storeu_ps(Out.Y + Index, Mask, _mm512_fmsub_ps(AZ, BX, _mm512_mul_ps(AX, BZ)));
+                _mm512_mask_storeu_ps(Out.Z + Index, Mask, _mm512_fmsub_ps(AX, BY, _mm512_mul_ps(AY, BX)));
+            }
+            return Count;
+        }
+    } // namespace MathBatch
+
+    // P = M * (P, 1) for each point
+    inline void TransformPoints(const m3x3& M, V2Soa In, V2Soa Out, uint32 Count, SimdLevel Level = GetBestSimdLevel())
+    {
+        auto Done = Level >= SimdLevel::Avx512 ? MathBatch::TransformPoints2Avx512(M, In, Out, Count)
+                    : Level == SimdLevel::Avx2 ? MathBatch::TransformPoints2Avx2(M, In, Out, Count)
+                    : Level == SimdLevel::Sse2 ? MathBatch::TransformPoints2Sse2(M, In, Out, Count)
+                                               : 0;
+        MathBatch::TransformPoints2Scalar(M, In, Out, Done, Count);
+    }
+
+    // P = M * (P, 1) for each point, the last row of M is ignored
+    inline void TransformPoints(const m4x4& M, V3Soa In, V3Soa Out, uint32 Count, SimdLevel Level = GetBestSimdLevel())
+    {
+        auto Done = Level >= SimdLevel::Avx512 ? MathBatch::TransformPoints3Avx512(M, In, Out, Count)
+                    : Level == SimdLevel::Avx2 ? MathBatch::TransformPoints3Avx2(M, In, Out, Count)
+                    : Level == SimdLevel::Sse2 ? MathBatch::TransformPoints3Sse2(M, In, Out, Count)
+                                               : 0;
+        MathBatch::TransformPoints3Scalar(M, In, Out, Done, Count);
+    }
+
+    // zero vectors stay zero
+    inline void Normalize(V3Soa In, V3Soa Out, uint32 Count, SimdLevel Level = GetBestSimdLevel())
+    {
+        auto Done = Level >= SimdLevel::Avx512 ? MathBatch::NormalizeAvx512(In, Out, Count)
+                    : Level == SimdLevel::Avx2 ? MathBatch::NormalizeAvx2(In, Out, Count)
+                    : Level == SimdLevel::Sse2 ? MathBatch::NormalizeSse2(In, Out, Count)
+                                               : 0;
+        MathBatch::NormalizeScalar(In, Out, Done, Count);
+    }
+
+    inline void Dot(V3Soa A, V3Soa B, real32* Out, uint32 Count, SimdLevel Level = GetBestSimdLevel())
+    {
+        auto Done = Level >= SimdLevel::Avx512 ? MathBatch::DotAvx512(A, B, Out, Count)
+                    : Level == SimdLevel::Avx2 ? MathBatch::DotAvx2(A, B, Out, Count)
+                    : Level == SimdLevel::Sse2 ? MathBatch::DotSse2(A, B, Out, Count)
+                                               : 0;
+        MathBatch::DotScalar(A, B, Out, Done, Count);
+    }
+
+    inline void Cross(V3Soa A, V3Soa B, V3Soa Out, uint32 Count, SimdLevel Level = GetBestSimdLevel())
+    {
+        auto Done = Level >= SimdLevel::Avx512 ? MathBatch::CrossAvx512(A, B, Out, Count)
+                    : Level == SimdLevel::Avx2 ? MathBatch::CrossAvx2(A, B, Out, Count)
+                    : Level == SimdLevel::Sse2 ? MathBatch::CrossSse2(A, B, Out, Count)
+                                               : 0;
+        MathBatch::CrossScalar(A, B, Out, Done, Count);
+    }
+
+} // namespace Game
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace Game
+{
+    // Linear allocator over a block of Game::Memory: no free, reset or restore a TemporaryMemory instead
+    struct MemoryArena
+    {
+        MemoryArena() = default;
+        MemoryArena(void* Base, uint64 Size)
+            : Base{ static_cast<uint8*>(Base) }
+            , Size{ Size }
+        {}
+
+        // Returns nullptr when the arena is full, Alignment must be a power of two
+        void* Push(uint64 PushSize, uint64 Alignment = 16)
+        {
+            auto Address = reinterpret_cast<uintptr_t>(Base + Used);
+            auto Padding = (Alignment - (Address & (Alignment - 1))) & (Alignment - 1);
+            if (Used + Padding + PushSize > Size)
+            {
+                return nullptr;
+            }
+            auto Result = Base + Used + Padding;
+            Used += Padding + PushSize;
+            return Result;
+        }
+
+        template <typename T>
+        T* PushArray(uint64 Count, uint64 Alignment = alignof(T))
+        {
+            return static_cast<T*>(Push(Count * sizeof(T), Alignment));
+        }
+
+        template <typename T>
+        T* PushStruct()
+        {
+            return PushArray<T>(1);
+        }
+
+        // a sub arena, for a subsystem owning its memory
+        MemoryArena PushArena(uint64 ArenaSize, uint64 Alignment = 64)
+        {
+            auto ArenaBase = Push(ArenaSize, Alignment);
+            return { ArenaBase, ArenaBase ? ArenaSize : 0 };
+        }
+
+        void   Reset() { Used = 0; }
+        uint64 GetUsed() const { return Used; }
+        uint64 GetSize() const { return Size; }
+        uint64 GetRemaining() const { return Size - Used; }
+
+        uint8* Base = nullptr;
+        uint64 Size = 0;
+        uint64 Used = 0;
+    };
+
+    // Everything pushed during its lifetime is released at destruction
+    class TemporaryMemory final
+    {
+    public:
+        explicit TemporaryMemory(MemoryArena& Arena)
+            : Arena{ Arena }
+            , Used{ Arena.Used }
+        {}
+        TemporaryMemory(const TemporaryMemory&) = delete; // non copyable
+        ~TemporaryMemory() { Arena.Used = Used; }
+
+    private:
+        MemoryArena& Arena;
+        uint64       Used;
+    };
+
+} // namespace Game
@@ -0,0 +1,470 @@
+#pragma once
+
+#include "memory_arena.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <thread>
+
+#if _MSC_VER
+#include <intrin.h>
+#endif
+
+// Metrics of the process: counters, gauges and histograms, updated on the hot paths with one relaxed atomic operation
+// each (an add, or a store for a gauge), no lock and no allocation. They are registered by name in a MetricRegistry,
+// once: registering a name again returns the same metric, the game dll finds its metrics back after a reload.
+//
+//     auto Underruns = Registry.AddCounter("audio_underruns");
+//     Underruns->Add();
+//
+// A MetricThread appends a record of every value to a MetricSeries at a fixed period. The series lays out a block of
+// memory, a file mapped by the platform, that a dashboard maps too and reads while it grows:
+//
+//   SeriesHeader          magic, layout, MetricCount and RecordCount (published with a release store)
+//   SeriesMetric[Max]     name, kind, and the values of the metric in a record
+//   Records[Capacity]     { Time, Values[ValueCount] }: nanoseconds since StartTime, then the values
+//
+// The file is append only, the records stop when it is full. A metric registered late has its values from the first
+// record which follows, zero before. A record is not a consistent cut: each value is read on its own.
+
+namespace Game
+{
+    enum class MetricKind : uint32
+    {
+        Counter, // uint64, only grows
+        Gauge, // int64, the last value set
+        Histogram // uint64[BucketCount], the number of values per power of two
+    };
+
+    namespace Metering
+    {
+        constexpr char   Magic[4]    = { 'G', 'M', 'T', 'S' };
+        constexpr uint32 Version     = 1;
+        constexpr uint32 NameSize    = 48; // null included
+        constexpr uint32 BucketCount = 32;
+
+        inline uint32 FindLastBit(uint64 Bits) // Bits != 0
+        {
+#if _MSC_VER
+            unsigned long Index;
+            _BitScanReverse64(&Index, Bits);
+            return Index;
+#else
+            return 63 - static_cast<uint32>(__builtin_clzll(Bits));
+#endif
+        }
+
+        // 0 in the bucket 0, [2^(B-1), 2^B) in the bucket B, the last one takes everything above
+        inline uint32 GetBucket(uint64 Value)
+        {
+            auto Bucket = Value ? FindLastBit(Value) + 1 : 0;
+            return Bucket < BucketCount ? Bucket : BucketCount - 1;
+        }
+
+        // the values of the bucket are under this limit (the last one has none)
+        inline uint64 GetBucketLimit(uint32 Bucket)
+        {
+            return Bucket + 1 < BucketCount ? uint64(1) << Bucket : ~uint64(0);
+        }
+
+        inline uint32 GetValueCount(MetricKind Kind)
+        {
+            return Kind == MetricKind::Histogram ? BucketCount : 1;
+        }
+
+        struct SeriesHeader
+        {
+            char                Magic[4];
+            uint32              Version;
+            uint32              MaxMetricCount;
+            uint32              ValueCount; // per record, after the time
+            uint64              StartTime; // system clock, nanoseconds since 1970
+            uint64              RecordOffset; // from the header
+            uint64              RecordCapacity;
+            std::atomic<uint32> MetricCount;
+            uint32              Padding;
+            std::atomic<uint64> RecordCount;
+        };
+
+        struct SeriesMetric
+        {
+            char       Name[NameSize];
+            MetricKind Kind;
+            uint32     FirstValue; // in a record
+            uint32     ValueCount;
+            uint32     Padding;
+        };
+
+        static_assert(std::atomic<uint64>::is_always_lock_free, "the header is shared with other processes");
+        static_assert(sizeof(SeriesMetric) == 64);
+    } // namespace Metering
+
+    class MetricCounter final
+    {
+    public:
+        void   Add(uint64 Count = 1) { Value.fetch_add(Count, std::memory_order_relaxed); }
+        uint64 Get() const { return Value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64> Value{ 0 };
+    };
+
+    class MetricGauge final
+    {
+    public:
+        void  Set(int64 Current) { Value.store(Current, std::memory_order_relaxed); }
+        void  Add(int64 Delta) { Value.fetch_add(Delta, std::memory_order_relaxed); }
+        int64 Get() const { return Value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<int64> Value{ 0 };
+    };
+
+    class MetricHistogram final
+    {
+    public:
+        void   Record(uint64 Value) { Buckets[Metering::GetBucket(Value)].fetch_add(1, std::memory_order_relaxed); }
+        uint64 GetBucket(uint32 Bucket) const { return Buckets[Bucket].load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64> Buckets[Metering::BucketCount] = {};
+    };
+
+    class MetricRegistry final
+    {
+    public:
+        // Up to MaxMetricCount metrics of MaxValueCount values in all (one per counter or gauge, BucketCount per
+        // histogram), pushed on Arena as they are registered: the arena is the registry's own
+        MetricRegistry(MemoryArena& Arena, uint32 MaxMetricCount, uint32 MaxValueCount)
+            : Arena{ Arena }
+            , Entries{ Arena.PushArray<Entry>(MaxMetricCount) }
+            , MaxMetricCount{ Entries ? MaxMetricCount : 0 }
+            , MaxValueCount{ MaxValueCount }
+        {}
+        MetricRegistry(const MetricRegistry&) = delete; // non copyable
+
+        bool   IsValid() const { return Entries != nullptr; }
+        uint32 GetMaxMetricCount() const { return MaxMetricCount; }
+        uint32 GetMaxValueCount() const { return MaxValueCount; }
+        uint32 GetCount() const { return Count.load(std::memory_order_acquire); }
+
+        // The metric of Name, registered by the first call; nullptr when the registry is full, the name too long, or
+        // registered with another kind
+        MetricCounter* AddCounter(std::string_view Name)
+        {
+            return static_cast<MetricCounter*>(Add(Name, MetricKind::Counter));
+        }
+        MetricGauge* AddGauge(std::string_view Name) { return static_cast<MetricGauge*>(Add(Name, MetricKind::Gauge)); }
+        MetricHistogram* AddHistogram(std::string_view Name)
+        {
+            return static_cast<MetricHistogram*>(Add(Name, MetricKind::Histogram));
+        }
+
+        // the name, kind and place in a record of a registered metric
+        Metering::SeriesMetric GetMetric(uint32 Index) const
+        {
+            Metering::SeriesMetric Metric = {};
+            memcpy(Metric.Name, Entries[Index].Name, sizeof(Metric.Name));
+            Metric.Kind       = Entries[Index].Kind;
+            Metric.FirstValue = Entries[Index].FirstValue;
+            Metric.ValueCount = Metering::GetValueCount(Metric.Kind);
+            return Metric;
+        }
+
+        // The values of the first MetricCount metrics at their place in Values, relaxed loads
+        void Snapshot(uint64* Values, uint32 MetricCount) const
+        {
+            for (uint32 Index = 0; Index < MetricCount; ++Index)
+            {
+                auto& Metric = Entries[Index];
+                auto  Out    = Values + Metric.FirstValue;
+                switch (Metric.Kind)
+                {
+                case MetricKind::Counter:
+                    *Out = static_cast<const MetricCounter*>(Metric.Data)->Get();
+                    break;
+                case MetricKind::Gauge:
+                    *Out = uint64(static_cast<const MetricGauge*>(Metric.Data)->Get());
+                    break;
+                case MetricKind::Histogram:
+                    for (uint32 Bucket = 0; Bucket < Metering::BucketCount; ++Bucket)
+                    {
+                        Out[Bucket] = static_cast<const MetricHistogram*>(Metric.Data)->GetBucket(Bucket);
+                    }
+                    break;
+                }
+            }
+        }
+
+    private:
+        struct Entry
+        {
+            char       Name[Metering::NameSize];
+            MetricKind Kind;
+            uint32     FirstValue;
+            void*      Data;
+        };
+
+        void* Add(std::string_view Name, MetricKind Kind)
+        {
+            if (Name.size() >= Metering::NameSize)
+            {
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> Lock{ Mutex };
+            auto                        Used = Count.load(std::memory_order_relaxed);
+            for (uint32 Index = 0; Index < Used; ++Index)
+            {
+                if (Name == Entries[Index].Name)
+                {
+                    return Entries[Index].Kind == Kind ? Entries[Index].Data : nullptr;
+                }
+            }
+            auto ValueCount = Metering::GetValueCount(Kind);
+            if (Used == MaxMetricCount || UsedValueCount + ValueCount > MaxValueCount)
+            {
+                return nullptr;
+            }
+            // a cache line of its own: the metrics of different threads do not share one
+            void* Data = nullptr;
+            switch (Kind)
+            {
+            case MetricKind::Counter:
+                Data = Construct<MetricCounter>();
+                break;
+            case MetricKind::Gauge:
+                Data = Construct<MetricGauge>();
+                break;
+            case MetricKind::Histogram:
+                Data = Construct<MetricHistogram>();
+                break;
+            }
+            if (!Data)
+            {
+                return nullptr;
+            }
+            auto& Metric = Entries[Used];
+            memset(Metric.Name, 0, sizeof(Metric.Name));
+            memcpy(Metric.Name, Name.data(), Name.size());
+            Metric.Kind       = Kind;
+            Metric.FirstValue = UsedValueCount;
+            Metric.Data       = Data;
+            UsedValueCount += ValueCount;
+            Count.store(Used + 1, std::memory_order_release);
+            return Data;
+        }
+
+        template <typename T>
+        T* Construct()
+        {
+            auto Memory = Arena.Push((sizeof(T) + 63) & ~size_t(63), 64);
+            return Memory ? new (Memory) T{} : nullptr;
+        }
+
+        MemoryArena&        Arena;
+        Entry*              Entries;
+        uint32              MaxMetricCount;
+        uint32              MaxValueCount;
+        uint32              UsedValueCount = 0;
+        std::atomic<uint32> Count{ 0 };
+        std::mutex          Mutex;
+    };
+
+    // Writes the records of a registry in a block of memory, see the layout above; Append from one thread at a time
+    class MetricSeries final
+    {
+    public:
+        // Data is zero filled (a new file) and aligned on 8 bytes; IsValid is false when not one record fits
+        MetricSeries(const MetricRegistry& Registry, void* Data, uint64 Size)
+            : Registry{ Registry }
+            , Start{ std::chrono::steady_clock::now() }
+        {
+            auto MetricCount  = Registry.GetMaxMetricCount();
+            auto RecordOffset = sizeof(Metering::SeriesHeader) + uint64(MetricCount) * sizeof(Metering::SeriesMetric);
+            auto RecordSize   = (1 + uint64(Registry.GetMaxValueCount())) * sizeof(uint64);
+            if (!Registry.IsValid() || !Data || reinterpret_cast<uintptr_t>(Data) % 8 != 0 ||
+                Size < RecordOffset + RecordSize)
+            {
+                return;
+            }
+            auto Now = std::chrono::system_clock::now().time_since_epoch();
+
+            Header = new (Data) Metering::SeriesHeader{};
+            memcpy(Header->Magic, Metering::Magic, sizeof(Header->Magic));
+            Header->Version        = Metering::Version;
+            Header->MaxMetricCount = MetricCount;
+            Header->ValueCount     = Registry.GetMaxValueCount();
+            Header->StartTime      = uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(Now).count());
+            Header->RecordOffset   = RecordOffset;
+            Header->RecordCapacity = (Size - RecordOffset) / RecordSize;
+            Metrics                = reinterpret_cast<Metering::SeriesMetric*>(Header + 1);
+        }
+        MetricSeries(const MetricSeries&) = delete; // non copyable
+
+        bool   IsValid() const { return Header != nullptr; }
+        uint64 GetRecordCount() const { return Header ? Header->RecordCount.load(std::memory_order_relaxed) : 0; }
+        uint64 GetRecordCapacity() const { return Header ? Header->RecordCapacity : 0; }
+
+        // A record of the metrics registered so far, false when the series is full
+        bool Append()
+        {
+            auto Record = GetRecordCount();
+            if (Record >= GetRecordCapacity())
+            {
+                return false;
+            }
+            // the metrics registered since the last record first: a reader finds the metrics of every record
+            auto MetricCount = Registry.GetCount();
+            auto Published   = Header->MetricCount.load(std::memory_order_relaxed);
+            for (auto Index = Published; Index < MetricCount; ++Index)
+            {
+                Metrics[Index] = Registry.GetMetric(Index);
+            }
+            Header->MetricCount.store(MetricCount, std::memory_order_release);
+
+            auto Elapsed = std::chrono::steady_clock::now() - Start;
+            auto Out     = reinterpret_cast<uint64*>(reinterpret_cast<uint8*>(Header) + Header->RecordOffset) +
+                       Record * (1 + Header->ValueCount);
+            Out[0] = uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(Elapsed).count());
+            Registry.Snapshot(Out + 1, MetricCount);
+            Header->RecordCount.store(Record + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        const MetricRegistry&                 Registry;
+        std::chrono::steady_clock::time_point Start;
+        Metering::SeriesHeader*               Header  = nullptr;
+        Metering::SeriesMetric*               Metrics = nullptr;
+    };
+
+    // The reader of a series, written by this process or another one
+    class MetricSeriesView final
+    {
+    public:
+        // false when Data is not a series of this version, or is too small for its layout
+        bool Open(const void* Data, uint64 Size)
+        {
+            Header = nullptr;
+            auto Candidate = static_cast<const Metering::SeriesHeader*>(Data);
+            if (!Data || Size < sizeof(Metering::SeriesHeader) ||
+                memcmp(Candidate->Magic, Metering::Magic, sizeof(Candidate->Magic)) != 0 ||
+                Candidate->Version != Metering::Version)
+            {
+                return false;
+            }
+            auto MetricSize = uint64(Candidate->MaxMetricCount) * sizeof(Metering::SeriesMetric);
+            auto Offset     = sizeof(Metering::SeriesHeader) + MetricSize;
+            auto RecordSize = (1 + uint64(Candidate->ValueCount)) * sizeof(uint64);
+            if (Candidate->RecordOffset != Offset || Size < Offset ||
+                Candidate->RecordCapacity > (Size - Offset) / RecordSize)
+            {
+                return false;
+            }
+            Header = Candidate;
+            return true;
+        }
+
+        bool   IsValid() const { return Header != nullptr; }
+        uint64 GetStartTime() const { return Header->StartTime; }
+
+        // the metrics of the records read after this call
+        uint32 GetMetricCount() const
+        {
+            auto Count = Header->MetricCount.load(std::memory_order_acquire);
+            return Count < Header->MaxMetricCount ? Count : Header->MaxMetricCount;
+        }
+
+        const Metering::SeriesMetric& GetMetric(uint32 Index) const
+        {
+            return reinterpret_cast<const Metering::SeriesMetric*>(Header + 1)[Index];
+        }
+
+        // nullptr when there is none
+        const Metering::SeriesMetric* FindMetric(std::string_view Name) const
+        {
+            for (uint32 Index = 0; Index < GetMetricCount(); ++Index)
+            {
+                auto& Metric = GetMetric(Index);
+                if (Name == std::string_view{ Metric.Name, strnlen(Metric.Name, sizeof(Metric.Name)) })
+                {
+                    return &Metric;
+                }
+            }
+            return nullptr;
+        }
+
+        uint64 GetRecordCount() const
+        {
+            auto Count = Header->RecordCount.load(std::memory_order_acquire);
+            return Count < Header->RecordCapacity ? Count : Header->RecordCapacity;
+        }
+
+        // nanoseconds since GetStartTime
+        uint64 GetTime(uint64 Record) const { return GetRecord(Record)[0]; }
+
+        // the values of Metric in Record, GetValueCount of them
+        const uint64* GetValues(uint64 Record, const Metering::SeriesMetric& Metric) const
+        {
+            return GetRecord(Record) + 1 + Metric.FirstValue;
+        }
+
+    private:
+        const uint64* GetRecord(uint64 Record) const
+        {
+            auto Records = reinterpret_cast<const uint8*>(Header) + Header->RecordOffset;
+            return reinterpret_cast<const uint64*>(Records) + Record * (1 + Header->ValueCount);
+        }
+
+        const Metering::SeriesHeader* Header = nullptr;
+    };
+
+    // Appends a record to a series every PeriodMilliseconds on its own thread, and once more when it stops
+    class MetricThread final
+    {
+    public:
+        MetricThread(MetricSeries& Series, uint32 PeriodMilliseconds = 1000)
+            : Series{ Series }
+            , Period{ PeriodMilliseconds }
+            , Worker{ [this] { Work(); } }
+        {}
+        MetricThread(const MetricThread&) = delete; // non copyable
+
+        ~MetricThread()
+        {
+            {
+                std::lock_guard<std::mutex> Lock{ Mutex };
+                IsStopping = true;
+            }
+            HasStopped.notify_all();
+            Worker.join();
+        }
+
+    private:
+        void Work()
+        {
+            std::unique_lock<std::mutex> Lock{ Mutex };
+            while (!HasStopped.wait_for(Lock, std::chrono::milliseconds(Period), [this] { return IsStopping; }))
+            {
+                Lock.unlock();
+                Series.Append();
+                Lock.lock();
+            }
+            Series.Append();
+        }
+
+        MetricSeries&           Series;
+        uint32                  Period;
+        std::mutex              Mutex;
+        std::condition_variable HasStopped;
+        bool                    IsStopping = false;
+        std::thread             Worker; // last: starts once the rest is ready
+    };
+
+} // namespace Game
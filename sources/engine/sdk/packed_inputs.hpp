@@ -0,0 +1,303 @@
+#pragma once
+
+#include "game_inputs.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+// Compact Inputs for replays and the network: 100 bytes instead of 800, then about a byte per frame once delta encoded.
+//
+// A packed game pad keeps the buttons as bitsets (EndedDown, and HalfTransitionCount saturated to 3 on 2 bits) and the
+// sticks and triggers as int16 (1/32767 steps, clamped to [-1, 1]). A delta against the previous frame is a byte of
+// changed pads, then for each of them a byte of changed fields and the fields: LEB128 varints of the EndedDown xor, of
+// the transitions and of the zigzagged axis differences, the flags as a byte. An idle frame is the single byte 0.
+// Pack and Unpack convert a pad with SSE2, the x64 baseline, without a loop over the buttons.
+
+namespace Game
+{
+    struct PackedGamePad
+    {
+        int16  Axes[6]     = {}; // LeftStickX, LeftStickY, RightStickX, RightStickY, LeftTrigger, RightTrigger
+        uint32 Transitions = 0;  // 2 bits per button, the HalfTransitionCount saturated to 3
+        uint16 EndedDown   = 0;  // a bit per button
+        uint16 Flags       = 0;  // IsConnected, IsAnalog
+    };
+
+    inline bool operator==(const PackedGamePad& A, const PackedGamePad& B)
+    {
+        return A.Transitions == B.Transitions && A.EndedDown == B.EndedDown && A.Flags == B.Flags &&
+               memcmp(A.Axes, B.Axes, sizeof(A.Axes)) == 0;
+    }
+    inline bool operator!=(const PackedGamePad& A, const PackedGamePad& B) { return !(A == B); }
+
+    struct PackedInputs
+    {
+        static constexpr uint32 PadCount = Inputs::GamePadCount + 1; // the keyboard last
+        PackedGamePad           Pads[PadCount];
+    };
+
+    inline bool operator==(const PackedInputs& A, const PackedInputs& B)
+    {
+        for (uint32 Pad = 0; Pad < PackedInputs::PadCount; ++Pad)
+        {
+            if (A.Pads[Pad] != B.Pads[Pad])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    inline bool operator!=(const PackedInputs& A, const PackedInputs& B) { return !(A == B); }
+
+    namespace InputPacking
+    {
+        constexpr uint32 ButtonCount = 16;
+        constexpr uint32 AxisCount   = 6;
+        constexpr real32 AxisScale   = 32767.0f;
+
+        // fields of a changed pad
+        constexpr uint8 ButtonsChanged = 1 << 0;
+        constexpr uint8 FlagsChanged   = 1 << 1;
+        constexpr uint8 AxisChanged    = 1 << 2; // shifted by the axis index
+
+        // mask, then per pad: fields, EndedDown (3), transitions (5), flags (1), axes (3 each)
+        constexpr uint32 MaxDeltaSize = 1 + PackedInputs::PadCount * (1 + 3 + 5 + 1 + AxisCount * 3);
+
+        // 16 bits to the even bits of 32
+        inline uint32 Spread(uint32 Bits)
+        {
+            Bits = (Bits | Bits << 8) & 0x00FF00FF;
+            Bits = (Bits | Bits << 4) & 0x0F0F0F0F;
+            Bits = (Bits | Bits << 2) & 0x33333333;
+            return (Bits | Bits << 1) & 0x55555555;
+        }
+
+        // SSE2: 4 buttons per register, the counts and EndedDown apart, then a byte per button for the masks
+        inline PackedGamePad Pack(const GamePad& Pad)
+        {
+            static_assert(offsetof(GamePad, RightTrigger) == offsetof(GamePad, LeftStickX) + 5 * sizeof(real32));
+
+            auto    Buttons = reinterpret_cast<const __m128i*>(Pad.Buttons);
+            __m128i Counts[4];
+            __m128i Downs[4];
+            for (uint32 Group = 0; Group < 4; ++Group)
+            {
+                auto Low      = _mm_shuffle_epi32(_mm_loadu_si128(Buttons + 2 * Group), _MM_SHUFFLE(3, 1, 2, 0));
+                auto High     = _mm_shuffle_epi32(_mm_loadu_si128(Buttons + 2 * Group + 1), _MM_SHUFFLE(3, 1, 2, 0));
+                Counts[Group] = _mm_unpacklo_epi64(Low, High);
+                Downs[Group]  = _mm_unpackhi_epi64(Low, High);
+            }
+            auto Zero  = _mm_setzero_si128();
+            auto Count = _mm_packus_epi16(_mm_packs_epi32(Counts[0], Counts[1]), _mm_packs_epi32(Counts[2], Counts[3]));
+            auto Down  = _mm_packs_epi16(_mm_packs_epi32(Downs[0], Downs[1]), _mm_packs_epi32(Downs[2], Downs[3]));
+            Count      = _mm_min_epu8(Count, _mm_set1_epi8(3));
+            auto Bit0  = uint32(_mm_movemask_epi8(_mm_slli_epi16(Count, 7)));
+            auto Bit1  = uint32(_mm_movemask_epi8(_mm_slli_epi16(Count, 6)));
+
+            PackedGamePad Result;
+            Result.Transitions = Spread(Bit0) | Spread(Bit1) << 1;
+            Result.EndedDown   = uint16(~_mm_movemask_epi8(_mm_cmpeq_epi8(Down, Zero)));
+            Result.Flags       = uint16((Pad.IsConnected != 0) | (Pad.IsAnalog != 0) << 1);
+
+            // rounded to the nearest, ties to even
+            auto Sticks   = _mm_loadu_ps(&Pad.LeftStickX);
+            auto Triggers = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(&Pad.LeftTrigger)));
+            auto Minimum  = _mm_set1_ps(-1.0f);
+            auto Maximum  = _mm_set1_ps(1.0f);
+            auto Scale    = _mm_set1_ps(AxisScale);
+            Sticks        = _mm_mul_ps(_mm_min_ps(_mm_max_ps(Sticks, Minimum), Maximum), Scale);
+            Triggers      = _mm_mul_ps(_mm_min_ps(_mm_max_ps(Triggers, Minimum), Maximum), Scale);
+            auto Axes     = _mm_packs_epi32(_mm_cvtps_epi32(Sticks), _mm_cvtps_epi32(Triggers));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(Result.Axes), Axes);
+            auto Last = _mm_cvtsi128_si32(_mm_srli_si128(Axes, 8));
+            memcpy(Result.Axes + 4, &Last, sizeof(Last));
+            return Result;
+        }
+
+        // SSE2: the 2 bits of a count and the bit of EndedDown moved to the top of 16 bits lanes, then shifted down
+        inline void Unpack(const PackedGamePad& Packed, GamePad& Pad)
+        {
+            auto Buttons     = reinterpret_cast<__m128i*>(Pad.Buttons);
+            auto Zero        = _mm_setzero_si128();
+            auto CountShifts = _mm_setr_epi16(1 << 14, 1 << 12, 1 << 10, 1 << 8, 1 << 6, 1 << 4, 1 << 2, 1);
+            auto DownShifts  = _mm_setr_epi16(1 << 15, 1 << 14, 1 << 13, 1 << 12, 1 << 11, 1 << 10, 1 << 9, 1 << 8);
+            for (uint32 Half = 0; Half < 2; ++Half)
+            {
+                auto Transitions = _mm_set1_epi16(int16(Packed.Transitions >> (16 * Half)));
+                auto EndedDown   = _mm_set1_epi16(int16(Packed.EndedDown >> (8 * Half)));
+                auto Counts      = _mm_srli_epi16(_mm_mullo_epi16(Transitions, CountShifts), 14);
+                auto Downs       = _mm_srli_epi16(_mm_mullo_epi16(EndedDown, DownShifts), 15);
+                auto Low         = _mm_unpacklo_epi16(Counts, Zero);
+                auto High        = _mm_unpackhi_epi16(Counts, Zero);
+                auto DownLow     = _mm_unpacklo_epi16(Downs, Zero);
+                auto DownHigh    = _mm_unpackhi_epi16(Downs, Zero);
+                _mm_storeu_si128(Buttons + 4 * Half + 0, _mm_unpacklo_epi32(Low, DownLow));
+                _mm_storeu_si128(Buttons + 4 * Half + 1, _mm_unpackhi_epi32(Low, DownLow));
+                _mm_storeu_si128(Buttons + 4 * Half + 2, _mm_unpacklo_epi32(High, DownHigh));
+                _mm_storeu_si128(Buttons + 4 * Half + 3, _mm_unpackhi_epi32(High, DownHigh));
+            }
+            Pad.IsConnected = Packed.Flags & 1;
+            Pad.IsAnalog    = Packed.Flags >> 1 & 1;
+
+            auto Inverse  = _mm_set1_ps(1.0f / AxisScale);
+            auto Axes     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Packed.Axes)); // Transitions after
+            auto Sticks   = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(Axes, Axes), 16));
+            auto Triggers = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(Axes, Axes), 16));
+            _mm_storeu_ps(&Pad.LeftStickX, _mm_mul_ps(Sticks, Inverse));
+            _mm_storel_pi(reinterpret_cast<__m64*>(&Pad.LeftTrigger), _mm_mul_ps(Triggers, Inverse));
+        }
+
+        inline PackedInputs Pack(const Inputs& Value)
+        {
+            PackedInputs Result;
+            for (uint32 Pad = 0; Pad < Inputs::GamePadCount; ++Pad)
+            {
+                Result.Pads[Pad] = Pack(Value.GamePads[Pad]);
+            }
+            Result.Pads[Inputs::GamePadCount] = Pack(Value.Keyboard);
+            return Result;
+        }
+
+        inline void Unpack(const PackedInputs& Packed, Inputs& Value)
+        {
+            for (uint32 Pad = 0; Pad < Inputs::GamePadCount; ++Pad)
+            {
+                Unpack(Packed.Pads[Pad], Value.GamePads[Pad]);
+            }
+            Unpack(Packed.Pads[Inputs::GamePadCount], Value.Keyboard);
+        }
+
+        inline uint8* WriteVarint(uint8* Out, uint32 Value)
+        {
+            while (Value >= 0x80)
+            {
+                *Out++ = uint8(Value | 0x80);
+                Value >>= 7;
+            }
+            *Out++ = uint8(Value);
+            return Out;
+        }
+
+        // nullptr past End or on more than 5 bytes
+        inline const uint8* ReadVarint(const uint8* In, const uint8* End, uint32& Value)
+        {
+            Value = 0;
+            for (uint32 Shift = 0; Shift < 35 && In < End; Shift += 7)
+            {
+                auto Byte = *In++;
+                Value |= uint32(Byte & 0x7F) << Shift;
+                if (!(Byte & 0x80))
+                {
+                    return In;
+                }
+            }
+            return nullptr;
+        }
+
+        inline uint32 ZigZag(int32 Value) { return uint32(Value) << 1 ^ uint32(Value >> 31); }
+        inline int32  UnZigZag(uint32 Value) { return int32(Value >> 1) ^ -int32(Value & 1); }
+
+        // Writes at most MaxDeltaSize bytes, returns their count
+        inline uint32 EncodeDelta(const PackedInputs& Previous, const PackedInputs& Current, uint8* Output)
+        {
+            auto Out  = Output + 1;
+            Output[0] = 0;
+            for (uint32 Pad = 0; Pad < PackedInputs::PadCount; ++Pad)
+            {
+                auto& Old    = Previous.Pads[Pad];
+                auto& New    = Current.Pads[Pad];
+                uint8 Fields = 0;
+                Fields |= New.EndedDown != Old.EndedDown || New.Transitions != Old.Transitions ? ButtonsChanged : 0;
+                Fields |= New.Flags != Old.Flags ? FlagsChanged : 0;
+                for (uint32 Axis = 0; Axis < AxisCount; ++Axis)
+                {
+                    Fields |= New.Axes[Axis] != Old.Axes[Axis] ? AxisChanged << Axis : 0;
+                }
+                if (!Fields)
+                {
+                    continue;
+                }
+                Output[0] |= uint8(1 << Pad);
+                *Out++ = Fields;
+                if (Fields & ButtonsChanged)
+                {
+                    Out = WriteVarint(Out, uint32(New.EndedDown ^ Old.EndedDown));
+                    Out = WriteVarint(Out, New.Transitions);
+                }
+                if (Fields & FlagsChanged)
+                {
+                    *Out++ = uint8(New.Flags);
+                }
+                for (uint32 Axis = 0; Axis < AxisCount; ++Axis)
+                {
+                    if (Fields & (AxisChanged << Axis))
+                    {
+                        Out = WriteVarint(Out, ZigZag(int32(New.Axes[Axis]) - Old.Axes[Axis]));
+                    }
+                }
+            }
+            return uint32(Out - Output);
+        }
+
+        // Returns the bytes read, 0 when Input is truncated or corrupted
+        inline uint32 DecodeDelta(const PackedInputs& Previous, const uint8* Input, uint32 Size, PackedInputs& Current)
+        {
+            auto In  = Input;
+            auto End = Input + Size;
+            if (In == End || *In >> PackedInputs::PadCount)
+            {
+                return 0;
+            }
+            auto Pads = *In++;
+            Current   = Previous;
+            for (uint32 Pad = 0; Pad < PackedInputs::PadCount; ++Pad)
+            {
+                if (!(Pads >> Pad & 1))
+                {
+                    continue;
+                }
+                if (In == End)
+                {
+                    return 0;
+                }
+                auto   Fields = *In++;
+                auto&  New    = Current.Pads[Pad];
+                uint32 Value  = 0;
+                if (Fields & ButtonsChanged)
+                {
+                    In            = ReadVarint(In, End, Value);
+                    New.EndedDown = uint16(New.EndedDown ^ Value);
+                    In            = In ? ReadVarint(In, End, New.Transitions) : nullptr;
+                    if (!In || Value >> ButtonCount)
+                    {
+                        return 0;
+                    }
+                }
+                if (Fields & FlagsChanged)
+                {
+                    if (In == End)
+                    {
+                        return 0;
+                    }
+                    New.Flags = *In++;
+                }
+                for (uint32 Axis = 0; Axis < AxisCount; ++Axis)
+                {
+                    if (Fields & (AxisChanged << Axis))
+                    {
+                        In = ReadVarint(In, End, Value);
+                        if (!In)
+                        {
+                            return 0;
+                        }
+                        New.Axes[Axis] = int16(New.Axes[Axis] + UnZigZag(Value));
+                    }
+                }
+            }
+            return uint32(In - Input);
+        }
+    } // namespace InputPacking
+
+} // namespace Game
@@ -0,0 +1,531 @@
+#pragma once
+
+#include "game.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+#include "memory_arena.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// Point particles with a position, a velocity, a remaining life in seconds and a color, stored as arrays (one per
+// field) pushed on an arena.
+//
+// Update moves them in batches, in parallel, and drops the dead ones: a first pass counts the survivors of each batch,
+// a second one writes them packed, in order, to the other set of arrays. The SIMD kernels do not branch per particle:
+// the survivors of 8 (AVX2) or 16 (AVX-512) lanes are moved to the front of the vector and stored with a mask. The
+// SSE2 level uses the scalar kernel (no variable shuffle nor masked store).
+//
+// Draw adds the colors to the pixels of a 32-bit PIBackBuffer, saturated per channel: the particles are sorted by
+// band of 16 rows with a counting sort, then the bands are drawn in parallel. Smaller tiles make the sort scatter
+// to too many places at once, it costs more than the pixels it keeps in the L1 cache.
+
+namespace Game
+{
+    struct Particle
+    {
+        v2     Position; // in pixels
+        v2     Velocity; // in pixels per second
+        real32 Life;     // seconds left
+        uint32 Color;    // 0xXXRRGGBB, added to the pixels
+    };
+
+    namespace Particles
+    {
+        constexpr uint32 BatchSize  = 16384; // particles per job
+        constexpr uint32 BandShift  = 4;     // a band of the buffer, the bin of the counting sort, is 16 rows
+        constexpr uint32 BandHeight = 1 << BandShift;
+
+        struct Columns
+        {
+            real32* X;
+            real32* Y;
+            real32* VelocityX;
+            real32* VelocityY;
+            real32* Life;
+            uint32* Color;
+        };
+
+        inline Columns Offset(const Columns& Base, uint32 Index)
+        {
+            return { Base.X + Index,         Base.Y + Index,    Base.VelocityX + Index,
+                     Base.VelocityY + Index, Base.Life + Index, Base.Color + Index };
+        }
+
+        // Update kernels: moves the Count particles of In, writes the survivors of Dt to Out, returns their count
+
+        inline uint32 UpdateScalar(const Columns& In, const Columns& Out, uint32 Count, real32 Dt, v2 Gravity)
+        {
+            // the velocity change once, like the SIMD kernels: no multiply left to contract into an FMA
+            auto   GravityX = Gravity.X * Dt;
+            auto   GravityY = Gravity.Y * Dt;
+            uint32 Written  = 0;
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                auto Life = In.Life[Index] - Dt;
+                if (Life > 0.0f)
+                {
+                    auto VelocityX         = In.VelocityX[Index] + GravityX;
+                    auto VelocityY         = In.VelocityY[Index] + GravityY;
+                    Out.X[Written]         = In.X[Index] + VelocityX * Dt;
+                    Out.Y[Written]         = In.Y[Index] + VelocityY * Dt;
+                    Out.VelocityX[Written] = VelocityX;
+                    Out.VelocityY[Written] = VelocityY;
+                    Out.Life[Written]      = Life;
+                    Out.Color[Written]     = In.Color[Index];
+                    ++Written;
+                }
+            }
+            return Written;
+        }
+
+        inline uint32 CountAliveScalar(const real32* Life, uint32 Count, real32 Dt)
+        {
+            uint32 Alive = 0;
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                Alive += Life[Index] - Dt > 0.0f;
+            }
+            return Alive;
+        }
+
+        inline uint32 CountBits(uint32 Mask)
+        {
+            Mask = Mask - ((Mask >> 1) & 0x55);
+            Mask = (Mask & 0x33) + ((Mask >> 2) & 0x33);
+            return (Mask + (Mask >> 4)) & 0x0F;
+        }
+
+        // indices of the set bits of Mask first, as a permutation for _mm256_permutevar8x32
+        GAME_TARGET_AVX2 inline __m256i GetPackingAvx2(uint32 Mask)
+        {
+            auto Lanes   = _pdep_u64(Mask, 0x0101010101010101ull) * 0xFF;
+            auto Indices = _pext_u64(0x0706050403020100ull, Lanes);
+            return _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<int64>(Indices)));
+        }
+
+        GAME_TARGET_AVX2 inline void StorePackedAvx2(real32* Out, __m256 Value, __m256i Packing, __m256i Stored)
+        {
+            _mm256_maskstore_ps(Out, Stored, _mm256_permutevar8x32_ps(Value, Packing));
+        }
+
+        GAME_TARGET_AVX2 inline uint32
+        UpdateAvx2(const Columns& In, const Columns& Out, uint32 Count, real32 Dt, v2 Gravity)
+        {
+            auto   Dt8      = _mm256_set1_ps(Dt);
+            auto   GravityX = _mm256_set1_ps(Gravity.X * Dt);
+            auto   GravityY = _mm256_set1_ps(Gravity.Y * Dt);
+            auto   Lanes    = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            uint32 Written  = 0;
+            uint32 Index    = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto Life       = _mm256_sub_ps(_mm256_loadu_ps(In.Life + Index), Dt8);
+                auto IsAlive    = _mm256_cmp_ps(Life, _mm256_setzero_ps(), _CMP_GT_OQ);
+                auto Alive      = static_cast<uint32>(_mm256_movemask_ps(IsAlive));
+                auto Packing    = GetPackingAvx2(Alive);
+                auto AliveCount = CountBits(Alive);
+                auto Stored     = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int32>(AliveCount)), Lanes);
+                auto VelocityX  = _mm256_add_ps(_mm256_loadu_ps(In.VelocityX + Index), GravityX);
+                auto VelocityY  = _mm256_add_ps(_mm256_loadu_ps(In.VelocityY + Index), GravityY);
+                auto X          = _mm256_fmadd_ps(VelocityX, Dt8, _mm256_loadu_ps(In.X + Index));
+                auto Y          = _mm256_fmadd_ps(VelocityY, Dt8, _mm256_loadu_ps(In.Y + Index));
+                auto Color      = _mm256_loadu_ps(reinterpret_cast<const real32*>(In.Color + Index));
+                StorePackedAvx2(Out.X + Written, X, Packing, Stored);
+                StorePackedAvx2(Out.Y + Written, Y, Packing, Stored);
+                StorePackedAvx2(Out.VelocityX + Written, VelocityX, Packing, Stored);
+                StorePackedAvx2(Out.VelocityY + Written, VelocityY, Packing, Stored);
+                StorePackedAvx2(Out.Life + Written, Life, Packing, Stored);
+                StorePackedAvx2(reinterpret_cast<real32*>(Out.Color + Written), Color, Packing, Stored);
+                Written += AliveCount;
+            }
+            return Written + UpdateScalar(Offset(In, Index), Offset(Out, Written), Count - Index, Dt, Gravity);
+        }
+
+        GAME_TARGET_AVX2 inline uint32 CountAliveAvx2(const real32* Life, uint32 Count, real32 Dt)
+        {
+            auto   Dt8   = _mm256_set1_ps(Dt);
+            auto   Alive = _mm256_setzero_si256();
+            uint32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto Left    = _mm256_sub_ps(_mm256_loadu_ps(Life + Index), Dt8);
+                auto IsAlive = _mm256_cmp_ps(Left, _mm256_setzero_ps(), _CMP_GT_OQ);
+                Alive        = _mm256_sub_epi32(Alive, _mm256_castps_si256(IsAlive)); // -1 per survivor
+            }
+            uint32 Lanes[8];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(Lanes), Alive);
+            uint32 Total = 0;
+            for (auto Lane : Lanes)
+            {
+                Total += Lane;
+            }
+            return Total + CountAliveScalar(Life + Index, Count - Index, Dt);
+        }
+
+        GAME_TARGET_AVX512 inline uint32
+        UpdateAvx512(const Columns& In, const Columns& Out, uint32 Count, real32 Dt, v2 Gravity)
+        {
+            auto   Dt16     = _mm512_set1_ps(Dt);
+            auto   GravityX = _mm512_set1_ps(Gravity.X * Dt);
+            auto   GravityY = _mm512_set1_ps(Gravity.Y * Dt);
+            uint32 Written  = 0;
+            for (uint32 Index = 0; Index < Count; Index += 16)
+            {
+                auto Rest      = Count - Index;
+                auto Loaded    = static_cast<__mmask16>(Rest >= 16 ? 0xFFFF : (1u << Rest) - 1);
+                auto Life      = _mm512_sub_ps(_mm512_maskz_loadu_ps(Loaded, In.Life + Index), Dt16);
+                auto Alive     = _mm512_mask_cmp_ps_mask(Loaded, Life, _mm512_setzero_ps(), _CMP_GT_OQ);
+                auto VelocityX = _mm512_add_ps(_mm512_maskz_loadu_ps(Loaded, In.VelocityX + Index), GravityX);
+                auto VelocityY = _mm512_add_ps(_mm512_maskz_loadu_ps(Loaded, In.VelocityY + Index), GravityY);
+                auto X         = _mm512_fmadd_ps(VelocityX, Dt16, _mm512_maskz_loadu_ps(Loaded, In.X + Index));
+                auto Y         = _mm512_fmadd_ps(VelocityY, Dt16, _mm512_maskz_loadu_ps(Loaded, In.Y + Index));
+                auto Color     = _mm512_maskz_loadu_epi32(Loaded, In.Color + Index);
+                _mm512_mask_compressstoreu_ps(Out.X + Written, Alive, X);
+                _mm512_mask_compressstoreu_ps(Out.Y + Written, Alive, Y);
+                _mm512_mask_compressstoreu_ps(Out.VelocityX + Written, Alive, VelocityX);
+                _mm512_mask_compressstoreu_ps(Out.VelocityY + Written, Alive, VelocityY);
+                _mm512_mask_compressstoreu_ps(Out.Life + Written, Alive, Life);
+                _mm512_mask_compressstoreu_epi32(Out.Color + Written, Alive, Color);
+                Written += CountBits(Alive & 0xFF) + CountBits(Alive >> 8);
+            }
+            return Written;
+        }
+
+        struct Viewport
+        {
+            real32 Width;
+            real32 Height;
+            uint32 RowPixels; // pitch of the buffer in pixels
+            uint32 OutBand;   // of the particles out of the buffer
+        };
+
+        // Locate kernels: band and pixel (from the start of the buffer) of Count particles. The compares reject NaN,
+        // the conversions happen in range only, without a branch.
+
+        inline void LocateScalar(const real32*   X,
+                                 const real32*   Y,
+                                 uint32          Count,
+                                 const Viewport& View,
+                                 uint32*         Bands,
+                                 uint32*         Pixels)
+        {
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                auto Inside = (X[Index] >= 0.0f) & (Y[Index] >= 0.0f) & (X[Index] < View.Width) &
+                              (Y[Index] < View.Height);
+                auto PixelX = Inside ? static_cast<uint32>(X[Index]) : 0;
+                auto PixelY = Inside ? static_cast<uint32>(Y[Index]) : 0;
+                Bands[Index]  = Inside ? PixelY >> BandShift : View.OutBand;
+                Pixels[Index] = PixelY * View.RowPixels + PixelX;
+            }
+        }
+
+        inline void LocateSse2(const real32*   X,
+                               const real32*   Y,
+                               uint32          Count,
+                               const Viewport& View,
+                               uint32*         Bands,
+                               uint32*         Pixels)
+        {
+            auto   Zero      = _mm_setzero_ps();
+            auto   Width     = _mm_set1_ps(View.Width);
+            auto   Height    = _mm_set1_ps(View.Height);
+            auto   RowPixels = _mm_set1_epi32(static_cast<int32>(View.RowPixels));
+            auto   OutBand   = _mm_set1_epi32(static_cast<int32>(View.OutBand));
+            uint32 Index     = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto X4     = _mm_loadu_ps(X + Index);
+                auto Y4     = _mm_loadu_ps(Y + Index);
+                auto Low    = _mm_and_ps(_mm_cmpge_ps(X4, Zero), _mm_cmpge_ps(Y4, Zero));
+                auto High   = _mm_and_ps(_mm_cmplt_ps(X4, Width), _mm_cmplt_ps(Y4, Height));
+                auto Inside = _mm_castps_si128(_mm_and_ps(Low, High));
+                auto PixelX = _mm_and_si128(_mm_cvttps_epi32(X4), Inside);
+                auto PixelY = _mm_and_si128(_mm_cvttps_epi32(Y4), Inside);
+                // no _mm_mullo_epi32 before SSE4.1: even and odd lanes
+                auto Even   = _mm_mul_epu32(PixelY, RowPixels);
+                auto Odd    = _mm_mul_epu32(_mm_srli_epi64(PixelY, 32), RowPixels);
+                auto Row    = _mm_unpacklo_epi32(_mm_shuffle_epi32(Even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                                 _mm_shuffle_epi32(Odd, _MM_SHUFFLE(0, 0, 2, 0)));
+                auto Band   = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(PixelY, BandShift), Inside),
+                                           _mm_andnot_si128(Inside, OutBand));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Bands + Index), Band);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Pixels + Index), _mm_add_epi32(Row, PixelX));
+            }
+            LocateScalar(X + Index, Y + Index, Count - Index, View, Bands + Index, Pixels + Index);
+        }
+
+        GAME_TARGET_AVX2 inline void LocateAvx2(const real32*   X,
+                                                const real32*   Y,
+                                                uint32          Count,
+                                                const Viewport& View,
+                                                uint32*         Bands,
+                                                uint32*         Pixels)
+        {
+            auto   Zero      = _mm256_setzero_ps();
+            auto   Width     = _mm256_set1_ps(View.Width);
+            auto   Height    = _mm256_set1_ps(View.Height);
+            auto   RowPixels = _mm256_set1_epi32(static_cast<int32>(View.RowPixels));
+            auto   OutBand   = _mm256_set1_epi32(static_cast<int32>(View.OutBand));
+            uint32 Index     = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto X8     = _mm256_loadu_ps(X + Index);
+                auto Y8     = _mm256_loadu_ps(Y + Index);
+                auto Low    = _mm256_and_ps(_mm256_cmp_ps(X8, Zero, _CMP_GE_OQ), _mm256_cmp_ps(Y8, Zero, _CMP_GE_OQ));
+                auto Right  = _mm256_cmp_ps(X8, Width, _CMP_LT_OQ);
+                auto High   = _mm256_and_ps(Right, _mm256_cmp_ps(Y8, Height, _CMP_LT_OQ));
+                auto Inside = _mm256_castps_si256(_mm256_and_ps(Low, High));
+                auto PixelX = _mm256_and_si256(_mm256_cvttps_epi32(X8), Inside);
+                auto PixelY = _mm256_and_si256(_mm256_cvttps_epi32(Y8), Inside);
+                auto Pixel  = _mm256_add_epi32(_mm256_mullo_epi32(PixelY, RowPixels), PixelX);
+                auto Band   = _mm256_blendv_epi8(OutBand, _mm256_srli_epi32(PixelY, BandShift), Inside);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(Bands + Index), Band);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(Pixels + Index), Pixel);
+            }
+            LocateScalar(X + Index, Y + Index, Count - Index, View, Bands + Index, Pixels + Index);
+        }
+
+        // Pixel kernels: adds the color to the pixel, saturated per channel
+        inline void AddPixelScalar(uint32* Pixel, uint32 Color)
+        {
+            uint32 Result = 0;
+            for (int Shift = 0; Shift < 32; Shift += 8)
+            {
+                auto Channel = ((*Pixel >> Shift) & 0xFF) + ((Color >> Shift) & 0xFF);
+                Result |= (Channel < 0xFF ? Channel : 0xFF) << Shift;
+            }
+            *Pixel = Result;
+        }
+
+        inline void AddPixelSse2(uint32* Pixel, uint32 Color)
+        {
+            auto Sum = _mm_adds_epu8(_mm_cvtsi32_si128(static_cast<int32>(*Pixel)),
+                                     _mm_cvtsi32_si128(static_cast<int32>(Color)));
+            *Pixel   = static_cast<uint32>(_mm_cvtsi128_si32(Sum));
+        }
+    } // namespace Particles
+
+    class ParticleSystem final
+    {
+    public:
+        // Two sets of arrays are pushed on Arena
+        ParticleSystem(MemoryArena& Arena, uint32 MaxParticleCount)
+            : Front{ PushColumns(Arena, MaxParticleCount) }
+            , Back{ PushColumns(Arena, MaxParticleCount) }
+            , MaxParticleCount{ Front.Color && Back.Color ? MaxParticleCount : 0 }
+        {}
+        ParticleSystem(const ParticleSystem&) = delete; // non copyable
+
+        // Returns false when the system is full
+        bool Spawn(const Particle& Value)
+        {
+            if (ParticleCount == MaxParticleCount)
+            {
+                return false;
+            }
+            Front.X[ParticleCount]         = Value.Position.X;
+            Front.Y[ParticleCount]         = Value.Position.Y;
+            Front.VelocityX[ParticleCount] = Value.Velocity.X;
+            Front.VelocityY[ParticleCount] = Value.Velocity.Y;
+            Front.Life[ParticleCount]      = Value.Life;
+            Front.Color[ParticleCount]     = Value.Color;
+            ++ParticleCount;
+            return true;
+        }
+
+        // In spawn order, the dead ones removed
+        Particle Get(uint32 Index) const
+        {
+            return { { Front.X[Index], Front.Y[Index] },
+                     { Front.VelocityX[Index], Front.VelocityY[Index] },
+                     Front.Life[Index],
+                     Front.Color[Index] };
+        }
+
+        uint32 GetCount() const { return ParticleCount; }
+        uint32 GetMaxCount() const { return MaxParticleCount; }
+
+        // Ages the particles by Dt, removes the dead ones, then accelerates (Gravity, in pixels per second squared)
+        // and moves the others. The batch offsets are pushed on Scratch and released.
+        void Update(real32       Dt,
+                    v2           Gravity,
+                    MemoryArena& Scratch,
+                    JobSystem*   Jobs  = nullptr,
+                    SimdLevel    Level = GetBestSimdLevel())
+        {
+            TemporaryMemory Memory{ Scratch };
+
+            auto BatchCount = (ParticleCount + Particles::BatchSize - 1) / Particles::BatchSize;
+            auto Offsets    = Scratch.PushArray<uint32>(BatchCount + 1);
+            if (!Offsets)
+            {
+                return;
+            }
+            Offsets[0] = 0;
+            ParallelFor(Jobs, BatchCount, [&](uint32 Batch) {
+                auto Life  = Front.Life + Batch * Particles::BatchSize;
+                auto Count = GetBatchCount(Batch);
+                Offsets[Batch + 1] = Level >= SimdLevel::Avx2 ? Particles::CountAliveAvx2(Life, Count, Dt)
+                                                              : Particles::CountAliveScalar(Life, Count, Dt);
+            });
+            for (uint32 Batch = 0; Batch < BatchCount; ++Batch)
+            {
+                Offsets[Batch + 1] += Offsets[Batch];
+            }
+            ParallelFor(Jobs, BatchCount, [&](uint32 Batch) {
+                auto In    = Particles::Offset(Front, Batch * Particles::BatchSize);
+                auto Out   = Particles::Offset(Back, Offsets[Batch]);
+                auto Count = GetBatchCount(Batch);
+                if (Level >= SimdLevel::Avx512)
+                {
+                    Particles::UpdateAvx512(In, Out, Count, Dt, Gravity);
+                }
+                else if (Level >= SimdLevel::Avx2)
+                {
+                    Particles::UpdateAvx2(In, Out, Count, Dt, Gravity);
+                }
+                else
+                {
+                    Particles::UpdateScalar(In, Out, Count, Dt, Gravity);
+                }
+            });
+            auto Swapped  = Front;
+            Front         = Back;
+            Back          = Swapped;
+            ParticleCount = Offsets[BatchCount];
+        }
+
+        // Adds the particles to Buffer (4 bytes per pixel), the ones out of it are ignored. The bins are pushed on
+        // Scratch and released: 16 bytes per particle, and a few per tile and batch.
+        void Draw(const PIBackBuffer& Buffer,
+                  MemoryArena&        Scratch,
+                  JobSystem*          Jobs  = nullptr,
+                  SimdLevel           Level = GetBestSimdLevel()) const
+        {
+            TemporaryMemory Memory{ Scratch };
+
+            auto BandCount  = static_cast<uint32>((Buffer.Height + Particles::BandHeight - 1) / Particles::BandHeight);
+            auto BinCount   = BandCount + 1; // the last one for the particles out of the buffer
+            auto BatchCount = (ParticleCount + Particles::BatchSize - 1) / Particles::BatchSize;
+            auto Bands      = Scratch.PushArray<uint32>(ParticleCount, 64);
+            auto Pixels     = Scratch.PushArray<uint32>(ParticleCount, 64);
+            auto Starts     = Scratch.PushArray<uint32>(uint64(BatchCount) * BinCount, 64); // by batch then bin
+            auto BinStarts  = Scratch.PushArray<uint32>(BinCount + 1);
+            auto Bins       = Scratch.PushArray<PixelColor>(ParticleCount, 64);
+            if (!Bands || !Pixels || !Starts || !BinStarts || !Bins || Buffer.BytesPerPixel != 4)
+            {
+                return;
+            }
+
+            Particles::Viewport View = {
+                real32(Buffer.Width), real32(Buffer.Height), static_cast<uint32>(Buffer.Pitch / 4), BandCount
+            };
+            ParallelFor(Jobs, BatchCount, [&](uint32 Batch) {
+                auto First = Batch * Particles::BatchSize;
+                auto Count = GetBatchCount(Batch);
+                auto X     = Front.X + First;
+                auto Y     = Front.Y + First;
+                if (Level >= SimdLevel::Avx2)
+                {
+                    Particles::LocateAvx2(X, Y, Count, View, Bands + First, Pixels + First);
+                }
+                else if (Level == SimdLevel::Sse2)
+                {
+                    Particles::LocateSse2(X, Y, Count, View, Bands + First, Pixels + First);
+                }
+                else
+                {
+                    Particles::LocateScalar(X, Y, Count, View, Bands + First, Pixels + First);
+                }
+                auto Counts = Starts + uint64(Batch) * BinCount;
+                for (uint32 Bin = 0; Bin < BinCount; ++Bin)
+                {
+                    Counts[Bin] = 0;
+                }
+                for (auto Index = First; Index < First + Count; ++Index)
+                {
+                    ++Counts[Bands[Index]];
+                }
+            });
+
+            // counting sort: bin after bin, batch after batch, so a band keeps the particle order
+            uint32 Total = 0;
+            for (uint32 Bin = 0; Bin < BinCount; ++Bin)
+            {
+                BinStarts[Bin] = Total;
+                for (uint32 Batch = 0; Batch < BatchCount; ++Batch)
+                {
+                    auto& Start = Starts[uint64(Batch) * BinCount + Bin];
+                    auto  Count = Start;
+                    Start       = Total;
+                    Total += Count;
+                }
+            }
+            BinStarts[BinCount] = Total;
+
+            ParallelFor(Jobs, BatchCount, [&](uint32 Batch) {
+                auto Cursors = Starts + uint64(Batch) * BinCount;
+                auto First   = Batch * Particles::BatchSize;
+                auto Last    = First + GetBatchCount(Batch);
+                for (auto Index = First; Index < Last; ++Index)
+                {
+                    Bins[Cursors[Bands[Index]]++] = { Pixels[Index], Front.Color[Index] };
+                }
+            });
+
+            auto Target = static_cast<uint32*>(Buffer.Memory);
+            ParallelFor(Jobs, BandCount, [&](uint32 Band) {
+                auto Last = BinStarts[Band + 1];
+                if (Level == SimdLevel::Scalar)
+                {
+                    for (auto Index = BinStarts[Band]; Index < Last; ++Index)
+                    {
+                        Particles::AddPixelScalar(Target + Bins[Index].Pixel, Bins[Index].Color);
+                    }
+                }
+                else
+                {
+                    for (auto Index = BinStarts[Band]; Index < Last; ++Index)
+                    {
+                        Particles::AddPixelSse2(Target + Bins[Index].Pixel, Bins[Index].Color);
+                    }
+                }
+            });
+        }
+
+    private:
+        struct PixelColor
+        {
+            uint32 Pixel; // from the start of the buffer
+            uint32 Color;
+        };
+
+        static Particles::Columns PushColumns(MemoryArena& Arena, uint32 Count)
+        {
+            Particles::Columns Columns;
+            Columns.X         = Arena.PushArray<real32>(Count, 64);
+            Columns.Y         = Arena.PushArray<real32>(Count, 64);
+            Columns.VelocityX = Arena.PushArray<real32>(Count, 64);
+            Columns.VelocityY = Arena.PushArray<real32>(Count, 64);
+            Columns.Life      = Arena.PushArray<real32>(Count, 64);
+            Columns.Color     = Arena.PushArray<uint32>(Count, 64); // last: null if any failed
+            return Columns;
+        }
+
+        uint32 GetBatchCount(uint32 Batch) const
+        {
+            auto Rest = ParticleCount - Batch * Particles::BatchSize;
+            return Rest < Particles::BatchSize ? Rest : Particles::BatchSize;
+        }
+
+        Particles::Columns Front; // the particles
+        Particles::Columns Back;  // the survivors of the next update
+        uint32             MaxParticleCount;
+        uint32             ParticleCount = 0;
+    };
+
+} // namespace Game
@@ -0,0 +1,689 @@
+#pragma once
+
+#include "job_system.hpp"
+#include "memory_arena.hpp"
+#include "simd.hpp"
+#include "tilemap.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <cstring>
+
+// Shortest paths on 8-connected grids: A* with Jump Point Search when every walkable cell has the same cost, plain A*
+// when the cells are weighted.
+//
+// NavGrid holds the cost of each cell (0 blocks, 1 to 255 is the cost of entering it) with a border of blocked cells,
+// so the neighbours need no bound checks, and the blocked cells as bitsets by row and by column: a straight jump of
+// JPS scans 64 cells per step for a wall, a forced neighbour or the goal. Diagonal moves cannot cut a blocked corner.
+// PathFinder is the per-query state: the nodes of the whole grid and a binary heap of the open ones, pushed once on a
+// scratch arena (GetMemorySize bytes) and stamped with the query number so that a query only touches what it visits.
+// FindPaths runs a batch of queries with one PathFinder per thread.
+
+namespace Game
+{
+    struct GridPoint
+    {
+        int32 X = 0;
+        int32 Y = 0;
+    };
+
+    inline bool operator==(const GridPoint& A, const GridPoint& B) { return A.X == B.X && A.Y == B.Y; }
+    inline bool operator!=(const GridPoint& A, const GridPoint& B) { return !(A == B); }
+
+    struct PathQuery
+    {
+        GridPoint Start;
+        GridPoint Goal;
+    };
+
+    struct PathResult
+    {
+        real32 Cost          = 0;     // sum of the entered cell costs, sqrt(2) times for a diagonal step
+        uint32 Length        = 0;     // corners of the path, start and goal included, even past the written ones
+        uint32 ExpandedCount = 0;     // nodes taken from the heap
+        bool   IsFound       = false; // false when the goal cannot be reached or the query is out of the grid
+    };
+
+    enum class PathMethod : uint32
+    {
+        Automatic = 0, // JumpPoint on a uniform grid, AStar otherwise
+        AStar     = 1,
+        JumpPoint = 2, // every walkable cell costs 1
+    };
+
+    namespace Pathfinding
+    {
+        constexpr real32 Diagonal = 1.41421356f;
+
+        // cost of the octile line between the two points on a uniform grid: the heuristic of both searches
+        inline real32 GetOctileDistance(int32 X0, int32 Y0, int32 X1, int32 Y1)
+        {
+            auto Dx = X1 > X0 ? X1 - X0 : X0 - X1;
+            auto Dy = Y1 > Y0 ? Y1 - Y0 : Y0 - Y1;
+            return Dx > Dy ? real32(Dx - Dy) + Diagonal * real32(Dy) : real32(Dy - Dx) + Diagonal * real32(Dx);
+        }
+
+        inline uint32 FindFirstBit(uint64 Bits) // Bits != 0
+        {
+#if _MSC_VER
+            unsigned long Index;
+            _BitScanForward64(&Index, Bits);
+            return Index;
+#else
+            return static_cast<uint32>(__builtin_ctzll(Bits));
+#endif
+        }
+
+        inline uint32 FindLastBit(uint64 Bits) // Bits != 0
+        {
+#if _MSC_VER
+            unsigned long Index;
+            _BitScanReverse64(&Index, Bits);
+            return Index;
+#else
+            return 63 - static_cast<uint32>(__builtin_clzll(Bits));
+#endif
+        }
+
+        inline int32 GetSign(int32 Value) { return (Value > 0) - (Value < 0); }
+    } // namespace Pathfinding
+
+    class NavGrid final
+    {
+    public:
+        // Every cell starts walkable with a cost of 1, IsValid is false if Arena is too small
+        NavGrid(MemoryArena& Arena, int32 Width, int32 Height)
+            : Width{ Width }
+            , Height{ Height }
+            , Stride{ Width + 2 }
+            , RowWords{ uint32(Width + 2 * 64 + 63) / 64 + 1 }
+            , ColumnWords{ uint32(Height + 2 * 64 + 63) / 64 + 1 }
+        {
+            Costs   = Arena.PushArray<uint8>(uint64(Stride) * (Height + 2), 64);
+            Rows    = Arena.PushArray<uint64>(uint64(RowWords) * (Height + 2), 64);
+            Columns = Arena.PushArray<uint64>(uint64(ColumnWords) * (Width + 2), 64);
+            if (!Costs || !Rows || !Columns)
+            {
+                Costs = nullptr;
+                return;
+            }
+            memset(Costs, 0, uint64(Stride) * (Height + 2));
+            memset(Rows, 0xFF, uint64(RowWords) * (Height + 2) * sizeof(uint64));
+            memset(Columns, 0xFF, uint64(ColumnWords) * (Width + 2) * sizeof(uint64));
+            for (int32 Y = 0; Y < Height; ++Y)
+            {
+                memset(Costs + GetNode(0, Y), 1, uint64(Width));
+                for (int32 X = 0; X < Width; ++X)
+                {
+                    SetBlocked(X, Y, false);
+                }
+            }
+        }
+        NavGrid(const NavGrid&) = delete; // non copyable
+
+        bool  IsValid() const { return Costs != nullptr; }
+        int32 GetWidth() const { return Width; }
+        int32 GetHeight() const { return Height; }
+        bool  IsUniform() const { return WeightedCount == 0; } // every walkable cell costs 1
+        bool  IsInside(int32 X, int32 Y) const { return X >= 0 && Y >= 0 && X < Width && Y < Height; }
+
+        uint8 GetCost(int32 X, int32 Y) const { return IsInside(X, Y) ? Costs[GetNode(X, Y)] : 0; }
+        bool  IsWalkable(int32 X, int32 Y) const { return GetCost(X, Y) != 0; }
+
+        void SetCost(int32 X, int32 Y, uint8 Cost)
+        {
+            if (!IsInside(X, Y))
+            {
+                return;
+            }
+            auto& Cell = Costs[GetNode(X, Y)];
+            WeightedCount += (Cost > 1) - (Cell > 1);
+            if ((Cell == 0) != (Cost == 0))
+            {
+                SetBlocked(X, Y, Cost == 0);
+            }
+            Cell = Cost;
+        }
+
+        // Cost of every tile of Map: TileCosts[Id], 0 for the ids past TileCostCount. Reads the map chunk per chunk,
+        // one resident at a time: a streamed map larger than its resident chunks is loaded whole.
+        void Load(TileMap& Map, const uint8* TileCosts, uint32 TileCostCount)
+        {
+            auto EndX = Map.GetWidth() < Width ? Map.GetWidth() : Width;
+            auto EndY = Map.GetHeight() < Height ? Map.GetHeight() : Height;
+            for (int32 ChunkY = 0; ChunkY < EndY; ChunkY += TileMap::ChunkSize)
+            {
+                for (int32 ChunkX = 0; ChunkX < EndX; ChunkX += TileMap::ChunkSize)
+                {
+                    auto Tiles = Map.GetChunkTiles(ChunkX / TileMap::ChunkSize, ChunkY / TileMap::ChunkSize);
+                    for (auto Y = ChunkY; Y < ChunkY + TileMap::ChunkSize && Y < EndY; ++Y)
+                    {
+                        for (auto X = ChunkX; X < ChunkX + TileMap::ChunkSize && X < EndX; ++X)
+                        {
+                            auto Id = Tiles ? Tiles[(Y - ChunkY) * TileMap::ChunkSize + X - ChunkX] : EmptyTile;
+                            SetCost(X, Y, Id < TileCostCount ? TileCosts[Id] : 0);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Node: the cell index in the bordered grid
+        int32     GetStride() const { return Stride; }
+        uint32    GetNodeCount() const { return uint32(Stride) * uint32(Height + 2); }
+        uint32    GetNode(int32 X, int32 Y) const { return uint32((Y + 1) * Stride + X + 1); }
+        GridPoint GetPoint(uint32 Node) const { return { int32(Node % Stride) - 1, int32(Node / Stride) - 1 }; }
+        uint8     GetNodeCost(uint32 Node) const { return Costs[Node]; }
+
+        // 64 blocked bits of the row Y (-1 to Height) from the column X (-64 to Width + 64), bit 0 is X
+        uint64 GetRowBits(int32 Y, int32 X) const { return GetBits(Rows + uint64(Y + 1) * RowWords, X); }
+        uint64 GetColumnBits(int32 X, int32 Y) const { return GetBits(Columns + uint64(X + 1) * ColumnWords, Y); }
+
+    private:
+        // the bit of the cell X is 64 + X: a word of blocked cells before the first one, and more than one after
+        static uint64 GetBits(const uint64* Words, int32 X)
+        {
+            auto Bit   = uint32(X + 64);
+            auto Word  = Bit / 64;
+            auto Shift = Bit % 64;
+            return Shift ? Words[Word] >> Shift | Words[Word + 1] << (64 - Shift) : Words[Word];
+        }
+
+        static void SetBit(uint64* Words, int32 X, bool Value)
+        {
+            auto Bit  = uint32(X + 64);
+            auto Mask = uint64(1) << (Bit % 64);
+            Words[Bit / 64] = Value ? Words[Bit / 64] | Mask : Words[Bit / 64] & ~Mask;
+        }
+
+        void SetBlocked(int32 X, int32 Y, bool IsBlocked)
+        {
+            SetBit(Rows + uint64(Y + 1) * RowWords, X, IsBlocked);
+            SetBit(Columns + uint64(X + 1) * ColumnWords, Y, IsBlocked);
+        }
+
+        int32   Width;
+        int32   Height;
+        int32   Stride; // of Costs, with the border
+        uint32  RowWords;
+        uint32  ColumnWords;
+        uint32  WeightedCount = 0; // walkable cells costing more than 1
+        uint8*  Costs         = nullptr;
+        uint64* Rows          = nullptr; // blocked bits, one row after the other, border rows included
+        uint64* Columns       = nullptr; // the same, transposed
+    };
+
+    class PathFinder final
+    {
+    public:
+        // Pushes GetMemorySize(Grid) bytes on Scratch, IsValid is false if it is too small. The grid must not change
+        // during a query.
+        PathFinder(MemoryArena& Scratch, const NavGrid& Grid)
+            : Grid{ Grid }
+            , Nodes{ Scratch.PushArray<Node>(Grid.GetNodeCount(), 64) }
+            , Heap{ Scratch.PushArray<HeapEntry>(Grid.GetNodeCount(), 64) }
+        {
+            if (Nodes && Heap)
+            {
+                memset(Nodes, 0, uint64(Grid.GetNodeCount()) * sizeof(Node));
+            }
+        }
+        PathFinder(const PathFinder&) = delete; // non copyable
+
+        static uint64 GetMemorySize(const NavGrid& Grid)
+        {
+            return uint64(Grid.GetNodeCount()) * (sizeof(Node) + sizeof(HeapEntry)) + 2 * 64;
+        }
+
+        bool IsValid() const { return Nodes && Heap; }
+
+        // Writes the first MaxLength corners of the path in Path: consecutive corners are joined by a straight or
+        // diagonal line.
+        PathResult Find(const PathQuery& Query,
+                        GridPoint*       Path,
+                        uint32           MaxLength,
+                        PathMethod       Method = PathMethod::Automatic)
+        {
+            PathResult Result;
+            if (!IsValid() || !Grid.IsWalkable(Query.Start.X, Query.Start.Y) ||
+                !Grid.IsWalkable(Query.Goal.X, Query.Goal.Y))
+            {
+                return Result;
+            }
+            if (++Stamp == 0)
+            {
+                memset(Nodes, 0, uint64(Grid.GetNodeCount()) * sizeof(Node));
+                Stamp = 1;
+            }
+            IsJumping = Method == PathMethod::JumpPoint || (Method == PathMethod::Automatic && Grid.IsUniform());
+            Goal      = Query.Goal;
+            HeapCount = 0;
+
+            auto Start = Grid.GetNode(Query.Start.X, Query.Start.Y);
+            auto End   = Grid.GetNode(Query.Goal.X, Query.Goal.Y);
+            Visit(Start);
+            Push(Start, GetKey(GetHeuristic(Query.Start.X, Query.Start.Y), 0));
+            while (HeapCount)
+            {
+                auto Current = Pop();
+                ++Result.ExpandedCount;
+                if (Current == End)
+                {
+                    Result.IsFound = true;
+                    Result.Cost    = Nodes[End].G;
+                    Result.Length  = WritePath(End, Path, MaxLength);
+                    break;
+                }
+                if (IsJumping)
+                {
+                    ExpandJumpPoint(Current);
+                }
+                else
+                {
+                    ExpandAStar(Current);
+                }
+            }
+            return Result;
+        }
+
+    private:
+        static constexpr uint32 NoParent = 0xFFFFFFFF;
+        static constexpr uint32 Closed   = 0xFFFFFFFF; // HeapIndex of an expanded node
+        static constexpr uint32 Outside  = 0xFFFFFFFE; // HeapIndex of a node never pushed
+        static constexpr int32  NoJump   = -1;         // never a cell of the grid, the blocked border at most
+
+        struct Node
+        {
+            real32 G;
+            uint32 Parent;
+            uint32 HeapIndex;
+            uint32 Stamp; // the query which last visited the node
+        };
+
+        struct HeapEntry
+        {
+            uint64 Key; // F, then the highest G first: ties go to the node nearest to the goal
+            uint32 Node;
+        };
+
+        static uint32 GetBits(real32 Value)
+        {
+            uint32 Bits;
+            memcpy(&Bits, &Value, sizeof(Bits));
+            return Bits;
+        }
+
+        // F and G are positive: their bits sort like them
+        static uint64 GetKey(real32 F, real32 G) { return uint64(GetBits(F)) << 32 | (0xFFFFFFFF - GetBits(G)); }
+
+        real32 GetHeuristic(int32 X, int32 Y) const { return Pathfinding::GetOctileDistance(X, Y, Goal.X, Goal.Y); }
+
+        // the node, reset when it is not from this query
+        Node& Visit(uint32 Index)
+        {
+            auto& Value = Nodes[Index];
+            if (Value.Stamp != Stamp)
+            {
+                Value = { 0, NoParent, Outside, Stamp };
+            }
+            return Value;
+        }
+
+        void Relax(uint32 From, uint32 To, GridPoint Point, real32 G)
+        {
+            auto& Value = Visit(To);
+            if (Value.HeapIndex == Closed || (Value.HeapIndex != Outside && Value.G <= G))
+            {
+                return;
+            }
+            Value.G      = G;
+            Value.Parent = From;
+            auto Key     = GetKey(G + GetHeuristic(Point.X, Point.Y), G);
+            if (Value.HeapIndex == Outside)
+            {
+                Push(To, Key);
+            }
+            else
+            {
+                Heap[Value.HeapIndex].Key = Key;
+                SiftUp(Value.HeapIndex);
+            }
+        }
+
+        void Push(uint32 Index, uint64 Key)
+        {
+            Heap[HeapCount] = { Key, Index };
+            SiftUp(HeapCount++);
+        }
+
+        uint32 Pop()
+        {
+            auto Top             = Heap[0].Node;
+            Nodes[Top].HeapIndex = Closed;
+            if (--HeapCount)
+            {
+                Heap[0] = Heap[HeapCount];
+                SiftDown(0);
+            }
+            return Top;
+        }
+
+        void SiftUp(uint32 Index)
+        {
+            auto Entry = Heap[Index];
+            while (Index)
+            {
+                auto Parent = (Index - 1) / 2;
+                if (Heap[Parent].Key <= Entry.Key)
+                {
+                    break;
+                }
+                Heap[Index]                       = Heap[Parent];
+                Nodes[Heap[Index].Node].HeapIndex = Index;
+                Index                             = Parent;
+            }
+            Heap[Index]                 = Entry;
+            Nodes[Entry.Node].HeapIndex = Index;
+        }
+
+        void SiftDown(uint32 Index)
+        {
+            auto Entry = Heap[Index];
+            for (;;)
+            {
+                auto Child = 2 * Index + 1;
+                if (Child >= HeapCount)
+                {
+                    break;
+                }
+                Child += Child + 1 < HeapCount && Heap[Child + 1].Key < Heap[Child].Key;
+                if (Entry.Key <= Heap[Child].Key)
+                {
+                    break;
+                }
+                Heap[Index]                       = Heap[Child];
+                Nodes[Heap[Index].Node].HeapIndex = Index;
+                Index                             = Child;
+            }
+            Heap[Index]                 = Entry;
+            Nodes[Entry.Node].HeapIndex = Index;
+        }
+
+        // 8 neighbours, a diagonal one only when both cells beside the step are walkable
+        void ExpandAStar(uint32 Current)
+        {
+            static constexpr int32 Steps[8][2] = { { -1, 0 }, { 1, 0 },  { 0, -1 }, { 0, 1 },
+                                                   { -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 } };
+
+            auto Stride = Grid.GetStride();
+            auto Point  = Grid.GetPoint(Current);
+            auto G      = Nodes[Current].G;
+            bool IsOpen[4];
+            for (uint32 Index = 0; Index < 8; ++Index)
+            {
+                auto Dx   = Steps[Index][0];
+                auto Dy   = Steps[Index][1];
+                auto Next = uint32(int32(Current) + Dy * Stride + Dx);
+                auto Cost = Grid.GetNodeCost(Next);
+                if (Index < 4)
+                {
+                    IsOpen[Index] = Cost != 0;
+                }
+                else if (!IsOpen[Index & 1] || !IsOpen[2 + (Index >> 1 & 1)])
+                {
+                    continue;
+                }
+                if (Cost)
+                {
+                    auto Step = Index < 4 ? real32(Cost) : Pathfinding::Diagonal * real32(Cost);
+                    Relax(Current, Next, { Point.X + Dx, Point.Y + Dy }, G + Step);
+                }
+            }
+        }
+
+        // the pruned directions from the parent, then a jump in each of them
+        void ExpandJumpPoint(uint32 Current)
+        {
+            auto Point  = Grid.GetPoint(Current);
+            auto Parent = Nodes[Current].Parent;
+            auto Dx     = 0;
+            auto Dy     = 0;
+            if (Parent != NoParent)
+            {
+                auto From = Grid.GetPoint(Parent);
+                Dx        = Pathfinding::GetSign(Point.X - From.X);
+                Dy        = Pathfinding::GetSign(Point.Y - From.Y);
+            }
+
+            int32  Directions[8][2];
+            uint32 Count = 0;
+            auto   Add   = [&](int32 X, int32 Y) {
+                Directions[Count][0] = X;
+                Directions[Count][1] = Y;
+                ++Count;
+            };
+            if (!Dx && !Dy)
+            {
+                for (auto Y = -1; Y <= 1; ++Y)
+                {
+                    for (auto X = -1; X <= 1; ++X)
+                    {
+                        if (X || Y)
+                        {
+                            Add(X, Y);
+                        }
+                    }
+                }
+            }
+            else if (Dx && Dy)
+            {
+                Add(Dx, 0);
+                Add(0, Dy);
+                Add(Dx, Dy);
+            }
+            else if (Dx)
+            {
+                Add(Dx, 0);
+                for (auto Side = -1; Side <= 1; Side += 2)
+                {
+                    if (!Grid.IsWalkable(Point.X - Dx, Point.Y + Side) && Grid.IsWalkable(Point.X, Point.Y + Side))
+                    {
+                        Add(0, Side);
+                        Add(Dx, Side);
+                    }
+                }
+            }
+            else
+            {
+                Add(0, Dy);
+                for (auto Side = -1; Side <= 1; Side += 2)
+                {
+                    if (!Grid.IsWalkable(Point.X + Side, Point.Y - Dy) && Grid.IsWalkable(Point.X + Side, Point.Y))
+                    {
+                        Add(Side, 0);
+                        Add(Side, Dy);
+                    }
+                }
+            }
+
+            auto G = Nodes[Current].G;
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                GridPoint Found;
+                if (Jump(Point, Directions[Index][0], Directions[Index][1], Found))
+                {
+                    auto Cost = Pathfinding::GetOctileDistance(Point.X, Point.Y, Found.X, Found.Y);
+                    Relax(Current, Grid.GetNode(Found.X, Found.Y), Found, G + Cost);
+                }
+            }
+        }
+
+        bool Jump(GridPoint From, int32 Dx, int32 Dy, GridPoint& Found) const
+        {
+            if (!Dy)
+            {
+                Found = { JumpX(From.X, From.Y, Dx), From.Y };
+                return Found.X != NoJump;
+            }
+            if (!Dx)
+            {
+                Found = { From.X, JumpY(From.X, From.Y, Dy) };
+                return Found.Y != NoJump;
+            }
+            auto X = From.X;
+            auto Y = From.Y;
+            while (Grid.IsWalkable(X + Dx, Y) && Grid.IsWalkable(X, Y + Dy) && Grid.IsWalkable(X + Dx, Y + Dy))
+            {
+                X += Dx;
+                Y += Dy;
+                if ((X == Goal.X && Y == Goal.Y) || JumpX(X, Y, Dx) != NoJump || JumpY(X, Y, Dy) != NoJump)
+                {
+                    Found = { X, Y };
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // first cell after X along the row which is the goal or has a forced neighbour, NoJump at a wall
+        int32 JumpX(int32 X, int32 Y, int32 Dx) const
+        {
+            auto Line = [&](int32 At) { return Grid.GetRowBits(Y, At); };
+            auto Up   = [&](int32 At) { return Grid.GetRowBits(Y - 1, At); };
+            auto Down = [&](int32 At) { return Grid.GetRowBits(Y + 1, At); };
+            return Scan(X, Dx, Y == Goal.Y ? Goal.X : NoJump, Line, Up, Down);
+        }
+
+        int32 JumpY(int32 X, int32 Y, int32 Dy) const
+        {
+            auto Line  = [&](int32 At) { return Grid.GetColumnBits(X, At); };
+            auto Left  = [&](int32 At) { return Grid.GetColumnBits(X - 1, At); };
+            auto Right = [&](int32 At) { return Grid.GetColumnBits(X + 1, At); };
+            return Scan(Y, Dy, X == Goal.X ? Goal.Y : NoJump, Line, Left, Right);
+        }
+
+        // 64 cells per step: a cell stops the scan when it is blocked, or when a side cell is walkable and the one
+        // behind it blocked (a forced neighbour). The blocked border ends every scan.
+        template <typename L, typename A, typename B>
+        static int32 Scan(int32 From, int32 Step, int32 Target, L&& Line, A&& SideA, B&& SideB)
+        {
+            if (Step > 0)
+            {
+                for (auto At = From + 1;; At += 64)
+                {
+                    auto Blocked = Line(At);
+                    auto Forced  = (~SideA(At) & SideA(At - 1)) | (~SideB(At) & SideB(At - 1));
+                    if (auto Stops = Blocked | Forced)
+                    {
+                        auto Stop = At + int32(Pathfinding::FindFirstBit(Stops));
+                        if (Target > From && Target <= Stop)
+                        {
+                            return Target;
+                        }
+                        return Blocked >> (Stop - At) & 1 ? NoJump : Stop;
+                    }
+                }
+            }
+            for (auto At = From - 1;; At -= 64)
+            {
+                // bit 63 is At
+                auto Blocked = Line(At - 63);
+                auto Forced  = (~SideA(At - 63) & SideA(At - 62)) | (~SideB(At - 63) & SideB(At - 62));
+                if (auto Stops = Blocked | Forced)
+                {
+                    auto Stop = At - 63 + int32(Pathfinding::FindLastBit(Stops));
+                    if (Target != NoJump && Target < From && Target >= Stop)
+                    {
+                        return Target;
+                    }
+                    return Blocked >> (Stop - At + 63) & 1 ? NoJump : Stop;
+                }
+            }
+        }
+
+        // corners only, from the goal back to the start; returns their count
+        uint32 WritePath(uint32 End, GridPoint* Path, uint32 MaxLength) const
+        {
+            uint32 Count = 0;
+            ForEachCorner(End, [&](GridPoint) { ++Count; });
+            auto Index = Count;
+            ForEachCorner(End, [&](GridPoint Point) {
+                if (--Index < MaxLength)
+                {
+                    Path[Index] = Point;
+                }
+            });
+            return Count;
+        }
+
+        template <typename F>
+        void ForEachCorner(uint32 End, F&& Function) const
+        {
+            auto Point = Grid.GetPoint(End);
+            auto Dx    = 0;
+            auto Dy    = 0;
+            Function(Point);
+            for (auto Current = End; Nodes[Current].Parent != NoParent;)
+            {
+                auto Next  = Nodes[Current].Parent;
+                auto From  = Grid.GetPoint(Next);
+                auto NextX = Pathfinding::GetSign(From.X - Point.X);
+                auto NextY = Pathfinding::GetSign(From.Y - Point.Y);
+                if (Current != End && (NextX != Dx || NextY != Dy))
+                {
+                    Function(Point);
+                }
+                Dx      = NextX;
+                Dy      = NextY;
+                Point   = From;
+                Current = Next;
+            }
+            if (Nodes[End].Parent != NoParent)
+            {
+                Function(Point);
+            }
+        }
+
+        const NavGrid& Grid;
+        Node*          Nodes;
+        HeapEntry*     Heap;
+        uint32         HeapCount = 0;
+        uint32         Stamp     = 0;
+        GridPoint      Goal;
+        bool           IsJumping = false;
+    };
+
+    // Query I writes its corners in Paths + I * MaxLength. The queries are shared by the threads, each with its own
+    // PathFinder pushed on Scratch and released at the end.
+    inline void FindPaths(const NavGrid&   Grid,
+                          const PathQuery* Queries,
+                          PathResult*      Results,
+                          uint32           Count,
+                          GridPoint*       Paths,
+                          uint32           MaxLength,
+                          MemoryArena&     Scratch,
+                          JobSystem*       Jobs   = nullptr,
+                          PathMethod       Method = PathMethod::Automatic)
+    {
+        TemporaryMemory Memory{ Scratch };
+        auto            SliceCount = Jobs ? Jobs->GetThreadCount() : 1;
+        SliceCount                 = SliceCount < Count ? SliceCount : (Count ? Count : 1);
+        auto Arenas                = Scratch.PushArray<MemoryArena>(SliceCount);
+        for (uint32 Slice = 0; Arenas && Slice < SliceCount; ++Slice)
+        {
+            Arenas[Slice] = Scratch.PushArena(PathFinder::GetMemorySize(Grid));
+        }
+
+        std::atomic<uint32> Next{ 0 };
+        ParallelFor(Jobs, SliceCount, [&](uint32 Slice) {
+            MemoryArena Empty;
+            PathFinder  Finder{ Arenas ? Arenas[Slice] : Empty, Grid };
+            for (auto Index = Next.fetch_add(1, std::memory_order_relaxed); Index < Count;
+                 Index      = Next.fetch_add(1, std::memory_order_relaxed))
+            {
+                Results[Index] = Finder.Find(Queries[Index], Paths + uint64(Index) * MaxLength, MaxLength, Method);
+            }
+        });
+    }
+
+} // namespace Game
@@ -0,0 +1,802 @@
+#pragma once
+
+#include "game.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// Explicit pixel conversions between the formats of the platform and of the assets: the back buffer (BGRX), straight
+// alpha colors (BGRA like cuppa::Color, RGBA like the image files, ARGB), premultiplied BGRA (the sprites, PARGB of
+// GDI+), 565, 8-bit gray, and 16-bit linear light.
+//
+//     ConvertPixels(GetPixelView(Buffer), { Pixels, Width, Height, Width * 4, PixelFormat::Rgba8 });
+//
+// A row goes through the canonical format, 0xAARRGGBB in a uint32, by chunks that stay in the L1 cache: unpacked,
+// premultiplied or unpremultiplied when the alpha kinds differ, then packed. A conversion between 32-bit formats
+// without alpha change is a single byte shuffle. The formats without alpha are opaque, a straight alpha source is
+// premultiplied into them (over black). Every kernel gives the same result to the bit as the scalar one: the 32-bit
+// shuffles and the gray conversion use SSSE3 at the Sse2 level when the CPU has it, the sRGB tables are scalar.
+
+namespace Game
+{
+    enum class PixelFormat : uint32
+    {
+        Bgrx8              = 0, // the back buffer, X is written 0xFF
+        Bgra8              = 1, // straight alpha
+        Bgra8Premultiplied = 2,
+        Rgba8              = 3, // straight alpha
+        Argb8              = 4, // straight alpha, A in the first byte
+        Rgb565             = 5, // R in the high bits
+        Gray8              = 6, // Rec. 709 luma of the sRGB values
+        Bgra16Linear       = 7, // straight alpha, linear light colors
+    };
+
+    // Width x Height pixels of Format, rows Pitch bytes apart
+    struct PixelView
+    {
+        void*       Memory = nullptr;
+        int32       Width  = 0;
+        int32       Height = 0;
+        int32       Pitch  = 0;
+        PixelFormat Format = PixelFormat::Bgrx8;
+    };
+
+    inline int32 GetBytesPerPixel(PixelFormat Format)
+    {
+        return Format == PixelFormat::Bgra16Linear ? 8
+               : Format == PixelFormat::Rgb565     ? 2
+               : Format == PixelFormat::Gray8      ? 1
+                                                   : 4;
+    }
+
+    inline const char* GetPixelFormatName(PixelFormat Format)
+    {
+        switch (Format)
+        {
+        case PixelFormat::Bgrx8:
+            return "bgrx8";
+        case PixelFormat::Bgra8:
+            return "bgra8";
+        case PixelFormat::Bgra8Premultiplied:
+            return "bgra8 premultiplied";
+        case PixelFormat::Rgba8:
+            return "rgba8";
+        case PixelFormat::Argb8:
+            return "argb8";
+        case PixelFormat::Rgb565:
+            return "rgb565";
+        case PixelFormat::Gray8:
+            return "gray8";
+        case PixelFormat::Bgra16Linear:
+            return "bgra16 linear";
+        }
+        return "?";
+    }
+
+    inline PixelView GetPixelView(const PIBackBuffer& Buffer)
+    {
+        return { Buffer.Memory, Buffer.Width, Buffer.Height, Buffer.Pitch, PixelFormat::Bgrx8 };
+    }
+
+    // The part of View in the rectangle at (X, Y), clipped to it
+    inline PixelView GetTile(const PixelView& View, int32 X, int32 Y, int32 Width, int32 Height)
+    {
+        auto MinX = X > 0 ? X : 0;
+        auto MinY = Y > 0 ? Y : 0;
+        auto MaxX = X + Width < View.Width ? X + Width : View.Width;
+        auto MaxY = Y + Height < View.Height ? Y + Height : View.Height;
+        if (MinX >= MaxX || MinY >= MaxY)
+        {
+            return { View.Memory, 0, 0, View.Pitch, View.Format };
+        }
+        auto Row    = static_cast<uint8*>(View.Memory) + int64(MinY) * View.Pitch;
+        auto Memory = Row + MinX * GetBytesPerPixel(View.Format);
+        return { Memory, MaxX - MinX, MaxY - MinY, View.Pitch, View.Format };
+    }
+
+    namespace PixelConversion
+    {
+        constexpr int32 ChunkSize = 256;
+
+        // Byte I of an output pixel is byte Index[I] of the input one (4 and more: zero), then ORed with Or
+        struct ChannelShuffle
+        {
+            uint8  Index[4];
+            uint32 Or;
+        };
+
+        // Row kernels: Count pixels from In to Out, which may be the same memory
+
+        inline void ShuffleRowScalar(const uint32* In, uint32* Out, int32 Count, const ChannelShuffle& Shuffle)
+        {
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                auto Pixel  = In[Index];
+                auto Result = Shuffle.Or;
+                for (uint32 Byte = 0; Byte < 4; ++Byte)
+                {
+                    auto From = Shuffle.Index[Byte];
+                    Result |= From < 4 ? ((Pixel >> (8 * From)) & 0xFF) << (8 * Byte) : 0;
+                }
+                Out[Index] = Result;
+            }
+        }
+
+        inline __m128i GetShuffleMask(const ChannelShuffle& Shuffle)
+        {
+            alignas(16) int8 Mask[16];
+            for (int32 Byte = 0; Byte < 16; ++Byte)
+            {
+                auto From  = Shuffle.Index[Byte % 4];
+                Mask[Byte] = From < 4 ? int8(Byte / 4 * 4 + From) : int8(-128);
+            }
+            return _mm_load_si128(reinterpret_cast<const __m128i*>(Mask));
+        }
+
+        GAME_TARGET_SSSE3 inline void ShuffleRowSsse3(const uint32* In, uint32* Out, int32 Count,
+                                                      const ChannelShuffle& Shuffle)
+        {
+            auto  Mask  = GetShuffleMask(Shuffle);
+            auto  Or    = _mm_set1_epi32(int32(Shuffle.Or));
+            int32 Index = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto Pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(In + Index));
+                Pixels      = _mm_or_si128(_mm_shuffle_epi8(Pixels, Mask), Or);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + Index), Pixels);
+            }
+            ShuffleRowScalar(In + Index, Out + Index, Count - Index, Shuffle);
+        }
+
+        GAME_TARGET_AVX2 inline void ShuffleRowAvx2(const uint32* In, uint32* Out, int32 Count,
+                                                    const ChannelShuffle& Shuffle)
+        {
+            auto  Mask  = _mm256_broadcastsi128_si256(GetShuffleMask(Shuffle));
+            auto  Or    = _mm256_set1_epi32(int32(Shuffle.Or));
+            int32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto Pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(In + Index));
+                Pixels      = _mm256_or_si256(_mm256_shuffle_epi8(Pixels, Mask), Or);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + Index), Pixels);
+            }
+            ShuffleRowSsse3(In + Index, Out + Index, Count - Index, Shuffle);
+        }
+
+        // C * A / 255 on the colors, with the rounding of blit.hpp, the alpha kept
+        inline void PremultiplyRowScalar(const uint32* In, uint32* Out, int32 Count)
+        {
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                auto Pixel  = In[Index];
+                auto Alpha  = Pixel >> 24;
+                auto Result = Pixel & 0xFF000000;
+                for (uint32 Shift = 0; Shift < 24; Shift += 8)
+                {
+                    Result |= (((((Pixel >> Shift) & 0xFF) * Alpha + 128) * 257) >> 16) << Shift;
+                }
+                Out[Index] = Result;
+            }
+        }
+
+        inline void PremultiplyRowSse2(const uint32* In, uint32* Out, int32 Count)
+        {
+            auto  Zero       = _mm_setzero_si128();
+            auto  AlphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+            auto  Full       = _mm_and_si128(AlphaLanes, _mm_set1_epi16(255));
+            auto  Round      = _mm_set1_epi16(128);
+            auto  By255      = _mm_set1_epi16(257);
+            auto  Scale      = [&](__m128i Pixels16) {
+                auto Alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(Pixels16, 0xFF), 0xFF);
+                Alpha      = _mm_or_si128(_mm_andnot_si128(AlphaLanes, Alpha), Full);
+                return _mm_mulhi_epu16(_mm_add_epi16(_mm_mullo_epi16(Pixels16, Alpha), Round), By255);
+            };
+            int32 Index = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto Pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(In + Index));
+                Pixels      = _mm_packus_epi16(Scale(_mm_unpacklo_epi8(Pixels, Zero)),
+                                          Scale(_mm_unpackhi_epi8(Pixels, Zero)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + Index), Pixels);
+            }
+            PremultiplyRowScalar(In + Index, Out + Index, Count - Index);
+        }
+
+        GAME_TARGET_AVX2 inline void PremultiplyRowAvx2(const uint32* In, uint32* Out, int32 Count)
+        {
+            auto  Zero       = _mm256_setzero_si256();
+            auto  AlphaLanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+            auto  Full       = _mm256_and_si256(AlphaLanes, _mm256_set1_epi16(255));
+            auto  Round      = _mm256_set1_epi16(128);
+            auto  By255      = _mm256_set1_epi16(257);
+            int32 Index      = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto Pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(In + Index));
+                __m256i Halves[2] = { _mm256_unpacklo_epi8(Pixels, Zero), _mm256_unpackhi_epi8(Pixels, Zero) };
+                for (auto& Half : Halves)
+                {
+                    auto Alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(Half, 0xFF), 0xFF);
+                    Alpha      = _mm256_or_si256(_mm256_andnot_si256(AlphaLanes, Alpha), Full);
+                    Half = _mm256_mulhi_epu16(_mm256_add_epi16(_mm256_mullo_epi16(Half, Alpha), Round), By255);
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + Index), _mm256_packus_epi16(Halves[0], Halves[1]));
+            }
+            PremultiplyRowSse2(In + Index, Out + Index, Count - Index);
+        }
+
+        // C * 255 / A rounded to the nearest, saturated (a color above its alpha is not premultiplied), 0 when A is 0
+        inline void UnpremultiplyRowScalar(const uint32* In, uint32* Out, int32 Count)
+        {
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                auto Pixel = In[Index];
+                auto Alpha = Pixel >> 24;
+                if (Alpha == 0)
+                {
+                    Out[Index] = 0;
+                    continue;
+                }
+                auto Scale  = 255.0f / real32(Alpha);
+                auto Result = Pixel & 0xFF000000;
+                for (uint32 Shift = 0; Shift < 24; Shift += 8)
+                {
+                    // the conversion of the SIMD kernels, to round the same way
+                    auto Value = uint32(_mm_cvtss_si32(_mm_set_ss(real32((Pixel >> Shift) & 0xFF) * Scale)));
+                    Result |= (Value < 255 ? Value : 255) << Shift;
+                }
+                Out[Index] = Result;
+            }
+        }
+
+        inline void UnpremultiplyRowSse2(const uint32* In, uint32* Out, int32 Count)
+        {
+            auto  Zero       = _mm_setzero_si128();
+            auto  ColorLanes = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+            auto  One        = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+            auto  Max        = _mm_set1_ps(255.0f);
+            auto  Opaque     = _mm_set1_epi32(255);
+            auto  Unscale    = [&](__m128i Pixel32) {
+                auto Pixel = _mm_cvtepi32_ps(Pixel32);
+                auto Alpha = _mm_shuffle_ps(Pixel, Pixel, 0xFF);
+                auto Scale = _mm_and_ps(_mm_div_ps(Max, Alpha), _mm_cmpneq_ps(Alpha, _mm_setzero_ps()));
+                Scale      = _mm_or_ps(_mm_and_ps(Scale, ColorLanes), One);
+                return _mm_cvtps_epi32(_mm_mul_ps(Pixel, Scale));
+            };
+            int32 Index = 0;
+            for (; Index + 4 <= Count; Index += 4)
+            {
+                auto Pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(In + Index));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(Pixels, 24), Opaque)) != 0xFFFF)
+                {
+                    auto Low  = _mm_unpacklo_epi8(Pixels, Zero);
+                    auto High = _mm_unpackhi_epi8(Pixels, Zero);
+                    Low       = _mm_packs_epi32(Unscale(_mm_unpacklo_epi16(Low, Zero)),
+                                          Unscale(_mm_unpackhi_epi16(Low, Zero)));
+                    High      = _mm_packs_epi32(Unscale(_mm_unpacklo_epi16(High, Zero)),
+                                           Unscale(_mm_unpackhi_epi16(High, Zero)));
+                    Pixels    = _mm_packus_epi16(Low, High);
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + Index), Pixels);
+            }
+            UnpremultiplyRowScalar(In + Index, Out + Index, Count - Index);
+        }
+
+        GAME_TARGET_AVX2 inline void UnpremultiplyRowAvx2(const uint32* In, uint32* Out, int32 Count)
+        {
+            auto  ColorLanes = _mm256_castsi256_ps(_mm256_set_epi32(0, -1, -1, -1, 0, -1, -1, -1));
+            auto  One        = _mm256_set_ps(1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+            auto  Max        = _mm256_set1_ps(255.0f);
+            auto  Opaque     = _mm256_set1_epi32(255);
+            auto  Order      = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+            int32 Index      = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto Pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(In + Index));
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_srli_epi32(Pixels, 24), Opaque)) != -1)
+                {
+                    // two pixels per register, a pixel per lane
+                    auto    Low       = _mm256_castsi256_si128(Pixels);
+                    auto    High      = _mm256_extracti128_si256(Pixels, 1);
+                    __m256i Pairs[4]  = { _mm256_cvtepu8_epi32(Low), _mm256_cvtepu8_epi32(_mm_srli_si128(Low, 8)),
+                                          _mm256_cvtepu8_epi32(High), _mm256_cvtepu8_epi32(_mm_srli_si128(High, 8)) };
+                    for (auto& Pair : Pairs)
+                    {
+                        auto Pixel = _mm256_cvtepi32_ps(Pair);
+                        auto Alpha = _mm256_shuffle_ps(Pixel, Pixel, 0xFF);
+                        auto Scale = _mm256_and_ps(_mm256_div_ps(Max, Alpha),
+                                                   _mm256_cmp_ps(Alpha, _mm256_setzero_ps(), _CMP_NEQ_UQ));
+                        Scale      = _mm256_or_ps(_mm256_and_ps(Scale, ColorLanes), One);
+                        Pair       = _mm256_cvtps_epi32(_mm256_mul_ps(Pixel, Scale));
+                    }
+                    // pixels 0 2 4 6 in the low lane, 1 3 5 7 in the high one
+                    Pixels = _mm256_packus_epi16(_mm256_packs_epi32(Pairs[0], Pairs[1]),
+                                                 _mm256_packs_epi32(Pairs[2], Pairs[3]));
+                    Pixels = _mm256_permutevar8x32_epi32(Pixels, Order);
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + Index), Pixels);
+            }
+            UnpremultiplyRowSse2(In + Index, Out + Index, Count - Index);
+        }
+
+        // 565 from the canonical format, the low bits dropped
+        inline void Pack565RowScalar(const uint32* In, uint16* Out, int32 Count)
+        {
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                auto Pixel = In[Index];
+                Out[Index] = uint16(((Pixel >> 8) & 0xF800) | ((Pixel >> 5) & 0x07E0) | ((Pixel >> 3) & 0x001F));
+            }
+        }
+
+        inline __m128i Pack565(__m128i Pixels)
+        {
+            auto Result = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(Pixels, 8), _mm_set1_epi32(0xF800)),
+                                       _mm_and_si128(_mm_srli_epi32(Pixels, 5), _mm_set1_epi32(0x07E0)));
+            Result      = _mm_or_si128(Result, _mm_and_si128(_mm_srli_epi32(Pixels, 3), _mm_set1_epi32(0x001F)));
+            // sign extended, for the signed saturation of the pack to keep the bits
+            return _mm_srai_epi32(_mm_slli_epi32(Result, 16), 16);
+        }
+
+        inline void Pack565RowSse2(const uint32* In, uint16* Out, int32 Count)
+        {
+            int32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                auto Low  = Pack565(_mm_loadu_si128(reinterpret_cast<const __m128i*>(In + Index)));
+                auto High = Pack565(_mm_loadu_si128(reinterpret_cast<const __m128i*>(In + Index + 4)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + Index), _mm_packs_epi32(Low, High));
+            }
+            Pack565RowScalar(In + Index, Out + Index, Count - Index);
+        }
+
+        GAME_TARGET_AVX2 inline __m256i Pack565(__m256i Pixels)
+        {
+            auto Result = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(Pixels, 8), _mm256_set1_epi32(0xF800)),
+                                          _mm256_and_si256(_mm256_srli_epi32(Pixels, 5), _mm256_set1_epi32(0x07E0)));
+            Result = _mm256_or_si256(Result, _mm256_and_si256(_mm256_srli_epi32(Pixels, 3), _mm256_set1_epi32(0x001F)));
+            return _mm256_srai_epi32(_mm256_slli_epi32(Result, 16), 16);
+        }
+
+        GAME_TARGET_AVX2 inline void Pack565RowAvx2(const uint32* In, uint16* Out, int32 Count)
+        {
+            int32 Index = 0;
+            for (; Index + 16 <= Count; Index += 16)
+            {
+                auto Low    = Pack565(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(In + Index)));
+                auto High   = Pack565(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(In + Index + 8)));
+                auto Packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(Low, High), 0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + Index), Packed);
+            }
+            Pack565RowSse2(In + Index, Out + Index, Count - Index);
+        }
+
+        // 565 to the canonical format, the high bits repeated in the low ones: 31 gives 255
+        inline void Unpack565RowScalar(const uint16* In, uint32* Out, int32 Count)
+        {
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                uint32 Pixel = In[Index];
+                auto   Red   = Pixel >> 11;
+                auto   Green = (Pixel >> 5) & 63;
+                auto   Blue  = Pixel & 31;
+                Out[Index]   = 0xFF000000 | ((Red << 3 | Red >> 2) << 16) | ((Green << 2 | Green >> 4) << 8)
+                             | (Blue << 3 | Blue >> 2);
+            }
+        }
+
+        // 8 pixels of 565 to their blue and green bytes, and their red and alpha ones
+        inline void Unpack565(__m128i Pixels, __m128i& BlueGreen, __m128i& RedAlpha)
+        {
+            auto Red   = _mm_srli_epi16(Pixels, 11);
+            auto Green = _mm_and_si128(_mm_srli_epi16(Pixels, 5), _mm_set1_epi16(63));
+            auto Blue  = _mm_and_si128(Pixels, _mm_set1_epi16(31));
+            Red        = _mm_or_si128(_mm_slli_epi16(Red, 3), _mm_srli_epi16(Red, 2));
+            Green      = _mm_or_si128(_mm_slli_epi16(Green, 2), _mm_srli_epi16(Green, 4));
+            Blue       = _mm_or_si128(_mm_slli_epi16(Blue, 3), _mm_srli_epi16(Blue, 2));
+            BlueGreen  = _mm_or_si128(Blue, _mm_slli_epi16(Green, 8));
+            RedAlpha   = _mm_or_si128(Red, _mm_set1_epi16(int16(0xFF00)));
+        }
+
+        inline void Unpack565RowSse2(const uint16* In, uint32* Out, int32 Count)
+        {
+            int32 Index = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                __m128i BlueGreen, RedAlpha;
+                Unpack565(_mm_loadu_si128(reinterpret_cast<const __m128i*>(In + Index)), BlueGreen, RedAlpha);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + Index), _mm_unpacklo_epi16(BlueGreen, RedAlpha));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + Index + 4), _mm_unpackhi_epi16(BlueGreen, RedAlpha));
+            }
+            Unpack565RowScalar(In + Index, Out + Index, Count - Index);
+        }
+
+        GAME_TARGET_AVX2 inline void Unpack565RowAvx2(const uint16* In, uint32* Out, int32 Count)
+        {
+            int32 Index = 0;
+            for (; Index + 16 <= Count; Index += 16)
+            {
+                auto Pixels    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(In + Index));
+                auto Red       = _mm256_srli_epi16(Pixels, 11);
+                auto Green     = _mm256_and_si256(_mm256_srli_epi16(Pixels, 5), _mm256_set1_epi16(63));
+                auto Blue      = _mm256_and_si256(Pixels, _mm256_set1_epi16(31));
+                Red            = _mm256_or_si256(_mm256_slli_epi16(Red, 3), _mm256_srli_epi16(Red, 2));
+                Green          = _mm256_or_si256(_mm256_slli_epi16(Green, 2), _mm256_srli_epi16(Green, 4));
+                Blue           = _mm256_or_si256(_mm256_slli_epi16(Blue, 3), _mm256_srli_epi16(Blue, 2));
+                auto BlueGreen = _mm256_or_si256(Blue, _mm256_slli_epi16(Green, 8));
+                auto RedAlpha  = _mm256_or_si256(Red, _mm256_set1_epi16(int16(0xFF00)));
+                // pixels 0-3 and 8-11, then 4-7 and 12-15
+                auto Low       = _mm256_unpacklo_epi16(BlueGreen, RedAlpha);
+                auto High      = _mm256_unpackhi_epi16(BlueGreen, RedAlpha);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + Index),
+                                    _mm256_permute2x128_si256(Low, High, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + Index + 8),
+                                    _mm256_permute2x128_si256(Low, High, 0x31));
+            }
+            Unpack565RowSse2(In + Index, Out + Index, Count - Index);
+        }
+
+        // Rec. 709 weights in 1/128: blue, green, red
+        constexpr uint32 GrayBlue  = 9;
+        constexpr uint32 GrayGreen = 92;
+        constexpr uint32 GrayRed   = 27;
+
+        inline void PackGrayRowScalar(const uint32* In, uint8* Out, int32 Count)
+        {
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                auto Pixel = In[Index];
+                Out[Index] = uint8(((Pixel & 0xFF) * GrayBlue + ((Pixel >> 8) & 0xFF) * GrayGreen
+                                    + ((Pixel >> 16) & 0xFF) * GrayRed + 64)
+                                   >> 7);
+            }
+        }
+
+        GAME_TARGET_SSSE3 inline void PackGrayRowSsse3(const uint32* In, uint8* Out, int32 Count)
+        {
+            auto  Weights = _mm_set1_epi32(int32(GrayBlue | GrayGreen << 8 | GrayRed << 16));
+            auto  Round   = _mm_set1_epi16(64);
+            int32 Index   = 0;
+            for (; Index + 8 <= Count; Index += 8)
+            {
+                // blue + green and red + 0 per pixel, then their sums
+                auto Low  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(In + Index));
+                auto High = _mm_loadu_si128(reinterpret_cast<const __m128i*>(In + Index + 4));
+                auto Sums = _mm_hadd_epi16(_mm_maddubs_epi16(Low, Weights), _mm_maddubs_epi16(High, Weights));
+                auto Gray = _mm_srli_epi16(_mm_add_epi16(Sums, Round), 7);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(Out + Index), _mm_packus_epi16(Gray, Gray));
+            }
+            PackGrayRowScalar(In + Index, Out + Index, Count - Index);
+        }
+
+        GAME_TARGET_AVX2 inline void PackGrayRowAvx2(const uint32* In, uint8* Out, int32 Count)
+        {
+            auto  Weights = _mm256_set1_epi32(int32(GrayBlue | GrayGreen << 8 | GrayRed << 16));
+            auto  Round   = _mm256_set1_epi16(64);
+            int32 Index   = 0;
+            for (; Index + 16 <= Count; Index += 16)
+            {
+                auto Low  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(In + Index));
+                auto High = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(In + Index + 8));
+                // pixels 0-3, 8-11, 4-7 and 12-15 in the quarters, put back in order
+                auto Gray = _mm256_hadd_epi16(_mm256_maddubs_epi16(Low, Weights), _mm256_maddubs_epi16(High, Weights));
+                Gray      = _mm256_permute4x64_epi64(_mm256_srli_epi16(_mm256_add_epi16(Gray, Round), 7), 0xD8);
+                Gray      = _mm256_permute4x64_epi64(_mm256_packus_epi16(Gray, Gray), 0xD8);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + Index), _mm256_castsi256_si128(Gray));
+            }
+            PackGrayRowSsse3(In + Index, Out + Index, Count - Index);
+        }
+
+        inline void UnpackGrayRowScalar(const uint8* In, uint32* Out, int32 Count)
+        {
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                Out[Index] = 0xFF000000 | In[Index] * 0x010101u;
+            }
+        }
+
+        inline void UnpackGrayRowSse2(const uint8* In, uint32* Out, int32 Count)
+        {
+            auto  Alpha = _mm_set1_epi32(int32(0xFF000000));
+            int32 Index = 0;
+            for (; Index + 16 <= Count; Index += 16)
+            {
+                auto    Gray     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(In + Index));
+                auto    Low      = _mm_unpacklo_epi8(Gray, Gray);
+                auto    High     = _mm_unpackhi_epi8(Gray, Gray);
+                __m128i Parts[4] = { _mm_unpacklo_epi16(Low, Low), _mm_unpackhi_epi16(Low, Low),
+                                     _mm_unpacklo_epi16(High, High), _mm_unpackhi_epi16(High, High) };
+                for (int32 Part = 0; Part < 4; ++Part)
+                {
+                    auto Pixels = _mm_or_si128(Parts[Part], Alpha);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + Index + 4 * Part), Pixels);
+                }
+            }
+            UnpackGrayRowScalar(In + Index, Out + Index, Count - Index);
+        }
+
+        GAME_TARGET_AVX2 inline void UnpackGrayRowAvx2(const uint8* In, uint32* Out, int32 Count)
+        {
+            // the gray byte 3 times and a zero, pixels 0-3 then 4-7 of each half of the 16 bytes
+            auto  First  = _mm256_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1, //
+                                            4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1);
+            auto  Second = _mm256_setr_epi8(8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1, //
+                                            12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1);
+            auto  Alpha  = _mm256_set1_epi32(int32(0xFF000000));
+            int32 Index  = 0;
+            for (; Index + 16 <= Count; Index += 16)
+            {
+                auto Gray = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(In + Index)));
+                auto Low  = _mm256_or_si256(_mm256_shuffle_epi8(Gray, First), Alpha);
+                auto High = _mm256_or_si256(_mm256_shuffle_epi8(Gray, Second), Alpha);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + Index), Low);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + Index + 8), High);
+            }
+            UnpackGrayRowSse2(In + Index, Out + Index, Count - Index);
+        }
+
+        // sRGB bytes to linear light in 16 bits, and back from the linear value rounded to 12 bits
+        inline const uint16* GetSrgbToLinearTable()
+        {
+            static const struct Table
+            {
+                Table()
+                {
+                    for (uint32 Index = 0; Index < 256; ++Index)
+                    {
+                        auto Value      = real64(Index) / 255.0;
+                        auto Linear     = Value <= 0.04045 ? Value / 12.92 : std::pow((Value + 0.055) / 1.055, 2.4);
+                        Values[Index]   = uint16(Linear * 65535.0 + 0.5);
+                    }
+                }
+                uint16 Values[256];
+            } Srgb;
+            return Srgb.Values;
+        }
+
+        constexpr uint32 LinearTableSize = 4097; // (65535 + 8) >> 4
+
+        inline const uint8* GetLinearToSrgbTable()
+        {
+            static const struct Table
+            {
+                Table()
+                {
+                    for (uint32 Index = 0; Index < LinearTableSize; ++Index)
+                    {
+                        auto Linear   = real64(Index < 4095 ? Index : 4095) / 4095.0;
+                        auto Curve    = 1.055 * std::pow(Linear, 1 / 2.4) - 0.055;
+                        auto Value    = Linear <= 0.0031308 ? Linear * 12.92 : Curve;
+                        Values[Index] = uint8(Value * 255.0 + 0.5);
+                    }
+                }
+                uint8 Values[LinearTableSize];
+            } Linear;
+            return Linear.Values;
+        }
+
+        // 4 channels per pixel, blue first, the alpha scaled to 16 bits
+        inline void PackLinearRow(const uint32* In, uint16* Out, int32 Count)
+        {
+            auto Table = GetSrgbToLinearTable();
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                auto Pixel         = In[Index];
+                Out[4 * Index + 0] = Table[Pixel & 0xFF];
+                Out[4 * Index + 1] = Table[(Pixel >> 8) & 0xFF];
+                Out[4 * Index + 2] = Table[(Pixel >> 16) & 0xFF];
+                Out[4 * Index + 3] = uint16((Pixel >> 24) * 257);
+            }
+        }
+
+        inline void UnpackLinearRow(const uint16* In, uint32* Out, int32 Count)
+        {
+            auto Table = GetLinearToSrgbTable();
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                auto Pixel = In + 4 * Index;
+                auto Alpha = (uint32(Pixel[3]) * 255 + 32767) / 65535;
+                auto Red   = uint32(Table[(Pixel[2] + 8) >> 4]);
+                auto Green = uint32(Table[(Pixel[1] + 8) >> 4]);
+                Out[Index] = Alpha << 24 | Red << 16 | Green << 8 | Table[(Pixel[0] + 8) >> 4];
+            }
+        }
+
+        using ShuffleKernel = void (*)(const uint32* In, uint32* Out, int32 Count, const ChannelShuffle& Shuffle);
+        using AlphaKernel   = void (*)(const uint32* In, uint32* Out, int32 Count);
+
+        // The kernels of a level, SSSE3 ones only on a CPU that has it
+        struct Kernels
+        {
+            ShuffleKernel Shuffle;
+            AlphaKernel   Premultiply;
+            AlphaKernel   Unpremultiply;
+            void (*Pack565)(const uint32* In, uint16* Out, int32 Count);
+            void (*Unpack565)(const uint16* In, uint32* Out, int32 Count);
+            void (*PackGray)(const uint32* In, uint8* Out, int32 Count);
+            void (*UnpackGray)(const uint8* In, uint32* Out, int32 Count);
+        };
+
+        inline Kernels GetKernels(SimdLevel Level)
+        {
+            if (Level >= SimdLevel::Avx2)
+            {
+                return { ShuffleRowAvx2, PremultiplyRowAvx2, UnpremultiplyRowAvx2, Pack565RowAvx2,
+                         Unpack565RowAvx2, PackGrayRowAvx2, UnpackGrayRowAvx2 };
+            }
+            if (Level == SimdLevel::Sse2)
+            {
+                auto HasSsse3 = GetCpuFeatures().Ssse3;
+                return { HasSsse3 ? ShuffleRowSsse3 : ShuffleRowScalar,
+                         PremultiplyRowSse2,
+                         UnpremultiplyRowSse2,
+                         Pack565RowSse2,
+                         Unpack565RowSse2,
+                         HasSsse3 ? PackGrayRowSsse3 : PackGrayRowScalar,
+                         UnpackGrayRowSse2 };
+            }
+            return { ShuffleRowScalar,   PremultiplyRowScalar, UnpremultiplyRowScalar, Pack565RowScalar,
+                     Unpack565RowScalar, PackGrayRowScalar,    UnpackGrayRowScalar };
+        }
+
+        enum class AlphaKind : uint32
+        {
+            Opaque,
+            Straight,
+            Premultiplied,
+        };
+
+        inline AlphaKind GetAlphaKind(PixelFormat Format)
+        {
+            switch (Format)
+            {
+            case PixelFormat::Bgra8:
+            case PixelFormat::Rgba8:
+            case PixelFormat::Argb8:
+            case PixelFormat::Bgra16Linear:
+                return AlphaKind::Straight;
+            case PixelFormat::Bgra8Premultiplied:
+                return AlphaKind::Premultiplied;
+            default:
+                return AlphaKind::Opaque;
+            }
+        }
+
+        inline bool IsByteOrder(PixelFormat Format)
+        {
+            return GetBytesPerPixel(Format) == 4;
+        }
+
+        // The shuffle of a 32-bit format to the canonical one: its own inverse, the alpha of BGRX forced both ways
+        inline ChannelShuffle GetShuffle(PixelFormat Format)
+        {
+            ChannelShuffle Shuffle = { { 0, 1, 2, 3 }, 0 };
+            if (Format == PixelFormat::Rgba8)
+            {
+                Shuffle = { { 2, 1, 0, 3 }, 0 };
+            }
+            else if (Format == PixelFormat::Argb8)
+            {
+                Shuffle = { { 3, 2, 1, 0 }, 0 };
+            }
+            Shuffle.Or = Format == PixelFormat::Bgrx8 ? 0xFF000000 : 0;
+            return Shuffle;
+        }
+
+        inline bool IsIdentity(const ChannelShuffle& Shuffle)
+        {
+            return Shuffle.Index[0] == 0 && Shuffle.Index[1] == 1 && Shuffle.Index[2] == 2 && Shuffle.Index[3] == 3
+                   && Shuffle.Or == 0;
+        }
+
+        // Source then Destination: byte I of the result is byte Destination.Index[I] of the canonical pixel
+        inline ChannelShuffle Combine(const ChannelShuffle& Source, const ChannelShuffle& Destination)
+        {
+            ChannelShuffle Result = { { 4, 4, 4, 4 }, 0 };
+            for (uint32 Byte = 0; Byte < 4; ++Byte)
+            {
+                auto From          = Destination.Index[Byte];
+                Result.Index[Byte] = From < 4 ? Source.Index[From] : 4;
+                Result.Or |= From < 4 ? ((Source.Or >> (8 * From)) & 0xFF) << (8 * Byte) : 0;
+            }
+            Result.Or |= Destination.Or;
+            return Result;
+        }
+    } // namespace PixelConversion
+
+    // Converts the pixels of Source into Destination, over the smaller of their widths and heights. Both may be the
+    // same memory when their pixels have the same size.
+    inline void ConvertPixels(const PixelView& Source,
+                              const PixelView& Destination,
+                              SimdLevel        Level = GetBestSimdLevel())
+    {
+        using namespace PixelConversion;
+        auto Width      = Source.Width < Destination.Width ? Source.Width : Destination.Width;
+        auto Height     = Source.Height < Destination.Height ? Source.Height : Destination.Height;
+        auto Kernel     = GetKernels(Level);
+        auto FromKind   = GetAlphaKind(Source.Format);
+        auto ToKind     = GetAlphaKind(Destination.Format);
+        auto AlphaStep  = FromKind == AlphaKind::Straight && ToKind != AlphaKind::Straight ? Kernel.Premultiply
+                          : FromKind == AlphaKind::Premultiplied && ToKind == AlphaKind::Straight ? Kernel.Unpremultiply
+                                                                                                 : nullptr;
+        auto Unpack     = GetShuffle(Source.Format);
+        auto Pack       = GetShuffle(Destination.Format);
+        auto IsShuffle  = IsByteOrder(Source.Format) && IsByteOrder(Destination.Format) && !AlphaStep;
+        auto Direct     = Combine(Unpack, Pack);
+        auto InSize     = GetBytesPerPixel(Source.Format);
+        auto OutSize    = GetBytesPerPixel(Destination.Format);
+        alignas(32) uint32 Unpacked[ChunkSize];
+        alignas(32) uint32 Converted[ChunkSize];
+        for (int32 Y = 0; Y < Height; ++Y)
+        {
+            auto InRow  = static_cast<const uint8*>(Source.Memory) + int64(Y) * Source.Pitch;
+            auto OutRow = static_cast<uint8*>(Destination.Memory) + int64(Y) * Destination.Pitch;
+            for (int32 X = 0; X < Width; X += ChunkSize)
+            {
+                auto Count  = Width - X < ChunkSize ? Width - X : ChunkSize;
+                auto In     = InRow + int64(X) * InSize;
+                auto Out    = OutRow + int64(X) * OutSize;
+                auto Pixels = reinterpret_cast<const uint32*>(In);
+                if (IsShuffle)
+                {
+                    Kernel.Shuffle(Pixels, reinterpret_cast<uint32*>(Out), Count, Direct);
+                    continue;
+                }
+                switch (Source.Format)
+                {
+                case PixelFormat::Rgb565:
+                    Kernel.Unpack565(reinterpret_cast<const uint16*>(In), Unpacked, Count);
+                    Pixels = Unpacked;
+                    break;
+                case PixelFormat::Gray8:
+                    Kernel.UnpackGray(In, Unpacked, Count);
+                    Pixels = Unpacked;
+                    break;
+                case PixelFormat::Bgra16Linear:
+                    UnpackLinearRow(reinterpret_cast<const uint16*>(In), Unpacked, Count);
+                    Pixels = Unpacked;
+                    break;
+                default:
+                    if (!IsIdentity(Unpack))
+                    {
+                        Kernel.Shuffle(Pixels, Unpacked, Count, Unpack);
+                        Pixels = Unpacked;
+                    }
+                    break;
+                }
+                if (AlphaStep)
+                {
+                    // straight into a canonical destination
+                    auto IsLast = IsByteOrder(Destination.Format) && IsIdentity(Pack);
+                    auto Target = IsLast ? reinterpret_cast<uint32*>(Out) : Converted;
+                    AlphaStep(Pixels, Target, Count);
+                    if (IsLast)
+                    {
+                        continue;
+                    }
+                    Pixels = Converted;
+                }
+                switch (Destination.Format)
+                {
+                case PixelFormat::Rgb565:
+                    Kernel.Pack565(Pixels, reinterpret_cast<uint16*>(Out), Count);
+                    break;
+                case PixelFormat::Gray8:
+                    Kernel.PackGray(Pixels, Out, Count);
+                    break;
+                case PixelFormat::Bgra16Linear:
+                    PackLinearRow(Pixels, reinterpret_cast<uint16*>(Out), Count);
+                    break;
+                default:
+                    Kernel.Shuffle(Pixels, reinterpret_cast<uint32*>(Out), Count, Pack);
+                    break;
+                }
+            }
+        }
+    }
+
+} // namespace Game
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "types.hpp"
+
+#if _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+namespace Game
+{
+    inline uint64 ReadCycleCounter()
+    {
+        return __rdtsc();
+    }
+
+    // Accumulated cost of one instrumented block (an audio effect, a render pass...)
+    struct ProfileRecord
+    {
+        const char* Name           = nullptr;
+        uint64      HitCount       = 0;
+        uint64      CycleCount     = 0;
+        uint64      LastCycleCount = 0; // cost of the last hit only
+
+        void Reset()
+        {
+            HitCount       = 0;
+            CycleCount     = 0;
+            LastCycleCount = 0;
+        }
+    };
+
+    // Adds the cycles spent in its scope to a ProfileRecord
+    class TimedBlock final
+    {
+    public:
+        explicit TimedBlock(ProfileRecord& Record)
+            : Record{ Record }
+            , StartCycleCount{ ReadCycleCounter() }
+        {}
+        TimedBlock(const TimedBlock&) = delete; // non copyable
+
+        ~TimedBlock()
+        {
+            auto Elapsed          = ReadCycleCounter() - StartCycleCount;
+            Record.LastCycleCount = Elapsed;
+            Record.CycleCount += Elapsed;
+            ++Record.HitCount;
+        }
+
+    private:
+        ProfileRecord& Record;
+        uint64         StartCycleCount;
+    };
+
+} // namespace Game
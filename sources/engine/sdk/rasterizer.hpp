@@ -0,0 +1,639 @@
+#pragma once
+
+#include "blit.hpp"
+#include "job_system.hpp"
+#include "memory_arena.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+#include <cmath>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// Half-space triangle rasterizer into a PIBackBuffer, with an optional depth buffer.
+//
+// Vertices are in pixels (X, Y), with the depth Z in [0, 1] and the clip space W, which must be positive: clipping
+// against the near plane is the caller's job, the rest is handled by the guard band (GuardBand pixels around the
+// target) and the scissor. Positions are snapped to 1/16 of a pixel and covered with integer edge functions and the
+// top-left rule: a pixel shared by two triangles is drawn exactly once.
+//
+// PushTriangle sets triangles up and Execute bins them into 64x64 tiles, rasterized in parallel. In a tile, 8x8 blocks
+// are rejected, accepted or tested per pixel, 8 pixels at a time. Colors and texture coordinates are interpolated with
+// perspective correction, the texture (optional, power of two sizes) is sampled nearest with wrapping and modulated by
+// the color. The output is opaque.
+
+namespace Game
+{
+    struct RasterVertex
+    {
+        real32 X, Y, Z, W;
+        real32 R, G, B, A; // in [0, 1]
+        real32 U, V;
+    };
+
+    struct RasterTarget
+    {
+        PIBackBuffer Color;
+        real32*      Depth = nullptr; // Width * Height values, cleared to 1 for the farthest, or null
+    };
+
+    namespace Raster
+    {
+        constexpr int32  SubpixelBits  = 4;
+        constexpr int32  SubpixelScale = 1 << SubpixelBits;
+        constexpr int32  BlockSize     = 8;
+        constexpr int32  TileSize      = 64;
+        constexpr real32 GuardBand     = 8192.0f; // edge functions stay on 64 bits, blocks on 32 bits
+        constexpr int32  AcceptedEdge  = 1 << 30; // block start of an edge covering the whole block
+
+        // Interpolated attributes, divided by W but for Z and InvW
+        enum Attribute : uint32
+        {
+            Z,
+            InvW,
+            R,
+            G,
+            B,
+            A,
+            U,
+            V,
+            AttributeCount
+        };
+
+        // Value at (OriginX + DX, OriginY + DY) = Value + DX * StepX + DY * StepY
+        struct Plane
+        {
+            real32 Value;
+            real32 StepX;
+            real32 StepY;
+        };
+
+        struct Triangle
+        {
+            int64         EdgeA[3]; // E(x, y) = A x + B y + C in subpixels, top-left bias in C: inside when E >= 0
+            int64         EdgeB[3];
+            int64         EdgeC[3];
+            BlitRect      Bounds; // covered pixels, clipped to the target
+            real32        OriginX;
+            real32        OriginY;
+            Plane         Planes[AttributeCount];
+            const Bitmap* Texture;
+        };
+
+        inline Plane MakePlane(real32 X1, real32 Y1, real32 X2, real32 Y2, real32 InverseArea, const real32 Values[3])
+        {
+            auto D1 = Values[1] - Values[0];
+            auto D2 = Values[2] - Values[0];
+            return { Values[0], (D1 * Y2 - D2 * Y1) * InverseArea, (D2 * X1 - D1 * X2) * InverseArea };
+        }
+
+        // first pixel whose center is at or after Subpixel
+        inline int32 FirstPixel(int64 Subpixel)
+        {
+            auto Shifted = Subpixel - SubpixelScale / 2 + SubpixelScale - 1;
+            auto Floor   = Shifted >= 0 ? Shifted / SubpixelScale : -((-Shifted + SubpixelScale - 1) / SubpixelScale);
+            return static_cast<int32>(Floor);
+        }
+
+        // Returns false if the triangle is degenerate, behind the camera, out of the guard band or of Target
+        inline bool SetupTriangle(const RasterVertex& V0,
+                                  const RasterVertex& V1,
+                                  const RasterVertex& V2,
+                                  const BlitRect&     Target,
+                                  Triangle&           Result)
+        {
+            // both faces are drawn: the triangles are wound the same way, inside is E >= 0
+            const RasterVertex* Vertices[3] = { &V0, &V1, &V2 };
+            int64               X[3];
+            int64               Y[3];
+            for (int Index = 0; Index < 3; ++Index)
+            {
+                auto& Vertex = *Vertices[Index];
+                if (!(Vertex.W > 0.0f) || !(std::fabs(Vertex.X) < GuardBand) || !(std::fabs(Vertex.Y) < GuardBand))
+                {
+                    return false;
+                }
+                X[Index] = static_cast<int64>(std::lrint(Vertex.X * SubpixelScale));
+                Y[Index] = static_cast<int64>(std::lrint(Vertex.Y * SubpixelScale));
+            }
+            auto Area = (X[1] - X[0]) * (Y[2] - Y[0]) - (Y[1] - Y[0]) * (X[2] - X[0]);
+            if (Area == 0)
+            {
+                return false;
+            }
+            if (Area < 0)
+            {
+                auto SwapX  = X[1];
+                auto SwapY  = Y[1];
+                X[1]        = X[2];
+                Y[1]        = Y[2];
+                X[2]        = SwapX;
+                Y[2]        = SwapY;
+                Vertices[1] = &V2;
+                Vertices[2] = &V1;
+                Area        = -Area;
+            }
+
+            int64 MinX = X[0], MaxX = X[0], MinY = Y[0], MaxY = Y[0];
+            for (int Index = 1; Index < 3; ++Index)
+            {
+                MinX = X[Index] < MinX ? X[Index] : MinX;
+                MaxX = X[Index] > MaxX ? X[Index] : MaxX;
+                MinY = Y[Index] < MinY ? Y[Index] : MinY;
+                MaxY = Y[Index] > MaxY ? Y[Index] : MaxY;
+            }
+            BlitRect Bounds = { FirstPixel(MinX), FirstPixel(MinY), FirstPixel(MaxX + 1), FirstPixel(MaxY + 1) };
+            Result.Bounds   = Intersect(Target, Bounds);
+            if (Result.Bounds.IsEmpty())
+            {
+                return false;
+            }
+
+            for (int Edge = 0; Edge < 3; ++Edge)
+            {
+                auto From      = Edge;
+                auto To        = (Edge + 1) % 3;
+                auto DX        = X[To] - X[From];
+                auto DY        = Y[To] - Y[From];
+                auto IsTopLeft = (DY == 0 && DX > 0) || DY < 0;
+
+                Result.EdgeA[Edge] = -DY;
+                Result.EdgeB[Edge] = DX;
+                Result.EdgeC[Edge] = DY * X[From] - DX * Y[From] - (IsTopLeft ? 0 : 1);
+            }
+
+            // attribute planes, from the snapped positions
+            Result.OriginX   = real32(X[0]) / SubpixelScale;
+            Result.OriginY   = real32(Y[0]) / SubpixelScale;
+            auto X1          = real32(X[1] - X[0]) / SubpixelScale;
+            auto Y1          = real32(Y[1] - Y[0]) / SubpixelScale;
+            auto X2          = real32(X[2] - X[0]) / SubpixelScale;
+            auto Y2          = real32(Y[2] - Y[0]) / SubpixelScale;
+            auto InverseArea = real32(SubpixelScale * SubpixelScale) / real32(Area);
+
+            real32 Values[AttributeCount][3];
+            for (int Index = 0; Index < 3; ++Index)
+            {
+                auto& Vertex        = *Vertices[Index];
+                auto  OneOverW      = 1.0f / Vertex.W;
+                Values[Z][Index]    = Vertex.Z;
+                Values[InvW][Index] = OneOverW;
+                Values[R][Index]    = Vertex.R * OneOverW;
+                Values[G][Index]    = Vertex.G * OneOverW;
+                Values[B][Index]    = Vertex.B * OneOverW;
+                Values[A][Index]    = Vertex.A * OneOverW;
+                Values[U][Index]    = Vertex.U * OneOverW;
+                Values[V][Index]    = Vertex.V * OneOverW;
+            }
+            for (uint32 Attribute = 0; Attribute < AttributeCount; ++Attribute)
+            {
+                Result.Planes[Attribute] = MakePlane(X1, Y1, X2, Y2, InverseArea, Values[Attribute]);
+            }
+            return true;
+        }
+
+        // Row kernels: shade pixels from (X, Y), Edges are the edge functions of the first pixel. The SIMD ones always
+        // load and store a whole 4 or 8 pixel row, the scalar one handles Count pixels at the right of the target.
+        // They return the number of pixels written.
+
+        inline uint32 CountBits(uint32 Mask)
+        {
+            Mask = Mask - ((Mask >> 1) & 0x55);
+            Mask = (Mask & 0x33) + ((Mask >> 2) & 0x33);
+            return (Mask + (Mask >> 4)) & 0x0F;
+        }
+
+        inline uint32 ShadePixel(const Triangle& T, real32 DX, real32 DY, real32* Depth, uint32* Color)
+        {
+            auto Eval = [&](uint32 Attribute) {
+                auto& Plane = T.Planes[Attribute];
+                return Plane.Value + Plane.StepX * DX + Plane.StepY * DY;
+            };
+            auto Z = Eval(Raster::Z);
+            if (Depth && !(Z < *Depth))
+            {
+                return 0;
+            }
+            auto W     = 1.0f / Eval(InvW);
+            auto Scale = W * 255.0f;
+            auto Red   = Eval(R) * Scale;
+            auto Green = Eval(G) * Scale;
+            auto Blue  = Eval(B) * Scale;
+            auto Alpha = Eval(A) * Scale;
+            if (T.Texture)
+            {
+                auto& Texture = *T.Texture;
+                auto  TexelX  = static_cast<int32>(std::floor(Eval(U) * W * real32(Texture.Width)));
+                auto  TexelY  = static_cast<int32>(std::floor(Eval(V) * W * real32(Texture.Height)));
+                auto  Texel   = Texture.GetRow(TexelY & (Texture.Height - 1))[TexelX & (Texture.Width - 1)];
+                Red *= real32((Texel >> 16) & 0xFF) * (1.0f / 255.0f);
+                Green *= real32((Texel >> 8) & 0xFF) * (1.0f / 255.0f);
+                Blue *= real32(Texel & 0xFF) * (1.0f / 255.0f);
+                Alpha *= real32(Texel >> 24) * (1.0f / 255.0f);
+            }
+            auto ToByte = [](real32 Value) {
+                auto Byte = static_cast<int32>(Value + 0.5f);
+                return static_cast<uint32>(Byte < 0 ? 0 : Byte > 255 ? 255 : Byte);
+            };
+            if (Depth)
+            {
+                *Depth = Z;
+            }
+            *Color = (ToByte(Alpha) << 24) | (ToByte(Red) << 16) | (ToByte(Green) << 8) | ToByte(Blue);
+            return 1;
+        }
+
+        inline uint32 ShadeRowScalar(
+            const Triangle& T, int32 X, int32 Y, const int32 Edges[3], int32 Count, real32* Depth, uint32* Color)
+        {
+            uint32 Written = 0;
+            auto   DY      = real32(Y) + 0.5f - T.OriginY;
+            for (int32 Lane = 0; Lane < Count; ++Lane)
+            {
+                auto StepX = Lane * SubpixelScale;
+                if (Edges[0] + int32(T.EdgeA[0]) * StepX >= 0 && Edges[1] + int32(T.EdgeA[1]) * StepX >= 0 &&
+                    Edges[2] + int32(T.EdgeA[2]) * StepX >= 0)
+                {
+                    auto DX = real32(X + Lane) + 0.5f - T.OriginX;
+                    Written += ShadePixel(T, DX, DY, Depth ? Depth + Lane : nullptr, Color + Lane);
+                }
+            }
+            return Written;
+        }
+
+        // 4 pixels, twice per block row
+        inline uint32
+        ShadeRowSse2(const Triangle& T, int32 X, int32 Y, const int32 Edges[3], real32* Depth, uint32* Color)
+        {
+            auto Lanes  = _mm_setr_epi32(0, 1, 2, 3);
+            auto Inside = _mm_set1_epi32(-1);
+            for (int Edge = 0; Edge < 3; ++Edge)
+            {
+                auto Step   = int32(T.EdgeA[Edge]) * SubpixelScale;
+                auto Values = _mm_add_epi32(_mm_set1_epi32(Edges[Edge]), _mm_setr_epi32(0, Step, 2 * Step, 3 * Step));
+                Inside      = _mm_andnot_si128(_mm_srai_epi32(Values, 31), Inside);
+            }
+            if (!_mm_movemask_epi8(Inside))
+            {
+                return 0;
+            }
+            auto DX   = _mm_add_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(X), Lanes)),
+                                 _mm_set1_ps(0.5f - T.OriginX));
+            auto DY   = _mm_set1_ps(real32(Y) + 0.5f - T.OriginY);
+            auto Eval = [&](uint32 Attribute) {
+                auto& Plane = T.Planes[Attribute];
+                return _mm_add_ps(_mm_add_ps(_mm_set1_ps(Plane.Value), _mm_mul_ps(_mm_set1_ps(Plane.StepX), DX)),
+                                  _mm_mul_ps(_mm_set1_ps(Plane.StepY), DY));
+            };
+            auto Z = Eval(Raster::Z);
+            if (Depth)
+            {
+                Inside = _mm_and_si128(Inside, _mm_castps_si128(_mm_cmplt_ps(Z, _mm_loadu_ps(Depth))));
+                if (!_mm_movemask_epi8(Inside))
+                {
+                    return 0;
+                }
+            }
+            auto W     = _mm_div_ps(_mm_set1_ps(1.0f), Eval(InvW));
+            auto Scale = _mm_mul_ps(W, _mm_set1_ps(255.0f));
+            auto Red   = _mm_mul_ps(Eval(R), Scale);
+            auto Green = _mm_mul_ps(Eval(G), Scale);
+            auto Blue  = _mm_mul_ps(Eval(B), Scale);
+            auto Alpha = _mm_mul_ps(Eval(A), Scale);
+            if (T.Texture)
+            {
+                auto& Texture = *T.Texture;
+                auto  Floor   = [](__m128 Value) {
+                    // no _mm_floor_ps before SSE4.1
+                    auto Truncated = _mm_cvttps_epi32(Value);
+                    return _mm_add_epi32(Truncated, _mm_castps_si128(_mm_cmplt_ps(Value, _mm_cvtepi32_ps(Truncated))));
+                };
+                auto TexelX = Floor(_mm_mul_ps(_mm_mul_ps(Eval(U), W), _mm_set1_ps(real32(Texture.Width))));
+                auto TexelY = Floor(_mm_mul_ps(_mm_mul_ps(Eval(V), W), _mm_set1_ps(real32(Texture.Height))));
+                TexelX      = _mm_and_si128(TexelX, _mm_set1_epi32(Texture.Width - 1));
+                TexelY      = _mm_and_si128(TexelY, _mm_set1_epi32(Texture.Height - 1));
+                alignas(16) int32  Xs[4];
+                alignas(16) int32  Ys[4];
+                alignas(16) uint32 Texels[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(Xs), TexelX);
+                _mm_store_si128(reinterpret_cast<__m128i*>(Ys), TexelY);
+                for (int Lane = 0; Lane < 4; ++Lane)
+                {
+                    Texels[Lane] = Texture.GetRow(Ys[Lane])[Xs[Lane]];
+                }
+                auto Texel   = _mm_load_si128(reinterpret_cast<const __m128i*>(Texels));
+                auto Channel = [&](int Shift) {
+                    auto Bytes = _mm_and_si128(_mm_srli_epi32(Texel, Shift), _mm_set1_epi32(0xFF));
+                    return _mm_mul_ps(_mm_cvtepi32_ps(Bytes), _mm_set1_ps(1.0f / 255.0f));
+                };
+                Red   = _mm_mul_ps(Red, Channel(16));
+                Green = _mm_mul_ps(Green, Channel(8));
+                Blue  = _mm_mul_ps(Blue, Channel(0));
+                Alpha = _mm_mul_ps(Alpha, Channel(24));
+            }
+            // rounded, saturated to bytes by the packs
+            auto Half   = _mm_set1_ps(0.5f);
+            auto Round  = [&](__m128 Value) { return _mm_cvttps_epi32(_mm_add_ps(Value, Half)); };
+            auto Bytes  = _mm_packus_epi16(_mm_packs_epi32(Round(Blue), Round(Red)),
+                                          _mm_packs_epi32(Round(Green), Round(Alpha))); // B0-3 R0-3 G0-3 A0-3
+            auto BG     = _mm_unpacklo_epi8(Bytes, _mm_srli_si128(Bytes, 8)); // B0 G0 B1 G1...
+            auto RA     = _mm_unpacklo_epi8(_mm_srli_si128(Bytes, 4), _mm_srli_si128(Bytes, 12));
+            auto Pixels = _mm_unpacklo_epi16(BG, RA);
+
+            auto Target   = reinterpret_cast<__m128i*>(Color);
+            auto Previous = _mm_loadu_si128(Target);
+            _mm_storeu_si128(Target, _mm_or_si128(_mm_and_si128(Inside, Pixels), _mm_andnot_si128(Inside, Previous)));
+            if (Depth)
+            {
+                auto Mask = _mm_castsi128_ps(Inside);
+                _mm_storeu_ps(Depth, _mm_or_ps(_mm_and_ps(Mask, Z), _mm_andnot_ps(Mask, _mm_loadu_ps(Depth))));
+            }
+            return CountBits(static_cast<uint32>(_mm_movemask_ps(_mm_castsi128_ps(Inside))));
+        }
+
+        // lambdas do not inherit the target attribute, helpers do
+        GAME_TARGET_AVX2 inline __m256 EvalPlane8(const Plane& Plane, __m256 DX, __m256 DY)
+        {
+            auto StepX = _mm256_mul_ps(_mm256_set1_ps(Plane.StepX), DX);
+            auto StepY = _mm256_mul_ps(_mm256_set1_ps(Plane.StepY), DY);
+            return _mm256_add_ps(_mm256_add_ps(_mm256_set1_ps(Plane.Value), StepX), StepY);
+        }
+
+        GAME_TARGET_AVX2 inline __m256i Round8(__m256 Value)
+        {
+            return _mm256_cvttps_epi32(_mm256_add_ps(Value, _mm256_set1_ps(0.5f)));
+        }
+
+        GAME_TARGET_AVX2 inline __m256 TexelChannel8(__m256i Texel, int Shift)
+        {
+            auto Bytes = _mm256_and_si256(_mm256_srli_epi32(Texel, Shift), _mm256_set1_epi32(0xFF));
+            return _mm256_mul_ps(_mm256_cvtepi32_ps(Bytes), _mm256_set1_ps(1.0f / 255.0f));
+        }
+
+        GAME_TARGET_AVX2 inline uint32
+        ShadeRowAvx2(const Triangle& T, int32 X, int32 Y, const int32 Edges[3], real32* Depth, uint32* Color)
+        {
+            auto Lanes  = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            auto Inside = _mm256_set1_epi32(-1);
+            for (int Edge = 0; Edge < 3; ++Edge)
+            {
+                auto Step   = _mm256_set1_epi32(int32(T.EdgeA[Edge]) * SubpixelScale);
+                auto Values = _mm256_add_epi32(_mm256_set1_epi32(Edges[Edge]), _mm256_mullo_epi32(Lanes, Step));
+                Inside      = _mm256_andnot_si256(_mm256_srai_epi32(Values, 31), Inside);
+            }
+            if (_mm256_testz_si256(Inside, Inside))
+            {
+                return 0;
+            }
+            auto DX = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(X), Lanes)),
+                                    _mm256_set1_ps(0.5f - T.OriginX));
+            auto DY = _mm256_set1_ps(real32(Y) + 0.5f - T.OriginY);
+            auto Z  = EvalPlane8(T.Planes[Raster::Z], DX, DY);
+            if (Depth)
+            {
+                auto Closer = _mm256_cmp_ps(Z, _mm256_loadu_ps(Depth), _CMP_LT_OQ);
+                Inside      = _mm256_and_si256(Inside, _mm256_castps_si256(Closer));
+                if (_mm256_testz_si256(Inside, Inside))
+                {
+                    return 0;
+                }
+            }
+            auto W     = _mm256_div_ps(_mm256_set1_ps(1.0f), EvalPlane8(T.Planes[InvW], DX, DY));
+            auto Scale = _mm256_mul_ps(W, _mm256_set1_ps(255.0f));
+            auto Red   = _mm256_mul_ps(EvalPlane8(T.Planes[R], DX, DY), Scale);
+            auto Green = _mm256_mul_ps(EvalPlane8(T.Planes[G], DX, DY), Scale);
+            auto Blue  = _mm256_mul_ps(EvalPlane8(T.Planes[B], DX, DY), Scale);
+            auto Alpha = _mm256_mul_ps(EvalPlane8(T.Planes[A], DX, DY), Scale);
+            if (T.Texture)
+            {
+                auto& Texture = *T.Texture;
+                auto  TexU    = _mm256_mul_ps(EvalPlane8(T.Planes[U], DX, DY), W);
+                auto  TexV    = _mm256_mul_ps(EvalPlane8(T.Planes[V], DX, DY), W);
+                auto  FloorU  = _mm256_floor_ps(_mm256_mul_ps(TexU, _mm256_set1_ps(real32(Texture.Width))));
+                auto  FloorV  = _mm256_floor_ps(_mm256_mul_ps(TexV, _mm256_set1_ps(real32(Texture.Height))));
+                auto  TexelX  = _mm256_and_si256(_mm256_cvttps_epi32(FloorU), _mm256_set1_epi32(Texture.Width - 1));
+                auto  TexelY  = _mm256_and_si256(_mm256_cvttps_epi32(FloorV), _mm256_set1_epi32(Texture.Height - 1));
+                auto  Row     = _mm256_mullo_epi32(TexelY, _mm256_set1_epi32(Texture.Pitch / 4));
+                auto  Texels  = reinterpret_cast<const int*>(Texture.Pixels);
+                auto  Texel   = _mm256_i32gather_epi32(Texels, _mm256_add_epi32(Row, TexelX), 4);
+                Red           = _mm256_mul_ps(Red, TexelChannel8(Texel, 16));
+                Green         = _mm256_mul_ps(Green, TexelChannel8(Texel, 8));
+                Blue          = _mm256_mul_ps(Blue, TexelChannel8(Texel, 0));
+                Alpha         = _mm256_mul_ps(Alpha, TexelChannel8(Texel, 24));
+            }
+            // same packing as ShadeRowSse2, inside each 128-bit lane
+            auto Bytes  = _mm256_packus_epi16(_mm256_packs_epi32(Round8(Blue), Round8(Red)),
+                                             _mm256_packs_epi32(Round8(Green), Round8(Alpha)));
+            auto BG     = _mm256_unpacklo_epi8(Bytes, _mm256_srli_si256(Bytes, 8));
+            auto RA     = _mm256_unpacklo_epi8(_mm256_srli_si256(Bytes, 4), _mm256_srli_si256(Bytes, 12));
+            auto Pixels = _mm256_unpacklo_epi16(BG, RA);
+
+            _mm256_maskstore_epi32(reinterpret_cast<int*>(Color), Inside, Pixels);
+            if (Depth)
+            {
+                _mm256_maskstore_ps(Depth, Inside, Z);
+            }
+            return CountBits(static_cast<uint32>(_mm256_movemask_ps(_mm256_castsi256_ps(Inside))));
+        }
+
+        // Rasterizes the part of T inside Clip, whose left and top are multiples of BlockSize
+        inline uint32
+        RasterizeTriangle(const Triangle& T, const BlitRect& Clip, const RasterTarget& Target, SimdLevel Level)
+        {
+            auto Area = Intersect(T.Bounds, Clip);
+            if (Area.IsEmpty())
+            {
+                return 0;
+            }
+            uint32 Written   = 0;
+            auto&  Buffer    = Target.Color;
+            auto   ClipRight = Clip.MaxX < Buffer.Width ? Clip.MaxX : Buffer.Width;
+            for (auto BlockY = Area.MinY & ~(BlockSize - 1); BlockY < Area.MaxY; BlockY += BlockSize)
+            {
+                for (auto BlockX = Area.MinX & ~(BlockSize - 1); BlockX < Area.MaxX; BlockX += BlockSize)
+                {
+                    // edge functions at the first pixel center, and their extremes on the block
+                    int32 Edges[3];
+                    bool  IsOutside = false;
+                    for (int Edge = 0; Edge < 3; ++Edge)
+                    {
+                        auto A     = T.EdgeA[Edge] * SubpixelScale * (BlockSize - 1);
+                        auto B     = T.EdgeB[Edge] * SubpixelScale * (BlockSize - 1);
+                        auto Value = T.EdgeA[Edge] * (int64(BlockX) * SubpixelScale + SubpixelScale / 2) +
+                                     T.EdgeB[Edge] * (int64(BlockY) * SubpixelScale + SubpixelScale / 2) +
+                                     T.EdgeC[Edge];
+                        auto Max   = Value + (A > 0 ? A : 0) + (B > 0 ? B : 0);
+                        auto Min   = Value + (A < 0 ? A : 0) + (B < 0 ? B : 0);
+                        IsOutside |= Max < 0;
+                        // fully inside: any big value passes the tests of the whole block, and fits 32 bits
+                        Edges[Edge] = Min >= 0 ? AcceptedEdge : static_cast<int32>(Value);
+                    }
+                    if (IsOutside)
+                    {
+                        continue;
+                    }
+                    // the pixels out of the triangle but in the clip are rejected by the edges, no need to go scalar
+                    auto Count = ClipRight - BlockX < BlockSize ? ClipRight - BlockX : BlockSize;
+                    auto EndY  = Area.MaxY - BlockY < BlockSize ? Area.MaxY : BlockY + BlockSize;
+                    for (auto Y = BlockY; Y < EndY; ++Y)
+                    {
+                        auto Row   = static_cast<uint8*>(Buffer.Memory) + int64(Y) * Buffer.Pitch;
+                        auto Color = reinterpret_cast<uint32*>(Row) + BlockX;
+                        auto Depth = Target.Depth ? Target.Depth + int64(Y) * Buffer.Width + BlockX : nullptr;
+                        if (Count < BlockSize || Level == SimdLevel::Scalar)
+                        {
+                            Written += ShadeRowScalar(T, BlockX, Y, Edges, Count, Depth, Color);
+                        }
+                        else if (Level >= SimdLevel::Avx2)
+                        {
+                            Written += ShadeRowAvx2(T, BlockX, Y, Edges, Depth, Color);
+                        }
+                        else
+                        {
+                            int32 Right[3];
+                            for (int Edge = 0; Edge < 3; ++Edge)
+                            {
+                                Right[Edge] = Edges[Edge] + int32(T.EdgeA[Edge]) * SubpixelScale * 4;
+                            }
+                            Written += ShadeRowSse2(T, BlockX, Y, Edges, Depth, Color);
+                            Written += ShadeRowSse2(T, BlockX + 4, Y, Right, Depth ? Depth + 4 : nullptr, Color + 4);
+                        }
+                        for (int Edge = 0; Edge < 3; ++Edge)
+                        {
+                            Edges[Edge] += int32(T.EdgeB[Edge]) * SubpixelScale;
+                        }
+                    }
+                }
+            }
+            return Written;
+        }
+    } // namespace Raster
+
+    class Rasterizer final
+    {
+    public:
+        // The triangles are pushed on Arena, for a target of Width x Height pixels
+        Rasterizer(MemoryArena& Arena, uint32 MaxTriangleCount, int32 Width, int32 Height)
+            : Triangles{ Arena.PushArray<Raster::Triangle>(MaxTriangleCount, 64) }
+            , MaxTriangleCount{ Triangles ? MaxTriangleCount : 0 }
+            , Target{ 0, 0, Width, Height }
+        {}
+        Rasterizer(const Rasterizer&) = delete; // non copyable
+
+        // Texture is optional, its pixels must be valid until Execute
+        void PushTriangle(const RasterVertex& V0,
+                          const RasterVertex& V1,
+                          const RasterVertex& V2,
+                          const Bitmap*       Texture = nullptr)
+        {
+            if (TriangleCount == MaxTriangleCount)
+            {
+                ++DroppedCount;
+                return;
+            }
+            auto& Triangle = Triangles[TriangleCount];
+            if (!Raster::SetupTriangle(V0, V1, V2, Target, Triangle))
+            {
+                ++CulledCount;
+                return;
+            }
+            Triangle.Texture = Texture;
+            ++TriangleCount;
+        }
+
+        // Bins the triangles into tiles, draws the tiles (in parallel with Jobs) then empties the rasterizer.
+        // In a tile, triangles are drawn in push order. The bins are pushed on Scratch and released.
+        void Execute(const RasterTarget& Output,
+                     MemoryArena&        Scratch,
+                     JobSystem*          Jobs  = nullptr,
+                     SimdLevel           Level = GetBestSimdLevel())
+        {
+            TemporaryMemory Memory{ Scratch };
+
+            auto TileCountX = (Target.MaxX + Raster::TileSize - 1) / Raster::TileSize;
+            auto TileCountY = (Target.MaxY + Raster::TileSize - 1) / Raster::TileSize;
+            auto TileCount  = static_cast<uint32>(TileCountX * TileCountY);
+            auto TileStarts = Scratch.PushArray<uint32>(TileCount + 1);
+            auto Written    = Scratch.PushArray<uint64>(TileCount);
+            if (!TileStarts || !Written)
+            {
+                TriangleCount = 0;
+                return;
+            }
+            for (uint32 Tile = 0; Tile <= TileCount; ++Tile)
+            {
+                TileStarts[Tile] = 0;
+            }
+            ForEachTile(TileCountX, [&](uint32 Tile, uint32) { ++TileStarts[Tile + 1]; });
+            for (uint32 Tile = 0; Tile < TileCount; ++Tile)
+            {
+                TileStarts[Tile + 1] += TileStarts[Tile];
+            }
+            auto TileTriangles = Scratch.PushArray<uint32>(TileStarts[TileCount]);
+            auto Cursors       = Scratch.PushArray<uint32>(TileCount);
+            if (!TileTriangles || !Cursors)
+            {
+                TriangleCount = 0;
+                return;
+            }
+            for (uint32 Tile = 0; Tile < TileCount; ++Tile)
+            {
+                Cursors[Tile] = TileStarts[Tile];
+            }
+            ForEachTile(TileCountX, [&](uint32 Tile, uint32 Index) { TileTriangles[Cursors[Tile]++] = Index; });
+
+            ParallelFor(Jobs, TileCount, [&](uint32 Tile) {
+                auto     TileX = static_cast<int32>(Tile % TileCountX) * Raster::TileSize;
+                auto     TileY = static_cast<int32>(Tile / TileCountX) * Raster::TileSize;
+                BlitRect Clip  = { TileX, TileY, TileX + Raster::TileSize, TileY + Raster::TileSize };
+                uint64   Count = 0;
+                for (auto Index = TileStarts[Tile]; Index < TileStarts[Tile + 1]; ++Index)
+                {
+                    Count += Raster::RasterizeTriangle(Triangles[TileTriangles[Index]], Clip, Output, Level);
+                }
+                Written[Tile] = Count;
+            });
+
+            WrittenPixelCount = 0;
+            for (uint32 Tile = 0; Tile < TileCount; ++Tile)
+            {
+                WrittenPixelCount += Written[Tile];
+            }
+            TriangleCount = 0;
+        }
+
+        uint32 GetTriangleCount() const { return TriangleCount; }
+        uint32 GetCulledCount() const { return CulledCount; } // since construction
+        uint32 GetDroppedCount() const { return DroppedCount; } // rasterizer full, since construction
+        uint64 GetWrittenPixelCount() const { return WrittenPixelCount; } // by the last Execute, depth test passed
+
+    private:
+        // calls Function(Tile, TriangleIndex) for every tile touched by each triangle bounds
+        template <typename F>
+        void ForEachTile(int32 TileCountX, F&& Function) const
+        {
+            for (uint32 Index = 0; Index < TriangleCount; ++Index)
+            {
+                auto& Bounds = Triangles[Index].Bounds;
+                auto  LastX  = (Bounds.MaxX - 1) / Raster::TileSize;
+                auto  LastY  = (Bounds.MaxY - 1) / Raster::TileSize;
+                for (auto TileY = Bounds.MinY / Raster::TileSize; TileY <= LastY; ++TileY)
+                {
+                    for (auto TileX = Bounds.MinX / Raster::TileSize; TileX <= LastX; ++TileX)
+                    {
+                        Function(static_cast<uint32>(TileY * TileCountX + TileX), Index);
+                    }
+                }
+            }
+        }
+
+        Raster::Triangle* Triangles;
+        uint32            MaxTriangleCount;
+        uint32            TriangleCount     = 0;
+        uint32            CulledCount       = 0;
+        uint32            DroppedCount      = 0;
+        uint64            WrittenPixelCount = 0;
+        BlitRect          Target;
+    };
+
+} // namespace Game
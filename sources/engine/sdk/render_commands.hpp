@@ -0,0 +1,259 @@
+#pragma once
+
+#include "blit.hpp"
+#include "job_system.hpp"
+#include "memory_arena.hpp"
+#include "types.hpp"
+
+// Deferred 2D rendering: the game pushes commands with a sort key during the update, Execute sorts them once (radix
+// sort, stable: equal keys keep the push order), bins them into screen tiles and draws tile after tile, so a tile
+// stays in the cache while all its commands are drawn and tiles can be drawn in parallel.
+// Commands out of the target are culled when pushed. All the memory comes from arenas, nothing is allocated.
+
+namespace Game
+{
+    enum class RenderCommandType : uint32
+    {
+        Clear     = 0,
+        Rectangle = 1,
+        Bitmap    = 2,
+    };
+
+    struct RenderCommand
+    {
+        RenderCommandType Type;
+        uint32            Color; // Clear and Rectangle, premultiplied
+        BlitRect          Bounds; // in the target, already clipped
+        Bitmap            Sprite; // Bitmap only, the pixels must be valid until Execute
+        int32             X;
+        int32             Y;
+    };
+
+    struct RenderSortEntry
+    {
+        uint32 Key;
+        uint32 Index;
+    };
+
+    // LSD radix sort on the 32-bit keys, 8 bits per pass, Temporary holds Count entries too.
+    // Passes where every key has the same digit are skipped: sort keys are often small.
+    inline void RadixSort(RenderSortEntry* Entries, RenderSortEntry* Temporary, uint32 Count)
+    {
+        uint32 Histograms[4][256] = {};
+        for (uint32 Index = 0; Index < Count; ++Index)
+        {
+            auto Key = Entries[Index].Key;
+            ++Histograms[0][Key & 0xFF];
+            ++Histograms[1][(Key >> 8) & 0xFF];
+            ++Histograms[2][(Key >> 16) & 0xFF];
+            ++Histograms[3][Key >> 24];
+        }
+        auto Source      = Entries;
+        auto Destination = Temporary;
+        for (uint32 Pass = 0; Pass < 4; ++Pass)
+        {
+            auto& Histogram = Histograms[Pass];
+            auto  Shift     = Pass * 8;
+            if (Count && Histogram[(Source[0].Key >> Shift) & 0xFF] == Count)
+            {
+                continue;
+            }
+            uint32 Offset = 0;
+            for (auto& Bucket : Histogram)
+            {
+                auto BucketCount = Bucket;
+                Bucket           = Offset;
+                Offset += BucketCount;
+            }
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                Destination[Histogram[(Source[Index].Key >> Shift) & 0xFF]++] = Source[Index];
+            }
+            auto Swap   = Source;
+            Source      = Destination;
+            Destination = Swap;
+        }
+        if (Source != Entries)
+        {
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                Entries[Index] = Source[Index];
+            }
+        }
+    }
+
+    class RenderCommandBuffer final
+    {
+    public:
+        static constexpr int32 TileSize = 128; // 64KB of pixels, stays in L2
+
+        // The commands are pushed on Arena, for a target of Width x Height pixels
+        RenderCommandBuffer(MemoryArena& Arena, uint32 MaxCommandCount, int32 Width, int32 Height)
+            : Commands{ Arena.PushArray<RenderCommand>(MaxCommandCount) }
+            , Entries{ Arena.PushArray<RenderSortEntry>(MaxCommandCount) }
+            , MaxCommandCount{ Commands && Entries ? MaxCommandCount : 0 }
+            , Target{ 0, 0, Width, Height }
+        {}
+        RenderCommandBuffer(const RenderCommandBuffer&) = delete; // non copyable
+
+        void PushClear(uint32 SortKey, uint32 Color)
+        {
+            if (auto Command = Push(SortKey, RenderCommandType::Clear, Target))
+            {
+                Command->Color = Color;
+            }
+        }
+
+        void PushRectangle(uint32 SortKey, const BlitRect& Rectangle, uint32 Color)
+        {
+            if (auto Command = Push(SortKey, RenderCommandType::Rectangle, Rectangle))
+            {
+                Command->Color = Color;
+            }
+        }
+
+        void PushBitmap(uint32 SortKey, const Bitmap& Sprite, int32 X, int32 Y)
+        {
+            if (auto Command = Push(SortKey, RenderCommandType::Bitmap, { X, Y, X + Sprite.Width, Y + Sprite.Height }))
+            {
+                Command->Sprite = Sprite;
+                Command->X      = X;
+                Command->Y      = Y;
+            }
+        }
+
+        // Sorts, bins and draws everything, then empties the buffer. The bins are pushed on Scratch and released.
+        void Execute(const PIBackBuffer& Buffer,
+                     MemoryArena&        Scratch,
+                     JobSystem*          Jobs  = nullptr,
+                     SimdLevel           Level = GetBestSimdLevel())
+        {
+            TemporaryMemory Memory{ Scratch };
+
+            auto Temporary  = Scratch.PushArray<RenderSortEntry>(CommandCount);
+            auto TileCountX = (Target.MaxX + TileSize - 1) / TileSize;
+            auto TileCountY = (Target.MaxY + TileSize - 1) / TileSize;
+            auto TileCount  = static_cast<uint32>(TileCountX * TileCountY);
+            auto TileStarts = Scratch.PushArray<uint32>(TileCount + 1);
+            if (!Temporary || !TileStarts)
+            {
+                Reset();
+                return;
+            }
+            RadixSort(Entries, Temporary, CommandCount);
+
+            // binning: count, prefix sum, then fill in sort order
+            for (uint32 Tile = 0; Tile <= TileCount; ++Tile)
+            {
+                TileStarts[Tile] = 0;
+            }
+            ForEachTile([&](uint32 Tile, uint32) { ++TileStarts[Tile + 1]; });
+            for (uint32 Tile = 0; Tile < TileCount; ++Tile)
+            {
+                TileStarts[Tile + 1] += TileStarts[Tile];
+            }
+            auto TileCommands = Scratch.PushArray<uint32>(TileStarts[TileCount]);
+            auto Cursors      = Scratch.PushArray<uint32>(TileCount);
+            if (!TileCommands || !Cursors)
+            {
+                Reset();
+                return;
+            }
+            for (uint32 Tile = 0; Tile < TileCount; ++Tile)
+            {
+                Cursors[Tile] = TileStarts[Tile];
+            }
+            ForEachTile([&](uint32 Tile, uint32 Index) { TileCommands[Cursors[Tile]++] = Index; });
+
+            ParallelFor(Jobs, TileCount, [&](uint32 Tile) {
+                auto     TileX = static_cast<int32>(Tile % TileCountX) * TileSize;
+                auto     TileY = static_cast<int32>(Tile / TileCountX) * TileSize;
+                BlitRect Clip  = { TileX, TileY, TileX + TileSize, TileY + TileSize };
+
+                // nothing before the last opaque clear can be seen, a translucent one blends over it
+                auto First = TileStarts[Tile];
+                auto End   = TileStarts[Tile + 1];
+                for (auto Index = End; Index > First; --Index)
+                {
+                    auto& Command = Commands[TileCommands[Index - 1]];
+                    if (Command.Type == RenderCommandType::Clear && (Command.Color >> 24) == 0xFF)
+                    {
+                        First = Index - 1;
+                        break;
+                    }
+                }
+                for (auto Index = First; Index < End; ++Index)
+                {
+                    auto& Command = Commands[TileCommands[Index]];
+                    switch (Command.Type)
+                    {
+                    case RenderCommandType::Clear:
+                    case RenderCommandType::Rectangle:
+                        DrawRectangle(Buffer, Command.Bounds, Command.Color, Clip, Level);
+                        break;
+                    case RenderCommandType::Bitmap:
+                        DrawBitmap(Buffer, Command.Sprite, Command.X, Command.Y, Clip, Level);
+                        break;
+                    }
+                }
+            });
+            Reset();
+        }
+
+        void Reset() { CommandCount = 0; }
+
+        uint32 GetCommandCount() const { return CommandCount; }
+        uint32 GetCulledCount() const { return CulledCount; } // since construction
+        uint32 GetDroppedCount() const { return DroppedCount; } // buffer full, since construction
+
+    private:
+        RenderCommand* Push(uint32 SortKey, RenderCommandType Type, const BlitRect& Rectangle)
+        {
+            auto Bounds = Intersect(Rectangle, Target);
+            if (Bounds.IsEmpty())
+            {
+                ++CulledCount;
+                return nullptr;
+            }
+            if (CommandCount == MaxCommandCount)
+            {
+                ++DroppedCount;
+                return nullptr;
+            }
+            auto& Command         = Commands[CommandCount];
+            Command.Type          = Type;
+            Command.Bounds        = Bounds;
+            Entries[CommandCount] = { SortKey, CommandCount };
+            ++CommandCount;
+            return &Command;
+        }
+
+        // calls Function(Tile, CommandIndex) for every tile touched by each command, in sort order
+        template <typename F>
+        void ForEachTile(F&& Function) const
+        {
+            auto TileCountX = (Target.MaxX + TileSize - 1) / TileSize;
+            for (uint32 Entry = 0; Entry < CommandCount; ++Entry)
+            {
+                auto  Index  = Entries[Entry].Index;
+                auto& Bounds = Commands[Index].Bounds;
+                for (auto TileY = Bounds.MinY / TileSize; TileY <= (Bounds.MaxY - 1) / TileSize; ++TileY)
+                {
+                    for (auto TileX = Bounds.MinX / TileSize; TileX <= (Bounds.MaxX - 1) / TileSize; ++TileX)
+                    {
+                        Function(static_cast<uint32>(TileY * TileCountX + TileX), Index);
+                    }
+                }
+            }
+        }
+
+        RenderCommand*   Commands;
+        RenderSortEntry* Entries;
+        uint32           MaxCommandCount;
+        uint32           CommandCount = 0;
+        uint32           CulledCount  = 0;
+        uint32           DroppedCount = 0;
+        BlitRect         Target;
+    };
+
+} // namespace Game
@@ -0,0 +1,583 @@
+#pragma once
+
+#include "hash.hpp"
+#include "memory_arena.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Flat binary serialization, read in place: a block is a header and a root struct followed by the arrays and the
+// strings it references, all aligned. Loading is a check of the header and of the bounds of the references, then
+// the root is used where it lies (a mapped file, a buffer), without parsing nor copy.
+//
+//   Serialization::Header   Magic, Version, SchemaHash of the root type, Size
+//   T                       the root, as in memory
+//   ...                     SerialArray / SerialString data, referenced by offsets relative to the field
+//
+// A serialized struct lists all its fields in order with GAME_SERIAL_FIELD, which records their offsets
+// (reflection-light), optionally with a version for the changes of meaning:
+//
+//   struct SaveGame
+//   {
+//       wit::Meter              X;        // Quantity: float, the units are in the schema
+//       Health                  Life;     // strong_type: its value_type, the name of the type is in the schema
+//       SerialEnum<Weapon>      Equipped; // nonintegral_enum: the index of the value, the value names in the schema
+//       SerialArray<uint32>     Items;
+//       SerialString            Name;
+//       static constexpr uint32 SerialVersion = 2;
+//       static constexpr auto   GetSerialFields()
+//       {
+//           return std::make_tuple(GAME_SERIAL_FIELD(SaveGame, X), ..., GAME_SERIAL_FIELD(SaveGame, Name));
+//       }
+//   };
+//
+// The schema hash is computed at compile time from the offsets, the sizes, the alignments, the kinds and the units of
+// the fields in order, and the version: a block written by another layout is rejected. The fields must cover the
+// struct, each at the natural alignment of its type after the previous one: a member left out of the list, listed
+// twice or out of order fails to compile (see AreFieldsComplete). static_assert on GetSchemaHash<T>()
+// catches the unintended changes of a saved type. The wit types are recognized by their shape, the sdk does not
+// depend on wit. Pointers, InternedString and the raw nonintegral_enum (a type_info pointer) are refused.
+// Little endian only, like the targets.
+
+namespace Game
+{
+    // Count values stored after the field, Offset is relative to the field: the block moves as a whole
+    template <typename T>
+    struct SerialArray
+    {
+        using ValueType = T;
+
+        int32  Offset;
+        uint32 Count;
+
+        const T* GetData() const
+        {
+            return Count ? reinterpret_cast<const T*>(reinterpret_cast<const uint8*>(this) + Offset) : nullptr;
+        }
+        T*       GetData() { return const_cast<T*>(static_cast<const SerialArray&>(*this).GetData()); }
+        uint32   GetCount() const { return Count; }
+        const T* begin() const { return GetData(); }
+        const T* end() const { return GetData() + Count; }
+        const T& operator[](uint32 Index) const { return GetData()[Index]; }
+    };
+
+    // Length characters and a null, stored after the field
+    struct SerialString
+    {
+        int32  Offset;
+        uint32 Length;
+
+        const char* c_str() const { return Length ? reinterpret_cast<const char*>(this) + Offset : ""; }
+        std::string_view GetView() const { return { c_str(), Length }; }
+    };
+
+    namespace Serialization
+    {
+        template <typename E, size_t... I>
+        uint32 GetEnumIndex(const E& Value, std::index_sequence<I...>)
+        {
+            uint32 Index = 0;
+            ((Index = Value == std::tuple_element_t<I, typename E::values_type>{} ? uint32(I + 1) : Index), ...);
+            return Index;
+        }
+
+        template <typename E, size_t... I>
+        E GetEnumValue(uint32 Index, std::index_sequence<I...>)
+        {
+            E Value{};
+            ((Index == I + 1 ? (Value = E{ std::tuple_element_t<I, typename E::values_type>{} }, 0) : 0), ...);
+            return Value;
+        }
+    } // namespace Serialization
+
+    // A wit::nonintegral_enum by the index of its value: 0 for Invalid, then 1 + its position in values_type
+    template <typename E>
+    struct SerialEnum
+    {
+        using EnumType                     = E;
+        static constexpr uint32 ValueCount = uint32(std::tuple_size_v<typename E::values_type>);
+        using Indices                      = std::make_index_sequence<ValueCount>;
+
+        uint32 Index;
+
+        E    Get() const { return Serialization::GetEnumValue<E>(Index, Indices{}); }
+        void Set(const E& Value) { Index = Serialization::GetEnumIndex(Value, Indices{}); }
+    };
+
+    namespace Serialization
+    {
+        constexpr uint32 Magic   = 0x52455347; // "GSER"
+        constexpr uint32 Version = 1;
+
+        struct Header
+        {
+            uint32 Magic;
+            uint32 Version;
+            uint64 SchemaHash;
+            uint64 Size; // of the block, header included
+            uint32 RootOffset;
+            uint32 RootSize;
+        };
+
+        constexpr uint64 Combine(uint64 Hash, uint64 Value)
+        {
+            return MixHash(Hash ^ (Value + 0x9E3779B97F4A7C15ULL + (Hash << 6) + (Hash >> 2)));
+        }
+        constexpr uint64 Combine(uint64 Hash, std::string_view Text)
+        {
+            return Combine(Hash, HashBytes(Text.data(), Text.size()));
+        }
+
+        // the name of T as the compiler spells it, then without its scopes ("struct" included for MSVC)
+        template <typename T>
+        constexpr std::string_view GetTypeName()
+        {
+#if _MSC_VER
+            std::string_view Name  = __FUNCSIG__;
+            auto             Start = Name.find("GetTypeName<") + 12;
+            auto             End   = Name.rfind(">(void)");
+#else
+            std::string_view Name  = __PRETTY_FUNCTION__;
+            auto             Start = Name.find("T = ") + 4;
+            auto             End   = Name.find_first_of(";]", Start);
+#endif
+            return Name.substr(Start, End - Start);
+        }
+        template <typename T>
+        constexpr std::string_view GetShortTypeName()
+        {
+            auto Name = GetTypeName<T>();
+            auto Last = Name.find_last_of(": ");
+            return Last == std::string_view::npos ? Name : Name.substr(Last + 1);
+        }
+
+        template <typename T>
+        constexpr bool AlwaysFalse = false;
+
+        // A field of a serialized struct C, made by GAME_SERIAL_FIELD
+        template <typename C, typename T>
+        struct Field
+        {
+            using Type = T;
+
+            T C::*Member;
+            uint64 Offset;
+        };
+
+        template <typename C, typename T>
+        constexpr Field<C, T> MakeField(T C::*Member, uint64 Offset)
+        {
+            return { Member, Offset };
+        }
+
+        template <typename T, size_t I>
+        using FieldType = typename std::tuple_element_t<I, decltype(T::GetSerialFields())>::Type;
+
+        template <typename T>
+        struct IsStdArray : std::false_type
+        {};
+        template <typename T, size_t N>
+        struct IsStdArray<std::array<T, N>> : std::true_type
+        {};
+        template <typename T>
+        struct IsSerialArray : std::false_type
+        {};
+        template <typename T>
+        struct IsSerialArray<SerialArray<T>> : std::true_type
+        {};
+        template <typename T>
+        struct IsSerialEnum : std::false_type
+        {};
+        template <typename E>
+        struct IsSerialEnum<SerialEnum<E>> : std::true_type
+        {};
+
+        template <typename T, typename = void>
+        struct HasSerialFields : std::false_type
+        {};
+        template <typename T>
+        struct HasSerialFields<T, std::void_t<decltype(T::GetSerialFields())>> : std::true_type
+        {};
+        template <typename T, typename = void>
+        struct SerialVersionOf : std::integral_constant<uint32, 0>
+        {};
+        template <typename T>
+        struct SerialVersionOf<T, std::void_t<decltype(T::SerialVersion)>>
+            : std::integral_constant<uint32, T::SerialVersion>
+        {};
+
+        // wit::Quantity: its three orders and a float
+        template <typename T, typename = void>
+        struct IsQuantity : std::false_type
+        {};
+        template <typename T>
+        struct IsQuantity<T, std::void_t<decltype(T::getLengthOrder()), decltype(T::getTimeOrder()),
+                                         decltype(T::getMassOrder()), decltype(std::declval<T>().value_)>>
+            : std::true_type
+        {};
+        // wit::strong_type: its value_type and its derived_type
+        template <typename T, typename = void>
+        struct IsStrongType : std::false_type
+        {};
+        template <typename T>
+        struct IsStrongType<T, std::void_t<typename T::value_type, typename T::derived_type>> : std::true_type
+        {};
+        // wit::nonintegral_enum: its values_type
+        template <typename T, typename = void>
+        struct IsNonintegralEnum : std::false_type
+        {};
+        template <typename T>
+        struct IsNonintegralEnum<T, std::void_t<typename T::values_type>> : std::true_type
+        {};
+
+        template <typename T>
+        constexpr uint64 GetSchemaHash();
+
+        // true when the fields follow each other from offset 0, each at the alignment of its type, and end with the
+        // padding of T: nothing else fits in T
+        template <typename T, size_t... I>
+        constexpr bool AreFieldsPacked(std::index_sequence<I...>)
+        {
+            constexpr auto Fields   = T::GetSerialFields();
+            uint64         End      = 0;
+            bool           IsPacked = true;
+            ((IsPacked = IsPacked && std::get<I>(Fields).Offset ==
+                                         ((End + alignof(FieldType<T, I>) - 1) & ~uint64(alignof(FieldType<T, I>) - 1)),
+              End      = std::get<I>(Fields).Offset + sizeof(FieldType<T, I>)),
+             ...);
+            return IsPacked && ((End + alignof(T) - 1) & ~uint64(alignof(T) - 1)) == sizeof(T);
+        }
+
+        template <typename T>
+        constexpr bool AreFieldsComplete()
+        {
+            return AreFieldsPacked<T>(std::make_index_sequence<std::tuple_size_v<decltype(T::GetSerialFields())>>{});
+        }
+
+        template <typename T, size_t... I>
+        constexpr uint64 GetFieldsHash(std::index_sequence<I...>)
+        {
+            static_assert(AreFieldsComplete<T>(), "list every member of the struct, in order, with GAME_SERIAL_FIELD");
+            constexpr auto Fields = T::GetSerialFields();
+            auto           Hash   = Combine(Combine(Combine(0, "struct"), sizeof(T)), alignof(T));
+            Hash                  = Combine(Hash, SerialVersionOf<T>::value);
+            ((Hash = Combine(Combine(Hash, std::get<I>(Fields).Offset), GetSchemaHash<FieldType<T, I>>())), ...);
+            return Hash;
+        }
+
+        template <typename E, size_t... I>
+        constexpr uint64 GetEnumHash(std::index_sequence<I...>)
+        {
+            auto Hash = Combine(0, "nonintegral_enum");
+            ((Hash = Combine(Hash, GetShortTypeName<std::tuple_element_t<I, typename E::values_type>>())), ...);
+            return Hash;
+        }
+
+        template <typename T>
+        constexpr uint64 GetSchemaHash()
+        {
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                return Combine(0, "bool");
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                return Combine(Combine(0, std::is_signed_v<T> ? "int" : "uint"), sizeof(T));
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                return Combine(Combine(0, "float"), sizeof(T));
+            }
+            else if constexpr (std::is_enum_v<T>)
+            {
+                return Combine(Combine(0, "enum"), GetSchemaHash<std::underlying_type_t<T>>());
+            }
+            else if constexpr (std::is_array_v<T>)
+            {
+                auto Hash = Combine(Combine(0, "array"), std::extent_v<T>);
+                return Combine(Hash, GetSchemaHash<std::remove_extent_t<T>>());
+            }
+            else if constexpr (IsStdArray<T>::value)
+            {
+                auto Hash = Combine(Combine(0, "array"), std::tuple_size_v<T>);
+                return Combine(Hash, GetSchemaHash<typename T::value_type>());
+            }
+            else if constexpr (IsSerialArray<T>::value)
+            {
+                return Combine(Combine(0, "vector"), GetSchemaHash<typename T::ValueType>());
+            }
+            else if constexpr (std::is_same_v<T, SerialString>)
+            {
+                return Combine(0, "string");
+            }
+            else if constexpr (IsSerialEnum<T>::value)
+            {
+                return GetEnumHash<typename T::EnumType>(typename T::Indices{});
+            }
+            else if constexpr (HasSerialFields<T>::value)
+            {
+                return GetFieldsHash<T>(std::make_index_sequence<std::tuple_size_v<decltype(T::GetSerialFields())>>{});
+            }
+            else if constexpr (IsQuantity<T>::value)
+            {
+                static_assert(sizeof(T) == sizeof(float), "a Quantity is a float");
+                auto Hash = Combine(Combine(0, "quantity"), uint64(int64(T::getLengthOrder())));
+                return Combine(Combine(Hash, uint64(int64(T::getTimeOrder()))), uint64(int64(T::getMassOrder())));
+            }
+            else if constexpr (IsStrongType<T>::value)
+            {
+                static_assert(sizeof(T) == sizeof(typename T::value_type), "a strong_type is its value");
+                auto Hash = Combine(Combine(0, "strong_type"), GetShortTypeName<typename T::derived_type>());
+                return Combine(Hash, GetSchemaHash<typename T::value_type>());
+            }
+            else if constexpr (IsNonintegralEnum<T>::value)
+            {
+                static_assert(AlwaysFalse<T>, "a nonintegral_enum is a type_info pointer: store a SerialEnum");
+                return 0;
+            }
+            else
+            {
+                static_assert(AlwaysFalse<T>, "declare GetSerialFields, or store a SerialArray or a SerialString");
+                return 0;
+            }
+        }
+
+        // true when T holds references to check
+        template <typename T>
+        constexpr bool HasReferences();
+
+        template <typename T, size_t... I>
+        constexpr bool HaveReferences(std::index_sequence<I...>)
+        {
+            return (HasReferences<FieldType<T, I>>() || ...);
+        }
+
+        template <typename T>
+        constexpr bool HasReferences()
+        {
+            if constexpr (IsSerialArray<T>::value || IsSerialEnum<T>::value || std::is_same_v<T, SerialString>)
+            {
+                return true;
+            }
+            else if constexpr (std::is_array_v<T>)
+            {
+                return HasReferences<std::remove_extent_t<T>>();
+            }
+            else if constexpr (IsStdArray<T>::value)
+            {
+                return HasReferences<typename T::value_type>();
+            }
+            else if constexpr (HasSerialFields<T>::value)
+            {
+                return HaveReferences<T>(std::make_index_sequence<std::tuple_size_v<decltype(T::GetSerialFields())>>{});
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        inline bool IsInside(const void* Data, uint64 Size, uint64 Alignment, const uint8* Begin, const uint8* End)
+        {
+            auto Bytes = static_cast<const uint8*>(Data);
+            return Bytes >= Begin && Bytes <= End && uint64(End - Bytes) >= Size &&
+                   reinterpret_cast<uintptr_t>(Bytes) % Alignment == 0;
+        }
+
+        // the references of Value stay in [Begin, End), recursively
+        template <typename T>
+        bool Verify(const T& Value, const uint8* Begin, const uint8* End)
+        {
+            if constexpr (!HasReferences<T>())
+            {
+                return true;
+            }
+            else if constexpr (IsSerialArray<T>::value)
+            {
+                using U = typename T::ValueType;
+                if (!Value.Count)
+                {
+                    return true;
+                }
+                auto Data = reinterpret_cast<const uint8*>(&Value) + Value.Offset;
+                if (!IsInside(Data, uint64(Value.Count) * sizeof(U), alignof(U), Begin, End))
+                {
+                    return false;
+                }
+                for (auto& Element : Value)
+                {
+                    if (!Verify(Element, Begin, End))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            else if constexpr (std::is_same_v<T, SerialString>)
+            {
+                auto Data = reinterpret_cast<const uint8*>(&Value) + Value.Offset;
+                return !Value.Length ||
+                       (IsInside(Data, uint64(Value.Length) + 1, 1, Begin, End) && Data[Value.Length] == 0);
+            }
+            else if constexpr (IsSerialEnum<T>::value)
+            {
+                return Value.Index <= T::ValueCount;
+            }
+            else if constexpr (std::is_array_v<T> || IsStdArray<T>::value)
+            {
+                for (auto& Element : Value)
+                {
+                    if (!Verify(Element, Begin, End))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            else
+            {
+                return std::apply([&](auto... Fields) { return (Verify(Value.*Fields.Member, Begin, End) && ...); },
+                                  T::GetSerialFields());
+            }
+        }
+    } // namespace Serialization
+
+    using Serialization::GetSchemaHash;
+
+    // Builds a block in a buffer of fixed capacity pushed on an arena: the pointers it returns stay valid, the root and
+    // the arrays are filled in place. Every push is zero filled; a push which does not fit fails the block.
+    class SerialWriter final
+    {
+    public:
+        SerialWriter(MemoryArena& Arena, uint64 Capacity)
+            : Data{ Arena.PushArray<uint8>(Capacity, 64) }
+            , Capacity{ Data ? Capacity : 0 }
+        {}
+        SerialWriter(const SerialWriter&) = delete; // non copyable
+
+        // The root, right after the header; first push of the block
+        template <typename T>
+        T* PushRoot()
+        {
+            if (Size != 0 || !Push(sizeof(Serialization::Header), 16))
+            {
+                IsOverflowed = true;
+                return nullptr;
+            }
+            auto Root  = static_cast<T*>(Push(sizeof(T), alignof(T)));
+            RootOffset = Root ? uint32(reinterpret_cast<uint8*>(Root) - Data) : 0;
+            return Root;
+        }
+
+        // Count zeroed values for Field (in the block) to fill in place, nullptr when full
+        template <typename T>
+        T* PushArray(SerialArray<T>& Field, uint32 Count)
+        {
+            auto Values = static_cast<T*>(Push(uint64(Count) * sizeof(T), alignof(T)));
+            Field.Offset = Values ? int32(reinterpret_cast<uint8*>(Values) - reinterpret_cast<uint8*>(&Field)) : 0;
+            Field.Count  = Values ? Count : 0;
+            return Values;
+        }
+
+        template <typename T>
+        bool PushArray(SerialArray<T>& Field, const T* Values, uint32 Count)
+        {
+            auto Copy = PushArray(Field, Count);
+            for (uint32 Index = 0; Copy && Index < Count; ++Index)
+            {
+                Copy[Index] = Values[Index];
+            }
+            return Copy || !Count;
+        }
+
+        bool PushString(SerialString& Field, std::string_view Text)
+        {
+            auto Characters = static_cast<char*>(Push(Text.size() + 1, 1));
+            if (Characters)
+            {
+                memcpy(Characters, Text.data(), Text.size());
+            }
+            Field.Offset = Characters ? int32(Characters - reinterpret_cast<char*>(&Field)) : 0;
+            Field.Length = Characters ? uint32(Text.size()) : 0;
+            return Characters != nullptr;
+        }
+
+        // Writes the header for the root T, the size of the block or 0 when a push failed
+        template <typename T>
+        uint64 Finish()
+        {
+            if (IsOverflowed || !RootOffset)
+            {
+                return 0;
+            }
+            Serialization::Header Header = { Serialization::Magic, Serialization::Version, GetSchemaHash<T>(),
+                                             Size, RootOffset, uint32(sizeof(T)) };
+            memcpy(Data, &Header, sizeof(Header));
+            return Size;
+        }
+
+        const uint8* GetData() const { return Data; }
+        uint64       GetSize() const { return Size; }
+        bool         HasOverflowed() const { return IsOverflowed; }
+
+        // another block in the same buffer
+        void Reset()
+        {
+            Size         = 0;
+            RootOffset   = 0;
+            IsOverflowed = false;
+        }
+
+    private:
+        void* Push(uint64 PushSize, uint64 Alignment)
+        {
+            auto Start = (Size + Alignment - 1) & ~(Alignment - 1);
+            if (IsOverflowed || Start + PushSize > Capacity || Start + PushSize > 0x7FFFFFFF)
+            {
+                IsOverflowed = true;
+                return nullptr;
+            }
+            memset(Data + Size, 0, Start + PushSize - Size);
+            Size = Start + PushSize;
+            return Data + Start;
+        }
+
+        uint8* Data;
+        uint64 Capacity;
+        uint64 Size         = 0;
+        uint32 RootOffset   = 0;
+        bool   IsOverflowed = false;
+    };
+
+    // The root of a block, used in place: nullptr when the block is not a T of this schema, or when one of its
+    // references leaves it. Data is aligned like T (a mapped file or an arena is) and outlives the root.
+    template <typename T>
+    const T* ReadSerial(const void* Data, uint64 Size)
+    {
+        auto                  Begin = static_cast<const uint8*>(Data);
+        Serialization::Header Header;
+        if (Size < sizeof(Header))
+        {
+            return nullptr;
+        }
+        memcpy(&Header, Begin, sizeof(Header));
+        if (Header.Magic != Serialization::Magic || Header.Version != Serialization::Version ||
+            Header.SchemaHash != GetSchemaHash<T>() || Header.Size != Size || Header.RootSize != sizeof(T) ||
+            !Serialization::IsInside(Begin + Header.RootOffset, sizeof(T), alignof(T), Begin, Begin + Size))
+        {
+            return nullptr;
+        }
+        auto Root = reinterpret_cast<const T*>(Begin + Header.RootOffset);
+        return Serialization::Verify(*Root, Begin, Begin + Size) ? Root : nullptr;
+    }
+
+} // namespace Game
+
+// A field of GetSerialFields: the member of _TYPE_ and its offset
+#define GAME_SERIAL_FIELD(_TYPE_, _MEMBER_)                                                                            \
+    Game::Serialization::MakeField(&_TYPE_::_MEMBER_, offsetof(_TYPE_, _MEMBER_))
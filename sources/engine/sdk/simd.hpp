@@ -0,0 +1,141 @@
+#pragma once
+
+#include "types.hpp"
+
+#if _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// Runtime dispatch support: the modules are built for the baseline (SSE2, or AVX with the project flags) and carry
+// wider kernels marked with GAME_TARGET_*, only called when GetCpuFeatures() says the CPU and the OS support them.
+// MSVC accepts any intrinsic without a target attribute.
+
+#if _MSC_VER
+#define GAME_TARGET_SSSE3
+#define GAME_TARGET_SSE41
+#define GAME_TARGET_AVX2
+#define GAME_TARGET_AVX512
+#else
+#define GAME_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define GAME_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define GAME_TARGET_AVX2 __attribute__((target("avx2,fma,bmi,bmi2")))
+#define GAME_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma,bmi,bmi2")))
+#endif
+
+namespace Game
+{
+    struct CpuFeatures
+    {
+        bool Ssse3  = false;
+        bool Sse41  = false;
+        bool Avx    = false;
+        bool Avx2   = false; // with FMA and BMI2
+        bool Avx512 = false; // F, BW, DQ and VL
+    };
+
+    namespace Detail
+    {
+        inline void CpuId(uint32 Leaf, uint32 SubLeaf, uint32 Registers[4])
+        {
+#if _MSC_VER
+            int Values[4];
+            __cpuidex(Values, static_cast<int>(Leaf), static_cast<int>(SubLeaf));
+            for (int Index = 0; Index < 4; ++Index)
+            {
+                Registers[Index] = static_cast<uint32>(Values[Index]);
+            }
+#else
+            __cpuid_count(Leaf, SubLeaf, Registers[0], Registers[1], Registers[2], Registers[3]);
+#endif
+        }
+
+        // XCR0: register states the OS saves on context switches
+        inline uint64 ReadExtendedControlRegister()
+        {
+#if _MSC_VER
+            return _xgetbv(0);
+#else
+            uint32 Low, High;
+            __asm__("xgetbv" : "=a"(Low), "=d"(High) : "c"(0));
+            return (uint64(High) << 32) | Low;
+#endif
+        }
+
+        inline CpuFeatures DetectCpuFeatures()
+        {
+            CpuFeatures Features;
+            uint32      Registers[4];
+            CpuId(0, 0, Registers);
+            auto MaxLeaf = Registers[0];
+
+            CpuId(1, 0, Registers);
+            auto Ecx1      = Registers[2];
+            Features.Ssse3 = (Ecx1 >> 9) & 1;
+            Features.Sse41 = (Ecx1 >> 19) & 1;
+
+            auto IsOsSavingYmm = false;
+            auto IsOsSavingZmm = false;
+            if ((Ecx1 >> 27) & 1) // OSXSAVE
+            {
+                auto Xcr0     = ReadExtendedControlRegister();
+                IsOsSavingYmm = (Xcr0 & 0x06) == 0x06;
+                IsOsSavingZmm = (Xcr0 & 0xE6) == 0xE6;
+            }
+            Features.Avx = IsOsSavingYmm && ((Ecx1 >> 28) & 1);
+
+            if (MaxLeaf >= 7)
+            {
+                CpuId(7, 0, Registers);
+                auto Ebx7       = Registers[1];
+                auto HasFma     = (Ecx1 >> 12) & 1;
+                auto HasBmi     = ((Ebx7 >> 3) & 1) && ((Ebx7 >> 8) & 1);
+                Features.Avx2   = Features.Avx && ((Ebx7 >> 5) & 1) && HasFma && HasBmi;
+                Features.Avx512 = Features.Avx2 && IsOsSavingZmm && ((Ebx7 >> 16) & 1) && ((Ebx7 >> 17) & 1) &&
+                                  ((Ebx7 >> 30) & 1) && ((Ebx7 >> 31) & 1);
+            }
+            return Features;
+        }
+    } // namespace Detail
+
+    // Detected once per module (the game DLL has its own copy, which is fine)
+    inline const CpuFeatures& GetCpuFeatures()
+    {
+        static const CpuFeatures Features = Detail::DetectCpuFeatures();
+        return Features;
+    }
+
+    // Kernel sets of the SIMD modules, from the most portable
+    enum class SimdLevel : uint32
+    {
+        Scalar = 0,
+        Sse2   = 1,
+        Avx2   = 2,
+        Avx512 = 3,
+    };
+
+    inline SimdLevel GetBestSimdLevel()
+    {
+        auto& Features = GetCpuFeatures();
+        return Features.Avx512 ? SimdLevel::Avx512 : Features.Avx2 ? SimdLevel::Avx2 : SimdLevel::Sse2;
+    }
+
+    inline const char* GetSimdLevelName(SimdLevel Level)
+    {
+        switch (Level)
+        {
+        case SimdLevel::Scalar:
+            return "scalar";
+        case SimdLevel::Sse2:
+            return "sse2";
+        case SimdLevel::Avx2:
+            return "avx2";
+        case SimdLevel::Avx512:
+            return "avx512";
+        }
+        return "?";
+    }
+
+} // namespace Game
@@ -0,0 +1,426 @@
+#pragma once
+
+#include "hash.hpp"
+#include "lz.hpp"
+#include "memory_arena.hpp"
+#include "types.hpp"
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+// Incremental save states of a memory block (Game::Memory::PermanentStorage): a capture copies the 4KB pages written
+// since the previous one, then a background thread compresses them with Lz and hands them to a sink, usually a file.
+// The stream is a base (the pages written since startup) followed by deltas; a restore, from a mapped file for
+// instance, clears the block and applies the records in order.
+//
+// A record is a header then runs of up to RunPageCount consecutive dirty pages, each compressed as one Lz block:
+//     RecordHeader, { RunHeader, Lz block (or the raw pages when they do not compress) } * RunCount
+// The pages written are found by a PageTracker: the OS one of the platform (write watch on Windows, write faults on
+// Linux) costs nothing between captures, HashPageTracker is the portable fallback which reads the whole block.
+
+namespace Game
+{
+    // Pages of a block written since the previous call
+    class PageTracker
+    {
+    public:
+        static constexpr uint64 PageSize = 4096;
+
+        PageTracker()                   = default;
+        PageTracker(const PageTracker&) = delete; // non copyable
+        virtual ~PageTracker() {}
+
+        // Sets the bit of every page written since the previous call (since the tracker was made at the first call)
+        // and clears the others, (GetPageCount() + 63) / 64 words
+        virtual void CollectDirtyPages(uint64* Bits) = 0;
+
+        virtual uint64 GetPageCount() const = 0;
+    };
+
+    namespace Snapshot
+    {
+        constexpr uint32 Magic        = 0x50414E53; // "SNAP"
+        constexpr uint32 RunPageCount = 16;         // 64KB, within the reach of an Lz match
+        constexpr uint64 MaxRunSize   = RunPageCount * PageTracker::PageSize;
+
+        struct RecordHeader
+        {
+            uint32 Magic;
+            uint32 Sequence; // 0 for the base
+            uint64 StorageSize;
+            uint32 RunCount;
+            uint32 PageCount;
+        };
+
+        struct RunHeader
+        {
+            uint32 FirstPage;
+            uint32 PageCount;
+            uint32 StoredSize; // PageCount * PageSize: stored raw
+            uint32 Reserved;
+        };
+
+        inline uint64 Read64(const uint8* Pointer)
+        {
+            uint64 Value;
+            memcpy(&Value, Pointer, sizeof(Value));
+            return Value;
+        }
+
+        // 4 independent multiply chains, the page is read at memory speed
+        inline uint64 HashPage(const uint8* Page)
+        {
+            uint64 Lanes[4] = { 1, 2, 3, 4 };
+            for (uint64 Offset = 0; Offset < PageTracker::PageSize; Offset += 32)
+            {
+                for (uint32 Lane = 0; Lane < 4; ++Lane)
+                {
+                    Lanes[Lane] = (Lanes[Lane] ^ Read64(Page + Offset + 8 * Lane)) * 0x9E3779B97F4A7C15ULL;
+                }
+            }
+            return MixHash(Lanes[0] ^ MixHash(Lanes[1] ^ MixHash(Lanes[2] ^ MixHash(Lanes[3]))));
+        }
+
+        inline uint64 GetPageCount(uint64 StorageSize)
+        {
+            return (StorageSize + PageTracker::PageSize - 1) / PageTracker::PageSize;
+        }
+
+        // Applies at most MaxRecordCount records of Data (a base, then deltas) to Storage. Returns the number applied,
+        // 0 if Data does not start with a base of StorageSize bytes. A truncated or corrupted record ends the restore:
+        // its structure is checked before it is applied, an Lz block which does not decode leaves its pages cleared.
+        inline uint32 Restore(const void* Data,
+                              uint64      Size,
+                              void*       Storage,
+                              uint64      StorageSize,
+                              uint32      MaxRecordCount = 0xFFFFFFFF)
+        {
+            auto   In        = static_cast<const uint8*>(Data);
+            auto   End       = In + Size;
+            auto   Pages     = static_cast<uint8*>(Storage);
+            auto   PageCount = GetPageCount(StorageSize);
+            uint32 Applied   = 0;
+            while (Applied < MaxRecordCount && uint64(End - In) >= sizeof(RecordHeader))
+            {
+                RecordHeader Header;
+                memcpy(&Header, In, sizeof(Header));
+                if (Header.Magic != Magic || Header.StorageSize != StorageSize || Header.Sequence != Applied)
+                {
+                    break;
+                }
+
+                // the runs, within the record and the block
+                auto Runs         = In + sizeof(Header);
+                auto IsWellFormed = true;
+                for (uint32 Run = 0; IsWellFormed && Run < Header.RunCount; ++Run)
+                {
+                    RunHeader Entry;
+                    IsWellFormed = uint64(End - Runs) >= sizeof(Entry);
+                    if (IsWellFormed)
+                    {
+                        memcpy(&Entry, Runs, sizeof(Entry));
+                        IsWellFormed = Entry.PageCount && Entry.PageCount <= RunPageCount &&
+                                       Entry.FirstPage < PageCount && Entry.PageCount <= PageCount - Entry.FirstPage &&
+                                       Entry.StoredSize <= uint64(End - Runs) - sizeof(Entry);
+                        Runs += sizeof(Entry) + (IsWellFormed ? Entry.StoredSize : 0);
+                    }
+                }
+                if (!IsWellFormed)
+                {
+                    break;
+                }
+
+                if (Header.Sequence == 0)
+                {
+                    memset(Storage, 0, StorageSize);
+                }
+                Runs = In + sizeof(Header);
+                for (uint32 Run = 0; Run < Header.RunCount; ++Run)
+                {
+                    RunHeader Entry;
+                    memcpy(&Entry, Runs, sizeof(Entry));
+                    Runs += sizeof(Entry);
+
+                    auto Destination = Pages + uint64(Entry.FirstPage) * PageTracker::PageSize;
+                    auto RunEnd      = uint64(Entry.FirstPage + Entry.PageCount) * PageTracker::PageSize;
+                    auto RunSize     = (RunEnd < StorageSize ? RunEnd : StorageSize) -
+                                   uint64(Entry.FirstPage) * PageTracker::PageSize;
+                    if (Entry.StoredSize == Entry.PageCount * PageTracker::PageSize)
+                    {
+                        memcpy(Destination, Runs, RunSize);
+                    }
+                    else if (!Lz::Decompress(Runs, Entry.StoredSize, Destination, RunSize))
+                    {
+                        memset(Destination, 0, RunSize);
+                        return Applied;
+                    }
+                    Runs += Entry.StoredSize;
+                }
+                In = Runs;
+                ++Applied;
+            }
+            return Applied;
+        }
+    } // namespace Snapshot
+
+    // Portable fallback: compares a hash of every page with the one of the previous call. Made while the block is
+    // still zero, like Game::Memory at startup, its first call reports the pages which are not.
+    class HashPageTracker final : public PageTracker
+    {
+    public:
+        HashPageTracker(MemoryArena& Arena, const void* Base, uint64 Size)
+            : Base{ static_cast<const uint8*>(Base) }
+            , Size{ Size }
+            , Hashes{ Arena.PushArray<uint64>(Snapshot::GetPageCount(Size), 64) }
+        {
+            alignas(64) static const uint8 Zero[PageSize] = {};
+            auto ZeroHash                                 = Snapshot::HashPage(Zero);
+            for (uint64 Page = 0; Hashes && Page < GetPageCount(); ++Page)
+            {
+                Hashes[Page] = ZeroHash;
+            }
+        }
+
+        bool IsValid() const { return Hashes != nullptr; }
+
+        void CollectDirtyPages(uint64* Bits) override
+        {
+            auto PageCount = GetPageCount();
+            for (uint64 Word = 0; Word < (PageCount + 63) / 64; ++Word)
+            {
+                uint64 Dirty = 0;
+                for (uint64 Page = Word * 64; Page < PageCount && Page < Word * 64 + 64; ++Page)
+                {
+                    auto Hash = Snapshot::HashPage(GetPage(Page));
+                    Dirty |= uint64(Hash != Hashes[Page]) << (Page % 64);
+                    Hashes[Page] = Hash;
+                }
+                Bits[Word] = Dirty;
+            }
+        }
+
+        uint64 GetPageCount() const override { return Snapshot::GetPageCount(Size); }
+
+    private:
+        // the last page is hashed through a copy when the block does not end on a page
+        const uint8* GetPage(uint64 Page)
+        {
+            auto Offset = Page * PageSize;
+            if (Offset + PageSize <= Size)
+            {
+                return Base + Offset;
+            }
+            memset(Tail, 0, PageSize);
+            memcpy(Tail, Base + Offset, Size - Offset);
+            return Tail;
+        }
+
+        const uint8* Base;
+        uint64       Size;
+        uint64*      Hashes;
+        alignas(64) uint8 Tail[PageSize];
+    };
+
+    // Function pointers, called from the background thread: set them again after the game code is reloaded
+    struct SnapshotSink
+    {
+        using WriteFunction = bool (*)(void* Context, const void* Data, uint64 Size);
+
+        void*         Context = nullptr;
+        WriteFunction Write   = nullptr; // false on failure: HasFailed() becomes true
+    };
+
+    class SnapshotWriter final
+    {
+    public:
+        // Pushes a copy of the block and the dirty bitset on Arena, IsValid is false if it is too small. Neither may be
+        // in the tracked block.
+        SnapshotWriter(MemoryArena&        Arena,
+                       const void*         Storage,
+                       uint64              StorageSize,
+                       PageTracker&        Tracker,
+                       const SnapshotSink& Sink)
+            : Storage{ static_cast<const uint8*>(Storage) }
+            , StorageSize{ StorageSize }
+            , Tracker{ Tracker }
+            , Sink{ Sink }
+            , Staging{ Arena.PushArray<uint8>(Snapshot::GetPageCount(StorageSize) * PageTracker::PageSize, 64) }
+            , Dirty{ Arena.PushArray<uint64>((Snapshot::GetPageCount(StorageSize) + 63) / 64, 64) }
+            , Compressed{ Arena.PushArray<uint8>(Lz::CompressBound(Snapshot::MaxRunSize), 64) }
+        {
+            if (Staging && Dirty && Compressed && Tracker.GetPageCount() == Snapshot::GetPageCount(StorageSize))
+            {
+                Worker = std::thread{ [this] { Work(); } };
+            }
+        }
+        SnapshotWriter(const SnapshotWriter&) = delete; // non copyable
+
+        ~SnapshotWriter()
+        {
+            if (Worker.joinable())
+            {
+                Wait();
+                {
+                    std::lock_guard<std::mutex> Lock{ Mutex };
+                    IsStopping = true;
+                }
+                HasWork.notify_all();
+                Worker.join();
+            }
+        }
+
+        bool IsValid() const { return Worker.joinable(); }
+
+        // Copies the pages written since the previous capture (the base at the first), the compression and the write
+        // are left to the background thread. Waits for the previous capture first. Returns the number of pages.
+        uint32 Capture()
+        {
+            if (!IsValid())
+            {
+                return 0;
+            }
+            Wait();
+            Tracker.CollectDirtyPages(Dirty);
+            uint32 PageCount = 0;
+            for (uint64 Word = 0; Word < (Tracker.GetPageCount() + 63) / 64; ++Word)
+            {
+                for (auto Bits = Dirty[Word]; Bits; Bits &= Bits - 1)
+                {
+                    auto Page   = Word * 64 + CountTrailingZeros(Bits);
+                    auto Offset = Page * PageTracker::PageSize;
+                    auto Size   = Offset + PageTracker::PageSize <= StorageSize ? PageTracker::PageSize
+                                                                                : StorageSize - Offset;
+                    memcpy(Staging + Offset, Storage + Offset, Size);
+                    memset(Staging + Offset + Size, 0, PageTracker::PageSize - Size);
+                    ++PageCount;
+                }
+            }
+            {
+                std::lock_guard<std::mutex> Lock{ Mutex };
+                IsPending = true;
+            }
+            HasWork.notify_all();
+            return PageCount;
+        }
+
+        // Until the last capture is written
+        void Wait()
+        {
+            std::unique_lock<std::mutex> Lock{ Mutex };
+            IsDone.wait(Lock, [this] { return !IsPending; });
+        }
+
+        uint32 GetCaptureCount() const { return Sequence; }          // written, after Wait
+        uint64 GetWrittenSize() const { return WrittenSize; }        // sent to the sink, after Wait
+        bool   HasFailed() const { return IsFailed; }                // a write of the sink failed, after Wait
+
+    private:
+        static uint32 CountTrailingZeros(uint64 Bits)
+        {
+#if _MSC_VER
+            unsigned long Index;
+            _BitScanForward64(&Index, Bits);
+            return Index;
+#else
+            return static_cast<uint32>(__builtin_ctzll(Bits));
+#endif
+        }
+
+        bool IsDirty(uint64 Page) const { return Dirty[Page / 64] >> (Page % 64) & 1; }
+
+        bool Write(const void* Data, uint64 Size)
+        {
+            WrittenSize += Size;
+            return Sink.Write && Sink.Write(Sink.Context, Data, Size);
+        }
+
+        // the record of the staged pages
+        void WriteRecord()
+        {
+            auto PageCount = Tracker.GetPageCount();
+
+            Snapshot::RecordHeader Header = { Snapshot::Magic, Sequence, StorageSize, 0, 0 };
+            for (uint64 Page = 0; Page < PageCount;)
+            {
+                auto Count = RunLength(Page);
+                Header.RunCount += Count != 0;
+                Header.PageCount += Count;
+                Page += Count ? Count : 1;
+            }
+            auto Succeeded = Write(&Header, sizeof(Header));
+            for (uint64 Page = 0; Page < PageCount;)
+            {
+                if (!IsDirty(Page))
+                {
+                    ++Page;
+                    continue;
+                }
+                auto Count      = RunLength(Page);
+                auto Source     = Staging + Page * PageTracker::PageSize;
+                auto RunSize    = Count * PageTracker::PageSize; // the last page is padded with zeros
+                auto SourceSize = Page * PageTracker::PageSize + RunSize <= StorageSize
+                                      ? RunSize
+                                      : StorageSize - Page * PageTracker::PageSize;
+                auto Size       = Lz::Compress(Source, SourceSize, Compressed, Lz::CompressBound(Snapshot::MaxRunSize));
+                auto IsRaw      = Size == 0 || Size >= SourceSize;
+
+                Snapshot::RunHeader Run = { uint32(Page), Count, uint32(IsRaw ? RunSize : Size), 0 };
+                Succeeded &= Write(&Run, sizeof(Run));
+                Succeeded &= Write(IsRaw ? Source : Compressed, Run.StoredSize);
+                Page += Count;
+            }
+            IsFailed |= !Succeeded;
+            ++Sequence;
+        }
+
+        // dirty pages from Page, up to the end of its aligned group of RunPageCount
+        uint32 RunLength(uint64 Page) const
+        {
+            uint32 Count = 0;
+            while (Page + Count < Tracker.GetPageCount() && IsDirty(Page + Count) &&
+                   (Count == 0 || (Page + Count) % Snapshot::RunPageCount != 0))
+            {
+                ++Count;
+            }
+            return Count;
+        }
+
+        void Work()
+        {
+            std::unique_lock<std::mutex> Lock{ Mutex };
+            for (;;)
+            {
+                HasWork.wait(Lock, [this] { return IsPending || IsStopping; });
+                if (IsStopping)
+                {
+                    return;
+                }
+                Lock.unlock();
+                WriteRecord();
+                Lock.lock();
+                IsPending = false;
+                IsDone.notify_all();
+            }
+        }
+
+        const uint8*            Storage;
+        uint64                  StorageSize;
+        PageTracker&            Tracker;
+        SnapshotSink            Sink;
+        uint8*                  Staging;    // the dirty pages at their offset in the block
+        uint64*                 Dirty;      // of the staged capture
+        uint8*                  Compressed; // a run
+        uint32                  Sequence    = 0;
+        uint64                  WrittenSize = 0;
+        bool                    IsFailed    = false;
+        std::mutex              Mutex;
+        std::condition_variable HasWork;
+        std::condition_variable IsDone;
+        bool                    IsPending  = false;
+        bool                    IsStopping = false;
+        std::thread             Worker;
+    };
+
+} // namespace Game
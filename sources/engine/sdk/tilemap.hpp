@@ -0,0 +1,437 @@
+#pragma once
+
+#include "blit.hpp"
+#include "memory_arena.hpp"
+#include "render_commands.hpp"
+#include "types.hpp"
+
+#include <cstring>
+
+// Tile maps of any size, drawn in a time which only depends on the view.
+//
+// The map is cut in chunks of ChunkSize x ChunkSize tiles. Only a fixed number of chunks are resident: their tile ids
+// are stored one chunk after the other in a single array, the per chunk state in parallel arrays beside it. A chunk
+// which is not resident is loaded by the streamer when it is needed (or is empty without one), the least recently
+// used chunk gives its place and is stored first if it was modified.
+// Each visible chunk is drawn from a cached bitmap of its tiles, rebuilt only when one of its tiles changes or when
+// the chunk comes back into view after its cache was reused. A frame draws a handful of chunk bitmaps whatever the
+// size of the map: the only memory proportional to the map is the chunk directory, 4 bytes per chunk.
+// All the memory is pushed on the arena given at construction.
+
+namespace Game
+{
+    using TileId               = uint16;
+    constexpr TileId EmptyTile = 0;
+
+    enum class TileShape : uint32
+    {
+        Rectangle = 0, // squares included
+        Hexagon   = 1, // pointy top, odd rows shifted right by half a tile, rows are 3/4 of a tile apart
+    };
+
+    struct Tileset
+    {
+        Bitmap    Atlas; // tile N > 0 is the cell N - 1, row-major. Hexagons need Mask or Blend alpha.
+        int32     TileWidth  = 0;
+        int32     TileHeight = 0;
+        TileShape Shape      = TileShape::Rectangle;
+
+        int32 GetRowStep() const { return Shape == TileShape::Hexagon ? TileHeight * 3 / 4 : TileHeight; }
+        int32 GetTileCount() const { return (Atlas.Width / TileWidth) * (Atlas.Height / TileHeight); }
+
+        Bitmap GetTile(TileId Id) const
+        {
+            auto Columns = Atlas.Width / TileWidth;
+            auto Cell    = Id - 1;
+            auto Pixels  = Atlas.GetRow(Cell / Columns * TileHeight) + Cell % Columns * TileWidth;
+            return { Pixels, TileWidth, TileHeight, Atlas.Pitch, Atlas.Alpha };
+        }
+    };
+
+    // Function pointers into the game code: set them again after the game code is reloaded
+    struct TileMapStreamer
+    {
+        using LoadFunction  = void (*)(void* Context, int32 ChunkX, int32 ChunkY, TileId* Tiles);
+        using StoreFunction = void (*)(void* Context, int32 ChunkX, int32 ChunkY, const TileId* Tiles);
+
+        void*         Context = nullptr;
+        LoadFunction  Load    = nullptr; // fills the ChunkTileCount tiles, row-major; null: chunks start empty
+        StoreFunction Store   = nullptr; // null: modified chunks stay resident
+    };
+
+    class TileMap final
+    {
+    public:
+        static constexpr int32  ChunkSize      = 16;
+        static constexpr int32  ChunkTileCount = ChunkSize * ChunkSize;
+        static constexpr uint32 NoSlot         = 0xFFFFFFFF;
+
+        // Width x Height tiles, with ResidentCount chunks in memory of which CachedCount have a bitmap. Every array is
+        // pushed on Arena, IsValid is false if it is too small.
+        TileMap(MemoryArena&   Arena,
+                int32          Width,
+                int32          Height,
+                const Tileset& Tiles,
+                uint32         ResidentCount,
+                uint32         CachedCount)
+            : Set{ Tiles }
+            , Width{ Width }
+            , Height{ Height }
+            , ChunkCountX{ (Width + ChunkSize - 1) / ChunkSize }
+            , ChunkCountY{ (Height + ChunkSize - 1) / ChunkSize }
+            , StrideX{ ChunkSize * Tiles.TileWidth }
+            , StrideY{ ChunkSize * Tiles.GetRowStep() }
+            , CacheWidth{ StrideX + (Tiles.Shape == TileShape::Hexagon ? Tiles.TileWidth / 2 : 0) }
+            , CacheHeight{ (ChunkSize - 1) * Tiles.GetRowStep() + Tiles.TileHeight }
+        {
+            auto ChunkCount = uint64(ChunkCountX) * ChunkCountY;
+            ChunkSlots      = Arena.PushArray<uint32>(ChunkCount);
+            SlotTiles       = Arena.PushArray<TileId>(uint64(ResidentCount) * ChunkTileCount, 64);
+            SlotChunks      = Arena.PushArray<uint32>(ResidentCount);
+            SlotLastUsed    = Arena.PushArray<uint64>(ResidentCount);
+            SlotCaches      = Arena.PushArray<uint32>(ResidentCount);
+            SlotIsModified  = Arena.PushArray<bool>(ResidentCount);
+            CachePixels     = Arena.PushArray<uint32>(uint64(CachedCount) * CacheWidth * CacheHeight, 64);
+            CacheSlots      = Arena.PushArray<uint32>(CachedCount);
+            CacheLastUsed   = Arena.PushArray<uint64>(CachedCount);
+            CacheIsValid    = Arena.PushArray<bool>(CachedCount);
+            CacheAlpha      = Arena.PushArray<BitmapAlpha>(CachedCount);
+            if (!ChunkSlots || !SlotTiles || !SlotChunks || !SlotLastUsed || !SlotCaches || !SlotIsModified ||
+                !CachePixels || !CacheSlots || !CacheLastUsed || !CacheIsValid || !CacheAlpha)
+            {
+                return;
+            }
+            for (uint64 Chunk = 0; Chunk < ChunkCount; ++Chunk)
+            {
+                ChunkSlots[Chunk] = NoSlot;
+            }
+            for (uint32 Slot = 0; Slot < ResidentCount; ++Slot)
+            {
+                SlotChunks[Slot]     = NoSlot;
+                SlotLastUsed[Slot]   = 0;
+                SlotCaches[Slot]     = NoSlot;
+                SlotIsModified[Slot] = false;
+            }
+            for (uint32 Cache = 0; Cache < CachedCount; ++Cache)
+            {
+                CacheSlots[Cache]    = NoSlot;
+                CacheLastUsed[Cache] = 0;
+                CacheIsValid[Cache]  = false;
+            }
+            this->ResidentCount = ResidentCount;
+            this->CachedCount   = CachedCount;
+        }
+        TileMap(const TileMap&) = delete; // non copyable
+
+        bool  IsValid() const { return ResidentCount && CachedCount; }
+        int32 GetWidth() const { return Width; }
+        int32 GetHeight() const { return Height; }
+
+        void SetStreamer(const TileMapStreamer& Streamer) { this->Streamer = Streamer; }
+
+        // Loads the chunk if needed, evicting the least recently used one; out of the map or when no chunk can be
+        // evicted (all modified without a Store) returns EmptyTile
+        TileId GetTile(int32 X, int32 Y)
+        {
+            auto Slot = IsInside(X, Y) ? AcquireSlot(X / ChunkSize, Y / ChunkSize) : NoSlot;
+            return Slot != NoSlot ? SlotTiles[uint64(Slot) * ChunkTileCount + GetTileIndex(X, Y)] : EmptyTile;
+        }
+
+        // Loads the chunk if needed and invalidates its bitmap, returns false when it cannot be loaded
+        bool SetTile(int32 X, int32 Y, TileId Id)
+        {
+            auto Slot = IsInside(X, Y) ? AcquireSlot(X / ChunkSize, Y / ChunkSize) : NoSlot;
+            if (Slot == NoSlot)
+            {
+                return false;
+            }
+            auto& Tile = SlotTiles[uint64(Slot) * ChunkTileCount + GetTileIndex(X, Y)];
+            if (Tile != Id)
+            {
+                Tile                 = Id;
+                SlotIsModified[Slot] = true;
+                if (SlotCaches[Slot] != NoSlot)
+                {
+                    CacheIsValid[SlotCaches[Slot]] = false;
+                }
+            }
+            return true;
+        }
+
+        // The ChunkTileCount tiles of a chunk, row-major, loaded if needed; valid until the next call which loads a
+        // chunk. nullptr out of the map or when no chunk can be evicted. Faster than GetTile to read a whole chunk
+        const TileId* GetChunkTiles(int32 ChunkX, int32 ChunkY)
+        {
+            auto IsChunk = ChunkX >= 0 && ChunkY >= 0 && ChunkX < ChunkCountX && ChunkY < ChunkCountY;
+            auto Slot    = IsChunk && IsValid() ? AcquireSlot(ChunkX, ChunkY) : NoSlot;
+            return Slot != NoSlot ? SlotTiles + uint64(Slot) * ChunkTileCount : nullptr;
+        }
+
+        // Draws the view whose top left corner is the map pixel (CameraX, CameraY)
+        void Draw(const PIBackBuffer& Buffer, int32 CameraX, int32 CameraY, SimdLevel Level = GetBestSimdLevel())
+        {
+            auto DrawChunk = [&](const Bitmap& Chunk, int32 X, int32 Y) {
+                DrawBitmap(Buffer, Chunk, X, Y, GetBufferRect(Buffer), Level);
+            };
+            ForEachVisibleChunk(CameraX, CameraY, Buffer.Width, Buffer.Height, DrawChunk);
+        }
+
+        // Same as Draw through a command buffer: the map must not be touched before the commands are executed
+        void Push(RenderCommandBuffer& Commands,
+                  uint32               SortKey,
+                  int32                CameraX,
+                  int32                CameraY,
+                  int32                ViewWidth,
+                  int32                ViewHeight)
+        {
+            auto PushChunk = [&](const Bitmap& Chunk, int32 X, int32 Y) { Commands.PushBitmap(SortKey, Chunk, X, Y); };
+            ForEachVisibleChunk(CameraX, CameraY, ViewWidth, ViewHeight, PushChunk);
+        }
+
+        // since construction
+        uint64 GetLoadCount() const { return LoadCount; }
+        uint64 GetStoreCount() const { return StoreCount; }
+        uint64 GetCacheBuildCount() const { return CacheBuildCount; }
+        uint64 GetDroppedCount() const { return DroppedCount; } // visible chunks not drawn: every slot was in use
+
+    private:
+        static constexpr uint64 NoDraw = ~uint64(0);
+
+        bool IsInside(int32 X, int32 Y) const { return X >= 0 && Y >= 0 && X < Width && Y < Height; }
+
+        static uint32 GetTileIndex(int32 X, int32 Y) { return uint32((Y % ChunkSize) * ChunkSize + X % ChunkSize); }
+
+        static int64 FloorDivide(int64 Value, int64 Divisor)
+        {
+            return Value >= 0 ? Value / Divisor : -((-Value + Divisor - 1) / Divisor);
+        }
+
+        // least recently used entry which is not used by the draw in progress, free entries first
+        uint32 FindVictim(const uint32* Owners, const uint64* LastUsed, uint32 Count, bool CheckPinned) const
+        {
+            auto Victim = NoSlot;
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                if (Owners[Index] == NoSlot)
+                {
+                    return Index;
+                }
+                auto IsPinned = CheckPinned && SlotIsModified[Index] && !Streamer.Store;
+                if (!IsPinned && LastUsed[Index] < DrawStart &&
+                    (Victim == NoSlot || LastUsed[Index] < LastUsed[Victim]))
+                {
+                    Victim = Index;
+                }
+            }
+            return Victim;
+        }
+
+        uint32 AcquireSlot(int32 ChunkX, int32 ChunkY)
+        {
+            auto  Chunk = uint32(ChunkY * ChunkCountX + ChunkX);
+            auto& Slot  = ChunkSlots[Chunk];
+            if (Slot == NoSlot)
+            {
+                auto Victim = FindVictim(SlotChunks, SlotLastUsed, ResidentCount, true);
+                if (Victim == NoSlot)
+                {
+                    return NoSlot;
+                }
+                Evict(Victim);
+
+                auto Tiles = SlotTiles + uint64(Victim) * ChunkTileCount;
+                if (Streamer.Load)
+                {
+                    Streamer.Load(Streamer.Context, ChunkX, ChunkY, Tiles);
+                    ++LoadCount;
+                }
+                else
+                {
+                    memset(Tiles, 0, ChunkTileCount * sizeof(TileId));
+                }
+                SlotChunks[Victim] = Chunk;
+                Slot               = Victim;
+            }
+            SlotLastUsed[Slot] = ++UseCount;
+            return Slot;
+        }
+
+        void Evict(uint32 Slot)
+        {
+            auto Chunk = SlotChunks[Slot];
+            if (Chunk == NoSlot)
+            {
+                return;
+            }
+            if (SlotIsModified[Slot] && Streamer.Store)
+            {
+                auto ChunkX = int32(Chunk % ChunkCountX);
+                auto ChunkY = int32(Chunk / ChunkCountX);
+                Streamer.Store(Streamer.Context, ChunkX, ChunkY, SlotTiles + uint64(Slot) * ChunkTileCount);
+                ++StoreCount;
+            }
+            if (SlotCaches[Slot] != NoSlot)
+            {
+                CacheSlots[SlotCaches[Slot]] = NoSlot;
+                SlotCaches[Slot]             = NoSlot;
+            }
+            SlotIsModified[Slot] = false;
+            SlotChunks[Slot]     = NoSlot;
+            ChunkSlots[Chunk]    = NoSlot;
+        }
+
+        Bitmap GetCacheBitmap(uint32 Cache) const
+        {
+            auto Pixels = CachePixels + uint64(Cache) * CacheWidth * CacheHeight;
+            return { Pixels, CacheWidth, CacheHeight, CacheWidth * 4, CacheAlpha[Cache] };
+        }
+
+        // returns the cache of the resident chunk in Slot, rebuilt if needed, or NoSlot
+        uint32 AcquireCache(uint32 Slot)
+        {
+            auto Cache = SlotCaches[Slot];
+            if (Cache == NoSlot)
+            {
+                Cache = FindVictim(CacheSlots, CacheLastUsed, CachedCount, false);
+                if (Cache == NoSlot)
+                {
+                    return NoSlot;
+                }
+                if (CacheSlots[Cache] != NoSlot)
+                {
+                    SlotCaches[CacheSlots[Cache]] = NoSlot;
+                }
+                CacheSlots[Cache]   = Slot;
+                SlotCaches[Slot]    = Cache;
+                CacheIsValid[Cache] = false;
+            }
+            if (!CacheIsValid[Cache])
+            {
+                BuildCache(Cache, Slot);
+            }
+            CacheLastUsed[Cache] = ++UseCount;
+            return Cache;
+        }
+
+        void BuildCache(uint32 Cache, uint32 Slot)
+        {
+            auto Chunk  = SlotChunks[Slot];
+            auto ChunkX = int32(Chunk % ChunkCountX);
+            auto ChunkY = int32(Chunk / ChunkCountX);
+            auto Ids    = SlotTiles + uint64(Slot) * ChunkTileCount;
+            auto Count  = Set.GetTileCount();
+
+            // tiles out of the map (last row and column of chunks) are left empty
+            auto EndX    = Width - ChunkX * ChunkSize < ChunkSize ? Width - ChunkX * ChunkSize : ChunkSize;
+            auto EndY    = Height - ChunkY * ChunkSize < ChunkSize ? Height - ChunkY * ChunkSize : ChunkSize;
+            auto IsFull  = EndX == ChunkSize && EndY == ChunkSize;
+            for (int32 Index = 0; IsFull && Index < ChunkTileCount; ++Index)
+            {
+                IsFull = Ids[Index] != EmptyTile && Ids[Index] <= Count;
+            }
+            auto IsOpaque = IsFull && Set.Shape == TileShape::Rectangle &&
+                            Set.Atlas.Alpha == BitmapAlpha::Opaque;
+
+            auto         Pixels = const_cast<uint32*>(GetCacheBitmap(Cache).Pixels);
+            PIBackBuffer Target = { Pixels, CacheWidth, CacheHeight, 4, CacheWidth * 4 };
+            if (!IsOpaque)
+            {
+                memset(Pixels, 0, uint64(CacheWidth) * CacheHeight * 4);
+            }
+            auto RowStep = Set.GetRowStep();
+            auto IsHex   = Set.Shape == TileShape::Hexagon;
+            for (int32 Y = 0; Y < EndY; ++Y)
+            {
+                auto ShiftX = IsHex && (Y & 1) ? Set.TileWidth / 2 : 0; // ChunkSize is even
+                for (int32 X = 0; X < EndX; ++X)
+                {
+                    auto Id = Ids[Y * ChunkSize + X];
+                    if (Id != EmptyTile && Id <= Count)
+                    {
+                        DrawBitmap(Target, Set.GetTile(Id), X * Set.TileWidth + ShiftX, Y * RowStep);
+                    }
+                }
+            }
+            CacheAlpha[Cache]   = IsOpaque ? BitmapAlpha::Opaque
+                                  : Set.Atlas.Alpha == BitmapAlpha::Blend ? BitmapAlpha::Blend
+                                                                                 : BitmapAlpha::Mask;
+            CacheIsValid[Cache] = true;
+            ++CacheBuildCount;
+        }
+
+        // calls Function(Bitmap, X, Y) for every chunk overlapping the view, X and Y relative to the view
+        template <typename F>
+        void ForEachVisibleChunk(int32 CameraX, int32 CameraY, int32 ViewWidth, int32 ViewHeight, F&& Function)
+        {
+            if (!IsValid())
+            {
+                return;
+            }
+            // the chunks of this draw stay until its end, GetTile and SetTile can evict any of them afterwards
+            DrawStart = UseCount + 1;
+            // a chunk bitmap overlaps the next chunks by half a tile for hexagons
+            auto FirstX = FloorDivide(int64(CameraX) - CacheWidth, StrideX) + 1;
+            auto FirstY = FloorDivide(int64(CameraY) - CacheHeight, StrideY) + 1;
+            auto LastX  = FloorDivide(int64(CameraX) + ViewWidth - 1, StrideX);
+            auto LastY  = FloorDivide(int64(CameraY) + ViewHeight - 1, StrideY);
+            FirstX      = FirstX > 0 ? FirstX : 0;
+            FirstY      = FirstY > 0 ? FirstY : 0;
+            LastX       = LastX < ChunkCountX - 1 ? LastX : ChunkCountX - 1;
+            LastY       = LastY < ChunkCountY - 1 ? LastY : ChunkCountY - 1;
+            for (auto ChunkY = FirstY; ChunkY <= LastY; ++ChunkY)
+            {
+                for (auto ChunkX = FirstX; ChunkX <= LastX; ++ChunkX)
+                {
+                    auto Slot  = AcquireSlot(int32(ChunkX), int32(ChunkY));
+                    auto Cache = Slot != NoSlot ? AcquireCache(Slot) : NoSlot;
+                    if (Cache == NoSlot)
+                    {
+                        ++DroppedCount;
+                        continue;
+                    }
+                    Function(GetCacheBitmap(Cache),
+                             int32(ChunkX * StrideX - CameraX),
+                             int32(ChunkY * StrideY - CameraY));
+                }
+            }
+            DrawStart = NoDraw;
+        }
+
+        Tileset         Set;
+        TileMapStreamer Streamer;
+        int32           Width;
+        int32           Height;
+        int32           ChunkCountX;
+        int32           ChunkCountY;
+        int32           StrideX; // in pixels, between two chunks
+        int32           StrideY;
+        int32           CacheWidth; // in pixels, size of a chunk bitmap
+        int32           CacheHeight;
+        uint32          ResidentCount = 0;
+        uint32          CachedCount   = 0;
+        uint64          UseCount      = 0; // the last used time of the entries, they start unused at 0
+        uint64          DrawStart     = NoDraw; // entries used since are not evicted
+
+        uint32* ChunkSlots = nullptr; // directory: chunk -> resident slot
+
+        // resident chunks
+        TileId* SlotTiles      = nullptr; // ChunkTileCount per slot, row-major
+        uint32* SlotChunks     = nullptr;
+        uint64* SlotLastUsed   = nullptr;
+        uint32* SlotCaches     = nullptr;
+        bool*   SlotIsModified = nullptr; // since loaded
+
+        // chunk bitmaps
+        uint32*      CachePixels   = nullptr; // CacheWidth x CacheHeight per cache
+        uint32*      CacheSlots    = nullptr;
+        uint64*      CacheLastUsed = nullptr;
+        bool*        CacheIsValid  = nullptr;
+        BitmapAlpha* CacheAlpha    = nullptr;
+
+        uint64 LoadCount       = 0;
+        uint64 StoreCount      = 0;
+        uint64 CacheBuildCount = 0;
+        uint64 DroppedCount    = 0;
+    };
+
+} // namespace Game
@@ -0,0 +1,93 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include "../asset_packer/asset_pack_builder.hpp"
+
+using namespace Game;
+
+void AssetPackTests()
+{
+    // Lz round trip on compressible and incompressible data
+    std::vector<char> Text;
+    for (int Index = 0; Index < 5000; ++Index)
+    {
+        Text.push_back("the quick brown fox jumps over the lazy dog "[Index % 44]);
+    }
+    std::vector<char> Noise(3000);
+    uint32            Seed = 7;
+    for (auto& Byte : Noise)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        Byte = static_cast<char>(Seed >> 24);
+    }
+    for (auto* Data : { &Text, &Noise })
+    {
+        std::vector<char> Compressed(Lz::CompressBound(Data->size()));
+        auto              Size = Lz::Compress(Data->data(), Data->size(), Compressed.data(), Compressed.size());
+        std::vector<char> Decompressed(Data->size());
+        CHECK_TRUE(Lz::Decompress(Compressed.data(), Size, Decompressed.data(), Decompressed.size()));
+        CHECK_TRUE(Decompressed == *Data);
+        CHECK_FALSE(Lz::Decompress(Compressed.data(), Size - 1, Decompressed.data(), Decompressed.size()));
+    }
+
+    // every name is found with its content, in place, aligned
+    std::vector<InputAsset> Assets;
+    for (int Index = 0; Index < 100; ++Index)
+    {
+        Assets.push_back({ "asset_" + std::to_string(Index), Index % 2 ? Text : Noise });
+        Assets.back().Data.resize(Index * 37);
+    }
+    auto Pack = BuildAssetPack(Assets, true, nullptr);
+
+    AssetPack Reader;
+    CHECK_TRUE(Reader.Open(Pack.data(), Pack.size()));
+    CHECK_EQ(Reader.GetEntryCount(), 100u);
+    CHECK_FALSE(Reader.Get("asset_100"));
+    CHECK_FALSE(Reader.Open(Pack.data(), Pack.size() - 1));
+
+    // a blob or a name out of the file rejects the pack
+    for (uint32 Field = 0; Field < 2; ++Field)
+    {
+        auto  Corrupt = Pack;
+        auto& Header  = *reinterpret_cast<const AssetPackHeader*>(Corrupt.data());
+        auto  Entry   = reinterpret_cast<AssetPackEntry*>(Corrupt.data() + Header.EntriesOffset) + 3;
+        if (Field == 0)
+        {
+            Entry->Offset     = Corrupt.size() - 1;
+            Entry->StoredSize = Entry->Size = 2;
+        }
+        else
+        {
+            Entry->NameLength = uint32(Corrupt.size());
+        }
+        CHECK_FALSE(Reader.Open(Corrupt.data(), Corrupt.size()));
+    }
+    Reader.Open(Pack.data(), Pack.size());
+
+    int Matching   = 0;
+    int Compressed = 0;
+    for (auto& Asset : Assets)
+    {
+        auto View = Reader.Get(Asset.Name.c_str());
+        CHECK_EQ((View.Data - reinterpret_cast<const uint8*>(Pack.data())) % AssetPackAlignment, 0);
+        std::vector<char> Content(View.Size);
+        Matching += AssetPack::Unpack(View, Content.data()) && Content == Asset.Data;
+        Compressed += View.IsCompressed();
+    }
+    CHECK_EQ(Matching, 100);
+    CHECK_GT(Compressed, 0);
+
+    // interned names skip the hashing
+    std::vector<uint8> Memory(64 * 1024);
+    MemoryArena        Arena{ Memory.data(), Memory.size() };
+    StringTable        Names{ Arena, 256, 4096 };
+    auto               Interned = Reader.Find(InternedString{ Names, "asset_42" });
+    CHECK_TRUE(Interned == Reader.Find("asset_42"));
+    CHECK_FALSE(Reader.Get(InternedString{ Names, "asset_100" }));
+
+    CHECK_TRUE(BuildAssetPack({ { "twice", {} }, { "twice", {} } }, false, nullptr).empty());
+    AssetPackStats Failed;
+    CHECK_TRUE(BuildAssetPack({ { "twice", {} }, { "twice", {} } }, false, &Failed).empty());
+    CHECK_EQ(Failed.Error, std::string{ "duplicated name twice" });
+}
@@ -0,0 +1,482 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <audio_dsp.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    constexpr real32 SampleRate = 48000.0f;
+
+    bool IsNear(real32 A, real32 B, real32 Tolerance = 1e-4f)
+    {
+        return std::fabs(A - B) <= Tolerance * (1.0f + std::fabs(B));
+    }
+
+    // deterministic noise in [-Amplitude, Amplitude[
+    real32 Noise(uint32& Seed, real32 Amplitude)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        return static_cast<real32>(static_cast<int32>(Seed)) / 2147483648.0f * Amplitude;
+    }
+
+    void FillNoise(AudioBlock& Block, uint32 FrameCount, uint32& Seed, real32 Amplitude)
+    {
+        Block.FrameCount = FrameCount;
+        for (uint32 Index = 0; Index < FrameCount * AudioBlock::LaneCount; ++Index)
+        {
+            Block.Samples[Index] = Noise(Seed, Amplitude);
+        }
+    }
+
+    // RBJ cookbook coefficients b0 b1 b2 a1 a2, normalized by a0
+    void GetCoefficients(Biquad::Type Type, real32 FrequencyHz, real32 Q, real32 GainDb, real32* Coefficients)
+    {
+        auto   W0    = 2.0f * Dsp::Pi32 * FrequencyHz / SampleRate;
+        auto   CosW0 = std::cos(W0);
+        auto   Alpha = std::sin(W0) / (2.0f * Q);
+        auto   A     = std::pow(10.0f, GainDb / 40.0f);
+        real32 B[3]  = { (1.0f - CosW0) * 0.5f, 1.0f - CosW0, (1.0f - CosW0) * 0.5f };
+        real32 A0    = 1.0f + Alpha;
+        real32 A2    = 1.0f - Alpha;
+        if (Type == Biquad::Type::HighPass)
+        {
+            B[0] = B[2] = (1.0f + CosW0) * 0.5f;
+            B[1]        = -(1.0f + CosW0);
+        }
+        else if (Type == Biquad::Type::BandPass)
+        {
+            B[0] = Alpha;
+            B[1] = 0.0f;
+            B[2] = -Alpha;
+        }
+        else if (Type == Biquad::Type::Peak)
+        {
+            B[0] = 1.0f + Alpha * A;
+            B[1] = -2.0f * CosW0;
+            B[2] = 1.0f - Alpha * A;
+            A0   = 1.0f + Alpha / A;
+            A2   = 1.0f - Alpha / A;
+        }
+        Coefficients[0] = B[0] / A0;
+        Coefficients[1] = B[1] / A0;
+        Coefficients[2] = B[2] / A0;
+        Coefficients[3] = -2.0f * CosW0 / A0;
+        Coefficients[4] = A2 / A0;
+    }
+
+    // Scalar references: the algorithms of audio_dsp.hpp one lane at a time, with the same ramps over a block
+
+    struct ReferenceBiquad
+    {
+        ReferenceBiquad() { GetCoefficients(Biquad::Type::LowPass, SampleRate * 0.45f, 0.7071f, 0.0f, Current); }
+
+        void Set(Biquad::Type Type, real32 FrequencyHz, real32 Q, real32 GainDb)
+        {
+            GetCoefficients(Type, FrequencyHz, Q, GainDb, Target);
+        }
+
+        void Process(AudioBlock& Block)
+        {
+            real32 Coefficients[5];
+            real32 Steps[5];
+            for (uint32 Index = 0; Index < 5; ++Index)
+            {
+                Coefficients[Index] = Current[Index];
+                Steps[Index]        = (Target[Index] - Current[Index]) / static_cast<real32>(Block.FrameCount);
+                Current[Index]      = Target[Index];
+            }
+            for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                for (uint32 Index = 0; Index < 5; ++Index)
+                {
+                    Coefficients[Index] += Steps[Index];
+                }
+                for (uint32 Lane = 0; Lane < AudioBlock::LaneCount; ++Lane)
+                {
+                    auto& Sample = Block.Samples[FrameIndex * AudioBlock::LaneCount + Lane];
+                    auto  X      = Sample;
+                    auto  Y      = Coefficients[0] * X + Z1[Lane];
+                    Z1[Lane]     = Coefficients[1] * X - Coefficients[3] * Y + Z2[Lane];
+                    Z2[Lane]     = Coefficients[2] * X - Coefficients[4] * Y;
+                    Sample       = Y;
+                }
+            }
+        }
+
+        real32 Current[5];
+        real32 Target[5];
+        real32 Z1[AudioBlock::LaneCount] = {};
+        real32 Z2[AudioBlock::LaneCount] = {};
+    };
+
+    struct ReferenceReverb
+    {
+        static constexpr uint32 Mask                           = FeedbackDelayReverb::LineLength - 1;
+        static constexpr uint32 Lengths[AudioBlock::LaneCount] = { 1447, 1789, 2083, 2503 };
+
+        void Process(AudioBlock& Block)
+        {
+            auto FeedbackValue = Feedback.Current;
+            auto FeedbackStep  = Feedback.BeginBlock(Block.FrameCount);
+            auto DampingValue  = Damping.Current;
+            auto DampingStep   = Damping.BeginBlock(Block.FrameCount);
+            auto MixValue      = Mix.Current;
+            auto MixStep       = Mix.BeginBlock(Block.FrameCount);
+            for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                FeedbackValue += FeedbackStep;
+                DampingValue += DampingStep;
+                MixValue += MixStep;
+
+                auto   Frame = Block.Samples + FrameIndex * AudioBlock::LaneCount;
+                real32 Taps[AudioBlock::LaneCount];
+                for (uint32 Line = 0; Line < AudioBlock::LaneCount; ++Line)
+                {
+                    Taps[Line]    = Lines[Line][(Position - Lengths[Line]) & Mask];
+                    LowPass[Line] = Taps[Line] + DampingValue * (LowPass[Line] - Taps[Line]);
+                }
+                auto   A        = LowPass[0];
+                auto   B        = LowPass[1];
+                auto   C        = LowPass[2];
+                auto   D        = LowPass[3];
+                real32 Mixed[4] = { ((A + B) + (C + D)) * 0.5f, ((A - B) + (C - D)) * 0.5f,
+                                    ((A + B) - (C + D)) * 0.5f, ((A - B) - (C - D)) * 0.5f };
+                auto   Mono     = (Frame[0] + Frame[1]) * 0.5f;
+                for (uint32 Line = 0; Line < AudioBlock::LaneCount; ++Line)
+                {
+                    Lines[Line][Position] = Mono + FeedbackValue * Mixed[Line];
+                }
+                Position = (Position + 1) & Mask;
+
+                real32 Wet[4] = { (Taps[0] + Taps[2]) * 0.5f, (Taps[1] + Taps[3]) * 0.5f, 0.0f, 0.0f };
+                for (uint32 Lane = 0; Lane < AudioBlock::LaneCount; ++Lane)
+                {
+                    Frame[Lane] = Frame[Lane] * (1.0f - MixValue) + Wet[Lane] * MixValue;
+                }
+            }
+        }
+
+        SmoothedParameter Feedback{ 0.7f };
+        SmoothedParameter Damping{ 0.3f };
+        SmoothedParameter Mix{ 0.0f };
+        uint32            Position                       = 0;
+        real32            LowPass[AudioBlock::LaneCount] = {};
+        real32            Lines[AudioBlock::LaneCount][FeedbackDelayReverb::LineLength] = {};
+    };
+
+    // exact log2 and exp2 where the kernel approximates them
+    struct ReferenceCompressor
+    {
+        void Process(AudioBlock& Block)
+        {
+            auto Threshold     = ThresholdLog2.Current;
+            auto ThresholdStep = ThresholdLog2.BeginBlock(Block.FrameCount);
+            auto SlopeValue    = Slope.Current;
+            auto SlopeStep     = Slope.BeginBlock(Block.FrameCount);
+            auto MakeUp        = MakeUpLog2.Current;
+            auto MakeUpStep    = MakeUpLog2.BeginBlock(Block.FrameCount);
+            for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                Threshold += ThresholdStep;
+                SlopeValue += SlopeStep;
+                MakeUp += MakeUpStep;
+
+                auto   Frame = Block.Samples + FrameIndex * AudioBlock::LaneCount;
+                real32 Level = 0.0f;
+                for (uint32 Lane = 0; Lane < AudioBlock::LaneCount; ++Lane)
+                {
+                    Level = std::max(Level, std::fabs(Frame[Lane]));
+                }
+                auto Coefficient = Level > Envelope ? Attack : Release;
+                Envelope         = Level + Coefficient * (Envelope - Level);
+                auto Over        = Threshold - std::log2(std::max(Envelope, 1e-30f));
+                auto Gain        = std::exp2(std::min(0.0f, SlopeValue * Over) + MakeUp);
+                for (uint32 Lane = 0; Lane < AudioBlock::LaneCount; ++Lane)
+                {
+                    Frame[Lane] *= Gain;
+                }
+            }
+        }
+
+        SmoothedParameter ThresholdLog2{ 0.0f };
+        SmoothedParameter Slope{ 1.0f };
+        SmoothedParameter MakeUpLog2{ 0.0f };
+        real32            Attack   = Dsp::TimeCoefficient(0.001f, SampleRate);
+        real32            Release  = Dsp::TimeCoefficient(0.1f, SampleRate);
+        real32            Envelope = 0.0f;
+    };
+
+    // doubles the signal: drives the conversion back to int16 into saturation
+    class Amplifier final : public AudioEffect
+    {
+    public:
+        Amplifier()
+            : AudioEffect{ "Amplifier" }
+        {}
+
+    private:
+        void ProcessBlock(AudioBlock& Block) override
+        {
+            for (uint32 Index = 0; Index < Block.FrameCount * AudioBlock::LaneCount; ++Index)
+            {
+                Block.Samples[Index] *= 2.0f;
+            }
+        }
+    };
+
+    // the count of samples too far from the reference, over blocks of noise
+    template <typename E, typename R>
+    uint32 CompareBlocks(E& Effect, R& Reference, uint32 BlockCount, real32 Amplitude, real32 Tolerance)
+    {
+        AudioBlock Block;
+        AudioBlock Expected;
+        uint32     Seed       = 5;
+        uint32     Mismatches = 0;
+        for (uint32 BlockIndex = 0; BlockIndex < BlockCount; ++BlockIndex)
+        {
+            // odd sizes: the ramps must end on the target whatever the block
+            FillNoise(Block, BlockIndex % 3 ? AudioBlock::MaxFrameCount : 77, Seed, Amplitude);
+            Expected = Block;
+            Effect.Process(Block);
+            Reference.Process(Expected);
+            for (uint32 Index = 0; Index < Block.FrameCount * AudioBlock::LaneCount; ++Index)
+            {
+                Mismatches += !IsNear(Block.Samples[Index], Expected.Samples[Index], Tolerance);
+            }
+        }
+        return Mismatches;
+    }
+
+    // the peak of lane 0 over the last frames of a sine at FrequencyHz, once the filter settled
+    real32 GetSineGain(Biquad& Filter, real32 FrequencyHz)
+    {
+        AudioBlock Block;
+        real32     Peak = 0.0f;
+        for (uint32 BlockIndex = 0; BlockIndex < 40; ++BlockIndex)
+        {
+            Block.FrameCount = AudioBlock::MaxFrameCount;
+            for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                auto Time   = static_cast<real32>(BlockIndex * AudioBlock::MaxFrameCount + FrameIndex) / SampleRate;
+                auto Sample = std::sin(2.0f * Dsp::Pi32 * FrequencyHz * Time);
+                Block.Store(FrameIndex, _mm_set1_ps(Sample));
+            }
+            Filter.Process(Block);
+            for (uint32 FrameIndex = 0; BlockIndex >= 30 && FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                Peak = std::max(Peak, std::fabs(Block.Samples[FrameIndex * AudioBlock::LaneCount]));
+            }
+        }
+        return Peak;
+    }
+} // namespace
+
+void AudioDspTests()
+{
+    // smoothed parameter: the increment reaches the target at the end of the block, empty blocks jump to it
+    {
+        SmoothedParameter Volume{ 1.0f };
+        Volume.SetTarget(0.5f);
+        auto Step   = Volume.BeginBlock(100);
+        auto Ended  = Volume.Current;
+        auto Still  = Volume.BeginBlock(100);
+        auto Ramped = 1.0f + 100 * Step;
+        CHECK_TRUE(IsNear(Step, -0.005f));
+        CHECK_TRUE(IsNear(Ramped, 0.5f));
+        CHECK_EQ(Ended, 0.5f);
+        CHECK_EQ(Still, 0.0f);
+        Volume.SetTarget(1.0f);
+        auto Jump = Volume.BeginBlock(0);
+        CHECK_EQ(Jump, 0.5f);
+    }
+
+    // biquad: the 4 lanes like the scalar filter, coefficients ramped over the block after each Set
+    {
+        Biquad          Filter{ SampleRate };
+        ReferenceBiquad Reference;
+        Biquad::Type    Types[] = { Biquad::Type::LowPass, Biquad::Type::HighPass, Biquad::Type::BandPass,
+                                    Biquad::Type::Peak };
+        uint32          Mismatches = 0;
+        for (auto Type : Types)
+        {
+            Filter.Set(Type, 1200.0f, 0.9f, 6.0f);
+            Reference.Set(Type, 1200.0f, 0.9f, 6.0f);
+            Mismatches += CompareBlocks(Filter, Reference, 4, 0.5f, 1e-4f);
+        }
+        CHECK_EQ(Mismatches, 0u);
+
+        // the responses: the low pass keeps the bass, the high pass the treble, the peak doubles its frequency
+        Biquad LowPass{ SampleRate };
+        Biquad HighPass{ SampleRate };
+        Biquad Peak{ SampleRate };
+        LowPass.Set(Biquad::Type::LowPass, 1000.0f, 0.7071f, 0.0f);
+        HighPass.Set(Biquad::Type::HighPass, 1000.0f, 0.7071f, 0.0f);
+        Peak.Set(Biquad::Type::Peak, 1000.0f, 1.0f, 6.0206f);
+        auto Bass    = GetSineGain(LowPass, 100.0f);
+        auto Treble  = GetSineGain(LowPass, 12000.0f);
+        auto Removed = GetSineGain(HighPass, 100.0f);
+        auto Boosted = GetSineGain(Peak, 1000.0f);
+        CHECK_TRUE(Bass > 0.99f && Bass < 1.01f);
+        CHECK_LT(Treble, 0.01f);
+        CHECK_LT(Removed, 0.02f);
+        CHECK_TRUE(Boosted > 1.98f && Boosted < 2.02f);
+    }
+
+    // reverb: the delay lines, their damping and mixing like the scalar network, past the longest line
+    {
+        auto Reverb    = std::make_unique<FeedbackDelayReverb>();
+        auto Reference = std::make_unique<ReferenceReverb>();
+        Reverb->SetFeedback(0.85f);
+        Reverb->SetDamping(0.4f);
+        Reverb->SetMix(0.6f);
+        Reference->Feedback.SetTarget(0.85f);
+        Reference->Damping.SetTarget(0.4f);
+        Reference->Mix.SetTarget(0.6f);
+        auto Mismatches = CompareBlocks(*Reverb, *Reference, 40, 0.5f, 1e-4f);
+        CHECK_EQ(Mismatches, 0u);
+
+        // an impulse comes back on the left after the first line, lanes 2 and 3 stay silent
+        FeedbackDelayReverb Echo;
+        Echo.SetMix(1.0f);
+        AudioBlock Block = {};
+        Block.FrameCount = AudioBlock::MaxFrameCount;
+        Block.Samples[0] = 1.0f;
+        Block.Samples[1] = 1.0f;
+        real32 Left      = 0.0f;
+        real32 Lanes23   = 0.0f;
+        for (uint32 BlockIndex = 0; BlockIndex < 8; ++BlockIndex)
+        {
+            Echo.Process(Block);
+            if (BlockIndex == 5) // frame 1447 is frame 167 of block 5
+            {
+                Left = Block.Samples[(1447 - 5 * AudioBlock::MaxFrameCount) * AudioBlock::LaneCount];
+            }
+            for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                Lanes23 += std::fabs(Block.Samples[FrameIndex * 4 + 2]) + std::fabs(Block.Samples[FrameIndex * 4 + 3]);
+            }
+            std::fill(Block.Samples, Block.Samples + AudioBlock::MaxFrameCount * AudioBlock::LaneCount, 0.0f);
+        }
+        CHECK_TRUE(IsNear(Left, 0.5f));
+        CHECK_EQ(Lanes23, 0.0f);
+    }
+
+    // compressor: the gains of the exact curve within the error of the fast log2 and exp2
+    {
+        Compressor          Compress{ SampleRate };
+        ReferenceCompressor Reference;
+        Compress.SetThreshold(-12.0f);
+        Compress.SetRatio(4.0f);
+        Compress.SetMakeUpGain(3.0f);
+        Reference.ThresholdLog2.SetTarget(-12.0f / 6.0206f);
+        Reference.Slope.SetTarget(0.75f);
+        Reference.MakeUpLog2.SetTarget(3.0f / 6.0206f);
+        auto Mismatches = CompareBlocks(Compress, Reference, 12, 0.9f, 1e-2f);
+        CHECK_EQ(Mismatches, 0u);
+
+        // a ratio of 0 and an instant attack limit a loud sine to the threshold, -6dB
+        Compressor Limiter{ SampleRate };
+        Limiter.SetThreshold(-6.0206f);
+        Limiter.SetRatio(0.0f);
+        Limiter.SetTimes(0.0f, 0.1f);
+        AudioBlock Block;
+        Block.FrameCount = AudioBlock::MaxFrameCount;
+        real32 Peak      = 0.0f;
+        for (uint32 BlockIndex = 0; BlockIndex < 20; ++BlockIndex)
+        {
+            for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                auto Sample = std::sin(2.0f * Dsp::Pi32 * 40.0f * static_cast<real32>(FrameIndex) / 256.0f);
+                Block.Store(FrameIndex, _mm_set1_ps(Sample));
+            }
+            Limiter.Process(Block);
+            for (uint32 FrameIndex = 0; BlockIndex >= 10 && FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                Peak = std::max(Peak, Block.Samples[FrameIndex * AudioBlock::LaneCount]);
+            }
+        }
+        auto Reduction = Limiter.GetLastGainReduction();
+        CHECK_TRUE(Peak > 0.49f && Peak < 0.51f);
+        CHECK_TRUE(Reduction > 0.49f && Reduction < 0.51f);
+    }
+
+    // chain: insertion order, removal, the int16 round trip in blocks, saturation and bypass
+    {
+        EffectChain Chain;
+        Biquad      Filter{ SampleRate };
+        Compressor  Compress{ SampleRate };
+        Amplifier   Loud;
+        CHECK_TRUE(Chain.Insert(Compress));
+        CHECK_TRUE(Chain.Insert(Filter, 0));
+        CHECK_EQ(&Chain.GetEffect(0), static_cast<AudioEffect*>(&Filter));
+        CHECK_EQ(&Chain.GetEffect(1), static_cast<AudioEffect*>(&Compress));
+        for (uint32 Index = 2; Index < EffectChain::MaxEffectCount; ++Index)
+        {
+            Chain.Insert(Loud);
+        }
+        CHECK_FALSE(Chain.Insert(Loud));
+        Chain.Remove(Loud);
+        CHECK_EQ(Chain.GetEffectCount(), 2u);
+
+        // 700 frames: two full blocks and a partial one, against the references on the same blocks
+        constexpr uint32   FrameCount = 700;
+        std::vector<int16> Samples(2 * FrameCount);
+        uint32             Seed = 9;
+        for (auto& Sample : Samples)
+        {
+            Sample = static_cast<int16>(Noise(Seed, 20000.0f));
+        }
+        auto Input = Samples;
+        Filter.Set(Biquad::Type::Peak, 3000.0f, 2.0f, -9.0f);
+        Compress.SetThreshold(-18.0f);
+        Chain.Process(Samples.data(), FrameCount);
+
+        ReferenceBiquad     ReferenceFilter;
+        ReferenceCompressor ReferenceCompress;
+        ReferenceFilter.Set(Biquad::Type::Peak, 3000.0f, 2.0f, -9.0f);
+        ReferenceCompress.ThresholdLog2.SetTarget(-18.0f / 6.0206f);
+        uint32 Mismatches = 0;
+        for (uint32 First = 0; First < FrameCount; First += AudioBlock::MaxFrameCount)
+        {
+            AudioBlock Block = {};
+            Block.FrameCount = std::min(FrameCount - First, AudioBlock::MaxFrameCount);
+            for (uint32 FrameIndex = 0; FrameIndex < Block.FrameCount; ++FrameIndex)
+            {
+                Block.Samples[FrameIndex * 4]     = Input[2 * (First + FrameIndex)] / 32768.0f;
+                Block.Samples[FrameIndex * 4 + 1] = Input[2 * (First + FrameIndex) + 1] / 32768.0f;
+            }
+            ReferenceFilter.Process(Block);
+            ReferenceCompress.Process(Block);
+            for (uint32 Index = 0; Index < 2 * Block.FrameCount; ++Index)
+            {
+                auto Scaled   = std::nearbyint(Block.Samples[Index / 2 * 4 + Index % 2] * 32767.0f);
+                auto Expected = static_cast<int32>(std::min(std::max(Scaled, -32768.0f), 32767.0f));
+                auto Actual   = static_cast<int32>(Samples[2 * First + Index]);
+                // 1% of a sample of 20000 for the fast gain
+                Mismatches += std::abs(Actual - Expected) > 1 + std::abs(Expected) / 100;
+            }
+        }
+        CHECK_EQ(Mismatches, 0u);
+
+        // saturated, then bypassed: only the rounding of the conversions is left
+        EffectChain Gain;
+        Gain.Insert(Loud);
+        int16 Stereo[6] = { 30000, -30000, 1000, -1000, 32767, -32768 };
+        Gain.Process(Stereo, 3);
+        CHECK_EQ(Stereo[0], 32767);
+        CHECK_EQ(Stereo[1], -32768);
+        CHECK_EQ(Stereo[2], 2000);
+        CHECK_EQ(Stereo[3], -2000);
+        Loud.IsBypassed = true;
+        int16 Bypassed[2] = { 12345, -12345 };
+        Gain.Process(Bypassed, 1);
+        CHECK_TRUE(std::abs(Bypassed[0] - 12345) <= 1 && std::abs(Bypassed[1] + 12345) <= 1);
+    }
+}
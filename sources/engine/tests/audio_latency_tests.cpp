@@ -0,0 +1,91 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <audio_latency.hpp>
+
+using namespace Game;
+
+namespace
+{
+    constexpr uint32 SamplesPerSecond = 48000;
+    constexpr uint32 BytesPerSample   = 4;
+    constexpr uint32 BufferSize       = SamplesPerSecond * BytesPerSample;
+    constexpr uint32 InitialLatency   = SamplesPerSecond / 12;
+
+    // Same write policy as Windows::SoundEngine::PrepareUpdate/FillSoundBuffer, against a simulated device
+    struct Writer
+    {
+        SimulatedSoundDevice Device{ BufferSize, BytesPerSample, SamplesPerSecond, 480, 720 };
+        LatencyController    Controller{ BufferSize, BytesPerSample, SamplesPerSecond, InitialLatency };
+        uint64               RunningSampleIndex = 0;
+        uint64               RealUnderrunCount  = 0;
+
+        void Frame(uint64 Microseconds)
+        {
+            Device.Advance(Microseconds);
+            if (Device.GetPlayedSampleCount() > RunningSampleIndex)
+            {
+                ++RealUnderrunCount;
+            }
+
+            auto Cursors    = Device.GetCursors();
+            auto ByteToLock = static_cast<uint32>((RunningSampleIndex * BytesPerSample) % BufferSize);
+            if (Controller.Update(Cursors, ByteToLock))
+            {
+                RunningSampleIndex += ((Cursors.WriteCursor + BufferSize - ByteToLock) % BufferSize) / BytesPerSample;
+                ByteToLock = Cursors.WriteCursor;
+            }
+            auto Ahead  = (ByteToLock + BufferSize - Cursors.PlayCursor) % BufferSize;
+            auto Wanted = Controller.GetLatencySampleCount() * BytesPerSample;
+            RunningSampleIndex += (Wanted > Ahead ? Wanted - Ahead : 0) / BytesPerSample;
+        }
+    };
+
+    // deterministic frame durations: 33.3ms +/- 2ms
+    uint64 JitteredFrame(uint32& Seed)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        return 33'333 + (Seed >> 16) % 4'000 - 2'000;
+    }
+} // namespace
+
+void AudioLatencyTests()
+{
+    uint32 Seed = 42;
+
+    Writer Steady;
+    for (int FrameIndex = 0; FrameIndex < 600; ++FrameIndex)
+    {
+        Steady.Frame(JitteredFrame(Seed));
+    }
+    auto UnderrunsAfterWarmUp = Steady.RealUnderrunCount;
+    for (int FrameIndex = 0; FrameIndex < 1000; ++FrameIndex)
+    {
+        Steady.Frame(JitteredFrame(Seed));
+    }
+    auto& Telemetry = Steady.Controller.GetTelemetry();
+
+    CHECK_EQ(Steady.RealUnderrunCount, UnderrunsAfterWarmUp);
+    CHECK_LT(Telemetry.LatencySampleCount, InitialLatency);
+    CHECK_GT(Telemetry.LatencySampleCount, Telemetry.GuardSampleCount + Telemetry.LastAdvance);
+    CHECK_EQ(Telemetry.GuardSampleCount, 720u);
+    CHECK_GT(Telemetry.MeanAdvance, 1500.0f);
+    CHECK_LT(Telemetry.MeanAdvance, 1700.0f);
+    CHECK_GT(Telemetry.Jitter, 0.0f);
+
+    // a 150ms hitch must be reported and make the controller more careful
+    auto LatencyBeforeHitch   = Telemetry.LatencySampleCount;
+    auto UnderrunsBeforeHitch = Telemetry.UnderrunCount;
+    Steady.Frame(150'000);
+    CHECK_EQ(Telemetry.UnderrunCount, UnderrunsBeforeHitch + 1);
+    CHECK_GT(Telemetry.LatencySampleCount, LatencyBeforeHitch);
+
+    // and it recovers without new underruns
+    for (int FrameIndex = 0; FrameIndex < 600; ++FrameIndex)
+    {
+        Steady.Frame(JitteredFrame(Seed));
+    }
+    CHECK_EQ(Telemetry.UnderrunCount, UnderrunsBeforeHitch + 1);
+    CHECK_LT(Telemetry.LatencySampleCount, InitialLatency);
+}
@@ -0,0 +1,158 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <bitmap_font.hpp>
+
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    struct TestBuffer
+    {
+        TestBuffer(int32 Width, int32 Height, uint32 Seed)
+            : Pixels(size_t(Width) * Height)
+            , Buffer{ Pixels.data(), Width, Height, 4, Width * 4 }
+        {
+            for (auto& Pixel : Pixels)
+            {
+                Seed  = Seed * 1664525u + 1013904223u;
+                Pixel = Seed;
+            }
+        }
+
+        uint32 Get(int32 X, int32 Y) const { return Pixels[size_t(Y) * Buffer.Width + X]; }
+
+        std::vector<uint32> Pixels;
+        PIBackBuffer        Buffer;
+    };
+} // namespace
+
+void BitmapFontTests()
+{
+    std::vector<uint8> Memory(1 << 16);
+    MemoryArena        Arena{ Memory.data(), Memory.size() };
+
+    // the built-in font: 'T' in the atlas, a row of 5 then a column, twice as large at scale 2
+    {
+        BitmapFont Font{ Arena };
+        BitmapFont Large{ Arena, 2 };
+        CHECK_TRUE(Font.IsValid());
+        CHECK_TRUE(Large.IsValid());
+        auto& T      = Font.GetGlyph('T');
+        auto  Atlas  = Font.GetAtlas();
+        auto  Width  = Font.GetAtlasWidth();
+        auto  Top    = Atlas + T.AtlasY * Width + T.AtlasX;
+        auto  Second = Atlas + (T.AtlasY + 1) * Width + T.AtlasX;
+        CHECK_EQ(T.Width, 5);
+        CHECK_EQ(T.Height, 7);
+        CHECK_EQ(T.Advance, 6);
+        CHECK_EQ(Top[0] + Top[1] + Top[2] + Top[3] + Top[4], 5 * 255);
+        CHECK_EQ(Second[0] + Second[1] + Second[2] + Second[3] + Second[4], 255);
+        CHECK_EQ(Second[2], 255);
+        auto& LargeT = Large.GetGlyph('T');
+        auto  Corner = Large.GetAtlas() + (LargeT.AtlasY + 1) * Large.GetAtlasWidth() + LargeT.AtlasX + 1;
+        auto  Below  = Large.GetAtlas() + (LargeT.AtlasY + 2) * Large.GetAtlasWidth() + LargeT.AtlasX;
+        CHECK_EQ(LargeT.Width, 10);
+        CHECK_EQ(*Corner, 255);
+        CHECK_EQ(*Below, 0);
+        CHECK_EQ(Large.GetLineHeight(), 2 * Font.GetLineHeight());
+
+        // too large a scale, or too small an arena
+        std::vector<uint8> Small(256);
+        MemoryArena        SmallArena{ Small.data(), Small.size() };
+        BitmapFont         Huge{ Arena, 9 };
+        BitmapFont         Invalid{ SmallArena };
+        CHECK_FALSE(Huge.IsValid());
+        CHECK_FALSE(Invalid.IsValid());
+    }
+
+    // measure and layout: advances, lines, blanks without quads, unknown characters as '?'
+    {
+        BitmapFont Font{ Arena };
+        auto       Line     = Font.GetLineHeight();
+        auto       Single   = Font.Measure("abc");
+        auto       Multiple = Font.Measure("ab\nabcd\n");
+        auto       Empty    = Font.Measure("");
+        auto       Unknown  = Font.Measure("\x01\xE9");
+        CHECK_EQ(Single.Width, 18);
+        CHECK_EQ(Single.Height, Line);
+        CHECK_EQ(Multiple.Width, 24);
+        CHECK_EQ(Multiple.Height, 3 * Line);
+        CHECK_EQ(Empty.Width, 0);
+        CHECK_EQ(Unknown.Width, 12);
+        auto& Question = Font.GetGlyph('?');
+        auto& Missing  = Font.GetGlyph('\x7F');
+        CHECK_EQ(Missing.AtlasX, Question.AtlasX);
+        CHECK_EQ(Missing.AtlasY, Question.AtlasY);
+
+        GlyphQuad Quads[8];
+        auto      Count = Font.Layout("a b\nc", 10, 20, Quads, 8);
+        CHECK_EQ(Count, 3u);
+        CHECK_EQ(Quads[0].X, 10);
+        CHECK_EQ(Quads[1].X, 22);
+        CHECK_EQ(Quads[2].X, 10);
+        CHECK_EQ(Quads[2].Y, 20 + Line);
+        CHECK_EQ(Quads[2].AtlasX, Font.GetGlyph('c').AtlasX);
+        auto Truncated = Font.Layout("abcdef", 0, 0, Quads, 4);
+        CHECK_EQ(Truncated, 4u);
+    }
+
+    // a font of the caller with partial coverage: the SIMD kernels blend like the scalar one, inside the clip only
+    {
+        constexpr int32 AtlasWidth  = 37;
+        constexpr int32 AtlasHeight = 3;
+        uint8           Atlas[AtlasWidth * AtlasHeight];
+        for (int32 Index = 0; Index < AtlasWidth * AtlasHeight; ++Index)
+        {
+            // runs of empty and full coverage for the fast paths, a ramp elsewhere
+            Atlas[Index] = Index < 8 ? 0 : Index < 16 ? 255 : uint8(Index * 37);
+        }
+        GlyphMetrics Metrics[256] = {};
+        Metrics['?']              = { 0, 0, AtlasWidth, AtlasHeight, 0, 0, AtlasWidth + 1, 0 };
+        Metrics['x']              = { 0, 0, AtlasWidth, AtlasHeight, 0, 1, AtlasWidth + 1, 0 };
+        BitmapFont Font{ Atlas, AtlasWidth, AtlasHeight, Metrics, 8 };
+        CHECK_TRUE(Font.IsValid());
+
+        GlyphQuad Quads[4];
+        auto      Count = Font.Layout("xx", -5, 2, Quads, 4);
+        CHECK_EQ(Count, 2u);
+        CHECK_EQ(Quads[0].Y, 3);
+        BlitRect  Clip     = { 0, 3, 60, 5 };
+        SimdLevel Levels[] = { SimdLevel::Sse2, SimdLevel::Avx2 };
+        for (auto Color : { 0xFFFF8040u, 0x80402010u })
+        {
+            TestBuffer Expected{ 64, 8, 11 };
+            DrawGlyphs(Expected.Buffer, Font, Quads, Count, Color, Clip, SimdLevel::Scalar);
+            auto Below = Expected.Get(10, 5);
+            auto Right = Expected.Get(60, 3);
+            CHECK_EQ(Below, TestBuffer(64, 8, 11).Get(10, 5));
+            CHECK_EQ(Right, TestBuffer(64, 8, 11).Get(60, 3));
+            // the pixel at (20, 3) is at column 25 of the first glyph
+            auto Scaled  = FontRendering::ScaleColor(Color, Atlas[25]);
+            auto Blended = Blit::BlendPixel(Scaled, TestBuffer(64, 8, 11).Get(20, 3));
+            CHECK_EQ(Expected.Get(20, 3), Blended);
+            for (auto Level : Levels)
+            {
+                if (Level > GetBestSimdLevel())
+                {
+                    continue;
+                }
+                TestBuffer Actual{ 64, 8, 11 };
+                DrawGlyphs(Actual.Buffer, Font, Quads, Count, Color, Clip, Level);
+                CHECK_TRUE(Actual.Pixels == Expected.Pixels);
+            }
+        }
+
+        // a line at a time
+        TestBuffer Target{ 128, 32, 5 };
+        TestBuffer Reference{ 128, 32, 5 };
+        DrawText(Target.Buffer, Font, "x\nxx", 2, 0, 0xFFFFFFFF);
+        CHECK_EQ(Target.Get(2 + 8, 1), 0xFFFFFFFFu);
+        CHECK_EQ(Target.Get(2 + 8, 9), 0xFFFFFFFFu);
+        CHECK_EQ(Target.Get(2 + 38 + 8, 9), 0xFFFFFFFFu);
+        CHECK_EQ(Target.Get(2 + 38 + 8, 1), Reference.Get(2 + 38 + 8, 1));
+    }
+}
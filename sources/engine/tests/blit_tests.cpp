@@ -0,0 +1,114 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <blit.hpp>
+
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    struct TestBuffer
+    {
+        TestBuffer(int32 Width, int32 Height, uint32 Seed)
+            : Pixels(size_t(Width + 3) * Height)
+        {
+            for (auto& Pixel : Pixels)
+            {
+                Seed  = Seed * 1664525u + 1013904223u;
+                Pixel = Seed;
+            }
+            // pitch larger than the width, like a sub-rectangle
+            Buffer = { Pixels.data(), Width, Height, 4, (Width + 3) * 4 };
+        }
+
+        std::vector<uint32> Pixels;
+        PIBackBuffer        Buffer;
+    };
+
+    // premultiplied sprite with transparent, opaque and translucent pixels
+    std::vector<uint32> MakeSprite(int32 Width, int32 Height, bool IsMask)
+    {
+        std::vector<uint32> Pixels(size_t(Width) * Height);
+        uint32              Seed = 3;
+        for (auto& Pixel : Pixels)
+        {
+            Seed        = Seed * 1664525u + 1013904223u;
+            uint32 Kind = (Seed >> 28) % 3;
+            uint32 A    = Kind == 0 ? 0 : Kind == 1 || IsMask ? 255 : (Seed >> 8) & 0xFF;
+            uint32 R    = ((Seed >> 16) & 0xFF) * A / 255;
+            uint32 G    = ((Seed >> 4) & 0xFF) * A / 255;
+            Pixel       = A ? (A << 24) | (R << 16) | (G << 8) | (A / 2) : 0;
+        }
+        return Pixels;
+    }
+} // namespace
+
+void BlitTests()
+{
+    // pixel math: opaque replaces, transparent keeps, half alpha halves the background
+    CHECK_EQ(Blit::BlendPixel(0xFF102030, 0xFFFFFFFF), 0xFF102030u);
+    CHECK_EQ(Blit::BlendPixel(0x00000000, 0x12345678), 0x12345678u);
+    CHECK_EQ(Blit::BlendPixel(0x80000000, 0x00C8C8C8), 0x80646464u);
+    CHECK_EQ(Blit::BlendPixel(0x00FF0000, 0x00808080), 0x00FF8080u); // additive, saturated
+
+    auto Sprite = MakeSprite(37, 21, false);
+    auto Masked = MakeSprite(37, 21, true);
+    CHECK_TRUE(ClassifyAlpha(Sprite.data(), 37, 21, 37 * 4) == BitmapAlpha::Blend);
+    CHECK_TRUE(ClassifyAlpha(Masked.data(), 37, 21, 37 * 4) == BitmapAlpha::Mask);
+    std::vector<uint32> Opaque(37 * 21, 0xFF00FF00);
+    CHECK_TRUE(ClassifyAlpha(Opaque.data(), 37, 21, 37 * 4) == BitmapAlpha::Opaque);
+
+    // every kernel gives the scalar result, clipped on all sides and by a clip rectangle
+    const BlitRect Clip         = { 5, 3, 55, 40 };
+    const int32    Positions[]  = { -10, 0, 17, 40 };
+    const uint32*  Sources[]    = { Sprite.data(), Masked.data(), Opaque.data() };
+    BitmapAlpha    Alphas[]     = { BitmapAlpha::Blend, BitmapAlpha::Mask, BitmapAlpha::Opaque };
+    SimdLevel      Levels[]     = { SimdLevel::Sse2, SimdLevel::Avx2 };
+    int            MatchCount   = 0;
+    int            CompareCount = 0;
+    for (int Kind = 0; Kind < 3; ++Kind)
+    {
+        Bitmap Bitmap = { Sources[Kind], 37, 21, 37 * 4, Alphas[Kind] };
+        for (auto Level : Levels)
+        {
+            if (Level == SimdLevel::Avx2 && !GetCpuFeatures().Avx2)
+            {
+                continue;
+            }
+            for (auto X : Positions)
+            {
+                for (auto Y : Positions)
+                {
+                    TestBuffer Expected{ 60, 45, 9 };
+                    TestBuffer Actual{ 60, 45, 9 };
+                    DrawBitmap(Expected.Buffer, Bitmap, X, Y, Clip, SimdLevel::Scalar);
+                    DrawBitmap(Actual.Buffer, Bitmap, X, Y, Clip, Level);
+                    MatchCount += Expected.Pixels == Actual.Pixels;
+                    ++CompareCount;
+                }
+            }
+        }
+    }
+    CHECK_EQ(MatchCount, CompareCount);
+
+    // nothing is written out of the clip rectangle, nor past the width in the pitch padding
+    TestBuffer Reference{ 60, 45, 9 };
+    TestBuffer Drawn{ 60, 45, 9 };
+    DrawBitmap(Drawn.Buffer, { Opaque.data(), 37, 21, 37 * 4, BitmapAlpha::Opaque }, 40, 30, Clip);
+    int OutsideChanged = 0;
+    int InsideChanged  = 0;
+    for (int32 Y = 0; Y < 45; ++Y)
+    {
+        for (int32 X = 0; X < 63; ++X)
+        {
+            auto IsInside  = X >= 40 && X < 55 && Y >= 30 && Y < 40;
+            auto IsChanged = Drawn.Pixels[Y * 63 + X] != Reference.Pixels[Y * 63 + X];
+            (IsInside ? InsideChanged : OutsideChanged) += IsChanged;
+        }
+    }
+    CHECK_EQ(InsideChanged, 15 * 10);
+    CHECK_EQ(OutsideChanged, 0);
+}
@@ -0,0 +1,185 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <broadphase.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    using Pairs = std::vector<uint64>;
+
+    uint32 Random(uint32& Seed)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        return Seed >> 8;
+    }
+
+    // around the origin, some of them covering many cells of 4 units
+    std::vector<Aabb> MakeBoxes(uint32 Count, uint32 Seed)
+    {
+        std::vector<Aabb> Boxes(Count);
+        for (auto& Box : Boxes)
+        {
+            auto X     = real32(Random(Seed) % 20000) / 100.0f - 100.0f;
+            auto Y     = real32(Random(Seed) % 20000) / 100.0f - 100.0f;
+            auto Size  = Random(Seed) % 50 == 0 ? 2000u : 300u;
+            auto Width = real32(Random(Seed) % Size) / 100.0f;
+            Box.Min    = { X, Y };
+            Box.Max    = { X + Width, Y + real32(Random(Seed) % Size) / 100.0f };
+        }
+        return Boxes;
+    }
+
+    Pairs BruteForce(const std::vector<Aabb>& Boxes)
+    {
+        Pairs Result;
+        for (uint32 A = 0; A < Boxes.size(); ++A)
+        {
+            for (uint32 B = A + 1; B < Boxes.size(); ++B)
+            {
+                if (Overlap(Boxes[A], Boxes[B]))
+                {
+                    Result.push_back(uint64(A) << 32 | B);
+                }
+            }
+        }
+        return Result;
+    }
+
+    // sorted, to compare with the brute force; false if a pair is not ordered
+    bool Collect(const PairBuffer& Output, Pairs& Result)
+    {
+        auto IsOrdered = true;
+        Result.clear();
+        for (uint32 Index = 0; Index < Output.GetStoredCount(); ++Index)
+        {
+            IsOrdered = IsOrdered && Output.Pairs[Index].A < Output.Pairs[Index].B;
+            Result.push_back(uint64(Output.Pairs[Index].A) << 32 | Output.Pairs[Index].B);
+        }
+        std::sort(Result.begin(), Result.end());
+        return IsOrdered;
+    }
+} // namespace
+
+void BroadphaseTests()
+{
+    std::vector<uint8>    Memory(32 << 20);
+    MemoryArena           Arena{ Memory.data(), Memory.size() };
+    ThreadPoolJobSystem   Jobs{ 3 };
+    std::vector<BodyPair> Storage(200000);
+    PairBuffer            Output{ Storage.data(), uint32(Storage.size()) };
+    Pairs                 Found;
+
+    // 20000 boxes: the grid and the sweep cut them in several batches
+    constexpr uint32 Count    = 20000;
+    auto             Boxes    = MakeBoxes(Count, 1);
+    auto             Expected = BruteForce(Boxes);
+    CHECK_TRUE(Expected.size() > Count);
+
+    // 6 bits of hash: many cells share a bucket
+    for (uint32 TableBits : { 6u, 20u })
+    {
+        HashGrid Grid{ Arena, Count, 8 * Count, 4.0f, TableBits };
+        for (JobSystem* Parallel : { static_cast<JobSystem*>(&Jobs), static_cast<JobSystem*>(nullptr) })
+        {
+            Output.Count = 0;
+            Grid.Build(Boxes.data(), Count, Parallel);
+            Grid.FindPairs(Output, Parallel);
+            CHECK_TRUE(Collect(Output, Found));
+            CHECK_TRUE(Found == Expected);
+            CHECK_EQ(Grid.GetDroppedCount(), 0u);
+        }
+    }
+
+    // sweep and prune: built, then updated after small moves, after box removal and after a shuffle
+    SweepAndPrune Sweep{ Arena, Count, 4 * Count, 8.0f };
+    Output.Count = 0;
+    Sweep.Update(Boxes.data(), Count, &Jobs);
+    Sweep.FindPairs(Output, &Jobs);
+    CHECK_TRUE(Collect(Output, Found));
+    CHECK_TRUE(Found == Expected);
+    CHECK_EQ(Sweep.GetRebuildCount(), 1u);
+
+    uint32 Seed = 5;
+    for (auto& Box : Boxes)
+    {
+        auto Move = v2{ real32(Random(Seed) % 100) / 1000.0f, -real32(Random(Seed) % 100) / 1000.0f };
+        Box.Min   = Box.Min + Move;
+        Box.Max   = Box.Max + Move;
+    }
+    Output.Count = 0;
+    Sweep.Update(Boxes.data(), Count, &Jobs);
+    Sweep.FindPairs(Output, &Jobs);
+    CHECK_TRUE(Collect(Output, Found));
+    CHECK_TRUE(Found == BruteForce(Boxes));
+    CHECK_EQ(Sweep.GetRebuildCount(), 1u);
+
+    Boxes.resize(Count / 2);
+    Output.Count = 0;
+    Sweep.Update(Boxes.data(), Count / 2);
+    Sweep.FindPairs(Output);
+    CHECK_TRUE(Collect(Output, Found));
+    CHECK_TRUE(Found == BruteForce(Boxes));
+
+    std::reverse(Boxes.begin(), Boxes.end());
+    Output.Count = 0;
+    Sweep.Update(Boxes.data(), Count / 2, &Jobs);
+    Sweep.FindPairs(Output, &Jobs);
+    CHECK_TRUE(Collect(Output, Found));
+    CHECK_TRUE(Found == BruteForce(Boxes));
+    CHECK_EQ(Sweep.GetRebuildCount(), 2u);
+
+    // full buffer: the count tells the size needed
+    PairBuffer Small{ Storage.data(), 100 };
+    Sweep.FindPairs(Small, &Jobs);
+    CHECK_TRUE(Small.IsOverflowing());
+    CHECK_EQ(Small.GetStoredCount(), 100u);
+    CHECK_EQ(Small.Count.load(), uint32(Found.size()));
+
+    // too many cells: dropped, counted
+    HashGrid Tiny{ Arena, 10, 4, 1.0f, 4 };
+    Aabb     Big = { { 0, 0 }, { 2.5f, 2.5f } };
+    Tiny.Build(&Big, 1);
+    CHECK_EQ(Tiny.GetEntryCount(), 4u);
+    CHECK_EQ(Tiny.GetDroppedCount(), 5u);
+
+    SweepAndPrune Narrow{ Arena, 10, 2, 1.0f };
+    Narrow.Update(&Big, 1);
+    CHECK_EQ(Narrow.GetEntryCount(), 2u);
+    CHECK_EQ(Narrow.GetDroppedCount(), 1u);
+    Big.Max.Y = 1.5f;
+    Narrow.Update(&Big, 1);
+    CHECK_EQ(Narrow.GetEntryCount(), 2u);
+    CHECK_EQ(Narrow.GetDroppedCount(), 0u);
+
+    // 32 bits of hash: clamped to a bucket mask which fits
+    HashGrid Wide{ Arena, 10, 32, 1.0f, 32 };
+    Aabb     Square = { { 0, 0 }, { 2.5f, 2.5f } };
+    Aabb     Pair[] = { Square, Square };
+    Output.Count    = 0;
+    Wide.Build(Pair, 2);
+    Wide.FindPairs(Output);
+    CHECK_EQ(Wide.GetEntryCount(), 18u);
+    CHECK_EQ(Output.GetStoredCount(), 1u);
+
+    // an arena too small: no capacity, nothing built nor found
+    std::vector<uint8> Few(256);
+    MemoryArena        SmallArena{ Few.data(), Few.size() };
+    HashGrid           StarvedGrid{ SmallArena, Count, 8 * Count, 4.0f };
+    SweepAndPrune      StarvedSweep{ SmallArena, Count, 4 * Count, 8.0f };
+    CHECK_FALSE(StarvedGrid.IsValid());
+    CHECK_FALSE(StarvedSweep.IsValid());
+    Output.Count = 0;
+    StarvedGrid.Build(Boxes.data(), uint32(Boxes.size()));
+    StarvedGrid.FindPairs(Output);
+    StarvedSweep.Update(Boxes.data(), uint32(Boxes.size()));
+    StarvedSweep.FindPairs(Output);
+    CHECK_EQ(StarvedGrid.GetEntryCount(), 0u);
+    CHECK_EQ(StarvedSweep.GetEntryCount(), 0u);
+    CHECK_EQ(Output.Count.load(), 0u);
+}
@@ -0,0 +1,111 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <debug_overlay.hpp>
+
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    struct TestBuffer
+    {
+        TestBuffer(int32 Width, int32 Height, uint32 Color)
+            : Pixels(size_t(Width) * Height, Color)
+            , Buffer{ Pixels.data(), Width, Height, 4, Width * 4 }
+        {}
+
+        uint32 Get(int32 X, int32 Y) const { return Pixels[size_t(Y) * Buffer.Width + X]; }
+
+        std::vector<uint32> Pixels;
+        PIBackBuffer        Buffer;
+    };
+} // namespace
+
+void DebugOverlayTests()
+{
+    std::vector<uint8> Memory(1 << 20);
+    MemoryArena        Arena{ Memory.data(), Memory.size() };
+
+    // text alone: the glyph bits, top row in bit 0, opaque colors replace the pixels
+    {
+        DebugOverlay Overlay{ Arena };
+        TestBuffer   Target{ 32, 16, 0 };
+        CHECK_TRUE(Overlay.IsValid());
+        Overlay.PushText(2, 3, "T!", 0xFFFFFFFF);
+        Overlay.End(Target.Buffer);
+        uint32 Lit = 0;
+        for (auto Pixel : Target.Pixels)
+        {
+            Lit += Pixel != 0;
+        }
+        // 'T': a row of 5 then a column of 6, '!': a column of 5 and a dot
+        CHECK_EQ(Lit, 17u);
+        CHECK_EQ(Target.Get(2, 3), 0xFFFFFFFFu);
+        CHECK_EQ(Target.Get(4, 9), 0xFFFFFFFFu);
+        CHECK_EQ(Target.Get(2, 4), 0u);
+        CHECK_EQ(Target.Get(10, 3), 0xFFFFFFFFu);
+        CHECK_EQ(Target.Get(10, 8), 0u);
+        CHECK_EQ(Target.Get(10, 9), 0xFFFFFFFFu);
+    }
+
+    // a panel: the background blended, the frame bars colored by their time, the usage bar filled by its share
+    {
+        DebugOverlay Overlay{ Arena };
+        TestBuffer   Target{ 320, 200, 0x00C8C8C8 };
+        for (auto Time : { 10.0f, 40.0f, 80.0f })
+        {
+            Overlay.AddFrameTime(Time);
+        }
+        Overlay.Begin(10, 10, 264);
+        Overlay.AddFrameGraph(33.0f, 99);
+        Overlay.AddUsageBar("arena", 512 * 1024, 1024 * 1024);
+        Overlay.End(Target.Buffer);
+
+        // outside, and in the margin
+        CHECK_EQ(Target.Get(5, 5), 0x00C8C8C8u);
+        CHECK_EQ(Target.Get(11, 11), Blit::BlendPixel(DebugDrawing::Background, 0x00C8C8C8));
+        // the graph starts under the line of text, the bars are one pixel wide, the last frame on the right
+        auto Bottom = 10 + 4 + DebugDrawing::LineHeight + 99 - 1;
+        auto First  = Target.Get(14, Bottom);
+        auto Second = Target.Get(15, Bottom);
+        auto Third  = Target.Get(16, Bottom);
+        auto Past   = Target.Get(17, Bottom);
+        CHECK_EQ(First, DebugDrawing::Green);
+        CHECK_EQ(Second, DebugDrawing::Yellow);
+        CHECK_EQ(Third, DebugDrawing::Red);
+        CHECK_TRUE(Past != DebugDrawing::Red);
+        // 10 ms of 99 pixels for 99 ms: 10 pixels
+        CHECK_EQ(Target.Get(14, Bottom - 9), DebugDrawing::Green);
+        CHECK_TRUE(Target.Get(14, Bottom - 10) != DebugDrawing::Green);
+        // half the usage bar
+        auto BarY = Bottom + 1 + 4 + DebugDrawing::LineHeight;
+        CHECK_EQ(Target.Get(14 + 127, BarY), DebugDrawing::Green);
+        CHECK_TRUE(Target.Get(14 + 128, BarY) != DebugDrawing::Green);
+    }
+
+    // clipped by the buffer, and a batch too small
+    {
+        DebugOverlay  Overlay{ Arena, 4, 64 };
+        TestBuffer    Target{ 64, 32, 0 };
+        ProfileRecord Records[3];
+        Records[0].Name           = "update";
+        Records[0].LastCycleCount = 500;
+        Overlay.Begin(40, 20, 100);
+        Overlay.AddProfileBars(Records, 3, 1000);
+        Overlay.PushText(-3, -3, "clipped", DebugDrawing::White);
+        Overlay.End(Target.Buffer);
+        CHECK_EQ(Target.Get(39, 25), 0u);
+        CHECK_TRUE(Target.Get(63, 31) != 0);
+
+        std::vector<uint8> Small(256);
+        MemoryArena        SmallArena{ Small.data(), Small.size() };
+        DebugOverlay       Invalid{ SmallArena };
+        CHECK_FALSE(Invalid.IsValid());
+        Invalid.Begin(0, 0, 10);
+        Invalid.AddText("nothing");
+        Invalid.End(Target.Buffer);
+    }
+}
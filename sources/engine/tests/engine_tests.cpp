@@ -0,0 +1,36 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <iostream>
+
+int main()
+{
+    AudioLatencyTests();
+    AssetPackTests();
+    FileServiceTests();
+    BlitTests();
+    RenderCommandsTests();
+    RasterizerTests();
+    TileMapTests();
+    MathTests();
+    EntitiesTests();
+    ParticlesTests();
+    BroadphaseTests();
+    PathfindingTests();
+    PackedInputsTests();
+    SnapshotTests();
+    LoggerTests();
+    FormatTests();
+    InternedStringTests();
+    FlatHashMapTests();
+    SerializationTests();
+    MetricsTests();
+    DebugOverlayTests();
+    BitmapFontTests();
+    PixelFormatTests();
+    AudioDspTests();
+
+    tdd::PrintTestResults([](const char* line) { std::cout << line << std::endl; });
+    return tdd::FailureCount ? 1 : 0;
+}
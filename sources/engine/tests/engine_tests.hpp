@@ -0,0 +1,27 @@
+#pragma once
+
+// one entry point per tested module, called by main
+void AudioLatencyTests();
+void AssetPackTests();
+void FileServiceTests();
+void BlitTests();
+void RenderCommandsTests();
+void RasterizerTests();
+void TileMapTests();
+void MathTests();
+void EntitiesTests();
+void ParticlesTests();
+void BroadphaseTests();
+void PathfindingTests();
+void PackedInputsTests();
+void SnapshotTests();
+void LoggerTests();
+void FormatTests();
+void InternedStringTests();
+void FlatHashMapTests();
+void SerializationTests();
+void MetricsTests();
+void DebugOverlayTests();
+void BitmapFontTests();
+void PixelFormatTests();
+void AudioDspTests();
@@ -0,0 +1,147 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <entities.hpp>
+
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    struct Position
+    {
+        real32 X, Y;
+    };
+
+    struct Velocity
+    {
+        real32 X, Y;
+    };
+
+    struct Health
+    {
+        int32 Value;
+    };
+
+    struct Prop
+    {
+    };
+
+    using Store = EntityStore<Position, Velocity, Health, Prop>;
+
+    real32 SumX(Store& Entities)
+    {
+        real32 Sum = 0;
+        Entities.ForEach<const Position>([&Sum](const Position& P) { Sum += P.X; });
+        return Sum;
+    }
+} // namespace
+
+void EntitiesTests()
+{
+    std::vector<uint8> Memory(64 << 20);
+    MemoryArena        Arena{ Memory.data(), Memory.size() };
+    Store              Entities{ Arena, 10000 };
+    CHECK_TRUE(Entities.IsValid());
+
+    // creation and archetypes
+    auto Moving = Entities.Create(Position{ 1, 2 }, Velocity{ 10, 20 });
+    auto Still  = Entities.Create(Position{ 100, 0 });
+    auto Box    = Entities.Create(Position{ 1000, 0 }, Prop{});
+    CHECK_EQ(Entities.GetEntityCount(), 3u);
+    CHECK_EQ(Entities.GetArchetypeCount(), 3u);
+    CHECK_EQ(Entities.Count<Position>(), 3u);
+    CHECK_EQ(Entities.Count<Prop>(), 1u);
+    CHECK_EQ((Entities.Count<Position, Velocity>()), 1u);
+    CHECK_TRUE(Entities.Has<Prop>(Box));
+    CHECK_TRUE(!Entities.Has<Prop>(Still));
+    CHECK_TRUE(Entities.Get<Velocity>(Still) == nullptr);
+    CHECK_EQ(Entities.Get<Position>(Moving)->Y, 2.0f);
+
+    // queries visit the matching archetypes only
+    Entities.ForEach<Position, const Velocity>([](Position& P, const Velocity& V) {
+        P.X += V.X;
+        P.Y += V.Y;
+    });
+    CHECK_EQ(Entities.Get<Position>(Moving)->X, 11.0f);
+    CHECK_EQ(Entities.Get<Position>(Still)->X, 100.0f);
+    CHECK_EQ(SumX(Entities), 1111.0f);
+    uint32 PropCount = 0;
+    Entities.ForEach<Prop, Position>([&PropCount](Prop&, Position& P) { PropCount += P.X == 1000.0f; });
+    CHECK_EQ(PropCount, 1u);
+
+    // adding and removing components moves the entity, handles stay valid
+    CHECK_TRUE(Entities.Add(Still, Health{ 5 }));
+    CHECK_TRUE(Entities.Add(Still, Health{ 7 }));
+    CHECK_EQ(Entities.Get<Health>(Still)->Value, 7);
+    CHECK_EQ(Entities.Get<Position>(Still)->X, 100.0f);
+    CHECK_TRUE(Entities.Remove<Velocity>(Moving));
+    CHECK_TRUE(!Entities.Remove<Velocity>(Moving));
+    CHECK_EQ(Entities.Get<Position>(Moving)->X, 11.0f);
+    CHECK_EQ(Entities.Count<Velocity>(), 0u);
+    CHECK_EQ(SumX(Entities), 1111.0f);
+
+    // destroyed handles are dead even when their index is reused
+    Entities.Destroy(Moving);
+    CHECK_TRUE(!Entities.IsAlive(Moving));
+    CHECK_TRUE(Entities.Get<Position>(Moving) == nullptr);
+    auto Reused = Entities.Create(Position{ 5, 5 });
+    CHECK_EQ(Reused.Index, Moving.Index);
+    CHECK_TRUE(!Entities.IsAlive(Moving));
+    CHECK_TRUE(Entities.IsAlive(Reused));
+    CHECK_EQ(Entities.GetEntityCount(), 3u);
+
+    // many chunks: swap removal keeps every row addressable, parallel and serial queries agree
+    std::vector<Entity> Handles;
+    for (int32 Index = 0; Index < 9000; ++Index)
+    {
+        Handles.push_back(Entities.Create(Position{ real32(Index), 0 }, Velocity{ 1, 0 }, Health{ Index }));
+    }
+    for (size_t Index = 0; Index < Handles.size(); Index += 3)
+    {
+        Entities.Destroy(Handles[Index]);
+    }
+    int32 Wrong = 0;
+    for (size_t Index = 1; Index < Handles.size(); Index += 3)
+    {
+        auto P = Entities.Get<Position>(Handles[Index]);
+        Wrong += !P || P->X != real32(Entities.Get<Health>(Handles[Index])->Value);
+    }
+    CHECK_EQ(Wrong, 0);
+    CHECK_EQ(Entities.Count<Velocity>(), 6000u);
+
+    ThreadPoolJobSystem Jobs{ 3 };
+    Entities.ParallelForEach<Position, const Velocity>(&Jobs, [](Position& P, const Velocity& V) { P.X += V.X; });
+    uint32 ChunkCount = 0;
+    Entities.ForEachChunk<const Position, const Health, const Velocity>(
+        [&](uint32 Count, const Entity*, const Position* P, const Health* H, const Velocity*) {
+            ++ChunkCount;
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                Wrong += P[Index].X != real32(H[Index].Value + 1);
+            }
+        });
+    CHECK_EQ(Wrong, 0);
+    CHECK_EQ(ChunkCount, 2u);
+
+    // full store
+    Store Small{ Arena, 2 };
+    auto  First = Small.Create(Position{});
+    Small.Destroy(First);
+    Small.Create(Position{});
+    Small.Create(Position{});
+    CHECK_TRUE(Small.Create(Position{}) == InvalidEntity);
+    CHECK_TRUE(Small.Create(Velocity{}) == InvalidEntity);
+    CHECK_EQ(Small.GetArchetypeCount(), 1u);
+
+    // a tag has a single value whatever the row
+    for (uint32 Index = 0; Index < 3000; ++Index)
+    {
+        Entities.Create(Prop{});
+    }
+    auto Tagged = Entities.Create(Prop{});
+    CHECK_TRUE(Entities.Get<Prop>(Tagged) != nullptr);
+    CHECK_TRUE(Entities.Get<Prop>(Tagged) == Entities.Get<Prop>(Box));
+}
@@ -0,0 +1,123 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <file_service.hpp>
+
+#if !_WIN32
+#include "../linux/io_uring_file_service.hpp"
+#endif
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+using namespace Game;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // reads complete at a later frame, with their user data, short reads fail
+    void CheckReads(FileService& Service, const fs::path& Path)
+    {
+        std::vector<uint8> Buffers(200000);
+        MemoryArena        Reads{ Buffers.data(), Buffers.size() };
+
+        uint64 Size = 0;
+        auto   File = Service.OpenForRead(Path.string().c_str(), &Size);
+        CHECK_TRUE(File != InvalidFileHandle);
+        CHECK_EQ(Size, 100000u);
+        CHECK_TRUE(Service.OpenForRead("engine_tests_missing_file.bin", &Size) == InvalidFileHandle);
+
+        FileReadRequest Requests[] = {
+            PushRead(Reads, File, 0, 4096, 10),
+            PushRead(Reads, File, 50000, 20000, 11),
+            PushRead(Reads, File, 99000, 4096, 12), // past the end
+            PushRead(Reads, InvalidFileHandle, 0, 16, 13),
+        };
+        auto Accepted = Service.SubmitReads(Requests, 4);
+        CHECK_EQ(Accepted, 4u);
+        CHECK_EQ(Service.GetCompletionCount(), 0u);
+
+        std::vector<FileReadCompletion> Completions;
+        for (int Frame = 0; Frame < 1000 && Completions.size() < 4; ++Frame)
+        {
+            Service.BeginFrame();
+            for (uint32 Index = 0; Index < Service.GetCompletionCount(); ++Index)
+            {
+                Completions.push_back(Service.GetCompletion(Index));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK_EQ(Completions.size(), 4u);
+        CHECK_EQ(Service.GetInFlightCount(), 0u);
+
+        int Succeeded = 0;
+        for (auto& Completion : Completions)
+        {
+            auto& Request = Requests[Completion.UserData - 10];
+            if (Completion.Succeeded)
+            {
+                auto Content = static_cast<const uint8*>(Request.Destination);
+                bool IsSame  = true;
+                for (uint32 Index = 0; Index < Request.Size; ++Index)
+                {
+                    IsSame &= Content[Index] == static_cast<uint8>((Request.Offset + Index) * 7);
+                }
+                Succeeded += IsSame;
+            }
+            else if (Completion.UserData == 12)
+            {
+                CHECK_EQ(Completion.BytesRead, 1000u);
+            }
+        }
+        CHECK_EQ(Succeeded, 2);
+
+        Service.Close(File);
+    }
+} // namespace
+
+void FileServiceTests()
+{
+    // arena: aligned pushes, null when full, temporary memory rolls back
+    alignas(64) uint8 Storage[1024];
+    MemoryArena       Arena{ Storage, sizeof(Storage) };
+    auto              First  = reinterpret_cast<uintptr_t>(Arena.Push(3, 64));
+    auto              Second = reinterpret_cast<uintptr_t>(Arena.Push(1, 64));
+    CHECK_EQ(First % 64, 0u);
+    CHECK_EQ(Second - First, 64u);
+    CHECK_EQ(Arena.GetUsed(), 65u);
+    {
+        TemporaryMemory Temporary{ Arena };
+        auto            Pushed = Arena.Push(512);
+        CHECK_TRUE(Pushed != nullptr);
+    }
+    CHECK_EQ(Arena.GetUsed(), 65u);
+    auto TooBig = Arena.Push(2048);
+    CHECK_TRUE(TooBig == nullptr);
+
+    auto Path = fs::temp_directory_path() / "engine_tests_file_service.bin";
+    {
+        std::vector<char> Data(100000);
+        for (size_t Index = 0; Index < Data.size(); ++Index)
+        {
+            Data[Index] = static_cast<char>(Index * 7);
+        }
+        std::ofstream{ Path, std::ios::binary }.write(Data.data(), Data.size());
+    }
+
+    ThreadPoolFileService Service;
+    CheckReads(Service, Path);
+#if !_WIN32
+    Linux::IoUringFileService Ring;
+    if (Ring.IsValid()) // not with a kernel before 5.6 or io_uring disabled
+    {
+        CheckReads(Ring, Path);
+    }
+#endif
+    fs::remove(Path);
+}
@@ -0,0 +1,166 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <flat_hash_map.hpp>
+#include <interned_string.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    // every key in the same group, and the same H2: the probes and the key compares do all the work
+    struct CollidingHash
+    {
+        uint64 operator()(uint32) const { return 0x1234; }
+    };
+} // namespace
+
+void FlatHashMapTests()
+{
+    std::vector<uint8> Memory(8 << 20);
+    MemoryArena        Arena{ Memory.data(), Memory.size() };
+
+    // insert, replace, find, remove
+    {
+        FlatHashMap<uint32, uint32> Map{ Arena, 100 };
+        CHECK_TRUE(Map.IsValid());
+        CHECK_GE(Map.GetCapacity(), 100u);
+        CHECK_TRUE(Map.Find(7) == nullptr);
+        CHECK_TRUE(Map.Insert(7, 70));
+        CHECK_TRUE(Map.Insert(8, 80));
+        CHECK_TRUE(Map.Insert(7, 71));
+        CHECK_EQ(Map.GetCount(), 2u);
+        auto Seven = Map.Find(7);
+        CHECK_TRUE(Seven && *Seven == 71);
+        CHECK_TRUE(Map.Contains(8));
+        *Map.FindOrInsert(9) += 5;
+        auto Nine = Map.Find(9);
+        CHECK_TRUE(Nine && *Nine == 5);
+        CHECK_TRUE(Map.Remove(8));
+        CHECK_FALSE(Map.Remove(8));
+        CHECK_FALSE(Map.Contains(8));
+        CHECK_EQ(Map.GetCount(), 2u);
+
+        uint32 Sum = 0;
+        Map.ForEach([&](uint32 Key, uint32& Value) { Sum += Key + Value; });
+        CHECK_EQ(Sum, 7u + 71u + 9u + 5u);
+        Map.Clear();
+        CHECK_EQ(Map.GetCount(), 0u);
+        CHECK_FALSE(Map.Contains(7));
+    }
+
+    // full at the capacity, too small an arena
+    {
+        FlatHashMap<uint32, uint32> Map{ Arena, 10 };
+        uint32                      Inserted = 0;
+        for (uint32 Key = 0; Key < 20; ++Key)
+        {
+            Inserted += Map.Insert(Key, Key);
+        }
+        CHECK_EQ(Inserted, Map.GetCapacity());
+        CHECK_TRUE(Map.Insert(3, 33)); // replacing needs no room
+
+        std::vector<uint8>          Small(256);
+        MemoryArena                 SmallArena{ Small.data(), Small.size() };
+        FlatHashMap<uint64, uint64> Invalid{ SmallArena, 1000 };
+        CHECK_FALSE(Invalid.IsValid());
+        CHECK_FALSE(Invalid.Insert(1, 1));
+        CHECK_TRUE(Invalid.Find(1) == nullptr);
+    }
+
+    // probes through full groups: all the keys collide
+    {
+        FlatHashMap<uint32, uint32, CollidingHash> Map{ Arena, 100 };
+        for (uint32 Key = 0; Key < 60; ++Key)
+        {
+            Map.Insert(Key, Key * 2);
+        }
+        uint32 Found = 0;
+        for (uint32 Key = 0; Key < 60; Key += 3)
+        {
+            Map.Remove(Key);
+        }
+        for (uint32 Key = 0; Key < 60; ++Key)
+        {
+            auto Value = Map.Find(Key);
+            Found += Key % 3 ? Value && *Value == Key * 2 : Value == nullptr;
+        }
+        CHECK_EQ(Found, 60u);
+
+        // one full group: the removals leave tombstones, dropped by the next insertion
+        FlatHashMap<uint32, uint32, CollidingHash> Small{ Arena, 14 };
+        for (uint32 Key = 0; Key < 14; ++Key)
+        {
+            Small.Insert(Key, Key);
+        }
+        for (uint32 Key = 0; Key < 14; Key += 2)
+        {
+            Small.Remove(Key);
+        }
+        uint32 Inserted = 0;
+        for (uint32 Key = 100; Key < 107; ++Key)
+        {
+            Inserted += Small.Insert(Key, Key);
+        }
+        CHECK_EQ(Inserted, 7u);
+        uint32 Kept = 0;
+        for (uint32 Key = 1; Key < 14; Key += 2)
+        {
+            auto Value = Small.Find(Key);
+            Kept += Value && *Value == Key;
+        }
+        CHECK_EQ(Kept, 7u);
+    }
+
+    // random operations against std::unordered_map, with enough removals to drop the tombstones
+    {
+        FlatHashMap<uint64, uint32>        Map{ Arena, 3000 };
+        std::unordered_map<uint64, uint32> Expected;
+        uint32                             Seed       = 5;
+        uint32                             Mismatches = 0;
+        for (uint32 Operation = 0; Operation < 200000; ++Operation)
+        {
+            Seed     = Seed * 1664525u + 1013904223u;
+            auto Key = uint64(Seed >> 20) * 0x9E3779B97F4A7C15ULL; // 4096 keys
+            switch ((Seed >> 8) % 3)
+            {
+            case 0:
+                if (Expected.size() < Map.GetCapacity() || Expected.count(Key))
+                {
+                    Mismatches += !Map.Insert(Key, Operation);
+                    Expected[Key] = Operation;
+                }
+                break;
+            case 1:
+                Mismatches += Map.Remove(Key) != (Expected.erase(Key) == 1);
+                break;
+            default:
+            {
+                auto Value = Map.Find(Key);
+                auto Other = Expected.find(Key);
+                Mismatches += (Value != nullptr) != (Other != Expected.end()) || (Value && *Value != Other->second);
+            }
+            }
+        }
+        CHECK_EQ(Mismatches, 0u);
+        CHECK_EQ(size_t(Map.GetCount()), Expected.size());
+        uint32 Listed = 0;
+        Map.ForEach([&](uint64 Key, uint32 Value) { Listed += Expected.count(Key) && Expected[Key] == Value; });
+        CHECK_EQ(size_t(Listed), Expected.size());
+    }
+
+    // interned names as keys, the stored hash reused
+    {
+        StringTable                         Names{ Arena, 256, 4096 };
+        FlatHashMap<InternedString, uint32> Map{ Arena, 64 };
+        Map.Insert(InternedString{ Names, "player" }, 1);
+        Map.Insert(InternedString{ Names, "enemy" }, 2);
+        auto Player = Map.Find(InternedString{ Names, "player" });
+        CHECK_TRUE(Player && *Player == 1);
+        CHECK_FALSE(Map.Contains(InternedString{ Names, "boss" }));
+    }
+}
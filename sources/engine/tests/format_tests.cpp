@@ -0,0 +1,154 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <format.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    enum class Color : uint8
+    {
+        Red,
+        Green
+    };
+
+    struct Point
+    {
+        int32 X;
+        int32 Y;
+    };
+
+    void FormatValue(FormatBuffer& Out, const Point& Value, const FormatSpec&)
+    {
+        Format(Out, GAME_FORMAT_STRING("({}, {})"), Value.X, Value.Y);
+    }
+
+    // the format strings are checked at compile time
+    static_assert(Formatting::Parse("a {} b {:>8.3f} {{c}}").IsValid);
+    static_assert(Formatting::Parse("a {} b {:>8.3f} {{c}}").ArgumentCount == 2);
+    static_assert(Formatting::Parse("a {} b {:>8.3f} {{c}}").Specs[1].Width == 8);
+    static_assert(!Formatting::Parse("{").IsValid);
+    static_assert(!Formatting::Parse("}").IsValid);
+    static_assert(!Formatting::Parse("{:q}").IsValid);
+    static_assert(!Formatting::Parse("{:.}").IsValid);
+    static_assert(!Formatting::Parse("{0}").IsValid);
+    static_assert(!Formatting::IsCompatible(Formatting::Category::String, { ' ', 0, false, false, 0, -1, 'f' }));
+    static_assert(!Formatting::IsCompatible(Formatting::Category::Integer, { ' ', 0, false, false, 0, 2, 0 }));
+} // namespace
+
+void FormatTests()
+{
+    char Text[128];
+
+    // integers, specs
+    {
+        auto Lowest = int64(-9223372036854775807 - 1);
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{} {} {} {}"), 0, -1, 18446744073709551615ULL, Lowest),
+                 std::string_view{ "0 -1 18446744073709551615 -9223372036854775808" });
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{:x} {:X} {:b} {:+d} {:c}"), 255, 255u, 5, 3, 65),
+                 std::string_view{ "ff FF 101 +3 A" });
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("[{:5}] [{:<5}] [{:^6}] [{:*>4}] [{:05}] [{:08x}]"), 42, 42, 42, 7,
+                        -42, 0xBEEFu),
+                 std::string_view{ "[   42] [42   ] [  42  ] [***7] [-0042] [0000beef]" });
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{} {} {:d}"), Color::Green, uint8(200), int8(-5)),
+                 std::string_view{ "1 200 -5" });
+    }
+
+    // floats
+    {
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{} {} {} {} {}"), 0.0, 1.5f, -0.1, 100.0, 0.000123),
+                 std::string_view{ "0 1.5 -0.1 100 0.000123" });
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{:.2f} {:.0f} {:f} {:.12f} {:8.3f}"), 3.14159, 2.5, 1.0, 0.5, -1.0),
+                 std::string_view{ "3.14 2 1.000000 0.500000000000   -1.000" });
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{:e} {:.2e} {} {} {:e}"), 12345.678, 0.000999, 1e20, -2.5e-7, 0.0),
+                 std::string_view{ "1.234568e+04 9.99e-04 1e+20 -2.5e-07 0.000000e+00" });
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{} {} {:+.1f} {:09.3f}"), 1.0 / 0.0, std::nan(""), 2.0, -3.14159),
+                 std::string_view{ "inf nan +2.0 -0003.142" });
+
+        // the digits agree with printf where the fast path is exact
+        uint32 Seed  = 1;
+        uint32 Wrong = 0;
+        char   Expected[64];
+        for (uint32 Index = 0; Index < 2000; ++Index)
+        {
+            Seed       = Seed * 1664525u + 1013904223u;
+            auto Value = (double(Seed) - 2147483648.0) / double(1 << (Seed % 24));
+            snprintf(Expected, sizeof(Expected), "%.3f", Value);
+            Wrong += Format(Text, GAME_FORMAT_STRING("{:.3f}"), Value) != std::string_view{ Expected };
+            snprintf(Expected, sizeof(Expected), "%.5e", Value);
+            Wrong += Format(Text, GAME_FORMAT_STRING("{:.5e}"), Value) != std::string_view{ Expected };
+        }
+        CHECK_EQ(Wrong, 0u);
+
+        // near the halves, where scaling in double would round twice, and the exact halves (ties to even)
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{:.3f} {:.1f} {:.0f} {:.0f} {:.2f}"), 555.89850000000001, 0.25, 0.5,
+                        1.5, 1.005),
+                 std::string_view{ "555.899 0.2 0 2 1.00" });
+        Wrong = 0;
+        for (uint32 Index = 0; Index < 20000; ++Index)
+        {
+            Seed       = Seed * 1664525u + 1013904223u;
+            auto Value = double(Seed % 10000000) / 1000.0 + 0.0005;
+            for (auto Neighbour : { std::nextafter(Value, 0.0), Value, std::nextafter(Value, 1e9) })
+            {
+                snprintf(Expected, sizeof(Expected), "%.3f", Neighbour);
+                Wrong += Format(Text, GAME_FORMAT_STRING("{:.3f}"), Neighbour) != std::string_view{ Expected };
+            }
+            auto Tiny = double(Seed) * 1e-15 + 5e-10;
+            snprintf(Expected, sizeof(Expected), "%.9f", Tiny);
+            Wrong += Format(Text, GAME_FORMAT_STRING("{:.9f}"), Tiny) != std::string_view{ Expected };
+        }
+        CHECK_EQ(Wrong, 0u);
+
+        // fixed point up to 1e15 whatever the decimals
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{} {} {}"), 123456789012345.0, 999999999999999.9, 1e15),
+                 std::string_view{ "123456789012345 999999999999999.875 1e+15" });
+    }
+
+    // strings, characters, booleans, pointers, custom types
+    {
+        std::string Owned = "owned";
+        const char* Null  = nullptr;
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{} {} {} {} {}"), "literal", Owned, std::string_view{ "view" }, Null,
+                        'c'),
+                 std::string_view{ "literal owned view (null) c" });
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("[{:>6}] [{:.3}] [{:-^7}] {} {:d}"), "ab", "abcdef", "mid", true,
+                        false),
+                 std::string_view{ "[    ab] [abc] [--mid--] true 0" });
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{} {:p}"), reinterpret_cast<void*>(0x1234), nullptr),
+                 std::string_view{ "0x1234 0x0" });
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("{{{}}} at {}"), 5, Point{ 1, -2 }),
+                 std::string_view{ "{5} at (1, -2)" });
+        CHECK_EQ(Format(Text, GAME_FORMAT_STRING("no arguments")), std::string_view{ "no arguments" });
+    }
+
+    // truncation: the buffer, an array, an arena
+    {
+        char         Small[8];
+        FormatBuffer Out = { Small, 4 };
+        Format(Out, GAME_FORMAT_STRING("{}"), 123456);
+        CHECK_TRUE(Out.IsTruncated);
+        CHECK_EQ(Out.GetText(), std::string_view{ "1234" });
+
+        auto Line = Format(Small, GAME_FORMAT_STRING("{:>10}"), 1);
+        CHECK_EQ(Line.size(), 7u);
+        CHECK_EQ(Small[7], 0);
+
+        std::vector<uint8> Memory(16);
+        MemoryArena        Arena{ Memory.data(), Memory.size() };
+        auto               First = Format(Arena, GAME_FORMAT_STRING("{}-{}"), 12, 34);
+        CHECK_EQ(First, std::string_view{ "12-34" });
+        CHECK_EQ(Arena.GetUsed(), 6u);
+        CHECK_EQ(First.data()[5], 0);
+        CHECK_TRUE(Format(Arena, GAME_FORMAT_STRING("{}"), 1234567890123ULL).empty());
+        CHECK_EQ(Arena.GetUsed(), 6u);
+    }
+}
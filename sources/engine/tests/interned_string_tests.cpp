@@ -0,0 +1,163 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <interned_string.hpp>
+
+#if !_WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace Game;
+
+// the hash of a literal is a constant
+static_assert(StringKey{ "player" }.Hash == HashBytes("player", 6));
+static_assert(StringKey{ "" }.Text.empty());
+
+void InternedStringTests()
+{
+    std::vector<uint8> Memory(1 << 20);
+    MemoryArena        Arena{ Memory.data(), Memory.size() };
+    StringTable        Table{ Arena, 1024, 64 * 1024 };
+    CHECK_TRUE(Table.IsValid());
+    auto Previous = GetStringTable();
+    SetStringTable(&Table);
+
+    // one entry per text, whatever the source
+    {
+        InternedString Literal{ "player" };
+        InternedString Copy{ std::string{ "player" } };
+        InternedString View{ std::string_view{ "player_01", 6 } };
+        InternedString Other{ "enemy" };
+        CHECK_TRUE(Literal == Copy);
+        CHECK_TRUE(Literal == View);
+        CHECK_TRUE(Literal != Other);
+        CHECK_TRUE(GAME_INTERN("player") == Literal);
+        CHECK_EQ(Literal.GetView(), std::string_view{ "player" });
+        CHECK_EQ(std::string{ View.c_str() }, std::string{ "player" });
+        CHECK_EQ(Literal.GetHash(), HashBytes("player", 6));
+        CHECK_EQ(Table.GetCount(), 2u);
+
+        // the text is a copy, the source may go away
+        std::string    Temporary = "temporary";
+        InternedString Kept{ Temporary };
+        Temporary[0] = 'X';
+        CHECK_EQ(Kept.ToString(), std::string{ "temporary" });
+    }
+
+    // the empty string is the default one, in no table
+    {
+        InternedString Default;
+        InternedString Empty{ "" };
+        CHECK_TRUE(Default == Empty);
+        CHECK_TRUE(Default.empty());
+        CHECK_EQ(std::string{ Default.c_str() }, std::string{});
+        CHECK_EQ(Default.size(), size_t(0));
+    }
+
+    // lookups without insertion, an explicit table
+    {
+        CHECK_TRUE(Table.Find(StringKey{ "enemy" }) != nullptr);
+        CHECK_TRUE(Table.Find(StringKey{ "boss" }) == nullptr);
+        std::vector<uint8> OtherMemory(4096);
+        MemoryArena        OtherArena{ OtherMemory.data(), OtherMemory.size() };
+        StringTable        Other{ OtherArena, 16, 1024 };
+        InternedString     Local{ Other, "enemy" };
+        CHECK_TRUE(Local != InternedString{ "enemy" });
+        CHECK_EQ(Local.GetView(), std::string_view{ "enemy" });
+        CHECK_EQ(Other.GetCount(), 1u);
+    }
+
+    // full: 3/4 of the slots, or the pool
+    {
+        std::vector<uint8> SmallMemory(4096);
+        MemoryArena        SmallArena{ SmallMemory.data(), SmallMemory.size() };
+        StringTable        Small{ SmallArena, 8, 1024 };
+        uint32             Added = 0;
+        for (uint32 Index = 0; Index < 8; ++Index)
+        {
+            Added += Small.Intern(StringKey{ std::to_string(Index) }) != nullptr;
+        }
+        CHECK_EQ(Added, 6u);
+        auto Found = Small.Intern(StringKey{ "3" });
+        CHECK_TRUE(Found != nullptr);
+
+        StringTable Tiny{ SmallArena, 8, 48 };
+        std::string Long(30, 'x');
+        auto        First  = Tiny.Intern(StringKey{ "a" });
+        auto        Second = Tiny.Intern(StringKey{ Long });
+        auto        Third  = Tiny.Intern(StringKey{ "b" });
+        auto        Used   = Tiny.GetPoolUsed();
+        CHECK_TRUE(First != nullptr);
+        CHECK_TRUE(Second == nullptr);
+        // the text too long reserved nothing
+        CHECK_TRUE(Third != nullptr);
+        CHECK_EQ(Used, 48u);
+
+        std::vector<uint8> NoMemory(64);
+        MemoryArena        NoArena{ NoMemory.data(), NoMemory.size() };
+        StringTable        Invalid{ NoArena, 1024, 1024 };
+        CHECK_FALSE(Invalid.IsValid());
+        CHECK_TRUE(Invalid.Intern(StringKey{ "a" }) == nullptr);
+    }
+
+    // threads interning the same names agree on every pointer
+    {
+        constexpr uint32                         ThreadCount = 4;
+        constexpr uint32                         NameCount   = 300;
+        std::vector<std::vector<InternedString>> Results(ThreadCount);
+        std::vector<std::thread>                 Threads;
+        for (uint32 Thread = 0; Thread < ThreadCount; ++Thread)
+        {
+            Threads.emplace_back([&Results, Thread] {
+                for (uint32 Index = 0; Index < NameCount; ++Index)
+                {
+                    auto Name = "name_" + std::to_string((Index * 7 + Thread) % NameCount);
+                    Results[Thread].push_back(InternedString{ Name });
+                }
+            });
+        }
+        for (auto& Thread : Threads)
+        {
+            Thread.join();
+        }
+        uint32 Mismatches = 0;
+        for (uint32 Thread = 1; Thread < ThreadCount; ++Thread)
+        {
+            for (uint32 Index = 0; Index < NameCount; ++Index)
+            {
+                auto Expected = (Index * 7 + Thread) % NameCount;
+                auto Found    = InternedString{ "name_" + std::to_string(Expected) };
+                Mismatches += Results[Thread][Index] != Found;
+            }
+        }
+        CHECK_EQ(Mismatches, 0u);
+        std::unordered_set<InternedString> Distinct(Results[0].begin(), Results[0].end());
+        CHECK_EQ(Distinct.size(), size_t(NameCount));
+    }
+
+    // no table set: the empty string
+    SetStringTable(nullptr);
+    InternedString Unset{ "player" };
+    CHECK_TRUE(Unset.empty());
+
+#if !_WIN32 && ENABLE_ASSERT
+    // but GAME_INTERN asserts: its empty string would stay for good
+    auto Child = fork();
+    if (Child == 0)
+    {
+        _exit(GAME_INTERN("no table").empty() ? 1 : 0);
+    }
+    int Status = 0;
+    waitpid(Child, &Status, 0);
+    CHECK_TRUE(WIFSIGNALED(Status));
+#endif
+
+    SetStringTable(Previous);
+}
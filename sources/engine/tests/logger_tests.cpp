@@ -0,0 +1,220 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+// Debug and Trace are compiled out of this file
+#define MIN_LOG_LEVEL 2
+#include <logger.hpp>
+
+#if !_WIN32
+#include "../linux/crash_log.hpp"
+#include <sys/wait.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    enum class Color : uint8
+    {
+        Red,
+        Green
+    };
+
+    void Append(void* Context, const char* Text, uint32 Size)
+    {
+        static_cast<std::string*>(Context)->append(Text, Size);
+    }
+
+    // the messages, without the level, the time and the site
+    std::vector<std::string> GetMessages(const std::string& Text)
+    {
+        std::vector<std::string> Messages;
+        for (size_t Start = 0, End; (End = Text.find('\n', Start)) != std::string::npos; Start = End + 1)
+        {
+            auto Line = Text.substr(Start, End - Start);
+            Messages.push_back(Line.substr(Line.find("): ") + 3));
+        }
+        return Messages;
+    }
+} // namespace
+
+void LoggerTests()
+{
+    std::vector<uint8> Memory(1 << 20);
+    MemoryArena        Arena{ Memory.data(), Memory.size() };
+
+    // arguments, formatted when drained with their specs
+    {
+        Logger      Log{ Arena, 4, 4096 };
+        std::string Text;
+        std::string Long(300, 'x');
+        int32       Value = -42;
+        GAME_LOG(Log, Info, "int {} unsigned {} float {} double {}", Value, 7u, 0.5f, -1234.125);
+        GAME_LOG(Log, Warning, "{} {} {} {}", true, 'c', Color::Green, "text");
+        GAME_LOG(Log, Error, "{:>5}|{:.2f}|{:x}", 1, 2.0 / 3, 255u);
+        GAME_LOG(Log, Debug, "compiled out {}", 1);
+        GAME_LOG(Log, Info, "{}", Long.c_str());
+        GAME_LOG(Log, Info, "{} {}", std::string_view{ "view" }, static_cast<const char*>(nullptr));
+        GAME_LOG(Log, Fatal, "no arguments");
+        auto Count = Log.Drain({ &Text, &Append });
+        CHECK_EQ(Count, 6u);
+
+        auto Messages = GetMessages(Text);
+        CHECK_EQ(Messages.size(), 6u);
+        CHECK_EQ(Messages[0], "int -42 unsigned 7 float 0.5 double -1234.125");
+        CHECK_EQ(Messages[1], "true c 1 text");
+        CHECK_EQ(Messages[2], "    1|0.67|ff");
+        CHECK_EQ(Messages[3], std::string(Logging::MaxStringSize, 'x'));
+        CHECK_EQ(Messages[4], "view (null)");
+        CHECK_EQ(Messages[5], "no arguments");
+        CHECK_EQ(Text.substr(0, 7), "[info] ");
+        CHECK_TRUE(Text.find("logger_tests.cpp(") != std::string::npos);
+
+        Text.clear();
+        Count = Log.Drain({ &Text, &Append });
+        CHECK_EQ(Count, 0u);
+        CHECK_TRUE(Text.empty());
+        CHECK_EQ(Log.GetDroppedCount(), 0u);
+    }
+
+    // a full ring drops, the entries wrap around the end of the ring
+    {
+        Logger      Log{ Arena, 1, 1024 };
+        std::string Text;
+        for (uint32 Index = 0; Index < 100; ++Index)
+        {
+            GAME_LOG(Log, Info, "{}", Index);
+        }
+        auto Count = Log.Drain({ &Text, &Append });
+        CHECK_EQ(Count, 1024u / 32);
+        CHECK_EQ(Log.GetDroppedCount(), 100u - 1024 / 32);
+
+        uint32 Wrong = 0;
+        for (uint32 Round = 0; Round < 50; ++Round)
+        {
+            Text.clear();
+            GAME_LOG(Log, Info, "{} {}", Round, "abc");
+            GAME_LOG(Log, Info, "{}", Round);
+            Log.Drain({ &Text, &Append });
+            Wrong += Text.find(std::to_string(Round) + " abc\n") == std::string::npos;
+        }
+        CHECK_EQ(Wrong, 0u);
+    }
+
+    // threads log while another drains: every entry drained or dropped, in order per thread
+    {
+        constexpr uint32 ThreadCount = 4;
+        constexpr uint32 Count       = 20000;
+        Logger           Log{ Arena, ThreadCount, 64 * 1024 };
+        std::string      Text;
+        std::atomic<int> Running{ ThreadCount };
+
+        std::vector<std::thread> Threads;
+        for (uint32 Thread = 0; Thread < ThreadCount; ++Thread)
+        {
+            Threads.emplace_back([&Log, &Running, Thread] {
+                for (uint32 Index = 0; Index < Count; ++Index)
+                {
+                    GAME_LOG(Log, Info, "{} {}", Thread, Index);
+                }
+                --Running;
+            });
+        }
+        uint32 Drained = 0;
+        while (Running)
+        {
+            Drained += Log.Drain({ &Text, &Append });
+        }
+        for (auto& Thread : Threads)
+        {
+            Thread.join();
+        }
+        Drained += Log.Drain({ &Text, &Append });
+
+        uint32 Next[ThreadCount] = {};
+        uint32 Wrong             = 0;
+        for (auto& Message : GetMessages(Text))
+        {
+            auto Thread = uint32(std::stoul(Message)) % ThreadCount;
+            auto Index  = uint32(std::stoul(Message.substr(Message.find(' '))));
+            Wrong += Index < Next[Thread];
+            Next[Thread] = Index + 1;
+        }
+        CHECK_EQ(Wrong, 0u);
+        CHECK_EQ(Drained + uint32(Log.GetDroppedCount()), ThreadCount * Count);
+    }
+
+    // a thread over MaxThreadCount has no ring
+    {
+        Logger Log{ Arena, 1, 1024 };
+        GAME_LOG(Log, Info, "main");
+        std::thread{ [&Log] { GAME_LOG(Log, Info, "other"); } }.join();
+        CHECK_EQ(Log.GetDroppedCount(), 1u);
+    }
+
+    // a forced drain during another one (a crash in the sink) does not drain, the other one goes on
+    {
+        struct Crash
+        {
+            Logger*     Log;
+            std::string Text;
+            std::string Forced;
+            uint32      Count = ~0u;
+        } State{ nullptr, {}, {} };
+        Logger Log{ Arena, 1, 1024 };
+        State.Log = &Log;
+        GAME_LOG(Log, Info, "{}", 1);
+        GAME_LOG(Log, Info, "{}", 2);
+        auto Count = Log.Drain({ &State, [](void* Context, const char* Text, uint32 Size) {
+                                    auto Self = static_cast<Crash*>(Context);
+                                    Self->Text.append(Text, Size);
+                                    Self->Count = Self->Log->Drain({ &Self->Forced, &Append }, true);
+                                } });
+        CHECK_EQ(Count, 2u);
+        CHECK_EQ(State.Count, 0u);
+        CHECK_EQ(State.Forced, std::string{ Logger::NotDrainedLine });
+        CHECK_EQ(GetMessages(State.Text).size(), 2u);
+
+        std::string Text;
+        GAME_LOG(Log, Info, "{}", 3);
+        Count = Log.Drain({ &Text, &Append }, true);
+        CHECK_EQ(Count, 1u);
+    }
+
+#if !_WIN32
+    // a crashing child leaves its pending entries in the crash file
+    {
+        auto Path = "logger_tests_crash.log";
+        remove(Path);
+        auto Child = fork();
+        if (Child == 0)
+        {
+            Logger          Log{ Arena, 1, 4096 };
+            Linux::CrashLog Crash{ Log, Path };
+            GAME_LOG(Log, Error, "before the crash {}", 42);
+            abort();
+        }
+        int Status = 0;
+        waitpid(Child, &Status, 0);
+        CHECK_TRUE(WIFSIGNALED(Status) && WTERMSIG(Status) == SIGABRT);
+
+        std::string Text(256, 0);
+        auto        File = fopen(Path, "rb");
+        Text.resize(File ? fread(&Text[0], 1, Text.size(), File) : 0);
+        if (File)
+        {
+            fclose(File);
+        }
+        remove(Path);
+        CHECK_EQ(Text.substr(0, 16), "crash: signal 6\n");
+        CHECK_TRUE(Text.find("before the crash 42\n") != std::string::npos);
+    }
+#endif
+}
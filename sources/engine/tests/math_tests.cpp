@@ -0,0 +1,128 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <math.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    bool IsNear(real32 A, real32 B, real32 Tolerance = 1e-5f)
+    {
+        return std::fabs(A - B) <= Tolerance * (1.0f + std::fabs(A) + std::fabs(B));
+    }
+
+    bool IsNear(v3 A, v3 B) { return IsNear(A.X, B.X) && IsNear(A.Y, B.Y) && IsNear(A.Z, B.Z); }
+
+    // Count values in 3 arrays, a zero vector first
+    struct Points
+    {
+        Points(uint32 Count, uint32 Seed)
+            : X(Count)
+            , Y(Count)
+            , Z(Count)
+        {
+            for (uint32 Index = 1; Index < Count; ++Index)
+            {
+                real32* Coordinates[] = { &X[Index], &Y[Index], &Z[Index] };
+                for (auto Coordinate : Coordinates)
+                {
+                    Seed        = Seed * 1664525u + 1013904223u;
+                    *Coordinate = real32(int32(Seed >> 8) % 20000) / 100.0f - 100.0f;
+                }
+            }
+        }
+
+        V2Soa Soa2() { return { X.data(), Y.data() }; }
+        V3Soa Soa3() { return { X.data(), Y.data(), Z.data() }; }
+
+        std::vector<real32> X, Y, Z;
+    };
+} // namespace
+
+void MathTests()
+{
+    // values
+    constexpr v3 A = { 1, 2, 3 };
+    constexpr v3 B = { -4, 5, 0.5f };
+    static_assert(Dot(A, B) == 7.5f, "constexpr dot");
+    CHECK_EQ(Dot(Cross(A, B), A), 0.0f);
+    CHECK_EQ(Dot(Cross(A, B), B), 0.0f);
+    CHECK_TRUE(IsNear(Length(Normalize(B)), 1.0f));
+    CHECK_EQ(LengthSquared(Normalize(v3{})), 0.0f);
+    CHECK_TRUE(IsNear(Lerp(A, B, 0.25f), A * 0.75f + B * 0.25f));
+
+    auto Transform = Translation(v3{ 1, 2, 3 }) * RotationZ(0.5f) * Scaling(v3{ 2, 2, 2 });
+    CHECK_TRUE(IsNear(TransformPoint(Transform, A), v3{ 1, 2, 9 } + v3{ std::cos(0.5f) * 2 - std::sin(0.5f) * 4,
+                                                                        std::sin(0.5f) * 2 + std::cos(0.5f) * 4,
+                                                                        0 }));
+    auto Round = RotationX(0.3f) * Transpose(RotationX(0.3f)); // rotations are orthogonal
+    for (int Row = 0; Row < 4; ++Row)
+    {
+        for (int Column = 0; Column < 4; ++Column)
+        {
+            CHECK_TRUE(IsNear(Round.E[Row][Column], Identity4x4().E[Row][Column]));
+        }
+    }
+    auto Point = TransformPoint(Translation(v2{ 3, 4 }) * Rotation(1.0f), v2{ 1, 0 });
+    CHECK_TRUE(IsNear(Point.X, 3 + std::cos(1.0f)) && IsNear(Point.Y, 4 + std::sin(1.0f)));
+
+    // batches: every level gives the scalar results, in place too, for counts which are not multiple of the width
+    constexpr uint32 Count = 37;
+    auto             M3    = Translation(v2{ 5, -2 }) * Rotation(0.7f);
+    auto             M4    = Translation(v3{ 5, -2, 1 }) * RotationY(0.7f) * Scaling(v3{ 1, 2, 3 });
+    Points           In{ Count, 7 };
+    Points           Other{ Count, 11 };
+    SimdLevel        Levels[] = { SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Avx512 };
+    for (auto Level : Levels)
+    {
+        if (Level > GetBestSimdLevel())
+        {
+            continue;
+        }
+        Points              Out{ Count, 1 };
+        Points              Reference{ Count, 1 };
+        std::vector<real32> Dots(Count);
+        std::vector<real32> ReferenceDots(Count);
+        int                 Wrong = 0;
+
+        TransformPoints(M3, In.Soa2(), Out.Soa2(), Count, Level);
+        TransformPoints(M3, In.Soa2(), Reference.Soa2(), Count, SimdLevel::Scalar);
+        for (uint32 Index = 0; Index < Count; ++Index)
+        {
+            Wrong += !IsNear(Out.X[Index], Reference.X[Index]) || !IsNear(Out.Y[Index], Reference.Y[Index]);
+        }
+        TransformPoints(M4, In.Soa3(), Out.Soa3(), Count, Level);
+        TransformPoints(M4, In.Soa3(), Reference.Soa3(), Count, SimdLevel::Scalar);
+        for (uint32 Index = 0; Index < Count; ++Index)
+        {
+            Wrong += !IsNear(Out.Soa3().Get(Index), Reference.Soa3().Get(Index));
+        }
+        Cross(In.Soa3(), Other.Soa3(), Out.Soa3(), Count, Level);
+        Cross(In.Soa3(), Other.Soa3(), Reference.Soa3(), Count, SimdLevel::Scalar);
+        for (uint32 Index = 0; Index < Count; ++Index)
+        {
+            Wrong += !IsNear(Out.Soa3().Get(Index), Reference.Soa3().Get(Index));
+        }
+        Dot(In.Soa3(), Other.Soa3(), Dots.data(), Count, Level);
+        Dot(In.Soa3(), Other.Soa3(), ReferenceDots.data(), Count, SimdLevel::Scalar);
+        for (uint32 Index = 0; Index < Count; ++Index)
+        {
+            Wrong += !IsNear(Dots[Index], ReferenceDots[Index], 1e-4f);
+        }
+        Out = In;
+        Normalize(Out.Soa3(), Out.Soa3(), Count, Level);
+        Normalize(In.Soa3(), Reference.Soa3(), Count, SimdLevel::Scalar);
+        for (uint32 Index = 0; Index < Count; ++Index)
+        {
+            Wrong += !IsNear(Out.Soa3().Get(Index), Reference.Soa3().Get(Index));
+        }
+        CHECK_EQ(Wrong, 0);
+        CHECK_EQ(LengthSquared(Out.Soa3().Get(0)), 0.0f);
+        CHECK_TRUE(IsNear(Length(Out.Soa3().Get(Count - 1)), 1.0f));
+    }
+}
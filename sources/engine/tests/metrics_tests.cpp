@@ -0,0 +1,210 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <metrics.hpp>
+
+#if !_WIN32
+#include "../linux/mapped_output_file.hpp"
+#include <cstdio>
+#endif
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Game;
+
+void MetricsTests()
+{
+    std::vector<uint8> Memory(1 << 20);
+    MemoryArena        Arena{ Memory.data(), Memory.size() };
+
+    // a name is registered once, with one kind
+    {
+        MemoryArena    Own = Arena.PushArena(64 * 1024);
+        MetricRegistry Registry{ Own, 4, 40 };
+        auto           Frames  = Registry.AddCounter("frames");
+        auto           Again   = Registry.AddCounter("frames");
+        auto           Wrong   = Registry.AddGauge("frames");
+        auto           Latency = Registry.AddHistogram("latency");
+        CHECK_TRUE(Frames != nullptr);
+        CHECK_TRUE(Frames == Again);
+        CHECK_TRUE(Wrong == nullptr);
+        CHECK_TRUE(Latency != nullptr);
+        CHECK_EQ(Registry.GetCount(), 2u);
+
+        // full: the values of a histogram, then the metrics
+        CHECK_TRUE(Registry.AddHistogram("other") == nullptr);
+        CHECK_TRUE(Registry.AddGauge("memory") != nullptr);
+        CHECK_TRUE(Registry.AddGauge("threads") != nullptr);
+        CHECK_TRUE(Registry.AddGauge("more") == nullptr);
+        CHECK_TRUE(Registry.AddCounter(std::string(Metering::NameSize, 'x')) == nullptr);
+        CHECK_EQ(Registry.GetMetric(1).FirstValue, 1u);
+        CHECK_EQ(Registry.GetMetric(2).FirstValue, 33u);
+    }
+
+    // histogram buckets, powers of two
+    {
+        CHECK_EQ(Metering::GetBucket(0), 0u);
+        CHECK_EQ(Metering::GetBucket(1), 1u);
+        CHECK_EQ(Metering::GetBucket(3), 2u);
+        CHECK_EQ(Metering::GetBucket(4), 3u);
+        CHECK_EQ(Metering::GetBucket(~0ULL), Metering::BucketCount - 1);
+        CHECK_EQ(Metering::GetBucketLimit(3), 8u);
+        CHECK_EQ(Metering::GetBucketLimit(Metering::BucketCount - 1), ~0ULL);
+        MetricHistogram Histogram;
+        for (uint64 Value : { 0, 5, 6, 7, 33333 })
+        {
+            Histogram.Record(Value);
+        }
+        auto Low  = Histogram.GetBucket(3);
+        auto High = Histogram.GetBucket(16);
+        CHECK_EQ(Low, 3u);
+        CHECK_EQ(High, 1u);
+    }
+
+    // records read back, with a metric registered between two of them
+    {
+        MemoryArena         Own = Arena.PushArena(64 * 1024);
+        MetricRegistry      Registry{ Own, 8, 64 };
+        std::vector<uint64> File(4096);
+        MetricSeries        Series{ Registry, File.data(), File.size() * sizeof(uint64) };
+        MetricSeriesView    View;
+        auto                Frames = Registry.AddCounter("frames");
+        auto                Used   = Registry.AddGauge("used");
+        CHECK_TRUE(Series.IsValid());
+        CHECK_TRUE(View.Open(File.data(), File.size() * sizeof(uint64)));
+        CHECK_EQ(View.GetRecordCount(), 0u);
+
+        Frames->Add(3);
+        Used->Set(-5);
+        CHECK_TRUE(Series.Append());
+        auto Time = Registry.AddHistogram("time");
+        Time->Record(100);
+        Frames->Add();
+        CHECK_TRUE(Series.Append());
+
+        CHECK_EQ(View.GetRecordCount(), 2u);
+        CHECK_EQ(View.GetMetricCount(), 3u);
+        auto FramesMetric = View.FindMetric("frames");
+        auto UsedMetric   = View.FindMetric("used");
+        auto TimeMetric   = View.FindMetric("time");
+        CHECK_TRUE(FramesMetric && UsedMetric && TimeMetric);
+        CHECK_TRUE(View.FindMetric("fram") == nullptr);
+        if (FramesMetric && UsedMetric && TimeMetric)
+        {
+            auto First  = View.GetValues(0, *FramesMetric)[0];
+            auto Second = View.GetValues(1, *FramesMetric)[0];
+            auto Gauge  = int64(View.GetValues(1, *UsedMetric)[0]);
+            auto Before = View.GetValues(0, *TimeMetric)[7];
+            auto After  = View.GetValues(1, *TimeMetric)[7];
+            CHECK_EQ(First, 3u);
+            CHECK_EQ(Second, 4u);
+            CHECK_EQ(Gauge, -5);
+            CHECK_EQ(Before, 0u);
+            CHECK_EQ(After, 1u);
+            CHECK_TRUE(TimeMetric->Kind == MetricKind::Histogram);
+            CHECK_EQ(TimeMetric->ValueCount, Metering::BucketCount);
+        }
+        CHECK_TRUE(View.GetTime(1) >= View.GetTime(0));
+
+        // append only: full, then nothing more
+        while (Series.Append())
+        {
+        }
+        auto Capacity = Series.GetRecordCapacity();
+        auto Records  = File.size() * sizeof(uint64) - sizeof(Metering::SeriesHeader) - 8 * 64;
+        CHECK_EQ(View.GetRecordCount(), Capacity);
+        CHECK_EQ(Capacity, Records / (65 * sizeof(uint64)));
+
+        // not a series, or a truncated one
+        CHECK_FALSE(View.Open(File.data(), 1024));
+        File[0] = 0;
+        CHECK_FALSE(View.Open(File.data(), File.size() * sizeof(uint64)));
+        MetricSeries Small{ Registry, File.data(), 100 };
+        CHECK_FALSE(Small.IsValid());
+    }
+
+    // threads count while the series is written
+    {
+        MemoryArena         Own = Arena.PushArena(64 * 1024);
+        MetricRegistry      Registry{ Own, 8, 64 };
+        std::vector<uint64> File(64 * 1024);
+        MetricSeries        Series{ Registry, File.data(), File.size() * sizeof(uint64) };
+        auto                Counter = Registry.AddCounter("work");
+        {
+            MetricThread             Thread{ Series, 1 };
+            std::vector<std::thread> Workers;
+            for (uint32 Worker = 0; Worker < 4; ++Worker)
+            {
+                Workers.emplace_back([Counter] {
+                    for (uint32 Index = 0; Index < 100000; ++Index)
+                    {
+                        Counter->Add();
+                    }
+                });
+            }
+            for (auto& Worker : Workers)
+            {
+                Worker.join();
+            }
+        }
+        MetricSeriesView View;
+        CHECK_TRUE(View.Open(File.data(), File.size() * sizeof(uint64)));
+        auto Count = View.GetRecordCount();
+        CHECK_GT(Count, 0u);
+        auto Metric = View.FindMetric("work");
+        CHECK_TRUE(Metric != nullptr);
+        if (Metric && Count)
+        {
+            uint32 Decreasing = 0;
+            for (uint64 Record = 1; Record < Count; ++Record)
+            {
+                Decreasing += View.GetValues(Record, *Metric)[0] < View.GetValues(Record - 1, *Metric)[0];
+            }
+            auto Last = View.GetValues(Count - 1, *Metric)[0];
+            CHECK_EQ(Decreasing, 0u);
+            CHECK_EQ(Last, 400000u);
+        }
+    }
+
+#if !_WIN32
+    // through a file, read by a second mapping like a dashboard
+    {
+        MemoryArena    Own = Arena.PushArena(64 * 1024);
+        MetricRegistry Registry{ Own, 4, 8 };
+        auto           Path = "metrics_tests.series";
+        {
+            Linux::MappedOutputFile File{ Path, 64 * 1024 };
+            CHECK_TRUE(File.IsValid());
+            MetricSeries Series{ Registry, File.GetData(), File.GetSize() };
+            Registry.AddGauge("level")->Set(12);
+            Series.Append();
+
+            auto Reader = open(Path, O_RDONLY);
+            auto Shared = mmap(nullptr, 64 * 1024, PROT_READ, MAP_SHARED, Reader, 0);
+            CHECK_TRUE(Shared != MAP_FAILED);
+            if (Shared != MAP_FAILED)
+            {
+                MetricSeriesView View;
+                CHECK_TRUE(View.Open(Shared, 64 * 1024));
+                auto Level = View.FindMetric("level");
+                CHECK_TRUE(Level != nullptr);
+                CHECK_EQ(View.GetRecordCount(), 1u);
+                Registry.AddGauge("level")->Set(13);
+                Series.Append();
+                CHECK_EQ(View.GetRecordCount(), 2u);
+                if (Level)
+                {
+                    auto Value = View.GetValues(1, *Level)[0];
+                    CHECK_EQ(Value, 13u);
+                }
+                munmap(Shared, 64 * 1024);
+            }
+            close(Reader);
+        }
+        remove(Path);
+    }
+#endif
+}
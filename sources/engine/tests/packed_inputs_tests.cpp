@@ -0,0 +1,137 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <packed_inputs.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    uint32 Random(uint32& Seed)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        return Seed >> 8;
+    }
+
+    // a frame of play: a few buttons change, the sticks of the first pad drift
+    void Step(Inputs& Value, uint32& Seed)
+    {
+        for (auto* Pad : { &Value.GamePads[0], &Value.GamePads[1], &Value.Keyboard })
+        {
+            Pad->IsConnected = true;
+            for (auto& Button : Pad->Buttons)
+            {
+                Button.HalfTransitionCount = 0;
+                if (Random(Seed) % 40 == 0)
+                {
+                    Button.EndedDown           = !Button.EndedDown;
+                    Button.HalfTransitionCount = 1 + (Random(Seed) % 8 == 0) * 4; // sometimes saturated
+                }
+            }
+        }
+        auto& Pad      = Value.GamePads[0];
+        Pad.IsAnalog   = true;
+        Pad.LeftStickX = std::sin(real32(Seed % 1000) * 0.01f);
+        Pad.LeftStickY = Random(Seed) % 4 ? Pad.LeftStickY : -2.0f; // clamped
+    }
+} // namespace
+
+void PackedInputsTests()
+{
+    // a pad: bits, saturated counts, quantized and clamped axes
+    {
+        Inputs Value = {};
+        auto&  Pad   = Value.GamePads[2];
+
+        Pad.IsConnected                    = true;
+        Pad.ActionDown.EndedDown           = true;
+        Pad.ActionDown.HalfTransitionCount = 1;
+        Pad.Start.HalfTransitionCount      = 7;
+        Pad.LeftStickX                     = 0.5f;
+        Pad.RightTrigger                   = 3.0f;
+        Pad.RightStickY                    = -1.0f;
+
+        auto Packed = InputPacking::Pack(Value);
+        CHECK_EQ(sizeof(PackedInputs), 100u);
+        CHECK_EQ(Packed.Pads[2].EndedDown, 1 << 5);
+        CHECK_EQ(Packed.Pads[2].Transitions, 1u << 10 | 3u << 30);
+        CHECK_EQ(Packed.Pads[2].Flags, 1);
+        CHECK_EQ(Packed.Pads[2].Axes[5], 32767);
+        CHECK_EQ(Packed.Pads[2].Axes[3], -32767);
+        CHECK_TRUE(Packed.Pads[0] == PackedGamePad{});
+
+        Inputs Unpacked;
+        InputPacking::Unpack(Packed, Unpacked);
+        auto& Result = Unpacked.GamePads[2];
+        CHECK_TRUE(Result.IsConnected && !Result.IsAnalog);
+        CHECK_TRUE(Result.ActionDown.EndedDown && Result.ActionDown.HalfTransitionCount == 1);
+        CHECK_TRUE(!Result.Start.EndedDown && Result.Start.HalfTransitionCount == 3);
+        CHECK_TRUE(std::fabs(Result.LeftStickX - 0.5f) <= 0.5f / 32767);
+        CHECK_EQ(Result.RightTrigger, 1.0f);
+        CHECK_TRUE(InputPacking::Pack(Unpacked) == Packed);
+    }
+
+    // a session: every frame comes back from its delta, idle frames are a byte
+    {
+        constexpr uint32   Count = 2000;
+        Inputs             Value = {};
+        PackedInputs       Previous;
+        PackedInputs       Decoded;
+        std::vector<uint8> Stream;
+        uint32             Seed  = 3;
+        int32              Wrong = 0;
+        uint8              Delta[InputPacking::MaxDeltaSize];
+        for (uint32 Frame = 0; Frame < Count; ++Frame)
+        {
+            Step(Value, Seed);
+            auto Size = InputPacking::EncodeDelta(Previous, InputPacking::Pack(Value), Delta);
+            Wrong += Size > InputPacking::MaxDeltaSize;
+            Stream.insert(Stream.end(), Delta, Delta + Size);
+            Previous = InputPacking::Pack(Value);
+        }
+        CHECK_TRUE(Stream.size() < Count * 16);
+
+        uint32 Offset = 0;
+        Seed          = 3;
+        Value         = {};
+        Previous      = {};
+        for (uint32 Frame = 0; Frame < Count; ++Frame)
+        {
+            Step(Value, Seed);
+            auto Read = InputPacking::DecodeDelta(Previous, Stream.data() + Offset, uint32(Stream.size()) - Offset,
+                                                  Decoded);
+            Wrong += !Read || Decoded != InputPacking::Pack(Value);
+            Offset += Read;
+            Previous = Decoded;
+        }
+        CHECK_EQ(Wrong, 0);
+        CHECK_EQ(Offset, uint32(Stream.size()));
+
+        CHECK_EQ(InputPacking::EncodeDelta(Previous, Previous, Delta), 1u);
+        CHECK_EQ(Delta[0], 0);
+
+        // the largest delta fits, truncated or corrupted ones are rejected
+        PackedInputs Full;
+        for (auto& Pad : Full.Pads)
+        {
+            Pad = { { -32767, 32767, -32767, 32767, -32767, 32767 }, 0xFFFFFFFF, 0xFFFF, 3 };
+        }
+        PackedInputs Opposite;
+        for (auto& Pad : Opposite.Pads)
+        {
+            Pad = { { 32767, -32767, 32767, -32767, 32767, -32767 }, 0, 0, 0 };
+        }
+        auto Size = InputPacking::EncodeDelta(Opposite, Full, Delta);
+        CHECK_TRUE(Size <= InputPacking::MaxDeltaSize);
+        CHECK_EQ(InputPacking::DecodeDelta(Opposite, Delta, Size, Decoded), Size);
+        CHECK_TRUE(Decoded == Full);
+        CHECK_EQ(InputPacking::DecodeDelta(Opposite, Delta, Size - 1, Decoded), 0u);
+        CHECK_EQ(InputPacking::DecodeDelta(Opposite, Delta, 0, Decoded), 0u);
+        uint8 Corrupted[] = { 0xFF };
+        CHECK_EQ(InputPacking::DecodeDelta(Opposite, Corrupted, 1, Decoded), 0u);
+    }
+}
@@ -0,0 +1,133 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <particles.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    uint32 Random(uint32& Seed)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        return Seed >> 8;
+    }
+
+    // lives from 0 to 1 second, so about a third dies at each update of 1/3 second
+    void SpawnRandom(ParticleSystem& System, uint32 Count, uint32 Seed)
+    {
+        for (uint32 Index = 0; Index < Count; ++Index)
+        {
+            Particle Value;
+            Value.Position = { real32(Random(Seed) % 20000) / 100.0f - 20.0f, real32(Random(Seed) % 12000) / 100.0f };
+            Value.Velocity = { real32(Random(Seed) % 200) - 100.0f, real32(Random(Seed) % 200) - 100.0f };
+            Value.Life     = real32(Random(Seed) % 1000) / 1000.0f;
+            Value.Color    = Random(Seed) & 0x3F3F3F;
+            System.Spawn(Value);
+        }
+    }
+
+    bool IsNear(real32 A, real32 B) { return std::fabs(A - B) <= 1e-4f * (1.0f + std::fabs(A)); }
+} // namespace
+
+void ParticlesTests()
+{
+    std::vector<uint8>  Memory(64 << 20);
+    MemoryArena         Arena{ Memory.data(), 48 << 20 };
+    MemoryArena         Scratch{ Memory.data() + (48 << 20), 16 << 20 };
+    ThreadPoolJobSystem Jobs{ 3 };
+
+    // one particle: motion, death
+    {
+        TemporaryMemory Temporary{ Arena };
+        ParticleSystem  System{ Arena, 100 };
+        CHECK_TRUE(System.Spawn({ { 10, 20 }, { 1, 2 }, 1.0f, 0xFF0000 }));
+        System.Update(0.5f, { 0, 4 }, Scratch);
+        auto Moved = System.Get(0);
+        CHECK_EQ(System.GetCount(), 1u);
+        CHECK_TRUE(IsNear(Moved.Velocity.Y, 4.0f));
+        CHECK_TRUE(IsNear(Moved.Position.X, 10.5f) && IsNear(Moved.Position.Y, 22.0f));
+        CHECK_EQ(Moved.Life, 0.5f);
+        System.Update(0.5f, { 0, 4 }, Scratch);
+        CHECK_EQ(System.GetCount(), 0u);
+        CHECK_EQ(Scratch.GetUsed(), 0u);
+    }
+
+    // every level keeps the same survivors in the same order, on any number of threads; the tails of the batches
+    // are not multiples of the SIMD width
+    SimdLevel Levels[] = { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Avx512 };
+    auto      Best     = GetBestSimdLevel();
+
+    constexpr uint32 Count = 3 * Particles::BatchSize + 1001;
+    TemporaryMemory  Temporary{ Arena };
+    ParticleSystem   Reference{ Arena, Count };
+    SpawnRandom(Reference, Count, 7);
+    Reference.Update(1.0f / 3, { 0, 10 }, Scratch, nullptr, SimdLevel::Scalar);
+    Reference.Update(1.0f / 3, { 0, 10 }, Scratch, nullptr, SimdLevel::Scalar);
+    CHECK_TRUE(Reference.GetCount() > Count / 4 && Reference.GetCount() < Count / 2);
+    for (auto Level : Levels)
+    {
+        if (Level > Best)
+        {
+            continue;
+        }
+        TemporaryMemory Inner{ Arena };
+        ParticleSystem  System{ Arena, Count };
+        SpawnRandom(System, Count, 7);
+        System.Update(1.0f / 3, { 0, 10 }, Scratch, &Jobs, Level);
+        System.Update(1.0f / 3, { 0, 10 }, Scratch, &Jobs, Level);
+        CHECK_EQ(System.GetCount(), Reference.GetCount());
+        int32 Wrong = 0;
+        for (uint32 Index = 0; Index < System.GetCount(); ++Index)
+        {
+            auto A = System.Get(Index);
+            auto B = Reference.Get(Index);
+            Wrong += !IsNear(A.Position.X, B.Position.X) || !IsNear(A.Position.Y, B.Position.Y) ||
+                     !IsNear(A.Velocity.X, B.Velocity.X) || !IsNear(A.Velocity.Y, B.Velocity.Y) || A.Life != B.Life ||
+                     A.Color != B.Color;
+        }
+        CHECK_EQ(Wrong, 0);
+    }
+
+    // drawing adds the colors, saturated, and ignores the particles out of the buffer
+    constexpr int32     Width  = 150;
+    constexpr int32     Height = 100;
+    std::vector<uint32> Expected(Width * Height, 0x102030);
+    for (uint32 Index = 0; Index < Reference.GetCount(); ++Index)
+    {
+        auto Value = Reference.Get(Index);
+        auto X     = Value.Position.X;
+        auto Y     = Value.Position.Y;
+        if (X >= 0 && Y >= 0 && X < Width && Y < Height)
+        {
+            Particles::AddPixelScalar(&Expected[int32(Y) * Width + int32(X)], Value.Color);
+        }
+    }
+    for (auto Level : Levels)
+    {
+        if (Level > Best)
+        {
+            continue;
+        }
+        std::vector<uint32> Pixels(Width * Height, 0x102030);
+        PIBackBuffer        Buffer = { Pixels.data(), Width, Height, 4, Width * 4 };
+        Reference.Draw(Buffer, Scratch, &Jobs, Level);
+        CHECK_TRUE(Pixels == Expected);
+    }
+    uint32 Saturated = 0;
+    for (auto Pixel : Expected)
+    {
+        Saturated += (Pixel & 0xFF) == 0xFF;
+    }
+    CHECK_TRUE(Saturated > 0);
+
+    // full
+    ParticleSystem Small{ Arena, 2 };
+    CHECK_TRUE(Small.Spawn({}));
+    CHECK_TRUE(Small.Spawn({}));
+    CHECK_TRUE(!Small.Spawn({}));
+}
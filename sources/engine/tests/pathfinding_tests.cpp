@@ -0,0 +1,290 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <pathfinding.hpp>
+
+#include <cmath>
+#include <queue>
+#include <utility>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    uint32 Random(uint32& Seed)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        return Seed >> 8;
+    }
+
+    // about a fifth of the cells blocked, in short walls; costs from 1 to MaxCost
+    void Fill(NavGrid& Grid, uint32 Seed, uint32 MaxCost)
+    {
+        for (int32 Y = 0; Y < Grid.GetHeight(); ++Y)
+        {
+            for (int32 X = 0; X < Grid.GetWidth(); ++X)
+            {
+                Grid.SetCost(X, Y, uint8(1 + Random(Seed) % MaxCost));
+            }
+        }
+        for (int32 Wall = 0; Wall < Grid.GetWidth() * Grid.GetHeight() / 24; ++Wall)
+        {
+            auto X      = int32(Random(Seed) % uint32(Grid.GetWidth()));
+            auto Y      = int32(Random(Seed) % uint32(Grid.GetHeight()));
+            auto IsWide = Random(Seed) % 2 == 0;
+            for (int32 Index = 0; Index < 6; ++Index)
+            {
+                Grid.SetCost(IsWide ? X + Index : X, IsWide ? Y : Y + Index, 0);
+            }
+        }
+    }
+
+    // Dijkstra over the cells, with the same moves
+    real32 FindReference(const NavGrid& Grid, GridPoint Start, GridPoint Goal)
+    {
+        using Entry = std::pair<real32, int32>;
+        auto                Width = Grid.GetWidth();
+        std::vector<real32> Costs(size_t(Width) * Grid.GetHeight(), 1e30f);
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> Open;
+        Costs[Start.Y * Width + Start.X] = 0;
+        Open.push({ 0.0f, Start.Y * Width + Start.X });
+        while (!Open.empty())
+        {
+            auto [Cost, Cell] = Open.top();
+            Open.pop();
+            auto X = Cell % Width;
+            auto Y = Cell / Width;
+            if (Cost > Costs[Cell])
+            {
+                continue;
+            }
+            if (X == Goal.X && Y == Goal.Y)
+            {
+                return Cost;
+            }
+            for (auto Dy = -1; Dy <= 1; ++Dy)
+            {
+                for (auto Dx = -1; Dx <= 1; ++Dx)
+                {
+                    auto Step = Grid.GetCost(X + Dx, Y + Dy);
+                    if (!Step || (Dx && Dy && (!Grid.IsWalkable(X + Dx, Y) || !Grid.IsWalkable(X, Y + Dy))))
+                    {
+                        continue;
+                    }
+                    auto Next = Cost + real32(Step) * (Dx && Dy ? Pathfinding::Diagonal : 1.0f);
+                    auto To   = (Y + Dy) * Width + X + Dx;
+                    if (Next < Costs[To])
+                    {
+                        Costs[To] = Next;
+                        Open.push({ Next, To });
+                    }
+                }
+            }
+        }
+        return -1;
+    }
+
+    // the corners are joined by straight or diagonal lines of walkable cells, without cut corners: returns the cost
+    real32 Walk(const NavGrid& Grid, const GridPoint* Path, uint32 Length, bool& IsValid)
+    {
+        real32 Cost = 0;
+        IsValid     = Length > 0 && Grid.IsWalkable(Path[0].X, Path[0].Y);
+        for (uint32 Index = 1; IsValid && Index < Length; ++Index)
+        {
+            auto Dx = Pathfinding::GetSign(Path[Index].X - Path[Index - 1].X);
+            auto Dy = Pathfinding::GetSign(Path[Index].Y - Path[Index - 1].Y);
+            auto X  = Path[Index - 1].X;
+            auto Y  = Path[Index - 1].Y;
+            IsValid = std::abs(Path[Index].X - X) == std::abs(Path[Index].Y - Y) || !Dx || !Dy;
+            while (IsValid && (X != Path[Index].X || Y != Path[Index].Y))
+            {
+                IsValid = !Dx || !Dy || (Grid.IsWalkable(X + Dx, Y) && Grid.IsWalkable(X, Y + Dy));
+                X += Dx;
+                Y += Dy;
+                IsValid = IsValid && Grid.IsWalkable(X, Y);
+                Cost += real32(Grid.GetCost(X, Y)) * (Dx && Dy ? Pathfinding::Diagonal : 1.0f);
+            }
+        }
+        return Cost;
+    }
+
+    bool IsNear(real32 A, real32 B) { return std::fabs(A - B) <= 1e-3f * (1.0f + std::fabs(A)); }
+
+    TileId GetStripe(int32 X, int32 Y) { return TileId((X / 3 + Y) % 4); }
+
+    void LoadStripes(void*, int32 ChunkX, int32 ChunkY, TileId* Tiles)
+    {
+        for (int32 Y = 0; Y < TileMap::ChunkSize; ++Y)
+        {
+            for (int32 X = 0; X < TileMap::ChunkSize; ++X)
+            {
+                auto MapX                         = ChunkX * TileMap::ChunkSize + X;
+                auto MapY                         = ChunkY * TileMap::ChunkSize + Y;
+                Tiles[Y * TileMap::ChunkSize + X] = GetStripe(MapX, MapY);
+            }
+        }
+    }
+} // namespace
+
+void PathfindingTests()
+{
+    std::vector<uint8>  Memory(16 << 20);
+    MemoryArena         Arena{ Memory.data(), Memory.size() };
+    ThreadPoolJobSystem Jobs{ 3 };
+    GridPoint           Path[512];
+
+    // an open grid: one diagonal then one straight line
+    {
+        TemporaryMemory Temporary{ Arena };
+        NavGrid         Grid{ Arena, 20, 10 };
+        PathFinder      Finder{ Arena, Grid };
+        CHECK_TRUE(Grid.IsValid() && Finder.IsValid() && Grid.IsUniform());
+        for (auto Method : { PathMethod::AStar, PathMethod::JumpPoint })
+        {
+            auto Result = Finder.Find({ { 1, 1 }, { 15, 4 } }, Path, 512, Method);
+            CHECK_TRUE(Result.IsFound);
+            CHECK_TRUE(IsNear(Result.Cost, 11.0f + 3 * Pathfinding::Diagonal));
+            CHECK_EQ(Result.Length, 3u);
+            CHECK_TRUE(Path[0] == (GridPoint{ 1, 1 }) && Path[2] == (GridPoint{ 15, 4 }));
+        }
+
+        // same cell, blocked goal, out of the grid, walled off
+        auto Same = Finder.Find({ { 3, 3 }, { 3, 3 } }, Path, 512);
+        CHECK_TRUE(Same.IsFound && Same.Length == 1 && Same.Cost == 0);
+        Grid.SetCost(5, 5, 0);
+        CHECK_TRUE(!Finder.Find({ { 3, 3 }, { 5, 5 } }, Path, 512).IsFound);
+        CHECK_TRUE(!Finder.Find({ { 3, 3 }, { 20, 5 } }, Path, 512).IsFound);
+        for (int32 Y = 0; Y < 10; ++Y)
+        {
+            Grid.SetCost(10, Y, 0);
+        }
+        for (auto Method : { PathMethod::AStar, PathMethod::JumpPoint })
+        {
+            CHECK_TRUE(!Finder.Find({ { 3, 3 }, { 12, 5 } }, Path, 512, Method).IsFound);
+        }
+        Grid.SetCost(10, 0, 1);
+        auto Around = Finder.Find({ { 3, 3 }, { 12, 5 } }, Path, 512);
+        CHECK_TRUE(Around.IsFound);
+        CHECK_TRUE(IsNear(Around.Cost, FindReference(Grid, { 3, 3 }, { 12, 5 })));
+
+        // a path longer than the buffer: the length tells the size needed
+        auto Short = Finder.Find({ { 3, 3 }, { 12, 5 } }, Path, 2);
+        CHECK_EQ(Short.Length, Around.Length);
+        CHECK_TRUE(Path[0] == (GridPoint{ 3, 3 }));
+    }
+
+    // random walls, wider than a bitset word: JPS, A* and Dijkstra agree on the uniform grid, A* and Dijkstra on
+    // the weighted one
+    for (uint32 MaxCost : { 1u, 4u })
+    {
+        TemporaryMemory Temporary{ Arena };
+        NavGrid         Grid{ Arena, 150, 90 };
+        PathFinder      Finder{ Arena, Grid };
+        Fill(Grid, MaxCost, MaxCost);
+        CHECK_EQ(Grid.IsUniform(), MaxCost == 1);
+
+        uint32 Seed  = 17;
+        int32  Wrong = 0;
+        int32  Found = 0;
+        for (int32 Query = 0; Query < 60; ++Query)
+        {
+            GridPoint Start     = { int32(Random(Seed) % 150), int32(Random(Seed) % 90) };
+            GridPoint Goal      = { int32(Random(Seed) % 150), int32(Random(Seed) % 90) };
+            auto      IsOpen    = Grid.IsWalkable(Start.X, Start.Y) && Grid.IsWalkable(Goal.X, Goal.Y);
+            auto      Reference = IsOpen ? FindReference(Grid, Start, Goal) : -1.0f;
+            for (auto Method : { PathMethod::AStar, PathMethod::JumpPoint })
+            {
+                if (Method == PathMethod::JumpPoint && MaxCost > 1)
+                {
+                    continue;
+                }
+                auto Result  = Finder.Find({ Start, Goal }, Path, 512, Method);
+                auto IsValid = false;
+                auto Cost    = Result.IsFound ? Walk(Grid, Path, Result.Length, IsValid) : 0.0f;
+                Wrong += Result.IsFound != (Reference >= 0);
+                Wrong += Result.IsFound && (!IsValid || !IsNear(Cost, Reference) || !IsNear(Result.Cost, Reference) ||
+                                            Path[0] != Start || Path[Result.Length - 1] != Goal);
+            }
+            Found += Reference >= 0;
+        }
+        CHECK_EQ(Wrong, 0);
+        CHECK_TRUE(Found > 25);
+    }
+
+    // a batch on the jobs gives the same results as one finder
+    {
+        TemporaryMemory Temporary{ Arena };
+        NavGrid         Grid{ Arena, 100, 100 };
+        Fill(Grid, 3, 1);
+        constexpr uint32       Count     = 40;
+        constexpr uint32       MaxLength = 64;
+        std::vector<PathQuery> Queries(Count);
+        uint32                 Seed = 9;
+        for (auto& Query : Queries)
+        {
+            Query = { { int32(Random(Seed) % 100), int32(Random(Seed) % 100) },
+                      { int32(Random(Seed) % 100), int32(Random(Seed) % 100) } };
+        }
+        std::vector<PathResult> Results(Count);
+        std::vector<GridPoint>  Paths(Count * MaxLength);
+        FindPaths(Grid, Queries.data(), Results.data(), Count, Paths.data(), MaxLength, Arena, &Jobs);
+
+        PathFinder Finder{ Arena, Grid };
+        int32      Wrong = 0;
+        for (uint32 Index = 0; Index < Count; ++Index)
+        {
+            auto Result = Finder.Find(Queries[Index], Path, MaxLength);
+            Wrong += Result.IsFound != Results[Index].IsFound || Result.Length != Results[Index].Length ||
+                     Result.Cost != Results[Index].Cost;
+            for (uint32 Corner = 0; Corner < Result.Length && Corner < MaxLength; ++Corner)
+            {
+                Wrong += Path[Corner] != Paths[Index * MaxLength + Corner];
+            }
+        }
+        CHECK_EQ(Wrong, 0);
+    }
+
+    // costs from a tile map, through the streamer-less chunks
+    {
+        TemporaryMemory Temporary{ Arena };
+        Tileset         Tiles;
+        TileMap         Map{ Arena, 40, 20, Tiles, 8, 1 };
+        for (int32 Y = 0; Y < 20; ++Y)
+        {
+            Map.SetTile(7, Y, 2); // a wall, open at the bottom
+            Map.SetTile(8, Y, 3); // mud
+        }
+        Map.SetTile(7, 19, 1);
+        uint8   Costs[] = { 0, 1, 0, 5 };
+        NavGrid Grid{ Arena, 40, 20 };
+        Grid.Load(Map, Costs, 4);
+        CHECK_EQ(Grid.GetCost(0, 0), 0); // EmptyTile
+        CHECK_EQ(Grid.GetCost(7, 3), 0);
+        CHECK_EQ(Grid.GetCost(7, 19), 1);
+        CHECK_EQ(Grid.GetCost(8, 3), 5);
+        CHECK_TRUE(!Grid.IsUniform());
+    }
+
+    // a streamed map of 256 chunks through 8 resident ones
+    {
+        TemporaryMemory Temporary{ Arena };
+        Tileset         Tiles;
+        TileMap         Map{ Arena, 256, 256, Tiles, 8, 1 };
+        Map.SetStreamer({ nullptr, LoadStripes, nullptr });
+        uint8   Costs[] = { 0, 1, 0, 5 };
+        NavGrid Grid{ Arena, 256, 256 };
+        Grid.Load(Map, Costs, 4);
+        int32 Wrong = 0;
+        for (int32 Y = 0; Y < 256; ++Y)
+        {
+            for (int32 X = 0; X < 256; ++X)
+            {
+                Wrong += Grid.GetCost(X, Y) != Costs[GetStripe(X, Y)];
+            }
+        }
+        CHECK_EQ(Wrong, 0);
+        CHECK_EQ(Map.GetLoadCount(), 256u);
+    }
+}
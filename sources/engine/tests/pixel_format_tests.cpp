@@ -0,0 +1,164 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <pixel_format.hpp>
+
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    constexpr PixelFormat Formats[] = { PixelFormat::Bgrx8, PixelFormat::Bgra8,  PixelFormat::Bgra8Premultiplied,
+                                        PixelFormat::Rgba8, PixelFormat::Argb8,  PixelFormat::Rgb565,
+                                        PixelFormat::Gray8, PixelFormat::Bgra16Linear };
+
+    // an image of random bytes, rows padded past the width like a tile
+    struct TestImage
+    {
+        TestImage(int32 Width, int32 Height, PixelFormat Format, uint32 Seed)
+            : Bytes(size_t(Width * GetBytesPerPixel(Format) + 24) * Height)
+            , View{ Bytes.data(), Width, Height, Width * GetBytesPerPixel(Format) + 24, Format }
+        {
+            for (auto& Byte : Bytes)
+            {
+                Seed = Seed * 1664525u + 1013904223u;
+                Byte = uint8(Seed >> 24);
+            }
+        }
+
+        std::vector<uint8> Bytes;
+        PixelView          View;
+    };
+
+    uint32 Convert(uint32 Pixel, PixelFormat From, PixelFormat To, SimdLevel Level = SimdLevel::Scalar)
+    {
+        uint32 Result = 0;
+        ConvertPixels({ &Pixel, 1, 1, 4, From }, { &Result, 1, 1, 4, To }, Level);
+        return Result;
+    }
+} // namespace
+
+void PixelFormatTests()
+{
+    // channel orders: the bytes of 0x80FF4020 (A R G B) in each format
+    {
+        uint32 Color    = 0x80FF4020;
+        auto   Rgba     = Convert(Color, PixelFormat::Bgra8, PixelFormat::Rgba8);
+        auto   Argb     = Convert(Color, PixelFormat::Bgra8, PixelFormat::Argb8);
+        auto   Back     = Convert(Argb, PixelFormat::Argb8, PixelFormat::Rgba8);
+        auto   Opaque   = Convert(0x00FF4020, PixelFormat::Bgrx8, PixelFormat::Bgra8);
+        auto   Unpacked = Convert(Rgba, PixelFormat::Rgba8, PixelFormat::Bgra8, GetBestSimdLevel());
+        CHECK_EQ(Rgba, 0x802040FFu);
+        CHECK_EQ(Argb, 0x2040FF80u);
+        CHECK_EQ(Back, Rgba);
+        CHECK_EQ(Opaque, 0xFFFF4020u);
+        CHECK_EQ(Unpacked, Color);
+    }
+
+    // alpha: premultiplied with the rounding of the blits and back, transparent to zero, colors above alpha saturated
+    {
+        auto Premultiplied = Convert(0x80FF4020, PixelFormat::Bgra8, PixelFormat::Bgra8Premultiplied);
+        auto Straight      = Convert(Premultiplied, PixelFormat::Bgra8Premultiplied, PixelFormat::Bgra8);
+        auto Transparent   = Convert(0x00FF4020, PixelFormat::Bgra8Premultiplied, PixelFormat::Bgra8);
+        auto OverBlack     = Convert(0x80FF4020, PixelFormat::Bgra8, PixelFormat::Bgrx8);
+        auto Saturated     = Convert(0x40FF4020, PixelFormat::Bgra8Premultiplied, PixelFormat::Bgra8);
+        CHECK_EQ(Premultiplied, 0x80802010u);
+        CHECK_EQ(Straight, 0x80FF4020u);
+        CHECK_EQ(Transparent, 0u);
+        CHECK_EQ(OverBlack, 0xFF802010u);
+        CHECK_EQ(Saturated, 0x40FFFF80u);
+    }
+
+    // 565 and gray: the pure colors, and the white and black ends
+    {
+        uint16 Packed[4];
+        uint32 Colors[4] = { 0xFFFF0000, 0xFF00FF00, 0xFF0000FF, 0xFFFFFFFF };
+        uint32 Unpacked[4];
+        uint8  Gray[4];
+        ConvertPixels({ Colors, 4, 1, 16, PixelFormat::Bgrx8 }, { Packed, 4, 1, 8, PixelFormat::Rgb565 });
+        ConvertPixels({ Packed, 4, 1, 8, PixelFormat::Rgb565 }, { Unpacked, 4, 1, 16, PixelFormat::Bgrx8 });
+        ConvertPixels({ Colors, 4, 1, 16, PixelFormat::Bgrx8 }, { Gray, 4, 1, 4, PixelFormat::Gray8 });
+        CHECK_EQ(Packed[0], 0xF800);
+        CHECK_EQ(Packed[1], 0x07E0);
+        CHECK_EQ(Packed[2], 0x001F);
+        CHECK_TRUE(Unpacked[0] == Colors[0] && Unpacked[1] == Colors[1] && Unpacked[3] == Colors[3]);
+        CHECK_EQ(Gray[0], 54);
+        CHECK_EQ(Gray[1], 183);
+        CHECK_EQ(Gray[2], 18);
+        CHECK_EQ(Gray[3], 255);
+    }
+
+    // sRGB: the 256 values survive a trip through linear light, the middle gray is a fifth of the light
+    {
+        uint32 Colors[256];
+        uint16 Linear[256 * 4];
+        uint32 Back[256];
+        for (uint32 Index = 0; Index < 256; ++Index)
+        {
+            Colors[Index] = 0xFF000000 | Index * 0x010101u;
+        }
+        PixelView Srgb   = { Colors, 256, 1, 1024, PixelFormat::Bgra8 };
+        PixelView Light  = { Linear, 256, 1, 2048, PixelFormat::Bgra16Linear };
+        PixelView Result = { Back, 256, 1, 1024, PixelFormat::Bgra8 };
+        ConvertPixels(Srgb, Light);
+        ConvertPixels(Light, Result);
+        uint32 Mismatches = 0;
+        for (uint32 Index = 0; Index < 256; ++Index)
+        {
+            Mismatches += Back[Index] != Colors[Index];
+        }
+        CHECK_EQ(Mismatches, 0u);
+        CHECK_EQ(Linear[4 * 128 + 3], 65535);
+        CHECK_TRUE(Linear[4 * 128] > 14000 && Linear[4 * 128] < 14300);
+    }
+
+    // every pair of formats at every level, over odd widths and padded rows: the same bytes as the scalar kernels
+    {
+        SimdLevel Levels[]   = { SimdLevel::Sse2, SimdLevel::Avx2 };
+        uint32    Mismatches = 0;
+        for (auto From : Formats)
+        {
+            for (auto To : Formats)
+            {
+                TestImage Source{ 77, 5, From, 7 };
+                TestImage Expected{ 77, 5, To, 9 };
+                ConvertPixels(Source.View, Expected.View, SimdLevel::Scalar);
+                for (auto Level : Levels)
+                {
+                    if (Level > GetBestSimdLevel())
+                    {
+                        continue;
+                    }
+                    TestImage Actual{ 77, 5, To, 9 };
+                    ConvertPixels(Source.View, Actual.View, Level);
+                    Mismatches += Actual.Bytes != Expected.Bytes;
+                }
+            }
+        }
+        CHECK_EQ(Mismatches, 0u);
+    }
+
+    // tiles: clipped to the image, converted in place without touching the rest
+    {
+        TestImage Image{ 40, 30, PixelFormat::Bgra8, 3 };
+        TestImage Copy{ 40, 30, PixelFormat::Bgra8, 3 };
+        auto      Tile    = GetTile(Image.View, 32, -4, 16, 16);
+        auto      Outside = GetTile(Image.View, 50, 0, 8, 8);
+        CHECK_EQ(Tile.Width, 8);
+        CHECK_EQ(Tile.Height, 12);
+        CHECK_EQ(Outside.Width, 0);
+        auto Premultiplied   = Tile;
+        Premultiplied.Format = PixelFormat::Bgra8Premultiplied;
+        ConvertPixels(Tile, Premultiplied);
+        auto Pixels    = reinterpret_cast<const uint32*>(Image.Bytes.data());
+        auto Original  = reinterpret_cast<const uint32*>(Copy.Bytes.data());
+        auto Stride    = Image.View.Pitch / 4;
+        auto Inside    = Pixels[11 * Stride + 39];
+        auto Reference = Convert(Original[11 * Stride + 39], PixelFormat::Bgra8, PixelFormat::Bgra8Premultiplied);
+        CHECK_EQ(Inside, Reference);
+        CHECK_EQ(Pixels[12 * Stride + 39], Original[12 * Stride + 39]);
+        CHECK_EQ(Pixels[11 * Stride + 31], Original[11 * Stride + 31]);
+    }
+}
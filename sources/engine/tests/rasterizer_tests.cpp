@@ -0,0 +1,169 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <rasterizer.hpp>
+
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    struct Image
+    {
+        Image(int32 Width, int32 Height)
+            : Pixels(size_t(Width) * Height, 0)
+            , Depth(size_t(Width) * Height, 1.0f)
+        {
+            Target = { { Pixels.data(), Width, Height, 4, Width * 4 }, Depth.data() };
+        }
+
+        std::vector<uint32> Pixels;
+        std::vector<real32> Depth;
+        RasterTarget        Target;
+    };
+
+    RasterVertex
+    Vertex(real32 X, real32 Y, real32 Z = 0.5f, real32 W = 1.0f, real32 R = 1.0f, real32 U = 0.0f, real32 V = 0.0f)
+    {
+        return { X, Y, Z, W, R, 1.0f - R, 0.5f, 1.0f, U, V };
+    }
+
+    int32 ChannelDifference(uint32 A, uint32 B)
+    {
+        int32 Max = 0;
+        for (uint32 Shift = 0; Shift < 32; Shift += 8)
+        {
+            auto Difference = int32((A >> Shift) & 0xFF) - int32((B >> Shift) & 0xFF);
+            Difference      = Difference < 0 ? -Difference : Difference;
+            Max             = Difference > Max ? Difference : Max;
+        }
+        return Max;
+    }
+} // namespace
+
+void RasterizerTests()
+{
+    std::vector<uint8> ArenaMemory(8 << 20);
+    MemoryArena        Arena{ ArenaMemory.data(), ArenaMemory.size() };
+
+    // watertight, no double: a jittered grid of triangles covers each pixel of its square exactly once
+    {
+        constexpr int32     Cells = 6;
+        constexpr real32    Cell  = 13.0f;
+        RasterVertex        Grid[Cells + 1][Cells + 1];
+        uint32              Seed = 5;
+        for (int32 Y = 0; Y <= Cells; ++Y)
+        {
+            for (int32 X = 0; X <= Cells; ++X)
+            {
+                Seed         = Seed * 1664525u + 1013904223u;
+                auto Inner   = X > 0 && X < Cells && Y > 0 && Y < Cells;
+                auto JitterX = Inner ? real32((Seed >> 8) % 1000) / 200.0f - 2.5f : 0.0f;
+                auto JitterY = Inner ? real32((Seed >> 18) % 1000) / 200.0f - 2.5f : 0.0f;
+                Grid[Y][X]   = Vertex(10.3f + X * Cell + JitterX, 7.6f + Y * Cell + JitterY);
+            }
+        }
+        std::vector<int> Coverage(100 * 100, 0);
+        for (int32 Y = 0; Y < Cells; ++Y)
+        {
+            for (int32 X = 0; X < Cells; ++X)
+            {
+                const RasterVertex* Triangles[2][3] = {
+                    { &Grid[Y][X], &Grid[Y][X + 1], &Grid[Y + 1][X + 1] },
+                    { &Grid[Y][X], &Grid[Y + 1][X + 1], &Grid[Y + 1][X] },
+                };
+                for (auto& Triangle : Triangles)
+                {
+                    Image           Output{ 100, 100 };
+                    TemporaryMemory Frame{ Arena };
+                    Rasterizer      Rasterizer{ Arena, 1, 100, 100 };
+                    Rasterizer.PushTriangle(*Triangle[0], *Triangle[1], *Triangle[2]);
+                    Rasterizer.Execute(Output.Target, Arena);
+                    for (size_t Index = 0; Index < Coverage.size(); ++Index)
+                    {
+                        Coverage[Index] += Output.Pixels[Index] != 0;
+                    }
+                }
+            }
+        }
+        // pixel centers inside the outer square [10.3, 88.3] x [7.6, 85.6]
+        int Wrong = 0;
+        for (int32 Y = 0; Y < 100; ++Y)
+        {
+            for (int32 X = 0; X < 100; ++X)
+            {
+                auto IsInside = X + 0.5f > 10.3f && X + 0.5f < 88.3f && Y + 0.5f > 7.6f && Y + 0.5f < 85.6f;
+                Wrong += Coverage[Y * 100 + X] != (IsInside ? 1 : 0);
+            }
+        }
+        CHECK_EQ(Wrong, 0);
+    }
+
+    // perspective correction: halfway on screen between W = 1 and W = 3 is a quarter of the way in the attribute
+    {
+        Image           Output{ 64, 64 };
+        TemporaryMemory Frame{ Arena };
+        Rasterizer      Rasterizer{ Arena, 1, 64, 64 };
+        Rasterizer.PushTriangle(Vertex(0, 0, 0.5f, 1, 0), Vertex(64, 0, 0.5f, 3, 1), Vertex(0, 64, 0.5f, 1, 0));
+        Rasterizer.Execute(Output.Target, Arena, nullptr, SimdLevel::Scalar);
+        auto Red = (Output.Pixels[1 * 64 + 31] >> 16) & 0xFF; // pixel center x = 31.5
+        CHECK_TRUE(Red > 60 && Red < 66);
+    }
+
+    // reference image: a textured scene with depth, drawn by the scalar path on one thread, is what the SIMD
+    // paths draw in parallel
+    std::vector<uint32> Texels(16 * 16);
+    for (int32 Index = 0; Index < 16 * 16; ++Index)
+    {
+        Texels[Index] = ((Index / 16 + Index % 16) % 2) ? 0xFFFFFFFF : 0xFF404040;
+    }
+    Bitmap Texture = { Texels.data(), 16, 16, 16 * 4, BitmapAlpha::Opaque };
+
+    auto DrawScene = [&](Image& Output, JobSystem* Jobs, SimdLevel Level) {
+        TemporaryMemory Frame{ Arena };
+        Rasterizer      Rasterizer{ Arena, 512, 203, 150 };
+        uint32          Seed = 17;
+        for (int Index = 0; Index < 300; ++Index)
+        {
+            RasterVertex Vertices[3];
+            for (auto& Vertex : Vertices)
+            {
+                Seed     = Seed * 1664525u + 1013904223u;
+                auto X   = real32((Seed >> 8) % 2600) / 10.0f - 30.0f;
+                Seed     = Seed * 1664525u + 1013904223u;
+                auto Y   = real32((Seed >> 8) % 2000) / 10.0f - 25.0f;
+                Seed     = Seed * 1664525u + 1013904223u;
+                auto W   = 1.0f + real32((Seed >> 8) % 100) / 25.0f;
+                auto Z   = real32((Seed >> 4) % 1000) / 1000.0f;
+                Vertex   = ::Vertex(X, Y, Z, W, real32(Seed % 256) / 255.0f, X / 40.0f, Y / 40.0f);
+            }
+            Rasterizer.PushTriangle(Vertices[0], Vertices[1], Vertices[2], Index % 3 ? &Texture : nullptr);
+        }
+        Rasterizer.Execute(Output.Target, Arena, Jobs, Level);
+        return Rasterizer.GetWrittenPixelCount();
+    };
+    Image Reference{ 203, 150 };
+    auto  ReferenceCount = DrawScene(Reference, nullptr, SimdLevel::Scalar);
+    CHECK_TRUE(ReferenceCount > 203 * 150);
+
+    ThreadPoolJobSystem Jobs{ 3 };
+    SimdLevel           Levels[] = { SimdLevel::Sse2, SimdLevel::Avx2 };
+    for (auto Level : Levels)
+    {
+        if (Level == SimdLevel::Avx2 && !GetCpuFeatures().Avx2)
+        {
+            continue;
+        }
+        Image Output{ 203, 150 };
+        auto  Count = DrawScene(Output, &Jobs, Level);
+        int   Wrong = 0;
+        for (size_t Index = 0; Index < Reference.Pixels.size(); ++Index)
+        {
+            Wrong += ChannelDifference(Reference.Pixels[Index], Output.Pixels[Index]) > 1;
+        }
+        CHECK_EQ(Count, ReferenceCount);
+        CHECK_EQ(Wrong, 0);
+    }
+}
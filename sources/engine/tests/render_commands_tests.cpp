@@ -0,0 +1,129 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <render_commands.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+using namespace Game;
+
+void RenderCommandsTests()
+{
+    // radix sort: sorted, stable
+    std::vector<RenderSortEntry> Entries;
+    uint32                       Seed = 11;
+    for (uint32 Index = 0; Index < 5000; ++Index)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        Entries.push_back({ (Seed >> 20) << (Index % 2 ? 20 : 0), Index });
+    }
+    auto Expected = Entries;
+    std::stable_sort(Expected.begin(), Expected.end(), [](auto& A, auto& B) { return A.Key < B.Key; });
+    std::vector<RenderSortEntry> Temporary(Entries.size());
+    RadixSort(Entries.data(), Temporary.data(), static_cast<uint32>(Entries.size()));
+    auto IsSame = std::equal(Entries.begin(), Entries.end(), Expected.begin(), [](auto& A, auto& B) {
+        return A.Key == B.Key && A.Index == B.Index;
+    });
+    CHECK_TRUE(IsSame);
+
+    // job system: every index once
+    ThreadPoolJobSystem           Jobs{ 3 };
+    std::vector<std::atomic<int>> Hits(1000);
+    for (int Repeat = 0; Repeat < 20; ++Repeat)
+    {
+        ParallelFor(&Jobs, 1000, [&](uint32 Index) { ++Hits[Index]; });
+    }
+    int Wrong = 0;
+    for (auto& Hit : Hits)
+    {
+        Wrong += Hit != 20;
+    }
+    CHECK_EQ(Wrong, 0);
+
+    // sorted, tiled and parallel execution draws like the commands drawn one by one in key order
+    constexpr int32     Width  = 300;
+    constexpr int32     Height = 200;
+    std::vector<uint32> Sprite(20 * 30);
+    for (size_t Index = 0; Index < Sprite.size(); ++Index)
+    {
+        auto A        = static_cast<uint32>(Index * 7 % 256);
+        Sprite[Index] = (A << 24) | ((A / 2) << 16) | (A / 3);
+    }
+    Bitmap Bitmap = { Sprite.data(), 20, 30, 20 * 4, BitmapAlpha::Blend };
+
+    std::vector<uint8>  ArenaMemory(1 << 20);
+    MemoryArena         Arena{ ArenaMemory.data(), ArenaMemory.size() };
+    RenderCommandBuffer Commands{ Arena, 1024, Width, Height };
+
+    struct Draw
+    {
+        uint32 Key;
+        int32  X;
+        int32  Y;
+        uint32 Kind; // bitmap, rectangle, clear
+    };
+    std::vector<Draw> Draws;
+    for (uint32 Index = 0; Index < 300; ++Index)
+    {
+        Seed   = Seed * 1664525u + 1013904223u;
+        auto X = int32((Seed >> 8) % (Width + 80)) - 40;
+        Seed   = Seed * 1664525u + 1013904223u;
+        auto Y = int32((Seed >> 8) % (Height + 80)) - 40;
+        Draws.push_back({ (Seed >> 4) % 8, X, Y, Index % 2 });
+    }
+    Draws[150] = { 3, 0, 0, 2 };
+    auto Render = [&](RenderCommandBuffer& Buffer, const std::vector<Draw>& List) {
+        for (auto& Draw : List)
+        {
+            switch (Draw.Kind)
+            {
+            case 0:
+                Buffer.PushBitmap(Draw.Key, Bitmap, Draw.X, Draw.Y);
+                break;
+            case 1:
+                Buffer.PushRectangle(Draw.Key, { Draw.X, Draw.Y, Draw.X + 33, Draw.Y + 17 }, 0x80402000 + Draw.Key);
+                break;
+            default:
+                Buffer.PushClear(Draw.Key, 0xFF000010);
+                break;
+            }
+        }
+    };
+    Render(Commands, Draws);
+    CHECK_EQ(Commands.GetCommandCount() + Commands.GetCulledCount(), 300u);
+    CHECK_TRUE(Commands.GetCulledCount() > 0);
+
+    std::vector<uint32> Tiled(Width * Height, 0x11223344);
+    PIBackBuffer        TiledBuffer = { Tiled.data(), Width, Height, 4, Width * 4 };
+    Commands.Execute(TiledBuffer, Arena, &Jobs);
+    CHECK_EQ(Commands.GetCommandCount(), 0u);
+
+    // reference: one command at a time in key order, in a buffer as large as the target (one tile)
+    std::stable_sort(Draws.begin(), Draws.end(), [](auto& A, auto& B) { return A.Key < B.Key; });
+    std::vector<uint32> Reference(Width * Height, 0x11223344);
+    PIBackBuffer        ReferenceBuffer = { Reference.data(), Width, Height, 4, Width * 4 };
+    for (auto& Draw : Draws)
+    {
+        RenderCommandBuffer One{ Arena, 1, Width, Height };
+        Render(One, { Draw });
+        One.Execute(ReferenceBuffer, Arena, nullptr, SimdLevel::Scalar);
+    }
+    CHECK_TRUE(Tiled == Reference);
+
+    // a translucent clear blends over the commands before it
+    {
+        std::vector<uint32> Pixels(Width * Height, 0xFF000000);
+        PIBackBuffer        Target = { Pixels.data(), Width, Height, 4, Width * 4 };
+        RenderCommandBuffer Layers{ Arena, 4, Width, Height };
+        Layers.PushRectangle(0, { 0, 0, 10, 10 }, 0xFFFF0000);
+        Layers.PushClear(1, 0x800000FF);
+        Layers.Execute(Target, Arena, &Jobs);
+        auto Inside  = Pixels[0];
+        auto Outside = Pixels[20];
+        CHECK_EQ(Inside, Blit::BlendPixel(0x800000FF, 0xFFFF0000));
+        CHECK_EQ(Outside, Blit::BlendPixel(0x800000FF, 0xFF000000));
+    }
+}
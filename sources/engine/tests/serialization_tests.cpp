@@ -0,0 +1,257 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <serialization.hpp>
+
+#include "../../strong_type/strong_type.h"
+#include "../../wit/nonintegral_enum.hpp"
+#include "../../wit/quantity.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    struct Health : wit::strong_type<int32, Health, wit::comparable>
+    {
+        using strong_type::strong_type;
+        using strong_type::get_value;
+    };
+
+    struct Armor : wit::strong_type<int32, Armor>
+    {
+        using strong_type::strong_type;
+    };
+
+    struct Weapon : wit::nonintegral_enum<Weapon>
+    {
+        struct Sword : value<Sword>
+        {};
+        struct Bow : value<Bow>
+        {};
+        using values_type = std::tuple<Sword, Bow>;
+        using nonintegral_enum::nonintegral_enum;
+    };
+
+    struct Weapons2 : wit::nonintegral_enum<Weapons2>
+    {
+        struct Bow : value<Bow>
+        {};
+        struct Sword : value<Sword>
+        {};
+        using values_type = std::tuple<Bow, Sword>;
+        using nonintegral_enum::nonintegral_enum;
+    };
+
+    enum class Team : uint8
+    {
+        Red,
+        Blue
+    };
+
+    struct Unit
+    {
+        wit::Meter          X;
+        wit::Meter          Y;
+        Health              Life;
+        SerialEnum<Weapon>  Equipped;
+        Team                Side;
+        SerialArray<uint16> Items;
+
+        static constexpr auto GetSerialFields()
+        {
+            return std::make_tuple(GAME_SERIAL_FIELD(Unit, X), GAME_SERIAL_FIELD(Unit, Y),
+                                   GAME_SERIAL_FIELD(Unit, Life), GAME_SERIAL_FIELD(Unit, Equipped),
+                                   GAME_SERIAL_FIELD(Unit, Side), GAME_SERIAL_FIELD(Unit, Items));
+        }
+    };
+
+    struct Level
+    {
+        uint32            Seed;
+        real32            Gravity[2];
+        SerialString      Name;
+        SerialArray<Unit> Units;
+
+        static constexpr uint32 SerialVersion = 1;
+        static constexpr auto   GetSerialFields()
+        {
+            return std::make_tuple(GAME_SERIAL_FIELD(Level, Seed), GAME_SERIAL_FIELD(Level, Gravity),
+                                   GAME_SERIAL_FIELD(Level, Name), GAME_SERIAL_FIELD(Level, Units));
+        }
+    };
+
+    // the same layout as Level, another version
+    struct LevelV2
+    {
+        uint32            Seed;
+        real32            Gravity[2];
+        SerialString      Name;
+        SerialArray<Unit> Units;
+
+        static constexpr uint32 SerialVersion = 2;
+        static constexpr auto   GetSerialFields()
+        {
+            return std::make_tuple(GAME_SERIAL_FIELD(LevelV2, Seed), GAME_SERIAL_FIELD(LevelV2, Gravity),
+                                   GAME_SERIAL_FIELD(LevelV2, Name), GAME_SERIAL_FIELD(LevelV2, Units));
+        }
+    };
+
+    template <typename X, typename L, typename E>
+    struct Changed
+    {
+        X             Value;
+        L             Life;
+        SerialEnum<E> Equipped;
+
+        static constexpr auto GetSerialFields()
+        {
+            return std::make_tuple(GAME_SERIAL_FIELD(Changed, Value), GAME_SERIAL_FIELD(Changed, Life),
+                                   GAME_SERIAL_FIELD(Changed, Equipped));
+        }
+    };
+
+    constexpr uint64 Reference = GetSchemaHash<Changed<wit::Meter, Health, Weapon>>();
+
+    // the field lists which do not cover their struct: a member left out, two swapped, one listed twice
+    struct Padded
+    {
+        uint8  Kind;
+        uint32 Count;
+        uint16 Flags;
+
+        static constexpr auto GetSerialFields()
+        {
+            return std::make_tuple(GAME_SERIAL_FIELD(Padded, Kind), GAME_SERIAL_FIELD(Padded, Count),
+                                   GAME_SERIAL_FIELD(Padded, Flags));
+        }
+    };
+
+    template <int32 List>
+    struct Listed
+    {
+        uint32 A;
+        uint32 B;
+
+        static constexpr auto GetSerialFields()
+        {
+            if constexpr (List == 0)
+            {
+                return std::make_tuple(GAME_SERIAL_FIELD(Listed, A));
+            }
+            else if constexpr (List == 1)
+            {
+                return std::make_tuple(GAME_SERIAL_FIELD(Listed, B), GAME_SERIAL_FIELD(Listed, A));
+            }
+            else
+            {
+                return std::make_tuple(GAME_SERIAL_FIELD(Listed, A), GAME_SERIAL_FIELD(Listed, A));
+            }
+        }
+    };
+} // namespace
+
+// every member in order, padding included, or nothing: the offsets are in the schema
+static_assert(Serialization::AreFieldsComplete<Padded>());
+static_assert(Serialization::AreFieldsComplete<Level>());
+static_assert(!Serialization::AreFieldsComplete<Listed<0>>());
+static_assert(!Serialization::AreFieldsComplete<Listed<1>>());
+static_assert(!Serialization::AreFieldsComplete<Listed<2>>());
+
+// the schema tells the units, the strong types and the names of the enum values apart
+static_assert(GetSchemaHash<Level>() != GetSchemaHash<LevelV2>());
+static_assert(Reference != GetSchemaHash<Changed<wit::Second, Health, Weapon>>());
+static_assert(Reference != GetSchemaHash<Changed<wit::Meter, Armor, Weapon>>());
+static_assert(Reference != GetSchemaHash<Changed<wit::Meter, Health, Weapons2>>());
+static_assert(Reference == GetSchemaHash<Changed<wit::Meter, Health, Weapon>>());
+static_assert(GetSchemaHash<uint32>() != GetSchemaHash<int32>());
+static_assert(Serialization::GetShortTypeName<Weapon::Sword>() == "Sword");
+
+void SerializationTests()
+{
+    std::vector<uint8> Memory(1 << 20);
+    MemoryArena        Arena{ Memory.data(), Memory.size() };
+    SerialWriter       Writer{ Arena, 64 * 1024 };
+
+    // write a level with nested arrays
+    auto Root        = Writer.PushRoot<Level>();
+    Root->Seed       = 1234;
+    Root->Gravity[1] = -9.81f;
+    Writer.PushString(Root->Name, "forest");
+    auto Units = Writer.PushArray(Root->Units, 3);
+    for (uint16 Index = 0; Index < 3; ++Index)
+    {
+        Units[Index].X    = wit::Meter{ 1.5f * Index };
+        Units[Index].Y    = wit::Meter{ -2.0f };
+        Units[Index].Life = Health{ 100 - Index };
+        Units[Index].Equipped.Set(Index == 1 ? Weapon{ Weapon::Bow{} } : Weapon{ Weapon::Sword{} });
+        Units[Index].Side = Index ? Team::Blue : Team::Red;
+        uint16 Items[]    = { uint16(Index), uint16(Index * 10), 7 };
+        Writer.PushArray(Units[Index].Items, Items, Index);
+    }
+    auto Size = Writer.Finish<Level>();
+    CHECK_GT(Size, sizeof(Level) + 3 * sizeof(Unit));
+
+    // read in place, from a copy: the offsets are relative
+    std::vector<uint8> Copy(Size + 64);
+    auto               Aligned = Copy.data() + (64 - reinterpret_cast<uintptr_t>(Copy.data()) % 64) % 64;
+    memcpy(Aligned, Writer.GetData(), Size);
+    auto Level0 = ReadSerial<Level>(Aligned, Size);
+    CHECK_TRUE(Level0 != nullptr);
+    if (Level0)
+    {
+        CHECK_EQ(Level0->Seed, 1234u);
+        CHECK_EQ(Level0->Gravity[1], -9.81f);
+        CHECK_EQ(Level0->Name.GetView(), std::string_view{ "forest" });
+        CHECK_EQ(Level0->Units.GetCount(), 3u);
+        auto& Second = Level0->Units[1];
+        CHECK_EQ(Second.X.value_, 1.5f);
+        CHECK_EQ(Second.Life.get_value(), 99);
+        CHECK_TRUE(Second.Equipped.Get() == Weapon::Bow{});
+        CHECK_TRUE(Level0->Units[2].Equipped.Get() == Weapon::Sword{});
+        CHECK_TRUE(Second.Side == Team::Blue);
+        CHECK_EQ(Second.Items.GetCount(), 1u);
+        CHECK_EQ(Level0->Units[2].Items[1], uint16(20));
+        CHECK_EQ(Level0->Units[0].Items.GetCount(), 0u);
+    }
+
+    // rejected: another schema, a truncated block, a reference outside, an unknown enum value
+    if (Level0)
+    {
+        CHECK_TRUE(ReadSerial<LevelV2>(Aligned, Size) == nullptr);
+        CHECK_TRUE(ReadSerial<Level>(Aligned, Size - 1) == nullptr);
+        CHECK_TRUE(ReadSerial<Level>(Aligned, 8) == nullptr);
+
+        auto Units           = const_cast<Unit*>(Level0->Units.GetData());
+        Units[2].Items.Count = 1000;
+        CHECK_TRUE(ReadSerial<Level>(Aligned, Size) == nullptr);
+        Units[2].Items.Count    = 2;
+        Units[1].Equipped.Index = 3;
+        CHECK_TRUE(ReadSerial<Level>(Aligned, Size) == nullptr);
+        Units[1].Equipped.Index = 0;
+        CHECK_TRUE(ReadSerial<Level>(Aligned, Size) != nullptr);
+        CHECK_TRUE(Level0->Units[1].Equipped.Get() == Weapon::Invalid{});
+
+        auto Name = const_cast<char*>(Level0->Name.c_str());
+        Name[6]   = 'x'; // the null
+        CHECK_TRUE(ReadSerial<Level>(Aligned, Size) == nullptr);
+    }
+
+    // a block which does not fit
+    {
+        SerialWriter Small{ Arena, 128 };
+        std::string  Long(100, 'x');
+        auto         Tiny = Small.PushRoot<Level>();
+        CHECK_TRUE(Tiny != nullptr);
+        CHECK_FALSE(Small.PushString(Tiny->Name, Long));
+        CHECK_TRUE(Small.PushArray(Tiny->Units, 10) == nullptr);
+        CHECK_TRUE(Small.HasOverflowed());
+        CHECK_EQ(Small.Finish<Level>(), 0u);
+        Small.Reset();
+        CHECK_TRUE(Small.PushRoot<Level>() != nullptr);
+        CHECK_GT(Small.Finish<Level>(), 0u);
+    }
+}
@@ -0,0 +1,171 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <snapshot.hpp>
+
+#if !_WIN32
+#include "../linux/write_fault_page_tracker.hpp"
+#endif
+
+#include <cstring>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    bool Append(void* Context, const void* Data, uint64 Size)
+    {
+        auto Stream = static_cast<std::vector<uint8>*>(Context);
+        Stream->insert(Stream->end(), static_cast<const uint8*>(Data), static_cast<const uint8*>(Data) + Size);
+        return true;
+    }
+
+    bool Fail(void*, const void*, uint64) { return false; }
+
+    uint32 Random(uint32& Seed)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        return Seed >> 8;
+    }
+
+    // a few words in a few pages, one run of pages filled with noise
+    void Modify(uint8* Storage, uint64 Size, uint32& Seed)
+    {
+        for (uint32 Write = 0; Write < 20; ++Write)
+        {
+            Storage[Random(Seed) % Size] = uint8(Random(Seed));
+        }
+        auto Offset = Random(Seed) % (Size - 5 * PageTracker::PageSize);
+        for (uint64 Byte = Offset; Byte < Offset + 5 * PageTracker::PageSize; ++Byte)
+        {
+            Storage[Byte] = uint8(Random(Seed));
+        }
+    }
+} // namespace
+
+void SnapshotTests()
+{
+    std::vector<uint8> Memory(8 << 20);
+    MemoryArena        Arena{ Memory.data(), Memory.size() };
+
+    // the hash tracker reports the written pages once, a partial last page included
+    {
+        constexpr uint64   Size = 10 * PageTracker::PageSize + 100;
+        std::vector<uint8> Storage(Size);
+        HashPageTracker    Tracker{ Arena, Storage.data(), Size };
+        uint64             Bits  = ~0ULL;
+        CHECK_TRUE(Tracker.IsValid());
+        CHECK_EQ(Tracker.GetPageCount(), 11u);
+        Tracker.CollectDirtyPages(&Bits);
+        CHECK_EQ(Bits, 0u);
+
+        Storage[3 * PageTracker::PageSize + 7] = 1;
+        Storage[Size - 1]                      = 2;
+        Tracker.CollectDirtyPages(&Bits);
+        CHECK_EQ(Bits, (1u << 3 | 1u << 10));
+        Tracker.CollectDirtyPages(&Bits);
+        CHECK_EQ(Bits, 0u);
+    }
+
+    // a base then deltas: every prefix of the stream restores the state of its capture
+    {
+        constexpr uint64   Size  = 300 * PageTracker::PageSize + 1000;
+        constexpr uint32   Count = 6;
+        std::vector<uint8> Storage(Size);
+        std::vector<uint8> Stream;
+        std::vector<uint8> States[Count];
+        std::vector<uint8> Restored(Size, 0xCD);
+        uint32             Seed = 5;
+        HashPageTracker    Tracker{ Arena, Storage.data(), Size };
+        {
+            SnapshotWriter Writer{ Arena, Storage.data(), Size, Tracker, { &Stream, &Append } };
+            CHECK_TRUE(Writer.IsValid());
+            for (uint32 Capture = 0; Capture < Count; ++Capture)
+            {
+                Modify(Storage.data(), Size, Seed);
+                States[Capture] = Storage;
+                auto Pages      = Writer.Capture();
+                CHECK_TRUE(Pages >= 5 && Pages <= 26);
+            }
+            Writer.Wait();
+            CHECK_EQ(Writer.GetCaptureCount(), Count);
+            CHECK_EQ(Writer.GetWrittenSize(), uint64(Stream.size()));
+            CHECK_TRUE(!Writer.HasFailed());
+        }
+        CHECK_TRUE(Stream.size() < Count * 8 * PageTracker::PageSize);
+
+        for (uint32 Capture = 0; Capture < Count; ++Capture)
+        {
+            CHECK_EQ(Snapshot::Restore(Stream.data(), Stream.size(), Restored.data(), Size, Capture + 1), Capture + 1);
+            CHECK_TRUE(Restored == States[Capture]);
+        }
+
+        // a truncated tail is left out, the wrong storage or a corrupted header restore nothing
+        CHECK_EQ(Snapshot::Restore(Stream.data(), Stream.size() - 10, Restored.data(), Size), Count - 1);
+        CHECK_TRUE(Restored == States[Count - 2]);
+        CHECK_EQ(Snapshot::Restore(Stream.data(), Stream.size(), Restored.data(), Size - 1), 0u);
+        Stream[0] ^= 1;
+        CHECK_EQ(Snapshot::Restore(Stream.data(), Stream.size(), Restored.data(), Size), 0u);
+    }
+
+    // a failing sink is reported, incompressible pages are stored as they are
+    {
+        constexpr uint64   Size = 8 * PageTracker::PageSize;
+        std::vector<uint8> Storage(Size);
+        std::vector<uint8> Stream;
+        std::vector<uint8> Restored(Size);
+        uint32             Seed = 9;
+        for (auto& Byte : Storage)
+        {
+            Byte = uint8(Random(Seed));
+        }
+        HashPageTracker Tracker{ Arena, Storage.data(), Size };
+        {
+            SnapshotWriter Writer{ Arena, Storage.data(), Size, Tracker, { nullptr, &Fail } };
+            auto Pages = Writer.Capture();
+            Writer.Wait();
+            CHECK_EQ(Pages, 8u);
+            CHECK_TRUE(Writer.HasFailed());
+        }
+        HashPageTracker Second{ Arena, Storage.data(), Size };
+        {
+            SnapshotWriter Writer{ Arena, Storage.data(), Size, Second, { &Stream, &Append } };
+            Writer.Capture();
+        }
+        CHECK_EQ(Stream.size(), sizeof(Snapshot::RecordHeader) + sizeof(Snapshot::RunHeader) + Size);
+        CHECK_EQ(Snapshot::Restore(Stream.data(), Stream.size(), Restored.data(), Size), 1u);
+        CHECK_TRUE(Restored == Storage);
+    }
+
+#if !_WIN32
+    // write faults: only the written pages, without reading the block
+    {
+        constexpr uint64 Size    = 64 * PageTracker::PageSize;
+        auto             Storage = static_cast<uint8*>(
+            mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        {
+            Linux::WriteFaultPageTracker Tracker{ Arena, Storage, Size };
+            Linux::WriteFaultPageTracker Other{ Arena, Storage, Size };
+            CHECK_TRUE(Tracker.IsValid());
+            CHECK_TRUE(!Other.IsValid());
+
+            uint64 Bits = ~0ULL;
+            Storage[5 * PageTracker::PageSize]      = 1;
+            Storage[5 * PageTracker::PageSize + 10] = 2;
+            Storage[63 * PageTracker::PageSize + 9] = 3;
+            Tracker.CollectDirtyPages(&Bits);
+            CHECK_EQ(Bits, (1ULL << 5 | 1ULL << 63));
+            Tracker.CollectDirtyPages(&Bits);
+            CHECK_EQ(Bits, 0u);
+            Storage[5 * PageTracker::PageSize] = 4;
+            Tracker.CollectDirtyPages(&Bits);
+            CHECK_EQ(Bits, 1ULL << 5);
+        }
+        Storage[0] = 1; // writable again
+        CHECK_EQ(Storage[5 * PageTracker::PageSize + 10], 2);
+        munmap(Storage, Size);
+    }
+#endif
+}
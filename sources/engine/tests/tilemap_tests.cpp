@@ -0,0 +1,230 @@
+#include "engine_tests.hpp"
+
+#include "simple_tests.hpp"
+
+#include <tilemap.hpp>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace Game;
+
+namespace
+{
+    constexpr int32 TileSize = 8;
+
+    // 4 tiles of 8x8 in a 2x2 atlas, the last rows transparent when Rows < TileSize
+    std::vector<uint32> MakeAtlas(int32 Rows)
+    {
+        std::vector<uint32> Pixels(4 * TileSize * TileSize);
+        for (int32 Y = 0; Y < 2 * TileSize; ++Y)
+        {
+            for (int32 X = 0; X < 2 * TileSize; ++X)
+            {
+                auto Cell                    = uint32(Y / TileSize * 2 + X / TileSize);
+                auto Color                   = 0xFF000000 | (Cell << 20) | uint32(Y << 8 | X);
+                Pixels[Y * 2 * TileSize + X] = Y % TileSize < Rows ? Color : 0;
+            }
+        }
+        return Pixels;
+    }
+
+    TileId MakeTile(int32 X, int32 Y) { return TileId((X * 7 + Y * 13) % 5); }
+
+    // fills a map with MakeTile, the reference drawing is done tile per tile
+    void Fill(TileMap& Map)
+    {
+        for (int32 Y = 0; Y < Map.GetHeight(); ++Y)
+        {
+            for (int32 X = 0; X < Map.GetWidth(); ++X)
+            {
+                Map.SetTile(X, Y, MakeTile(X, Y));
+            }
+        }
+    }
+
+    std::vector<uint32>
+    DrawReference(const Tileset& Tiles, TileMap& Map, int32 Width, int32 Height, int32 CameraX, int32 CameraY)
+    {
+        std::vector<uint32> Pixels(size_t(Width) * Height, 0x00123456);
+        PIBackBuffer        Buffer = { Pixels.data(), Width, Height, 4, Width * 4 };
+        for (int32 Y = 0; Y < Map.GetHeight(); ++Y)
+        {
+            for (int32 X = 0; X < Map.GetWidth(); ++X)
+            {
+                auto ShiftX = Tiles.Shape == TileShape::Hexagon && (Y & 1) ? Tiles.TileWidth / 2 : 0;
+                auto PixelX = X * Tiles.TileWidth + ShiftX - CameraX;
+                auto PixelY = Y * Tiles.GetRowStep() - CameraY;
+                if (auto Id = Map.GetTile(X, Y))
+                {
+                    DrawBitmap(Buffer, Tiles.GetTile(Id), PixelX, PixelY);
+                }
+            }
+        }
+        return Pixels;
+    }
+
+    std::vector<uint32> Draw(TileMap& Map, int32 Width, int32 Height, int32 CameraX, int32 CameraY)
+    {
+        std::vector<uint32> Pixels(size_t(Width) * Height, 0x00123456);
+        Map.Draw({ Pixels.data(), Width, Height, 4, Width * 4 }, CameraX, CameraY);
+        return Pixels;
+    }
+
+    struct Storage
+    {
+        std::map<std::pair<int32, int32>, std::vector<TileId>> Chunks;
+    };
+
+    void LoadChunk(void* Context, int32 ChunkX, int32 ChunkY, TileId* Tiles)
+    {
+        auto& Chunks = static_cast<Storage*>(Context)->Chunks;
+        auto  Stored = Chunks.find({ ChunkX, ChunkY });
+        for (int32 Index = 0; Index < TileMap::ChunkTileCount; ++Index)
+        {
+            auto X       = ChunkX * TileMap::ChunkSize + Index % TileMap::ChunkSize;
+            auto Y       = ChunkY * TileMap::ChunkSize + Index / TileMap::ChunkSize;
+            Tiles[Index] = Stored != Chunks.end() ? Stored->second[Index] : MakeTile(X, Y);
+        }
+    }
+
+    void StoreChunk(void* Context, int32 ChunkX, int32 ChunkY, const TileId* Tiles)
+    {
+        static_cast<Storage*>(Context)->Chunks[{ ChunkX, ChunkY }].assign(Tiles, Tiles + TileMap::ChunkTileCount);
+    }
+} // namespace
+
+void TileMapTests()
+{
+    std::vector<uint8> Memory(16 << 20);
+    MemoryArena        Arena{ Memory.data(), Memory.size() };
+
+    auto    Opaque    = MakeAtlas(TileSize);
+    Tileset Rectangle = { { Opaque.data(), 2 * TileSize, 2 * TileSize, 2 * TileSize * 4, BitmapAlpha::Opaque },
+                          TileSize,
+                          TileSize,
+                          TileShape::Rectangle };
+
+    // chunk bitmaps give the same image as the tiles drawn one by one, empty tiles and partial chunks included
+    {
+        TemporaryMemory Scope{ Arena };
+        TileMap         Map{ Arena, 41, 37, Rectangle, 16, 16 };
+        CHECK_TRUE(Map.IsValid());
+        Fill(Map);
+        CHECK_TRUE(Draw(Map, 200, 150, 13, -7) == DrawReference(Rectangle, Map, 200, 150, 13, -7));
+        CHECK_TRUE(Draw(Map, 90, 70, 211, 190) == DrawReference(Rectangle, Map, 90, 70, 211, 190));
+    }
+
+    // hexagons overlap the next chunks by half a tile
+    {
+        auto    Masked  = MakeAtlas(6);
+        Tileset Hexagon = { { Masked.data(), 2 * TileSize, 2 * TileSize, 2 * TileSize * 4, BitmapAlpha::Mask },
+                            TileSize,
+                            TileSize,
+                            TileShape::Hexagon };
+
+        TemporaryMemory Scope{ Arena };
+        TileMap         Map{ Arena, 40, 35, Hexagon, 16, 16 };
+        Fill(Map);
+        CHECK_TRUE(Draw(Map, 250, 180, 20, 3) == DrawReference(Hexagon, Map, 250, 180, 20, 3));
+        CHECK_TRUE(Draw(Map, 150, 100, 129, 90) == DrawReference(Hexagon, Map, 150, 100, 129, 90));
+    }
+
+    // a chunk bitmap is only built again when one of its tiles changes
+    {
+        TemporaryMemory Scope{ Arena };
+        TileMap         Map{ Arena, 64, 64, Rectangle, 16, 16 };
+        Fill(Map);
+        Draw(Map, 512, 512, 0, 0);
+        auto Built = Map.GetCacheBuildCount();
+        CHECK_EQ(Built, 16u);
+        Draw(Map, 512, 512, 0, 0);
+        CHECK_EQ(Map.GetCacheBuildCount(), Built);
+
+        Map.SetTile(20, 40, 4);
+        Map.SetTile(21, 40, 4); // same chunk
+        Map.SetTile(22, 40, 4);
+        CHECK_TRUE(Draw(Map, 512, 512, 0, 0) == DrawReference(Rectangle, Map, 512, 512, 0, 0));
+        CHECK_EQ(Map.GetCacheBuildCount(), Built + 1);
+    }
+
+    // chunks out of the resident set are stored when modified then loaded again
+    {
+        Storage         Stored;
+        TemporaryMemory Scope{ Arena };
+        TileMap         Map{ Arena, 1024, 1024, Rectangle, 8, 4 };
+        Map.SetStreamer({ &Stored, LoadChunk, StoreChunk });
+        CHECK_TRUE(Map.SetTile(5, 5, 3));
+        CHECK_EQ(Map.GetTile(6, 5), MakeTile(6, 5));
+        for (int32 Step = 0; Step < 8; ++Step)
+        {
+            Draw(Map, 64, 64, 1000 + Step * 1024, 3000);
+        }
+        CHECK_EQ(Map.GetStoreCount(), 1u);
+        CHECK_EQ(Stored.Chunks.size(), 1u);
+        CHECK_EQ(Map.GetTile(5, 5), 3);
+        CHECK_EQ(Map.GetTile(6, 5), MakeTile(6, 5));
+        CHECK_EQ(Map.GetDroppedCount(), 0u);
+    }
+
+    // between two draws any chunk can be evicted: more chunks touched than resident slots
+    {
+        Storage         Stored;
+        TemporaryMemory Scope{ Arena };
+        TileMap         Map{ Arena, 1024, 1024, Rectangle, 8, 4 };
+        Map.SetStreamer({ &Stored, LoadChunk, StoreChunk });
+        Draw(Map, 64, 64, 0, 0);
+        int32 Failed = 0;
+        int32 Wrong  = 0;
+        for (int32 Chunk = 0; Chunk < 20; ++Chunk)
+        {
+            Failed += !Map.SetTile(Chunk * TileMap::ChunkSize + 1, 7, TileId(Chunk % 3 + 1));
+            Wrong += Map.GetTile(Chunk * TileMap::ChunkSize + 2, 900) != MakeTile(Chunk * TileMap::ChunkSize + 2, 900);
+        }
+        for (int32 Chunk = 0; Chunk < 20; ++Chunk)
+        {
+            Wrong += Map.GetTile(Chunk * TileMap::ChunkSize + 1, 7) != TileId(Chunk % 3 + 1);
+        }
+        CHECK_EQ(Failed, 0);
+        CHECK_EQ(Wrong, 0);
+        CHECK_TRUE(Draw(Map, 64, 64, 0, 0) == DrawReference(Rectangle, Map, 64, 64, 0, 0));
+        CHECK_EQ(Map.GetDroppedCount(), 0u);
+    }
+
+    // without a place to store them, modified chunks stay resident
+    {
+        TemporaryMemory Scope{ Arena };
+        TileMap         Map{ Arena, 1024, 1024, Rectangle, 8, 4 };
+        CHECK_TRUE(Map.SetTile(5, 5, 3));
+        for (int32 Step = 0; Step < 8; ++Step)
+        {
+            Draw(Map, 64, 64, 1000 + Step * 1024, 3000);
+        }
+        CHECK_EQ(Map.GetTile(5, 5), 3);
+        CHECK_EQ(Map.GetTile(6, 5), EmptyTile);
+    }
+
+    // 10^8 tiles: only the chunk directory grows with the map
+    {
+        TemporaryMemory Scope{ Arena };
+        auto            Used = Arena.GetUsed();
+        TileMap         Map{ Arena, 10000, 10000, Rectangle, 64, 32 };
+        Storage         Generated;
+        Map.SetStreamer({ &Generated, LoadChunk, nullptr });
+        CHECK_TRUE(Map.IsValid());
+        CHECK_LT(Arena.GetUsed() - Used, 4u << 20);
+        // the reference would walk the whole map: check the pixels in the view corners
+        auto Pixels = Draw(Map, 300, 200, 51234, 70001);
+        int  Wrong  = 0;
+        for (auto Pixel : { 0, 299, 199 * 300, 199 * 300 + 299 })
+        {
+            auto X  = 51234 + Pixel % 300;
+            auto Y  = 70001 + Pixel / 300;
+            auto Id = MakeTile(X / TileSize, Y / TileSize);
+            Wrong += Pixels[Pixel] != (Id ? Rectangle.GetTile(Id).GetRow(Y % TileSize)[X % TileSize] : 0x00123456);
+        }
+        CHECK_EQ(Wrong, 0);
+        CHECK_EQ(Map.GetDroppedCount(), 0u);
+    }
+}
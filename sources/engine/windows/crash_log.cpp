@@ -0,0 +1,49 @@
+#include "crash_log.hpp"
+
+namespace Windows
+{
+
+    CrashLog* CrashLog::Instance = nullptr;
+
+    CrashLog::CrashLog(Game::Logger& Log, const char* Path)
+        : Log{ Log }
+        , Path{ Path }
+    {
+        Instance = this;
+        Previous = SetUnhandledExceptionFilter(&OnException);
+    }
+
+    CrashLog::~CrashLog()
+    {
+        SetUnhandledExceptionFilter(Previous);
+        Instance = nullptr;
+    }
+
+    LONG WINAPI CrashLog::OnException(EXCEPTION_POINTERS* Exception)
+    {
+        auto Self = Instance;
+        if (!Self)
+        {
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+
+        auto File = CreateFileA(Self->Path, FILE_APPEND_DATA, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (File != INVALID_HANDLE_VALUE)
+        {
+            auto Write = [](void* Context, const char* Text, uint32 Size) {
+                DWORD Written;
+                WriteFile(*static_cast<HANDLE*>(Context), Text, Size, &Written, nullptr);
+            };
+
+            char Line[64];
+            auto Text = Game::Format(Line, GAME_FORMAT_STRING("crash: exception 0x{:08x}\n"),
+                                     uint32(Exception->ExceptionRecord->ExceptionCode));
+            Write(&File, Text.data(), uint32(Text.size()));
+            Self->Log.Drain({ &File, Write }, true); // only a "log not drained" line when a drain was in progress
+            CloseHandle(File);
+        }
+        return Self->Previous ? Self->Previous(Exception) : EXCEPTION_CONTINUE_SEARCH;
+    }
+
+} // namespace Windows
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <logger.hpp>
+
+#include <Windows.h>
+
+namespace Windows
+{
+
+    // Unhandled exception filter of the logger: the entries still in the rings are formatted and appended to a file,
+    // then the previous filter runs
+    class CrashLog final
+    {
+    public:
+        CrashLog(Game::Logger& Log, const char* Path);
+        CrashLog(const CrashLog&) = delete; // non copyable
+        ~CrashLog();
+
+    private:
+        static LONG WINAPI OnException(EXCEPTION_POINTERS* Exception);
+
+        static CrashLog* Instance;
+
+        Game::Logger&                Log;
+        const char*                  Path;
+        LPTOP_LEVEL_EXCEPTION_FILTER Previous = nullptr;
+    };
+
+} // namespace Windows
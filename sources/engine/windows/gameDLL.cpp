@@ -1,6 +1,11 @@
 #include "gameDLL.hpp"
 
+#include "hdtimer.hpp"
+
+#include <logger.hpp>
+
 #include <cstdio>
+#include <cstring>
 
 static void CatStrings(size_t      SourceACount,
                        const char* SourceA,
@@ -45,6 +50,23 @@ static void BuildPath(const Windows::win32_state& State, const char* FileName, s
                Dest);
 }
 
+// "game.dll" -> "game_<Index>.dll"
+static void BuildIndexedPath(const Windows::win32_state& State,
+                             const char*                 FileName,
+                             unsigned                    Index,
+                             size_t                      DestCount,
+                             char*                       Dest)
+{
+    char        IndexedName[Windows::WIN32_STATE_FILE_NAME_COUNT];
+    const char* Extension = strrchr(FileName, '.');
+    if (!Extension)
+    {
+        Extension = FileName + StringLength(FileName);
+    }
+    sprintf_s(IndexedName, "%.*s_%u%s", static_cast<int>(Extension - FileName), FileName, Index, Extension);
+    BuildPath(State, IndexedName, DestCount, Dest);
+}
+
 static FILETIME Win32GetLastWriteTime(const char* Filename)
 {
     if (WIN32_FILE_ATTRIBUTE_DATA Data; GetFileAttributesExA(Filename, GetFileExInfoStandard, &Data))
@@ -71,104 +93,207 @@ namespace Windows
         }
     }
 
-    GameDLL::GameDLL(const win32_state& Win32State, const char* sourceDLLName, const char* TempDLLName)
+    GameDLL::GameDLL(const win32_state& Win32State,
+                     Game::Logger&      Log,
+                     const char*        sourceDLLName,
+                     const char*        TempDLLName)
         : Win32State_{ Win32State }
+        , Log{ Log }
     {
         BuildPath(Win32State, sourceDLLName, sizeof(SourceGameCodeDLLFullPath), SourceGameCodeDLLFullPath);
-        BuildPath(Win32State_, TempDLLName, sizeof(TempGameCodeDLLFullPath), TempGameCodeDLLFullPath);
+        for (unsigned Index = 0; Index < TempDLLCount; ++Index)
+        {
+            BuildIndexedPath(Win32State_,
+                             TempDLLName,
+                             Index,
+                             sizeof(TempGameCodeDLLFullPath[Index]),
+                             TempGameCodeDLLFullPath[Index]);
+        }
+        BuildPath(Win32State_, "", sizeof(WatchedDirectory), WatchedDirectory);
+
+        // first load is synchronous, there is no frame to stall yet
+        Current = Load();
+        if (Current)
+        {
+            UpdateAndRender = Current->UpdateAndRender;
+            GetSoundSamples = Current->GetSoundSamples;
+        }
+
+        StopEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        Watcher   = std::thread{ [this] { Watch(); } };
+    }
+
+    GameDLL::~GameDLL()
+    {
+        if (Watcher.joinable())
+        {
+            SetEvent(StopEvent);
+            Watcher.join();
+        }
+        CloseHandle(StopEvent);
+
+        UnloadRetired(true);
+        Unload(Pending.exchange(nullptr));
+        Unload(Current);
+        UpdateAndRender = nullptr;
+        GetSoundSamples = nullptr;
+    }
+
+    void GameDLL::BeginFrame()
+    {
+        if (auto Loaded = Pending.exchange(nullptr, std::memory_order_acquire))
+        {
+            auto SwapStart = WallClock::create();
+            if (Current)
+            {
+                // frames before this one may still use it
+                Current->RetiredFrame = StartedFrameCount;
+                std::lock_guard<std::mutex> Lock{ RetiredMutex };
+                Retired.push_back(Current);
+            }
+            Current         = Loaded;
+            UpdateAndRender = Current->UpdateAndRender;
+            GetSoundSamples = Current->GetSoundSamples;
+
+            ++Stats.ReloadCount;
+            Stats.LastLoadMicroseconds = Current->LoadMicroseconds;
+            Stats.LastSwapMicroseconds = SwapStart.GetElapsedMicroseconds();
+            if (Stats.LastSwapMicroseconds > Stats.MaxSwapMicroseconds)
+            {
+                Stats.MaxSwapMicroseconds = Stats.LastSwapMicroseconds;
+            }
 
-        Load();
+            GAME_LOG(Log, Info, "game DLL reloaded: {} us off frame (copy + load), {} us on frame (swap)",
+                     Stats.LastLoadMicroseconds, Stats.LastSwapMicroseconds);
+        }
+        ++StartedFrameCount;
     }
 
-    void GameDLL::Load()
+    void GameDLL::EndFrame() { CompletedFrameCount.fetch_add(1, std::memory_order_release); }
+
+    GameDLL::Module* GameDLL::Load()
     {
+        auto LoadStart       = WallClock::create();
+        auto SourceWriteTime = Win32GetLastWriteTime(SourceGameCodeDLLFullPath);
+        auto TempPath        = TempGameCodeDLLFullPath[NextTempDLLIndex];
+
         // for now, during development we use a copy of the DLL so we can rebuild the DLL when the copy is used
-        // maybe a better way to handle this is to track new DLL in another folder and copy it if needed
-        if (!CopyFileA(SourceGameCodeDLLFullPath, TempGameCodeDLLFullPath, FALSE))
+        // the copy fails while the linker is still writing the DLL, the watcher will try again
+        if (!CopyFileA(SourceGameCodeDLLFullPath, TempPath, FALSE))
         {
-            char buff[64];
-            sprintf_s(buff, "DLL copy failed. Error #%d.\n", GetLastError());
-            OutputDebugStringA(buff);
-            return;
+            GAME_LOG(Log, Warning, "game DLL copy failed: error {}", uint32(GetLastError()));
+            return nullptr;
         }
+        NextTempDLLIndex = (NextTempDLLIndex + 1) % TempDLLCount;
 
         OutputDebugStringA("Loading ");
         OutputDebugStringA(SourceGameCodeDLLFullPath);
         OutputDebugStringA("\n");
-        dll_last_write_time_ = Win32GetLastWriteTime(SourceGameCodeDLLFullPath);
 
-        dll_handle_ = LoadLibraryA(TempGameCodeDLLFullPath);
-        if (dll_handle_)
+        auto Handle = LoadLibraryA(TempPath);
+        if (!Handle)
         {
-            UpdateAndRender =
-                reinterpret_cast<game_update_and_render*>(GetProcAddress(dll_handle_, "GameUpdateAndRender"));
-            GetSoundSamples =
-                reinterpret_cast<game_get_sound_samples*>(GetProcAddress(dll_handle_, "GameGetSoundSamples"));
-            is_valid_ = UpdateAndRender && GetSoundSamples;
+            return nullptr;
         }
-        else
+
+        auto Loaded    = new Module{};
+        Loaded->Handle = Handle;
+        Loaded->UpdateAndRender =
+            reinterpret_cast<game_update_and_render*>(GetProcAddress(Handle, "GameUpdateAndRender"));
+        Loaded->GetSoundSamples =
+            reinterpret_cast<game_get_sound_samples*>(GetProcAddress(Handle, "GameGetSoundSamples"));
+        if (!Loaded->UpdateAndRender || !Loaded->GetSoundSamples)
         {
-            is_valid_ = false;
+            Unload(Loaded);
+            return nullptr;
         }
-        if (!is_valid_)
+        // only a DLL that loaded is up to date: a failed load leaves the watcher retrying the same write
+        LastSourceWriteTime      = SourceWriteTime;
+        Loaded->LoadMicroseconds = LoadStart.GetElapsedMicroseconds();
+        return Loaded;
+    }
+
+    void GameDLL::Unload(Module* module) const
+    {
+        if (module)
         {
-            UpdateAndRender = nullptr;
-            GetSoundSamples = nullptr;
+            OutputDebugStringA("Unloading Game DLL.\n");
+            FreeLibrary(module->Handle);
+            delete module;
         }
     }
 
-    void GameDLL::LookForUpdate()
+    void GameDLL::UnloadRetired(bool All)
     {
-        auto NewDLLWriteTime = Win32GetLastWriteTime(SourceGameCodeDLLFullPath);
+        auto CompletedFrames = CompletedFrameCount.load(std::memory_order_acquire);
 
-        if (CompareFileTime(&NewDLLWriteTime, &dll_last_write_time_) != 0)
+        std::lock_guard<std::mutex> Lock{ RetiredMutex };
+        for (auto Iterator = Retired.begin(); Iterator != Retired.end();)
         {
-            // auto handle = CreateFileA(SourceGameCodeDLLFullPath,
-            //                           GENERIC_READ | GENERIC_WRITE,
-            //                           0,
-            //                           NULL,
-            //                           OPEN_EXISTING,
-            //                           FILE_ATTRIBUTE_NORMAL,
-            //                           NULL);
-
-            // FIXME: yuck... horrible...
-            char xxx[WIN32_STATE_FILE_NAME_COUNT];
-
-            BuildPath(Win32State_, "game.lld", sizeof(xxx), xxx);
-
-            if (CopyFileA(SourceGameCodeDLLFullPath, xxx, FALSE))
+            if (All || CompletedFrames >= (*Iterator)->RetiredFrame)
             {
-                DeleteFileA(xxx);
-                // CloseHandle(handle);
-                Unload();
-                Load();
+                Unload(*Iterator);
+                Iterator = Retired.erase(Iterator);
+            }
+            else
+            {
+                ++Iterator;
             }
-            // Sleep(1000); // we detect the change to early
-            // Unload();
         }
     }
 
-    void GameDLL::Unload()
+    // Watcher thread: sleeps until something is written in the executable directory, then loads the new DLL
+    void GameDLL::Watch()
     {
-        if (dll_handle_)
+        auto Notification = FindFirstChangeNotificationA(WatchedDirectory,
+                                                         FALSE,
+                                                         FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+        HANDLE Handles[]   = { StopEvent, Notification };
+        DWORD  HandleCount = Notification != INVALID_HANDLE_VALUE ? 2 : 1;
+        bool   IsDirty     = false;
+
+        for (;;)
         {
-            OutputDebugStringA("Unloading Game DLL.\n");
-            FreeLibrary(dll_handle_);
-            if (!FreeLibrary(dll_handle_))
+            bool HasRetired;
+            {
+                std::lock_guard<std::mutex> Lock{ RetiredMutex };
+                HasRetired = !Retired.empty();
+            }
+            // poll only while a copy must be retried or a module waits for its last frame
+            DWORD Timeout = (IsDirty || HasRetired) ? 100 : INFINITE;
+            auto  Result  = WaitForMultipleObjects(HandleCount, Handles, FALSE, Timeout);
+            if (Result == WAIT_OBJECT_0 || Result == WAIT_FAILED)
+            {
+                break;
+            }
+            if (Result == WAIT_OBJECT_0 + 1)
+            {
+                FindNextChangeNotification(Notification);
+                IsDirty = true;
+            }
+
+            // one pending module at a time, the frame thread must take it first
+            if (IsDirty && !Pending.load(std::memory_order_relaxed))
             {
-                // if (!DeleteFileA(TempGameCodeDLLFullPath))
-                // {
-                //     char buff[64];
-                //     sprintf_s(buff, "Delete Error #%d", GetLastError());
-                //     OutputDebugStringA(buff);
-                // }
+                auto NewDLLWriteTime = Win32GetLastWriteTime(SourceGameCodeDLLFullPath);
+                if (CompareFileTime(&NewDLLWriteTime, &LastSourceWriteTime) == 0)
+                {
+                    IsDirty = false; // our own copies, or another file
+                }
+                else if (auto Loaded = Load())
+                {
+                    Pending.store(Loaded, std::memory_order_release);
+                    IsDirty = false;
+                }
             }
-            // CoFreeUnusedLibraries();
-            dll_handle_ = 0;
+
+            UnloadRetired(false);
+        }
+
+        if (Notification != INVALID_HANDLE_VALUE)
+        {
+            FindCloseChangeNotification(Notification);
         }
-        is_valid_       = false;
-        UpdateAndRender = nullptr;
-        GetSoundSamples = nullptr;
     }
 
-} // namespace Windows
\ No newline at end of file
+} // namespace Windows
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <types.hpp>
+
 #include <Windows.h>
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace Game
 {
+    class Logger;
     struct Memory;
     struct Inputs;
     struct SoundOutputBuffer;
@@ -30,32 +38,75 @@ namespace Windows
         void Win32GetEXEFileName(); // RetrieveEXEFileName
     };
 
+    struct GameDLLReloadStats
+    {
+        uint32 ReloadCount          = 0;
+        int64  LastLoadMicroseconds = 0; // copy + LoadLibrary, on the watcher thread (it used to stall the frame)
+        int64  LastSwapMicroseconds = 0; // what remains on the frame thread
+        int64  MaxSwapMicroseconds  = 0;
+    };
+
+    // The game DLL is watched and reloaded by a background thread. The frame thread only swaps the function pointers
+    // at a frame boundary (BeginFrame), the previous module is unloaded once every frame that could use it has ended.
+    // Every reload is logged with its times, see GetReloadStats for the metrics.
     class GameDLL final
     {
     public:
         const win32_state& Win32State_;
 
-        GameDLL(const win32_state& Win32State, const char* sourceDLLName, const char* TempDLLName);
-
-        ~GameDLL() { Unload(); }
+        GameDLL(const win32_state& Win32State, Game::Logger& Log, const char* sourceDLLName, const char* TempDLLName);
+        GameDLL(const GameDLL&) = delete; // non copyable
 
-        void Load();
+        ~GameDLL();
 
-        void LookForUpdate();
+        // frame thread only
+        void BeginFrame();
+        void EndFrame();
 
-        void Unload();
+        bool IsValid() const { return UpdateAndRender && GetSoundSamples; }
 
-        bool IsValid() const { return is_valid_; }
+        const GameDLLReloadStats& GetReloadStats() const { return Stats; }
 
+        // stable from BeginFrame to EndFrame
         game_update_and_render* UpdateAndRender = nullptr;
         game_get_sound_samples* GetSoundSamples = nullptr;
 
     private:
-        char     SourceGameCodeDLLFullPath[WIN32_STATE_FILE_NAME_COUNT];
-        char     TempGameCodeDLLFullPath[WIN32_STATE_FILE_NAME_COUNT];
-        HMODULE  dll_handle_;
-        FILETIME dll_last_write_time_;
-        bool     is_valid_;
+        struct Module
+        {
+            HMODULE                 Handle           = 0;
+            game_update_and_render* UpdateAndRender  = nullptr;
+            game_get_sound_samples* GetSoundSamples  = nullptr;
+            uint64                  RetiredFrame     = 0; // first frame which does not use it anymore
+            int64                   LoadMicroseconds = 0;
+        };
+
+        Module* Load();
+        void    Unload(Module* module) const;
+        void    Watch();
+        void    UnloadRetired(bool All);
+
+        static constexpr uint32 TempDLLCount = 4; // a new copy can be loaded while the previous ones are still in use
+
+        char SourceGameCodeDLLFullPath[WIN32_STATE_FILE_NAME_COUNT];
+        char TempGameCodeDLLFullPath[TempDLLCount][WIN32_STATE_FILE_NAME_COUNT];
+        char WatchedDirectory[WIN32_STATE_FILE_NAME_COUNT];
+
+        uint32   NextTempDLLIndex    = 0;
+        FILETIME LastSourceWriteTime = {};
+
+        Module*              Current = nullptr;
+        std::atomic<Module*> Pending{ nullptr };
+        std::mutex           RetiredMutex;
+        std::vector<Module*> Retired;
+
+        uint64              StartedFrameCount = 0;
+        std::atomic<uint64> CompletedFrameCount{ 0 };
+
+        Game::Logger&      Log;
+        GameDLLReloadStats Stats;
+        HANDLE             StopEvent = 0;
+        std::thread        Watcher;
     };
 
-} // namespace Windows
\ No newline at end of file
+} // namespace Windows
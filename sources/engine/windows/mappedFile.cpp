@@ -0,0 +1,94 @@
+#include "mappedFile.hpp"
+
+namespace Windows
+{
+
+    MappedFile::MappedFile(const char* Path)
+    {
+        File = CreateFileA(Path,
+                           GENERIC_READ,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE, // a file still written, a SnapshotFile
+                           nullptr,
+                           OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS,
+                           nullptr);
+        if (File == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+        LARGE_INTEGER FileSize;
+        if (!GetFileSizeEx(File, &FileSize) || FileSize.QuadPart == 0)
+        {
+            return;
+        }
+        Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!Mapping)
+        {
+            return;
+        }
+        View = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+        if (View)
+        {
+            Size = static_cast<uint64>(FileSize.QuadPart);
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (View)
+        {
+            UnmapViewOfFile(View);
+        }
+        if (Mapping)
+        {
+            CloseHandle(Mapping);
+        }
+        if (File != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(File);
+        }
+    }
+
+    MappedOutputFile::MappedOutputFile(const char* Path, uint64 Size)
+    {
+        File = CreateFileA(Path,
+                           GENERIC_READ | GENERIC_WRITE,
+                           FILE_SHARE_READ,
+                           nullptr,
+                           CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+        if (File == INVALID_HANDLE_VALUE || Size == 0)
+        {
+            return;
+        }
+        // the mapping extends the file to Size, with zeros
+        Mapping = CreateFileMappingA(File, nullptr, PAGE_READWRITE, DWORD(Size >> 32), DWORD(Size), nullptr);
+        if (!Mapping)
+        {
+            return;
+        }
+        View = MapViewOfFile(Mapping, FILE_MAP_WRITE, 0, 0, 0);
+        if (View)
+        {
+            this->Size = Size;
+        }
+    }
+
+    MappedOutputFile::~MappedOutputFile()
+    {
+        if (View)
+        {
+            UnmapViewOfFile(View);
+        }
+        if (Mapping)
+        {
+            CloseHandle(Mapping);
+        }
+        if (File != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(File);
+        }
+    }
+
+} // namespace Windows
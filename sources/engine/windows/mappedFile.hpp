@@ -0,0 +1,49 @@
+#pragma once
+
+#include <types.hpp>
+
+#include <Windows.h>
+
+namespace Windows
+{
+
+    // Read only mapping of a whole file, empty if the file can't be opened
+    class MappedFile final
+    {
+    public:
+        explicit MappedFile(const char* Path);
+        MappedFile(const MappedFile&) = delete; // non copyable
+        ~MappedFile();
+
+        bool        IsValid() const { return View != nullptr; }
+        const void* GetData() const { return View; }
+        uint64      GetSize() const { return Size; }
+
+    private:
+        HANDLE File    = INVALID_HANDLE_VALUE;
+        HANDLE Mapping = 0;
+        void*  View    = nullptr;
+        uint64 Size    = 0;
+    };
+
+    // Shared writable mapping of a new file of Size bytes, zero filled (a metric series, see metrics.hpp); other
+    // processes see the writes through their own mapping. Empty if the file can't be created.
+    class MappedOutputFile final
+    {
+    public:
+        MappedOutputFile(const char* Path, uint64 Size);
+        MappedOutputFile(const MappedOutputFile&) = delete; // non copyable
+        ~MappedOutputFile();
+
+        bool   IsValid() const { return View != nullptr; }
+        void*  GetData() const { return View; }
+        uint64 GetSize() const { return Size; }
+
+    private:
+        HANDLE File    = INVALID_HANDLE_VALUE;
+        HANDLE Mapping = 0;
+        void*  View    = nullptr;
+        uint64 Size    = 0;
+    };
+
+} // namespace Windows
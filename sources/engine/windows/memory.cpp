@@ -11,15 +11,28 @@ namespace Windows
     Memory::Memory()
         : Game::Memory{ Megabytes(64), Gigabytes(1) }
     {
-        uint64 TotalSize = PermanentStorageSize + TransientStorageSize;
-        PermanentStorage = VirtualAlloc(baseAddress, (SIZE_T)TotalSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
-        if (!PermanentStorage)
+        // two regions: only the permanent storage is write watched, for its snapshots (WriteWatchPageTracker)
+        PermanentStorage = VirtualAlloc(baseAddress, (SIZE_T)PermanentStorageSize,
+                                        MEM_RESERVE | MEM_COMMIT | MEM_WRITE_WATCH, PAGE_READWRITE);
+        if (PermanentStorage)
         {
+            TransientStorage = VirtualAlloc(static_cast<uint8*>(baseAddress) + PermanentStorageSize,
+                                            (SIZE_T)TransientStorageSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        }
+        if (!PermanentStorage || !TransientStorage)
+        {
+            if (PermanentStorage)
+            {
+                VirtualFree(PermanentStorage, 0, MEM_RELEASE);
+            }
             throw std::domain_error{ "Fail to allocate virtual memory!" };
         }
-        TransientStorage = (static_cast<uint8*>(PermanentStorage) + PermanentStorageSize);
     }
 
-    Memory::~Memory() { VirtualFree(baseAddress, 0, MEM_RELEASE); }
+    Memory::~Memory()
+    {
+        VirtualFree(TransientStorage, 0, MEM_RELEASE);
+        VirtualFree(PermanentStorage, 0, MEM_RELEASE);
+    }
 
 } // namespace Windows
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "snapshot_file.hpp"
+
+namespace Windows
+{
+    static constexpr uint64 MaxWriteSize = uint64(1) << 30; // the size of a WriteFile is a DWORD
+
+    SnapshotFile::SnapshotFile(const char* Path)
+    {
+        File = CreateFileA(Path,
+                           GENERIC_WRITE,
+                           FILE_SHARE_READ, // read back by a quick load while it is written
+                           nullptr,
+                           CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+    }
+
+    SnapshotFile::~SnapshotFile()
+    {
+        if (File != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(File);
+        }
+    }
+
+    bool SnapshotFile::Write(void* Context, const void* Data, uint64 Size)
+    {
+        auto Self  = static_cast<SnapshotFile*>(Context);
+        auto Bytes = static_cast<const uint8*>(Data);
+        while (Size && Self->IsValid())
+        {
+            auto  Chunk = static_cast<DWORD>(Size < MaxWriteSize ? Size : MaxWriteSize);
+            DWORD Written;
+            if (!WriteFile(Self->File, Bytes, Chunk, &Written, nullptr) || Written != Chunk)
+            {
+                return false;
+            }
+            Bytes += Chunk;
+            Size -= Chunk;
+        }
+        return Size == 0;
+    }
+
+} // namespace Windows
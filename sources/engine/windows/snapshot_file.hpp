@@ -0,0 +1,27 @@
+#pragma once
+
+#include <snapshot.hpp>
+
+#include <Windows.h>
+
+namespace Windows
+{
+
+    // Sink of a SnapshotWriter: the stream in a new file, which a MappedFile can read while it is written
+    class SnapshotFile final
+    {
+    public:
+        explicit SnapshotFile(const char* Path);
+        SnapshotFile(const SnapshotFile&) = delete; // non copyable
+        ~SnapshotFile();
+
+        bool               IsValid() const { return File != INVALID_HANDLE_VALUE; }
+        Game::SnapshotSink GetSink() { return { this, &Write }; }
+
+    private:
+        static bool Write(void* Context, const void* Data, uint64 Size);
+
+        HANDLE File = INVALID_HANDLE_VALUE;
+    };
+
+} // namespace Windows
@@ -0,0 +1,143 @@
+#include "win_file_service.hpp"
+
+#include <game.hpp>
+
+namespace Windows
+{
+
+    OverlappedFileService::OverlappedFileService()
+    {
+        for (auto& File : Files)
+        {
+            File = INVALID_HANDLE_VALUE;
+        }
+        Port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    }
+
+    OverlappedFileService::~OverlappedFileService()
+    {
+        for (Game::FileHandle File = 0; File < MaxFileCount; ++File)
+        {
+            Close(File);
+        }
+        // the cancelled reads still write their OVERLAPPED, wait for them before the memory goes away
+        while (Port && InFlightCount)
+        {
+            BeginFrame();
+            if (InFlightCount)
+            {
+                Sleep(1);
+            }
+        }
+        if (Port)
+        {
+            CloseHandle(Port);
+        }
+    }
+
+    Game::FileHandle OverlappedFileService::OpenForRead(const char* Path, uint64* FileSize)
+    {
+        for (Game::FileHandle File = 0; File < MaxFileCount; ++File)
+        {
+            if (Files[File] == INVALID_HANDLE_VALUE)
+            {
+                auto Handle = CreateFileA(Path,
+                                          GENERIC_READ,
+                                          FILE_SHARE_READ,
+                                          nullptr,
+                                          OPEN_EXISTING,
+                                          FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+                                          nullptr);
+                if (Handle == INVALID_HANDLE_VALUE)
+                {
+                    return Game::InvalidFileHandle;
+                }
+                LARGE_INTEGER Size;
+                if (!GetFileSizeEx(Handle, &Size) || !CreateIoCompletionPort(Handle, Port, File, 0))
+                {
+                    CloseHandle(Handle);
+                    return Game::InvalidFileHandle;
+                }
+                *FileSize   = static_cast<uint64>(Size.QuadPart);
+                Files[File] = Handle;
+                return File;
+            }
+        }
+        return Game::InvalidFileHandle;
+    }
+
+    void OverlappedFileService::Close(Game::FileHandle File)
+    {
+        if (File < MaxFileCount && Files[File] != INVALID_HANDLE_VALUE)
+        {
+            // pending reads on this file complete as failed
+            CancelIo(Files[File]);
+            CloseHandle(Files[File]);
+            Files[File] = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    uint32 OverlappedFileService::SubmitReads(const Game::FileReadRequest* Requests, uint32 Count)
+    {
+        uint32 Accepted = 0;
+        while (Accepted < Count && InFlightCount < MaxInFlightCount)
+        {
+            auto& Request = Requests[Accepted++];
+            while (Reads[NextRead].IsUsed)
+            {
+                NextRead = (NextRead + 1) % MaxInFlightCount;
+            }
+            auto& Read = Reads[NextRead];
+            Read       = {};
+            Read.Overlapped.Offset     = static_cast<DWORD>(Request.Offset);
+            Read.Overlapped.OffsetHigh = static_cast<DWORD>(Request.Offset >> 32);
+            Read.UserData              = Request.UserData;
+            Read.Size                  = Request.Size;
+            Read.IsUsed                = true;
+            ++InFlightCount;
+
+            auto IsValidFile = Request.File < MaxFileCount && Files[Request.File] != INVALID_HANDLE_VALUE;
+            if (!IsValidFile || !Request.Destination ||
+                (!ReadFile(Files[Request.File], Request.Destination, Request.Size, nullptr, &Read.Overlapped) &&
+                 GetLastError() != ERROR_IO_PENDING))
+            {
+                // nothing will be posted on the port, make it complete at the next frame
+                PostQueuedCompletionStatus(Port, 0, Game::InvalidFileHandle, &Read.Overlapped);
+            }
+        }
+        return Accepted;
+    }
+
+    void OverlappedFileService::BeginFrame()
+    {
+        FrameCompletionCount = 0;
+
+        OVERLAPPED_ENTRY Entries[64];
+        constexpr ULONG  MaxEntryCount = static_cast<ULONG>(ArrayCount(Entries));
+        ULONG            EntryCount;
+        while (FrameCompletionCount < MaxInFlightCount &&
+               GetQueuedCompletionStatusEx(Port, Entries, MaxEntryCount, &EntryCount, 0, FALSE))
+        {
+            for (ULONG Index = 0; Index < EntryCount; ++Index)
+            {
+                auto& Entry = Entries[Index];
+                auto& Read  = *reinterpret_cast<PendingRead*>(Entry.lpOverlapped);
+                auto  IsOk  = Entry.lpCompletionKey != Game::InvalidFileHandle &&
+                            Entry.lpOverlapped->Internal == 0; // NTSTATUS of the read
+                Complete(Read, Entry.dwNumberOfBytesTransferred, IsOk);
+            }
+            if (EntryCount < MaxEntryCount)
+            {
+                break;
+            }
+        }
+    }
+
+    void OverlappedFileService::Complete(PendingRead& Read, uint32 BytesRead, bool Succeeded)
+    {
+        FrameCompletions[FrameCompletionCount++] = { Read.UserData, BytesRead, Succeeded && BytesRead == Read.Size };
+        Read.IsUsed                              = false;
+        --InFlightCount;
+    }
+
+} // namespace Windows
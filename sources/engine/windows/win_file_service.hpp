@@ -0,0 +1,44 @@
+#pragma once
+
+#include <file_service.hpp>
+
+#include <Windows.h>
+
+namespace Windows
+{
+
+    // Overlapped reads on an I/O completion port: no thread, the completions are reaped without waiting in
+    // BeginFrame
+    class OverlappedFileService final : public Game::FileService
+    {
+    public:
+        OverlappedFileService();
+        ~OverlappedFileService() override;
+
+        Game::FileHandle OpenForRead(const char* Path, uint64* FileSize) override;
+        void             Close(Game::FileHandle File) override;
+
+        uint32 SubmitReads(const Game::FileReadRequest* Requests, uint32 Count) override;
+
+        void BeginFrame() override;
+
+        bool IsValid() const { return Port != nullptr; }
+
+    private:
+        struct PendingRead
+        {
+            OVERLAPPED Overlapped; // first: the completion gives back its address
+            uint64     UserData;
+            uint32     Size;
+            bool       IsUsed;
+        };
+
+        void Complete(PendingRead& Read, uint32 BytesRead, bool Succeeded);
+
+        HANDLE      Port = nullptr;
+        HANDLE      Files[MaxFileCount];
+        PendingRead Reads[MaxInFlightCount] = {};
+        uint32      NextRead                = 0;
+    };
+
+} // namespace Windows
@@ -138,6 +138,12 @@ namespace Windows
                     case VK_BACK: // ScanCode 14
                         ProcessKeyboardMessage(KeyboardController.Back, IsDown);
                         break;
+                    case VK_F5:
+                        QuickSaveRequested |= IsDown;
+                        break;
+                    case VK_F9:
+                        QuickLoadRequested |= IsDown;
+                        break;
                     }
                 }
 
@@ -172,6 +178,8 @@ namespace Windows
             curKeyboardCtrl.Buttons[ButtonIndex].EndedDown = prevKeyboardCtrl.Buttons[ButtonIndex].EndedDown;
         }
 
+        QuickSaveRequested = false;
+        QuickLoadRequested = false;
         ProcessPendingMessages(curKeyboardCtrl);
 
         constexpr DWORD MaxControllerCount =
@@ -17,6 +17,8 @@ namespace Windows
         void Update();
 
         bool32 IsQuitRequested() const { return QuitRequested; }
+        bool32 IsQuickSaveRequested() const { return QuickSaveRequested; } // F5 pressed during the last Update
+        bool32 IsQuickLoadRequested() const { return QuickLoadRequested; } // F9 pressed during the last Update
         auto   GetCurrent() const { return PIInputs[CurrentInput]; }
 
     private:
@@ -26,9 +28,11 @@ namespace Windows
         void ProcessPendingMessages(Game::GamePad& KeyboardController);
 
         // Platform Independent Inputs (Double buffer for transition detection)
-        Game::Inputs PIInputs[2]   = {};
-        uint32       CurrentInput  = 0;
-        bool32       QuitRequested = false;
+        Game::Inputs PIInputs[2]        = {};
+        uint32       CurrentInput       = 0;
+        bool32       QuitRequested      = false;
+        bool32       QuickSaveRequested = false;
+        bool32       QuickLoadRequested = false;
     };
 
 } // namespace Windows
\ No newline at end of file
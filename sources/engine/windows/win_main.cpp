@@ -1,21 +1,38 @@
 #include <windows.h>
 
 #include "cpu.hpp"
+#include "crash_log.hpp"
 #include "gameDLL.hpp"
 #include "hdtimer.hpp"
+#include "mappedFile.hpp"
 #include "memory.hpp"
 #include "scopedTimerResolution.hpp"
+#include "snapshot_file.hpp"
 #include "win_backbuffer.hpp"
+#include "win_file_service.hpp"
 #include "win_inputs.hpp"
 #include "win_sound.hpp"
 #include "window.hpp"
 #include "windowsClass.hpp"
+#include "write_watch_page_tracker.hpp"
 
+#include <asset_pack.hpp>
+#include <debug_overlay.hpp>
+#include <format.hpp>
 #include <game.hpp>
+#include <interned_string.hpp>
+#include <job_system.hpp>
+#include <logger.hpp>
+#include <metrics.hpp>
+#include <snapshot.hpp>
 #include <types.hpp>
 
 #include <cstdio>
+#include <cstring>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace Windows
 {
@@ -131,6 +148,9 @@ namespace Windows
         inline static constexpr uint32 GameUpdateHz               = MonitorRefreshHz / 2;
         inline static constexpr uint32 TargetMicrosecondsPerFrame = 1'000'000 / GameUpdateHz;
 
+        using FileServicePtr = std::unique_ptr<Game::FileService>;
+        using JobSystem      = Game::ThreadPoolJobSystem;
+
         // order matters
         WindowClass           wndClass; // no dependies, can throw
         BackBuffer            backbuffer; // no dependies
@@ -140,9 +160,54 @@ namespace Windows
         SoundEngine           sndEngine; // depends on window
         Memory                memory;
         win32_state           win32State;
-        GameDLL               gameDLL; // depends on win32State
+        std::vector<uint8>    logMemory; // no dependencies
+        Game::MemoryArena     logArena; // depends on logMemory
+        Game::Logger          logger; // depends on logArena
+        Game::LogThread       logThread; // depends on logger
+        std::string           crashLogPath; // depends on win32State
+        CrashLog              crashLog; // depends on logger and crashLogPath
+        std::vector<uint8>    stringMemory; // no dependencies
+        Game::MemoryArena     stringArena; // depends on stringMemory
+        Game::StringTable     strings; // depends on stringArena
+        std::vector<uint8>    metricMemory; // no dependencies
+        Game::MemoryArena     metricArena; // depends on metricMemory
+        Game::MetricRegistry  metrics; // depends on metricArena
+        MappedOutputFile      metricFile; // depends on win32State
+        Game::MetricSeries    metricSeries; // depends on metrics and metricFile
+        Game::MetricThread    metricThread; // depends on metricSeries
+        std::vector<uint8>    overlayMemory; // no dependencies
+        Game::MemoryArena     overlayArena; // depends on overlayMemory
+        Game::DebugOverlay    overlay; // depends on overlayArena
+        std::vector<uint8>    snapshotMemory; // no dependencies
+        Game::MemoryArena     snapshotArena; // depends on snapshotMemory
+        WriteWatchPageTracker pageTracker; // depends on snapshotArena and memory
+        std::string           snapshotPath; // depends on win32State
+        SnapshotFile          snapshotFile; // depends on snapshotPath
+        Game::SnapshotWriter  snapshots; // depends on snapshotArena, memory, pageTracker and snapshotFile
+        MappedFile            assetFile; // depends on win32State
+        Game::AssetPack       assets; // depends on assetFile
+        FileServicePtr        files; // no dependencies
+        JobSystem             jobs; // no dependencies
+        GameDLL               gameDLL; // depends on win32State and logger
         WallClock             lastCounter;
 
+        Game::MetricHistogram* frameMicroseconds; // depends on metrics
+        Game::MetricCounter*   missedFrames; // depends on metrics
+        Game::MetricGauge*     audioUnderruns; // depends on metrics
+        Game::MetricGauge*     dllReloads; // depends on metrics
+        Game::MetricGauge*     dllLoadMicroseconds; // depends on metrics
+        Game::MetricGauge*     dllMaxSwapMicroseconds; // depends on metrics
+        Game::MetricGauge*     stringPoolUsed; // depends on metrics
+
+        enum FrameStage : uint32
+        {
+            GameStage,
+            SoundStage,
+            OverlayStage,
+            StageCount
+        };
+        Game::ProfileRecord stages[StageCount]; // no dependencies
+
         bool   isRunning      = true; // no dependencies
         uint64 LastCycleCount = __rdtsc(); // no dependencies
         bool   isPaused       = false; // no dependencies
@@ -151,13 +216,89 @@ namespace Windows
             : backbuffer{ 1280, 720 }
             , window{ wndClass.createNativeWindow(), backbuffer }
             , sndEngine{ window }
-            , gameDLL{ win32State, "game_msvc_r.dll", "game.dll" }
+            , logMemory(Megabytes(1))
+            , logArena{ logMemory.data(), logMemory.size() }
+            , logger{ logArena, 8, 64 * 1024 }
+            , logThread{ logger, { nullptr, &WriteDebugString } }
+            , crashLogPath{ BuildEXERelativePath(win32State, "crash.log") }
+            , crashLog{ logger, crashLogPath.c_str() }
+            , stringMemory(Megabytes(2))
+            , stringArena{ stringMemory.data(), stringMemory.size() }
+            , strings{ stringArena, 16 * 1024, Megabytes(1) }
+            , metricMemory(Kilobytes(64))
+            , metricArena{ metricMemory.data(), metricMemory.size() }
+            , metrics{ metricArena, 64, 512 }
+            , metricFile{ BuildEXERelativePath(win32State, "metrics.series").c_str(), Megabytes(32) }
+            , metricSeries{ metrics, metricFile.GetData(), metricFile.GetSize() }
+            , metricThread{ metricSeries }
+            , overlayMemory(Kilobytes(256))
+            , overlayArena{ overlayMemory.data(), overlayMemory.size() }
+            , overlay{ overlayArena }
+            , snapshotMemory(Megabytes(65)) // a copy of the permanent storage, and the buffers
+            , snapshotArena{ snapshotMemory.data(), snapshotMemory.size() }
+            , pageTracker{ snapshotArena, memory.PermanentStorage, memory.PermanentStorageSize }
+            , snapshotPath{ BuildEXERelativePath(win32State, "quick.snap") }
+            , snapshotFile{ snapshotPath.c_str() }
+            , snapshots{ snapshotArena,
+                         memory.PermanentStorage,
+                         memory.PermanentStorageSize,
+                         pageTracker,
+                         snapshotFile.GetSink() }
+            , assetFile{ BuildEXERelativePath(win32State, "data.pack").c_str() }
+            , files{ CreateFileService() }
+            , gameDLL{ win32State, logger, "game_msvc_r.dll", "game.dll" }
             , lastCounter{ WallClock::create() }
-        {}
+            , frameMicroseconds{ metrics.AddHistogram("frame_microseconds") }
+            , missedFrames{ metrics.AddCounter("missed_frames") }
+            , audioUnderruns{ metrics.AddGauge("audio_underruns") }
+            , dllReloads{ metrics.AddGauge("dll_reloads") }
+            , dllLoadMicroseconds{ metrics.AddGauge("dll_load_microseconds") }
+            , dllMaxSwapMicroseconds{ metrics.AddGauge("dll_max_swap_microseconds") }
+            , stringPoolUsed{ metrics.AddGauge("string_pool_used") }
+        {
+            // the game reads the assets in place, in the mapped file
+            if (assets.Open(assetFile.GetData(), assetFile.GetSize()))
+            {
+                memory.Assets = &assets;
+            }
+            memory.Files   = files.get();
+            memory.Jobs    = &jobs;
+            memory.Strings = &strings;
+            memory.Metrics = &metrics;
+            Game::SetStringTable(&strings);
+            stages[GameStage].Name    = "game";
+            stages[SoundStage].Name   = "sound";
+            stages[OverlayStage].Name = "overlay";
+        }
+
+        static FileServicePtr CreateFileService()
+        {
+            auto Overlapped = std::make_unique<OverlappedFileService>();
+            if (Overlapped->IsValid())
+            {
+                return Overlapped;
+            }
+            return std::make_unique<Game::ThreadPoolFileService>();
+        }
+
+        static void WriteDebugString(void*, const char* Text, uint32 Size)
+        {
+            char Buffer[4096 + 1];
+            Size = Size < 4096 ? Size : 4096;
+            memcpy(Buffer, Text, Size);
+            Buffer[Size] = 0;
+            OutputDebugStringA(Buffer);
+        }
+
+        static std::string BuildEXERelativePath(const win32_state& State, const char* FileName)
+        {
+            return std::string(State.EXEFileName, State.OnePastLastEXEFileNameSlash - State.EXEFileName) + FileName;
+        }
 
         void update()
         {
-            gameDLL.LookForUpdate();
+            gameDLL.BeginFrame();
+            files->BeginFrame();
             inputs.Update();
             isRunning &= !inputs.IsQuitRequested();
             isRunning &= ProcessPendingMessages();
@@ -166,6 +307,14 @@ namespace Windows
             {
                 isRunning = false;
             }
+            if (inputs.IsQuickSaveRequested())
+            {
+                QuickSave();
+            }
+            if (inputs.IsQuickLoadRequested())
+            {
+                QuickLoad();
+            }
             if (inputs.GetCurrent().GamePads[0].Start.EndedDown &&
                 inputs.GetCurrent().GamePads[0].Start.HalfTransitionCount == 1)
             {
@@ -187,10 +336,12 @@ namespace Windows
 
                 if (gameDLL.UpdateAndRender)
                 {
+                    Game::TimedBlock Timer{ stages[GameStage] };
                     gameDLL.UpdateAndRender(Thread, memory, inputs.GetCurrent(), Buffer);
                 }
                 if (gameDLL.GetSoundSamples)
                 {
+                    Game::TimedBlock Timer{ stages[SoundStage] };
                     gameDLL.GetSoundSamples(Thread, memory, SoundBuffer);
                 }
 
@@ -220,7 +371,9 @@ namespace Windows
                 else
                 {
                     // TODO: MISSED FRAME RATE!
-                    // TODO: Logging
+                    missedFrames->Add();
+                    GAME_LOG(logger, Warning, "missed frame: {} us for {} us", MicrosecondsElapsedForFrame,
+                             TargetMicrosecondsPerFrame);
                 }
 
                 auto EndCounter{ WallClock::create() };
@@ -234,14 +387,27 @@ namespace Windows
                 auto FPS  = 1000.0f / (real32)MSPerFrame;
                 auto MCPF = (real32)CyclesElapsed / 1'000'000.0f;
 
+                auto& Latency = sndEngine.GetLatencyTelemetry();
+
+                frameMicroseconds->Record(uint64(MSPerFrame * 1000.0f));
+                audioUnderruns->Set(int64(Latency.UnderrunCount));
+                dllReloads->Set(gameDLL.GetReloadStats().ReloadCount);
+                dllLoadMicroseconds->Set(gameDLL.GetReloadStats().LastLoadMicroseconds);
+                dllMaxSwapMicroseconds->Set(gameDLL.GetReloadStats().MaxSwapMicroseconds);
+                stringPoolUsed->Set(int64(strings.GetPoolUsed()));
+
                 char FPSBuffer[256];
-                sprintf_s(FPSBuffer,
-                          sizeof(FPSBuffer),
-                          "%.02fms/f,  %.02ffps,  %.02fMCycles/Frame\n",
-                          MSPerFrame,
-                          FPS,
-                          MCPF);
+                Game::Format(FPSBuffer,
+                             GAME_FORMAT_STRING("{:.2f}ms/f,  {:.2f}fps,  {:.2f}MCycles/Frame,  latency {} samples "
+                                                "(jitter {:.1f}),  {} underruns\n"),
+                             MSPerFrame,
+                             FPS,
+                             MCPF,
+                             Latency.LatencySampleCount,
+                             Latency.Jitter,
+                             Latency.UnderrunCount);
                 // OutputDebugStringA(FPSBuffer);
+                DrawOverlay(Buffer, MSPerFrame, CyclesElapsed);
 #if DEBUG_SOUND
                 DebugDisplaySoundSync(backbuffer, sndEngine);
                 currentMarkerIndex++;
@@ -257,6 +423,55 @@ namespace Windows
             }
 
             window.blitBackBuffer();
+            gameDLL.EndFrame();
+        }
+
+        // F5: appends the pages of the permanent storage written since the previous save to quick.snap, compressed
+        // in the background
+        void QuickSave()
+        {
+            if (pageTracker.IsValid() && snapshotFile.IsValid())
+            {
+                auto PageCount = snapshots.Capture();
+                GAME_LOG(logger, Info, "quick save: {} pages", PageCount);
+            }
+        }
+
+        // F9: back to the last quick save, quick.snap replayed from its base. The restored pages are written: the next
+        // save holds them again
+        void QuickLoad()
+        {
+            snapshots.Wait();
+            MappedFile Saved{ snapshotPath.c_str() };
+            if (Saved.IsValid() && !snapshots.HasFailed())
+            {
+                auto Applied = Game::Snapshot::Restore(Saved.GetData(),
+                                                       Saved.GetSize(),
+                                                       memory.PermanentStorage,
+                                                       memory.PermanentStorageSize);
+                GAME_LOG(logger, Info, "quick load: {} of {} saves", Applied, snapshots.GetCaptureCount());
+            }
+        }
+
+        // the overlay times itself: its bar shows the previous frame
+        void DrawOverlay(const PIBackBuffer& Buffer, real32 MillisecondsPerFrame, uint64 FrameCycles)
+        {
+            Game::TimedBlock Timer{ stages[OverlayStage] };
+            auto&            Latency = sndEngine.GetLatencyTelemetry();
+            char             Line[96];
+            overlay.AddFrameTime(MillisecondsPerFrame);
+            overlay.Begin(8, 8, 320);
+            overlay.AddFrameGraph(TargetMicrosecondsPerFrame * 0.001f);
+            overlay.AddProfileBars(stages, StageCount, FrameCycles);
+            overlay.AddUsageBar("strings", strings.GetPoolUsed(), Megabytes(1));
+            overlay.AddUsageBar("log arena", logArena.GetUsed(), logArena.GetSize());
+            overlay.AddUsageBar("metric arena", metricArena.GetUsed(), metricArena.GetSize());
+            overlay.AddText(Game::Format(Line,
+                                         GAME_FORMAT_STRING("latency {} samples, {} underruns, {} reloads"),
+                                         Latency.LatencySampleCount,
+                                         Latency.UnderrunCount,
+                                         gameDLL.GetReloadStats().ReloadCount));
+            overlay.End(Buffer);
         }
 
         bool is_running() const { return isRunning; }
@@ -275,17 +490,14 @@ namespace Windows
     };
 } // namespace Windows
 
-#include <sstream>
-
 class OutputDebugStream
 {
 public:
     template <typename T>
-    OutputDebugStream& operator<<(T&& t)
+    OutputDebugStream& operator<<(const T& t)
     {
-        std::ostringstream s{};
-        s << t;
-        OutputDebugStringA(s.str().c_str());
+        char Buffer[256];
+        OutputDebugStringA(Game::Format(Buffer, GAME_FORMAT_STRING("{}"), t).data());
         return *this;
     }
 };
@@ -62,6 +62,14 @@ namespace Windows
 
     SoundEngine::SoundEngine(const Window& window)
     {
+        // last stage of the master bus, before going back to int16: a limiter at -0.1dBFS with an instant attack and
+        // no lookahead. Peaks land on the ceiling within the 0.5% of the fast gain approximations, under full scale;
+        // the int16 conversion saturates anything left over
+        MasterLimiter.SetThreshold(-0.1f);
+        MasterLimiter.SetRatio(0.0f);
+        MasterLimiter.SetTimes(0.0f, 0.1f);
+        MasterBus.Insert(MasterLimiter);
+
         Init(window);
         ClearBuffer();
         Play();
@@ -170,27 +178,27 @@ namespace Windows
         ByteToLock   = 0;
         BytesToWrite = 0;
 
-        bool32 SoundIsValid            = false;
-        auto [PlayCursor, WriteCursor] = WorkBuffer->GetCursors();
-        // if (SUCCEEDED(WorkBuffer->GetCurrentPosition(&PlayCursor, &WriteCursor)))
+        bool32 SoundIsValid = false;
+        auto   Cursors      = WorkBuffer->GetCursors();
         {
-            ByteToLock         = (RunningSampleIndex * BytesPerSample) % WorkBufferSize;
-            DWORD TargetCursor = (PlayCursor + (LatencySampleCount * BytesPerSample)) % WorkBufferSize;
-
-            if (ByteToLock > TargetCursor)
-            {
-                BytesToWrite = (WorkBufferSize - ByteToLock);
-                BytesToWrite += TargetCursor;
-            }
-            else
+            ByteToLock = (RunningSampleIndex * BytesPerSample) % WorkBufferSize;
+            if (Latency.Update(Cursors, ByteToLock))
             {
-                BytesToWrite = TargetCursor - ByteToLock;
+                // underrun: the play cursor went past us, restart writing from the write cursor
+                auto WriteCursor = Cursors.WriteCursor - Cursors.WriteCursor % BytesPerSample;
+                RunningSampleIndex += ((WriteCursor + WorkBufferSize - ByteToLock) % WorkBufferSize) / BytesPerSample;
+                ByteToLock = WriteCursor;
             }
 
+            // write up to PlayCursor + latency, nothing if we are already further (latency just decreased)
+            auto Ahead   = (ByteToLock + WorkBufferSize - Cursors.PlayCursor) % WorkBufferSize;
+            auto Wanted  = Latency.GetLatencySampleCount() * BytesPerSample;
+            BytesToWrite = Wanted > Ahead ? Wanted - Ahead : 0;
+
             SoundIsValid = true;
 #if DEBUG_SOUND
-            lastPlayCursor   = PlayCursor;
-            lastWriteCursor  = WriteCursor;
+            lastPlayCursor   = Cursors.PlayCursor;
+            lastWriteCursor  = Cursors.WriteCursor;
             lastByteToLock   = ByteToLock;
             lastBytesToWrite = BytesToWrite;
 #endif // DEBUG_SOUND
@@ -201,6 +209,8 @@ namespace Windows
 
     void SoundEngine::FillSoundBuffer(Game::SoundOutputBuffer& SourceBuffer)
     {
+        MasterBus.Process(SourceBuffer.Samples, BytesToWrite / BytesPerSample);
+
         if (auto lock = WorkBuffer->Lock(ByteToLock, BytesToWrite); lock.succeeded)
         {
             CopyMemory(lock.Region1, SourceBuffer.Samples, lock.Region1Size);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "audio_dsp.hpp"
+#include "audio_latency.hpp"
 #include "types.hpp"
 
 #include <memory>
@@ -14,22 +16,18 @@ namespace Windows
 
     class Window;
 
-    struct Cursors
-    {
-        uint32 PlayCursor;
-        uint32 WriteCursor;
-    };
+    using Cursors = Game::SoundCursors;
 
     struct SoundEngine
     {
-        using value_type                          = int16;
-        static constexpr int32 BitsPerSample      = sizeof(value_type) * 8;
-        static constexpr int32 SamplesPerSecond   = 48000;
-        static constexpr int32 ChannelCount       = 2;
-        static constexpr int32 BytesPerSample     = sizeof(value_type) * ChannelCount;
-        static constexpr int32 WorkBufferSize     = SamplesPerSecond * BytesPerSample; // 1 second
-        static constexpr int32 LatencySampleCount = SamplesPerSecond / 12;
-        static constexpr int32 BlockAlign         = (ChannelCount * BitsPerSample) / 8;
+        using value_type                                 = int16;
+        static constexpr int32 BitsPerSample             = sizeof(value_type) * 8;
+        static constexpr int32 SamplesPerSecond          = 48000;
+        static constexpr int32 ChannelCount              = 2;
+        static constexpr int32 BytesPerSample            = sizeof(value_type) * ChannelCount;
+        static constexpr int32 WorkBufferSize            = SamplesPerSecond * BytesPerSample; // 1 second
+        static constexpr int32 InitialLatencySampleCount = SamplesPerSecond / 12;
+        static constexpr int32 BlockAlign                = (ChannelCount * BitsPerSample) / 8;
 
 #if DEBUG_SOUND
         unsigned long lastPlayCursor   = 0;
@@ -47,6 +45,11 @@ namespace Windows
 
         Cursors GetCursors() const;
 
+        // Insert effects here, they run in front of the int16 conversion of FillSoundBuffer
+        Game::EffectChain& GetMasterBus() { return MasterBus; }
+
+        const Game::LatencyTelemetry& GetLatencyTelemetry() const { return Latency.GetTelemetry(); }
+
     private:
         void Init(const Window&);
         void ClearBuffer() const;
@@ -58,6 +61,12 @@ namespace Windows
         int16*                       Samples = nullptr;
         uint32                       ByteToLock;
         uint32                       BytesToWrite;
+        Game::Compressor             MasterLimiter{ static_cast<real32>(SamplesPerSecond) };
+        Game::EffectChain            MasterBus;
+        Game::LatencyController      Latency{ WorkBufferSize,
+                                              BytesPerSample,
+                                              SamplesPerSecond,
+                                              InitialLatencySampleCount };
     };
 
 } // namespace Windows
\ No newline at end of file
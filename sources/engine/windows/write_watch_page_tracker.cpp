@@ -0,0 +1,55 @@
+#include "write_watch_page_tracker.hpp"
+
+#include <Windows.h>
+
+namespace Windows
+{
+
+    WriteWatchPageTracker::WriteWatchPageTracker(Game::MemoryArena& Arena, void* Base, uint64 Size)
+        : Base{ Base }
+        , Size{ Size }
+        , Addresses{ Arena.PushArray<void*>(Game::Snapshot::GetPageCount(Size)) }
+    {
+        // fails when the block was not allocated with MEM_WRITE_WATCH, the pages written before are not reported:
+        // made at startup, while the block is still zero
+        if (Addresses && ResetWriteWatch(Base, (SIZE_T)Size) != 0)
+        {
+            Addresses = nullptr;
+        }
+    }
+
+    void WriteWatchPageTracker::CollectDirtyPages(uint64* Bits)
+    {
+        auto Words = (GetPageCount() + 63) / 64;
+        for (uint64 Word = 0; Word < Words; ++Word)
+        {
+            Bits[Word] = 0;
+        }
+        if (!IsValid())
+        {
+            return;
+        }
+
+        ULONG_PTR Count = (ULONG_PTR)GetPageCount();
+        ULONG     Granularity;
+        if (GetWriteWatch(WRITE_WATCH_FLAG_RESET, Base, (SIZE_T)Size, Addresses, &Count, &Granularity) != 0)
+        {
+            // every page then, a snapshot with missing pages could not be restored
+            for (uint64 Page = 0; Page < GetPageCount(); ++Page)
+            {
+                Bits[Page / 64] |= uint64(1) << (Page % 64);
+            }
+            return;
+        }
+        for (ULONG_PTR Index = 0; Index < Count; ++Index)
+        {
+            auto Offset = static_cast<uint64>(static_cast<uint8*>(Addresses[Index]) - static_cast<uint8*>(Base));
+            for (uint64 Page = Offset / PageSize; Page < GetPageCount() && Page < (Offset + Granularity) / PageSize;
+                 ++Page)
+            {
+                Bits[Page / 64] |= uint64(1) << (Page % 64);
+            }
+        }
+    }
+
+} // namespace Windows
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <snapshot.hpp>
+
+namespace Windows
+{
+
+    // Page tracker of the snapshots on a block allocated with MEM_WRITE_WATCH (the permanent storage of
+    // Windows::Memory): the kernel records the written pages, GetWriteWatch reads and resets them
+    class WriteWatchPageTracker final : public Game::PageTracker
+    {
+    public:
+        WriteWatchPageTracker(Game::MemoryArena& Arena, void* Base, uint64 Size);
+
+        void CollectDirtyPages(uint64* Bits) override;
+
+        uint64 GetPageCount() const override { return Game::Snapshot::GetPageCount(Size); }
+
+        bool IsValid() const { return Addresses != nullptr; }
+
+    private:
+        void*  Base;
+        uint64 Size;
+        void** Addresses; // one per page, filled by GetWriteWatch
+    };
+
+} // namespace Windows
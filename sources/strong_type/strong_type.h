@@ -57,9 +57,9 @@ namespace wit
         template<typename U>
         static constexpr bool has_flag = detail::has<U, FLAG_TYPES...>::value;
     private:
-        template<typename... FLAG_TYPES>
-        static constexpr bool any_flag() { return (... || has_flag<FLAG_TYPES>); }
-        template<typename... FLAG_TYPES> using check = std::enable_if_t<any_flag<FLAG_TYPES...>()>;
+        template<typename... OTHER_FLAG_TYPES>
+        static constexpr bool any_flag() { return (... || has_flag<OTHER_FLAG_TYPES>); }
+        template<typename... OTHER_FLAG_TYPES> using check = std::enable_if_t<any_flag<OTHER_FLAG_TYPES...>()>;
 
     // adds/subtracts the values in the tuples/arrays "member to member"
         template<typename TUPLE, std::size_t... INDICES>
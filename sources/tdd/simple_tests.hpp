@@ -56,7 +56,7 @@ namespace tdd
     inline auto AssertionSuccess() { return AssertionResult(true); }
     inline auto AssertionFailure() { return AssertionResult(false); }
 
-    auto OpFailure(const char* _file, size_t _line, const char* _message)
+    inline auto OpFailure(const char* _file, size_t _line, const char* _message)
     {
         return AssertionFailure() << _file << "(" << _line << "): " << _message;
     }
@@ -79,7 +79,7 @@ namespace tdd
         _writeline_callback((tdd::Message() << "Tests: " << (CheckCount-FailureCount) << "/" << CheckCount).GetString().c_str());
     }
 
-    void CheckUnaryPostOperator(bool condition, const char* condition_text, const char* filename, std::size_t lineindex)
+    inline void CheckUnaryPostOperator(bool condition, const char* condition_text, const char* filename, std::size_t lineindex)
     {
         ++tdd::CheckCount;
         if (!condition)
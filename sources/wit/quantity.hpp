@@ -55,11 +55,7 @@ struct Quantity
 {
     explicit constexpr Quantity(float _value) : value_{_value} {}
 
-    constexpr auto operator=(const Quantity &_rhs)
-    {
-        value_ = _rhs.value_;
-        return *this;
-    }
+    constexpr Quantity &operator=(const Quantity &_rhs) = default;
 
     template <LengthOrder OTHER_LENGTH_ORDER, TimeOrder OTHER_TIME_ORDER, MassOrder OTHER_MASS_ORDER>
     constexpr auto operator*(const Quantity<OTHER_LENGTH_ORDER, OTHER_TIME_ORDER, OTHER_MASS_ORDER> &_rhs) const